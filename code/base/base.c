@@ -34,6 +34,7 @@
 #include <unistd.h>
 #include <sys/file.h>
 #include <time.h>
+#include <stdint.h>
 #include "base.h"
 //#include "hardware.h"
 //#include "hw_procs.h"
@@ -43,6 +44,11 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
 
 static int s_bootCount = -1;
 static long long sStartTimeStamp_ms;
@@ -69,6 +75,47 @@ static int s_logAddTime = 1;
 static char s_szTimeLog[64];
 static char s_szAdditionalLogFile[128];
 
+// Async log: bounded MPSC ring of formatted lines, drained by a writer thread
+
+#define LOG_ASYNC_RING_SLOTS 512
+#define LOG_ASYNC_ENTRY_SIZE 384
+#define LOG_ASYNC_WRITE_BATCH 64
+#define LOG_ASYNC_WRITER_INTERVAL_MS 20
+#define LOG_ASYNC_REOPEN_INTERVAL_MS 1000
+#define LOG_ASYNC_EXIT_FLUSH_MS 500
+#define LOG_ASYNC_CRASH_FLUSH_MS 200
+
+#define LOG_ASYNC_FILE_SYSTEM 0
+#define LOG_ASYNC_FILE_ERRORS 1
+#define LOG_ASYNC_FILE_ERRORS_SOFT 2
+#define LOG_ASYNC_FILE_WATCHDOG 3
+#define LOG_ASYNC_FILE_COMMANDS 4
+#define LOG_ASYNC_FILE_ADDITIONAL 5
+#define LOG_ASYNC_FILES_COUNT 6
+
+#define LOG_ASYNC_TARGET_STDOUT ((u8)(1<<6))
+#define LOG_ASYNC_TARGET_SERVICE ((u8)(1<<7))
+
+typedef struct
+{
+   u32 uSequence;
+   u8 uTargets;
+   u8 uServiceMsgType;
+   u16 uLength;
+   char szText[LOG_ASYNC_ENTRY_SIZE];
+} t_log_async_entry;
+
+static t_log_async_entry s_LogAsyncRing[LOG_ASYNC_RING_SLOTS];
+static u32 s_uLogAsyncEnqueuePos = 0;
+static u32 s_uLogAsyncDequeuePos = 0;
+static u32 s_uLogAsyncDroppedCount = 0;
+static u32 s_uLogAsyncDroppedReported = 0;
+static int s_iLogAsyncConsumerBusy = 0;
+static int s_iLogAsyncEnabled = 0;
+static pthread_t s_pThreadLogAsyncWriter;
+static int s_iLogAsyncFiles[LOG_ASYNC_FILES_COUNT] = { -1, -1, -1, -1, -1, -1 };
+static u32 s_uLogAsyncLastReopenTime = 0;
+
 const u32 crc32_table[] = {
 	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
 	0xe963a535, 0x9e6495a3,	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
@@ -159,18 +206,263 @@ void reset_counters(type_u32_couters* pCounters)
    pCounters->uValueNow = 0;
 }
 
-u32 base_compute_crc32(u8 *buf, int length)
+//---------------------------------------------------------
+// CRC32 (IEEE 802.3, reflected, same output as the byte table version above)
+// Portable default is slice-by-8; ARMv8 CRC instructions or x86 PCLMULQDQ folding are used when the CPU has them.
+
+static u32 s_uCrc32TablesSlice8[8][256];
+static int s_iCrc32AccelerationType = CRC32_ACCELERATION_NONE;
+static u32 (*s_pFnCrc32Update)(u32 uCrc, const u8* pBuffer, int iLength) = NULL;
+
+static u32 _crc32_update_bytes(u32 uCrc, const u8* pBuffer, int iLength)
 {
-   u8* p = buf;
-   u32 crc;
-   crc = ~0U;
+   while ( iLength-- > 0 )
+      uCrc = crc32_table[(uCrc ^ *pBuffer++) & 0xFF] ^ (uCrc >> 8);
+   return uCrc;
+}
 
-   while (length--)
+static u32 _crc32_update_slice8(u32 uCrc, const u8* pBuffer, int iLength)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+   while ( (iLength > 0) && (((uintptr_t)pBuffer) & 3) )
    {
-      crc = crc32_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+      uCrc = crc32_table[(uCrc ^ *pBuffer++) & 0xFF] ^ (uCrc >> 8);
+      iLength--;
    }
-   return crc ^ ~0U;
-} 
+   while ( iLength >= 8 )
+   {
+      u32 uLow = *(const u32*)pBuffer ^ uCrc;
+      u32 uHigh = *(const u32*)(pBuffer+4);
+      uCrc = s_uCrc32TablesSlice8[7][uLow & 0xFF] ^
+             s_uCrc32TablesSlice8[6][(uLow >> 8) & 0xFF] ^
+             s_uCrc32TablesSlice8[5][(uLow >> 16) & 0xFF] ^
+             s_uCrc32TablesSlice8[4][uLow >> 24] ^
+             s_uCrc32TablesSlice8[3][uHigh & 0xFF] ^
+             s_uCrc32TablesSlice8[2][(uHigh >> 8) & 0xFF] ^
+             s_uCrc32TablesSlice8[1][(uHigh >> 16) & 0xFF] ^
+             s_uCrc32TablesSlice8[0][uHigh >> 24];
+      pBuffer += 8;
+      iLength -= 8;
+   }
+#endif
+   return _crc32_update_bytes(uCrc, pBuffer, iLength);
+}
+
+#if defined(__aarch64__) && defined(__GNUC__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define CRC32_HAS_ARMV8_KERNEL
+
+__attribute__((target("+crc")))
+static u32 _crc32_update_armv8(u32 uCrc, const u8* pBuffer, int iLength)
+{
+   while ( (iLength > 0) && (((uintptr_t)pBuffer) & 7) )
+   {
+      uCrc = __crc32b(uCrc, *pBuffer++);
+      iLength--;
+   }
+   while ( iLength >= 32 )
+   {
+      uCrc = __crc32d(uCrc, *(const uint64_t*)pBuffer);
+      uCrc = __crc32d(uCrc, *(const uint64_t*)(pBuffer+8));
+      uCrc = __crc32d(uCrc, *(const uint64_t*)(pBuffer+16));
+      uCrc = __crc32d(uCrc, *(const uint64_t*)(pBuffer+24));
+      pBuffer += 32;
+      iLength -= 32;
+   }
+   while ( iLength >= 8 )
+   {
+      uCrc = __crc32d(uCrc, *(const uint64_t*)pBuffer);
+      pBuffer += 8;
+      iLength -= 8;
+   }
+   while ( iLength-- > 0 )
+      uCrc = __crc32b(uCrc, *pBuffer++);
+   return uCrc;
+}
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define CRC32_HAS_PCLMUL_KERNEL
+
+// Folding constants for the reflected 0x04C11DB7 polynomial (x^n mod P, bit reflected)
+static const uint64_t s_uCrc32FoldK1K2[2] __attribute__((aligned(16))) = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+static const uint64_t s_uCrc32FoldK3K4[2] __attribute__((aligned(16))) = { 0x01751997d0ULL, 0x00ccaa009eULL };
+static const uint64_t s_uCrc32FoldK5K0[2] __attribute__((aligned(16))) = { 0x0163cd6124ULL, 0x0000000000ULL };
+static const uint64_t s_uCrc32FoldPoly[2] __attribute__((aligned(16))) = { 0x01db710641ULL, 0x01f7011641ULL };
+
+__attribute__((target("pclmul,sse4.1")))
+static u32 _crc32_update_pclmul(u32 uCrc, const u8* pBuffer, int iLength)
+{
+   if ( iLength < 64 )
+      return _crc32_update_slice8(uCrc, pBuffer, iLength);
+
+   __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+   x1 = _mm_loadu_si128((const __m128i*)(pBuffer + 0x00));
+   x2 = _mm_loadu_si128((const __m128i*)(pBuffer + 0x10));
+   x3 = _mm_loadu_si128((const __m128i*)(pBuffer + 0x20));
+   x4 = _mm_loadu_si128((const __m128i*)(pBuffer + 0x30));
+   x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)uCrc));
+   x0 = _mm_load_si128((const __m128i*)s_uCrc32FoldK1K2);
+   pBuffer += 64;
+   iLength -= 64;
+
+   // Fold 4 x 128 bits at a time
+   while ( iLength >= 64 )
+   {
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+      x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+      x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+      x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+      x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+      y5 = _mm_loadu_si128((const __m128i*)(pBuffer + 0x00));
+      y6 = _mm_loadu_si128((const __m128i*)(pBuffer + 0x10));
+      y7 = _mm_loadu_si128((const __m128i*)(pBuffer + 0x20));
+      y8 = _mm_loadu_si128((const __m128i*)(pBuffer + 0x30));
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+      x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+      x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+      x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+      pBuffer += 64;
+      iLength -= 64;
+   }
+
+   // Fold into 128 bits
+   x0 = _mm_load_si128((const __m128i*)s_uCrc32FoldK3K4);
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+   while ( iLength >= 16 )
+   {
+      x2 = _mm_loadu_si128((const __m128i*)pBuffer);
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+      pBuffer += 16;
+      iLength -= 16;
+   }
+
+   // Fold 128 bits to 64 bits
+   x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+   x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+   x1 = _mm_srli_si128(x1, 8);
+   x1 = _mm_xor_si128(x1, x2);
+   x0 = _mm_loadl_epi64((const __m128i*)s_uCrc32FoldK5K0);
+   x2 = _mm_srli_si128(x1, 4);
+   x1 = _mm_and_si128(x1, x3);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+
+   // Barrett reduction to 32 bits
+   x0 = _mm_load_si128((const __m128i*)s_uCrc32FoldPoly);
+   x2 = _mm_and_si128(x1, x3);
+   x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+   x2 = _mm_and_si128(x2, x3);
+   x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+   uCrc = (u32)_mm_extract_epi32(x1, 1);
+
+   return _crc32_update_slice8(uCrc, pBuffer, iLength);
+}
+#endif
+
+static int _crc32_is_acceleration_supported(int iType)
+{
+   switch ( iType )
+   {
+      case CRC32_ACCELERATION_NONE:
+      case CRC32_ACCELERATION_SLICE8:
+         return 1;
+      #if defined(CRC32_HAS_ARMV8_KERNEL)
+      case CRC32_ACCELERATION_ARMV8:
+         return (getauxval(AT_HWCAP) & HWCAP_CRC32) ? 1 : 0;
+      #endif
+      #if defined(CRC32_HAS_PCLMUL_KERNEL)
+      case CRC32_ACCELERATION_PCLMUL:
+         __builtin_cpu_init();
+         return (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) ? 1 : 0;
+      #endif
+      default:
+         return 0;
+   }
+}
+
+// Runs before main (and so before any thread), so the tables and dispatch never change while in use
+__attribute__((constructor))
+static void _crc32_init()
+{
+   for( int i=0; i<256; i++ )
+      s_uCrc32TablesSlice8[0][i] = crc32_table[i];
+   for( int i=0; i<256; i++ )
+   for( int k=1; k<8; k++ )
+      s_uCrc32TablesSlice8[k][i] = (s_uCrc32TablesSlice8[k-1][i] >> 8) ^ crc32_table[s_uCrc32TablesSlice8[k-1][i] & 0xFF];
+
+   base_set_crc32_acceleration(CRC32_ACCELERATION_AUTO);
+}
+
+int base_set_crc32_acceleration(int iAccelerationType)
+{
+   if ( CRC32_ACCELERATION_AUTO == iAccelerationType )
+   {
+      iAccelerationType = CRC32_ACCELERATION_SLICE8;
+      if ( _crc32_is_acceleration_supported(CRC32_ACCELERATION_ARMV8) )
+         iAccelerationType = CRC32_ACCELERATION_ARMV8;
+      if ( _crc32_is_acceleration_supported(CRC32_ACCELERATION_PCLMUL) )
+         iAccelerationType = CRC32_ACCELERATION_PCLMUL;
+   }
+   if ( ! _crc32_is_acceleration_supported(iAccelerationType) )
+      return -1;
+
+   switch ( iAccelerationType )
+   {
+      #if defined(CRC32_HAS_ARMV8_KERNEL)
+      case CRC32_ACCELERATION_ARMV8: s_pFnCrc32Update = _crc32_update_armv8; break;
+      #endif
+      #if defined(CRC32_HAS_PCLMUL_KERNEL)
+      case CRC32_ACCELERATION_PCLMUL: s_pFnCrc32Update = _crc32_update_pclmul; break;
+      #endif
+      case CRC32_ACCELERATION_SLICE8: s_pFnCrc32Update = _crc32_update_slice8; break;
+      default: s_pFnCrc32Update = _crc32_update_bytes; break;
+   }
+   s_iCrc32AccelerationType = iAccelerationType;
+   return iAccelerationType;
+}
+
+int base_get_crc32_acceleration()
+{
+   return s_iCrc32AccelerationType;
+}
+
+const char* base_get_crc32_acceleration_name()
+{
+   switch ( s_iCrc32AccelerationType )
+   {
+      case CRC32_ACCELERATION_SLICE8: return "slice8";
+      case CRC32_ACCELERATION_ARMV8: return "armv8";
+      case CRC32_ACCELERATION_PCLMUL: return "pclmul";
+      default: return "table";
+   }
+}
+
+u32 base_compute_crc32(u8 *buf, int length)
+{
+   if ( (NULL == buf) || (length <= 0) )
+      return 0;
+   return s_pFnCrc32Update(~0U, buf, length) ^ ~0U;
+}
 
 u8 base_compute_crc8(u8* pBuffer, int iLength)
 {
@@ -636,11 +928,333 @@ void _log_format_time_mstens(char* szOutTime)
    sprintf(szOutTime,"%d-%d:%02d:%02d.%03d", s_bootCount, (int)(uMilisTens/1000/60/60/10), (int)(uMilisTens/1000/60/10)%60, (int)((uMilisTens/1000/10)%60), (int)((uMilisTens/10)%1000));
 }
 
+static void _log_async_close_files()
+{
+   for( int i=0; i<LOG_ASYNC_FILES_COUNT; i++ )
+   {
+      if ( s_iLogAsyncFiles[i] >= 0 )
+         close(s_iLogAsyncFiles[i]);
+      s_iLogAsyncFiles[i] = -1;
+   }
+}
+
+// Files are kept open between batches and reopened periodically so that deleted/rotated logs get recreated
+static int _log_async_get_file(int iFile)
+{
+   if ( s_iLogAsyncFiles[iFile] >= 0 )
+      return s_iLogAsyncFiles[iFile];
+
+   char szFile[MAX_FILE_PATH_SIZE];
+   szFile[0] = 0;
+   switch ( iFile )
+   {
+      case LOG_ASYNC_FILE_SYSTEM: strcpy(szFile, FOLDER_LOGS); strcat(szFile, LOG_FILE_SYSTEM); break;
+      case LOG_ASYNC_FILE_ERRORS: strcpy(szFile, FOLDER_LOGS); strcat(szFile, LOG_FILE_ERRORS); break;
+      case LOG_ASYNC_FILE_ERRORS_SOFT: strcpy(szFile, FOLDER_LOGS); strcat(szFile, LOG_FILE_ERRORS_SOFT); break;
+      case LOG_ASYNC_FILE_WATCHDOG: strcpy(szFile, FOLDER_LOGS); strcat(szFile, LOG_FILE_WATCHDOG); break;
+      case LOG_ASYNC_FILE_COMMANDS: strcpy(szFile, FOLDER_LOGS); strcat(szFile, LOG_FILE_COMMANDS); break;
+      case LOG_ASYNC_FILE_ADDITIONAL: strcpy(szFile, s_szAdditionalLogFile); break;
+   }
+   if ( 0 == szFile[0] )
+      return -1;
+   s_iLogAsyncFiles[iFile] = open(szFile, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+   return s_iLogAsyncFiles[iFile];
+}
+
+// Never blocks: if the ring is full the line is dropped and counted
+static void _log_async_push(u8 uTargets, u8 uServiceMsgType, const char* szTimeSuffix, const char* szTextPrefix, const char* format, va_list args)
+{
+   char szTime[32];
+   szTime[0] = 0;
+   if ( s_logAddTime )
+      _log_format_time_mstens(szTime);
+
+   if ( ! s_logDisabledStdout )
+      uTargets |= LOG_ASYNC_TARGET_STDOUT;
+   if ( 0 == s_szAdditionalLogFile[0] )
+      uTargets &= ~(1<<LOG_ASYNC_FILE_ADDITIONAL);
+   if ( 0 == s_logUseService )
+      uTargets &= ~LOG_ASYNC_TARGET_SERVICE;
+
+   t_log_async_entry* pEntry = NULL;
+   u32 uPos = __atomic_load_n(&s_uLogAsyncEnqueuePos, __ATOMIC_RELAXED);
+   while ( 1 )
+   {
+      pEntry = &s_LogAsyncRing[uPos & (LOG_ASYNC_RING_SLOTS-1)];
+      u32 uSeq = __atomic_load_n(&pEntry->uSequence, __ATOMIC_ACQUIRE);
+      int iDiff = (int)(uSeq - uPos);
+      if ( 0 == iDiff )
+      {
+         if ( __atomic_compare_exchange_n(&s_uLogAsyncEnqueuePos, &uPos, uPos+1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+            break;
+      }
+      else if ( iDiff < 0 )
+      {
+         __atomic_fetch_add(&s_uLogAsyncDroppedCount, 1, __ATOMIC_RELAXED);
+         return;
+      }
+      else
+         uPos = __atomic_load_n(&s_uLogAsyncEnqueuePos, __ATOMIC_RELAXED);
+   }
+
+   int iLen = snprintf(pEntry->szText, LOG_ASYNC_ENTRY_SIZE, "%s%s %s: %s", szTime, szTimeSuffix, sszComponentName, szTextPrefix);
+   if ( (iLen < 0) || (iLen > LOG_ASYNC_ENTRY_SIZE-2) )
+      iLen = 0;
+   int iLenText = vsnprintf(&pEntry->szText[iLen], LOG_ASYNC_ENTRY_SIZE-1-iLen, format, args);
+   if ( iLenText > 0 )
+      iLen += iLenText;
+   if ( iLen > LOG_ASYNC_ENTRY_SIZE-2 )
+      iLen = LOG_ASYNC_ENTRY_SIZE-2;
+   pEntry->szText[iLen++] = '\n';
+   pEntry->szText[iLen] = 0;
+   pEntry->uLength = (u16)iLen;
+   pEntry->uTargets = uTargets;
+   pEntry->uServiceMsgType = uServiceMsgType;
+   __atomic_store_n(&pEntry->uSequence, uPos+1, __ATOMIC_RELEASE);
+}
+
+static void _log_async_write_batch(t_log_async_entry** pEntries, int iCount)
+{
+   struct iovec iovFiles[LOG_ASYNC_FILES_COUNT][LOG_ASYNC_WRITE_BATCH];
+   struct iovec iovStdout[LOG_ASYNC_WRITE_BATCH];
+   int iCountFiles[LOG_ASYNC_FILES_COUNT];
+   int iCountStdout = 0;
+   memset(iCountFiles, 0, sizeof(iCountFiles));
+
+   int bUseService = 0;
+   for( int i=0; i<iCount; i++ )
+   {
+      if ( pEntries[i]->uTargets & LOG_ASYNC_TARGET_SERVICE )
+      {
+         bUseService = _log_check_for_service_log_access();
+         break;
+      }
+   }
+
+   for( int i=0; i<iCount; i++ )
+   {
+      t_log_async_entry* pEntry = pEntries[i];
+      if ( pEntry->uTargets & LOG_ASYNC_TARGET_STDOUT )
+      {
+         iovStdout[iCountStdout].iov_base = pEntry->szText;
+         iovStdout[iCountStdout].iov_len = pEntry->uLength;
+         iCountStdout++;
+      }
+      if ( bUseService && (pEntry->uTargets & LOG_ASYNC_TARGET_SERVICE) )
+      {
+         type_log_message_buffer msg;
+         msg.type = pEntry->uServiceMsgType;
+         msg.text[0] = 'S';
+         int iLen = pEntry->uLength - 1;
+         if ( iLen > MAX_SERVICE_LOG_ENTRY_LENGTH-2 )
+            iLen = MAX_SERVICE_LOG_ENTRY_LENGTH-2;
+         memcpy(&msg.text[1], pEntry->szText, iLen);
+         msg.text[iLen+1] = 0;
+         msgsnd(s_logServiceMessageQueue, &msg, iLen+2, IPC_NOWAIT);
+         continue;
+      }
+      for( int k=0; k<LOG_ASYNC_FILES_COUNT; k++ )
+      {
+         if ( ! (pEntry->uTargets & (1<<k)) )
+            continue;
+         iovFiles[k][iCountFiles[k]].iov_base = pEntry->szText;
+         iovFiles[k][iCountFiles[k]].iov_len = pEntry->uLength;
+         iCountFiles[k]++;
+      }
+   }
+
+   for( int k=0; k<LOG_ASYNC_FILES_COUNT; k++ )
+   {
+      if ( 0 == iCountFiles[k] )
+         continue;
+      int fd = _log_async_get_file(k);
+      if ( fd >= 0 )
+      if ( writev(fd, iovFiles[k], iCountFiles[k]) < 0 )
+      {
+         close(fd);
+         s_iLogAsyncFiles[k] = -1;
+      }
+   }
+   if ( iCountStdout > 0 )
+   if ( writev(STDOUT_FILENO, iovStdout, iCountStdout) < 0 )
+      return;
+}
+
+static void _log_async_report_dropped()
+{
+   u32 uDropped = __atomic_load_n(&s_uLogAsyncDroppedCount, __ATOMIC_RELAXED);
+   if ( uDropped == s_uLogAsyncDroppedReported )
+      return;
+   char szTime[32];
+   szTime[0] = 0;
+   if ( s_logAddTime )
+      _log_format_time_mstens(szTime);
+   char szBuff[256];
+   int iLen = snprintf(szBuff, sizeof(szBuff), "%s %s: SOFT_ERROR: [Log] Async log ring was full, dropped %u lines (%u total).\n", szTime, sszComponentName, uDropped - s_uLogAsyncDroppedReported, uDropped);
+   s_uLogAsyncDroppedReported = uDropped;
+   if ( iLen <= 0 )
+      return;
+   if ( iLen >= (int)sizeof(szBuff) )
+      iLen = sizeof(szBuff)-1;
+   int fd = _log_async_get_file(LOG_ASYNC_FILE_SYSTEM);
+   if ( fd >= 0 )
+   if ( write(fd, szBuff, iLen) < 0 )
+      return;
+}
+
+// Drains the ring. Returns the number of lines written or -1 if another thread is already draining it.
+static int _log_async_consume()
+{
+   if ( __atomic_exchange_n(&s_iLogAsyncConsumerBusy, 1, __ATOMIC_ACQUIRE) )
+      return -1;
+
+   u32 uTimeNow = get_current_timestamp_ms();
+   if ( uTimeNow >= s_uLogAsyncLastReopenTime + LOG_ASYNC_REOPEN_INTERVAL_MS )
+   {
+      s_uLogAsyncLastReopenTime = uTimeNow;
+      _log_async_close_files();
+   }
+
+   int iTotal = 0;
+   t_log_async_entry* pEntries[LOG_ASYNC_WRITE_BATCH];
+   while ( 1 )
+   {
+      int iCount = 0;
+      u32 uPos = s_uLogAsyncDequeuePos;
+      while ( iCount < LOG_ASYNC_WRITE_BATCH )
+      {
+         t_log_async_entry* pEntry = &s_LogAsyncRing[(uPos + iCount) & (LOG_ASYNC_RING_SLOTS-1)];
+         if ( __atomic_load_n(&pEntry->uSequence, __ATOMIC_ACQUIRE) != uPos + iCount + 1 )
+            break;
+         pEntries[iCount++] = pEntry;
+      }
+      if ( 0 == iCount )
+         break;
+
+      _log_async_write_batch(pEntries, iCount);
+
+      for( int i=0; i<iCount; i++ )
+         __atomic_store_n(&pEntries[i]->uSequence, uPos + i + LOG_ASYNC_RING_SLOTS, __ATOMIC_RELEASE);
+      s_uLogAsyncDequeuePos = uPos + iCount;
+      iTotal += iCount;
+   }
+
+   _log_async_report_dropped();
+   __atomic_store_n(&s_iLogAsyncConsumerBusy, 0, __ATOMIC_RELEASE);
+   return iTotal;
+}
+
+static void* _thread_log_async_writer(void *argument)
+{
+   int iLastCount = 0;
+   while ( 1 )
+   {
+      // Poll faster while lines come in bursts, so the ring does not fill up
+      if ( iLastCount > LOG_ASYNC_RING_SLOTS/4 )
+         usleep(2000);
+      else
+         usleep(LOG_ASYNC_WRITER_INTERVAL_MS*1000);
+      iLastCount = _log_async_consume();
+   }
+   return NULL;
+}
+
+static void _log_async_on_exit()
+{
+   log_flush_async(LOG_ASYNC_EXIT_FLUSH_MS);
+}
+
+static void _log_async_on_crash_signal(int iSignal)
+{
+   log_flush_async(LOG_ASYNC_CRASH_FLUSH_MS);
+   // Handler was installed with SA_RESETHAND: re-raise to get the default action (core dump)
+   raise(iSignal);
+}
+
+void log_enable_async()
+{
+   if ( s_iLogAsyncEnabled )
+      return;
+
+   for( int i=0; i<LOG_ASYNC_RING_SLOTS; i++ )
+      s_LogAsyncRing[i].uSequence = (u32)i;
+   s_uLogAsyncEnqueuePos = 0;
+   s_uLogAsyncDequeuePos = 0;
+   s_uLogAsyncLastReopenTime = get_current_timestamp_ms();
+
+   pthread_attr_t attr;
+   pthread_attr_init(&attr);
+   pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+   pthread_attr_setstacksize(&attr, 64*1024);
+   if ( 0 != pthread_create(&s_pThreadLogAsyncWriter, &attr, &_thread_log_async_writer, NULL) )
+   {
+      pthread_attr_destroy(&attr);
+      log_softerror_and_alarm("[Log] Failed to create async log writer thread. Using regular log.");
+      return;
+   }
+   pthread_attr_destroy(&attr);
+   __atomic_store_n(&s_iLogAsyncEnabled, 1, __ATOMIC_RELEASE);
+
+   atexit(_log_async_on_exit);
+
+   // Flush pending lines on fatal signals, unless the process already handles them
+   int iSignals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+   for( int i=0; i<(int)(sizeof(iSignals)/sizeof(iSignals[0])); i++ )
+   {
+      struct sigaction sigOld;
+      if ( (0 != sigaction(iSignals[i], NULL, &sigOld)) || (sigOld.sa_handler != SIG_DFL) )
+         continue;
+      struct sigaction sigNew;
+      memset(&sigNew, 0, sizeof(sigNew));
+      sigNew.sa_handler = _log_async_on_crash_signal;
+      sigemptyset(&sigNew.sa_mask);
+      sigNew.sa_flags = SA_RESETHAND | SA_NODEFER;
+      sigaction(iSignals[i], &sigNew, NULL);
+   }
+   log_line("[Log] Using async log writer (%d lines ring, %d ms flush interval).", LOG_ASYNC_RING_SLOTS, LOG_ASYNC_WRITER_INTERVAL_MS);
+}
+
+int log_is_async()
+{
+   return s_iLogAsyncEnabled;
+}
+
+void log_flush_async(u32 uMaxWaitMs)
+{
+   if ( ! s_iLogAsyncEnabled )
+      return;
+   u32 uTimeStart = get_current_timestamp_ms();
+   while ( 1 )
+   {
+      int iRes = _log_async_consume();
+      if ( (iRes >= 0) && (__atomic_load_n(&s_uLogAsyncEnqueuePos, __ATOMIC_ACQUIRE) == s_uLogAsyncDequeuePos) )
+         return;
+      if ( get_current_timestamp_ms() >= uTimeStart + uMaxWaitMs )
+         return;
+      if ( iRes <= 0 )
+         usleep(1000);
+   }
+}
+
+u32 log_get_async_dropped_count()
+{
+   return __atomic_load_n(&s_uLogAsyncDroppedCount, __ATOMIC_RELAXED);
+}
+
 void log_line(const char* format, ...)
 {
    if ( s_logDisabled || s_logOnlyErrors )
       return;
 
+   if ( s_iLogAsyncEnabled )
+   {
+      va_list args;
+      va_start(args, format);
+      _log_async_push((1<<LOG_ASYNC_FILE_SYSTEM) | (1<<LOG_ASYNC_FILE_ADDITIONAL) | LOG_ASYNC_TARGET_SERVICE, 1, "", "", format, args);
+      va_end(args);
+      return;
+   }
+
    va_list args;
    va_start(args, format);
 
@@ -719,6 +1333,15 @@ void log_line(const char* format, ...)
 
 void log_line_forced_to_file(const char* format, ...)
 {
+   if ( s_iLogAsyncEnabled )
+   {
+      va_list args;
+      va_start(args, format);
+      _log_async_push((1<<LOG_ASYNC_FILE_SYSTEM) | (1<<LOG_ASYNC_FILE_ADDITIONAL), 1, "(F)", "", format, args);
+      va_end(args);
+      return;
+   }
+
    va_list args;
    va_start(args, format);
 
@@ -789,6 +1412,15 @@ void log_line_watchdog(const char* format, ...)
    if ( s_logDisabled || s_logOnlyErrors )
       return;
 
+   if ( s_iLogAsyncEnabled )
+   {
+      va_list args;
+      va_start(args, format);
+      _log_async_push((1<<LOG_ASYNC_FILE_SYSTEM) | (1<<LOG_ASYNC_FILE_WATCHDOG) | LOG_ASYNC_TARGET_SERVICE, 1, "", "", format, args);
+      va_end(args);
+      return;
+   }
+
    va_list args;
    va_start(args, format);
 
@@ -854,6 +1486,15 @@ void log_line_commands(const char* format, ...)
    if ( s_logDisabled || s_logOnlyErrors )
       return;
 
+   if ( s_iLogAsyncEnabled )
+   {
+      va_list args;
+      va_start(args, format);
+      _log_async_push((1<<LOG_ASYNC_FILE_SYSTEM) | (1<<LOG_ASYNC_FILE_COMMANDS) | LOG_ASYNC_TARGET_SERVICE, 1, "", "", format, args);
+      va_end(args);
+      return;
+   }
+
    va_list args;
    va_start(args, format);
 
@@ -1200,6 +1841,15 @@ void log_error_and_alarm(const char* format, ...)
    if ( s_logDisabled )
       return;
 
+   if ( s_iLogAsyncEnabled )
+   {
+      va_list args;
+      va_start(args, format);
+      _log_async_push((1<<LOG_ASYNC_FILE_SYSTEM) | (1<<LOG_ASYNC_FILE_ERRORS) | (1<<LOG_ASYNC_FILE_ADDITIONAL) | LOG_ASYNC_TARGET_SERVICE, 3, "", "ERROR: ", format, args);
+      va_end(args);
+      return;
+   }
+
    va_list args;
    va_start(args, format);
 
@@ -1300,6 +1950,15 @@ void log_softerror_and_alarm(const char* format, ...)
    if ( s_logDisabled )
       return;
 
+   if ( s_iLogAsyncEnabled )
+   {
+      va_list args;
+      va_start(args, format);
+      _log_async_push((1<<LOG_ASYNC_FILE_SYSTEM) | (1<<LOG_ASYNC_FILE_ERRORS_SOFT) | (1<<LOG_ASYNC_FILE_ADDITIONAL) | LOG_ASYNC_TARGET_SERVICE, 2, "", "SOFT_ERROR: ", format, args);
+      va_end(args);
+      return;
+   }
+
    va_list args;
    va_start(args, format);
 
@@ -76,6 +76,17 @@ u32 revert_word(u32 input);
 
 void reset_counters(type_u32_couters* pCounters);
 
+#define CRC32_ACCELERATION_AUTO -1
+#define CRC32_ACCELERATION_NONE 0
+#define CRC32_ACCELERATION_SLICE8 1
+#define CRC32_ACCELERATION_ARMV8 2
+#define CRC32_ACCELERATION_PCLMUL 3
+
+// Auto selected at startup; set is meant for tests/benchmarks. Returns the type set or -1 if not supported
+int base_set_crc32_acceleration(int iAccelerationType);
+int base_get_crc32_acceleration();
+const char* base_get_crc32_acceleration_name();
+
 u32 base_compute_crc32(u8 *buf, int length);
 u8 base_compute_crc8(u8* pBuffer, int iLength);
 int base_check_crc32(u8* pBuffer, int iLength);
@@ -122,6 +133,14 @@ void log_error_and_alarm(const char* format, ...);
 void log_line_watchdog(const char* format, ...);
 void log_line_commands(const char* format, ...);
 
+// Moves file/service log output to a background writer thread. Log calls then only format
+// the line into a lock-free ring and never block; lines are dropped (and counted) if it is full.
+void log_enable_async();
+int log_is_async();
+// Writes out the pending lines, waiting at most the given time (used on exit and on crash signals)
+void log_flush_async(u32 uMaxWaitMs);
+u32 log_get_async_dropped_count();
+
 int check_licences();
 
 long get_filesize(const char* szFileName);
@@ -0,0 +1,298 @@
+/*
+ * ChaCha20-Poly1305 AEAD as specified in RFC 8439.
+ * ChaCha20 is the reference construction; Poly1305 uses 26 bit limbs
+ * (same approach as poly1305-donna-32), so it only needs 32x32->64 multiplies
+ * and is fast enough on the 32 bit ARM boards.
+ * Public domain / CC0 style implementation, no external dependencies.
+ */
+
+#include <string.h>
+#include "chacha20poly1305.h"
+
+#define U8TO32_LE(p) \
+   (((uint32_t)((p)[0])) | ((uint32_t)((p)[1]) << 8) | ((uint32_t)((p)[2]) << 16) | ((uint32_t)((p)[3]) << 24))
+
+#define U32TO8_LE(p, v) \
+   do { (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); (p)[2] = (uint8_t)((v) >> 16); (p)[3] = (uint8_t)((v) >> 24); } while (0)
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define CHACHA_QUARTERROUND(a, b, c, d) \
+   a += b; d ^= a; d = ROTL32(d, 16); \
+   c += d; b ^= c; b = ROTL32(b, 12); \
+   a += b; d ^= a; d = ROTL32(d, 8); \
+   c += d; b ^= c; b = ROTL32(b, 7);
+
+//--------------------------------------------------------
+// ChaCha20
+
+void chacha20_block(const uint8_t* pKey, uint32_t uCounter, const uint8_t* pNonce, uint8_t* pOut)
+{
+   uint32_t s[16];
+   uint32_t x[16];
+
+   s[0] = 0x61707865;
+   s[1] = 0x3320646e;
+   s[2] = 0x79622d32;
+   s[3] = 0x6b206574;
+   for( int i=0; i<8; i++ )
+      s[4+i] = U8TO32_LE(pKey + 4*i);
+   s[12] = uCounter;
+   s[13] = U8TO32_LE(pNonce);
+   s[14] = U8TO32_LE(pNonce + 4);
+   s[15] = U8TO32_LE(pNonce + 8);
+
+   memcpy(x, s, sizeof(x));
+   for( int i=0; i<10; i++ )
+   {
+      CHACHA_QUARTERROUND(x[0], x[4], x[8], x[12])
+      CHACHA_QUARTERROUND(x[1], x[5], x[9], x[13])
+      CHACHA_QUARTERROUND(x[2], x[6], x[10], x[14])
+      CHACHA_QUARTERROUND(x[3], x[7], x[11], x[15])
+      CHACHA_QUARTERROUND(x[0], x[5], x[10], x[15])
+      CHACHA_QUARTERROUND(x[1], x[6], x[11], x[12])
+      CHACHA_QUARTERROUND(x[2], x[7], x[8], x[13])
+      CHACHA_QUARTERROUND(x[3], x[4], x[9], x[14])
+   }
+   for( int i=0; i<16; i++ )
+   {
+      uint32_t v = x[i] + s[i];
+      U32TO8_LE(pOut + 4*i, v);
+   }
+}
+
+void chacha20_xor(const uint8_t* pKey, uint32_t uCounter, const uint8_t* pNonce, uint8_t* pData, int iLength)
+{
+   uint8_t block[64];
+   while ( iLength > 0 )
+   {
+      chacha20_block(pKey, uCounter, pNonce, block);
+      uCounter++;
+      int iCount = (iLength < 64) ? iLength : 64;
+      for( int i=0; i<iCount; i++ )
+         pData[i] ^= block[i];
+      pData += iCount;
+      iLength -= iCount;
+   }
+   memset(block, 0, sizeof(block));
+}
+
+//--------------------------------------------------------
+// Poly1305
+
+typedef struct
+{
+   uint32_t r[5];
+   uint32_t h[5];
+   uint32_t pad[4];
+   uint8_t buffer[16];
+   int iBufferUsed;
+} t_poly1305_state;
+
+static void _poly1305_init(t_poly1305_state* pState, const uint8_t* pKey)
+{
+   // r is clamped as per the spec
+   pState->r[0] = (U8TO32_LE(pKey + 0)) & 0x3ffffff;
+   pState->r[1] = (U8TO32_LE(pKey + 3) >> 2) & 0x3ffff03;
+   pState->r[2] = (U8TO32_LE(pKey + 6) >> 4) & 0x3ffc0ff;
+   pState->r[3] = (U8TO32_LE(pKey + 9) >> 6) & 0x3f03fff;
+   pState->r[4] = (U8TO32_LE(pKey + 12) >> 8) & 0x00fffff;
+   for( int i=0; i<5; i++ )
+      pState->h[i] = 0;
+   for( int i=0; i<4; i++ )
+      pState->pad[i] = U8TO32_LE(pKey + 16 + 4*i);
+   pState->iBufferUsed = 0;
+}
+
+static void _poly1305_blocks(t_poly1305_state* pState, const uint8_t* pData, int iLength, uint32_t uHiBit)
+{
+   const uint32_t r0 = pState->r[0], r1 = pState->r[1], r2 = pState->r[2], r3 = pState->r[3], r4 = pState->r[4];
+   const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+   uint32_t h0 = pState->h[0], h1 = pState->h[1], h2 = pState->h[2], h3 = pState->h[3], h4 = pState->h[4];
+
+   while ( iLength >= 16 )
+   {
+      h0 += (U8TO32_LE(pData + 0)) & 0x3ffffff;
+      h1 += (U8TO32_LE(pData + 3) >> 2) & 0x3ffffff;
+      h2 += (U8TO32_LE(pData + 6) >> 4) & 0x3ffffff;
+      h3 += (U8TO32_LE(pData + 9) >> 6) & 0x3ffffff;
+      h4 += (U8TO32_LE(pData + 12) >> 8) | uHiBit;
+
+      uint64_t d0 = (uint64_t)h0*r0 + (uint64_t)h1*s4 + (uint64_t)h2*s3 + (uint64_t)h3*s2 + (uint64_t)h4*s1;
+      uint64_t d1 = (uint64_t)h0*r1 + (uint64_t)h1*r0 + (uint64_t)h2*s4 + (uint64_t)h3*s3 + (uint64_t)h4*s2;
+      uint64_t d2 = (uint64_t)h0*r2 + (uint64_t)h1*r1 + (uint64_t)h2*r0 + (uint64_t)h3*s4 + (uint64_t)h4*s3;
+      uint64_t d3 = (uint64_t)h0*r3 + (uint64_t)h1*r2 + (uint64_t)h2*r1 + (uint64_t)h3*r0 + (uint64_t)h4*s4;
+      uint64_t d4 = (uint64_t)h0*r4 + (uint64_t)h1*r3 + (uint64_t)h2*r2 + (uint64_t)h3*r1 + (uint64_t)h4*r0;
+
+      uint32_t c;
+      c = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & 0x3ffffff;
+      d1 += c; c = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & 0x3ffffff;
+      d2 += c; c = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & 0x3ffffff;
+      d3 += c; c = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & 0x3ffffff;
+      d4 += c; c = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & 0x3ffffff;
+      h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+      h1 += c;
+
+      pData += 16;
+      iLength -= 16;
+   }
+
+   pState->h[0] = h0; pState->h[1] = h1; pState->h[2] = h2; pState->h[3] = h3; pState->h[4] = h4;
+}
+
+static void _poly1305_update(t_poly1305_state* pState, const uint8_t* pData, int iLength)
+{
+   if ( pState->iBufferUsed > 0 )
+   {
+      int iCount = 16 - pState->iBufferUsed;
+      if ( iCount > iLength )
+         iCount = iLength;
+      memcpy(pState->buffer + pState->iBufferUsed, pData, iCount);
+      pState->iBufferUsed += iCount;
+      pData += iCount;
+      iLength -= iCount;
+      if ( pState->iBufferUsed < 16 )
+         return;
+      _poly1305_blocks(pState, pState->buffer, 16, 1 << 24);
+      pState->iBufferUsed = 0;
+   }
+   int iFull = iLength & ~15;
+   if ( iFull > 0 )
+   {
+      _poly1305_blocks(pState, pData, iFull, 1 << 24);
+      pData += iFull;
+      iLength -= iFull;
+   }
+   if ( iLength > 0 )
+   {
+      memcpy(pState->buffer, pData, iLength);
+      pState->iBufferUsed = iLength;
+   }
+}
+
+static void _poly1305_finish(t_poly1305_state* pState, uint8_t* pTagOut)
+{
+   if ( pState->iBufferUsed > 0 )
+   {
+      int i = pState->iBufferUsed;
+      pState->buffer[i++] = 1;
+      for( ; i<16; i++ )
+         pState->buffer[i] = 0;
+      _poly1305_blocks(pState, pState->buffer, 16, 0);
+   }
+
+   uint32_t h0 = pState->h[0], h1 = pState->h[1], h2 = pState->h[2], h3 = pState->h[3], h4 = pState->h[4];
+   uint32_t c;
+
+   // Fully carry h
+   c = h1 >> 26; h1 &= 0x3ffffff;
+   h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+   h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+   h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+   h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+   h1 += c;
+
+   // Compute h - p and select it if h >= p (constant time)
+   uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+   uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+   uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+   uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+   uint32_t g4 = h4 + c - (1UL << 26);
+
+   uint32_t uMask = (g4 >> 31) - 1;
+   g0 &= uMask; g1 &= uMask; g2 &= uMask; g3 &= uMask; g4 &= uMask;
+   uMask = ~uMask;
+   h0 = (h0 & uMask) | g0;
+   h1 = (h1 & uMask) | g1;
+   h2 = (h2 & uMask) | g2;
+   h3 = (h3 & uMask) | g3;
+   h4 = (h4 & uMask) | g4;
+
+   // h = h % 2^128, then add the pad
+   h0 = (h0 | (h1 << 26));
+   h1 = ((h1 >> 6) | (h2 << 20));
+   h2 = ((h2 >> 12) | (h3 << 14));
+   h3 = ((h3 >> 18) | (h4 << 8));
+
+   uint64_t f;
+   f = (uint64_t)h0 + pState->pad[0]; h0 = (uint32_t)f;
+   f = (uint64_t)h1 + pState->pad[1] + (f >> 32); h1 = (uint32_t)f;
+   f = (uint64_t)h2 + pState->pad[2] + (f >> 32); h2 = (uint32_t)f;
+   f = (uint64_t)h3 + pState->pad[3] + (f >> 32); h3 = (uint32_t)f;
+
+   U32TO8_LE(pTagOut + 0, h0);
+   U32TO8_LE(pTagOut + 4, h1);
+   U32TO8_LE(pTagOut + 8, h2);
+   U32TO8_LE(pTagOut + 12, h3);
+
+   memset(pState, 0, sizeof(t_poly1305_state));
+}
+
+void poly1305_mac(const uint8_t* pKey, const uint8_t* pData, int iLength, uint8_t* pTagOut)
+{
+   t_poly1305_state state;
+   _poly1305_init(&state, pKey);
+   _poly1305_update(&state, pData, iLength);
+   _poly1305_finish(&state, pTagOut);
+}
+
+//--------------------------------------------------------
+// AEAD construction
+
+static void _chacha20_poly1305_tag(const uint8_t* pKey, const uint8_t* pNonce, const uint8_t* pAD, int iADLength, const uint8_t* pCipherText, int iLength, uint8_t* pTagOut)
+{
+   static const uint8_t s_Zeros[16] = {0};
+   uint8_t block[64];
+   uint8_t lengths[16];
+   t_poly1305_state state;
+
+   // One time Poly1305 key is the first half of keystream block 0
+   chacha20_block(pKey, 0, pNonce, block);
+   _poly1305_init(&state, block);
+
+   if ( iADLength > 0 )
+   {
+      _poly1305_update(&state, pAD, iADLength);
+      if ( iADLength & 15 )
+         _poly1305_update(&state, s_Zeros, 16 - (iADLength & 15));
+   }
+   if ( iLength > 0 )
+   {
+      _poly1305_update(&state, pCipherText, iLength);
+      if ( iLength & 15 )
+         _poly1305_update(&state, s_Zeros, 16 - (iLength & 15));
+   }
+   memset(lengths, 0, sizeof(lengths));
+   U32TO8_LE(lengths, (uint32_t)iADLength);
+   U32TO8_LE(lengths + 8, (uint32_t)iLength);
+   _poly1305_update(&state, lengths, 16);
+   _poly1305_finish(&state, pTagOut);
+   memset(block, 0, sizeof(block));
+}
+
+void chacha20_poly1305_encrypt(const uint8_t* pKey, const uint8_t* pNonce,
+                               const uint8_t* pAD, int iADLength,
+                               uint8_t* pData, int iLength,
+                               uint8_t* pTagOut)
+{
+   chacha20_xor(pKey, 1, pNonce, pData, iLength);
+   _chacha20_poly1305_tag(pKey, pNonce, pAD, iADLength, pData, iLength, pTagOut);
+}
+
+int chacha20_poly1305_decrypt(const uint8_t* pKey, const uint8_t* pNonce,
+                              const uint8_t* pAD, int iADLength,
+                              uint8_t* pData, int iLength,
+                              const uint8_t* pTag)
+{
+   uint8_t tag[CHACHA20_POLY1305_TAG_SIZE];
+   _chacha20_poly1305_tag(pKey, pNonce, pAD, iADLength, pData, iLength, tag);
+
+   uint8_t uDiff = 0;
+   for( int i=0; i<CHACHA20_POLY1305_TAG_SIZE; i++ )
+      uDiff |= tag[i] ^ pTag[i];
+   if ( 0 != uDiff )
+      return 0;
+
+   chacha20_xor(pKey, 1, pNonce, pData, iLength);
+   return 1;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * ChaCha20-Poly1305 AEAD (RFC 8439), small portable implementation.
+ * All functions work in place on the data buffer.
+ */
+
+#define CHACHA20_POLY1305_KEY_SIZE 32
+#define CHACHA20_POLY1305_NONCE_SIZE 12
+#define CHACHA20_POLY1305_TAG_SIZE 16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Generates one 64 bytes keystream block
+void chacha20_block(const uint8_t* pKey, uint32_t uCounter, const uint8_t* pNonce, uint8_t* pOut);
+
+// XORs data with the keystream starting at block uCounter
+void chacha20_xor(const uint8_t* pKey, uint32_t uCounter, const uint8_t* pNonce, uint8_t* pData, int iLength);
+
+void poly1305_mac(const uint8_t* pKey, const uint8_t* pData, int iLength, uint8_t* pTagOut);
+
+void chacha20_poly1305_encrypt(const uint8_t* pKey, const uint8_t* pNonce,
+                               const uint8_t* pAD, int iADLength,
+                               uint8_t* pData, int iLength,
+                               uint8_t* pTagOut);
+
+// Returns 1 and decrypts the data if the tag is valid, 0 (data left untouched) otherwise
+int chacha20_poly1305_decrypt(const uint8_t* pKey, const uint8_t* pNonce,
+                              const uint8_t* pAD, int iADLength,
+                              uint8_t* pData, int iLength,
+                              const uint8_t* pTag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -88,6 +88,9 @@
 
 #define DEFAULT_USE_PPCAP_FOR_TX 0
 #define DEFAULT_BYPASS_SOCKET_BUFFERS 1
+#define DEFAULT_USE_RX_RING 0
+#define DEFAULT_RADIO_TX_BATCHING 1
+#define DEFAULT_RADIO_RX_THREAD_PER_INTERFACE 0
 #define DEFAULT_RADIO_TX_POWER_CONTROLLER 20
 #define DEFAULT_RADIO_TX_POWER 20
 #define DEFAULT_RADIO_SIK_TX_POWER 11
@@ -13,11 +13,13 @@
 #define LOG_FILE_VIDEO "log_video.txt"
 #define LOG_FILE_CAPTURE_VEYE "log_capture_veye.txt"
 #define LOG_FILE_VEHICLE "log_vehicle_%s.txt"
+#define LOG_FILE_ADAPTIVE_VIDEO_TRACE "adaptive_video_trace_%u.bin"
 
 #define FILE_FORMAT_SCREENSHOT "picture-%s-%d-%d-%d.png"
 #define FILE_FORMAT_VIDEO_INFO "video-%s-%d-%d-%d.info"
 
 #define LOG_USE_PROCESS "use_log_process"
+#define TRACE_ENABLE_FLAG "enable_trace"
 #define CONFIG_FILENAME_DEBUG "debug"
 #define FILE_INFO_VERSION "version_ruby_base.txt"
 #define FILE_INFO_SHORT_LAST_UPDATE "ruby_update.log"
@@ -83,6 +85,7 @@
 #define FILE_TEMP_RADIOS_CONFIGURED "radio_configured"
 #define FILE_TEMP_INTRO_PLAYING "intro_playing"
 #define FILE_TEMP_STOP "cmdstop"
+#define FILE_TEMP_RECORD_ADAPTIVE_VIDEO_TRACE "record_adaptive_video_trace"
 #define SUBFOLDER_UPDATES_PI    "bin/pi/"
 #define SUBFOLDER_UPDATES_RADXA "bin/radxaz3/"
 #define SUBFOLDER_UPDATES_OIPC  "bin/ssc338q/"
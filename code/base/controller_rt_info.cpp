@@ -56,7 +56,7 @@ controller_runtime_info* controller_rt_info_open_for_write()
 void controller_rt_info_close(controller_runtime_info* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(controller_runtime_info));
+      close_shared_mem(pAddress, sizeof(controller_runtime_info));
    //shm_unlink(szName);
 }
 
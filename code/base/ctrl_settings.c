@@ -115,6 +115,8 @@ void reset_ControllerSettings()
    s_CtrlSettings.iStreamerOutputMode = 0;
    s_CtrlSettings.iVideoMPPBuffersSize = DEFAULT_MPP_BUFFERS_SIZE;
    s_CtrlSettings.iHDMIVSync = 1;
+   s_CtrlSettings.iRadioRxUsesRing = DEFAULT_USE_RX_RING;
+   s_CtrlSettings.iRadioRxThreadPerInterface = DEFAULT_RADIO_RX_THREAD_PER_INTERFACE;
    if ( s_CtrlSettingsLoaded )
       log_line("Reseted controller settings.");
 }
@@ -170,6 +172,7 @@ int save_ControllerSettings()
    fprintf(fd, "%d %d\n", s_CtrlSettings.iCoresAdjustment, s_CtrlSettings.iPrioritiesAdjustment);
    fprintf(fd, "%d %d\n", s_CtrlSettings.iStreamerOutputMode, s_CtrlSettings.iVideoMPPBuffersSize);
    fprintf(fd, "%d\n", s_CtrlSettings.iHDMIVSync);
+   fprintf(fd, "%d %d\n", s_CtrlSettings.iRadioRxUsesRing, s_CtrlSettings.iRadioRxThreadPerInterface);
    fclose(fd);
 
    log_line("Saved controller settings to file: %s", szFile);
@@ -304,6 +307,18 @@ int load_ControllerSettings()
       s_CtrlSettings.iHDMIVSync = 1;
       iWriteOptionalValues = 1;
    }
+
+   if ( 1 != fscanf(fd, "%d", &s_CtrlSettings.iRadioRxUsesRing) )
+   {
+      s_CtrlSettings.iRadioRxUsesRing = DEFAULT_USE_RX_RING;
+      iWriteOptionalValues = 1;
+   }
+
+   if ( 1 != fscanf(fd, "%d", &s_CtrlSettings.iRadioRxThreadPerInterface) )
+   {
+      s_CtrlSettings.iRadioRxThreadPerInterface = DEFAULT_RADIO_RX_THREAD_PER_INTERFACE;
+      iWriteOptionalValues = 1;
+   }
    fclose(fd);
 
    //--------------------------------------------------------
@@ -346,6 +361,10 @@ int load_ControllerSettings()
 
    if ( (s_CtrlSettings.iHDMIVSync != 0) && (s_CtrlSettings.iHDMIVSync != 1) )
       s_CtrlSettings.iHDMIVSync = 1;
+   if ( (s_CtrlSettings.iRadioRxUsesRing != 0) && (s_CtrlSettings.iRadioRxUsesRing != 1) )
+      s_CtrlSettings.iRadioRxUsesRing = DEFAULT_USE_RX_RING;
+   if ( (s_CtrlSettings.iRadioRxThreadPerInterface != 0) && (s_CtrlSettings.iRadioRxThreadPerInterface != 1) )
+      s_CtrlSettings.iRadioRxThreadPerInterface = DEFAULT_RADIO_RX_THREAD_PER_INTERFACE;
    if ( failed )
    {
       log_line("Invalid settings file %s, error code: %d. Reseted to default.", szFile, failed);
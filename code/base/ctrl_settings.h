@@ -78,6 +78,8 @@ typedef struct
    int iStreamerOutputMode; // 0 - sm, 1 - pipe, 2 - udp
    int iVideoMPPBuffersSize;
    int iHDMIVSync;
+   int iRadioRxUsesRing;
+   int iRadioRxThreadPerInterface;
 } ControllerSettings;
 
 int save_ControllerSettings();
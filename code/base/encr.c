@@ -33,14 +33,184 @@
 #include "base.h"
 #include "config.h"
 #include "encr.h"
+#include "chacha20poly1305.h"
 #include "../radio/radiopackets2.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/random.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #define ENC_BLOCK_SIZE 8
 #define ENC_KEY_INIT_SEED 23
+#define ENC_AEAD_RX_SESSIONS 4
 
 u8 s_epp[MAX_PASS_LENGTH+1];
 u8 s_eppl = 0;
 
+// Pass phrase repeated over a whole packet, so epp/dpp are a plain XOR of two buffers.
+// Its length is a multiple of the pass phrase length, so longer buffers are processed in chunks of it.
+u8 s_uEncKeyStream[MAX_PACKET_TOTAL_SIZE + MAX_PASS_LENGTH] __attribute__((aligned(16)));
+int s_iEncKeyStreamLength = 0;
+
+int s_iEncMode = ENC_PP_MODE_XOR;
+u8 s_uEncAeadKey[CHACHA20_POLY1305_KEY_SIZE];
+
+// Packet counters restart from zero on each boot, so the AEAD key is per session:
+// derived from the pass phrase key and a random salt picked at startup and sent in clear with each packet.
+int s_bEncSessionSaltSet = 0;
+u8 s_uEncSessionSalt[ENC_AEAD_SALT_SIZE];
+u8 s_uEncSessionKey[CHACHA20_POLY1305_KEY_SIZE];
+
+typedef struct
+{
+   int bUsed;
+   u32 uLastUseIndex;
+   u8 uSalt[ENC_AEAD_SALT_SIZE];
+   u8 uKey[CHACHA20_POLY1305_KEY_SIZE];
+} t_encr_rx_session;
+
+t_encr_rx_session s_EncRxSessions[ENC_AEAD_RX_SESSIONS];
+u32 s_uEncRxSessionsUseIndex = 0;
+
+static void _encr_build_session_key(const u8* pSalt, u8* pKeyOut)
+{
+   u8 uNonce[CHACHA20_POLY1305_NONCE_SIZE] = { 'r','s','e','s' };
+   u8 uBlock[64];
+   memcpy(uNonce + 4, pSalt, ENC_AEAD_SALT_SIZE);
+   chacha20_block(s_uEncAeadKey, 0, uNonce, uBlock);
+   memcpy(pKeyOut, uBlock, CHACHA20_POLY1305_KEY_SIZE);
+   memset(uBlock, 0, sizeof(uBlock));
+}
+
+static void _encr_generate_session_salt()
+{
+   int iRead = 0;
+   ssize_t iRes = getrandom(s_uEncSessionSalt, ENC_AEAD_SALT_SIZE, 0);
+   if ( iRes == ENC_AEAD_SALT_SIZE )
+      iRead = ENC_AEAD_SALT_SIZE;
+   else
+   {
+      int fd = open("/dev/urandom", O_RDONLY);
+      if ( fd >= 0 )
+      {
+         if ( ENC_AEAD_SALT_SIZE == read(fd, s_uEncSessionSalt, ENC_AEAD_SALT_SIZE) )
+            iRead = ENC_AEAD_SALT_SIZE;
+         close(fd);
+      }
+   }
+   if ( iRead != ENC_AEAD_SALT_SIZE )
+   {
+      // No entropy source: at least make it differ between boots and processes
+      struct timespec t;
+      clock_gettime(CLOCK_REALTIME, &t);
+      u32 uValues[2] = { (u32)t.tv_sec ^ ((u32)getpid() << 16), (u32)t.tv_nsec };
+      memcpy(s_uEncSessionSalt, uValues, ENC_AEAD_SALT_SIZE);
+   }
+   s_bEncSessionSaltSet = 1;
+}
+
+static void _encr_build_keys()
+{
+   s_iEncKeyStreamLength = 0;
+   memset(s_uEncAeadKey, 0, sizeof(s_uEncAeadKey));
+   memset(s_uEncSessionKey, 0, sizeof(s_uEncSessionKey));
+   memset(s_EncRxSessions, 0, sizeof(s_EncRxSessions));
+   if ( s_eppl > MAX_PASS_LENGTH )
+      s_eppl = MAX_PASS_LENGTH;
+   if ( 0 == s_eppl )
+      return;
+
+   while ( s_iEncKeyStreamLength + s_eppl <= MAX_PACKET_TOTAL_SIZE )
+   {
+      memcpy(&s_uEncKeyStream[s_iEncKeyStreamLength], s_epp, s_eppl);
+      s_iEncKeyStreamLength += s_eppl;
+   }
+
+   // AEAD key: pass phrase folded into 32 bytes, then one ChaCha20 block keyed by it (a PRF, no key stretching)
+   static const u8 s_uKdfNonce[CHACHA20_POLY1305_NONCE_SIZE] = { 'r','u','b','y','-','a','e','a','d','k','d','f' };
+   u8 uFolded[CHACHA20_POLY1305_KEY_SIZE];
+   u8 uBlock[64];
+   memset(uFolded, 0, sizeof(uFolded));
+   for( int i=0; i<s_eppl; i++ )
+      uFolded[i % CHACHA20_POLY1305_KEY_SIZE] ^= s_epp[i];
+   chacha20_block(uFolded, s_eppl, s_uKdfNonce, uBlock);
+   memcpy(s_uEncAeadKey, uBlock, CHACHA20_POLY1305_KEY_SIZE);
+   memset(uFolded, 0, sizeof(uFolded));
+   memset(uBlock, 0, sizeof(uBlock));
+
+   if ( ! s_bEncSessionSaltSet )
+      _encr_generate_session_salt();
+   _encr_build_session_key(s_uEncSessionSalt, s_uEncSessionKey);
+}
+
+// Returns the key of a known session (our own or a cached rx one), or NULL
+static u8* _encr_find_rx_session_key(const u8* pSalt)
+{
+   s_uEncRxSessionsUseIndex++;
+   if ( s_bEncSessionSaltSet && (0 == memcmp(pSalt, s_uEncSessionSalt, ENC_AEAD_SALT_SIZE)) )
+      return s_uEncSessionKey;
+
+   for( int i=0; i<ENC_AEAD_RX_SESSIONS; i++ )
+   {
+      if ( s_EncRxSessions[i].bUsed && (0 == memcmp(pSalt, s_EncRxSessions[i].uSalt, ENC_AEAD_SALT_SIZE)) )
+      {
+         s_EncRxSessions[i].uLastUseIndex = s_uEncRxSessionsUseIndex;
+         return s_EncRxSessions[i].uKey;
+      }
+   }
+   return NULL;
+}
+
+// Only called once a packet with this salt was authenticated, so forged salts can't evict real sessions
+static void _encr_add_rx_session_key(const u8* pSalt, const u8* pKey)
+{
+   int iOldest = 0;
+   for( int i=0; i<ENC_AEAD_RX_SESSIONS; i++ )
+   {
+      if ( ! s_EncRxSessions[i].bUsed )
+      {
+         iOldest = i;
+         break;
+      }
+      if ( s_EncRxSessions[i].uLastUseIndex < s_EncRxSessions[iOldest].uLastUseIndex )
+         iOldest = i;
+   }
+
+   t_encr_rx_session* pSession = &s_EncRxSessions[iOldest];
+   pSession->bUsed = 1;
+   pSession->uLastUseIndex = s_uEncRxSessionsUseIndex;
+   memcpy(pSession->uSalt, pSalt, ENC_AEAD_SALT_SIZE);
+   memcpy(pSession->uKey, pKey, CHACHA20_POLY1305_KEY_SIZE);
+}
+
+static void _encr_xor_keystream(u8* pData, int len)
+{
+   while ( len > 0 )
+   {
+      const u8* pKey = s_uEncKeyStream;
+      int iCount = (len < s_iEncKeyStreamLength) ? len : s_iEncKeyStreamLength;
+      int pos = 0;
+      #if defined(__ARM_NEON)
+      for( ; pos + 16 <= iCount; pos += 16 )
+         vst1q_u8(pData + pos, veorq_u8(vld1q_u8(pData + pos), vld1q_u8(pKey + pos)));
+      #endif
+      for( ; pos + 8 <= iCount; pos += 8 )
+      {
+         uint64_t uData, uKey;
+         memcpy(&uData, pData + pos, 8);
+         memcpy(&uKey, pKey + pos, 8);
+         uData ^= uKey;
+         memcpy(pData + pos, &uData, 8);
+      }
+      for( ; pos < iCount; pos++ )
+         pData[pos] ^= pKey[pos];
+      pData += iCount;
+      len -= iCount;
+   }
+}
+
 int lpp(char* szOutputBuffer, int maxLength)
 {
    char szFile[128];
@@ -84,6 +254,8 @@ int lpp(char* szOutputBuffer, int maxLength)
          sBlockSeed[k] = sBlockEnc[k];
    }
 
+   fclose(fd);
+
    if ( pos == 0 )
       return 0;
 
@@ -91,6 +263,7 @@ int lpp(char* szOutputBuffer, int maxLength)
    s_eppl = pos;
    strncpy((char*)s_epp, szBuffer, MAX_PASS_LENGTH);
    s_epp[MAX_PASS_LENGTH] = 0;
+   _encr_build_keys();
 
    if ( NULL != szOutputBuffer )
       strncpy(szOutputBuffer, szBuffer, maxLength);
@@ -98,6 +271,17 @@ int lpp(char* szOutputBuffer, int maxLength)
    return 1;
 }
 
+int upp(char* szBuffer)
+{
+   if ( NULL == szBuffer || 0 == szBuffer[0] )
+      return 0;
+   s_eppl = strlen(szBuffer);
+   strncpy((char*)s_epp, szBuffer, MAX_PASS_LENGTH);
+   s_epp[MAX_PASS_LENGTH] = 0;
+   _encr_build_keys();
+   return 1;
+}
+
 int spp(char* szBuffer)
 {
    if ( NULL == szBuffer || 0 == szBuffer[0] )
@@ -110,9 +294,7 @@ int spp(char* szBuffer)
    if ( NULL == fd )
       return 0;
 
-   s_eppl = strlen(szBuffer);
-   strncpy((char*)s_epp, szBuffer, MAX_PASS_LENGTH);
-   s_epp[MAX_PASS_LENGTH] = 0;
+   upp(szBuffer);
 
    u8 sBlockSeed[ENC_BLOCK_SIZE];
    u8 sBlockInput[ENC_BLOCK_SIZE];
@@ -165,6 +347,7 @@ void rpp()
 {
    s_eppl = 0;
    s_epp[0] = 0;
+   _encr_build_keys();
 }
 
 u8* gpp(int* pLen)
@@ -188,12 +371,7 @@ int epp(u8* pData, int len)
    if ( 0 == s_eppl )
       return 1;
 
-   for(int pos=0; pos < len; pos++ )
-   {
-      //*pData = (*pData)+1;
-      *pData = (*pData) ^ s_epp[pos%s_eppl];
-      pData++;
-   }
+   _encr_xor_keystream(pData, len);
    return 1;
 }
 
@@ -204,11 +382,48 @@ int dpp(u8* pData, int len)
    if ( 0 == s_eppl )
       return 1;
 
-   for(int pos=0; pos < len; pos++ )
-   {
-      //*pData = (*pData)-1;
-      *pData = (*pData) ^ s_epp[pos%s_eppl];
-      pData++;
-   }
+   _encr_xor_keystream(pData, len);
+   return 1;
+}
+
+void spm(int iMode)
+{
+   s_iEncMode = iMode;
+}
+
+int gpm()
+{
+   return s_iEncMode;
+}
+
+void rpps()
+{
+   _encr_generate_session_salt();
+   if ( 0 < s_eppl )
+      _encr_build_session_key(s_uEncSessionSalt, s_uEncSessionKey);
+}
+
+int eppa(u8* pAD, int iADLength, u8* pData, int len, u8* pNonce, u8* pSaltOut, u8* pTagOut)
+{
+   if ( (NULL == pData) || (len < 0) || (NULL == pNonce) || (NULL == pSaltOut) || (NULL == pTagOut) || (0 == s_eppl) )
+      return 0;
+   memcpy(pSaltOut, s_uEncSessionSalt, ENC_AEAD_SALT_SIZE);
+   chacha20_poly1305_encrypt(s_uEncSessionKey, pNonce, pAD, iADLength, pData, len, pTagOut);
+   return 1;
+}
+
+int dppa(u8* pAD, int iADLength, u8* pData, int len, u8* pNonce, u8* pSalt, u8* pTag)
+{
+   if ( (NULL == pData) || (len < 0) || (NULL == pNonce) || (NULL == pSalt) || (NULL == pTag) || (0 == s_eppl) )
+      return 0;
+   u8* pKey = _encr_find_rx_session_key(pSalt);
+   if ( NULL != pKey )
+      return chacha20_poly1305_decrypt(pKey, pNonce, pAD, iADLength, pData, len, pTag);
+
+   u8 uKey[CHACHA20_POLY1305_KEY_SIZE];
+   _encr_build_session_key(pSalt, uKey);
+   if ( ! chacha20_poly1305_decrypt(uKey, pNonce, pAD, iADLength, pData, len, pTag) )
+      return 0;
+   _encr_add_rx_session_key(pSalt, uKey);
    return 1;
 }
@@ -6,6 +6,14 @@
 
 #define MAX_PASS_LENGTH 64
 
+#define ENC_PP_MODE_XOR 0
+#define ENC_PP_MODE_AEAD 1
+#define ENC_AEAD_NONCE_SIZE 12
+#define ENC_AEAD_TAG_SIZE 16
+#define ENC_AEAD_SALT_SIZE 8
+// Appended after the packet: session salt, then the tag
+#define ENC_AEAD_TRAILER_SIZE (ENC_AEAD_SALT_SIZE + ENC_AEAD_TAG_SIZE)
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,6 +22,8 @@ extern "C" {
 // Load and saves pass phrases
 int lpp(char* szOutputBuffer, int maxLength);
 int spp(char* szBuffer);
+// Uses the pass phrase in this process, without saving it
+int upp(char* szBuffer);
 
 void rpp();
 u8* gpp(int* pLen);
@@ -22,6 +32,20 @@ int hpp();
 int epp(u8* pData, int len);
 int dpp(u8* pData, int len);
 
+// Mode used for sending (ENC_PP_MODE_XOR or ENC_PP_MODE_AEAD)
+void spm(int iMode);
+int gpm();
+
+// ChaCha20-Poly1305, in place, ENC_AEAD_TAG_SIZE bytes tag. The key is derived from the pass phrase
+// and a random per session salt (ENC_AEAD_SALT_SIZE bytes, sent in clear), so nonces built from
+// packet counters that restart on each boot are not reused with the same key.
+// eppa outputs the local session salt; dppa uses the sender's salt.
+// dppa returns 0 (data untouched) if the packet was not authenticated.
+int eppa(u8* pAD, int iADLength, u8* pData, int len, u8* pNonce, u8* pSaltOut, u8* pTagOut);
+int dppa(u8* pAD, int iADLength, u8* pData, int len, u8* pNonce, u8* pSalt, u8* pTag);
+// Starts a new local session (new random salt)
+void rpps();
+
 #ifdef __cplusplus
 }  
 #endif 
\ No newline at end of file
@@ -44,6 +44,7 @@
 #define MODEL_ENC_FLAG_ENC_DATA   ((u32)(((u32)0x01)<<1))
 #define MODEL_ENC_FLAG_ENC_VIDEO  ((u32)(((u32)0x01)<<2))
 #define MODEL_ENC_FLAG_ENC_ALL    ((u32)(((u32)0x01)<<3))
+#define MODEL_ENC_FLAG_USE_AEAD   ((u32)(((u32)0x01)<<4)) // ChaCha20-Poly1305 instead of the pass phrase XOR obfuscation
 
 // raspivid commands
 #define RASPIVID_COMMAND_ID_BRIGHTNESS 1
@@ -67,4 +67,5 @@
 #define VIDEO_FLAG_ENABLE_LOCAL_HDMI_OUTPUT  ((u32)(((u32)0x01)<<2))
 #define VIDEO_FLAG_RETRANSMISSIONS_FAST      ((u32)(((u32)0x01)<<3))
 #define VIDEO_FLAG_GENERATE_H265             ((u32)(((u32)0x01)<<4))
-#define VIDEO_FLAG_NEW_ADAPTIVE_ALGORITHM    ((u32)(((u32)0x01)<<5))
+#define VIDEO_FLAG_NEW_ADAPTIVE_ALGORITHM    ((u32)(((u32)0x01)<<5)) // not used, can be set on models saved by older versions
+#define VIDEO_FLAG_PREDICTIVE_ADAPTIVE_VIDEO ((u32)(((u32)0x01)<<6))
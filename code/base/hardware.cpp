@@ -35,6 +35,8 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/resource.h>
+#include <sys/utsname.h>
+#include <dirent.h>
 #include <ctype.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -47,6 +49,7 @@
 #include "gpio.h"
 #include "config.h"
 #include "hw_procs.h"
+#include "hw_sys.h"
 #include "hardware_camera.h"
 #include "hardware_files.h"
 #include "hardware_i2c.h"
@@ -130,6 +133,20 @@ int  s_iHardwareSystemIsVehicle = 0;
 int s_iHardwareJoystickCount = 0;
 hw_joystick_info_t s_HardwareJoystickInfo[MAX_JOYSTICK_INTERFACES];
 
+#if defined (HW_PLATFORM_RASPBERRY) || defined (HW_PLATFORM_OPENIPC_CAMERA)
+static void _hardware_save_board_description(const char* szFile)
+{
+   char szModel[256];
+   if ( hw_sys_read_file("/proc/device-tree/model", szModel, sizeof(szModel)) < 0 )
+      return;
+   FILE* fd = fopen(szFile, "w");
+   if ( NULL == fd )
+      return;
+   fprintf(fd, "%s", szModel);
+   fclose(fd);
+}
+#endif
+
 void _hardware_detectSystemType()
 {
    log_line("[Hardware] Detecting system type...");
@@ -152,7 +169,7 @@ void _hardware_detectSystemType()
       fclose(fd);
    }
    log_line("[Hardware] Do full detection of board and system type...");
-   hw_execute_bash_command_raw("cat /proc/device-tree/model", szBuff);
+   hw_sys_read_file("/proc/device-tree/model", szBuff, sizeof(szBuff));
    log_line("[Hardware] Board description string: %s", szBuff);
 
    s_uHardwareBoardType = hardware_getBoardType();
@@ -292,11 +309,11 @@ void _hardware_detectSystemType()
       fprintf(fd, "%u\n", s_uHardwareBoardType);
       fclose(fd);
    }
-   hw_execute_bash_command("cat /proc/device-tree/model > /boot/ruby_board_desc.txt", NULL);
+   _hardware_save_board_description("/boot/ruby_board_desc.txt");
    #endif
 
    #if defined (HW_PLATFORM_OPENIPC_CAMERA)
-   hw_execute_bash_command("cat /proc/device-tree/model > /root/ruby/config/ruby_board_desc.txt", NULL);
+   _hardware_save_board_description("/root/ruby/config/ruby_board_desc.txt");
    #endif
 
    log_line("[Hardware] Detected system Type: %s", s_iHardwareSystemIsVehicle?"[vehicle]":"[controller]");
@@ -559,14 +576,18 @@ void _hardware_detect_board_radxa(char* szBoardId)
 {
    #if defined (HW_PLATFORM_RADXA)
    s_uHardwareBoardType = BOARD_TYPE_RADXA_ZERO3;
-   char szOutput[4096];
-   hw_execute_bash_command_raw("uname -a", szOutput);
-   removeTrailingNewLines(szOutput);
-   if ( NULL != strstr(szOutput, "radxa3c") )
-      s_uHardwareBoardType = BOARD_TYPE_RADXA_3C;
+   char szOutput[1024];
+   struct utsname unameInfo;
+   if ( 0 == uname(&unameInfo) )
+   {
+      snprintf(szOutput, sizeof(szOutput)/sizeof(szOutput[0]), "%s %s %s %s %s", unameInfo.sysname, unameInfo.nodename, unameInfo.release, unameInfo.version, unameInfo.machine);
+      if ( NULL != strstr(szOutput, "radxa3c") )
+         s_uHardwareBoardType = BOARD_TYPE_RADXA_3C;
+   }
 
-   hw_execute_bash_command_raw("lscpu | grep Model", szOutput);
-   if ( NULL != strstr(szOutput, "Cortex-A55") )
+   // ARM part 0xd05 is Cortex-A55
+   hw_sys_read_key_value("/proc/cpuinfo", "CPU part", szOutput, sizeof(szOutput)/sizeof(szOutput[0]));
+   if ( 0 == strcasecmp(szOutput, "0xd05") )
    {
       bool bVRx = false;
       if ( access("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_cur_freq", R_OK) == -1 )
@@ -575,17 +596,10 @@ void _hardware_detect_board_radxa(char* szBoardId)
       if ( access("/home/8812eu_radxa.ko", R_OK) != -1 )
       if ( (access("/home/radxa/ruby/drivers", R_OK) == -1) || bVRx )
       {
-         hw_execute_bash_command_raw("lsusb | grep 0bda:a81a", szOutput);
-         char* pId = strstr(szOutput, "0bda:a81a");
-         if ( NULL != pId )
+         if ( hw_sys_count_usb_devices(0x0bda, 0xa81a) >= 2 )
          {
-            pId += 8;
-            pId = strstr(pId, "0bda:a81a");
-            if ( NULL != pId )
-            {
-               log_line("[Hardware] Detected RunCam VRx board.");
-               s_uHardwareBoardType = BOARD_TYPE_RADXA_RUNCAM_VRX;
-            }
+            log_line("[Hardware] Detected RunCam VRx board.");
+            s_uHardwareBoardType = BOARD_TYPE_RADXA_RUNCAM_VRX;
          }
       }
    }
@@ -604,8 +618,7 @@ u32 hardware_detectBoardType()
    char szBoardId[64];
    szBoardId[0] = 0;
    #if defined (HW_PLATFORM_RASPBERRY)
-   hw_execute_bash_command("cat /proc/cpuinfo | grep 'Revision' | awk '{print $3}'", szBoardId);
-   removeTrailingNewLines(szBoardId);
+   hw_sys_read_key_value("/proc/cpuinfo", "Revision", szBoardId, sizeof(szBoardId)/sizeof(szBoardId[0]));
    log_line("[Hardware] Detected board Id: (%s)", szBoardId);
 
    if ( strcmp(szBoardId, "a03111") == 0 ) { s_uHardwareBoardType = BOARD_TYPE_PI4B;}
@@ -1007,7 +1020,13 @@ u16 hardware_get_flags()
    u16 retValue = 0xFFFF;
 
    #ifdef HW_PLATFORM_RASPBERRY
+   // Newer firmware drivers expose the throttled flags in sysfs (hex value, no prefix)
    char szOut[1024];
+   if ( hw_sys_read_file("/sys/devices/platform/soc/soc:firmware/get_throttled", szOut, sizeof(szOut)) > 0 )
+   {
+      unsigned long ul = strtoul(szOut, NULL, 16);
+      return (u16)((ul & 0xF) | ((ul>>16) << 4));
+   }
    hw_execute_bash_command_silent("vcgencmd get_throttled", szOut);
    int len = strlen(szOut)-1;
    while (len > 0 )
@@ -1820,14 +1839,26 @@ char* hardware_has_eth()
 {
    char szETHName[128];
    s_szHardwareETHName[0] = 0;
+   szETHName[0] = 0;
 
-   hw_execute_bash_command_raw("ls /sys/class/net/ | grep eth0", szETHName);
-   if ( strlen(szETHName) < 4 )
-      hw_execute_bash_command_raw("ls /sys/class/net/ | grep eth1", szETHName);
-   if ( strlen(szETHName) < 4 )
-      hw_execute_bash_command_raw("ls /sys/class/net/ | grep etx", szETHName);
-   if ( strlen(szETHName) < 4 )
-      hw_execute_bash_command_raw("ls /sys/class/net/ | grep enx", szETHName);
+   const char* s_szETHPrefixes[] = { "eth0", "eth1", "etx", "enx" };
+   for( int i=0; (i<(int)(sizeof(s_szETHPrefixes)/sizeof(s_szETHPrefixes[0]))) && (strlen(szETHName) < 4); i++ )
+   {
+      DIR* pDir = opendir("/sys/class/net/");
+      if ( NULL == pDir )
+         break;
+      struct dirent* pEntry = NULL;
+      while ( NULL != (pEntry = readdir(pDir)) )
+      {
+         if ( NULL != strstr(pEntry->d_name, s_szETHPrefixes[i]) )
+         {
+            strncpy(szETHName, pEntry->d_name, sizeof(szETHName)/sizeof(szETHName[0])-1);
+            szETHName[sizeof(szETHName)/sizeof(szETHName[0])-1] = 0;
+            break;
+         }
+      }
+      closedir(pDir);
+   }
 
    if ( strlen(szETHName) < 4 )
    {
@@ -1857,27 +1888,31 @@ char* hardware_has_eth()
 
 void hardware_set_default_sigmastar_cpu_freq()
 {
-   hw_execute_bash_command_raw("echo 'performance' | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_governor", NULL);
-   char szBuff[256];
-   snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "echo %d | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_max_freq", DEFAULT_FREQ_OPENIPC_SIGMASTAR*1000);
-   hw_execute_bash_command_raw(szBuff, NULL);
-   hw_execute_bash_command_raw("echo 800000 | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_min_freq", NULL);
+   hw_sys_write_cpufreq_all("scaling_governor", "performance");
+   char szBuff[32];
+   snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "%d", DEFAULT_FREQ_OPENIPC_SIGMASTAR*1000);
+   hw_sys_write_cpufreq_all("scaling_max_freq", szBuff);
+   hw_sys_write_cpufreq_all("scaling_min_freq", "800000");
 }
 
 void hardware_set_default_radxa_cpu_freq()
 {
    if ( hardware_is_running_on_runcam_vrx() )
       return;
-   hw_execute_bash_command_raw("echo 'performance' | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_governor", NULL);
-   char szBuff[256];
-   snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "echo %d | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_max_freq", DEFAULT_FREQ_RADXA*1000);
-   hw_execute_bash_command_raw(szBuff, NULL);
-   hw_execute_bash_command_raw("echo 1400000 | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_min_freq", NULL); 
+   hw_sys_write_cpufreq_all("scaling_governor", "performance");
+   char szBuff[32];
+   snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "%d", DEFAULT_FREQ_RADXA*1000);
+   hw_sys_write_cpufreq_all("scaling_max_freq", szBuff);
+   hw_sys_write_cpufreq_all("scaling_min_freq", "1400000");
 }
 
 int hardware_get_cpu_speed()
 {
    #if defined(HW_PLATFORM_RASPBERRY)
+   int iFreqKhz = 0;
+   if ( hw_sys_read_int("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", &iFreqKhz) && (iFreqKhz > 0) )
+      return iFreqKhz/1000;
+
    char szOutput[64];
    szOutput[0] = 0;
    hw_execute_bash_command_raw_silent("vcgencmd measure_clock arm", szOutput);
@@ -1919,19 +1954,19 @@ int hardware_get_cpu_speed()
    #if defined(HW_PLATFORM_RADXA)
    if ( hardware_is_running_on_runcam_vrx() )
       return 1000;
-   char szOutput[1024];
-   hw_execute_bash_command_raw_silent("cat /sys/devices/system/cpu/cpufreq/policy0/cpuinfo_cur_freq 2>/dev/null", szOutput);
-   return atoi(szOutput)/1000;
+   int iFreqKhz = 0;
+   hw_sys_read_int("/sys/devices/system/cpu/cpufreq/policy0/cpuinfo_cur_freq", &iFreqKhz);
+   return iFreqKhz/1000;
    #endif
 
    #if defined(HW_PLATFORM_OPENIPC_CAMERA)
-   char szOutput[1024];
-   hw_execute_bash_command_raw_silent("cat /sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_cur_freq 2>/dev/null", szOutput);
-   int iFreqMhz = atoi(szOutput)/1000;
-   if ( access("/sys/devices/system/cpu/cpu1/cpufreq/cpuinfo_cur_freq", R_OK) != -1 )
+   int iFreqKhz = 0;
+   hw_sys_read_int("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_cur_freq", &iFreqKhz);
+   int iFreqMhz = iFreqKhz/1000;
+   iFreqKhz = 0;
+   if ( hw_sys_read_int("/sys/devices/system/cpu/cpu1/cpufreq/cpuinfo_cur_freq", &iFreqKhz) )
    {
-      hw_execute_bash_command_raw_silent("cat /sys/devices/system/cpu/cpu1/cpufreq/cpuinfo_cur_freq 2>/dev/null", szOutput);
-      int iFreqMhz1 = atoi(szOutput)/1000;
+      int iFreqMhz1 = iFreqKhz/1000;
       if ( iFreqMhz1 > 10 )
       if ( iFreqMhz1 < iFreqMhz )
          iFreqMhz = iFreqMhz1;
@@ -1982,9 +2017,9 @@ int hardware_get_gpu_speed()
    }
    return atoi(p);
    #elif defined(HW_PLATFORM_RADXA)
-   char szOutput[1024];
-   hw_execute_bash_command_raw_silent("cat /sys/devices/system/cpu/cpufreq/policy0/cpuinfo_cur_freq 2>/dev/null", szOutput);
-   return atoi(szOutput)/1000;
+   int iFreqKhz = 0;
+   hw_sys_read_int("/sys/devices/system/cpu/cpufreq/policy0/cpuinfo_cur_freq", &iFreqKhz);
+   return iFreqKhz/1000;
    #else
    return 1000;
    #endif
@@ -2043,11 +2078,11 @@ void hardware_set_oipc_freq_boost(int iFreqCPUMhz, int iGPUBoost)
    #if defined (HW_PLATFORM_OPENIPC_CAMERA)
    if ( hardware_board_is_sigmastar(hardware_getBoardType()) )
    {
-      hw_execute_bash_command_raw("echo 'performance' | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_governor", NULL);
-      char szComm[256];
-      sprintf(szComm, "echo %d | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_max_freq", iFreqCPUMhz*1000);
-      hw_execute_bash_command_raw(szComm, NULL);
-      hw_execute_bash_command_raw("echo 700000 | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_min_freq", NULL);
+      hw_sys_write_cpufreq_all("scaling_governor", "performance");
+      char szFreq[32];
+      sprintf(szFreq, "%d", iFreqCPUMhz*1000);
+      hw_sys_write_cpufreq_all("scaling_max_freq", szFreq);
+      hw_sys_write_cpufreq_all("scaling_min_freq", "700000");
    
       hardware_set_oipc_gpu_boost(iGPUBoost);
    }
@@ -2061,18 +2096,18 @@ void hardware_set_oipc_gpu_boost(int iGPUBoost)
    {
       if ( 0 == iGPUBoost )
       {
-         hw_execute_bash_command_raw("echo 384000000 > /sys/venc/ven_clock", NULL);
-         hw_execute_bash_command_raw("echo 320000000 > /sys/venc/ven_clock_2nd", NULL);
+         hw_sys_write_file("/sys/venc/ven_clock", "384000000");
+         hw_sys_write_file("/sys/venc/ven_clock_2nd", "320000000");
       }
       else if ( 1 == iGPUBoost )
       {
-         hw_execute_bash_command_raw("echo 432000000 > /sys/venc/ven_clock", NULL);
-         hw_execute_bash_command_raw("echo 336000000 > /sys/venc/ven_clock_2nd", NULL);
+         hw_sys_write_file("/sys/venc/ven_clock", "432000000");
+         hw_sys_write_file("/sys/venc/ven_clock_2nd", "336000000");
       }
       else if ( 2 == iGPUBoost )
       {
-         hw_execute_bash_command_raw("echo 480000000 > /sys/venc/ven_clock", NULL);
-         hw_execute_bash_command_raw("echo 348000000 > /sys/venc/ven_clock_2nd", NULL);
+         hw_sys_write_file("/sys/venc/ven_clock", "480000000");
+         hw_sys_write_file("/sys/venc/ven_clock_2nd", "348000000");
       }
       else
       {
@@ -2097,15 +2132,15 @@ void hardware_set_oipc_gpu_boost(int iGPUBoost)
          }
          if ( iFreq1 > 0 )
          {
-            char szComm[256];
-            sprintf(szComm, "echo %d > /sys/venc/ven_clock", iFreq1*1000*1000);
-            hw_execute_bash_command_raw(szComm, NULL);
+            char szFreq[32];
+            sprintf(szFreq, "%d", iFreq1*1000*1000);
+            hw_sys_write_file("/sys/venc/ven_clock", szFreq);
          }
          if ( iFreq2 > 0 )
          {
-            char szComm[256];
-            sprintf(szComm, "echo %d > /sys/venc/ven_clock_2nd", iFreq2*1000*1000);
-            hw_execute_bash_command_raw(szComm, NULL);
+            char szFreq[32];
+            sprintf(szFreq, "%d", iFreq2*1000*1000);
+            hw_sys_write_file("/sys/venc/ven_clock_2nd", szFreq);
          }
       }
    }
@@ -2117,13 +2152,18 @@ void _hardware_set_int_affinity_core(const char* szIntName, int iCoreIndex)
    if ( (NULL == szIntName) || (0 == szIntName[0]) || (iCoreIndex < 0) )
       return;
 
-   char szComm[256];
-   char szOutput[256];
-   for( int i=0; i<6; i++ )
+   FILE* fd = fopen("/proc/interrupts", "r");
+   if ( NULL == fd )
+      return;
+
+   char szOutput[512];
+   int iCountMatches = 0;
+   while ( (iCountMatches < 6) && (NULL != fgets(szOutput, sizeof(szOutput)/sizeof(szOutput[0]), fd)) )
    {
-      szOutput[0] = 0;
-      sprintf(szComm, "cat /proc/interrupts | grep -m 6 %s | sed -n %dp", szIntName, i+1);
-      hw_execute_bash_command(szComm, szOutput);
+      if ( NULL == strstr(szOutput, szIntName) )
+         continue;
+      iCountMatches++;
+      removeTrailingNewLines(szOutput);
       int iLen = (int)strlen(szOutput);
       if ( 0 == iLen )
          break;
@@ -2147,38 +2187,20 @@ void _hardware_set_int_affinity_core(const char* szIntName, int iCoreIndex)
          continue;
       }
 
-      sprintf(szComm, "echo %d > /proc/irq/%d/smp_affinity", iCoreIndex+1, iIntNumber);
-      hw_execute_bash_command(szComm, NULL);
+      char szFile[64];
+      char szMask[16];
+      sprintf(szFile, "/proc/irq/%d/smp_affinity", iIntNumber);
+      sprintf(szMask, "%d", iCoreIndex+1);
+      hw_sys_write_file(szFile, szMask);
    }
+   fclose(fd);
 }
 
 void hardware_balance_interupts()
 {
    #if defined (HW_PLATFORM_OPENIPC_CAMERA)
-   char szOutput[128];
-   hw_execute_bash_command_raw("nproc --all", szOutput);
-   removeTrailingNewLines(szOutput);
-   log_line("[Hardware] CPU cores: (%s)", szOutput);
-   strcat(szOutput, "\n");
-   int iCPUCoresCount = 1;
-   if ( (1 != sscanf(szOutput, "%d", &iCPUCoresCount)) || (1 == iCPUCoresCount) )
-   {
-      iCPUCoresCount = 1;
-      szOutput[0] = 0;
-      hw_execute_bash_command_raw("cat /proc/cpuinfo | grep processor | grep 0", szOutput);
-      removeTrailingNewLines(szOutput);
-      log_line("[Hardware] procinfo: (%s)", szOutput);
-      if ( strlen(szOutput) > 8 )
-      {
-         szOutput[0] = 0;
-         hw_execute_bash_command_raw("cat /proc/cpuinfo | grep processor | grep 1", szOutput);
-         removeTrailingNewLines(szOutput);
-         log_line("[Hardware] procinfo: (%s)", szOutput);
-         if ( strlen(szOutput) > 8 )
-         if ( NULL != strstr(szOutput, "1") )
-            iCPUCoresCount = 2;
-      }
-   }
+   int iCPUCoresCount = hw_sys_get_cpu_cores_count();
+   log_line("[Hardware] CPU cores: %d", iCPUCoresCount);
 
    if ( iCPUCoresCount > 1 )
    {
@@ -50,7 +50,9 @@
 #include "hardware_radio.h"
 #include "hardware_serial.h"
 #include "hardware_radio_sik.h"
+#include "hardware_radio_sim.h"
 #include "hw_procs.h"
+#include "hw_sys.h"
 #include "../common/string_utils.h"
 
 #define MAX_USB_DEVICES_INFO 24
@@ -144,6 +146,12 @@ void hardware_radio_remove_stored_config()
 
 void hardware_save_radio_info()
 {
+   // Simulated radios must not replace the stored config of the real radio hardware
+   if ( hardware_radio_sim_is_enabled() )
+   {
+      log_line("[HardwareRadio] Using simulated radios. Do not save hardware radio config.");
+      return;
+   }
    char szFile[MAX_FILE_PATH_SIZE];
    strcpy(szFile, FOLDER_CONFIG);
    strcat(szFile, FILE_CONFIG_CURRENT_RADIO_HW_CONFIG);
@@ -400,7 +408,7 @@ void _hardware_assign_usb_from_physical_ports()
 
    DIR *d;
    struct dirent *dir;
-   char szComm[256];
+   char szFile[MAX_FILE_PATH_SIZE];
    char szOutput[1024];
 
    d = opendir("/sys/bus/usb/devices/");
@@ -418,9 +426,8 @@ void _hardware_assign_usb_from_physical_ports()
 
       log_line("[HardwareRadio] Quering USB device path: [%s]...", dir->d_name);
 
-      snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "cat /sys/bus/usb/devices/%s/uevent 2>/dev/null | grep DRIVER", dir->d_name);
-      szOutput[0] = 0;
-      hw_execute_bash_command_silent(szComm, szOutput);
+      snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "/sys/bus/usb/devices/%s/uevent", dir->d_name);
+      hw_sys_grep_file(szFile, "DRIVER", szOutput, sizeof(szOutput)/sizeof(szOutput[0]));
       if ( 0 == szOutput[0] )
       {
          log_line("[HardwareRadio] No info for USB device: [%s]. Skipping it.", dir->d_name);
@@ -428,16 +435,11 @@ void _hardware_assign_usb_from_physical_ports()
       }
       for( int i=0; i<s_iHwRadiosCount; i++ )
       {
-         szOutput[0] = 0;
-         snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "cat /sys/bus/usb/devices/%s/net/%s/uevent 2>/dev/null | grep DEVTYPE=wlan", dir->d_name, sRadioInfo[i].szName);
-         hw_execute_bash_command_silent(szComm, szOutput);
-         if ( 0 == szOutput[0] )
+         snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "/sys/bus/usb/devices/%s/net/%s/uevent", dir->d_name, sRadioInfo[i].szName);
+         if ( ! hw_sys_grep_file(szFile, "DEVTYPE=wlan", szOutput, sizeof(szOutput)/sizeof(szOutput[0])) )
             continue;
 
-         szOutput[0] = 0;
-         snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "cat /sys/bus/usb/devices/%s/net/%s/uevent 2>/dev/null | grep INTERFACE", dir->d_name, sRadioInfo[i].szName);
-         hw_execute_bash_command_silent(szComm, szOutput);
-         if ( 0 == szOutput[0] )
+         if ( ! hw_sys_grep_file(szFile, "INTERFACE", szOutput, sizeof(szOutput)/sizeof(szOutput[0])) )
             continue;
 
          int iPos = 0;
@@ -469,10 +471,8 @@ void _hardware_assign_usb_from_physical_ports()
 
          // Find the product id / vendor id
 
-         szOutput[0] = 0;
-         snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "cat /sys/bus/usb/devices/%s/uevent 2>/dev/null | grep PRODUCT", dir->d_name);
-         hw_execute_bash_command_silent(szComm, szOutput);
-         if ( 0 != szOutput[0] )
+         snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "/sys/bus/usb/devices/%s/uevent", dir->d_name);
+         if ( hw_sys_grep_file(szFile, "PRODUCT", szOutput, sizeof(szOutput)/sizeof(szOutput[0])) )
          {
             iLen = strlen(szOutput);
             int iPosOut = 0;
@@ -864,8 +864,13 @@ int _hardware_enumerate_wifi_radios()
       sprintf(szComm, "ls -Al /sys/class/net/%s/device/ | grep driver", sRadioInfo[i].szName);
       hw_execute_bash_command_raw(szComm, szDriver);
       #else
-      sprintf(szComm, "cat /sys/class/net/%s/device/uevent | nice grep DRIVER | sed 's/DRIVER=//'", sRadioInfo[i].szName);
-      hw_execute_bash_command(szComm, szDriver);
+      char szUEventFile[MAX_FILE_PATH_SIZE];
+      snprintf(szUEventFile, sizeof(szUEventFile)/sizeof(szUEventFile[0]), "/sys/class/net/%s/device/uevent", sRadioInfo[i].szName);
+      if ( hw_sys_grep_file(szUEventFile, "DRIVER=", szComm, sizeof(szComm)/sizeof(szComm[0])) )
+      {
+         strncpy(szDriver, strstr(szComm, "DRIVER=") + 7, sizeof(szDriver)/sizeof(szDriver[0])-1);
+         szDriver[sizeof(szDriver)/sizeof(szDriver[0])-1] = 0;
+      }
       #endif
       removeTrailingNewLines(szDriver);
 
@@ -1098,6 +1103,21 @@ int hardware_enumerate_radio_interfaces()
    return hardware_enumerate_radio_interfaces_step(-1);
 }
 
+static int _hardware_enumerate_simulated_radios()
+{
+   t_radio_sim_config* pConfig = hardware_radio_sim_get_config();
+   s_iHwRadiosCount = 0;
+   s_iHwRadiosSupportedCount = 0;
+   for( int i=0; i<pConfig->iInterfacesCount; i++ )
+   {
+      hardware_radio_sim_fill_radio_info(i, &sRadioInfo[s_iHwRadiosCount]);
+      s_iHwRadiosCount++;
+      s_iHwRadiosSupportedCount++;
+   }
+   log_line("[HardwareRadio] Using %d simulated radio interfaces instead of the radio hardware.", s_iHwRadiosCount);
+   return s_iHwRadiosCount;
+}
+
 int hardware_enumerate_radio_interfaces_step(int iStep)
 {
    if ( s_HardwareRadiosEnumeratedOnce && ((iStep == -1) || (iStep == 0)) )
@@ -1106,6 +1126,17 @@ int hardware_enumerate_radio_interfaces_step(int iStep)
    log_line("=================================================================");
    log_line("[HardwareRadio] Enumerating radios (step %d)...", iStep);
 
+   if ( hardware_radio_sim_is_enabled() )
+   {
+      if ( (iStep == -1) || (iStep == 0) )
+         _hardware_enumerate_simulated_radios();
+      s_HardwareRadiosEnumeratedOnce = 1;
+      if ( (iStep == -1) || (iStep == 1) )
+         hardware_log_radio_info(&sRadioInfo[0], s_iHwRadiosCount);
+      log_line("=================================================================");
+      return (s_iHwRadiosCount > 0)?1:0;
+   }
+
    if( (iStep == -1) || (iStep == 0) )
    {
       char szFile[MAX_FILE_PATH_SIZE];
@@ -1918,6 +1949,16 @@ int hardware_initialize_radio_interface(int iInterfaceIndex, u32 uDelayMS)
 
    log_line("[HardwareRadio] Initialize radio interface %d: %s, (%s)", iInterfaceIndex+1, pRadioHWInfo->szName, pRadioHWInfo->szDriver);
 
+   if ( hardware_radio_is_simulated_radio(pRadioHWInfo) )
+   {
+      pRadioHWInfo->iCurrentDataRateBPS = 0;
+      pRadioHWInfo->uCurrentFrequencyKhz = 0;
+      pRadioHWInfo->lastFrequencySetFailed = 1;
+      pRadioHWInfo->uFailedFrequencyKhz = DEFAULT_FREQUENCY;
+      log_line("[HardwareRadio] Initialized simulated radio interface %d: %s", iInterfaceIndex+1, pRadioHWInfo->szName);
+      return 1;
+   }
+
    sprintf(szComm, "ip link set dev %s down", pRadioHWInfo->szName );
 
    pRadioHWInfo->iCurrentDataRateBPS = 0;
@@ -2180,7 +2221,8 @@ int hardware_radio_type_is_ieee(int iRadioType)
    if ( iRadioType == RADIO_TYPE_RALINK ||
         iRadioType == RADIO_TYPE_ATHEROS ||
         iRadioType == RADIO_TYPE_REALTEK ||
-        iRadioType == RADIO_TYPE_MEDIATEK )
+        iRadioType == RADIO_TYPE_MEDIATEK ||
+        iRadioType == RADIO_TYPE_SIMULATED )
       return 1;
 
    return 0;
@@ -2276,6 +2318,26 @@ int hardware_radio_is_sik_radio(radio_hw_info_t* pRadioInfo)
    return 0;
 }
 
+int hardware_radio_index_is_simulated_radio(int iHWInterfaceIndex)
+{
+   radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(iHWInterfaceIndex);
+   if ( NULL == pRadioHWInfo )
+      return 0;
+     
+   return hardware_radio_is_simulated_radio(pRadioHWInfo);
+}
+
+int hardware_radio_is_simulated_radio(radio_hw_info_t* pRadioInfo)
+{
+   if ( NULL == pRadioInfo )
+      return 0;
+
+   if ( pRadioInfo->iRadioType == RADIO_TYPE_SIMULATED )
+      return 1;
+
+   return 0;
+}
+
 int hardware_radioindex_supports_frequency(int iRadioIndex, u32 freqKhz)
 {
    if ( ! s_HardwareRadiosEnumeratedOnce )
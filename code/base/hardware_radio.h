@@ -13,6 +13,7 @@
 #define RADIO_TYPE_MEDIATEK 4
 #define RADIO_TYPE_SIK 5
 #define RADIO_TYPE_SERIAL 6
+#define RADIO_TYPE_SIMULATED 7
 
 #define RADIO_HW_DRIVER_ATHEROS 1       // ath9k_htc
 #define RADIO_HW_DRIVER_RALINK 2        // rt2800usb, only 2.4Ghz band
@@ -25,6 +26,7 @@
 #define RADIO_HW_DRIVER_SERIAL 9
 #define RADIO_HW_DRIVER_REALTEK_8812EU 10          // 88x2eu
 #define RADIO_HW_DRIVER_REALTEK_8733BU 15          // 88733bu
+#define RADIO_HW_DRIVER_SIMULATED 16               // loopback radio, see hardware_radio_sim.h
 
 
 // 0 is generic card model
@@ -75,6 +77,7 @@
 #define RADIO_HW_CAPABILITY_FLAG_SERIAL_LINK_ELRS ((u32)(((u32)0x01)<<12))
 #define RADIO_HW_CAPABILITY_FLAG_HAS_BOOSTER_2W ((u32)(((u32)0x01)<<13))
 #define RADIO_HW_CAPABILITY_FLAG_HAS_BOOSTER_4W ((u32)(((u32)0x01)<<14))
+#define RADIO_HW_CAPABILITY_FLAG_NO_TX_BATCHING ((u32)(((u32)0x01)<<15)) // radio interfaces only
 
 #define RADIO_HW_EXTRA_FLAG_FIRMWARE_OLD ((u32)(((u32)0x01)))
 
@@ -222,11 +225,13 @@ int hardware_radio_is_wifi_radio(radio_hw_info_t* pRadioInfo);
 int hardware_radio_is_serial_radio(radio_hw_info_t* pRadioInfo);
 int hardware_radio_is_elrs_radio(radio_hw_info_t* pRadioInfo);
 int hardware_radio_is_sik_radio(radio_hw_info_t* pRadioInfo);
+int hardware_radio_is_simulated_radio(radio_hw_info_t* pRadioInfo);
 int hardware_radio_index_is_high_capacity(int iRadioIndex);
 int hardware_radio_index_is_wifi_radio(int iRadioIndex);
 int hardware_radio_index_is_serial_radio(int iHWInterfaceIndex);
 int hardware_radio_index_is_elrs_radio(int iHWInterfaceIndex);
 int hardware_radio_index_is_sik_radio(int iHWInterfaceIndex);
+int hardware_radio_index_is_simulated_radio(int iHWInterfaceIndex);
 
 int hardware_radioindex_supports_frequency(int iRadioIndex, u32 freqKhz);
 int hardware_radio_supports_frequency(radio_hw_info_t* pRadioInfo, u32 freqKhz);
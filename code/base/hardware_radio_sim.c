@@ -0,0 +1,248 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <ctype.h>
+#include "../base/base.h"
+#include "../base/config.h"
+#include "hardware.h"
+#include "hardware_radio.h"
+#include "hardware_radio_sim.h"
+
+static t_radio_sim_config s_RadioSimConfig;
+static int s_iRadioSimConfigLoaded = 0;
+
+static void _hardware_radio_sim_set_defaults(t_radio_sim_config* pConfig)
+{
+   memset(pConfig, 0, sizeof(t_radio_sim_config));
+   pConfig->szNode[0] = 0;
+   pConfig->szPeer[0] = 0;
+   strcpy(pConfig->szFolder, "/tmp");
+   pConfig->iInterfacesCount = 1;
+   pConfig->fGELossBad = 1.0;
+   pConfig->uMaxQueueMs = 200;
+   pConfig->iRSSIGood = -50;
+   pConfig->iRSSIBad = -82;
+   pConfig->iNoise = -95;
+}
+
+static void _hardware_radio_sim_copy_name(char* szDest, int iMaxLength, const char* szValue)
+{
+   strncpy(szDest, szValue, iMaxLength-1);
+   szDest[iMaxLength-1] = 0;
+   for( int i=0; szDest[i] != 0; i++ )
+   {
+      if ( (! isalnum(szDest[i])) && (szDest[i] != '_') && (szDest[i] != '-') && (szDest[i] != '/') && (szDest[i] != '.') )
+         szDest[i] = '_';
+   }
+}
+
+static float _hardware_radio_sim_clamp_probability(float fValue)
+{
+   if ( fValue < 0.0 )
+      return 0.0;
+   if ( fValue > 1.0 )
+      return 1.0;
+   return fValue;
+}
+
+// Returns 1 if the config is valid
+
+int hardware_radio_sim_parse_config(const char* szConfig, t_radio_sim_config* pConfig)
+{
+   if ( NULL == pConfig )
+      return 0;
+   _hardware_radio_sim_set_defaults(pConfig);
+   if ( (NULL == szConfig) || (0 == szConfig[0]) )
+      return 0;
+
+   char szBuff[512];
+   strncpy(szBuff, szConfig, sizeof(szBuff)-1);
+   szBuff[sizeof(szBuff)-1] = 0;
+
+   char* pSavePtr = NULL;
+   char* szToken = strtok_r(szBuff, ",; ", &pSavePtr);
+   while ( NULL != szToken )
+   {
+      char* szValue = strchr(szToken, '=');
+      if ( NULL == szValue )
+      {
+         log_softerror_and_alarm("[HardwareRadioSim] Invalid config token [%s], expected key=value.", szToken);
+         szToken = strtok_r(NULL, ",; ", &pSavePtr);
+         continue;
+      }
+      *szValue = 0;
+      szValue++;
+
+      if ( 0 == strcmp(szToken, "node") )
+         _hardware_radio_sim_copy_name(pConfig->szNode, sizeof(pConfig->szNode), szValue);
+      else if ( 0 == strcmp(szToken, "peer") )
+         _hardware_radio_sim_copy_name(pConfig->szPeer, sizeof(pConfig->szPeer), szValue);
+      else if ( 0 == strcmp(szToken, "dir") )
+         _hardware_radio_sim_copy_name(pConfig->szFolder, sizeof(pConfig->szFolder), szValue);
+      else if ( 0 == strcmp(szToken, "count") )
+         pConfig->iInterfacesCount = atoi(szValue);
+      else if ( 0 == strcmp(szToken, "loss") )
+         pConfig->fLoss = _hardware_radio_sim_clamp_probability(atof(szValue));
+      else if ( 0 == strcmp(szToken, "ge_p") )
+         pConfig->fGEProbGoodToBad = _hardware_radio_sim_clamp_probability(atof(szValue));
+      else if ( 0 == strcmp(szToken, "ge_r") )
+         pConfig->fGEProbBadToGood = _hardware_radio_sim_clamp_probability(atof(szValue));
+      else if ( 0 == strcmp(szToken, "ge_loss") )
+         pConfig->fGELossBad = _hardware_radio_sim_clamp_probability(atof(szValue));
+      else if ( 0 == strcmp(szToken, "latency") )
+         pConfig->uLatencyMs = (u32)atoi(szValue);
+      else if ( 0 == strcmp(szToken, "jitter") )
+         pConfig->uJitterMs = (u32)atoi(szValue);
+      else if ( 0 == strcmp(szToken, "rate") )
+         pConfig->uRateKbps = (u32)atoi(szValue);
+      else if ( 0 == strcmp(szToken, "queue") )
+         pConfig->uMaxQueueMs = (u32)atoi(szValue);
+      else if ( 0 == strcmp(szToken, "rssi") )
+         pConfig->iRSSIGood = atoi(szValue);
+      else if ( 0 == strcmp(szToken, "rssi_bad") )
+         pConfig->iRSSIBad = atoi(szValue);
+      else if ( 0 == strcmp(szToken, "noise") )
+         pConfig->iNoise = atoi(szValue);
+      else if ( 0 == strcmp(szToken, "seed") )
+         pConfig->uSeed = (u32)strtoul(szValue, NULL, 10);
+      else
+         log_softerror_and_alarm("[HardwareRadioSim] Unknown config key [%s]", szToken);
+
+      szToken = strtok_r(NULL, ",; ", &pSavePtr);
+   }
+
+   if ( pConfig->iInterfacesCount < 1 )
+      pConfig->iInterfacesCount = 1;
+   if ( pConfig->iInterfacesCount > MAX_RADIO_INTERFACES )
+      pConfig->iInterfacesCount = MAX_RADIO_INTERFACES;
+   if ( pConfig->uMaxQueueMs < 5 )
+      pConfig->uMaxQueueMs = 5;
+   if ( pConfig->uLatencyMs > 10000 )
+      pConfig->uLatencyMs = 10000;
+   if ( pConfig->uJitterMs > 10000 )
+      pConfig->uJitterMs = 10000;
+
+   if ( 0 == pConfig->szNode[0] )
+      strcpy(pConfig->szNode, hardware_is_vehicle()?"vehicle":"station");
+   if ( 0 == pConfig->szPeer[0] )
+      strcpy(pConfig->szPeer, (0 == strcmp(pConfig->szNode, "vehicle"))?"station":"vehicle");
+
+   if ( 0 == strcmp(pConfig->szNode, pConfig->szPeer) )
+   {
+      log_softerror_and_alarm("[HardwareRadioSim] Node and peer can't have the same name (%s).", pConfig->szNode);
+      return 0;
+   }
+   pConfig->iEnabled = 1;
+   return 1;
+}
+
+t_radio_sim_config* hardware_radio_sim_get_config()
+{
+   if ( s_iRadioSimConfigLoaded )
+      return &s_RadioSimConfig;
+
+   s_iRadioSimConfigLoaded = 1;
+   const char* szConfig = getenv(RADIO_SIM_ENV_VAR);
+   if ( (NULL == szConfig) || (0 == szConfig[0]) )
+   {
+      _hardware_radio_sim_set_defaults(&s_RadioSimConfig);
+      return &s_RadioSimConfig;
+   }
+   if ( ! hardware_radio_sim_parse_config(szConfig, &s_RadioSimConfig) )
+   {
+      log_softerror_and_alarm("[HardwareRadioSim] Invalid simulated radio config: [%s]. Simulated radios are disabled.", szConfig);
+      s_RadioSimConfig.iEnabled = 0;
+      return &s_RadioSimConfig;
+   }
+
+   log_line("[HardwareRadioSim] Simulated radios enabled: node [%s], peer [%s], %d interfaces, sockets in %s",
+      s_RadioSimConfig.szNode, s_RadioSimConfig.szPeer, s_RadioSimConfig.iInterfacesCount, s_RadioSimConfig.szFolder);
+   log_line("[HardwareRadioSim] Tx impairments: loss %.3f, Gilbert-Elliott p/r/loss: %.3f/%.3f/%.3f, latency %u ms, jitter %u ms, rate %u kbps (max queue %u ms), rssi %d/%d dBm, noise %d dBm",
+      s_RadioSimConfig.fLoss, s_RadioSimConfig.fGEProbGoodToBad, s_RadioSimConfig.fGEProbBadToGood, s_RadioSimConfig.fGELossBad,
+      s_RadioSimConfig.uLatencyMs, s_RadioSimConfig.uJitterMs, s_RadioSimConfig.uRateKbps, s_RadioSimConfig.uMaxQueueMs,
+      s_RadioSimConfig.iRSSIGood, s_RadioSimConfig.iRSSIBad, s_RadioSimConfig.iNoise);
+   return &s_RadioSimConfig;
+}
+
+int hardware_radio_sim_is_enabled()
+{
+   return hardware_radio_sim_get_config()->iEnabled;
+}
+
+void hardware_radio_sim_get_socket_path(const char* szNode, int iIndex, char* szOutPath)
+{
+   if ( NULL == szOutPath )
+      return;
+   t_radio_sim_config* pConfig = hardware_radio_sim_get_config();
+   snprintf(szOutPath, MAX_FILE_PATH_SIZE, "%s/ruby_radio_sim_%s_%d", pConfig->szFolder, (NULL != szNode)?szNode:"", iIndex);
+}
+
+void hardware_radio_sim_fill_radio_info(int iIndex, radio_hw_info_t* pRadioInfo)
+{
+   if ( NULL == pRadioInfo )
+      return;
+
+   memset(pRadioInfo, 0, sizeof(radio_hw_info_t));
+   pRadioInfo->phy_index = iIndex;
+   pRadioInfo->iCardModel = 0;
+   pRadioInfo->isSupported = 1;
+   pRadioInfo->isEnabled = 1;
+   pRadioInfo->supportedBands = RADIO_HW_SUPPORTED_BAND_23 | RADIO_HW_SUPPORTED_BAND_24 | RADIO_HW_SUPPORTED_BAND_25 | RADIO_HW_SUPPORTED_BAND_58;
+   pRadioInfo->isHighCapacityInterface = 1;
+   pRadioInfo->isSerialRadio = 0;
+   pRadioInfo->isConfigurable = 1;
+   pRadioInfo->isTxCapable = 1;
+   pRadioInfo->uCurrentFrequencyKhz = 0;
+   pRadioInfo->lastFrequencySetFailed = 0;
+   sprintf(pRadioInfo->szName, "sim%d", iIndex);
+   strcpy(pRadioInfo->szDescription, "Simulated");
+   strcpy(pRadioInfo->szDriver, "radio_sim");
+   // Locally administered MAC, unique per node name and interface
+   u32 uHash = 5381;
+   const char* szNode = hardware_radio_sim_get_config()->szNode;
+   for( int i=0; szNode[i] != 0; i++ )
+      uHash = uHash * 33 + (u8)szNode[i];
+   sprintf(pRadioInfo->szMAC, "02:52:%02X:%02X:%02X:%02X", (uHash >> 16) & 0xFF, (uHash >> 8) & 0xFF, uHash & 0xFF, iIndex & 0xFF);
+   strcpy(pRadioInfo->szProductId, "sim");
+   snprintf(pRadioInfo->szUSBPort, sizeof(pRadioInfo->szUSBPort), "S%d", (iIndex+1) % 100);
+   pRadioInfo->iRadioType = RADIO_TYPE_SIMULATED;
+   pRadioInfo->iRadioDriver = RADIO_HW_DRIVER_SIMULATED;
+   pRadioInfo->openedForRead = 0;
+   pRadioInfo->openedForWrite = 0;
+
+   reset_runtime_radio_rx_info(&pRadioInfo->runtimeInterfaceInfoRx.radioHwRxInfo);
+   pRadioInfo->runtimeInterfaceInfoRx.ppcap = NULL;
+   pRadioInfo->runtimeInterfaceInfoRx.selectable_fd = -1;
+   reset_runtime_radio_rx_info(&pRadioInfo->runtimeInterfaceInfoTx.radioHwRxInfo);
+   pRadioInfo->runtimeInterfaceInfoTx.ppcap = NULL;
+   pRadioInfo->runtimeInterfaceInfoTx.selectable_fd = -1;
+}
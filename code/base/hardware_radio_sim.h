@@ -0,0 +1,65 @@
+#pragma once
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware_radio.h"
+
+// Simulated (loopback) radio interfaces, used to run the vehicle and the controller
+// back to back on a single Linux host, without any radio hardware.
+// They are enabled by the RUBY_RADIO_SIM environment variable, a comma separated list of key=value:
+//    node=<name>     name of this end of the link (default: vehicle or station)
+//    peer=<name>     name of the other end of the link (default: station or vehicle)
+//    count=<n>       number of simulated radio interfaces (default 1)
+//    dir=<path>      folder for the unix sockets (default /tmp)
+//    loss=<f>        iid loss probability in good state, 0..1
+//    ge_p=<f>        Gilbert-Elliott probability of going from good to bad state, per frame
+//    ge_r=<f>        Gilbert-Elliott probability of going from bad to good state, per frame
+//    ge_loss=<f>     loss probability while in bad state (default 1)
+//    latency=<ms>    fixed one way latency
+//    jitter=<ms>     random extra latency, 0..jitter
+//    rate=<kbps>     air bandwidth cap, 0 for no cap
+//    queue=<ms>      max time a frame can wait for the bandwidth cap before it's dropped (default 200)
+//    rssi=<dBm>      synthetic rx signal level in good state (default -50)
+//    rssi_bad=<dBm>  synthetic rx signal level in bad state (default -82)
+//    noise=<dBm>     synthetic rx noise level (default -95)
+//    seed=<n>        random seed, 0 for a time based one
+// All impairments apply to the frames sent by this node; each end configures its own tx direction.
+
+#define RADIO_SIM_ENV_VAR "RUBY_RADIO_SIM"
+#define RADIO_SIM_MAX_NODE_NAME 32
+
+typedef struct
+{
+   int iEnabled;
+   char szNode[RADIO_SIM_MAX_NODE_NAME];
+   char szPeer[RADIO_SIM_MAX_NODE_NAME];
+   char szFolder[MAX_FILE_PATH_SIZE];
+   int iInterfacesCount;
+   float fLoss;
+   float fGEProbGoodToBad;
+   float fGEProbBadToGood;
+   float fGELossBad;
+   u32 uLatencyMs;
+   u32 uJitterMs;
+   u32 uRateKbps;
+   u32 uMaxQueueMs;
+   int iRSSIGood;
+   int iRSSIBad;
+   int iNoise;
+   u32 uSeed;
+} ALIGN_STRUCT_SPEC_INFO t_radio_sim_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int hardware_radio_sim_is_enabled();
+t_radio_sim_config* hardware_radio_sim_get_config();
+int hardware_radio_sim_parse_config(const char* szConfig, t_radio_sim_config* pConfig);
+
+// Fills in the radio hardware info for simulated radio interface iIndex (0 based)
+void hardware_radio_sim_fill_radio_info(int iIndex, radio_hw_info_t* pRadioInfo);
+void hardware_radio_sim_get_socket_path(const char* szNode, int iIndex, char* szOutPath);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,47 +1,36 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // for pthread_setaffinity_np
+#endif
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/resource.h>
+#include <signal.h>
 #include <ctype.h>
 #include <pthread.h>
 
 #include "base.h"
 #include "config.h"
 #include "hw_procs.h"
+#include "hw_sys.h"
 #include "hardware.h"
 
+// Max PIDs returned as text by hw_process_get_pids, so that callers' buffers (128 bytes or more) do not overflow
+#define HW_PROCS_MAX_PIDS_TEXT 12
+
 int hw_process_exists(const char* szProcName)
 {
    if ( (NULL == szProcName) || (0 == szProcName[0]) )
       return 0;
-   char szPids[256];
-   hw_process_get_pids(szProcName, szPids);
-   removeTrailingNewLines(szPids);
-   char* p = removeLeadingWhiteSpace(szPids);
-
-   if ( strlen(p) < 3 )
-   {
-      log_line("Process (%s) is not running.", szProcName);
-      return 0;
-   }
-   if ( ! isdigit(*p) )
-   {
-      log_line("Process (%s) is not running.", szProcName);
-      return 0;
-   }
 
-   int iPID = 0;
-   if ( 1 != sscanf(p, "%d", &iPID) )
-   {
-      log_line("Process (%s) is not running.", szProcName);
-      return 0;
-   }
-   if ( iPID < 100 )
+   int iPIDs[HW_SYS_MAX_PIDS];
+   int iCount = hw_sys_find_pids(szProcName, iPIDs, HW_SYS_MAX_PIDS);
+   if ( iCount <= 0 )
    {
       log_line("Process (%s) is not running.", szProcName);
       return 0;
    }
-   log_line("Process (%s) is running, PID: %d", szProcName, iPID);
-   return iPID;
+   log_line("Process (%s) is running, PID: %d", szProcName, iPIDs[0]);
+   return iPIDs[0];
 }
 
 char* hw_process_get_pids_inline(const char* szProcName)
@@ -51,6 +40,7 @@ char* hw_process_get_pids_inline(const char* szProcName)
    hw_process_get_pids(szProcName, s_szHWProcessPIDs);
    return s_szHWProcessPIDs;
 }
+
 void hw_process_get_pids(const char* szProcName, char* szOutput)
 {
    if ( NULL == szOutput )
@@ -61,116 +51,78 @@ void hw_process_get_pids(const char* szProcName, char* szOutput)
    if ( (NULL == szProcName) || (0 == szProcName[0]) )
       return;
 
-   char szComm[128];
-
-   log_line("Check existence of process (%s)...", szProcName);
-   sprintf(szComm, "pidof %s", szProcName);
-   hw_execute_bash_command_raw_silent(szComm, szOutput);
-   removeTrailingNewLines(szOutput);
-   log_line("Result of pidof: (%s)", szOutput);
-   char* p = removeLeadingWhiteSpace(szOutput);
-   if ( strlen(p) < 3 )
-   {
-      log_line("No result on pidof. Check using pgrep...");
-      sprintf(szComm, "pgrep %s", szProcName);
-      hw_execute_bash_command_raw_silent(szComm, szOutput);
-      removeTrailingNewLines(szOutput);
-      log_line("Result of pgrep: (%s)", szOutput);
-      p = removeLeadingWhiteSpace(szOutput);
-      if ( strlen(p) < 3 )
-      {
-         log_line("No results on pgrep. Check using ps...");
-         sprintf(szComm, "ps -ae | grep %s | grep -v \"grep\"", szProcName);
-         hw_execute_bash_command_raw_silent(szComm, szOutput);
-         removeTrailingNewLines(szOutput);
-         log_line("Result of ps search: (%s)", szOutput);
-         p = removeLeadingWhiteSpace(szOutput);
-      }
-   }
+   int iPIDs[HW_PROCS_MAX_PIDS_TEXT];
+   int iCount = hw_sys_find_pids(szProcName, iPIDs, HW_PROCS_MAX_PIDS_TEXT);
+   char* pOut = szOutput;
+   for( int i=0; i<iCount; i++ )
+      pOut += sprintf(pOut, (i == 0)?"%d":" %d", iPIDs[i]);
+   log_line("PIDs of process (%s): (%s)", szProcName, szOutput);
 }
 
 void hw_stop_process(const char* szProcName)
 {
-   char szComm[1024];
-   char szPIDs[512];
-
    if ( NULL == szProcName || 0 == szProcName[0] )
       return;
 
    log_line("Stopping process [%s]...", szProcName);
-   
-   hw_process_get_pids(szProcName, szPIDs);
-   removeTrailingNewLines(szPIDs);
-   replaceNewLinesToSpaces(szPIDs);
-   if ( strlen(szPIDs) > 2 )
-   {
-      log_line("Found PID(s) for process to stop %s: %s", szProcName, szPIDs);
-      sprintf(szComm, "kill %s 2>/dev/null", szPIDs);
-      hw_execute_bash_command(szComm, NULL);
-      int retryCount = 30;
-      while ( retryCount > 0 )
+
+   int iPIDs[HW_SYS_MAX_PIDS];
+   int iCount = hw_sys_find_pids(szProcName, iPIDs, HW_SYS_MAX_PIDS);
+   if ( iCount <= 0 )
+   {
+      log_line("Process [%s] does not exists.", szProcName);
+      return;
+   }
+
+   log_line("Found %d PID(s) for process to stop %s, first: %d", iCount, szProcName, iPIDs[0]);
+   hw_sys_signal_pids(iPIDs, iCount, SIGTERM);
+   int retryCount = 30;
+   while ( retryCount > 0 )
+   {
+      hardware_sleep_ms(10);
+      iCount = hw_sys_find_pids(szProcName, iPIDs, HW_SYS_MAX_PIDS);
+      if ( iCount <= 0 )
       {
-         hardware_sleep_ms(10);
-         szPIDs[0] = 0;
-         hw_process_get_pids(szProcName, szPIDs);
-         removeTrailingNewLines(szPIDs);
-         replaceNewLinesToSpaces(szPIDs);
-         if ( strlen(szPIDs) < 2 )
-         {
-            log_line("Did stopped process %s", szProcName);
-            return;
-         }
-         retryCount--;
+         log_line("Did stopped process %s", szProcName);
+         return;
       }
-      sprintf(szComm, "kill -9 %s 2>/dev/null", szPIDs);
-      hw_execute_bash_command(szComm, NULL);
-      hardware_sleep_ms(20);
+      retryCount--;
    }
-   else
-      log_line("Process [%s] does not exists.", szProcName);
+   hw_sys_signal_pids(iPIDs, iCount, SIGKILL);
+   hardware_sleep_ms(20);
 }
 
 
 int hw_kill_process(const char* szProcName, int iSignal)
 {
-   char szCommStop[512];
-   char szPIDs[256];
-
    if ( (NULL == szProcName) || (0 == szProcName[0]) )
       return -1;
 
-   hw_process_get_pids(szProcName, szPIDs);
-   removeTrailingNewLines(szPIDs);
-   replaceNewLinesToSpaces(szPIDs);
-   if ( strlen(szPIDs) < 3 )
+   int iPIDs[HW_SYS_MAX_PIDS];
+   int iCount = hw_sys_find_pids(szProcName, iPIDs, HW_SYS_MAX_PIDS);
+   if ( iCount <= 0 )
    {
       log_line("Process %s does not exist. Nothing to kill.", szProcName);
       return 0;
    }
-   sprintf(szCommStop, "kill %d %s 2>/dev/null", iSignal, szPIDs);
-   hw_execute_bash_command_raw(szCommStop, NULL);
+   hw_sys_signal_pids(iPIDs, iCount, iSignal);
    hardware_sleep_ms(20);
 
-   hw_process_get_pids(szProcName, szPIDs);
-   removeTrailingNewLines(szPIDs);
-   replaceNewLinesToSpaces(szPIDs);
-   if ( strlen(szPIDs) < 3 )
+   iCount = hw_sys_find_pids(szProcName, iPIDs, HW_SYS_MAX_PIDS);
+   if ( iCount <= 0 )
       return 1;
 
-   log_line("Process still exists, %s PIDs are: %s", szProcName, szPIDs);
+   log_line("Process still exists, %s has %d PIDs, first: %d", szProcName, iCount, iPIDs[0]);
 
    int retryCount = 5;
    while ( retryCount > 0 )
    {
       hardware_sleep_ms(10);
-      hw_execute_bash_command_raw(szCommStop, NULL);
-      szPIDs[0] = 0;
-      hw_process_get_pids(szProcName, szPIDs);
-      removeTrailingNewLines(szPIDs);
-      replaceNewLinesToSpaces(szPIDs);
-      if ( strlen(szPIDs) < 3 )
+      hw_sys_signal_pids(iPIDs, iCount, iSignal);
+      iCount = hw_sys_find_pids(szProcName, iPIDs, HW_SYS_MAX_PIDS);
+      if ( iCount <= 0 )
          return 1;
-      log_line("Process still exists (%d), %s PIDs are: %s", retryCount, szProcName, szPIDs);
+      log_line("Process still exists (%d), %s has %d PIDs, first: %d", retryCount, szProcName, iCount, iPIDs[0]);
       retryCount--;
    }
    return 0;
@@ -199,87 +151,24 @@ int hw_launch_process3(const char *szFile, const char* szParam1, const char* szP
 
 int hw_launch_process4(const char *szFile, const char* szParam1, const char* szParam2, const char* szParam3, const char* szParam4)
 {
-   // execv messes up the timer
+   if ( (NULL == szFile) || (0 == szFile[0]) )
+      return -1;
 
    char szBuff[1024];
-   if ( (NULL == szParam1) && (NULL == szParam2) && (NULL == szParam3) && (NULL == szParam4) )
-      sprintf(szBuff, "%s &", szFile);
-   else if ( (NULL != szParam1) && (NULL == szParam2) && (NULL == szParam3) && (NULL == szParam4) )
-      sprintf(szBuff, "%s %s &", szFile, szParam1);
-   else
-      sprintf(szBuff, "%s %s %s %s %s &", szFile, ((NULL != szParam1)?szParam1:""), ((NULL != szParam2)?szParam2:""), ((NULL != szParam3)?szParam3:""), ((NULL != szParam4)?szParam4:"") );
-   
-   hw_execute_bash_command(szBuff, NULL);
-   return 0;
-
-   log_line("--------------------------------------------------------");
-   log_line("|   Launching process: %s %s %s %s %s", szFile, ((NULL != szParam1)?szParam1:""), ((NULL != szParam2)?szParam2:""), ((NULL != szParam3)?szParam3:""), ((NULL != szParam4)?szParam4:""));
-   log_line("--------------------------------------------------------");
+   snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "%s %s %s %s %s", szFile, ((NULL != szParam1)?szParam1:""), ((NULL != szParam2)?szParam2:""), ((NULL != szParam3)?szParam3:""), ((NULL != szParam4)?szParam4:"") );
 
-   pid_t   my_pid;
-#ifdef WAIT_FOR_COMPLETION
-   int status;
-   int timeout /* unused ifdef WAIT_FOR_COMPLETION */;
-#endif
-   char    *argv[6];
-   argv[5] = NULL;
-   argv[4] = NULL;
-   argv[3] = NULL;
-   argv[2] = NULL;
-   argv[1] = NULL;
-   if ( (NULL != szParam4) && (0 < strlen(szParam4)) )
-   {
-      argv[4] = (char*)malloc(strlen(szParam4)+1);
-      strcpy(argv[4], szParam4);
-   }
-   if ( (NULL != szParam3) && (0 < strlen(szParam3)) )
-   {
-      argv[3] = (char*)malloc(strlen(szParam3)+1);
-      strcpy(argv[3], szParam3);
-   }
-   if ( (NULL != szParam2) && (0 < strlen(szParam2)) )
-   {
-      argv[2] = (char*)malloc(strlen(szParam2)+1);
-      strcpy(argv[2], szParam2);
-   }
-   if ( (NULL != szParam1) && (0 < strlen(szParam1)) )
-   {
-      argv[1] = (char*)malloc(strlen(szParam1)+1);
-      strcpy(argv[1], szParam1);
-   }
+   log_line("Launching process: %s", szBuff);
 
-   argv[0] = (char*)malloc(strlen(szFile)+1);
-   strcpy(argv[0], szFile);
-   if (0 == (my_pid = fork()))
-   {
-      if (-1 == execve(argv[0], (char **)argv , NULL))
-      {
-         perror("child process execve failed [%m]");
-         return -1;
-      }
-   }
-
-#ifdef WAIT_FOR_COMPLETION
-    timeout = 1000;
-
-    while (0 == waitpid(my_pid , &status , WNOHANG)) {
-            if ( --timeout < 0 ) {
-                    perror("timeout");
-                    return -1;
-            }
-            sleep(1);
-    }
-
-    printf("%s WEXITSTATUS %d WIFEXITED %d [status %d]\n",
-            argv[0], WEXITSTATUS(status), WIFEXITED(status), status);
-
-    if (1 != WIFEXITED(status) || 0 != WEXITSTATUS(status)) {
-            perror("%s failed, halt system");
-            return -1;
-    }
+   // Spawned directly (no shell) when the parameters do not need shell parsing
+   int iPID = hw_sys_spawn_command_line(szBuff);
+   if ( iPID > 0 )
+      return 0;
+   if ( iPID < 0 )
+      return -1;
 
-#endif
-    return 0;
+   strcat(szBuff, " &");
+   hw_execute_bash_command(szBuff, NULL);
+   return 0;
 }
 
 void hw_set_priority_current_proc(int nice)
@@ -291,47 +180,36 @@ void hw_set_priority_current_proc(int nice)
 
 void hw_set_proc_priority(const char* szProcName, int nice, int ionice, int waitForProcess)
 {
-   char szPIDs[128];
-   char szComm[256];
    if ( NULL == szProcName || 0 == szProcName[0] )
       return;
-   
-   hw_process_get_pids(szProcName, szPIDs);
-   removeTrailingNewLines(szPIDs);
-   replaceNewLinesToSpaces(szPIDs);
+
+   int iPIDs[HW_SYS_MAX_PIDS];
+   int iCount = hw_sys_find_pids(szProcName, iPIDs, HW_SYS_MAX_PIDS);
 
    int count = 0;
-   while ( waitForProcess && (strlen(szPIDs) <= 2) && (count < 100) )
+   while ( waitForProcess && (iCount <= 0) && (count < 100) )
    {
       hardware_sleep_ms(2);
-      szPIDs[0] = 0;
-      hw_process_get_pids(szProcName, szPIDs);
-      removeTrailingNewLines(szPIDs);
-      replaceNewLinesToSpaces(szPIDs);
+      iCount = hw_sys_find_pids(szProcName, iPIDs, HW_SYS_MAX_PIDS);
       count++;
    }
 
-   if ( strlen(szPIDs) <= 2 )
+   if ( iCount <= 0 )
       return;
-   sprintf(szComm, "renice -n %d -p %s", nice, szPIDs);
-   hw_execute_bash_command(szComm, NULL);
 
-   #ifdef HW_CAPABILITY_IONICE
-   if ( ionice > 0 )
+   log_line("Setting priority of process [%s] (%d PIDs): nice %d, io nice: %d", szProcName, iCount, nice, ionice);
+   for( int i=0; i<iCount; i++ )
    {
-      sprintf(szComm, "ionice -c 1 -n %d -p %s", ionice, szPIDs);
-      hw_execute_bash_command(szComm, NULL);
+      hw_sys_set_process_nice(iPIDs[i], nice);
+      #ifdef HW_CAPABILITY_IONICE
+      if ( ionice > 0 )
+         hw_sys_set_process_io_priority(iPIDs[i], ionice);
+      #endif
    }
-   //else
-   //   sprintf(szComm, "ionice -c 2 -n 5 -p %s", szPids);
-   #endif
 }
 
 void hw_get_proc_priority(const char* szProcName, char* szOutput)
 {
-   char szPIDs[128];
-   char szComm[256];
-   char szCommOut[1024];
    if ( NULL == szOutput )
       return;
 
@@ -345,43 +223,25 @@ void hw_get_proc_priority(const char* szProcName, char* szOutput)
       strcpy(szOutput, szProcName);
    strcat(szOutput, ": ");
 
-   hw_process_get_pids(szProcName, szPIDs);
-   removeTrailingNewLines(szPIDs);
-   replaceNewLinesToSpaces(szPIDs);
-
-   if ( strlen(szPIDs) <= 2 )
+   int iPID = 0;
+   if ( hw_sys_find_pids(szProcName, &iPID, 1) <= 0 )
    {
       strcat(szOutput, "Not Running");
       return;
    }
    strcat(szOutput, "Running, ");
 
-   char* p = removeLeadingWhiteSpace(szPIDs);
-   char* t = p;
-   while ( (*t) != 0 )
-   {
-      if ( (*t) == ' ' )
-      {
-         *t = 0;
-         break;
-      }
-      t++;
-   }
-   sprintf(szComm, "cat /proc/%s/stat | awk '{print \"priority \" $18 \", nice \" $19}'", p);
-   hw_execute_bash_command_raw(szComm, szCommOut);
-   if ( 0 < strlen(szCommOut) )
-      szCommOut[strlen(szCommOut)-1] = 0;
-   strcat(szOutput, "pri.");
-   strcat(szOutput, szCommOut+8);
+   int iPriority = 0, iNice = 0;
+   if ( hw_sys_get_process_priority(iPID, &iPriority, &iNice) )
+      sprintf(szOutput + strlen(szOutput), "pri.%d, nice %d", iPriority, iNice);
+   else
+      strcat(szOutput, "pri.N/A");
 
    #ifdef HW_CAPABILITY_IONICE
+   char szIOPriority[64];
    strcat(szOutput, ", io priority: ");
-
-   sprintf(szComm, "ionice -p %s", p);
-   hw_execute_bash_command_raw(szComm, szCommOut);
-   if ( 0 < strlen(szCommOut) )
-      szCommOut[strlen(szCommOut)-1] = 0;
-   strcat(szOutput, szCommOut);
+   if ( hw_sys_get_process_io_priority(iPID, szIOPriority) )
+      strcat(szOutput, szIOPriority);
    #endif
    strcat(szOutput, ";");
 }
@@ -395,79 +255,33 @@ void hw_set_proc_affinity(const char* szProcName, int iExceptThreadId, int iCore
    }
    log_line("Adjusting affinity for process [%s] except thread id: %d ...", szProcName, iExceptThreadId);
 
-   char szComm[128];
-   char szOutput[256];
-   char szPIDs[256];
-
-   hw_process_get_pids(szProcName, szPIDs);
-   removeTrailingNewLines(szPIDs);
-   replaceNewLinesToSpaces(szPIDs);
-   if ( strlen(szPIDs) < 3 )
+   int iPID = 0;
+   if ( hw_sys_find_pids(szProcName, &iPID, 1) <= 0 )
    {
       log_softerror_and_alarm("Failed to set process affinity for process [%s], no such process.", szProcName);
       return;
    }
-   char* p = removeLeadingWhiteSpace(szPIDs);
-   int iPID = atoi(p);
 
-   if ( iPID < 100 )
+   int iTasks[128];
+   int iCountTasks = hw_sys_get_process_threads(iPID, iTasks, sizeof(iTasks)/sizeof(iTasks[0]));
+   if ( iCountTasks <= 0 )
    {
-      log_softerror_and_alarm("Failed to set process affinity for process [%s], invalid pid: %d.", szProcName, iPID);
+      log_softerror_and_alarm("Failed to set process affinity for process [%s], no tasks found for PID %d.", szProcName, iPID);
       return;
    }
 
-   sprintf(szComm, "ls /proc/%d/task 2>/dev/null", iPID);
-   hw_execute_bash_command_raw_silent(szComm, szOutput);
-   
-   if ( strlen(szOutput) < 3 )
+   log_line("Child processes to adjust affinity for, for process [%s] %d: %d tasks", szProcName, iPID, iCountTasks);
+   for( int i=0; i<iCountTasks; i++ )
    {
-      log_softerror_and_alarm("Failed to set process affinity for process [%s], invalid tasks: [%s].", szProcName, szOutput);
-      return;
+      if ( iTasks[i] == iExceptThreadId )
+      {
+         log_line("Skip exception thread id: %d", iExceptThreadId);
+         continue;
+      }
+      // Cores are 1 based in this API
+      hw_sys_set_thread_affinity(iTasks[i], iCoreStart-1, iCoreEnd-1);
    }
 
-   replaceNewLinesToSpaces(szOutput);
-   char* pTmp = removeLeadingWhiteSpace(szOutput);
-
-   log_line("Child processes to adjust affinity for, for process [%s] %d: [%s]", szProcName, iPID, pTmp);
-   do
-   {
-       int iTask = 0;
-       if ( 1 != sscanf(pTmp, "%d", &iTask) )
-       {
-          log_softerror_and_alarm("Failed to set process affinity for process [%s], invalid parsing tasks from [%s].", szProcName, pTmp);
-          return;
-       }
-       if ( iTask < 100 )
-       {
-          log_softerror_and_alarm("Failed to set process affinity for process [%s], read invalid parsing tasks (%d) from [%s].", szProcName, iTask, pTmp);
-          return;
-       }
-
-       if ( iTask == iExceptThreadId )
-          log_line("Skip exception thread id: %d", iExceptThreadId);
-       else
-       {
-          // Set affinity
-          if ( iCoreStart == iCoreEnd )
-          {
-             sprintf(szComm, "taskset -cp %d %d 2>/dev/null", iCoreStart-1, iTask);
-             hw_execute_bash_command(szComm, NULL);
-          }
-          else
-          {
-             sprintf(szComm, "taskset -cp %d-%d %d", iCoreStart-1, iCoreEnd-1, iTask);
-             hw_execute_bash_command(szComm, NULL);        
-          }
-       }
-       // Go to next task in string
-       while ( (*pTmp) && (*pTmp != ' ') )
-          pTmp++;
-
-       while ( (*pTmp) == ' ' )
-          pTmp++;
-   }
-   while(*pTmp);
-
    log_line("Done adjusting affinity for process [%s].", szProcName);
 }
 
@@ -476,6 +290,7 @@ int _hw_execute_bash_command(const char* command, char* outBuffer, int iSilent,
 {
    if ( NULL != outBuffer )
       *outBuffer = 0;
+   hw_sys_count_fork();
    FILE* fp = popen( command, "r" );
    if ( NULL == fp )
    {
@@ -565,6 +380,7 @@ int hw_execute_bash_command_nonblock(const char* command, char* outBuffer)
 
 
    log_line("Executing command nonblock: %s", szCommand);
+   hw_sys_count_fork();
    FILE* fp = popen( szCommand, "r" );
    if ( NULL == fp )
    {
@@ -703,8 +519,23 @@ void hw_execute_ruby_process_wait(const char* szPrefixes, const char* szProcess,
    }
 
    if ( ! iWait )
+   {
+      // Spawned directly (no shell) when the prefixes and params do not need shell parsing
+      int iPID = hw_sys_spawn_command_line(szCommand);
+      if ( iPID > 0 )
+      {
+         log_line("Launched Ruby process: [%s], PID: %d", szCommand, iPID);
+         return;
+      }
+      if ( iPID < 0 )
+      {
+         log_error_and_alarm("Failed to execute Ruby process: [%s]", szCommand);
+         return;
+      }
       strcat(szCommand, " &");
+   }
 
+   hw_sys_count_fork();
    FILE* fp = popen( szCommand, "r" );
    if ( NULL == fp )
    {
@@ -854,4 +685,37 @@ int hw_increase_current_thread_priority(const char* szLogPrefix, int iNewPriorit
    log_line("%s Current new thread policy/priority: %d/%d", szPrefix, policy, params.sched_priority);
 
    return iRetValue;
+}
+
+int hw_set_current_thread_affinity(const char* szLogPrefix, int iCoreStart, int iCoreEnd)
+{
+   char szTmp[2];
+   szTmp[0] = 0;
+   char* szPrefix = szTmp;
+   if ( (NULL != szLogPrefix) && (0 != szLogPrefix[0]) )
+     szPrefix = (char*)szLogPrefix;
+
+   int iCores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   if ( iCoreStart < 0 )
+      iCoreStart = 0;
+   if ( iCoreEnd >= iCores )
+      iCoreEnd = iCores-1;
+   if ( iCoreEnd < iCoreStart )
+   {
+      log_softerror_and_alarm("%s Invalid cores range to set thread affinity to: %d-%d (%d cores)", szPrefix, iCoreStart, iCoreEnd, iCores);
+      return -1;
+   }
+
+   cpu_set_t cpuSet;
+   CPU_ZERO(&cpuSet);
+   for( int i=iCoreStart; i<=iCoreEnd; i++ )
+      CPU_SET(i, &cpuSet);
+   int iRet = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+   if ( 0 != iRet )
+   {
+      log_softerror_and_alarm("%s Failed to set thread affinity to cores %d-%d, error: %d", szPrefix, iCoreStart, iCoreEnd, iRet);
+      return -1;
+   }
+   log_line("%s Set thread affinity to cores %d-%d", szPrefix, iCoreStart, iCoreEnd);
+   return 0;
 }
\ No newline at end of file
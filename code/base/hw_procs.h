@@ -36,6 +36,7 @@ void hw_execute_ruby_process_wait(const char* szPrefixes, const char* szProcess,
 void hw_init_worker_thread_attrs(pthread_attr_t* pAttr);
 int hw_get_current_thread_priority(const char* szLogPrefix);
 int hw_increase_current_thread_priority(const char* szLogPrefix, int iNewPriority);
+int hw_set_current_thread_affinity(const char* szLogPrefix, int iCoreStart, int iCoreEnd);
 
 #ifdef __cplusplus
 }  
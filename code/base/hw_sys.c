@@ -0,0 +1,685 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // for sched_setaffinity
+#endif
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <spawn.h>
+#include <signal.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#include "base.h"
+#include "config.h"
+#include "hw_sys.h"
+
+extern char** environ;
+
+#define HW_SYS_IOPRIO_CLASS_SHIFT 13
+#define HW_SYS_IOPRIO_WHO_PROCESS 1
+#define HW_SYS_IOPRIO_CLASS_RT 1
+
+static volatile u32 s_uHwSysForksStartup = 0;
+static volatile u32 s_uHwSysForksSteady = 0;
+static volatile int s_iHwSysStartupComplete = 0;
+
+void hw_sys_count_fork()
+{
+   if ( s_iHwSysStartupComplete )
+      __sync_fetch_and_add(&s_uHwSysForksSteady, 1);
+   else
+      __sync_fetch_and_add(&s_uHwSysForksStartup, 1);
+}
+
+void hw_sys_mark_startup_complete()
+{
+   if ( s_iHwSysStartupComplete )
+      return;
+   s_iHwSysStartupComplete = 1;
+   log_line("[HwSys] Startup complete, forks done during startup: %u", s_uHwSysForksStartup);
+}
+
+int hw_sys_is_startup_complete()
+{
+   return s_iHwSysStartupComplete;
+}
+
+u32 hw_sys_get_startup_forks_count()
+{
+   return s_uHwSysForksStartup;
+}
+
+u32 hw_sys_get_steady_forks_count()
+{
+   return s_uHwSysForksSteady;
+}
+
+int hw_sys_read_file(const char* szFile, char* szOutput, int iMaxLength)
+{
+   if ( (NULL == szOutput) || (iMaxLength < 1) )
+      return -1;
+   szOutput[0] = 0;
+   if ( (NULL == szFile) || (0 == szFile[0]) )
+      return -1;
+
+   int fd = open(szFile, O_RDONLY | O_CLOEXEC);
+   if ( fd < 0 )
+      return -1;
+
+   int iTotal = 0;
+   while ( iTotal < iMaxLength-1 )
+   {
+      int iRead = read(fd, szOutput + iTotal, iMaxLength - 1 - iTotal);
+      if ( iRead < 0 )
+      {
+         if ( EINTR == errno )
+            continue;
+         break;
+      }
+      if ( 0 == iRead )
+         break;
+      iTotal += iRead;
+   }
+   close(fd);
+
+   szOutput[iTotal] = 0;
+   while ( (iTotal > 0) && ((szOutput[iTotal-1] == 10) || (szOutput[iTotal-1] == 13)) )
+   {
+      iTotal--;
+      szOutput[iTotal] = 0;
+   }
+   return iTotal;
+}
+
+int hw_sys_read_int(const char* szFile, int* piValue)
+{
+   char szBuff[64];
+   if ( hw_sys_read_file(szFile, szBuff, sizeof(szBuff)) <= 0 )
+      return 0;
+   char* p = szBuff;
+   while ( (*p) && isspace(*p) )
+      p++;
+   char* pEnd = NULL;
+   long lValue = strtol(p, &pEnd, 0);
+   if ( pEnd == p )
+      return 0;
+   if ( NULL != piValue )
+      *piValue = (int)lValue;
+   return 1;
+}
+
+int hw_sys_read_key_value(const char* szFile, const char* szKey, char* szOutput, int iMaxLength)
+{
+   if ( (NULL == szOutput) || (iMaxLength < 1) )
+      return 0;
+   szOutput[0] = 0;
+   if ( (NULL == szFile) || (NULL == szKey) || (0 == szKey[0]) )
+      return 0;
+
+   FILE* fd = fopen(szFile, "r");
+   if ( NULL == fd )
+      return 0;
+
+   int iKeyLen = strlen(szKey);
+   int iFound = 0;
+   char szLine[512];
+   while ( NULL != fgets(szLine, sizeof(szLine), fd) )
+   {
+      if ( 0 != strncmp(szLine, szKey, iKeyLen) )
+         continue;
+      char* p = szLine + iKeyLen;
+      while ( (*p == ' ') || (*p == '\t') )
+         p++;
+      if ( *p != ':' )
+         continue;
+      p++;
+      while ( (*p == ' ') || (*p == '\t') )
+         p++;
+      strncpy(szOutput, p, iMaxLength-1);
+      szOutput[iMaxLength-1] = 0;
+      removeTrailingNewLines(szOutput);
+      iFound = 1;
+      break;
+   }
+   fclose(fd);
+   return iFound;
+}
+
+int hw_sys_grep_file(const char* szFile, const char* szPattern, char* szOutput, int iMaxLength)
+{
+   if ( (NULL == szOutput) || (iMaxLength < 1) )
+      return 0;
+   szOutput[0] = 0;
+   if ( (NULL == szFile) || (NULL == szPattern) )
+      return 0;
+
+   FILE* fd = fopen(szFile, "r");
+   if ( NULL == fd )
+      return 0;
+
+   int iFound = 0;
+   char szLine[512];
+   while ( NULL != fgets(szLine, sizeof(szLine), fd) )
+   {
+      if ( NULL == strstr(szLine, szPattern) )
+         continue;
+      strncpy(szOutput, szLine, iMaxLength-1);
+      szOutput[iMaxLength-1] = 0;
+      removeTrailingNewLines(szOutput);
+      iFound = 1;
+      break;
+   }
+   fclose(fd);
+   return iFound;
+}
+
+int hw_sys_write_file(const char* szFile, const char* szValue)
+{
+   if ( (NULL == szFile) || (0 == szFile[0]) || (NULL == szValue) )
+      return 0;
+   int fd = open(szFile, O_WRONLY | O_CLOEXEC);
+   if ( fd < 0 )
+   {
+      log_softerror_and_alarm("[HwSys] Failed to open [%s] for write, error: %d (%s)", szFile, errno, strerror(errno));
+      return 0;
+   }
+   int iLen = strlen(szValue);
+   int iRes = write(fd, szValue, iLen);
+   close(fd);
+   if ( iRes != iLen )
+   {
+      log_softerror_and_alarm("[HwSys] Failed to write [%s] to [%s], error: %d (%s)", szValue, szFile, errno, strerror(errno));
+      return 0;
+   }
+   return 1;
+}
+
+int hw_sys_write_cpufreq_all(const char* szNode, const char* szValue)
+{
+   if ( (NULL == szNode) || (0 == szNode[0]) || (NULL == szValue) )
+      return 0;
+
+   DIR* pDir = opendir("/sys/devices/system/cpu");
+   if ( NULL == pDir )
+      return 0;
+
+   int iCount = 0;
+   struct dirent* pEntry = NULL;
+   while ( NULL != (pEntry = readdir(pDir)) )
+   {
+      if ( (0 != strncmp(pEntry->d_name, "cpu", 3)) || (! isdigit(pEntry->d_name[3])) )
+         continue;
+      char szFile[MAX_FILE_PATH_SIZE];
+      snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "/sys/devices/system/cpu/%s/cpufreq/%s", pEntry->d_name, szNode);
+      if ( access(szFile, W_OK) == -1 )
+         continue;
+      if ( hw_sys_write_file(szFile, szValue) )
+         iCount++;
+   }
+   closedir(pDir);
+   log_line("[HwSys] Set cpufreq %s to %s on %d cpus", szNode, szValue, iCount);
+   return iCount;
+}
+
+int hw_sys_make_dirs(const char* szPath, int iMode)
+{
+   if ( (NULL == szPath) || (0 == szPath[0]) )
+      return 0;
+   char szDir[MAX_FILE_PATH_SIZE];
+   int iLen = strlen(szPath);
+   if ( iLen >= (int)sizeof(szDir) )
+      return 0;
+   strcpy(szDir, szPath);
+
+   // Create each parent, then the folder itself (the end of the string)
+   for( int i=1; i<=iLen; i++ )
+   {
+      if ( (i < iLen) && (szDir[i] != '/') )
+         continue;
+      char c = szDir[i];
+      szDir[i] = 0;
+      if ( (0 != mkdir(szDir, (mode_t)iMode)) && (errno != EEXIST) )
+      {
+         log_softerror_and_alarm("[HwSys] Failed to create folder [%s], error: %d (%s)", szDir, errno, strerror(errno));
+         return 0;
+      }
+      szDir[i] = c;
+   }
+   struct stat st;
+   if ( (0 != stat(szPath, &st)) || (! S_ISDIR(st.st_mode)) )
+   {
+      log_softerror_and_alarm("[HwSys] [%s] exists and is not a folder", szPath);
+      return 0;
+   }
+   return 1;
+}
+
+int hw_sys_get_cpu_cores_count()
+{
+   int iCores = (int)sysconf(_SC_NPROCESSORS_CONF);
+   if ( iCores > 1 )
+      return iCores;
+
+   // Some minimal libc builds report a single core; count the cpuinfo entries instead
+   iCores = 0;
+   FILE* fd = fopen("/proc/cpuinfo", "r");
+   if ( NULL != fd )
+   {
+      char szLine[256];
+      while ( NULL != fgets(szLine, sizeof(szLine), fd) )
+      {
+         if ( 0 == strncmp(szLine, "processor", 9) )
+            iCores++;
+      }
+      fclose(fd);
+   }
+   if ( iCores < 1 )
+      iCores = 1;
+   return iCores;
+}
+
+// Returns the process state char, 0 on failure. szComm is the kernel comm name
+static char _hw_sys_read_process_stat(int iPID, char* szComm, int iMaxComm, char** ppAfterState, char* szStatBuffer, int iStatBufferSize)
+{
+   char szFile[64];
+   snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "/proc/%d/stat", iPID);
+   if ( hw_sys_read_file(szFile, szStatBuffer, iStatBufferSize) <= 0 )
+      return 0;
+
+   // The comm name is between parentheses and can contain spaces or parentheses itself
+   char* pStart = strchr(szStatBuffer, '(');
+   char* pEnd = strrchr(szStatBuffer, ')');
+   if ( (NULL == pStart) || (NULL == pEnd) || (pEnd < pStart) || (pEnd[1] != ' ') )
+      return 0;
+   if ( NULL != szComm )
+   {
+      int iLen = (int)(pEnd - pStart - 1);
+      if ( iLen >= iMaxComm )
+         iLen = iMaxComm-1;
+      memcpy(szComm, pStart+1, iLen);
+      szComm[iLen] = 0;
+   }
+   if ( NULL != ppAfterState )
+      *ppAfterState = pEnd + 4;
+   return pEnd[2];
+}
+
+static void _hw_sys_read_process_argv0_name(int iPID, char* szOutput, int iMaxLength)
+{
+   char szFile[64];
+   char szCmdLine[256];
+   szOutput[0] = 0;
+   snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "/proc/%d/cmdline", iPID);
+   int fd = open(szFile, O_RDONLY | O_CLOEXEC);
+   if ( fd < 0 )
+      return;
+   int iRead = read(fd, szCmdLine, sizeof(szCmdLine)-1);
+   close(fd);
+   if ( iRead <= 0 )
+      return;
+   szCmdLine[iRead] = 0;
+   // argv[0] ends at the first zero
+   char* pName = strrchr(szCmdLine, '/');
+   pName = (NULL != pName)?(pName+1):szCmdLine;
+   strncpy(szOutput, pName, iMaxLength-1);
+   szOutput[iMaxLength-1] = 0;
+}
+
+int hw_sys_find_pids(const char* szProcName, int* piPIDs, int iMaxPIDs)
+{
+   if ( (NULL == szProcName) || (0 == szProcName[0]) || (NULL == piPIDs) || (iMaxPIDs < 1) )
+      return 0;
+
+   DIR* pDir = opendir("/proc");
+   if ( NULL == pDir )
+   {
+      log_softerror_and_alarm("[HwSys] Failed to open /proc");
+      return 0;
+   }
+
+   int iPIDsPartial[HW_SYS_MAX_PIDS];
+   int iCountPartial = 0;
+   int iCountExact = 0;
+   char szStat[512];
+   char szComm[64];
+   char szArg0[128];
+
+   struct dirent* pEntry = NULL;
+   while ( NULL != (pEntry = readdir(pDir)) )
+   {
+      if ( ! isdigit(pEntry->d_name[0]) )
+         continue;
+      int iPID = atoi(pEntry->d_name);
+      if ( iPID <= 0 )
+         continue;
+      char cState = _hw_sys_read_process_stat(iPID, szComm, sizeof(szComm), NULL, szStat, sizeof(szStat));
+      if ( (0 == cState) || ('Z' == cState) || ('X' == cState) )
+         continue;
+      _hw_sys_read_process_argv0_name(iPID, szArg0, sizeof(szArg0));
+
+      if ( (0 == strcmp(szComm, szProcName)) || (0 == strcmp(szArg0, szProcName)) )
+      {
+         if ( iCountExact < iMaxPIDs )
+            piPIDs[iCountExact++] = iPID;
+         continue;
+      }
+      if ( (0 == iCountExact) && (iCountPartial < HW_SYS_MAX_PIDS) )
+      if ( (NULL != strstr(szComm, szProcName)) || (NULL != strstr(szArg0, szProcName)) )
+         iPIDsPartial[iCountPartial++] = iPID;
+   }
+   closedir(pDir);
+
+   if ( iCountExact > 0 )
+      return iCountExact;
+
+   if ( iCountPartial > iMaxPIDs )
+      iCountPartial = iMaxPIDs;
+   for( int i=0; i<iCountPartial; i++ )
+      piPIDs[i] = iPIDsPartial[i];
+   return iCountPartial;
+}
+
+int hw_sys_get_process_threads(int iPID, int* piTIDs, int iMaxTIDs)
+{
+   if ( (iPID <= 0) || (NULL == piTIDs) || (iMaxTIDs < 1) )
+      return 0;
+
+   char szFolder[64];
+   snprintf(szFolder, sizeof(szFolder)/sizeof(szFolder[0]), "/proc/%d/task", iPID);
+   DIR* pDir = opendir(szFolder);
+   if ( NULL == pDir )
+      return 0;
+
+   int iCount = 0;
+   struct dirent* pEntry = NULL;
+   while ( (NULL != (pEntry = readdir(pDir))) && (iCount < iMaxTIDs) )
+   {
+      if ( ! isdigit(pEntry->d_name[0]) )
+         continue;
+      int iTID = atoi(pEntry->d_name);
+      if ( iTID > 0 )
+         piTIDs[iCount++] = iTID;
+   }
+   closedir(pDir);
+   return iCount;
+}
+
+int hw_sys_get_process_priority(int iPID, int* piPriority, int* piNice)
+{
+   char szStat[512];
+   char* pFields = NULL;
+   if ( 0 == _hw_sys_read_process_stat(iPID, NULL, 0, &pFields, szStat, sizeof(szStat)) )
+      return 0;
+
+   // pFields starts at field 4 (ppid); priority and nice are fields 18 and 19
+   int iField = 4;
+   char* p = pFields;
+   while ( (*p) && (iField < 18) )
+   {
+      if ( *p == ' ' )
+         iField++;
+      p++;
+   }
+   int iPriority = 0, iNice = 0;
+   if ( 2 != sscanf(p, "%d %d", &iPriority, &iNice) )
+      return 0;
+   if ( NULL != piPriority )
+      *piPriority = iPriority;
+   if ( NULL != piNice )
+      *piNice = iNice;
+   return 1;
+}
+
+int hw_sys_set_process_nice(int iPID, int iNice)
+{
+   if ( iPID <= 0 )
+      return 0;
+   if ( 0 != setpriority(PRIO_PROCESS, iPID, iNice) )
+   {
+      log_softerror_and_alarm("[HwSys] Failed to set nice %d for PID %d, error: %d (%s)", iNice, iPID, errno, strerror(errno));
+      return 0;
+   }
+   return 1;
+}
+
+int hw_sys_set_process_io_priority(int iPID, int iLevel)
+{
+   if ( iPID <= 0 )
+      return 0;
+   #ifdef SYS_ioprio_set
+   if ( iLevel < 0 )
+      iLevel = 0;
+   if ( iLevel > 7 )
+      iLevel = 7;
+   int iPrio = (HW_SYS_IOPRIO_CLASS_RT << HW_SYS_IOPRIO_CLASS_SHIFT) | iLevel;
+   if ( 0 != syscall(SYS_ioprio_set, HW_SYS_IOPRIO_WHO_PROCESS, iPID, iPrio) )
+   {
+      log_softerror_and_alarm("[HwSys] Failed to set io priority %d for PID %d, error: %d (%s)", iLevel, iPID, errno, strerror(errno));
+      return 0;
+   }
+   return 1;
+   #else
+   return 0;
+   #endif
+}
+
+int hw_sys_get_process_io_priority(int iPID, char* szOutput)
+{
+   if ( NULL == szOutput )
+      return 0;
+   szOutput[0] = 0;
+   #ifdef SYS_ioprio_get
+   int iPrio = syscall(SYS_ioprio_get, HW_SYS_IOPRIO_WHO_PROCESS, iPID);
+   if ( iPrio < 0 )
+      return 0;
+   static const char* s_szIOPrioClasses[] = { "none", "realtime", "best-effort", "idle" };
+   int iClass = (iPrio >> HW_SYS_IOPRIO_CLASS_SHIFT) & 0x03;
+   if ( 3 == iClass )
+      strcpy(szOutput, "idle");
+   else
+      sprintf(szOutput, "%s: prio %d", s_szIOPrioClasses[iClass], iPrio & 0xFF);
+   return 1;
+   #else
+   return 0;
+   #endif
+}
+
+int hw_sys_set_thread_affinity(int iTID, int iCoreStart, int iCoreEnd)
+{
+   int iCores = hw_sys_get_cpu_cores_count();
+   if ( iCoreStart < 0 )
+      iCoreStart = 0;
+   if ( iCoreEnd >= iCores )
+      iCoreEnd = iCores-1;
+   if ( (iTID <= 0) || (iCoreEnd < iCoreStart) )
+      return 0;
+
+   cpu_set_t cpuSet;
+   CPU_ZERO(&cpuSet);
+   for( int i=iCoreStart; i<=iCoreEnd; i++ )
+      CPU_SET(i, &cpuSet);
+   if ( 0 != sched_setaffinity(iTID, sizeof(cpu_set_t), &cpuSet) )
+   {
+      log_softerror_and_alarm("[HwSys] Failed to set affinity of thread %d to cores %d-%d, error: %d (%s)", iTID, iCoreStart, iCoreEnd, errno, strerror(errno));
+      return 0;
+   }
+   return 1;
+}
+
+int hw_sys_signal_pids(const int* piPIDs, int iCount, int iSignal)
+{
+   if ( NULL == piPIDs )
+      return 0;
+   int iSignaled = 0;
+   for( int i=0; i<iCount; i++ )
+   {
+      if ( piPIDs[i] <= 1 )
+         continue;
+      if ( 0 == kill(piPIDs[i], iSignal) )
+         iSignaled++;
+   }
+   return iSignaled;
+}
+
+int hw_sys_count_usb_devices(u16 uVendorId, u16 uProductId)
+{
+   DIR* pDir = opendir("/sys/bus/usb/devices");
+   if ( NULL == pDir )
+      return 0;
+
+   int iCount = 0;
+   struct dirent* pEntry = NULL;
+   while ( NULL != (pEntry = readdir(pDir)) )
+   {
+      if ( pEntry->d_name[0] == '.' )
+         continue;
+      // Interfaces (1-1:1.0) have no ids, only devices do
+      if ( NULL != strchr(pEntry->d_name, ':') )
+         continue;
+      char szFile[MAX_FILE_PATH_SIZE];
+      char szValue[16];
+      snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "/sys/bus/usb/devices/%s/idVendor", pEntry->d_name);
+      if ( hw_sys_read_file(szFile, szValue, sizeof(szValue)) <= 0 )
+         continue;
+      if ( (u16)strtol(szValue, NULL, 16) != uVendorId )
+         continue;
+      snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "/sys/bus/usb/devices/%s/idProduct", pEntry->d_name);
+      if ( hw_sys_read_file(szFile, szValue, sizeof(szValue)) <= 0 )
+         continue;
+      if ( (u16)strtol(szValue, NULL, 16) == uProductId )
+         iCount++;
+   }
+   closedir(pDir);
+   return iCount;
+}
+
+static void* _hw_sys_thread_reap_child(void* pArg)
+{
+   pid_t iPID = (pid_t)(intptr_t)pArg;
+   int iStatus = 0;
+   while ( waitpid(iPID, &iStatus, 0) < 0 )
+   {
+      if ( EINTR != errno )
+         break;
+   }
+   return NULL;
+}
+
+int hw_sys_spawn(char* const argv[])
+{
+   if ( (NULL == argv) || (NULL == argv[0]) || (0 == argv[0][0]) )
+      return -1;
+
+   posix_spawn_file_actions_t fileActions;
+   posix_spawnattr_t attr;
+   posix_spawn_file_actions_init(&fileActions);
+   posix_spawnattr_init(&attr);
+
+   // Same as a background job of a shell: no stdin
+   posix_spawn_file_actions_addopen(&fileActions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+
+   // Do not pass down the blocked or ignored signals of this process
+   sigset_t sigMask, sigDefault;
+   sigemptyset(&sigMask);
+   sigemptyset(&sigDefault);
+   sigaddset(&sigDefault, SIGPIPE);
+   sigaddset(&sigDefault, SIGINT);
+   sigaddset(&sigDefault, SIGQUIT);
+   sigaddset(&sigDefault, SIGTERM);
+   sigaddset(&sigDefault, SIGHUP);
+   sigaddset(&sigDefault, SIGCHLD);
+   sigaddset(&sigDefault, SIGUSR1);
+   sigaddset(&sigDefault, SIGUSR2);
+   posix_spawnattr_setsigmask(&attr, &sigMask);
+   posix_spawnattr_setsigdefault(&attr, &sigDefault);
+   posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+   pid_t iPID = 0;
+   hw_sys_count_fork();
+   int iRes = posix_spawnp(&iPID, argv[0], &fileActions, &attr, argv, environ);
+   posix_spawn_file_actions_destroy(&fileActions);
+   posix_spawnattr_destroy(&attr);
+
+   if ( 0 != iRes )
+   {
+      log_softerror_and_alarm("[HwSys] Failed to spawn process [%s], error: %d (%s)", argv[0], iRes, strerror(iRes));
+      return -1;
+   }
+
+   pthread_t pThread;
+   pthread_attr_t attrThread;
+   pthread_attr_init(&attrThread);
+   pthread_attr_setdetachstate(&attrThread, PTHREAD_CREATE_DETACHED);
+   pthread_attr_setstacksize(&attrThread, 1024*16);
+   if ( 0 != pthread_create(&pThread, &attrThread, &_hw_sys_thread_reap_child, (void*)(intptr_t)iPID) )
+      log_softerror_and_alarm("[HwSys] Failed to create reaper thread for child PID %d", iPID);
+   pthread_attr_destroy(&attrThread);
+
+   log_line("[HwSys] Spawned process [%s], PID: %d", argv[0], iPID);
+   return iPID;
+}
+
+int hw_sys_spawn_command_line(const char* szCommandLine)
+{
+   if ( (NULL == szCommandLine) || (0 == szCommandLine[0]) )
+      return -1;
+   if ( NULL != strpbrk(szCommandLine, "\"'\\$`|&;<>(){}*?~") )
+      return 0;
+
+   char szBuffer[1024];
+   strncpy(szBuffer, szCommandLine, sizeof(szBuffer)-1);
+   szBuffer[sizeof(szBuffer)-1] = 0;
+
+   char* argv[HW_SYS_MAX_SPAWN_ARGS+1];
+   int iArgs = 0;
+   char* pSavePtr = NULL;
+   char* pToken = strtok_r(szBuffer, " \t\r\n", &pSavePtr);
+   while ( (NULL != pToken) && (iArgs < HW_SYS_MAX_SPAWN_ARGS) )
+   {
+      argv[iArgs++] = pToken;
+      pToken = strtok_r(NULL, " \t\r\n", &pSavePtr);
+   }
+   if ( NULL != pToken )
+      return 0;
+   if ( 0 == iArgs )
+      return -1;
+   argv[iArgs] = NULL;
+   return hw_sys_spawn(argv);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "base.h"
+
+// Native process management and procfs/sysfs access.
+// Replaces the shell-outs (pidof, ps, renice, ionice, taskset, cat, lsusb, nproc...) that
+// used to fork and exec a bash for every read of a kernel value or process lookup.
+
+#define HW_SYS_MAX_PIDS 32
+#define HW_SYS_MAX_SPAWN_ARGS 32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fork/exec accounting. Every fork (popen, system, spawn) done through hw_procs is counted,
+// separately for the startup phase and for the steady state (after hw_sys_mark_startup_complete)
+void hw_sys_count_fork();
+void hw_sys_mark_startup_complete();
+int hw_sys_is_startup_complete();
+u32 hw_sys_get_startup_forks_count();
+u32 hw_sys_get_steady_forks_count();
+
+// procfs/sysfs reads and writes.
+// Read returns the number of bytes read (trailing new lines removed) or -1 on failure.
+int hw_sys_read_file(const char* szFile, char* szOutput, int iMaxLength);
+// Returns 1 on success
+int hw_sys_read_int(const char* szFile, int* piValue);
+// Finds the first line "szKey<spaces>:<value>" (as in /proc/cpuinfo) and returns the value part. Returns 1 on success
+int hw_sys_read_key_value(const char* szFile, const char* szKey, char* szOutput, int iMaxLength);
+// Returns the first line of the file that contains szPattern (as cat file | grep pattern). Returns 1 if found
+int hw_sys_grep_file(const char* szFile, const char* szPattern, char* szOutput, int iMaxLength);
+// Returns 1 on success
+int hw_sys_write_file(const char* szFile, const char* szValue);
+// Writes szValue to /sys/devices/system/cpu/cpu*/cpufreq/<szNode>. Returns the number of cpus updated
+int hw_sys_write_cpufreq_all(const char* szNode, const char* szValue);
+int hw_sys_get_cpu_cores_count();
+// Creates the folder and its missing parents (as mkdir -p). Returns 1 on success or if it already exists
+int hw_sys_make_dirs(const char* szPath, int iMode);
+
+// Processes. A process name matches the kernel comm name or the basename of argv[0].
+// If no process matches exactly, processes whose name contains szProcName match (as pgrep does).
+// Zombie processes are skipped. Returns the number of PIDs found.
+int hw_sys_find_pids(const char* szProcName, int* piPIDs, int iMaxPIDs);
+// Returns the number of thread ids of the process
+int hw_sys_get_process_threads(int iPID, int* piTIDs, int iMaxTIDs);
+// Returns 1 on success. Values are the kernel priority and nice fields of /proc/pid/stat
+int hw_sys_get_process_priority(int iPID, int* piPriority, int* piNice);
+int hw_sys_set_process_nice(int iPID, int iNice);
+// Realtime io class, level 0..7. Returns 1 on success
+int hw_sys_set_process_io_priority(int iPID, int iLevel);
+// Same output format as ionice -p: "<class>: prio <level>"
+int hw_sys_get_process_io_priority(int iPID, char* szOutput);
+// Cores are 0 based, inclusive
+int hw_sys_set_thread_affinity(int iTID, int iCoreStart, int iCoreEnd);
+// Returns the number of processes signaled
+int hw_sys_signal_pids(const int* piPIDs, int iCount, int iSignal);
+
+// USB devices, enumerated from /sys/bus/usb/devices. Returns the number of matching devices
+int hw_sys_count_usb_devices(u16 uVendorId, u16 uProductId);
+
+// Launches a child process without a shell (posix_spawnp). Returns the child PID or -1.
+// The child is reaped by a detached thread, so it never lingers as a zombie.
+int hw_sys_spawn(char* const argv[]);
+// Splits szCommandLine on white spaces and spawns it. Returns the child PID, -1 on failure
+// or 0 if the command line needs a shell (quotes, redirects, pipes, variables...).
+int hw_sys_spawn_command_line(const char* szCommandLine);
+
+#ifdef __cplusplus
+}
+#endif
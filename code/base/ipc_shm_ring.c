@@ -0,0 +1,295 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include "ipc_shm_ring.h"
+
+// Each message is a 4 bytes record header followed by the data, padded to 4 bytes.
+// When a record does not fit before the end of the ring, a wrap record fills the remaining space.
+#define IPC_SHM_RING_RECORD_MESSAGE 0xA55A0000
+#define IPC_SHM_RING_RECORD_WRAP 0x5AA50000
+#define IPC_SHM_RING_RECORD_TYPE_MASK 0xFFFF0000
+#define IPC_SHM_RING_RECORD_LENGTH_MASK 0x0000FFFF
+
+#define IPC_SHM_RING_INIT_NONE 0
+#define IPC_SHM_RING_INIT_IN_PROGRESS 1
+#define IPC_SHM_RING_INIT_DONE 2
+
+static void _ipc_shm_ring_init(t_ipc_shm_ring* pRing)
+{
+   u32 uState = __atomic_load_n(&pRing->uInitState, __ATOMIC_ACQUIRE);
+   if ( (IPC_SHM_RING_INIT_DONE == uState) && (pRing->uMagic == IPC_SHM_RING_MAGIC) && (pRing->uVersion == IPC_SHM_RING_VERSION) )
+      return;
+
+   // Left over from a different version: reset it
+   if ( IPC_SHM_RING_INIT_DONE == uState )
+      __atomic_compare_exchange_n(&pRing->uInitState, &uState, IPC_SHM_RING_INIT_NONE, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+
+   uState = IPC_SHM_RING_INIT_NONE;
+   if ( __atomic_compare_exchange_n(&pRing->uInitState, &uState, IPC_SHM_RING_INIT_IN_PROGRESS, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) )
+   {
+      pRing->uVersion = IPC_SHM_RING_VERSION;
+      pRing->uWriteLock = 0;
+      pRing->uCountMessagesWritten = 0;
+      pRing->uCountMessagesDropped = 0;
+      pRing->uWritePos = 0;
+      pRing->uDataSeq = 0;
+      pRing->uReadPos = 0;
+      pRing->uReaderWaiting = 0;
+      pRing->uMagic = IPC_SHM_RING_MAGIC;
+      __atomic_store_n(&pRing->uInitState, IPC_SHM_RING_INIT_DONE, __ATOMIC_RELEASE);
+      return;
+   }
+
+   // The other endpoint is initializing it
+   for( int i=0; i<1000; i++ )
+   {
+      if ( IPC_SHM_RING_INIT_DONE == __atomic_load_n(&pRing->uInitState, __ATOMIC_ACQUIRE) )
+         return;
+      hardware_sleep_micros(100);
+   }
+}
+
+t_ipc_shm_ring* ipc_shm_ring_open(const char* szName, int* piFd)
+{
+   if ( NULL != piFd )
+      *piFd = -1;
+   int fd = shm_open(szName, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+   if ( fd < 0 )
+   {
+      log_softerror_and_alarm("[IPCRing] Failed to open shared memory %s, error: %s", szName, strerror(errno));
+      return NULL;
+   }
+   struct stat st;
+   if ( (0 != fstat(fd, &st)) || (st.st_size < (off_t)sizeof(t_ipc_shm_ring)) )
+   if ( ftruncate(fd, sizeof(t_ipc_shm_ring)) == -1 )
+   {
+      log_softerror_and_alarm("[IPCRing] Failed to init (ftruncate) shared memory %s", szName);
+      close(fd);
+      return NULL;
+   }
+   void* pMem = mmap(NULL, sizeof(t_ipc_shm_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if ( pMem == MAP_FAILED )
+   {
+      log_softerror_and_alarm("[IPCRing] Failed to map shared memory %s", szName);
+      close(fd);
+      return NULL;
+   }
+   t_ipc_shm_ring* pRing = (t_ipc_shm_ring*)pMem;
+   _ipc_shm_ring_init(pRing);
+   if ( NULL != piFd )
+      *piFd = fd;
+   else
+      close(fd);
+   return pRing;
+}
+
+void ipc_shm_ring_close(t_ipc_shm_ring* pRing, int iFd)
+{
+   if ( NULL != pRing )
+      munmap(pRing, sizeof(t_ipc_shm_ring));
+   if ( iFd >= 0 )
+      close(iFd);
+}
+
+void ipc_shm_ring_unlink(const char* szName)
+{
+   shm_unlink(szName);
+}
+
+static void _ipc_shm_ring_lock_write(t_ipc_shm_ring* pRing)
+{
+   u32 uPID = (u32)getpid();
+   u32 uTimeLastOwnerCheck = 0;
+   int iSpins = 0;
+   while ( 1 )
+   {
+      u32 uOwner = 0;
+      if ( __atomic_compare_exchange_n(&pRing->uWriteLock, &uOwner, uPID, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) )
+         return;
+      iSpins++;
+      if ( iSpins < 100 )
+         continue;
+      if ( iSpins < 200 )
+      {
+         sched_yield();
+         continue;
+      }
+
+      u32 uTimeNow = get_current_timestamp_ms();
+      if ( 0 == uTimeLastOwnerCheck )
+         uTimeLastOwnerCheck = uTimeNow;
+
+      // A writer killed in the middle of a write never published its record (uWritePos is updated last), so the ring is consistent.
+      // A live owner (even a slow one) keeps the lock: taking it over would let two writers interleave in the ring.
+      if ( uTimeNow >= uTimeLastOwnerCheck + IPC_SHM_RING_LOCK_CHECK_OWNER_MS )
+      {
+         uTimeLastOwnerCheck = uTimeNow;
+         if ( (0 != kill((pid_t)uOwner, 0)) && (errno == ESRCH) )
+         {
+            log_softerror_and_alarm("[IPCRing] Write lock owner (PID %u) is dead. Taking over the lock.", uOwner);
+            // Fails if someone else released or took it meanwhile: keep waiting
+            if ( __atomic_compare_exchange_n(&pRing->uWriteLock, &uOwner, uPID, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) )
+               return;
+            continue;
+         }
+      }
+      hardware_sleep_micros(100);
+   }
+}
+
+static void _ipc_shm_ring_unlock_write(t_ipc_shm_ring* pRing)
+{
+   __atomic_store_n(&pRing->uWriteLock, 0, __ATOMIC_RELEASE);
+}
+
+int ipc_shm_ring_write(t_ipc_shm_ring* pRing, const u8* pData, int iLength)
+{
+   if ( (NULL == pRing) || (NULL == pData) || (iLength <= 0) || (iLength > (int)IPC_SHM_RING_RECORD_LENGTH_MASK) )
+      return 0;
+
+   u32 uRecordSize = 4 + (((u32)iLength + 3) & (~(u32)3));
+
+   _ipc_shm_ring_lock_write(pRing);
+   u32 uWritePos = pRing->uWritePos;
+   u32 uReadPos = __atomic_load_n(&pRing->uReadPos, __ATOMIC_ACQUIRE);
+   u32 uOffset = uWritePos & (IPC_SHM_RING_DATA_SIZE-1);
+   u32 uToEnd = IPC_SHM_RING_DATA_SIZE - uOffset;
+   u32 uNeeded = uRecordSize;
+   if ( uToEnd < uRecordSize )
+      uNeeded += uToEnd;
+
+   if ( IPC_SHM_RING_DATA_SIZE - (uWritePos - uReadPos) < uNeeded )
+   {
+      pRing->uCountMessagesDropped++;
+      _ipc_shm_ring_unlock_write(pRing);
+      return 0;
+   }
+
+   if ( uToEnd < uRecordSize )
+   {
+      *((u32*)&pRing->uData[uOffset]) = IPC_SHM_RING_RECORD_WRAP;
+      uWritePos += uToEnd;
+      uOffset = 0;
+   }
+   *((u32*)&pRing->uData[uOffset]) = IPC_SHM_RING_RECORD_MESSAGE | (u32)iLength;
+   memcpy(&pRing->uData[uOffset+4], pData, iLength);
+   pRing->uCountMessagesWritten++;
+   __atomic_store_n(&pRing->uWritePos, uWritePos + uRecordSize, __ATOMIC_RELEASE);
+   _ipc_shm_ring_unlock_write(pRing);
+
+   // Wake up the reader only if it sleeps (seq_cst pairs with the reader setting the flag then checking for data)
+   __atomic_add_fetch(&pRing->uDataSeq, 1, __ATOMIC_SEQ_CST);
+   if ( __atomic_load_n(&pRing->uReaderWaiting, __ATOMIC_SEQ_CST) )
+      syscall(SYS_futex, &pRing->uDataSeq, FUTEX_WAKE, 1, NULL, NULL, 0);
+   return iLength;
+}
+
+int ipc_shm_ring_has_data(t_ipc_shm_ring* pRing)
+{
+   if ( NULL == pRing )
+      return 0;
+   return (__atomic_load_n(&pRing->uWritePos, __ATOMIC_ACQUIRE) != pRing->uReadPos)?1:0;
+}
+
+int ipc_shm_ring_read(t_ipc_shm_ring* pRing, u8* pOutput, int iMaxLength)
+{
+   if ( (NULL == pRing) || (NULL == pOutput) )
+      return 0;
+
+   u32 uReadPos = pRing->uReadPos;
+   u32 uWritePos = __atomic_load_n(&pRing->uWritePos, __ATOMIC_ACQUIRE);
+   if ( uReadPos == uWritePos )
+      return 0;
+
+   u32 uOffset = uReadPos & (IPC_SHM_RING_DATA_SIZE-1);
+   u32 uRecord = *((u32*)&pRing->uData[uOffset]);
+   if ( (uRecord & IPC_SHM_RING_RECORD_TYPE_MASK) == IPC_SHM_RING_RECORD_WRAP )
+   {
+      uReadPos += IPC_SHM_RING_DATA_SIZE - uOffset;
+      if ( uReadPos == uWritePos )
+      {
+         __atomic_store_n(&pRing->uReadPos, uReadPos, __ATOMIC_RELEASE);
+         return 0;
+      }
+      uOffset = 0;
+      uRecord = *((u32*)&pRing->uData[0]);
+   }
+
+   int iLength = (int)(uRecord & IPC_SHM_RING_RECORD_LENGTH_MASK);
+   u32 uRecordSize = 4 + (((u32)iLength + 3) & (~(u32)3));
+   if ( ((uRecord & IPC_SHM_RING_RECORD_TYPE_MASK) != IPC_SHM_RING_RECORD_MESSAGE) ||
+        (uRecordSize > uWritePos - uReadPos) || (uOffset + uRecordSize > IPC_SHM_RING_DATA_SIZE) )
+   {
+      __atomic_store_n(&pRing->uReadPos, uWritePos, __ATOMIC_RELEASE);
+      return -1;
+   }
+   // Valid record, just too big for the caller: skip only this message
+   if ( iLength > iMaxLength )
+   {
+      __atomic_store_n(&pRing->uReadPos, uReadPos + uRecordSize, __ATOMIC_RELEASE);
+      return -1;
+   }
+
+   memcpy(pOutput, &pRing->uData[uOffset+4], iLength);
+   __atomic_store_n(&pRing->uReadPos, uReadPos + uRecordSize, __ATOMIC_RELEASE);
+   return iLength;
+}
+
+int ipc_shm_ring_wait(t_ipc_shm_ring* pRing, int iTimeoutMicros)
+{
+   if ( NULL == pRing )
+      return 0;
+   if ( ipc_shm_ring_has_data(pRing) )
+      return 1;
+   if ( iTimeoutMicros <= 0 )
+      return 0;
+
+   u32 uSeq = __atomic_load_n(&pRing->uDataSeq, __ATOMIC_SEQ_CST);
+   __atomic_store_n(&pRing->uReaderWaiting, 1, __ATOMIC_SEQ_CST);
+   if ( ! ipc_shm_ring_has_data(pRing) )
+   {
+      struct timespec ts;
+      ts.tv_sec = iTimeoutMicros / 1000000;
+      ts.tv_nsec = (iTimeoutMicros % 1000000) * 1000;
+      syscall(SYS_futex, &pRing->uDataSeq, FUTEX_WAIT, uSeq, &ts, NULL, 0);
+   }
+   __atomic_store_n(&pRing->uReaderWaiting, 0, __ATOMIC_RELAXED);
+   return ipc_shm_ring_has_data(pRing);
+}
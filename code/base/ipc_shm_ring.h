@@ -0,0 +1,60 @@
+#pragma once
+
+#include "base.h"
+
+// Shared memory ring used as IPC transport between two processes.
+// Variable size messages are copied into a byte ring mapped by both endpoints.
+// Writers serialize on a small spin lock inside the ring (normally there is only one).
+// The lock holds the writer's PID, so a writer killed while holding it (kill -9) does not
+// block the channel: every IPC_SHM_RING_LOCK_CHECK_OWNER_MS the owner is checked and the lock
+// is taken over only if the owner process no longer exists. A live owner is always waited for.
+// the reader side is lock free and must be used by one thread only.
+// The reader can block on a futex until data arrives; writers only do a syscall
+// if the reader is actually waiting.
+
+#define IPC_SHM_RING_MAGIC 0x52504349
+#define IPC_SHM_RING_VERSION 2
+#define IPC_SHM_RING_DATA_SIZE (64*1024)
+#define IPC_SHM_RING_LOCK_CHECK_OWNER_MS 20
+
+typedef struct
+{
+   u32 uMagic;
+   u32 uVersion;
+   u32 uInitState;
+   u32 uWriteLock; // PID of the writer holding the lock, 0 if free
+   u32 uCountMessagesWritten;
+   u32 uCountMessagesDropped;
+   u8  uPadding1[40];
+
+   u32 uWritePos; // Monotonic byte positions, offset in the ring is pos % IPC_SHM_RING_DATA_SIZE
+   u32 uDataSeq; // Futex word, incremented on each published message
+   u8  uPadding2[56];
+
+   u32 uReadPos;
+   u32 uReaderWaiting;
+   u8  uPadding3[56];
+
+   u8 uData[IPC_SHM_RING_DATA_SIZE];
+} t_ipc_shm_ring;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Creates the shared memory ring or attaches to an existing one. Returns NULL on failure.
+t_ipc_shm_ring* ipc_shm_ring_open(const char* szName, int* piFd);
+void ipc_shm_ring_close(t_ipc_shm_ring* pRing, int iFd);
+void ipc_shm_ring_unlink(const char* szName);
+
+// Returns iLength if the message was added, 0 if the ring is full
+int ipc_shm_ring_write(t_ipc_shm_ring* pRing, const u8* pData, int iLength);
+// Returns the message length, 0 if there is no message, -1 if an invalid (discarded) message or invalid data was found
+int ipc_shm_ring_read(t_ipc_shm_ring* pRing, u8* pOutput, int iMaxLength);
+int ipc_shm_ring_has_data(t_ipc_shm_ring* pRing);
+// Waits until a message is available or the timeout expires. Returns 1 if there is data to read.
+int ipc_shm_ring_wait(t_ipc_shm_ring* pRing, int iTimeoutMicros);
+
+#ifdef __cplusplus
+}
+#endif
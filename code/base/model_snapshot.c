@@ -0,0 +1,378 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include "model_snapshot.h"
+
+#define MODEL_SNAPSHOT_INIT_NONE 0
+#define MODEL_SNAPSHOT_INIT_IN_PROGRESS 1
+#define MODEL_SNAPSHOT_INIT_DONE 2
+
+#define MODEL_SNAPSHOT_SHM_MAGIC 0x4D534D52
+#define MODEL_SNAPSHOT_READ_RETRIES 8
+// A writer can't hold the lock longer than this, unless it died while holding it
+#define MODEL_SNAPSHOT_MAX_LOCK_WAIT_MS 200
+
+typedef struct
+{
+   u32 uMagic;
+   u32 uInitState;
+   u32 uWriteLock;
+   u32 uCountPublished;
+   u8  uPadding1[48];
+
+   u32 uSequence; // Futex word. Odd while a write is in progress
+   u32 uWaitersCount;
+   u8  uPadding2[56];
+
+   t_model_snapshot snapshot;
+} t_model_snapshot_shm;
+
+static t_model_snapshot_shm* s_pModelSnapshotShm = NULL;
+static int s_iModelSnapshotOpenFailed = 0;
+
+static void _model_snapshot_init_shm(t_model_snapshot_shm* pShm)
+{
+   u32 uState = __atomic_load_n(&pShm->uInitState, __ATOMIC_ACQUIRE);
+   if ( (MODEL_SNAPSHOT_INIT_DONE == uState) && (pShm->uMagic == MODEL_SNAPSHOT_SHM_MAGIC) )
+      return;
+
+   uState = MODEL_SNAPSHOT_INIT_NONE;
+   if ( __atomic_compare_exchange_n(&pShm->uInitState, &uState, MODEL_SNAPSHOT_INIT_IN_PROGRESS, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) )
+   {
+      pShm->uWriteLock = 0;
+      pShm->uCountPublished = 0;
+      pShm->uSequence = 0;
+      pShm->uWaitersCount = 0;
+      memset(&pShm->snapshot.header, 0, sizeof(t_model_snapshot_header));
+      pShm->uMagic = MODEL_SNAPSHOT_SHM_MAGIC;
+      __atomic_store_n(&pShm->uInitState, MODEL_SNAPSHOT_INIT_DONE, __ATOMIC_RELEASE);
+      return;
+   }
+
+   // Other process is initializing it
+   for( int i=0; i<1000; i++ )
+   {
+      if ( MODEL_SNAPSHOT_INIT_DONE == __atomic_load_n(&pShm->uInitState, __ATOMIC_ACQUIRE) )
+         return;
+      hardware_sleep_micros(100);
+   }
+}
+
+static t_model_snapshot_shm* _model_snapshot_get_shm()
+{
+   if ( NULL != s_pModelSnapshotShm )
+      return s_pModelSnapshotShm;
+   if ( s_iModelSnapshotOpenFailed )
+      return NULL;
+
+   int fd = shm_open(SHARED_MEM_MODEL_SNAPSHOT, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+   if ( fd < 0 )
+   {
+      log_softerror_and_alarm("[ModelSnapshot] Failed to open shared memory %s, error: %s", SHARED_MEM_MODEL_SNAPSHOT, strerror(errno));
+      s_iModelSnapshotOpenFailed = 1;
+      return NULL;
+   }
+   struct stat st;
+   if ( (0 != fstat(fd, &st)) || (st.st_size < (off_t)sizeof(t_model_snapshot_shm)) )
+   if ( ftruncate(fd, sizeof(t_model_snapshot_shm)) == -1 )
+   {
+      log_softerror_and_alarm("[ModelSnapshot] Failed to init (ftruncate) shared memory %s", SHARED_MEM_MODEL_SNAPSHOT);
+      close(fd);
+      s_iModelSnapshotOpenFailed = 1;
+      return NULL;
+   }
+   void* pMem = mmap(NULL, sizeof(t_model_snapshot_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if ( pMem == MAP_FAILED )
+   {
+      log_softerror_and_alarm("[ModelSnapshot] Failed to map shared memory %s", SHARED_MEM_MODEL_SNAPSHOT);
+      s_iModelSnapshotOpenFailed = 1;
+      return NULL;
+   }
+   s_pModelSnapshotShm = (t_model_snapshot_shm*)pMem;
+   _model_snapshot_init_shm(s_pModelSnapshotShm);
+   return s_pModelSnapshotShm;
+}
+
+static void _model_snapshot_lock(t_model_snapshot_shm* pShm)
+{
+   u32 uTimeStart = 0;
+   int iSpins = 0;
+   while ( __atomic_exchange_n(&pShm->uWriteLock, 1, __ATOMIC_ACQUIRE) )
+   {
+      iSpins++;
+      if ( iSpins < 100 )
+      {
+         sched_yield();
+         continue;
+      }
+      if ( 0 == uTimeStart )
+         uTimeStart = get_current_timestamp_ms();
+      else if ( get_current_timestamp_ms() > uTimeStart + MODEL_SNAPSHOT_MAX_LOCK_WAIT_MS )
+      {
+         log_softerror_and_alarm("[ModelSnapshot] Write lock held for more than %d ms. Taking it over.", MODEL_SNAPSHOT_MAX_LOCK_WAIT_MS);
+         // The previous writer died in the middle of a write: make the sequence even again
+         u32 uSeq = __atomic_load_n(&pShm->uSequence, __ATOMIC_ACQUIRE);
+         if ( uSeq & 1 )
+         {
+            pShm->snapshot.header.uMagic = 0;
+            __atomic_store_n(&pShm->uSequence, uSeq+1, __ATOMIC_RELEASE);
+         }
+         return;
+      }
+      hardware_sleep_micros(500);
+   }
+}
+
+static void _model_snapshot_unlock_and_notify(t_model_snapshot_shm* pShm)
+{
+   __atomic_store_n(&pShm->uWriteLock, 0, __ATOMIC_RELEASE);
+   if ( __atomic_load_n(&pShm->uWaitersCount, __ATOMIC_SEQ_CST) > 0 )
+      syscall(SYS_futex, &pShm->uSequence, FUTEX_WAKE, 0x7FFFFFFF, NULL, NULL, 0);
+}
+
+static u32 _model_snapshot_compute_header_crc(const t_model_snapshot_header* pHeader)
+{
+   return base_compute_crc32((u8*)pHeader, (int)(sizeof(t_model_snapshot_header) - sizeof(u32)));
+}
+
+u32 model_snapshot_compute_layout_hash(const t_model_snapshot_section_source* pSections, int iCount)
+{
+   u32 uLayout[2*MODEL_SNAPSHOT_MAX_SECTIONS+1];
+   int iWords = 0;
+   uLayout[iWords++] = MODEL_SNAPSHOT_VERSION;
+   for( int i=0; (i<iCount) && (i<MODEL_SNAPSHOT_MAX_SECTIONS); i++ )
+   {
+      uLayout[iWords++] = pSections[i].uId;
+      uLayout[iWords++] = pSections[i].uSize;
+   }
+   return base_compute_crc32((u8*)uLayout, iWords * (int)sizeof(u32));
+}
+
+int model_snapshot_publish(const char* szSourceFile, u32 uSaveCount, u32 uLayoutHash, const t_model_snapshot_section_source* pSections, int iCount)
+{
+   if ( (NULL == szSourceFile) || (NULL == pSections) || (iCount <= 0) || (iCount > MODEL_SNAPSHOT_MAX_SECTIONS) )
+      return 0;
+   if ( strlen(szSourceFile) >= MAX_FILE_PATH_SIZE )
+      return 0;
+
+   u32 uDataSize = 0;
+   for( int i=0; i<iCount; i++ )
+      uDataSize += (pSections[i].uSize + 3) & (~(u32)3);
+   if ( uDataSize > MODEL_SNAPSHOT_MAX_DATA_SIZE )
+   {
+      log_softerror_and_alarm("[ModelSnapshot] Model too big for snapshot (%u bytes, max %d).", uDataSize, MODEL_SNAPSHOT_MAX_DATA_SIZE);
+      return 0;
+   }
+
+   t_model_snapshot_shm* pShm = _model_snapshot_get_shm();
+   if ( NULL == pShm )
+      return 0;
+
+   struct stat st;
+   if ( 0 != stat(szSourceFile, &st) )
+   {
+      model_snapshot_invalidate();
+      return 0;
+   }
+
+   _model_snapshot_lock(pShm);
+   u32 uSeq = __atomic_load_n(&pShm->uSequence, __ATOMIC_ACQUIRE);
+   __atomic_store_n(&pShm->uSequence, uSeq+1, __ATOMIC_RELEASE);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   t_model_snapshot* pSnapshot = &pShm->snapshot;
+   t_model_snapshot_header* pHeader = &pSnapshot->header;
+   memset(pHeader, 0, sizeof(t_model_snapshot_header));
+   pHeader->uMagic = MODEL_SNAPSHOT_MAGIC;
+   pHeader->uVersion = MODEL_SNAPSHOT_VERSION;
+   pHeader->uLayoutHash = uLayoutHash;
+   pHeader->uSaveCount = uSaveCount;
+   pHeader->uSectionsCount = (u32)iCount;
+   pHeader->uSourceFileSize = (u32)st.st_size;
+   pHeader->uSourceFileInode = (u32)st.st_ino;
+   pHeader->uSourceFileTimeSec = (u32)st.st_mtim.tv_sec;
+   pHeader->uSourceFileTimeNsec = (u32)st.st_mtim.tv_nsec;
+   strcpy(pHeader->szSourceFile, szSourceFile);
+
+   u32 uOffset = 0;
+   for( int i=0; i<iCount; i++ )
+   {
+      pHeader->sections[i].uId = pSections[i].uId;
+      pHeader->sections[i].uOffset = uOffset;
+      pHeader->sections[i].uSize = pSections[i].uSize;
+      memcpy(&pSnapshot->uData[uOffset], pSections[i].pData, pSections[i].uSize);
+      pHeader->sections[i].uCRC = base_compute_crc32(&pSnapshot->uData[uOffset], (int)pSections[i].uSize);
+      uOffset += (pSections[i].uSize + 3) & (~(u32)3);
+   }
+   pHeader->uDataSize = uOffset;
+   pHeader->uHeaderCRC = _model_snapshot_compute_header_crc(pHeader);
+   pShm->uCountPublished++;
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   __atomic_store_n(&pShm->uSequence, uSeq+2, __ATOMIC_RELEASE);
+   _model_snapshot_unlock_and_notify(pShm);
+   return 1;
+}
+
+void model_snapshot_invalidate()
+{
+   t_model_snapshot_shm* pShm = _model_snapshot_get_shm();
+   if ( NULL == pShm )
+      return;
+   _model_snapshot_lock(pShm);
+   u32 uSeq = __atomic_load_n(&pShm->uSequence, __ATOMIC_ACQUIRE);
+   __atomic_store_n(&pShm->uSequence, uSeq+1, __ATOMIC_RELEASE);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   pShm->snapshot.header.uMagic = 0;
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   __atomic_store_n(&pShm->uSequence, uSeq+2, __ATOMIC_RELEASE);
+   _model_snapshot_unlock_and_notify(pShm);
+}
+
+int model_snapshot_read(const char* szSourceFile, u32 uLayoutHash, t_model_snapshot* pOutput)
+{
+   if ( (NULL == szSourceFile) || (NULL == pOutput) )
+      return 0;
+   t_model_snapshot_shm* pShm = _model_snapshot_get_shm();
+   if ( NULL == pShm )
+      return 0;
+
+   t_model_snapshot_header* pHeader = &pOutput->header;
+   int bConsistent = 0;
+   for( int iTry=0; iTry<MODEL_SNAPSHOT_READ_RETRIES; iTry++ )
+   {
+      u32 uSeq1 = __atomic_load_n(&pShm->uSequence, __ATOMIC_ACQUIRE);
+      if ( uSeq1 & 1 )
+      {
+         sched_yield();
+         continue;
+      }
+      memcpy(pHeader, &pShm->snapshot.header, sizeof(t_model_snapshot_header));
+      u32 uDataSize = pHeader->uDataSize;
+      if ( uDataSize > MODEL_SNAPSHOT_MAX_DATA_SIZE )
+         uDataSize = MODEL_SNAPSHOT_MAX_DATA_SIZE;
+      if ( pHeader->uMagic == MODEL_SNAPSHOT_MAGIC )
+         memcpy(pOutput->uData, pShm->snapshot.uData, uDataSize);
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if ( uSeq1 == __atomic_load_n(&pShm->uSequence, __ATOMIC_ACQUIRE) )
+      {
+         bConsistent = 1;
+         break;
+      }
+   }
+   if ( ! bConsistent )
+      return 0;
+
+   if ( (pHeader->uMagic != MODEL_SNAPSHOT_MAGIC) || (pHeader->uVersion != MODEL_SNAPSHOT_VERSION) )
+      return 0;
+   if ( pHeader->uHeaderCRC != _model_snapshot_compute_header_crc(pHeader) )
+   {
+      log_softerror_and_alarm("[ModelSnapshot] Invalid snapshot header CRC.");
+      return 0;
+   }
+   if ( pHeader->uLayoutHash != uLayoutHash )
+      return 0;
+   if ( (pHeader->uDataSize > MODEL_SNAPSHOT_MAX_DATA_SIZE) || (pHeader->uSectionsCount > MODEL_SNAPSHOT_MAX_SECTIONS) )
+      return 0;
+   pHeader->szSourceFile[MAX_FILE_PATH_SIZE-1] = 0;
+   if ( 0 != strcmp(pHeader->szSourceFile, szSourceFile) )
+      return 0;
+
+   // The file must be the one the snapshot was published for
+   struct stat st;
+   if ( 0 != stat(szSourceFile, &st) )
+      return 0;
+   if ( (pHeader->uSourceFileSize != (u32)st.st_size) || (pHeader->uSourceFileInode != (u32)st.st_ino) ||
+        (pHeader->uSourceFileTimeSec != (u32)st.st_mtim.tv_sec) || (pHeader->uSourceFileTimeNsec != (u32)st.st_mtim.tv_nsec) )
+      return 0;
+   return 1;
+}
+
+const u8* model_snapshot_get_section(const t_model_snapshot* pSnapshot, u32 uId, u32 uSize)
+{
+   if ( NULL == pSnapshot )
+      return NULL;
+   const t_model_snapshot_header* pHeader = &pSnapshot->header;
+   for( u32 i=0; (i<pHeader->uSectionsCount) && (i<MODEL_SNAPSHOT_MAX_SECTIONS); i++ )
+   {
+      const t_model_snapshot_section* pSection = &pHeader->sections[i];
+      if ( pSection->uId != uId )
+         continue;
+      if ( pSection->uSize != uSize )
+         return NULL;
+      if ( (pSection->uOffset > pHeader->uDataSize) || (pSection->uSize > pHeader->uDataSize - pSection->uOffset) )
+         return NULL;
+      if ( pSection->uCRC != base_compute_crc32((u8*)&pSnapshot->uData[pSection->uOffset], (int)pSection->uSize) )
+      {
+         log_softerror_and_alarm("[ModelSnapshot] Invalid CRC for section %u.", uId);
+         return NULL;
+      }
+      return &pSnapshot->uData[pSection->uOffset];
+   }
+   return NULL;
+}
+
+u32 model_snapshot_get_generation()
+{
+   t_model_snapshot_shm* pShm = _model_snapshot_get_shm();
+   if ( NULL == pShm )
+      return 0;
+   return __atomic_load_n(&pShm->uSequence, __ATOMIC_ACQUIRE);
+}
+
+int model_snapshot_wait_for_change(u32 uLastGeneration, int iTimeoutMs)
+{
+   t_model_snapshot_shm* pShm = _model_snapshot_get_shm();
+   if ( NULL == pShm )
+      return 0;
+   if ( __atomic_load_n(&pShm->uSequence, __ATOMIC_ACQUIRE) != uLastGeneration )
+      return 1;
+   if ( iTimeoutMs <= 0 )
+      return 0;
+
+   __atomic_add_fetch(&pShm->uWaitersCount, 1, __ATOMIC_SEQ_CST);
+   struct timespec ts;
+   ts.tv_sec = iTimeoutMs / 1000;
+   ts.tv_nsec = (iTimeoutMs % 1000) * 1000000;
+   // Returns right away if the sequence is no longer uLastGeneration
+   syscall(SYS_futex, &pShm->uSequence, FUTEX_WAIT, uLastGeneration, &ts, NULL, 0);
+   __atomic_sub_fetch(&pShm->uWaitersCount, 1, __ATOMIC_SEQ_CST);
+   return (__atomic_load_n(&pShm->uSequence, __ATOMIC_ACQUIRE) != uLastGeneration)?1:0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "base.h"
+#include "config.h"
+
+// Binary snapshot of the current vehicle model, shared by all the processes through shared memory.
+// A snapshot is a fixed header (source file identity, save counter, layout hash, sections table)
+// followed by the raw model sections; each section and the header have their own CRC.
+// It is published by Model::saveToFile (and after a text load), so the other processes can
+// pick up the model without parsing the text file. The text file stays the persistent storage.
+//
+// Writers serialize on a lock inside the segment; readers are lock free (sequence counter,
+// odd while a write is in progress). The sequence counter is also the futex word other
+// processes can wait on for change notifications.
+// A snapshot is only used if the source file was not changed since it was published
+// (same size, inode and modification time), otherwise callers fall back to the text file.
+
+#define SHARED_MEM_MODEL_SNAPSHOT "/SYSTEM_SHARED_MEM_RUBY_MODEL_SNAPSHOT"
+
+#define MODEL_SNAPSHOT_MAGIC 0x4C444D52
+#define MODEL_SNAPSHOT_VERSION 1
+#define MODEL_SNAPSHOT_MAX_SECTIONS 24
+#define MODEL_SNAPSHOT_MAX_DATA_SIZE (16*1024)
+
+typedef struct
+{
+   u32 uId;
+   u32 uOffset; // from the start of the data
+   u32 uSize;
+   u32 uCRC;
+} ALIGN_STRUCT_SPEC_INFO t_model_snapshot_section;
+
+typedef struct
+{
+   u32 uMagic;
+   u32 uVersion;
+   u32 uLayoutHash; // Hash of the sections ids and sizes, must match the reader's one
+   u32 uSaveCount;
+   u32 uSectionsCount;
+   u32 uDataSize;
+   u32 uSourceFileSize;
+   u32 uSourceFileInode;
+   u32 uSourceFileTimeSec;
+   u32 uSourceFileTimeNsec;
+   char szSourceFile[MAX_FILE_PATH_SIZE];
+   t_model_snapshot_section sections[MODEL_SNAPSHOT_MAX_SECTIONS];
+   u32 uHeaderCRC; // CRC of all the fields above
+} ALIGN_STRUCT_SPEC_INFO t_model_snapshot_header;
+
+typedef struct
+{
+   t_model_snapshot_header header;
+   u8 uData[MODEL_SNAPSHOT_MAX_DATA_SIZE];
+} ALIGN_STRUCT_SPEC_INFO t_model_snapshot;
+
+// Source of a section to publish
+typedef struct
+{
+   u32 uId;
+   const void* pData;
+   u32 uSize;
+} t_model_snapshot_section_source;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+u32 model_snapshot_compute_layout_hash(const t_model_snapshot_section_source* pSections, int iCount);
+
+// Returns 1 on success
+int model_snapshot_publish(const char* szSourceFile, u32 uSaveCount, u32 uLayoutHash, const t_model_snapshot_section_source* pSections, int iCount);
+// Marks the current snapshot as invalid (for writers that change the source file directly)
+void model_snapshot_invalidate();
+
+// Copies the current snapshot into pOutput and checks it. Returns 1 if there is a valid snapshot
+// for szSourceFile, with the same layout, and the file was not changed since it was published.
+int model_snapshot_read(const char* szSourceFile, u32 uLayoutHash, t_model_snapshot* pOutput);
+// Returns a pointer to the section data inside pSnapshot, or NULL if missing, of a different size or corrupted
+const u8* model_snapshot_get_section(const t_model_snapshot* pSnapshot, u32 uId, u32 uSize);
+
+// Change notification. The generation changes each time a snapshot is published or invalidated.
+u32 model_snapshot_get_generation();
+// Returns 1 if the generation is different from uLastGeneration, waiting for it at most iTimeoutMs
+int model_snapshot_wait_for_change(u32 uLastGeneration, int iTimeoutMs);
+
+#ifdef __cplusplus
+}
+#endif
@@ -35,12 +35,14 @@
 #include "models.h"
 #include <stdlib.h>
 #include <math.h>
+#include <sys/stat.h>
 #include "config.h"
 #include "ctrl_preferences.h"
 #include "hardware.h"
 #include "hardware_audio.h"
 #include "hardware_camera.h"
 #include "hw_procs.h"
+#include "hw_sys.h"
 #include "hardware_i2c.h"
 #include "camera_utils.h"
 #include "utils.h"
@@ -263,11 +265,206 @@ bool Model::isRunningOnRadxaHardware()
    return false;
 }
 
+#define MODEL_SNAPSHOT_SECTION_GENERAL 1
+#define MODEL_SNAPSHOT_SECTION_HW_CAPABILITIES 2
+#define MODEL_SNAPSHOT_SECTION_HW_INTERFACES 3
+#define MODEL_SNAPSHOT_SECTION_PROCESSES 4
+#define MODEL_SNAPSHOT_SECTION_RADIO_INTERFACES 5
+#define MODEL_SNAPSHOT_SECTION_RADIO_LINKS 6
+#define MODEL_SNAPSHOT_SECTION_STATS 7
+#define MODEL_SNAPSHOT_SECTION_CAMERAS 8
+#define MODEL_SNAPSHOT_SECTION_VIDEO 9
+#define MODEL_SNAPSHOT_SECTION_VIDEO_PROFILES 10
+#define MODEL_SNAPSHOT_SECTION_OSD 11
+#define MODEL_SNAPSHOT_SECTION_RC 12
+#define MODEL_SNAPSHOT_SECTION_TELEMETRY 13
+#define MODEL_SNAPSHOT_SECTION_AUDIO 14
+#define MODEL_SNAPSHOT_SECTION_FUNCTIONS 15
+#define MODEL_SNAPSHOT_SECTION_RELAY 16
+#define MODEL_SNAPSHOT_SECTION_ALARMS 17
+
+// Persistent scalar fields of the model (the ones saved in the model file)
+typedef struct
+{
+   u32 uModelFlags;
+   u32 uModelPersistentStatusFlags;
+   u32 uDeveloperFlags;
+   char vehicle_name[MAX_VEHICLE_NAME_LENGTH];
+   u32 uVehicleId;
+   u32 uControllerId;
+   u32 sw_version;
+   u8 is_spectator;
+   u8 vehicle_type;
+   u8 enableDHCP;
+   u8 uDummy;
+   int rxtx_sync_type;
+   u32 alarms;
+   int m_iRadioInterfacesGraphRefreshInterval;
+   u32 camera_rc_channels;
+   u32 enc_flags;
+   int iGPSCount;
+   int iCameraCount;
+   int iCurrentCamera;
+} ALIGN_STRUCT_SPEC_INFO t_model_snapshot_general;
+
+static bool _model_is_current_vehicle_model_file(const char* filename)
+{
+   char szFile[MAX_FILE_PATH_SIZE];
+   strcpy(szFile, FOLDER_CONFIG);
+   strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
+   return (NULL != filename) && (0 == strcmp(filename, szFile));
+}
+
+// pGeneral is filled in from the current model values. The other sections point to the model members.
+int Model::getSnapshotSections(t_model_snapshot_section_source* pSections, void* pGeneral)
+{
+   t_model_snapshot_general* pG = (t_model_snapshot_general*)pGeneral;
+   memset(pG, 0, sizeof(t_model_snapshot_general));
+   pG->uModelFlags = uModelFlags;
+   pG->uModelPersistentStatusFlags = uModelPersistentStatusFlags;
+   pG->uDeveloperFlags = uDeveloperFlags;
+   memcpy(pG->vehicle_name, vehicle_name, MAX_VEHICLE_NAME_LENGTH);
+   pG->uVehicleId = uVehicleId;
+   pG->uControllerId = uControllerId;
+   pG->sw_version = sw_version;
+   pG->is_spectator = is_spectator?1:0;
+   pG->vehicle_type = vehicle_type;
+   pG->enableDHCP = enableDHCP?1:0;
+   pG->rxtx_sync_type = rxtx_sync_type;
+   pG->alarms = alarms;
+   pG->m_iRadioInterfacesGraphRefreshInterval = m_iRadioInterfacesGraphRefreshInterval;
+   pG->camera_rc_channels = camera_rc_channels;
+   pG->enc_flags = enc_flags;
+   pG->iGPSCount = iGPSCount;
+   pG->iCameraCount = iCameraCount;
+   pG->iCurrentCamera = iCurrentCamera;
+
+   int iCount = 0;
+   #define MODEL_SNAPSHOT_ADD_SECTION(id, pSrc, uSrcSize) { pSections[iCount].uId = (id); pSections[iCount].pData = (pSrc); pSections[iCount].uSize = (uSrcSize); iCount++; }
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_GENERAL, pG, sizeof(t_model_snapshot_general));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_HW_CAPABILITIES, &hwCapabilities, sizeof(hwCapabilities));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_HW_INTERFACES, &hardwareInterfacesInfo, sizeof(hardwareInterfacesInfo));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_PROCESSES, &processesPriorities, sizeof(processesPriorities));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_RADIO_INTERFACES, &radioInterfacesParams, sizeof(radioInterfacesParams));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_RADIO_LINKS, &radioLinksParams, sizeof(radioLinksParams));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_STATS, &m_Stats, sizeof(m_Stats));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_CAMERAS, &camera_params[0], sizeof(camera_params));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_VIDEO, &video_params, sizeof(video_params));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_VIDEO_PROFILES, &video_link_profiles[0], sizeof(video_link_profiles));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_OSD, &osd_params, sizeof(osd_params));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_RC, &rc_params, sizeof(rc_params));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_TELEMETRY, &telemetry_params, sizeof(telemetry_params));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_AUDIO, &audio_params, sizeof(audio_params));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_FUNCTIONS, &functions_params, sizeof(functions_params));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_RELAY, &relay_params, sizeof(relay_params));
+   MODEL_SNAPSHOT_ADD_SECTION(MODEL_SNAPSHOT_SECTION_ALARMS, &alarms_params, sizeof(alarms_params));
+   #undef MODEL_SNAPSHOT_ADD_SECTION
+   return iCount;
+}
+
+bool Model::publishSnapshot(const char* filename)
+{
+   if ( ! _model_is_current_vehicle_model_file(filename) )
+      return false;
+
+   t_model_snapshot_section_source sections[MODEL_SNAPSHOT_MAX_SECTIONS];
+   t_model_snapshot_general general;
+   int iCount = getSnapshotSections(sections, &general);
+   u32 uLayoutHash = model_snapshot_compute_layout_hash(sections, iCount);
+   return model_snapshot_publish(filename, (u32)iSaveCount, uLayoutHash, sections, iCount)?true:false;
+}
+
+int Model::loadFromSnapshot(const char* filename, bool bLoadStats, bool bOnlyIfChanged)
+{
+   if ( ! _model_is_current_vehicle_model_file(filename) )
+      return -1;
+
+   u32 uTimeStart = get_current_timestamp_micros();
+   t_model_snapshot_section_source sections[MODEL_SNAPSHOT_MAX_SECTIONS];
+   t_model_snapshot_general general;
+   int iCount = getSnapshotSections(sections, &general);
+   u32 uLayoutHash = model_snapshot_compute_layout_hash(sections, iCount);
+
+   t_model_snapshot* pSnapshot = (t_model_snapshot*) malloc(sizeof(t_model_snapshot));
+   if ( NULL == pSnapshot )
+      return -1;
+   if ( ! model_snapshot_read(filename, uLayoutHash, pSnapshot) )
+   {
+      free(pSnapshot);
+      return -1;
+   }
+   if ( bOnlyIfChanged && ((int)pSnapshot->header.uSaveCount == iSaveCount) )
+   {
+      free(pSnapshot);
+      return 0;
+   }
+
+   // Check all the sections first, so that an invalid snapshot does not leave a half updated model
+   const u8* pSectionsData[MODEL_SNAPSHOT_MAX_SECTIONS];
+   for( int i=0; i<iCount; i++ )
+   {
+      pSectionsData[i] = model_snapshot_get_section(pSnapshot, sections[i].uId, sections[i].uSize);
+      if ( NULL == pSectionsData[i] )
+      {
+         free(pSnapshot);
+         return -1;
+      }
+   }
+
+   for( int i=0; i<iCount; i++ )
+   {
+      if ( sections[i].uId == MODEL_SNAPSHOT_SECTION_GENERAL )
+         memcpy((u8*)&general, pSectionsData[i], sizeof(t_model_snapshot_general));
+      else if ( (sections[i].uId == MODEL_SNAPSHOT_SECTION_STATS) && (! bLoadStats) )
+         continue;
+      else
+         memcpy((u8*)sections[i].pData, pSectionsData[i], sections[i].uSize);
+   }
+
+   uModelFlags = general.uModelFlags;
+   uModelPersistentStatusFlags = general.uModelPersistentStatusFlags;
+   uDeveloperFlags = general.uDeveloperFlags;
+   memcpy(vehicle_name, general.vehicle_name, MAX_VEHICLE_NAME_LENGTH);
+   vehicle_name[MAX_VEHICLE_NAME_LENGTH-1] = 0;
+   uVehicleId = general.uVehicleId;
+   uControllerId = general.uControllerId;
+   sw_version = general.sw_version;
+   is_spectator = general.is_spectator?true:false;
+   vehicle_type = general.vehicle_type;
+   enableDHCP = general.enableDHCP?true:false;
+   rxtx_sync_type = general.rxtx_sync_type;
+   alarms = general.alarms;
+   m_iRadioInterfacesGraphRefreshInterval = general.m_iRadioInterfacesGraphRefreshInterval;
+   camera_rc_channels = general.camera_rc_channels;
+   enc_flags = general.enc_flags;
+   iGPSCount = general.iGPSCount;
+   iCameraCount = general.iCameraCount;
+   iCurrentCamera = general.iCurrentCamera;
+
+   iSaveCount = (int)pSnapshot->header.uSaveCount;
+   iLoadedFileVersion = 10;
+   free(pSnapshot);
+
+   validate_settings();
+   constructLongName();
+
+   log_line("Loaded vehicle (%s) from model snapshot (%u us), save count: %d; name: [%s], VID: %u, %s",
+      bLoadStats?"with stats":"without stats", get_current_timestamp_micros() - uTimeStart, iSaveCount,
+      vehicle_name, uVehicleId, is_spectator?"spectator mode": "control mode");
+   return 1;
+}
+
 bool Model::reloadIfChanged(bool bLoadStats)
 {
    char szFile[MAX_FILE_PATH_SIZE];
    strcpy(szFile, FOLDER_CONFIG);
    strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
+
+   // Snapshot of the current model file: no file read needed
+   int iResult = loadFromSnapshot(szFile, bLoadStats, true);
+   if ( iResult >= 0 )
+      return true;
+
    FILE* fd = fopen(szFile, "r");
    if ( NULL == fd )
       return false;
@@ -299,6 +496,9 @@ bool Model::loadFromFile(const char* filename, bool bLoadStats)
    bool bMainFileLoadedOk = false;
    bool bBackupFileLoadedOk = false;
 
+   if ( 1 == loadFromSnapshot(filename, bLoadStats, false) )
+      return true;
+
    type_vehicle_stats_info stats;
    memcpy((u8*)&stats, (u8*)&m_Stats, sizeof(type_vehicle_stats_info));
 
@@ -352,6 +552,7 @@ bool Model::loadFromFile(const char* filename, bool bLoadStats)
          (sw_version >> 8) & 0xFF, sw_version & 0xFF, sw_version>>16,
          m_Stats.uCurrentOnTime/60, m_Stats.uCurrentOnTime%60);
       constructLongName();
+      publishSnapshot(filename);
       return true;
    }
 
@@ -405,6 +606,7 @@ bool Model::loadFromFile(const char* filename, bool bLoadStats)
       saveVersion10(fd, false);
       fclose(fd);
       log_line("Restored main model file from backup model file.");
+      publishSnapshot(filename);
    }
    else
       log_softerror_and_alarm("Failed to write main model file from backup model file.");
@@ -1112,15 +1314,17 @@ bool Model::saveToFile(const char* filename, bool isOnController)
 {
    iSaveCount++;
    char szBuff[128];
-   char szComm[256];
 
    //u32 timeStart = get_current_timestamp_ms();
 
    if ( isOnController )
    {
       sprintf(szBuff, FOLDER_VEHICLE_HISTORY, uVehicleId);
-      sprintf(szComm, "mkdir -p %s", szBuff);
-      hw_execute_bash_command_silent(szComm, NULL);
+      if ( access(szBuff, F_OK) == -1 )
+      {
+         if ( ! hw_sys_make_dirs(szBuff, 0777) )
+            log_softerror_and_alarm("Failed to create vehicle history folder: %s", szBuff);
+      }
    }
 
    for( int i=0; i<(int)strlen(vehicle_name); i++ )
@@ -1139,6 +1343,9 @@ bool Model::saveToFile(const char* filename, bool isOnController)
    fflush(fd);
    fclose(fd);
 
+   // The other processes pick up the saved model from the snapshot
+   publishSnapshot(filename);
+
    log_line("Saved vehicle successfully to file: %s; name: [%s], VID: %u, software: %d.%d (b%d), is on controller: %s, %s, on time: %02d:%02d",
          filename, vehicle_name, uVehicleId, (sw_version >> 8) & 0xFF, sw_version & 0xFF, sw_version>>16,
          isOnController?"yes":"no",
@@ -4,6 +4,7 @@
 #include "flags.h"
 #include "config_rc.h"
 #include "shared_mem.h"
+#include "model_snapshot.h"
 #include "../radio/radiopackets2.h"
 
 #define MODEL_TELEMETRY_TYPE_NONE 0
@@ -719,6 +720,12 @@ class Model
       void generateUID();
       bool loadVersion10(FILE* fd); // from 7.6
       bool saveVersion10(FILE* fd, bool isOnController); // from 7.6
+
+      // Binary snapshot in shared memory of the current vehicle model file (see model_snapshot.h)
+      int getSnapshotSections(t_model_snapshot_section_source* pSections, void* pGeneral);
+      // Returns 1 if loaded, 0 if skipped (bOnlyIfChanged and same save count), -1 if there is no valid snapshot for the file
+      int loadFromSnapshot(const char* filename, bool bLoadStats, bool bOnlyIfChanged);
+      bool publishSnapshot(const char* filename);
 };
 
 const char* model_getShortFlightMode(u8 mode);
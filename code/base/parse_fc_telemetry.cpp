@@ -138,6 +138,13 @@ mavlink_message_t msgMav;
 u32 s_vehicleMavId = 1;
 int s_iAllowAnyVehicleSysId = 0;
 
+// Carry-over buffer for the MAVLink frame scanner; holds at most one incomplete frame between reads
+#define MAVLINK_SCAN_BUFFER_SIZE 2048
+static u8 s_uMAVLinkScanBuffer[MAVLINK_SCAN_BUFFER_SIZE];
+static int s_iMAVLinkScanBufferLength = 0;
+static bool s_bMAVLinkScannerInSync = false;
+static bool s_bUseMAVLinkFrameScanner = true;
+
 
 void _rotate_point(float x, float y, float xCenter, float yCenter, float angle, float* px, float* py)
 {
@@ -172,6 +179,9 @@ void parse_telemetry_init(u32 vehicleMavId,  bool bShowLocalVerticalSpeed)
    
    s_iHeartbeatMsgCount = 0;
    s_iSystemMsgCount = 0;
+
+   s_iMAVLinkScanBufferLength = 0;
+   s_bMAVLinkScannerInSync = false;
 }
 
 void parse_telemetry_allow_any_sysid(int iAllow)
@@ -194,6 +204,16 @@ void parse_telemetry_force_always_armed(bool bForce)
    s_bTelemetryForceAlwaysArmed = bForce;
 }
 
+void parse_telemetry_use_mavlink_frame_scanner(bool bUse)
+{
+   if ( bUse == s_bUseMAVLinkFrameScanner )
+      return;
+   s_bUseMAVLinkFrameScanner = bUse;
+   s_iMAVLinkScanBufferLength = 0;
+   s_bMAVLinkScannerInSync = false;
+   log_line("[FCTelemetry] MAVLink parsing: %s", bUse?"frame scanner":"byte parser");
+}
+
 int* get_mavlink_rc_channels()
 {
    return s_MAVLinkRCChannels;
@@ -298,418 +318,577 @@ bool _check_add_fc_message(char* szMessage)
    return true;
 }
 
-void _process_mav_message(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+// Handlers for the MAVLink messages Ruby consumes. They decode from msgMav.
+
+static void _mav_handle_statustext(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
 {
-   char szBuff[512];
-   u32 tmp32;
-   u8 tmp8;
-   int tmpi;
-   int imah = 0;
-   //u32 uTmp32;
+   char szBuff[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN+1];
+   mavlink_msg_statustext_get_text(&msgMav, szBuff);
+   szBuff[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN] = 0;
+   if ( _check_add_fc_message(szBuff) )
+      log_line("MAV status text: %s", szBuff);
+}
 
-   if ( 0 == s_iAllowAnyVehicleSysId )
-   if ( (msgMav.sysid != s_vehicleMavId) && (msgMav.sysid != 0) )
-      return;
+static void _mav_handle_statustext_long(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   char szBuff[MAVLINK_MSG_STATUSTEXT_LONG_FIELD_TEXT_LEN+1];
+   mavlink_msg_statustext_long_get_text(&msgMav, szBuff);
+   szBuff[MAVLINK_MSG_STATUSTEXT_LONG_FIELD_TEXT_LEN] = 0;
+   if ( _check_add_fc_message(szBuff) )
+      log_line("MAV status text long: %s", szBuff);
+}
 
-   switch (msgMav.msgid)
-   { 
-      case MAVLINK_MSG_ID_STATUSTEXT:
-         mavlink_msg_statustext_get_text(&msgMav, szBuff);
-         if ( _check_add_fc_message(szBuff) )
-            log_line("MAV status text: %s", szBuff);
+static void _mav_handle_heartbeat(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   u32 tmp32 = mavlink_msg_heartbeat_get_custom_mode(&msgMav);
+   u8 tmp8 = mavlink_msg_heartbeat_get_base_mode(&msgMav);
+   pdpfct->flight_mode = 0;
+   /*
+   switch ( tmp8 )
+   {
+      case 0: 
+      case 64:
+      case 66:
+      case 81:
+      case 88:
+      case 92:
+         pdpfct->flight_mode &= ~FLIGHT_MODE_ARMED; //disarmed
          break;
 
-      case MAVLINK_MSG_ID_STATUSTEXT_LONG:
-         mavlink_msg_statustext_long_get_text(&msgMav, szBuff);
-         if ( _check_add_fc_message(szBuff) )
-            log_line("MAV status text long: %s", szBuff);
+      case 1:
+      case 192:
+      case 194:
+      case 208:
+      case 209:
+      case 216:
+      case 220:
+         pdpfct->flight_mode |= FLIGHT_MODE_ARMED;
          break;
 
-      case MAVLINK_MSG_ID_HEARTBEAT:
-         tmp32 = mavlink_msg_heartbeat_get_custom_mode(&msgMav);
-         tmp8 = mavlink_msg_heartbeat_get_base_mode(&msgMav);
-         pdpfct->flight_mode = 0;
-         /*
-         switch ( tmp8 )
-         {
-            case 0: 
-            case 64:
-            case 66:
-            case 81:
-            case 88:
-            case 92:
-               pdpfct->flight_mode &= ~FLIGHT_MODE_ARMED; //disarmed
-               break;
-
-            case 1:
-            case 192:
-            case 194:
-            case 208:
-            case 209:
-            case 216:
-            case 220:
-               pdpfct->flight_mode |= FLIGHT_MODE_ARMED;
-               break;
-
-            default:
-               if ( tmp8 > 100 )
-                  pdpfct->flight_mode |= FLIGHT_MODE_ARMED;
-               else if ( tmp8 < 100 )
-                  pdpfct->flight_mode &= ~FLIGHT_MODE_ARMED;
-               break;
-         };
-         */
-         if ( tmp8 & MAV_MODE_FLAG_SAFETY_ARMED )
+      default:
+         if ( tmp8 > 100 )
             pdpfct->flight_mode |= FLIGHT_MODE_ARMED;
-         else
+         else if ( tmp8 < 100 )
             pdpfct->flight_mode &= ~FLIGHT_MODE_ARMED;
+         break;
+   };
+   */
+   if ( tmp8 & MAV_MODE_FLAG_SAFETY_ARMED )
+      pdpfct->flight_mode |= FLIGHT_MODE_ARMED;
+   else
+      pdpfct->flight_mode &= ~FLIGHT_MODE_ARMED;
 
-         if ( s_bTelemetryForceAlwaysArmed )
-            pdpfct->flight_mode |= FLIGHT_MODE_ARMED;
+   if ( s_bTelemetryForceAlwaysArmed )
+      pdpfct->flight_mode |= FLIGHT_MODE_ARMED;
 
-         if ( (vehicleType & MODEL_TYPE_MASK) == MODEL_TYPE_AIRPLANE )
-         {
-         //log_line("plane tmp32: %u", tmp32);
-         switch ( tmp32 )
-         {
-            case PLANE_MODE_MANUAL: pdpfct->flight_mode |= FLIGHT_MODE_MANUAL; break;
-            case PLANE_MODE_CIRCLE: pdpfct->flight_mode |= FLIGHT_MODE_CIRCLE; break;
-            case PLANE_MODE_STABILIZE: pdpfct->flight_mode |= FLIGHT_MODE_STAB; break;
-            case PLANE_MODE_FLY_BY_WIRE_A: pdpfct->flight_mode |= FLIGHT_MODE_FBWA; break;
-            case PLANE_MODE_FLY_BY_WIRE_B: pdpfct->flight_mode |= FLIGHT_MODE_FBWB; break;
-            case PLANE_MODE_ACRO: pdpfct->flight_mode |= FLIGHT_MODE_ACRO; break;
-            case PLANE_MODE_AUTO: pdpfct->flight_mode |= FLIGHT_MODE_AUTO; break;
-            case PLANE_MODE_AUTOTUNE: pdpfct->flight_mode |= FLIGHT_MODE_AUTOTUNE; break;
-            case PLANE_MODE_RTL: pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
-            case PLANE_MODE_LOITER: pdpfct->flight_mode |= FLIGHT_MODE_LOITER; break;
-            case PLANE_MODE_TAKEOFF: pdpfct->flight_mode |= FLIGHT_MODE_TAKEOFF; break;
-            case PLANE_MODE_CRUISE: pdpfct->flight_mode |= FLIGHT_MODE_CRUISE; break;
-            case PLANE_MODE_QSTABILIZE: pdpfct->flight_mode |= FLIGHT_MODE_QSTAB; break;
-            case PLANE_MODE_QHOVER: pdpfct->flight_mode |= FLIGHT_MODE_QHOVER; break;
-            case PLANE_MODE_QLOITER: pdpfct->flight_mode |= FLIGHT_MODE_QLOITER; break;
-            case PLANE_MODE_QLAND: pdpfct->flight_mode |= FLIGHT_MODE_QLAND; break;
-            case PLANE_MODE_QRTL: pdpfct->flight_mode |= FLIGHT_MODE_QRTL; break;
-         };
-         }
-         else if ( (vehicleType & MODEL_TYPE_MASK) == MODEL_TYPE_CAR )
-         {
-         switch ( tmp32 )
-         {
-            case ROVER_MODE_MANUAL: pdpfct->flight_mode |= FLIGHT_MODE_MANUAL; break;
-            case ROVER_MODE_ACRO:   pdpfct->flight_mode |= FLIGHT_MODE_ACRO; break;
-            case ROVER_MODE_STEERING: pdpfct->flight_mode |= FLIGHT_MODE_STAB; break;
-            case ROVER_MODE_HOLD:   pdpfct->flight_mode |= FLIGHT_MODE_POSHOLD; break;
-            case ROVER_MODE_LOITER: pdpfct->flight_mode |= FLIGHT_MODE_LOITER; break;
-            case ROVER_MODE_RTL:    pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
-            case ROVER_MODE_SMART_RTL: pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
-         };
-         }
-         else
-         {
-         //log_line("drone tmp32: %u", tmp32);
-         switch ( tmp32 )
-         {
-            case COPTER_MODE_STABILIZE: pdpfct->flight_mode |= FLIGHT_MODE_STAB; break;
-            case COPTER_MODE_ALT_HOLD: pdpfct->flight_mode |= FLIGHT_MODE_ALTH; break;
-            case COPTER_MODE_LOITER: pdpfct->flight_mode |= FLIGHT_MODE_LOITER; break;
-            case COPTER_MODE_AUTO: pdpfct->flight_mode |= FLIGHT_MODE_AUTO; break;
-            case COPTER_MODE_LAND: pdpfct->flight_mode |= FLIGHT_MODE_LAND; break;
-            case COPTER_MODE_RTL: pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
-            case COPTER_MODE_SMART_RTL: pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
-            case COPTER_MODE_AUTOTUNE: pdpfct->flight_mode |= FLIGHT_MODE_AUTOTUNE; break;
-            case COPTER_MODE_POSHOLD: pdpfct->flight_mode |= FLIGHT_MODE_POSHOLD; break;
-            case COPTER_MODE_ACRO: pdpfct->flight_mode |= FLIGHT_MODE_ACRO; break;
-            case COPTER_MODE_CIRCLE: pdpfct->flight_mode |= FLIGHT_MODE_CIRCLE; break;
-         };
-         }
-         if ( pdpfct->flight_mode & FLIGHT_MODE_ARMED )
-            pdpfct->uFCFlags |= FC_TELE_FLAGS_ARMED;
-         else
-            pdpfct->uFCFlags &= ~FC_TELE_FLAGS_ARMED;
+   if ( (vehicleType & MODEL_TYPE_MASK) == MODEL_TYPE_AIRPLANE )
+   {
+   //log_line("plane tmp32: %u", tmp32);
+   switch ( tmp32 )
+   {
+      case PLANE_MODE_MANUAL: pdpfct->flight_mode |= FLIGHT_MODE_MANUAL; break;
+      case PLANE_MODE_CIRCLE: pdpfct->flight_mode |= FLIGHT_MODE_CIRCLE; break;
+      case PLANE_MODE_STABILIZE: pdpfct->flight_mode |= FLIGHT_MODE_STAB; break;
+      case PLANE_MODE_FLY_BY_WIRE_A: pdpfct->flight_mode |= FLIGHT_MODE_FBWA; break;
+      case PLANE_MODE_FLY_BY_WIRE_B: pdpfct->flight_mode |= FLIGHT_MODE_FBWB; break;
+      case PLANE_MODE_ACRO: pdpfct->flight_mode |= FLIGHT_MODE_ACRO; break;
+      case PLANE_MODE_AUTO: pdpfct->flight_mode |= FLIGHT_MODE_AUTO; break;
+      case PLANE_MODE_AUTOTUNE: pdpfct->flight_mode |= FLIGHT_MODE_AUTOTUNE; break;
+      case PLANE_MODE_RTL: pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
+      case PLANE_MODE_LOITER: pdpfct->flight_mode |= FLIGHT_MODE_LOITER; break;
+      case PLANE_MODE_TAKEOFF: pdpfct->flight_mode |= FLIGHT_MODE_TAKEOFF; break;
+      case PLANE_MODE_CRUISE: pdpfct->flight_mode |= FLIGHT_MODE_CRUISE; break;
+      case PLANE_MODE_QSTABILIZE: pdpfct->flight_mode |= FLIGHT_MODE_QSTAB; break;
+      case PLANE_MODE_QHOVER: pdpfct->flight_mode |= FLIGHT_MODE_QHOVER; break;
+      case PLANE_MODE_QLOITER: pdpfct->flight_mode |= FLIGHT_MODE_QLOITER; break;
+      case PLANE_MODE_QLAND: pdpfct->flight_mode |= FLIGHT_MODE_QLAND; break;
+      case PLANE_MODE_QRTL: pdpfct->flight_mode |= FLIGHT_MODE_QRTL; break;
+   };
+   }
+   else if ( (vehicleType & MODEL_TYPE_MASK) == MODEL_TYPE_CAR )
+   {
+   switch ( tmp32 )
+   {
+      case ROVER_MODE_MANUAL: pdpfct->flight_mode |= FLIGHT_MODE_MANUAL; break;
+      case ROVER_MODE_ACRO:   pdpfct->flight_mode |= FLIGHT_MODE_ACRO; break;
+      case ROVER_MODE_STEERING: pdpfct->flight_mode |= FLIGHT_MODE_STAB; break;
+      case ROVER_MODE_HOLD:   pdpfct->flight_mode |= FLIGHT_MODE_POSHOLD; break;
+      case ROVER_MODE_LOITER: pdpfct->flight_mode |= FLIGHT_MODE_LOITER; break;
+      case ROVER_MODE_RTL:    pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
+      case ROVER_MODE_SMART_RTL: pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
+   };
+   }
+   else
+   {
+   //log_line("drone tmp32: %u", tmp32);
+   switch ( tmp32 )
+   {
+      case COPTER_MODE_STABILIZE: pdpfct->flight_mode |= FLIGHT_MODE_STAB; break;
+      case COPTER_MODE_ALT_HOLD: pdpfct->flight_mode |= FLIGHT_MODE_ALTH; break;
+      case COPTER_MODE_LOITER: pdpfct->flight_mode |= FLIGHT_MODE_LOITER; break;
+      case COPTER_MODE_AUTO: pdpfct->flight_mode |= FLIGHT_MODE_AUTO; break;
+      case COPTER_MODE_LAND: pdpfct->flight_mode |= FLIGHT_MODE_LAND; break;
+      case COPTER_MODE_RTL: pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
+      case COPTER_MODE_SMART_RTL: pdpfct->flight_mode |= FLIGHT_MODE_RTL; break;
+      case COPTER_MODE_AUTOTUNE: pdpfct->flight_mode |= FLIGHT_MODE_AUTOTUNE; break;
+      case COPTER_MODE_POSHOLD: pdpfct->flight_mode |= FLIGHT_MODE_POSHOLD; break;
+      case COPTER_MODE_ACRO: pdpfct->flight_mode |= FLIGHT_MODE_ACRO; break;
+      case COPTER_MODE_CIRCLE: pdpfct->flight_mode |= FLIGHT_MODE_CIRCLE; break;
+   };
+   }
+   if ( pdpfct->flight_mode & FLIGHT_MODE_ARMED )
+      pdpfct->uFCFlags |= FC_TELE_FLAGS_ARMED;
+   else
+      pdpfct->uFCFlags &= ~FC_TELE_FLAGS_ARMED;
 
-         if ( s_bTelemetryForceAlwaysArmed )
-            pdpfct->flight_mode |= FLIGHT_MODE_ARMED;
+   if ( s_bTelemetryForceAlwaysArmed )
+      pdpfct->flight_mode |= FLIGHT_MODE_ARMED;
 
-         s_bHasReceivedHeartbeat = true;
-         s_iHeartbeatMsgCount++;
-         break;
+   s_bHasReceivedHeartbeat = true;
+   s_iHeartbeatMsgCount++;
+}
 
-      case MAVLINK_MSG_ID_BATTERY_STATUS:
-         imah = mavlink_msg_battery_status_get_current_consumed(&msgMav);
-         pdpfct->mah = (imah<0)?0:imah;
-         break;
+static void _mav_handle_battery_status(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   int imah = mavlink_msg_battery_status_get_current_consumed(&msgMav);
+   pdpfct->mah = (imah<0)?0:imah;
+}
 
-      case MAVLINK_MSG_ID_SYS_STATUS:
-         imah = mavlink_msg_sys_status_get_current_battery(&msgMav);
-         pdpfct->voltage = mavlink_msg_sys_status_get_voltage_battery(&msgMav);
-         pdpfct->current = (imah<0)?0:(imah*10U);
-         s_iSystemMsgCount++;
-         break;
-      
-      case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
-         pdpfct->altitude_abs = mavlink_msg_global_position_int_get_alt(&msgMav) / 10.0f + 100000;
-         pdpfct->altitude = mavlink_msg_global_position_int_get_relative_alt(&msgMav) / 10.0f + 100000;
-         //log_line("alt: %f, abs: %f", ((int)pdpfct->altitude-100000)/100.0, ((int)pdpfct->altitude_abs-100000)/100.0);
+static void _mav_handle_sys_status(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   int imah = mavlink_msg_sys_status_get_current_battery(&msgMav);
+   pdpfct->voltage = mavlink_msg_sys_status_get_voltage_battery(&msgMav);
+   pdpfct->current = (imah<0)?0:(imah*10U);
+   s_iSystemMsgCount++;
+}
+
+static void _mav_handle_global_position_int(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   pdpfct->altitude_abs = mavlink_msg_global_position_int_get_alt(&msgMav) / 10.0f + 100000;
+   pdpfct->altitude = mavlink_msg_global_position_int_get_relative_alt(&msgMav) / 10.0f + 100000;
+   //log_line("alt: %f, abs: %f", ((int)pdpfct->altitude-100000)/100.0, ((int)pdpfct->altitude_abs-100000)/100.0);
+   if ( s_bShowLocalVerticalSpeed )
+   {
+      if ( s_TimeLastMAVLink_Altitude == 0 )
+      {
+         s_TimeLastMAVLink_Altitude = get_current_timestamp_ms();
+         s_LastMAVLink_Altitude = ((long)pdpfct->altitude) - 100000;
+         pdpfct->vspeed = 100000;
+      }
+      else
+      {
+         long alt = ((long)pdpfct->altitude) - 100000;
+         if ( get_current_timestamp_ms() > s_TimeLastMAVLink_Altitude )
          {
-            if ( s_bShowLocalVerticalSpeed )
-            {
-               if ( s_TimeLastMAVLink_Altitude == 0 )
-               {
-                  s_TimeLastMAVLink_Altitude = get_current_timestamp_ms();
-                  s_LastMAVLink_Altitude = ((long)pdpfct->altitude) - 100000;
-                  pdpfct->vspeed = 100000;
-               }
-               else
-               {
-                  long alt = ((long)pdpfct->altitude) - 100000;
-                  if ( get_current_timestamp_ms() > s_TimeLastMAVLink_Altitude )
-                  {
-                     long dTime = get_current_timestamp_ms() - s_TimeLastMAVLink_Altitude; 
-                     float vspeed = (float)(alt - s_LastMAVLink_Altitude)*1000.0/(float)dTime;
-                     //log_line("alt: %d - %d, %d, %f, dt: %d", alt, s_LastMAVLink_Altitude, (long)vspeed, vspeed, dTime);
-                     pdpfct->vspeed = (u32)(vspeed + 100000);
-                  }
-                  s_TimeLastMAVLink_Altitude = get_current_timestamp_ms();
-                  s_LastMAVLink_Altitude = alt;
-               }
-            }
+            long dTime = get_current_timestamp_ms() - s_TimeLastMAVLink_Altitude; 
+            float vspeed = (float)(alt - s_LastMAVLink_Altitude)*1000.0/(float)dTime;
+            //log_line("alt: %d - %d, %d, %f, dt: %d", alt, s_LastMAVLink_Altitude, (long)vspeed, vspeed, dTime);
+            pdpfct->vspeed = (u32)(vspeed + 100000);
          }
-         pdpfct->heading = mavlink_msg_global_position_int_get_hdg(&msgMav) / 100.0f;
+         s_TimeLastMAVLink_Altitude = get_current_timestamp_ms();
+         s_LastMAVLink_Altitude = alt;
+      }
+   }
+   pdpfct->heading = mavlink_msg_global_position_int_get_hdg(&msgMav) / 100.0f;
 
-         pdpfct->latitude = mavlink_msg_global_position_int_get_lat(&msgMav);
-         pdpfct->longitude = mavlink_msg_global_position_int_get_lon(&msgMav);
-         s_bHasReceivedGPSPos = true;
-         break;
+   pdpfct->latitude = mavlink_msg_global_position_int_get_lat(&msgMav);
+   pdpfct->longitude = mavlink_msg_global_position_int_get_lon(&msgMav);
+   s_bHasReceivedGPSPos = true;
+}
 
-     case MAVLINK_MSG_ID_GPS_RAW_INT:
-         pdpfct->gps_fix_type = mavlink_msg_gps_raw_int_get_fix_type(&msgMav);
-         pdpfct->satelites = mavlink_msg_gps_raw_int_get_satellites_visible(&msgMav);
-         pdpfct->hdop = mavlink_msg_gps_raw_int_get_eph(&msgMav);
-         pdpfct->latitude = mavlink_msg_gps_raw_int_get_lat(&msgMav);
-         pdpfct->longitude = mavlink_msg_gps_raw_int_get_lon(&msgMav);
-         //uTmp32 = mavlink_msg_gps_raw_int_get_alt(&msgMav)/1000.0f / 10.0 + 100000;
-         //if ( pdpfct->gps_fix_type >= GPS_FIX_TYPE_3D_FIX )
-         //   pdpfct->altitude_abs = uTmp32;
-
-         s_bHasReceivedGPSInfo = true;
-         break;
+static void _mav_handle_gps_raw_int(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   pdpfct->gps_fix_type = mavlink_msg_gps_raw_int_get_fix_type(&msgMav);
+   pdpfct->satelites = mavlink_msg_gps_raw_int_get_satellites_visible(&msgMav);
+   pdpfct->hdop = mavlink_msg_gps_raw_int_get_eph(&msgMav);
+   pdpfct->latitude = mavlink_msg_gps_raw_int_get_lat(&msgMav);
+   pdpfct->longitude = mavlink_msg_gps_raw_int_get_lon(&msgMav);
+   //uTmp32 = mavlink_msg_gps_raw_int_get_alt(&msgMav)/1000.0f / 10.0 + 100000;
+   //if ( pdpfct->gps_fix_type >= GPS_FIX_TYPE_3D_FIX )
+   //   pdpfct->altitude_abs = uTmp32;
+
+   s_bHasReceivedGPSInfo = true;
+}
+
+static void _mav_handle_gps2_raw(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   pdpfct->extra_info[1] = mavlink_msg_gps2_raw_get_satellites_visible(&msgMav);
+   pdpfct->extra_info[2] = mavlink_msg_gps2_raw_get_fix_type(&msgMav);
+   u16 hdop = mavlink_msg_gps2_raw_get_eph(&msgMav);
+   pdpfct->extra_info[3] = (hdop >> 8);
+   pdpfct->extra_info[4] = (hdop & 0xFF);
+   s_bHasReceivedGPSInfo = true;
+}
+
+static void _mav_handle_vfr_hud(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   pdpfct->throttle = mavlink_msg_vfr_hud_get_throttle(&msgMav);
+   if ( pdpfct->throttle > 200 )
+      pdpfct->throttle = 0;
+   if ( pdpfct->throttle > 100 )
+      pdpfct->throttle = 100;
+   //pdpfct->altitude = mavlink_msg_vfr_hud_get_alt(&msgMav)*100 + 100000;
+
+   if ( ! s_bShowLocalVerticalSpeed )
+      pdpfct->vspeed = mavlink_msg_vfr_hud_get_climb(&msgMav)*100 + 100000; 
+   pdpfct->hspeed = mavlink_msg_vfr_hud_get_groundspeed(&msgMav) * 100.0f + 100000;
+
+   u32 tmp32 = mavlink_msg_vfr_hud_get_airspeed(&msgMav) * 100.0f + 100000;
+   pdpfct->aspeed = tmp32;
+}
 
-      case MAVLINK_MSG_ID_GPS2_RAW:
+static void _mav_handle_attitude(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   pdpfct->uFCFlags |= FC_TELE_FLAGS_HAS_ATTITUDE;
+   pdpfct->roll = (mavlink_msg_attitude_get_roll(&msgMav) + 3.141592653589793)*5700.2958;
+   pdpfct->pitch = (mavlink_msg_attitude_get_pitch(&msgMav) + 3.141592653589793)*5700.2958;
+}
+
+static void _mav_store_rc_rssi(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, int iRSSI)
+{
+   if ( /*(iRSSI != 255) &&*/ (NULL != pPHRTE) )
+   {
+      pdpfct->rc_rssi = (iRSSI*100)/255;
+      if ( ! (pPHRTE->uRubyFlags & FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RC_RSSI) )
       {
-         pdpfct->extra_info[1] = mavlink_msg_gps2_raw_get_satellites_visible(&msgMav);
-         pdpfct->extra_info[2] = mavlink_msg_gps2_raw_get_fix_type(&msgMav);
-         u16 hdop = mavlink_msg_gps2_raw_get_eph(&msgMav);
-         pdpfct->extra_info[3] = (hdop >> 8);
-         pdpfct->extra_info[4] = (hdop & 0xFF);
-         s_bHasReceivedGPSInfo = true;
-         break;
+         log_line("Received RC RSSI from FC through MAVLink, value: %d", pdpfct->rc_rssi);
+         pPHRTE->uRubyFlags |= FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RC_RSSI;
       }
-      
-      case MAVLINK_MSG_ID_VFR_HUD: 
-         pdpfct->throttle = mavlink_msg_vfr_hud_get_throttle(&msgMav);
-         if ( pdpfct->throttle > 200 )
-            pdpfct->throttle = 0;
-         if ( pdpfct->throttle > 100 )
-            pdpfct->throttle = 100;
-         //pdpfct->altitude = mavlink_msg_vfr_hud_get_alt(&msgMav)*100 + 100000;
-
-         if ( ! s_bShowLocalVerticalSpeed )
-            pdpfct->vspeed = mavlink_msg_vfr_hud_get_climb(&msgMav)*100 + 100000; 
-         pdpfct->hspeed = mavlink_msg_vfr_hud_get_groundspeed(&msgMav) * 100.0f + 100000;
-
-         tmp32= mavlink_msg_vfr_hud_get_airspeed(&msgMav) * 100.0f + 100000;
-         pdpfct->aspeed = tmp32;
-         break;
+      pPHRTE->uplink_mavlink_rc_rssi = pdpfct->rc_rssi;
+   }
+   //if ( NULL != pPHRTE && (pPHRTE->uRubyFlags & FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RC_RSSI) && (iRSSI == 255) )
+   //   pPHRTE->uplink_mavlink_rc_rssi = 255;
+}
 
-      case MAVLINK_MSG_ID_ATTITUDE: 
-         pdpfct->uFCFlags |= FC_TELE_FLAGS_HAS_ATTITUDE;
-         pdpfct->roll = (mavlink_msg_attitude_get_roll(&msgMav) + 3.141592653589793)*5700.2958;
-         pdpfct->pitch = (mavlink_msg_attitude_get_pitch(&msgMav) + 3.141592653589793)*5700.2958;
-         break;
+static void _mav_handle_rc_channels_raw(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   _mav_store_rc_rssi(pdpfct, pPHRTE, (int)((u8)mavlink_msg_rc_channels_raw_get_rssi(&msgMav)));
+
+   s_MAVLinkRCChannels[0] = mavlink_msg_rc_channels_raw_get_chan1_raw(&msgMav);
+   s_MAVLinkRCChannels[1] = mavlink_msg_rc_channels_raw_get_chan2_raw(&msgMav);
+   s_MAVLinkRCChannels[2] = mavlink_msg_rc_channels_raw_get_chan3_raw(&msgMav);
+   s_MAVLinkRCChannels[3] = mavlink_msg_rc_channels_raw_get_chan4_raw(&msgMav);
+   s_MAVLinkRCChannels[4] = mavlink_msg_rc_channels_raw_get_chan5_raw(&msgMav);
+   s_MAVLinkRCChannels[5] = mavlink_msg_rc_channels_raw_get_chan6_raw(&msgMav);
+   s_MAVLinkRCChannels[6] = mavlink_msg_rc_channels_raw_get_chan7_raw(&msgMav);
+   s_MAVLinkRCChannels[7] = mavlink_msg_rc_channels_raw_get_chan8_raw(&msgMav);
+}
 
-      case MAVLINK_MSG_ID_RC_CHANNELS_RAW:
-         tmpi = (int)((u8)mavlink_msg_rc_channels_raw_get_rssi(&msgMav));
-         
-         if ( /*(tmpi != 255) &&*/ (NULL != pPHRTE) )
-         {
-            pdpfct->rc_rssi = (tmpi*100)/255;
-            if ( ! (pPHRTE->uRubyFlags & FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RC_RSSI) )
-            {
-               log_line("Received RC RSSI from FC through MAVLink, value: %d", pdpfct->rc_rssi);
-               pPHRTE->uRubyFlags |= FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RC_RSSI;
-            }
-            pPHRTE->uplink_mavlink_rc_rssi = pdpfct->rc_rssi;
-         }
-         //if ( NULL != pPHRTE && (pPHRTE->uRubyFlags & FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RC_RSSI) && (tmpi == 255) )
-         //   pPHRTE->uplink_mavlink_rc_rssi = 255;
-
-         s_MAVLinkRCChannels[0] = mavlink_msg_rc_channels_raw_get_chan1_raw(&msgMav);
-         s_MAVLinkRCChannels[1] = mavlink_msg_rc_channels_raw_get_chan2_raw(&msgMav);
-         s_MAVLinkRCChannels[2] = mavlink_msg_rc_channels_raw_get_chan3_raw(&msgMav);
-         s_MAVLinkRCChannels[3] = mavlink_msg_rc_channels_raw_get_chan4_raw(&msgMav);
-         s_MAVLinkRCChannels[4] = mavlink_msg_rc_channels_raw_get_chan5_raw(&msgMav);
-         s_MAVLinkRCChannels[5] = mavlink_msg_rc_channels_raw_get_chan6_raw(&msgMav);
-         s_MAVLinkRCChannels[6] = mavlink_msg_rc_channels_raw_get_chan7_raw(&msgMav);
-         s_MAVLinkRCChannels[7] = mavlink_msg_rc_channels_raw_get_chan8_raw(&msgMav);
-         break;
+static void _mav_handle_rc_channels(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   _mav_store_rc_rssi(pdpfct, pPHRTE, (int)((u8)mavlink_msg_rc_channels_get_rssi(&msgMav)));
+
+   s_MAVLinkRCChannels[0] = mavlink_msg_rc_channels_get_chan1_raw(&msgMav);
+   s_MAVLinkRCChannels[1] = mavlink_msg_rc_channels_get_chan2_raw(&msgMav);
+   s_MAVLinkRCChannels[2] = mavlink_msg_rc_channels_get_chan3_raw(&msgMav);
+   s_MAVLinkRCChannels[3] = mavlink_msg_rc_channels_get_chan4_raw(&msgMav);
+   s_MAVLinkRCChannels[4] = mavlink_msg_rc_channels_get_chan5_raw(&msgMav);
+   s_MAVLinkRCChannels[5] = mavlink_msg_rc_channels_get_chan6_raw(&msgMav);
+   s_MAVLinkRCChannels[6] = mavlink_msg_rc_channels_get_chan7_raw(&msgMav);
+   s_MAVLinkRCChannels[7] = mavlink_msg_rc_channels_get_chan8_raw(&msgMav);
+   s_MAVLinkRCChannels[8] = mavlink_msg_rc_channels_get_chan9_raw(&msgMav);
+   s_MAVLinkRCChannels[9] = mavlink_msg_rc_channels_get_chan10_raw(&msgMav);
+   s_MAVLinkRCChannels[10] = mavlink_msg_rc_channels_get_chan11_raw(&msgMav);
+   s_MAVLinkRCChannels[11] = mavlink_msg_rc_channels_get_chan12_raw(&msgMav);
+   s_MAVLinkRCChannels[12] = mavlink_msg_rc_channels_get_chan13_raw(&msgMav);
+   s_MAVLinkRCChannels[13] = mavlink_msg_rc_channels_get_chan14_raw(&msgMav);         
+}
 
-      case MAVLINK_MSG_ID_RC_CHANNELS:
-         tmpi = (int)((u8)mavlink_msg_rc_channels_get_rssi(&msgMav));
-         
-         if ( /*(tmpi != 255) &&*/ (NULL != pPHRTE) )
-         {
-            pdpfct->rc_rssi = (tmpi*100)/255;
-            if ( ! (pPHRTE->uRubyFlags & FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RC_RSSI) )
-            {
-               log_line("Received RC RSSI from FC through MAVLink, value: %d", pdpfct->rc_rssi);
-               pPHRTE->uRubyFlags |= FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RC_RSSI;
-            }
-            pPHRTE->uplink_mavlink_rc_rssi = pdpfct->rc_rssi;
-         }
-         //if ( NULL != pPHRTE && (pPHRTE->uRubyFlags & FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RC_RSSI) && (tmpi == 255) )
-         //   pPHRTE->uplink_mavlink_rc_rssi = 255;
-
-         s_MAVLinkRCChannels[0] = mavlink_msg_rc_channels_get_chan1_raw(&msgMav);
-         s_MAVLinkRCChannels[1] = mavlink_msg_rc_channels_get_chan2_raw(&msgMav);
-         s_MAVLinkRCChannels[2] = mavlink_msg_rc_channels_get_chan3_raw(&msgMav);
-         s_MAVLinkRCChannels[3] = mavlink_msg_rc_channels_get_chan4_raw(&msgMav);
-         s_MAVLinkRCChannels[4] = mavlink_msg_rc_channels_get_chan5_raw(&msgMav);
-         s_MAVLinkRCChannels[5] = mavlink_msg_rc_channels_get_chan6_raw(&msgMav);
-         s_MAVLinkRCChannels[6] = mavlink_msg_rc_channels_get_chan7_raw(&msgMav);
-         s_MAVLinkRCChannels[7] = mavlink_msg_rc_channels_get_chan8_raw(&msgMav);
-         s_MAVLinkRCChannels[8] = mavlink_msg_rc_channels_get_chan9_raw(&msgMav);
-         s_MAVLinkRCChannels[9] = mavlink_msg_rc_channels_get_chan10_raw(&msgMav);
-         s_MAVLinkRCChannels[10] = mavlink_msg_rc_channels_get_chan11_raw(&msgMav);
-         s_MAVLinkRCChannels[11] = mavlink_msg_rc_channels_get_chan12_raw(&msgMav);
-         s_MAVLinkRCChannels[12] = mavlink_msg_rc_channels_get_chan13_raw(&msgMav);
-         s_MAVLinkRCChannels[13] = mavlink_msg_rc_channels_get_chan14_raw(&msgMav);         
-         break;
+static void _mav_handle_radio_status(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   u8 tmp8 = ((int)mavlink_msg_radio_status_get_rssi(&msgMav))*100/255;
+   //if ( tmp8 != 0xFF )
+   //   pdpfct->rc_rssi = tmp8;
 
-      case MAVLINK_MSG_ID_RADIO_STATUS:
-         tmp8 = ((int)mavlink_msg_radio_status_get_rssi(&msgMav))*100/255;
-         //if ( tmp8 != 0xFF )
-         //   pdpfct->rc_rssi = tmp8;
+   if ( NULL != pPHRTE )
+   {
+      if ( ! (pPHRTE->uRubyFlags & FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RX_RSSI) )
+      {
+         log_line("Received RX RSSI from FC through MAVLink, value: %d", tmp8);
+         pPHRTE->uRubyFlags |= FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RX_RSSI;
+      }
+      pPHRTE->uplink_mavlink_rx_rssi = tmp8;
+   }
+}
 
-         if ( NULL != pPHRTE )
-         {
-            if ( ! (pPHRTE->uRubyFlags & FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RX_RSSI) )
-            {
-               log_line("Received RX RSSI from FC through MAVLink, value: %d", tmp8);
-               pPHRTE->uRubyFlags |= FLAG_RUBY_TELEMETRY_HAS_MAVLINK_RX_RSSI;
-            }
-            pPHRTE->uplink_mavlink_rx_rssi = tmp8;
-         }
-         break;
+static void _mav_handle_high_latency(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   int iTemp = mavlink_msg_high_latency_get_temperature(&msgMav);
+   if ( iTemp < 100 && iTemp > -100 )
+      pdpfct->temperatureC = 100 + (int) iTemp;
 
-      case MAVLINK_MSG_ID_RAW_IMU:
-         //log_line("MSG_RAW_IMU");
-         break;
+   iTemp = mavlink_msg_high_latency_get_temperature_air(&msgMav);
+   if ( iTemp < 100 && iTemp > -100 )
+      pdpfct->temperatureC = 100 + (int) iTemp;
+}
 
-      case MAVLINK_MSG_ID_SCALED_IMU:
-         //log_line("MSG_SCALED_IMU");
-         break;
+static void _mav_handle_high_latency2(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   int iTemp = mavlink_msg_high_latency2_get_temperature_air(&msgMav);
+   if ( iTemp < 100 && iTemp > -100 )
+      pdpfct->temperatureC = 100 + (int) iTemp;
+
+   u16 uDir = 2 * mavlink_msg_high_latency2_get_wind_heading(&msgMav);
+   uDir++;
+   pdpfct->extra_info[7] = uDir >> 8;
+   pdpfct->extra_info[8] = uDir & 0xFF;
+    
+   u16 uSpeed = 100 * mavlink_msg_high_latency2_get_windspeed(&msgMav) / 5;
+   uSpeed++;
+   pdpfct->extra_info[9] = uSpeed >> 8;
+   pdpfct->extra_info[10] = uSpeed & 0xFF;
+}
 
-      case MAVLINK_MSG_ID_HIGH_LATENCY:
-         {
-            //log_line("MSG_HIGH_LAT");
-            int iTemp = mavlink_msg_high_latency_get_temperature(&msgMav);
-            if ( iTemp < 100 && iTemp > -100 )
-               pdpfct->temperatureC = 100 + (int) iTemp;
-
-            iTemp = mavlink_msg_high_latency_get_temperature_air(&msgMav);
-            if ( iTemp < 100 && iTemp > -100 )
-               pdpfct->temperatureC = 100 + (int) iTemp;
-         }
+static void _mav_handle_scaled_pressure(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   int iTemp = mavlink_msg_scaled_pressure_get_temperature(&msgMav);
+   iTemp = iTemp/100;
+   if ( iTemp < 100 && iTemp > -100 )
+      pdpfct->temperatureC = 100 + (int) iTemp;
+}
+
+static void _mav_handle_wind_cov(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   float fWindX = mavlink_msg_wind_cov_get_wind_x(&msgMav);
+   float fWindY = mavlink_msg_wind_cov_get_wind_x(&msgMav);
+   //float fWindZ = mavlink_msg_wind_cov_get_wind_x(&msgMav);
+   if ( fabs(fWindX) + fabs(fWindY) > 0.0001 )
+   {
+      float fLen = sqrtf(fWindX*fWindX + fWindY * fWindY);
+      float fAngle = 3.1415*2.0*atan2f(fWindY, fWindX);
+      fAngle -= pdpfct->heading;
+      u16 uDir = (u16)fAngle;
+      uDir++;
+      pdpfct->extra_info[7] = uDir >> 8;
+      pdpfct->extra_info[8] = uDir & 0xFF;
+
+      u16 uSpeed = (u16)(fLen*100.0);
+      uSpeed++;
+      pdpfct->extra_info[9] = uSpeed >> 8;
+      pdpfct->extra_info[10] = uSpeed & 0xFF;
+   }
+   else
+   {
+      pdpfct->extra_info[7] = 0;
+      pdpfct->extra_info[8] = 0;
+      pdpfct->extra_info[9] = 0;
+      pdpfct->extra_info[10] = 0;
+   }
+}
+
+// Only the messages Ruby consumes are in the table; everything else is skipped without decoding.
+// Ordered by how often ArduPilot/INAV send them, so the lookup usually stops on the first entries.
+
+typedef struct
+{
+   u32 uMsgId;
+   u8 uCRCExtra;
+   u8 uMsgLen;
+   void (*pHandler)(t_packet_header_fc_telemetry*, t_packet_header_ruby_telemetry_extended_v4*, u8);
+} t_mavlink_dispatch_entry;
+
+static const t_mavlink_dispatch_entry s_MAVLinkDispatchTable[] =
+{
+   { MAVLINK_MSG_ID_ATTITUDE, MAVLINK_MSG_ID_ATTITUDE_CRC, MAVLINK_MSG_ID_ATTITUDE_LEN, _mav_handle_attitude },
+   { MAVLINK_MSG_ID_GLOBAL_POSITION_INT, MAVLINK_MSG_ID_GLOBAL_POSITION_INT_CRC, MAVLINK_MSG_ID_GLOBAL_POSITION_INT_LEN, _mav_handle_global_position_int },
+   { MAVLINK_MSG_ID_VFR_HUD, MAVLINK_MSG_ID_VFR_HUD_CRC, MAVLINK_MSG_ID_VFR_HUD_LEN, _mav_handle_vfr_hud },
+   { MAVLINK_MSG_ID_RC_CHANNELS, MAVLINK_MSG_ID_RC_CHANNELS_CRC, MAVLINK_MSG_ID_RC_CHANNELS_LEN, _mav_handle_rc_channels },
+   { MAVLINK_MSG_ID_GPS_RAW_INT, MAVLINK_MSG_ID_GPS_RAW_INT_CRC, MAVLINK_MSG_ID_GPS_RAW_INT_LEN, _mav_handle_gps_raw_int },
+   { MAVLINK_MSG_ID_SYS_STATUS, MAVLINK_MSG_ID_SYS_STATUS_CRC, MAVLINK_MSG_ID_SYS_STATUS_LEN, _mav_handle_sys_status },
+   { MAVLINK_MSG_ID_BATTERY_STATUS, MAVLINK_MSG_ID_BATTERY_STATUS_CRC, MAVLINK_MSG_ID_BATTERY_STATUS_LEN, _mav_handle_battery_status },
+   { MAVLINK_MSG_ID_HEARTBEAT, MAVLINK_MSG_ID_HEARTBEAT_CRC, MAVLINK_MSG_ID_HEARTBEAT_LEN, _mav_handle_heartbeat },
+   { MAVLINK_MSG_ID_SCALED_PRESSURE, MAVLINK_MSG_ID_SCALED_PRESSURE_CRC, MAVLINK_MSG_ID_SCALED_PRESSURE_LEN, _mav_handle_scaled_pressure },
+   { MAVLINK_MSG_ID_RC_CHANNELS_RAW, MAVLINK_MSG_ID_RC_CHANNELS_RAW_CRC, MAVLINK_MSG_ID_RC_CHANNELS_RAW_LEN, _mav_handle_rc_channels_raw },
+   { MAVLINK_MSG_ID_RADIO_STATUS, MAVLINK_MSG_ID_RADIO_STATUS_CRC, MAVLINK_MSG_ID_RADIO_STATUS_LEN, _mav_handle_radio_status },
+   { MAVLINK_MSG_ID_GPS2_RAW, MAVLINK_MSG_ID_GPS2_RAW_CRC, MAVLINK_MSG_ID_GPS2_RAW_LEN, _mav_handle_gps2_raw },
+   { MAVLINK_MSG_ID_WIND_COV, MAVLINK_MSG_ID_WIND_COV_CRC, MAVLINK_MSG_ID_WIND_COV_LEN, _mav_handle_wind_cov },
+   { MAVLINK_MSG_ID_STATUSTEXT, MAVLINK_MSG_ID_STATUSTEXT_CRC, MAVLINK_MSG_ID_STATUSTEXT_LEN, _mav_handle_statustext },
+   { MAVLINK_MSG_ID_STATUSTEXT_LONG, MAVLINK_MSG_ID_STATUSTEXT_LONG_CRC, MAVLINK_MSG_ID_STATUSTEXT_LONG_LEN, _mav_handle_statustext_long },
+   { MAVLINK_MSG_ID_HIGH_LATENCY, MAVLINK_MSG_ID_HIGH_LATENCY_CRC, MAVLINK_MSG_ID_HIGH_LATENCY_LEN, _mav_handle_high_latency },
+   { MAVLINK_MSG_ID_HIGH_LATENCY2, MAVLINK_MSG_ID_HIGH_LATENCY2_CRC, MAVLINK_MSG_ID_HIGH_LATENCY2_LEN, _mav_handle_high_latency2 }
+};
+
+#define MAVLINK_DISPATCH_TABLE_SIZE ((int)(sizeof(s_MAVLinkDispatchTable)/sizeof(s_MAVLinkDispatchTable[0])))
+
+static const t_mavlink_dispatch_entry* _mav_find_dispatch_entry(u32 uMsgId)
+{
+   for( int i=0; i<MAVLINK_DISPATCH_TABLE_SIZE; i++ )
+   {
+      if ( s_MAVLinkDispatchTable[i].uMsgId == uMsgId )
+         return &s_MAVLinkDispatchTable[i];
+   }
+   return NULL;
+}
+
+void _process_mav_message(t_packet_header_fc_telemetry* pdpfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   if ( 0 == s_iAllowAnyVehicleSysId )
+   if ( (msgMav.sysid != s_vehicleMavId) && (msgMav.sysid != 0) )
+      return;
+
+   const t_mavlink_dispatch_entry* pEntry = _mav_find_dispatch_entry(msgMav.msgid);
+   if ( NULL != pEntry )
+      (*pEntry->pHandler)(pdpfct, pPHRTE, vehicleType);
+}
+
+static void _on_valid_mavlink_message_from_fc()
+{
+   if ( 0 == s_uTimeLastMAVLinkMessageFromFC )
+      log_line("Started receiving valid MAVLink telemetry from FC");
+   s_uTimeLastMAVLinkMessageFromFC = get_current_timestamp_ms();
+}
+
+// Scans all the complete frames in the carry-over buffer and returns the number of bytes consumed.
+// Frames we consume are always CRC checked (with CRC extra) before decoding. Once the scanner is
+// in sync (last frame had a good CRC), frames we do not consume are skipped by their length alone;
+// a corrupted length just makes the next position miss the STX, which drops the scanner out of sync
+// and back to checking the CRC of every candidate frame.
+static int _scan_mavlink_frames(t_packet_header_fc_telemetry* pphfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType, bool* pbGotMessages)
+{
+   u8* pBuffer = s_uMAVLinkScanBuffer;
+   int iLength = s_iMAVLinkScanBufferLength;
+   int iPos = 0;
+
+   while ( iPos < iLength )
+   {
+      u8 uSTX = pBuffer[iPos];
+      if ( (uSTX != MAVLINK_STX) && (uSTX != MAVLINK_STX_MAVLINK1) )
+      {
+         s_bMAVLinkScannerInSync = false;
+         iPos++;
+         continue;
+      }
+
+      int iHeaderLength = MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1;
+      if ( uSTX == MAVLINK_STX )
+         iHeaderLength = MAVLINK_CORE_HEADER_LEN + 1;
+      if ( iLength - iPos < iHeaderLength )
          break;
 
-      case MAVLINK_MSG_ID_HIGH_LATENCY2:
+      u8* pFrame = &pBuffer[iPos];
+      int iPayloadLength = pFrame[1];
+      int iFrameLength = iHeaderLength + iPayloadLength + MAVLINK_NUM_CHECKSUM_BYTES;
+      u32 uMsgId = 0;
+      u8 uIncompatFlags = 0;
+      u8 uSeq, uSysId, uCompId;
+
+      if ( uSTX == MAVLINK_STX )
+      {
+         uIncompatFlags = pFrame[2];
+         if ( uIncompatFlags & ~MAVLINK_IFLAG_MASK )
          {
-            //log_line("MSG_HIGH_LAT2");
-            int iTemp = mavlink_msg_high_latency2_get_temperature_air(&msgMav);
-            if ( iTemp < 100 && iTemp > -100 )
-               pdpfct->temperatureC = 100 + (int) iTemp;
-
-            u16 uDir = 2 * mavlink_msg_high_latency2_get_wind_heading(&msgMav);
-            uDir++;
-            pdpfct->extra_info[7] = uDir >> 8;
-            pdpfct->extra_info[8] = uDir & 0xFF;
-             
-            u16 uSpeed = 100 * mavlink_msg_high_latency2_get_windspeed(&msgMav) / 5;
-            uSpeed++;
-            pdpfct->extra_info[9] = uSpeed >> 8;
-            pdpfct->extra_info[10] = uSpeed & 0xFF;
+            s_bMAVLinkScannerInSync = false;
+            iPos++;
+            continue;
          }
+         if ( uIncompatFlags & MAVLINK_IFLAG_SIGNED )
+            iFrameLength += MAVLINK_SIGNATURE_BLOCK_LEN;
+         uSeq = pFrame[4];
+         uSysId = pFrame[5];
+         uCompId = pFrame[6];
+         uMsgId = ((u32)pFrame[7]) | (((u32)pFrame[8]) << 8) | (((u32)pFrame[9]) << 16);
+      }
+      else
+      {
+         uSeq = pFrame[2];
+         uSysId = pFrame[3];
+         uCompId = pFrame[4];
+         uMsgId = pFrame[5];
+      }
+
+      if ( iLength - iPos < iFrameLength )
          break;
 
-      case MAVLINK_MSG_ID_SCALED_PRESSURE:
-         {
-            //log_line("SCALED PRESSURE");
-            int iTemp = mavlink_msg_scaled_pressure_get_temperature(&msgMav);
-            iTemp = iTemp/100;
-            if ( iTemp < 100 && iTemp > -100 )
-               pdpfct->temperatureC = 100 + (int) iTemp;
-         }
+      const t_mavlink_dispatch_entry* pEntry = _mav_find_dispatch_entry(uMsgId);
+      if ( (NULL == pEntry) && s_bMAVLinkScannerInSync )
+      {
+         *pbGotMessages = true;
+         iPos += iFrameLength;
+         continue;
+      }
 
-      /*
-      case MAVLINK_MSG_ID_WIND:
-         {
-            log_line("WIND");
-            u16 uDir = mavlink_msg_wind_get_direction(&msgMav);
-            pdpfct->extra_info[7] = uDir >> 8;
-            pdpfct->extra_info[8] = uDir & 0xFF;
-            float fSpeed = mavlink_msg_wind_get_speed(&msgMav);
-            u16 uSpeed = (u16)(fSpeed*100.0);
-            pdpfct->extra_info[9] = uSpeed >> 8;
-            pdpfct->extra_info[10] = uSpeed & 0xFF;
-         }
-      */
-
-      case MAVLINK_MSG_ID_WIND_COV:
-       {
-          //log_line("WIND_COV");
-          float fWindX = mavlink_msg_wind_cov_get_wind_x(&msgMav);
-          float fWindY = mavlink_msg_wind_cov_get_wind_x(&msgMav);
-          //float fWindZ = mavlink_msg_wind_cov_get_wind_x(&msgMav);
-          if ( fabs(fWindX) + fabs(fWindY) > 0.0001 )
-          {
-             float fLen = sqrtf(fWindX*fWindX + fWindY * fWindY);
-             float fAngle = 3.1415*2.0*atan2f(fWindY, fWindX);
-             fAngle -= pdpfct->heading;
-             u16 uDir = (u16)fAngle;
-             uDir++;
-             pdpfct->extra_info[7] = uDir >> 8;
-             pdpfct->extra_info[8] = uDir & 0xFF;
-
-             u16 uSpeed = (u16)(fLen*100.0);
-             uSpeed++;
-             pdpfct->extra_info[9] = uSpeed >> 8;
-             pdpfct->extra_info[10] = uSpeed & 0xFF;
-          }
-          else
-          {
-             pdpfct->extra_info[7] = 0;
-             pdpfct->extra_info[8] = 0;
-             pdpfct->extra_info[9] = 0;
-             pdpfct->extra_info[10] = 0;
-          }
-       }
-      case MAVLINK_MSG_ID_PARAM_VALUE:
-         /*
+      u8 uCRCExtra = 0;
+      if ( NULL != pEntry )
+         uCRCExtra = pEntry->uCRCExtra;
+      else
+      {
+         const mavlink_msg_entry_t* pMsgEntry = mavlink_get_msg_entry(uMsgId);
+         if ( NULL == pMsgEntry )
          {
-            char szBuff[32];
-            szBuff[0] = '*';
-            szBuff[1] = 0;
-            mavlink_msg_param_value_get_param_id(&msgMav, szBuff);
-            u8 type = mavlink_msg_param_value_get_param_type(&msgMav);
-            //int val = (int)mavlink_msg_param_value_get_param_value(&msgMav);
-            //log_line("recv param '%s' (%d of %d),  value: %d", szBuff, (int)mavlink_msg_param_value_get_param_index(&msgMav), (int)mavlink_msg_param_value_get_param_count(&msgMav), val);
-            float val = (float)mavlink_msg_param_value_get_param_value(&msgMav);
-            log_line("recv param '%s'(%d of %d), type: %d, value: %f", szBuff, (int)mavlink_msg_param_value_get_param_index(&msgMav), (int)mavlink_msg_param_value_get_param_count(&msgMav), type, val);
+            s_bMAVLinkScannerInSync = false;
+            iPos++;
+            continue;
          }
-         */
-         break;
-      
+         uCRCExtra = pMsgEntry->crc_extra;
+      }
+
+      u16 uCRC;
+      crc_init(&uCRC);
+      crc_accumulate_buffer(&uCRC, (const char*)&pFrame[1], iHeaderLength - 1 + iPayloadLength);
+      crc_accumulate(uCRCExtra, &uCRC);
+      u8* pCRC = &pFrame[iHeaderLength + iPayloadLength];
+      if ( (pCRC[0] != (uCRC & 0xFF)) || (pCRC[1] != (uCRC >> 8)) )
+      {
+         s_bMAVLinkScannerInSync = false;
+         iPos++;
+         continue;
+      }
+
+      s_bMAVLinkScannerInSync = true;
+      *pbGotMessages = true;
+      iPos += iFrameLength;
+      if ( NULL == pEntry )
+         continue;
+
+      // Payloads can be truncated (MAVLink 2 trailing zeros), fill them up to the full message length
+      msgMav.magic = uSTX;
+      msgMav.len = iPayloadLength;
+      msgMav.incompat_flags = uIncompatFlags;
+      msgMav.compat_flags = 0;
+      msgMav.seq = uSeq;
+      msgMav.sysid = uSysId;
+      msgMav.compid = uCompId;
+      msgMav.msgid = uMsgId;
+      u8* pPayload = (u8*)_MAV_PAYLOAD_NON_CONST(&msgMav);
+      memcpy(pPayload, &pFrame[iHeaderLength], iPayloadLength);
+      if ( iPayloadLength < pEntry->uMsgLen )
+         memset(pPayload + iPayloadLength, 0, pEntry->uMsgLen - iPayloadLength);
+
+      if ( 0 == s_iAllowAnyVehicleSysId )
+      if ( (uSysId != s_vehicleMavId) && (uSysId != 0) )
+         continue;
+      (*pEntry->pHandler)(pphfct, pPHRTE, vehicleType);
+   }
+   return iPos;
+}
+
+static bool _parse_mavlink_frames(u8* buffer, int length, t_packet_header_fc_telemetry* pphfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType)
+{
+   bool bGotMessages = false;
+   while ( length > 0 )
+   {
+      int iCopy = MAVLINK_SCAN_BUFFER_SIZE - s_iMAVLinkScanBufferLength;
+      if ( iCopy > length )
+         iCopy = length;
+      memcpy(&s_uMAVLinkScanBuffer[s_iMAVLinkScanBufferLength], buffer, iCopy);
+      s_iMAVLinkScanBufferLength += iCopy;
+      buffer += iCopy;
+      length -= iCopy;
+
+      int iConsumed = _scan_mavlink_frames(pphfct, pPHRTE, vehicleType, &bGotMessages);
+
+      // Keep the incomplete frame at the end for the next read
+      if ( iConsumed > 0 )
+      {
+         s_iMAVLinkScanBufferLength -= iConsumed;
+         if ( s_iMAVLinkScanBufferLength > 0 )
+            memmove(s_uMAVLinkScanBuffer, &s_uMAVLinkScanBuffer[iConsumed], s_iMAVLinkScanBufferLength);
+      }
    }
+
+   if ( bGotMessages )
+      _on_valid_mavlink_message_from_fc();
+   return bGotMessages;
 }
 
 bool parse_telemetry_from_fc( u8* buffer, int length, t_packet_header_fc_telemetry* pphfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType, int telemetry_type )
@@ -717,6 +896,9 @@ bool parse_telemetry_from_fc( u8* buffer, int length, t_packet_header_fc_telemet
    if ( telemetry_type == TELEMETRY_TYPE_LTM )
       return parse_telemetry_from_fc_ltm(buffer, length, pphfct, pPHRTE, vehicleType);
 
+   if ( s_bUseMAVLinkFrameScanner )
+      return _parse_mavlink_frames(buffer, length, pphfct, pPHRTE, vehicleType);
+
    bool ret = false;
    uint8_t c;
    for( int i=0; i<length; i++)
@@ -725,9 +907,7 @@ bool parse_telemetry_from_fc( u8* buffer, int length, t_packet_header_fc_telemet
       buffer++;
       if (mavlink_parse_char(0, c, &msgMav, &statusMav))
       {
-         if ( 0 == s_uTimeLastMAVLinkMessageFromFC )
-            log_line("Started receiving valid MAVLink telemetry from FC");
-         s_uTimeLastMAVLinkMessageFromFC = get_current_timestamp_ms();
+         _on_valid_mavlink_message_from_fc();
          ret = true;
          _process_mav_message(pphfct, pPHRTE, vehicleType);
       }
@@ -8,6 +8,8 @@ void parse_telemetry_allow_any_sysid(int iAllow);
 void parse_telemetry_set_show_local_vspeed(bool bShowLocalVerticalSpeed);
 void parse_telemetry_remove_duplicate_messages(bool bRemove);
 void parse_telemetry_force_always_armed(bool bForce);
+// Bulk MAVLink frame scanner (default) or the byte by byte mavlink_parse_char parser
+void parse_telemetry_use_mavlink_frame_scanner(bool bUse);
 
 bool parse_telemetry_from_fc( u8* buffer, int length, t_packet_header_fc_telemetry* pphfct, t_packet_header_ruby_telemetry_extended_v4* pPHRTE, u8 vehicleType, int telemetry_type );
 bool has_received_gps_info();
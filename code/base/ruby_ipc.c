@@ -34,6 +34,8 @@
 #include "ruby_ipc.h"
 #include "hardware.h"
 #include "hw_procs.h"
+#include "trace.h"
+#include "ipc_shm_ring.h"
 #include "../common/string_utils.h"
 #include "../radio/radiopackets2.h"
 
@@ -43,7 +45,15 @@
 #include <errno.h>
 
 //#define RUBY_USE_FIFO_PIPES 1
-#define RUBY_USES_MSGQUEUES 1
+//#define RUBY_USES_MSGQUEUES 1
+#define RUBY_USES_SHM_RINGS 1
+
+// Shared memory rings are not touched by anything else than the two endpoints,
+// the packet CRC set by the sender is checked on read only if this is enabled
+#define IPC_SHM_RING_CHECK_CRC 0
+#define SHARED_MEM_IPC_RING_PREFIX "/SYSTEM_SHARED_MEM_IPC_"
+// A full ring drops the message; drops are counted per channel and logged at most once per interval
+#define IPC_DROPS_LOG_INTERVAL_MS 1000
 
 #define FIFO_RUBY_ROUTER_TO_CENTRAL "/tmp/ruby/fiforoutercentral"
 #define FIFO_RUBY_CENTRAL_TO_ROUTER "/tmp/ruby/fifocentralrouter"
@@ -65,6 +75,14 @@ int s_iRubyIPCChannelsFd[MAX_CHANNELS];
 int s_iRubyIPCChannelsType[MAX_CHANNELS];
 u8  s_uRubyIPCChannelsMsgId[MAX_CHANNELS];
 key_t s_uRubyIPCChannelsKeys[MAX_CHANNELS];
+t_ipc_shm_ring* s_pRubyIPCChannelsRings[MAX_CHANNELS];
+u32 s_uRubyIPCChannelsDropsNotLogged[MAX_CHANNELS];
+u32 s_uRubyIPCChannelsTimeLastDropsLog[MAX_CHANNELS];
+
+// Direct mapped cache: channel unique id -> index in the channels arrays
+#define CHANNELS_LOOKUP_SLOTS 32
+static int s_iRubyIPCChannelsLookupIds[CHANNELS_LOOKUP_SLOTS];
+static int s_iRubyIPCChannelsLookupIndex[CHANNELS_LOOKUP_SLOTS];
 
 static int s_iRubyIPCChannelsUniqueIdCounter = 1;
 
@@ -149,6 +167,42 @@ char* _ruby_ipc_get_pipe_name(int nChannelType )
 }
 
 
+char* _ruby_ipc_get_shm_ring_name(int nChannelType)
+{
+   static char s_szRubyShmRingName[64];
+   snprintf(s_szRubyShmRingName, sizeof(s_szRubyShmRingName), "%s%d", SHARED_MEM_IPC_RING_PREFIX, nChannelType);
+   return s_szRubyShmRingName;
+}
+
+void _ruby_ipc_update_channels_lookup()
+{
+   for( int i=0; i<CHANNELS_LOOKUP_SLOTS; i++ )
+      s_iRubyIPCChannelsLookupIds[i] = 0;
+   for( int i=0; i<s_iRubyIPCChannelsCount; i++ )
+   {
+      int iSlot = s_iRubyIPCChannelsUniqueIds[i] & (CHANNELS_LOOKUP_SLOTS-1);
+      s_iRubyIPCChannelsLookupIds[iSlot] = s_iRubyIPCChannelsUniqueIds[i];
+      s_iRubyIPCChannelsLookupIndex[iSlot] = i;
+   }
+}
+
+int _ruby_ipc_find_channel_index(int iChannelUniqueId)
+{
+   if ( iChannelUniqueId <= 0 )
+      return -1;
+   int iSlot = iChannelUniqueId & (CHANNELS_LOOKUP_SLOTS-1);
+   if ( s_iRubyIPCChannelsLookupIds[iSlot] == iChannelUniqueId )
+      return s_iRubyIPCChannelsLookupIndex[iSlot];
+
+   // Slot collision (only if more than CHANNELS_LOOKUP_SLOTS channels were opened over time)
+   for( int i=0; i<s_iRubyIPCChannelsCount; i++ )
+   {
+      if ( s_iRubyIPCChannelsUniqueIds[i] == iChannelUniqueId )
+         return i;
+   }
+   return -1;
+}
+
 void _ruby_ipc_log_channels()
 {
    log_line("[IPC] Currently opened channels: %d:", s_iRubyIPCChannelsCount);
@@ -164,6 +218,15 @@ void _ruby_ipc_log_channel_info(int iChannelType, int iChannelId, int iChannelFd
 {
    if ( iChannelFd < 0 )
       return;
+   #ifdef RUBY_USES_SHM_RINGS
+   int iIndex = _ruby_ipc_find_channel_index(iChannelId);
+   if ( (iIndex < 0) || (NULL == s_pRubyIPCChannelsRings[iIndex]) )
+      return;
+   t_ipc_shm_ring* pRing = s_pRubyIPCChannelsRings[iIndex];
+   log_line("[IPC] Channel %s (id: %d, fd: %d) info: %u pending bytes, %u messages written, %u dropped, ring size: %d bytes",
+      _ruby_ipc_get_channel_name(iChannelType), iChannelId, iChannelFd,
+      pRing->uWritePos - pRing->uReadPos, pRing->uCountMessagesWritten, pRing->uCountMessagesDropped, IPC_SHM_RING_DATA_SIZE);
+   #else
    struct msqid_ds msg_stats;
    if ( 0 != msgctl(iChannelFd, IPC_STAT, &msg_stats) )
       log_softerror_and_alarm("[IPC] Failed to get statistics on ICP message queue %s, id %d, fd %d",
@@ -172,6 +235,7 @@ void _ruby_ipc_log_channel_info(int iChannelType, int iChannelId, int iChannelFd
       log_line("[IPC] Channel %s (id: %d, fd: %d) info: %u pending messages, %u used bytes, max bytes in the IPC channel: %u bytes",
          _ruby_ipc_get_channel_name(iChannelType), iChannelId,
          iChannelFd, (u32)msg_stats.msg_qnum, (u32)msg_stats.msg_cbytes, (u32)msg_stats.msg_qbytes);
+   #endif
 }
 
 void _check_ruby_ipc_consistency()
@@ -267,6 +331,20 @@ void ruby_clear_all_ipc_channels()
 
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+
+   for( int i=0; i<s_iRubyIPCChannelsCount; i++ )
+      ipc_shm_ring_close(s_pRubyIPCChannelsRings[i], s_iRubyIPCChannelsFd[i]);
+   s_iRubyIPCChannelsCount = 0;
+   _ruby_ipc_update_channels_lookup();
+
+   int iTypes[] = { IPC_CHANNEL_TYPE_ROUTER_TO_CENTRAL, IPC_CHANNEL_TYPE_CENTRAL_TO_ROUTER, IPC_CHANNEL_TYPE_ROUTER_TO_TELEMETRY, IPC_CHANNEL_TYPE_TELEMETRY_TO_ROUTER,
+                    IPC_CHANNEL_TYPE_ROUTER_TO_RC, IPC_CHANNEL_TYPE_RC_TO_ROUTER, IPC_CHANNEL_TYPE_ROUTER_TO_COMMANDS, IPC_CHANNEL_TYPE_COMMANDS_TO_ROUTER };
+   for( int i=0; i<(int)(sizeof(iTypes)/sizeof(iTypes[0])); i++ )
+      ipc_shm_ring_unlink(_ruby_ipc_get_shm_ring_name(iTypes[i]));
+
+   #endif
+
    log_line("[IPC] Done clearing all IPC channels.");
 }
 
@@ -286,6 +364,8 @@ int ruby_open_ipc_channel_write_endpoint(int nChannelType)
 
    s_iRubyIPCChannelsType[s_iRubyIPCChannelsCount] = nChannelType;
    s_uRubyIPCChannelsMsgId[s_iRubyIPCChannelsCount] = 0;
+   s_uRubyIPCChannelsDropsNotLogged[s_iRubyIPCChannelsCount] = 0;
+   s_uRubyIPCChannelsTimeLastDropsLog[s_iRubyIPCChannelsCount] = 0;
 
    #ifdef RUBY_USE_FIFO_PIPES
 
@@ -347,10 +427,24 @@ int ruby_open_ipc_channel_write_endpoint(int nChannelType)
 
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+
+   s_uRubyIPCChannelsKeys[s_iRubyIPCChannelsCount] = 0;
+   s_pRubyIPCChannelsRings[s_iRubyIPCChannelsCount] = ipc_shm_ring_open(_ruby_ipc_get_shm_ring_name(nChannelType), &s_iRubyIPCChannelsFd[s_iRubyIPCChannelsCount]);
+   if ( NULL == s_pRubyIPCChannelsRings[s_iRubyIPCChannelsCount] )
+   {
+      log_softerror_and_alarm("[IPC] Failed to create IPC shared memory ring %s endpoint for channel %s",
+         "write", _ruby_ipc_get_channel_name(nChannelType));
+      return -1;
+   }
+
+   #endif
+
    s_iRubyIPCChannelsUniqueIds[s_iRubyIPCChannelsCount] = s_iRubyIPCChannelsUniqueIdCounter;
    s_iRubyIPCChannelsUniqueIdCounter++;
 
    s_iRubyIPCChannelsCount++;
+   _ruby_ipc_update_channels_lookup();
    
    log_line("[IPC] Opened IPC channel %s write endpoint: success, fd: %d, id: %d. (%d channels currently opened).",
       _ruby_ipc_get_channel_name(nChannelType), s_iRubyIPCChannelsFd[s_iRubyIPCChannelsCount-1], s_iRubyIPCChannelsUniqueIds[s_iRubyIPCChannelsCount-1], s_iRubyIPCChannelsCount);
@@ -376,6 +470,8 @@ int ruby_open_ipc_channel_read_endpoint(int nChannelType)
 
    s_iRubyIPCChannelsType[s_iRubyIPCChannelsCount] = nChannelType;
    s_uRubyIPCChannelsMsgId[s_iRubyIPCChannelsCount] = 0;
+   s_uRubyIPCChannelsDropsNotLogged[s_iRubyIPCChannelsCount] = 0;
+   s_uRubyIPCChannelsTimeLastDropsLog[s_iRubyIPCChannelsCount] = 0;
 
    #ifdef RUBY_USE_FIFO_PIPES
 
@@ -433,10 +529,24 @@ int ruby_open_ipc_channel_read_endpoint(int nChannelType)
    //   log_line("[IPC] IPC channels pools max: %u bytes, max msg size: %u bytes, max msg queue total size: %u bytes", (u32)msg_info.msgpool, (u32)msg_info.msgmax, (u32)msg_info.msgmnb);
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+
+   s_uRubyIPCChannelsKeys[s_iRubyIPCChannelsCount] = 0;
+   s_pRubyIPCChannelsRings[s_iRubyIPCChannelsCount] = ipc_shm_ring_open(_ruby_ipc_get_shm_ring_name(nChannelType), &s_iRubyIPCChannelsFd[s_iRubyIPCChannelsCount]);
+   if ( NULL == s_pRubyIPCChannelsRings[s_iRubyIPCChannelsCount] )
+   {
+      log_softerror_and_alarm("[IPC] Failed to create IPC shared memory ring %s endpoint for channel %s",
+         "read", _ruby_ipc_get_channel_name(nChannelType));
+      return -1;
+   }
+
+   #endif
+
    s_iRubyIPCChannelsUniqueIds[s_iRubyIPCChannelsCount] = s_iRubyIPCChannelsUniqueIdCounter;
    s_iRubyIPCChannelsUniqueIdCounter++;
 
    s_iRubyIPCChannelsCount++;
+   _ruby_ipc_update_channels_lookup();
    
    log_line("[IPC] Opened IPC channel %s read endpoint: success, fd: %d, id: %d. (%d channels currently opened).",
       _ruby_ipc_get_channel_name(nChannelType), s_iRubyIPCChannelsFd[s_iRubyIPCChannelsCount-1], s_iRubyIPCChannelsUniqueIds[s_iRubyIPCChannelsCount-1], s_iRubyIPCChannelsCount);
@@ -449,16 +559,9 @@ int ruby_open_ipc_channel_read_endpoint(int nChannelType)
 int ruby_close_ipc_channel(int iChannelUniqueId)
 {
    int fdToClose = 0;
-   int iChannelIndex = -1;
-   for( int i=0; i<s_iRubyIPCChannelsCount; i++ )
-   {
-      if ( s_iRubyIPCChannelsUniqueIds[i] == iChannelUniqueId )
-      {
-         fdToClose = s_iRubyIPCChannelsFd[i];
-         iChannelIndex = i;
-         break;
-      }
-   }
+   int iChannelIndex = _ruby_ipc_find_channel_index(iChannelUniqueId);
+   if ( -1 != iChannelIndex )
+      fdToClose = s_iRubyIPCChannelsFd[iChannelIndex];
 
    if ( (iChannelUniqueId < 0) || (fdToClose < 0) || (-1 == iChannelIndex) )
    {
@@ -478,6 +581,10 @@ int ruby_close_ipc_channel(int iChannelUniqueId)
    msgctl(fdToClose,IPC_RMID,NULL);
    #endif
 
+   // The ring is kept in shared memory so the peer endpoint and a restarted process keep using it
+   #ifdef RUBY_USES_SHM_RINGS
+   ipc_shm_ring_close(s_pRubyIPCChannelsRings[iChannelIndex], fdToClose);
+   #endif
 
    log_line("[IPC] Closed IPC channel %s, channel index %d, unique id %d, fd %d",
        _ruby_ipc_get_channel_name(s_iRubyIPCChannelsType[iChannelIndex]),
@@ -489,9 +596,12 @@ int ruby_close_ipc_channel(int iChannelUniqueId)
       s_iRubyIPCChannelsType[k] = s_iRubyIPCChannelsType[k+1];
       s_iRubyIPCChannelsUniqueIds[k] = s_iRubyIPCChannelsUniqueIds[k+1];
       s_uRubyIPCChannelsMsgId[k] = s_uRubyIPCChannelsMsgId[k+1];
-
+      s_pRubyIPCChannelsRings[k] = s_pRubyIPCChannelsRings[k+1];
+      s_uRubyIPCChannelsDropsNotLogged[k] = s_uRubyIPCChannelsDropsNotLogged[k+1];
+      s_uRubyIPCChannelsTimeLastDropsLog[k] = s_uRubyIPCChannelsTimeLastDropsLog[k+1];
    }
    s_iRubyIPCChannelsCount--;
+   _ruby_ipc_update_channels_lookup();
   
    _ruby_ipc_log_channels();
    return 1;
@@ -505,21 +615,10 @@ int ruby_ipc_channel_send_message(int iChannelUniqueId, u8* pMessage, int iLengt
       return 0;
    }
 
-   int iFoundIndex = -1;
    int iChannelFd = 0;
-   //int iChannelType = 0;
-   //u8 uChannelMsgId = 0;
-   for( int i=0; i<s_iRubyIPCChannelsCount; i++ )
-   {
-      if ( s_iRubyIPCChannelsUniqueIds[i] == iChannelUniqueId )
-      {
-         iChannelFd = s_iRubyIPCChannelsFd[i];
-         //iChannelType = s_iRubyIPCChannelsType[i];
-         //uChannelMsgId = s_uRubyIPCChannelsMsgId[i];
-         iFoundIndex = i;
-         break;
-      }
-   }
+   int iFoundIndex = _ruby_ipc_find_channel_index(iChannelUniqueId);
+   if ( -1 != iFoundIndex )
+      iChannelFd = s_iRubyIPCChannelsFd[iFoundIndex];
 
    if ( iFoundIndex == -1 )
    {
@@ -556,11 +655,28 @@ int ruby_ipc_channel_send_message(int iChannelUniqueId, u8* pMessage, int iLengt
    #endif
 
    s_uRubyIPCChannelsMsgId[iFoundIndex]++;
+   TRACE_BEGIN(TRACE_EVENT_IPC_SEND, iChannelUniqueId, iLength, 0);
 
    #ifdef RUBY_USE_FIFO_PIPES
    res = write(iChannelFd, pMessage, iLength);
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+   res = ipc_shm_ring_write(s_pRubyIPCChannelsRings[iFoundIndex], pMessage, iLength);
+   if ( 0 == res )
+   {
+      s_uRubyIPCChannelsDropsNotLogged[iFoundIndex]++;
+      u32 uTimeNow = get_current_timestamp_ms();
+      if ( (0 == s_uRubyIPCChannelsTimeLastDropsLog[iFoundIndex]) || (uTimeNow >= s_uRubyIPCChannelsTimeLastDropsLog[iFoundIndex] + IPC_DROPS_LOG_INTERVAL_MS) )
+      {
+         log_softerror_and_alarm("[IPC] Channel %s is full, dropped %u messages since last report (%u dropped in total on the channel)",
+            _ruby_ipc_get_channel_name(s_iRubyIPCChannelsType[iFoundIndex]), s_uRubyIPCChannelsDropsNotLogged[iFoundIndex], s_pRubyIPCChannelsRings[iFoundIndex]->uCountMessagesDropped );
+         s_uRubyIPCChannelsDropsNotLogged[iFoundIndex] = 0;
+         s_uRubyIPCChannelsTimeLastDropsLog[iFoundIndex] = uTimeNow;
+      }
+   }
+   #endif
+
    #ifdef RUBY_USES_MSGQUEUES
    
    type_ipc_message_buffer msg;
@@ -661,6 +777,7 @@ int ruby_ipc_channel_send_message(int iChannelUniqueId, u8* pMessage, int iLengt
    }
    #endif
 
+   TRACE_END(TRACE_EVENT_IPC_SEND, iChannelUniqueId, iLength, res);
    return res;
 }
 
@@ -673,18 +790,13 @@ u8* ruby_ipc_try_read_message(int iChannelUniqueId, u8* pTempBuffer, int* pTempB
       return NULL;
    }
 
-   int iFoundIndex = -1;
    int iChannelFd = 0;
    int iChannelType = 0;
-   for( int i=0; i<s_iRubyIPCChannelsCount; i++ )
+   int iFoundIndex = _ruby_ipc_find_channel_index(iChannelUniqueId);
+   if ( -1 != iFoundIndex )
    {
-      if ( s_iRubyIPCChannelsUniqueIds[i] == iChannelUniqueId )
-      {
-         iChannelFd = s_iRubyIPCChannelsFd[i];
-         iChannelType = s_iRubyIPCChannelsType[i];
-         iFoundIndex = i;
-         break;
-      }
+      iChannelFd = s_iRubyIPCChannelsFd[iFoundIndex];
+      iChannelType = s_iRubyIPCChannelsType[iFoundIndex];
    }
 
    if ( iFoundIndex == -1 )
@@ -693,6 +805,12 @@ u8* ruby_ipc_try_read_message(int iChannelUniqueId, u8* pTempBuffer, int* pTempB
       return NULL;
    }
 
+   if ( iChannelFd < 0 )
+   {
+      log_softerror_and_alarm("[IPC] Tried to read a message from an invalid channel fd %d (unique id %d)", iChannelFd, iChannelUniqueId);
+      return NULL;
+   }
+
    if ( NULL == pTempBuffer || NULL == pTempBufferPos || NULL == pOutputBuffer )
    {
       log_softerror_and_alarm("[IPC] Tried to read a message into a NULL buffer on channel %s", _ruby_ipc_get_channel_name(iChannelType) );
@@ -811,6 +929,23 @@ u8* ruby_ipc_try_read_message(int iChannelUniqueId, u8* pTempBuffer, int* pTempB
 
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+
+   lenReadIPCMsgQueue = ipc_shm_ring_read(s_pRubyIPCChannelsRings[iFoundIndex], pOutputBuffer, MAX_PACKET_TOTAL_SIZE);
+   if ( lenReadIPCMsgQueue < 0 )
+      log_softerror_and_alarm("[IPC] Found invalid data in the shared memory ring of channel %s. Discarded it.", _ruby_ipc_get_channel_name(iChannelType));
+   else if ( lenReadIPCMsgQueue > 0 )
+   {
+      #if IPC_SHM_RING_CHECK_CRC
+      if ( ! base_check_crc32(pOutputBuffer, lenReadIPCMsgQueue) )
+         log_softerror_and_alarm("[IPC] Received invalid CRC on channel %s, msg length: %d", _ruby_ipc_get_channel_name(iChannelType), lenReadIPCMsgQueue );
+      else
+      #endif
+      pReturn = pOutputBuffer;
+   }
+
+   #endif
+
    #ifdef PROFILE_IPC
    u32 uTimeTotal = get_current_timestamp_ms() - uTimeStart;
    if ( (uTimeTotal > PROFILE_IPC_MAX_TIME + timeoutMicrosec/1000) || uTimeTotal >= 50 )
@@ -825,9 +960,24 @@ u8* ruby_ipc_try_read_message(int iChannelUniqueId, u8* pTempBuffer, int* pTempB
       s_iRubyIPCCountReadErrors = 0;
    #endif
 
+   if ( NULL != pReturn )
+      TRACE_INSTANT(TRACE_EVENT_IPC_RECEIVE, iChannelUniqueId, ((t_packet_header*)pReturn)->total_length, ((t_packet_header*)pReturn)->packet_type);
    return pReturn;
 }
 
+int ruby_ipc_wait_for_message(int iChannelUniqueId, int iTimeoutMicros)
+{
+   #ifdef RUBY_USES_SHM_RINGS
+   int iIndex = _ruby_ipc_find_channel_index(iChannelUniqueId);
+   if ( iIndex >= 0 )
+      return ipc_shm_ring_wait(s_pRubyIPCChannelsRings[iIndex], iTimeoutMicros);
+   #endif
+   // Nothing to wait on (other transports or an invalid channel): sleep like the polling loops did, then let the caller poll
+   if ( iTimeoutMicros > 0 )
+      hardware_sleep_micros(iTimeoutMicros);
+   return 1;
+}
+
 int ruby_ipc_get_read_continous_error_count()
 {
    return s_iRubyIPCCountReadErrors;
@@ -32,6 +32,9 @@ int ruby_close_ipc_channel(int iChannelUniqueId);
 
 int ruby_ipc_channel_send_message(int iChannelUniqueId, u8* pMessage, int iLength);
 u8* ruby_ipc_try_read_message(int iChannelUniqueId, u8* pTempBuffer, int* pTempBufferPos, u8* pOutputBuffer);
+// Blocks until a message is available on the channel or the timeout expires. Returns 1 if there may be a message to read.
+// Transports without a wait primitive just sleep for the timeout. Use it in place of the sleep of single channel reader loops.
+int ruby_ipc_wait_for_message(int iChannelUniqueId, int iTimeoutMicros);
 
 int ruby_ipc_get_read_continous_error_count();
 
@@ -33,12 +33,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <sched.h>
 #include "base.h"
 #include "shared_mem.h"
 #include "../radio/radiopackets2.h"
 
+// Each object is mapped with a seqlock trailer after the struct (see shared_mem_publish)
+static int _shared_mem_get_mapped_size(int iSize)
+{
+   return SHARED_MEM_SEQLOCK_OFFSET(iSize) + (int)sizeof(t_shared_mem_seqlock);
+}
+
 void* open_shared_mem(const char* name, int size, int readOnly)
 {
+   int iMappedSize = _shared_mem_get_mapped_size(size);
    int fd;
    if ( readOnly )
       fd = shm_open(name, O_RDONLY, S_IRUSR | S_IWUSR);
@@ -53,7 +61,7 @@ void* open_shared_mem(const char* name, int size, int readOnly)
    }
    if ( ! readOnly )
    {
-      if (ftruncate(fd, size) == -1)
+      if (ftruncate(fd, iMappedSize) == -1)
       {
           log_softerror_and_alarm("[SharedMem] Failed to init (ftruncate) shared memory for writing: %s", name);
           close(fd);
@@ -62,9 +70,9 @@ void* open_shared_mem(const char* name, int size, int readOnly)
    }
    void *retval = NULL;
    if ( readOnly )
-      retval = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+      retval = mmap(NULL, iMappedSize, PROT_READ, MAP_SHARED, fd, 0);
    else
-      retval = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      retval = mmap(NULL, iMappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
    if (retval == MAP_FAILED)
    {
       log_softerror_and_alarm("[SharedMem] Failed to map shared memory for %s: %s",
@@ -74,7 +82,7 @@ void* open_shared_mem(const char* name, int size, int readOnly)
    }
 
    if ( ! readOnly )
-      memset(retval, 0, size);
+      memset(retval, 0, iMappedSize);
 
    close(fd);
 
@@ -82,6 +90,88 @@ void* open_shared_mem(const char* name, int size, int readOnly)
    return retval;
 }
 
+void close_shared_mem(void* pAddress, int iSize)
+{
+   if ( NULL != pAddress )
+      munmap(pAddress, _shared_mem_get_mapped_size(iSize));
+}
+
+t_shared_mem_seqlock* shared_mem_get_seqlock(const void* pAddress, int iSize)
+{
+   return (t_shared_mem_seqlock*)(((u8*)pAddress) + SHARED_MEM_SEQLOCK_OFFSET(iSize));
+}
+
+void shared_mem_write_begin(void* pAddress, int iSize)
+{
+   t_shared_mem_seqlock* pLock = shared_mem_get_seqlock(pAddress, iSize);
+   __atomic_store_n(&pLock->uSequence, pLock->uSequence + 1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void shared_mem_write_end(void* pAddress, int iSize)
+{
+   t_shared_mem_seqlock* pLock = shared_mem_get_seqlock(pAddress, iSize);
+   __atomic_store_n(&pLock->uSequence, pLock->uSequence + 1, __ATOMIC_RELEASE);
+}
+
+void shared_mem_publish(void* pShared, const void* pLocal, int iSize)
+{
+   if ( (NULL == pShared) || (NULL == pLocal) )
+      return;
+   shared_mem_write_begin(pShared, iSize);
+   memcpy(pShared, pLocal, iSize);
+   shared_mem_write_end(pShared, iSize);
+}
+
+// Snapshots are copied here first and committed to the caller's copy only once validated
+static __thread u8* s_pSharedMemReadScratch = NULL;
+static __thread int s_iSharedMemReadScratchSize = 0;
+
+int shared_mem_read_if_changed(void* pLocal, const void* pShared, int iSize, u32* puLastSequence)
+{
+   if ( (NULL == pLocal) || (NULL == pShared) || (NULL == puLastSequence) || (iSize <= 0) )
+      return 0;
+   const t_shared_mem_seqlock* pLock = shared_mem_get_seqlock(pShared, iSize);
+
+   if ( iSize > s_iSharedMemReadScratchSize )
+   {
+      u8* pScratch = (u8*) realloc(s_pSharedMemReadScratch, iSize);
+      if ( NULL == pScratch )
+      {
+         log_softerror_and_alarm("[SharedMem] Failed to allocate %d bytes for reading a snapshot.", iSize);
+         return -1;
+      }
+      s_pSharedMemReadScratch = pScratch;
+      s_iSharedMemReadScratchSize = iSize;
+   }
+
+   for( int i=0; i<SHARED_MEM_READ_RETRIES; i++ )
+   {
+      u32 uSeqStart = __atomic_load_n(&pLock->uSequence, __ATOMIC_ACQUIRE);
+      // Writer is in the middle of an update
+      if ( uSeqStart & 1 )
+      {
+         if ( i > 1 )
+            sched_yield();
+         continue;
+      }
+      // 0: writer does not publish through the seqlock, always copy
+      if ( (0 != uSeqStart) && (uSeqStart == *puLastSequence) )
+         return 0;
+
+      memcpy(s_pSharedMemReadScratch, pShared, iSize);
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if ( uSeqStart == __atomic_load_n(&pLock->uSequence, __ATOMIC_RELAXED) )
+      {
+         memcpy(pLocal, s_pSharedMemReadScratch, iSize);
+         *puLastSequence = uSeqStart;
+         return 1;
+      }
+   }
+   // Torn copy: pLocal keeps the previous snapshot, keep the last sequence so the next call copies again
+   return -1;
+}
+
 void* open_shared_mem_for_write(const char* name, int size)
 {
    return open_shared_mem(name, size, 0);
@@ -110,7 +200,7 @@ shared_mem_process_stats* shared_mem_process_stats_open_write(const char* szName
 void shared_mem_process_stats_close(const char* szName, shared_mem_process_stats* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_process_stats));
+      close_shared_mem(pAddress, sizeof(shared_mem_process_stats));
    //shm_unlink(szName);
 }
 
@@ -150,7 +240,7 @@ shared_mem_radio_stats* shared_mem_radio_stats_open_for_write()
 void shared_mem_radio_stats_close(shared_mem_radio_stats* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_radio_stats));
+      close_shared_mem(pAddress, sizeof(shared_mem_radio_stats));
    //shm_unlink(szName);
 }
 
@@ -169,7 +259,7 @@ shared_mem_radio_stats_rx_hist* shared_mem_radio_stats_rx_hist_open_for_write()
 void shared_mem_radio_stats_rx_hist_close(shared_mem_radio_stats_rx_hist* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_radio_stats_rx_hist));
+      close_shared_mem(pAddress, sizeof(shared_mem_radio_stats_rx_hist));
 }
 
 shared_mem_video_frames_stats* shared_mem_video_frames_stats_open_for_read()
@@ -187,7 +277,7 @@ shared_mem_video_frames_stats* shared_mem_video_frames_stats_open_for_write()
 void shared_mem_video_frames_stats_close(shared_mem_video_frames_stats* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_video_frames_stats));
+      close_shared_mem(pAddress, sizeof(shared_mem_video_frames_stats));
 }
 
 
@@ -206,7 +296,7 @@ shared_mem_video_frames_stats* shared_mem_video_frames_stats_radio_in_open_for_w
 void shared_mem_video_frames_stats_radio_in_close(shared_mem_video_frames_stats* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_video_frames_stats));
+      close_shared_mem(pAddress, sizeof(shared_mem_video_frames_stats));
 }
 
 shared_mem_video_frames_stats* shared_mem_video_frames_stats_radio_out_open_for_read()
@@ -224,7 +314,7 @@ shared_mem_video_frames_stats* shared_mem_video_frames_stats_radio_out_open_for_
 void shared_mem_video_frames_stats_radio_out_close(shared_mem_video_frames_stats* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_video_frames_stats));
+      close_shared_mem(pAddress, sizeof(shared_mem_video_frames_stats));
 }
 
 shared_mem_video_link_graphs* shared_mem_video_link_graphs_open_for_read()
@@ -242,7 +332,7 @@ shared_mem_video_link_graphs* shared_mem_video_link_graphs_open_for_write()
 void shared_mem_video_link_graphs_close(shared_mem_video_link_graphs* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_video_link_graphs));
+      close_shared_mem(pAddress, sizeof(shared_mem_video_link_graphs));
 }
 
 
@@ -263,7 +353,7 @@ t_packet_header_rc_info_downstream* shared_mem_rc_downstream_info_open_write()
 void shared_mem_rc_downstream_info_close(t_packet_header_rc_info_downstream* pRCInfo)
 {
    if ( NULL != pRCInfo )
-      munmap(pRCInfo, sizeof(t_packet_header_rc_info_downstream));
+      close_shared_mem(pRCInfo, sizeof(t_packet_header_rc_info_downstream));
    //shm_unlink(SHARED_MEM_RC_DOWNLOAD_INFO);
 }
 
@@ -285,7 +375,7 @@ t_packet_header_rc_full_frame_upstream* shared_mem_rc_upstream_frame_open_write(
 void shared_mem_rc_upstream_frame_close(t_packet_header_rc_full_frame_upstream* pRCInfo)
 {
    if ( NULL != pRCInfo )
-      munmap(pRCInfo, sizeof(t_packet_header_rc_full_frame_upstream));
+      close_shared_mem(pRCInfo, sizeof(t_packet_header_rc_full_frame_upstream));
    //shm_unlink(SHARED_MEM_RC_UPSTREAM_FRAME);
 }
 
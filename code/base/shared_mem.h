@@ -67,6 +67,8 @@ typedef struct
    u32 uTotalLoopTime;
    u32 uAverageLoopTimeMs;
    u32 uMaxLoopTimeMs;
+   u32 uForksAtStartup;   // fork/exec done before the main loop started
+   u32 uForksSteadyState; // fork/exec done since the main loop started
 } ALIGN_STRUCT_SPEC_INFO shared_mem_process_stats;
 
 
@@ -184,10 +186,32 @@ typedef struct
 } ALIGN_STRUCT_SPEC_INFO type_radio_tx_timers;
 
 
+// Every object opened with open_shared_mem() has a sequence lock placed after the struct.
+// Writers that update the object from a local copy use shared_mem_publish() (or wrap their own
+// updates in shared_mem_write_begin/end); readers use shared_mem_read_if_changed() to copy the
+// object only when it changed and never get a half written snapshot.
+// One writer per object. Objects written field by field keep sequence 0 and are always copied.
+typedef struct
+{
+   u32 uSequence; // odd while the writer updates the object
+   u32 uReserved[15];
+} t_shared_mem_seqlock;
+
+#define SHARED_MEM_SEQLOCK_OFFSET(size) ((((int)(size)) + 63) & (~63))
+#define SHARED_MEM_READ_RETRIES 8
+
 void* open_shared_mem(const char* name, int size, int readOnly);
+void close_shared_mem(void* pAddress, int iSize);
 void* open_shared_mem_for_write(const char* name, int size);
 void* open_shared_mem_for_read(const char* name, int size);
 
+t_shared_mem_seqlock* shared_mem_get_seqlock(const void* pAddress, int iSize);
+void shared_mem_write_begin(void* pAddress, int iSize);
+void shared_mem_write_end(void* pAddress, int iSize);
+void shared_mem_publish(void* pShared, const void* pLocal, int iSize);
+// Returns 1 if a new snapshot was copied, 0 if unchanged, -1 if no consistent copy could be made (pLocal is left unchanged)
+int shared_mem_read_if_changed(void* pLocal, const void* pShared, int iSize, u32* puLastSequence);
+
 shared_mem_process_stats* shared_mem_process_stats_open_read(const char* szName);
 shared_mem_process_stats* shared_mem_process_stats_open_write(const char* szName);
 void shared_mem_process_stats_close(const char* szName, shared_mem_process_stats* pAddress);
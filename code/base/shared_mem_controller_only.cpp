@@ -55,7 +55,7 @@ shared_mem_video_stream_stats_rx_processors* shared_mem_video_stream_stats_rx_pr
 void shared_mem_video_stream_stats_rx_processors_close(shared_mem_video_stream_stats_rx_processors* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_video_stream_stats_rx_processors));
+      close_shared_mem(pAddress, sizeof(shared_mem_video_stream_stats_rx_processors));
    //shm_unlink(SHARED_MEM_VIDEO_STREAM_STATS);
 }
 
@@ -87,7 +87,7 @@ shared_mem_radio_rx_queue_info* shared_mem_radio_rx_queue_info_open_for_write()
 void shared_mem_radio_rx_queue_info_close(shared_mem_radio_rx_queue_info* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_radio_rx_queue_info));
+      close_shared_mem(pAddress, sizeof(shared_mem_radio_rx_queue_info));
 }
 
 shared_mem_router_vehicles_runtime_info* shared_mem_router_vehicles_runtime_info_open_for_read()
@@ -105,6 +105,6 @@ shared_mem_router_vehicles_runtime_info* shared_mem_router_vehicles_runtime_info
 void shared_mem_router_vehicles_runtime_info_close(shared_mem_router_vehicles_runtime_info* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_router_vehicles_runtime_info));
+      close_shared_mem(pAddress, sizeof(shared_mem_router_vehicles_runtime_info));
    //shm_unlink(szName);
 }
@@ -22,6 +22,8 @@ typedef struct
    int iCurrentVideoHeight;
    int iCurrentVideoFPS;
    u32 uCurrentFECTimeMicros; // in micro seconds per second   
+   u32 uFECDecodeCacheHits;
+   u32 uFECDecodeCacheMisses;
    int iCurrentPacketsInBuffers;
    int iMaxPacketsInBuffers;
    u8 uDetectedH264Profile;
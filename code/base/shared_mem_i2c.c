@@ -53,7 +53,7 @@ t_shared_mem_i2c_current* shared_mem_i2c_current_open_for_read()
 void shared_mem_i2c_current_close(t_shared_mem_i2c_current* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(t_shared_mem_i2c_current));
+      close_shared_mem(pAddress, sizeof(t_shared_mem_i2c_current));
    //shm_unlink(SHARED_MEM_RX_STATS);
 }
 
@@ -75,7 +75,7 @@ t_shared_mem_i2c_controller_rc_in* shared_mem_i2c_controller_rc_in_open_for_writ
 void shared_mem_i2c_controller_rc_in_close(t_shared_mem_i2c_controller_rc_in* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(t_shared_mem_i2c_controller_rc_in));
+      close_shared_mem(pAddress, sizeof(t_shared_mem_i2c_controller_rc_in));
    //shm_unlink(SHARED_MEM_NAME_I2C_CONTROLLER_RC_IN);
 }
 
@@ -94,6 +94,6 @@ t_shared_mem_i2c_rotary_encoder_buttons_events* shared_mem_i2c_rotary_encoder_bu
 void shared_mem_i2c_rotary_encoder_buttons_events_close(t_shared_mem_i2c_rotary_encoder_buttons_events* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(t_shared_mem_i2c_rotary_encoder_buttons_events));
+      close_shared_mem(pAddress, sizeof(t_shared_mem_i2c_rotary_encoder_buttons_events));
 }
 
@@ -0,0 +1,335 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include "startup_timeline.h"
+
+typedef struct
+{
+   char szName[STARTUP_TIMELINE_MAX_NAME];
+   unsigned long long uStartUs;
+   unsigned long long uEndUs;
+   int iThreadId;
+} t_startup_timeline_phase;
+
+static pthread_mutex_t s_MutexStartupTimeline = PTHREAD_MUTEX_INITIALIZER;
+static t_startup_timeline_phase s_StartupPhases[STARTUP_TIMELINE_MAX_PHASES];
+static int s_iStartupPhasesCount = 0;
+static int s_iStartupPhasesDropped = 0;
+static int s_iStartupTimelineInitialized = 0;
+static unsigned long long s_uStartupTimelineStartUs = 0;
+static unsigned long long s_uStartupTimelineStartSinceBootUs = 0;
+static char s_szStartupTimelineProcess[32];
+
+static unsigned long long _startup_timeline_clock_us(clockid_t iClock)
+{
+   struct timespec ts;
+   if ( 0 != clock_gettime(iClock, &ts) )
+      return 0;
+   return (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)ts.tv_nsec/1000ULL;
+}
+
+// Must be called with the mutex locked
+static void _startup_timeline_init_locked(const char* szProcessName)
+{
+   s_uStartupTimelineStartUs = _startup_timeline_clock_us(CLOCK_MONOTONIC);
+   s_uStartupTimelineStartSinceBootUs = _startup_timeline_clock_us(CLOCK_BOOTTIME);
+   s_iStartupPhasesCount = 0;
+   s_iStartupPhasesDropped = 0;
+   s_szStartupTimelineProcess[0] = 0;
+   if ( NULL != szProcessName )
+   {
+      strncpy(s_szStartupTimelineProcess, szProcessName, sizeof(s_szStartupTimelineProcess)-1);
+      s_szStartupTimelineProcess[sizeof(s_szStartupTimelineProcess)-1] = 0;
+   }
+   s_iStartupTimelineInitialized = 1;
+}
+
+void startup_timeline_init(const char* szProcessName)
+{
+   pthread_mutex_lock(&s_MutexStartupTimeline);
+   _startup_timeline_init_locked(szProcessName);
+   pthread_mutex_unlock(&s_MutexStartupTimeline);
+   log_line("[Startup] Timeline started for %s, %u ms after kernel boot.", (NULL != szProcessName)?szProcessName:"N/A", (u32)(s_uStartupTimelineStartSinceBootUs/1000));
+}
+
+int startup_timeline_begin(const char* szPhaseName)
+{
+   unsigned long long uNowUs = _startup_timeline_clock_us(CLOCK_MONOTONIC);
+   int iThreadId = (int)syscall(SYS_gettid);
+   int iPhaseId = -1;
+
+   pthread_mutex_lock(&s_MutexStartupTimeline);
+   if ( ! s_iStartupTimelineInitialized )
+      _startup_timeline_init_locked(NULL);
+   if ( s_iStartupPhasesCount < STARTUP_TIMELINE_MAX_PHASES )
+   {
+      iPhaseId = s_iStartupPhasesCount;
+      s_iStartupPhasesCount++;
+      t_startup_timeline_phase* pPhase = &s_StartupPhases[iPhaseId];
+      strncpy(pPhase->szName, (NULL != szPhaseName)?szPhaseName:"N/A", STARTUP_TIMELINE_MAX_NAME-1);
+      pPhase->szName[STARTUP_TIMELINE_MAX_NAME-1] = 0;
+      pPhase->uStartUs = uNowUs;
+      pPhase->uEndUs = 0;
+      pPhase->iThreadId = iThreadId;
+   }
+   else
+      s_iStartupPhasesDropped++;
+   pthread_mutex_unlock(&s_MutexStartupTimeline);
+   return iPhaseId;
+}
+
+void startup_timeline_end(int iPhaseId)
+{
+   unsigned long long uNowUs = _startup_timeline_clock_us(CLOCK_MONOTONIC);
+   pthread_mutex_lock(&s_MutexStartupTimeline);
+   if ( (iPhaseId >= 0) && (iPhaseId < s_iStartupPhasesCount) && (0 == s_StartupPhases[iPhaseId].uEndUs) )
+      s_StartupPhases[iPhaseId].uEndUs = uNowUs;
+   pthread_mutex_unlock(&s_MutexStartupTimeline);
+}
+
+u32 startup_timeline_get_elapsed_ms()
+{
+   if ( ! s_iStartupTimelineInitialized )
+      return 0;
+   return (u32)((_startup_timeline_clock_us(CLOCK_MONOTONIC) - s_uStartupTimelineStartUs)/1000);
+}
+
+void startup_timeline_log_waterfall()
+{
+   t_startup_timeline_phase phases[STARTUP_TIMELINE_MAX_PHASES];
+   int iCount = 0;
+   int iDropped = 0;
+   unsigned long long uStartUs = 0;
+   unsigned long long uNowUs = _startup_timeline_clock_us(CLOCK_MONOTONIC);
+
+   pthread_mutex_lock(&s_MutexStartupTimeline);
+   iCount = s_iStartupPhasesCount;
+   iDropped = s_iStartupPhasesDropped;
+   uStartUs = s_uStartupTimelineStartUs;
+   memcpy(phases, s_StartupPhases, iCount * sizeof(t_startup_timeline_phase));
+   pthread_mutex_unlock(&s_MutexStartupTimeline);
+
+   unsigned long long uTotalUs = uNowUs - uStartUs;
+   if ( 0 == uTotalUs )
+      uTotalUs = 1;
+
+   const int iBarWidth = 50;
+   char szBar[64];
+
+   log_line("[Startup] Timeline of %s: %d phases, %u ms total, started %u ms after kernel boot:",
+      s_szStartupTimelineProcess[0]?s_szStartupTimelineProcess:"process", iCount, (u32)(uTotalUs/1000), (u32)(s_uStartupTimelineStartSinceBootUs/1000));
+   for( int i=0; i<iCount; i++ )
+   {
+      t_startup_timeline_phase* pPhase = &phases[i];
+      unsigned long long uEndUs = pPhase->uEndUs;
+      if ( 0 == uEndUs )
+         uEndUs = uNowUs;
+      unsigned long long uOffsetUs = pPhase->uStartUs - uStartUs;
+      unsigned long long uDurationUs = uEndUs - pPhase->uStartUs;
+
+      int iBarStart = (int)(uOffsetUs * (unsigned long long)iBarWidth / uTotalUs);
+      int iBarEnd = (int)((uEndUs - uStartUs) * (unsigned long long)iBarWidth / uTotalUs);
+      if ( iBarStart >= iBarWidth )
+         iBarStart = iBarWidth-1;
+      if ( iBarEnd <= iBarStart )
+         iBarEnd = iBarStart+1;
+      if ( iBarEnd > iBarWidth )
+         iBarEnd = iBarWidth;
+      for( int k=0; k<iBarWidth; k++ )
+         szBar[k] = ((k >= iBarStart) && (k < iBarEnd))?'#':'.';
+      szBar[iBarWidth] = 0;
+
+      log_line("[Startup] |%s| +%5u ms %5u.%01u ms tid %5d %s%s", szBar,
+         (u32)(uOffsetUs/1000), (u32)(uDurationUs/1000), (u32)((uDurationUs%1000)/100),
+         pPhase->iThreadId, pPhase->szName, (0 == pPhase->uEndUs)?" (not finished)":"");
+   }
+   if ( iDropped > 0 )
+      log_softerror_and_alarm("[Startup] %d phases were not recorded (timeline full, max %d phases).", iDropped, STARTUP_TIMELINE_MAX_PHASES);
+}
+
+
+#define STARTUP_TASK_STATE_PENDING 0
+#define STARTUP_TASK_STATE_RUNNING 1
+#define STARTUP_TASK_STATE_DONE 2
+
+typedef struct
+{
+   t_startup_graph* pGraph;
+   pthread_mutex_t mutex;
+   pthread_cond_t condTaskDone;
+   u32 uDoneMask;
+   int iRunningCount;
+} t_startup_graph_run_state;
+
+typedef struct
+{
+   t_startup_graph_run_state* pRunState;
+   int iTaskId;
+} t_startup_graph_task_context;
+
+void startup_graph_init(t_startup_graph* pGraph)
+{
+   if ( NULL == pGraph )
+      return;
+   memset(pGraph, 0, sizeof(t_startup_graph));
+}
+
+int startup_graph_add_task(t_startup_graph* pGraph, const char* szName, startup_task_function_t pFunction, void* pArg, u32 uDependsOnMask)
+{
+   if ( (NULL == pGraph) || (NULL == pFunction) )
+      return -1;
+   if ( pGraph->iTasksCount >= STARTUP_GRAPH_MAX_TASKS )
+   {
+      log_softerror_and_alarm("[Startup] Can't add task [%s], max %d tasks.", (NULL != szName)?szName:"N/A", STARTUP_GRAPH_MAX_TASKS);
+      return -1;
+   }
+   int iTaskId = pGraph->iTasksCount;
+   if ( uDependsOnMask & ~((((u32)1) << iTaskId) - 1) )
+   {
+      log_softerror_and_alarm("[Startup] Task [%s] can only depend on tasks added before it (dependency mask: 0x%X).", (NULL != szName)?szName:"N/A", uDependsOnMask);
+      return -1;
+   }
+   t_startup_graph_task* pTask = &pGraph->tasks[iTaskId];
+   strncpy(pTask->szName, (NULL != szName)?szName:"N/A", STARTUP_TIMELINE_MAX_NAME-1);
+   pTask->szName[STARTUP_TIMELINE_MAX_NAME-1] = 0;
+   pTask->pFunction = pFunction;
+   pTask->pArg = pArg;
+   pTask->uDependsOnMask = uDependsOnMask;
+   pTask->iState = STARTUP_TASK_STATE_PENDING;
+   pGraph->iTasksCount++;
+   return iTaskId;
+}
+
+static void _startup_graph_execute_task(t_startup_graph_task_context* pContext)
+{
+   t_startup_graph_run_state* pRunState = pContext->pRunState;
+   t_startup_graph_task* pTask = &pRunState->pGraph->tasks[pContext->iTaskId];
+
+   int iPhase = startup_timeline_begin(pTask->szName);
+   pTask->pFunction(pTask->pArg);
+   startup_timeline_end(iPhase);
+
+   pthread_mutex_lock(&pRunState->mutex);
+   pTask->iState = STARTUP_TASK_STATE_DONE;
+   pRunState->uDoneMask |= ((u32)1) << pContext->iTaskId;
+   pRunState->iRunningCount--;
+   pthread_cond_signal(&pRunState->condTaskDone);
+   pthread_mutex_unlock(&pRunState->mutex);
+}
+
+static void* _thread_startup_graph_task(void* pArg)
+{
+   _startup_graph_execute_task((t_startup_graph_task_context*)pArg);
+   return NULL;
+}
+
+int startup_graph_run(t_startup_graph* pGraph, int iMaxParallel)
+{
+   if ( (NULL == pGraph) || (0 == pGraph->iTasksCount) )
+      return 0;
+   if ( iMaxParallel < 1 )
+      iMaxParallel = 1;
+
+   t_startup_graph_run_state runState;
+   t_startup_graph_task_context contexts[STARTUP_GRAPH_MAX_TASKS];
+   pthread_t threads[STARTUP_GRAPH_MAX_TASKS];
+   int bThreadStarted[STARTUP_GRAPH_MAX_TASKS];
+
+   runState.pGraph = pGraph;
+   runState.uDoneMask = 0;
+   runState.iRunningCount = 0;
+   pthread_mutex_init(&runState.mutex, NULL);
+   pthread_cond_init(&runState.condTaskDone, NULL);
+
+   u32 uAllTasksMask = (((u32)1) << pGraph->iTasksCount) - 1;
+   int iCountRun = 0;
+
+   for( int i=0; i<pGraph->iTasksCount; i++ )
+   {
+      pGraph->tasks[i].iState = STARTUP_TASK_STATE_PENDING;
+      contexts[i].pRunState = &runState;
+      contexts[i].iTaskId = i;
+      bThreadStarted[i] = 0;
+   }
+
+   pthread_mutex_lock(&runState.mutex);
+   while ( runState.uDoneMask != uAllTasksMask )
+   {
+      // Start all the tasks that have their dependencies done, in the order they were added
+      for( int i=0; i<pGraph->iTasksCount; i++ )
+      {
+         if ( runState.iRunningCount >= iMaxParallel )
+            break;
+         t_startup_graph_task* pTask = &pGraph->tasks[i];
+         if ( pTask->iState != STARTUP_TASK_STATE_PENDING )
+            continue;
+         if ( (pTask->uDependsOnMask & runState.uDoneMask) != pTask->uDependsOnMask )
+            continue;
+
+         pTask->iState = STARTUP_TASK_STATE_RUNNING;
+         runState.iRunningCount++;
+         iCountRun++;
+         pthread_mutex_unlock(&runState.mutex);
+         if ( 0 == pthread_create(&threads[i], NULL, &_thread_startup_graph_task, &contexts[i]) )
+            bThreadStarted[i] = 1;
+         else
+         {
+            log_softerror_and_alarm("[Startup] Failed to create thread for task [%s]. Running it inline.", pTask->szName);
+            _startup_graph_execute_task(&contexts[i]);
+         }
+         pthread_mutex_lock(&runState.mutex);
+      }
+
+      if ( runState.uDoneMask == uAllTasksMask )
+         break;
+      if ( 0 == runState.iRunningCount )
+      {
+         // Can't happen, as dependencies only point backwards
+         log_softerror_and_alarm("[Startup] No task can run, dependencies can't be satisfied (done: 0x%X).", runState.uDoneMask);
+         break;
+      }
+      pthread_cond_wait(&runState.condTaskDone, &runState.mutex);
+   }
+   pthread_mutex_unlock(&runState.mutex);
+
+   for( int i=0; i<pGraph->iTasksCount; i++ )
+   {
+      if ( bThreadStarted[i] )
+         pthread_join(threads[i], NULL);
+   }
+   pthread_cond_destroy(&runState.condTaskDone);
+   pthread_mutex_destroy(&runState.mutex);
+   return iCountRun;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "base.h"
+
+// Startup timeline: records the begin/end of each startup phase on the monotonic clock,
+// together with the thread that ran it, and dumps a waterfall of all phases to the log.
+// Phases can be recorded from any thread.
+
+// Startup graph: runs a set of startup tasks concurrently, each one as soon as all the tasks
+// it depends on have finished. Dependencies can only point to tasks added before, so the graph
+// is always acyclic. Each task is recorded as a phase on the startup timeline.
+
+#define STARTUP_TIMELINE_MAX_PHASES 64
+#define STARTUP_TIMELINE_MAX_NAME 40
+#define STARTUP_GRAPH_MAX_TASKS 16
+
+typedef void (*startup_task_function_t)(void* pArg);
+
+typedef struct
+{
+   char szName[STARTUP_TIMELINE_MAX_NAME];
+   startup_task_function_t pFunction;
+   void* pArg;
+   u32 uDependsOnMask; // bit i set: depends on task i
+   int iState;
+} t_startup_graph_task;
+
+typedef struct
+{
+   t_startup_graph_task tasks[STARTUP_GRAPH_MAX_TASKS];
+   int iTasksCount;
+} t_startup_graph;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void startup_timeline_init(const char* szProcessName);
+// Returns the phase id, or -1 if the timeline is full
+int startup_timeline_begin(const char* szPhaseName);
+void startup_timeline_end(int iPhaseId);
+u32 startup_timeline_get_elapsed_ms();
+void startup_timeline_log_waterfall();
+
+void startup_graph_init(t_startup_graph* pGraph);
+// Returns the task id (to be used in the dependency mask of the tasks added after it), or -1 on error
+int startup_graph_add_task(t_startup_graph* pGraph, const char* szName, startup_task_function_t pFunction, void* pArg, u32 uDependsOnMask);
+// Runs all the tasks, at most iMaxParallel at a time, and returns when all of them finished.
+// Returns the number of tasks run.
+int startup_graph_run(t_startup_graph* pGraph, int iMaxParallel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,226 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/prctl.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include "trace.h"
+#include "config_file_names.h"
+
+typedef struct
+{
+   const char* szName;
+   const char* szArgs[3];
+} t_trace_event_info;
+
+static const t_trace_event_info s_TraceEventsInfo[TRACE_EVENTS_COUNT] =
+{
+   { "none", { NULL, NULL, NULL } },
+   { "radio_rx_wakeup", { "epoll_events", "packets", NULL } },
+   { "radio_rx_packet", { "interface", "length", "stream_packet_idx" } },
+   { "video_tx_send", { "ready", "max", "sent" } },
+   { "video_tx_packet", { "block_index", "block_packet_index", "retransmission_id" } },
+   { "fec_encode", { "data_packets", "ec_packets", "packet_size" } },
+   { "fec_encode_add", { "packet_index", "ec_rows", "packet_size" } },
+   { "fec_decode", { "data_packets", "missing_packets", "packet_size" } },
+   { "ipc_send", { "channel_id", "length", "result" } },
+   { "ipc_receive", { "channel_id", "length", "msg_type" } }
+};
+
+int g_iTraceEnabled = 0;
+
+static t_trace_shared_mem* s_pTraceSharedMem = NULL;
+static char s_szTraceSharedMemName[64];
+static int s_iTraceSharedMemSize = 0;
+
+// Ring owned by the current thread: NULL until first used, TRACE_NO_RING if no slot was left
+#define TRACE_NO_RING ((t_trace_thread_ring*)1)
+static __thread t_trace_thread_ring* s_pTraceThreadRing = NULL;
+// Releases the ring of a thread when it exits
+static pthread_key_t s_TraceThreadRingKey;
+static pthread_once_t s_TraceThreadRingKeyOnce = PTHREAD_ONCE_INIT;
+static int s_iTraceLoggedNoRing = 0;
+
+void trace_init(const char* szProcessName)
+{
+   if ( NULL != s_pTraceSharedMem )
+      return;
+
+   char szFile[MAX_FILE_PATH_SIZE];
+   strcpy(szFile, FOLDER_CONFIG);
+   strcat(szFile, TRACE_ENABLE_FLAG);
+   if ( access(szFile, R_OK) == -1 )
+      return;
+
+   snprintf(s_szTraceSharedMemName, sizeof(s_szTraceSharedMemName), "%s%s", SHARED_MEM_TRACE_PREFIX, szProcessName);
+   s_iTraceSharedMemSize = sizeof(t_trace_shared_mem);
+
+   int fd = shm_open(s_szTraceSharedMemName, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+   if ( fd < 0 )
+   {
+      log_softerror_and_alarm("[Trace] Failed to create shared memory %s, error: %s", s_szTraceSharedMemName, strerror(errno));
+      return;
+   }
+   // Truncate to 0 first so old records from a previous run are discarded
+   if ( (ftruncate(fd, 0) == -1) || (ftruncate(fd, s_iTraceSharedMemSize) == -1) )
+   {
+      log_softerror_and_alarm("[Trace] Failed to init (ftruncate) shared memory %s", s_szTraceSharedMemName);
+      close(fd);
+      return;
+   }
+   void* pMem = mmap(NULL, s_iTraceSharedMemSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if ( pMem == MAP_FAILED )
+   {
+      log_softerror_and_alarm("[Trace] Failed to map shared memory %s", s_szTraceSharedMemName);
+      return;
+   }
+
+   s_pTraceSharedMem = (t_trace_shared_mem*)pMem;
+   s_pTraceSharedMem->uVersion = TRACE_SHM_VERSION;
+   s_pTraceSharedMem->uProcessId = (u32)getpid();
+   s_pTraceSharedMem->uThreadsCount = 0;
+   strncpy(s_pTraceSharedMem->szProcessName, szProcessName, sizeof(s_pTraceSharedMem->szProcessName)-1);
+   __atomic_store_n(&s_pTraceSharedMem->uMagic, TRACE_SHM_MAGIC, __ATOMIC_RELEASE);
+   __atomic_store_n(&g_iTraceEnabled, 1, __ATOMIC_RELEASE);
+
+   log_line("[Trace] Binary tracing enabled to %s (%d threads x %d records, %d bytes).", s_szTraceSharedMemName, TRACE_MAX_THREADS, TRACE_RING_RECORDS, s_iTraceSharedMemSize);
+}
+
+// The shared memory object is left in place so the rings can still be dumped after the process exits
+void trace_uninit()
+{
+   if ( NULL == s_pTraceSharedMem )
+      return;
+   __atomic_store_n(&g_iTraceEnabled, 0, __ATOMIC_RELEASE);
+   munmap(s_pTraceSharedMem, s_iTraceSharedMemSize);
+   s_pTraceSharedMem = NULL;
+   log_line("[Trace] Binary tracing stopped.");
+}
+
+static void _trace_release_thread_ring(void* pParam)
+{
+   t_trace_thread_ring* pRing = (t_trace_thread_ring*)pParam;
+   if ( (NULL == s_pTraceSharedMem) || (pRing < &s_pTraceSharedMem->threads[0]) || (pRing >= &s_pTraceSharedMem->threads[TRACE_MAX_THREADS]) )
+      return;
+   __atomic_store_n(&pRing->uInUse, 0, __ATOMIC_RELEASE);
+}
+
+static void _trace_create_thread_ring_key()
+{
+   pthread_key_create(&s_TraceThreadRingKey, _trace_release_thread_ring);
+}
+
+// Unused rings are taken first, so records of exited threads are kept as long as possible.
+// After that, rings released by exited threads are reused.
+static t_trace_thread_ring* _trace_get_thread_ring()
+{
+   t_trace_thread_ring* pRing = NULL;
+   u32 uIndex = __atomic_fetch_add(&s_pTraceSharedMem->uThreadsCount, 1, __ATOMIC_RELAXED);
+   if ( uIndex < TRACE_MAX_THREADS )
+   {
+      pRing = &s_pTraceSharedMem->threads[uIndex];
+      __atomic_store_n(&pRing->uInUse, 1, __ATOMIC_RELEASE);
+   }
+   else
+   {
+      __atomic_store_n(&s_pTraceSharedMem->uThreadsCount, TRACE_MAX_THREADS, __ATOMIC_RELAXED);
+      for( int i=0; i<TRACE_MAX_THREADS; i++ )
+      {
+         u32 uFree = 0;
+         if ( __atomic_compare_exchange_n(&s_pTraceSharedMem->threads[i].uInUse, &uFree, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) )
+         {
+            pRing = &s_pTraceSharedMem->threads[i];
+            __atomic_store_n(&pRing->uWritePos, 0, __ATOMIC_RELEASE);
+            break;
+         }
+      }
+   }
+
+   if ( NULL == pRing )
+   {
+      if ( 0 == __atomic_exchange_n(&s_iTraceLoggedNoRing, 1, __ATOMIC_RELAXED) )
+         log_softerror_and_alarm("[Trace] No free trace ring left (%d threads max), thread %u is not traced.", TRACE_MAX_THREADS, (u32)syscall(SYS_gettid));
+      return TRACE_NO_RING;
+   }
+
+   pRing->uThreadId = (u32)syscall(SYS_gettid);
+   prctl(PR_GET_NAME, pRing->szThreadName, 0, 0, 0);
+   pRing->szThreadName[sizeof(pRing->szThreadName)-1] = 0;
+
+   pthread_once(&s_TraceThreadRingKeyOnce, _trace_create_thread_ring_key);
+   pthread_setspecific(s_TraceThreadRingKey, pRing);
+   return pRing;
+}
+
+void trace_record(u16 uEventId, u8 uPhase, u32 uArg1, u32 uArg2, u32 uArg3)
+{
+   if ( NULL == s_pTraceSharedMem )
+      return;
+   if ( NULL == s_pTraceThreadRing )
+      s_pTraceThreadRing = _trace_get_thread_ring();
+   if ( TRACE_NO_RING == s_pTraceThreadRing )
+      return;
+
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+
+   // Single writer per ring: fill the slot, then publish it by advancing the write position
+   u32 uPos = s_pTraceThreadRing->uWritePos;
+   t_trace_record* pRecord = &s_pTraceThreadRing->records[uPos & (TRACE_RING_RECORDS-1)];
+   pRecord->uTimeMicros = (uint64_t)t.tv_sec * 1000000LL + (uint64_t)(t.tv_nsec/1000);
+   pRecord->uEventId = uEventId;
+   pRecord->uPhase = uPhase;
+   pRecord->uReserved = 0;
+   pRecord->uArgs[0] = uArg1;
+   pRecord->uArgs[1] = uArg2;
+   pRecord->uArgs[2] = uArg3;
+   __atomic_store_n(&s_pTraceThreadRing->uWritePos, uPos+1, __ATOMIC_RELEASE);
+}
+
+const char* trace_get_event_name(u16 uEventId)
+{
+   if ( uEventId >= TRACE_EVENTS_COUNT )
+      return "unknown";
+   return s_TraceEventsInfo[uEventId].szName;
+}
+
+const char* trace_get_event_arg_name(u16 uEventId, int iArgIndex)
+{
+   if ( (uEventId >= TRACE_EVENTS_COUNT) || (iArgIndex < 0) || (iArgIndex >= 3) )
+      return NULL;
+   return s_TraceEventsInfo[uEventId].szArgs[iArgIndex];
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "base.h"
+
+// Binary tracing of hot path events.
+// Each thread writes fixed size records (timestamp, event id, phase, 3 args) in its own
+// ring inside a shared memory object, without locks or syscalls other than the clock read.
+// Tracing is off unless the FOLDER_CONFIG/TRACE_ENABLE_FLAG file exists when trace_init() is called.
+// Use ruby_trace_dump to convert the rings to Chrome trace-event JSON (chrome://tracing, Perfetto).
+
+#define SHARED_MEM_TRACE_PREFIX "/SYSTEM_SHARED_MEM_TRACE_"
+
+#define TRACE_SHM_MAGIC 0x45435254
+#define TRACE_SHM_VERSION 2
+#define TRACE_MAX_THREADS 6
+#define TRACE_RING_RECORDS 8192
+
+#define TRACE_PHASE_BEGIN 'B'
+#define TRACE_PHASE_END 'E'
+#define TRACE_PHASE_INSTANT 'i'
+
+#define TRACE_EVENT_NONE 0
+#define TRACE_EVENT_RADIO_RX_WAKEUP 1
+#define TRACE_EVENT_RADIO_RX_PACKET 2
+#define TRACE_EVENT_VIDEO_TX_SEND 3
+#define TRACE_EVENT_VIDEO_TX_PACKET 4
+#define TRACE_EVENT_FEC_ENCODE 5
+#define TRACE_EVENT_FEC_ENCODE_ADD 6
+#define TRACE_EVENT_FEC_DECODE 7
+#define TRACE_EVENT_IPC_SEND 8
+#define TRACE_EVENT_IPC_RECEIVE 9
+#define TRACE_EVENTS_COUNT 10
+
+typedef struct
+{
+   uint64_t uTimeMicros; // CLOCK_MONOTONIC, same time base in all processes
+   u16 uEventId;
+   u8 uPhase;
+   u8 uReserved;
+   u32 uArgs[3];
+} t_trace_record;
+
+typedef struct
+{
+   u32 uThreadId;
+   u32 uInUse; // 0 once the owner thread exited, the ring can then be reused by a new thread
+   char szThreadName[16];
+   u32 uWritePos; // total records written; the ring slot is uWritePos % TRACE_RING_RECORDS
+   t_trace_record records[TRACE_RING_RECORDS];
+} t_trace_thread_ring;
+
+typedef struct
+{
+   u32 uMagic;
+   u32 uVersion;
+   u32 uProcessId;
+   u32 uThreadsCount; // rings used so far
+   char szProcessName[32];
+   t_trace_thread_ring threads[TRACE_MAX_THREADS];
+} t_trace_shared_mem;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int g_iTraceEnabled;
+
+void trace_init(const char* szProcessName);
+void trace_uninit();
+void trace_record(u16 uEventId, u8 uPhase, u32 uArg1, u32 uArg2, u32 uArg3);
+
+const char* trace_get_event_name(u16 uEventId);
+const char* trace_get_event_arg_name(u16 uEventId, int iArgIndex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define TRACE_BEGIN(id, a1, a2, a3) do { if ( g_iTraceEnabled ) trace_record((id), TRACE_PHASE_BEGIN, (u32)(a1), (u32)(a2), (u32)(a3)); } while(0)
+#define TRACE_END(id, a1, a2, a3) do { if ( g_iTraceEnabled ) trace_record((id), TRACE_PHASE_END, (u32)(a1), (u32)(a2), (u32)(a3)); } while(0)
+#define TRACE_INSTANT(id, a1, a2, a3) do { if ( g_iTraceEnabled ) trace_record((id), TRACE_PHASE_INSTANT, (u32)(a1), (u32)(a2), (u32)(a3)); } while(0)
@@ -979,6 +979,10 @@ bool radio_utils_set_interface_frequency(Model* pModel, int iRadioIndex, int iAs
             continue;
          }
       }
+      else if ( hardware_radio_is_simulated_radio(pRadioInfo) )
+      {
+         // Nothing to configure, the frequency is only used to match frames on the simulated link
+      }
       else if ( hardware_radio_is_wifi_radio(pRadioInfo) )
       {
          bool bTryHT40 = false;
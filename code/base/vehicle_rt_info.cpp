@@ -55,7 +55,7 @@ vehicle_runtime_info* vehicle_rt_info_open_for_write()
 void vehicle_rt_info_close(vehicle_runtime_info* pAddress)
 {
    if ( NULL != pAddress )
-      munmap(pAddress, sizeof(vehicle_runtime_info));
+      close_shared_mem(pAddress, sizeof(vehicle_runtime_info));
    //shm_unlink(szName);
 }
 
@@ -996,6 +996,8 @@ const char* str_get_radio_type_description(int iRadioType)
       strcpy(sszNICTypeDescription, "SiK-Radio");
    if ( iRadioType == RADIO_TYPE_SERIAL )
       strcpy(sszNICTypeDescription, "Serial-Radio");
+   if ( iRadioType == RADIO_TYPE_SIMULATED )
+      strcpy(sszNICTypeDescription, "Simulated");
    return sszNICTypeDescription;
 }
 
@@ -1024,6 +1026,8 @@ const char* str_get_radio_driver_description(int iDriverType)
       strcpy(sszNICDriverDescription, "SiK");
    if ( iDriverType == RADIO_HW_DRIVER_SERIAL )
       strcpy(sszNICDriverDescription, "Serial");
+   if ( iDriverType == RADIO_HW_DRIVER_SIMULATED )
+      strcpy(sszNICDriverDescription, "radio_sim");
    return sszNICDriverDescription;
 }
 
@@ -1128,6 +1132,8 @@ void str_get_radio_capabilities_description(u32 flags, char* szOutput)
       strcat(szOutput, "[HIGH CAPACITY]");
    if ( flags & RADIO_HW_CAPABILITY_FLAG_USED_FOR_RELAY )
       strcat(szOutput, "[RELAY]");
+   if ( flags & RADIO_HW_CAPABILITY_FLAG_NO_TX_BATCHING )
+      strcat(szOutput, "[NO TX BATCHING]");
 }
 
 char* str_get_radio_frame_flags_description2(u32 frameFlags)
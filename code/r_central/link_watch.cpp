@@ -866,7 +866,7 @@ int link_watch_loop_processes()
                log_line("Opened shared mem to video player process stats");
                log_line("Video player active %u ms ago", g_TimeNow - pSMPlayer->lastActiveTime);
                log_line("Video player is in blocking operation: %d", pSMPlayer->uInBlockingOperation);
-               munmap(pSMPlayer, sizeof(shared_mem_player_process_stats));
+               close_shared_mem(pSMPlayer, sizeof(shared_mem_player_process_stats));
             }
             else
                log_softerror_and_alarm("Can't open shared mem to video player process stats.");
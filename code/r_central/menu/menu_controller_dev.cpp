@@ -92,6 +92,20 @@ void MenuControllerDev::addItems()
    m_pItemsSelect[6]->setSelectedIndex(pCS->iRadioBypassSocketBuffers);
    m_IndexBypassSocketBuffers = addMenuItem(m_pItemsSelect[6]);
 
+   m_pItemsSelect[7] = new MenuItemSelect("Controller Radio Rx Type", "Receive radio packets using PPCAP or straight from a kernel mmap ring (zero copy).");
+   m_pItemsSelect[7]->addSelection("PPCAP");
+   m_pItemsSelect[7]->addSelection("Mmap Ring");
+   m_pItemsSelect[7]->setIsEditable();
+   m_pItemsSelect[7]->setSelectedIndex(pCS->iRadioRxUsesRing);
+   m_IndexRxRing = addMenuItem(m_pItemsSelect[7]);
+
+   m_pItemsSelect[8] = new MenuItemSelect("Rx Thread Per Radio Interface", "Read and parse each radio interface on its own rx thread, or all of them on a single rx thread.");
+   m_pItemsSelect[8]->addSelection("No");
+   m_pItemsSelect[8]->addSelection("Yes");
+   m_pItemsSelect[8]->setIsEditable();
+   m_pItemsSelect[8]->setSelectedIndex(pCS->iRadioRxThreadPerInterface);
+   m_IndexRxThreadPerInterface = addMenuItem(m_pItemsSelect[8]);
+
    m_pItemsSlider[2] = new MenuItemSlider("Max Radio Packet Size", "Maximum size in bytes that can be set for a radio packet in the user interface.", 100,1500,1250, fSliderWidth);
    m_pItemsSlider[2]->setStep(10);
    m_pItemsSlider[2]->setCurrentValue(pP->iDebugMaxPacketSize);
@@ -204,6 +218,8 @@ void MenuControllerDev::onReturnFromChild(int iChildMenuId, int returnValue)
       pCS->nRetryRetransmissionAfterTimeoutMS = DEFAULT_VIDEO_RETRANS_MINIMUM_RETRY_INTERVAL;
       pCS->nRequestRetransmissionsOnVideoSilenceMs = DEFAULT_VIDEO_RETRANS_REQUEST_ON_VIDEO_SILENCE_MS;
       pCS->iRadioTxUsesPPCAP = DEFAULT_USE_PPCAP_FOR_TX;
+      pCS->iRadioRxUsesRing = DEFAULT_USE_RX_RING;
+      pCS->iRadioRxThreadPerInterface = DEFAULT_RADIO_RX_THREAD_PER_INTERFACE;
       save_ControllerSettings();
       save_Preferences();
       valuesToUI();
@@ -255,6 +271,18 @@ void MenuControllerDev::onSelectItem()
       bUpdatedController = true;
    }
 
+   if ( m_IndexRxRing == m_SelectedIndex )
+   {
+      pCS->iRadioRxUsesRing = m_pItemsSelect[7]->getSelectedIndex();
+      bUpdatedController = true;
+   }
+
+   if ( m_IndexRxThreadPerInterface == m_SelectedIndex )
+   {
+      pCS->iRadioRxThreadPerInterface = m_pItemsSelect[8]->getSelectedIndex();
+      bUpdatedController = true;
+   }
+
    if ( m_IndexPingClockSpeed == m_SelectedIndex )
    {
       pCS->nPingClockSyncFrequency = m_pItemsSlider[7]->getCurrentValue();
@@ -21,6 +21,8 @@ class MenuControllerDev: public Menu
       int m_IndexMaxPacketSize;
       int m_IndexPCAPRadioTx;
       int m_IndexBypassSocketBuffers;
+      int m_IndexRxRing;
+      int m_IndexRxThreadPerInterface;
       int m_IndexPingClockSpeed;
       int m_IndexWiFiChangeDelay;
       int m_IndexRxLoopTimeout;
@@ -70,6 +70,12 @@ MenuVehicleRadioInterface::MenuVehicleRadioInterface(int iRadioInterface)
    m_pItemsSelect[0]->addSelection(L("4W Booster"));
    m_pItemsSelect[0]->setIsEditable();
    m_iIndexBoostMode = addMenuItem(m_pItemsSelect[0]);
+
+   m_pItemsSelect[2] = new MenuItemSelect(L("Batched Tx"), L("Send the video packets of a frame to this radio interface in a single batch. Turn it off if the radio driver has issues with bursts of packets."));
+   m_pItemsSelect[2]->addSelection(L("Off"));
+   m_pItemsSelect[2]->addSelection(L("On"));
+   m_pItemsSelect[2]->setIsEditable();
+   m_iIndexTxBatching = addMenuItem(m_pItemsSelect[2]);
 }
 
 MenuVehicleRadioInterface::~MenuVehicleRadioInterface()
@@ -96,6 +102,11 @@ void MenuVehicleRadioInterface::valuesToUI()
       m_pItemsSelect[0]->setSelectedIndex(1);
    if ( g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[m_iRadioInterface] & RADIO_HW_CAPABILITY_FLAG_HAS_BOOSTER_4W )
       m_pItemsSelect[0]->setSelectedIndex(2);
+
+   if ( g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[m_iRadioInterface] & RADIO_HW_CAPABILITY_FLAG_NO_TX_BATCHING )
+      m_pItemsSelect[2]->setSelectedIndex(0);
+   else
+      m_pItemsSelect[2]->setSelectedIndex(1);
 }
 
 void MenuVehicleRadioInterface::Render()
@@ -172,6 +183,24 @@ void MenuVehicleRadioInterface::onSelectItem()
       if ( uNewFlags == g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[m_iRadioInterface] )
          return;
 
+      u32 uParam = m_iRadioInterface;
+      uParam = uParam | ((uNewFlags << 8) & 0xFFFFFF00);
+      if ( ! handle_commands_send_to_vehicle(COMMAND_ID_SET_RADIO_INTERFACE_CAPABILITIES, uParam, NULL, 0) )
+         valuesToUI();
+      return;
+   }
+
+   if ( m_iIndexTxBatching == m_SelectedIndex )
+   {
+      u32 uNewFlags = g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[m_iRadioInterface];
+      if ( 0 == m_pItemsSelect[2]->getSelectedIndex() )
+         uNewFlags |= RADIO_HW_CAPABILITY_FLAG_NO_TX_BATCHING;
+      else
+         uNewFlags &= ~RADIO_HW_CAPABILITY_FLAG_NO_TX_BATCHING;
+
+      if ( uNewFlags == g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[m_iRadioInterface] )
+         return;
+
       u32 uParam = m_iRadioInterface;
       uParam = uParam | ((uNewFlags << 8) & 0xFFFFFF00);
       if ( ! handle_commands_send_to_vehicle(COMMAND_ID_SET_RADIO_INTERFACE_CAPABILITIES, uParam, NULL, 0) )
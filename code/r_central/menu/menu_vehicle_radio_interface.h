@@ -26,4 +26,5 @@ class MenuVehicleRadioInterface: public Menu
       int m_IndexCardModel;
       int m_IndexName;
       int m_iIndexBoostMode;
+      int m_iIndexTxBatching;
 };
\ No newline at end of file
@@ -80,9 +80,9 @@ MenuVehicleVideoBidirectional::MenuVehicleVideoBidirectional(void)
    m_pItemsSelect[5]->setMargin(dxMargin);
    m_IndexAdaptiveVideoLevel = addMenuItem(m_pItemsSelect[5]);
 
-   m_pItemsSelect[0] = new MenuItemSelect(L("Algorithm"), L("Change the way adaptive video works."));
+   m_pItemsSelect[0] = new MenuItemSelect(L("Algorithm"), L("Change the way adaptive video works. Default: reacts to the EC and lost blocks. Predictive: forecasts the link quality from the signal, losses and retransmissions trends and picks the best video profile for the next moments."));
    m_pItemsSelect[0]->addSelection(L("Default"));
-   m_pItemsSelect[0]->addSelection(L("New"));
+   m_pItemsSelect[0]->addSelection(L("Predictive"));
    m_pItemsSelect[0]->setIsEditable();
    m_pItemsSelect[0]->setMargin(dxMargin);
    m_IndexAdaptiveAlgorithm = addMenuItem(m_pItemsSelect[0]);
@@ -127,8 +127,8 @@ void MenuVehicleVideoBidirectional::valuesToUI()
    if ( hardware_board_is_goke(g_pCurrentModel->hwCapabilities.uBoardType) )
       adaptiveVideo = 0;
 
-   m_pItemsSelect[0]->setSelection( (g_pCurrentModel->video_params.uVideoExtraFlags & VIDEO_FLAG_NEW_ADAPTIVE_ALGORITHM)?1:0);
-   m_pItemsSelect[0]->setEnabled(false);
+   m_pItemsSelect[0]->setSelection( (g_pCurrentModel->video_params.uVideoExtraFlags & VIDEO_FLAG_PREDICTIVE_ADAPTIVE_VIDEO)?1:0);
+   m_pItemsSelect[0]->setEnabled(adaptiveVideo?true:false);
 
    if ( g_pCurrentModel->video_link_profiles[g_pCurrentModel->video_params.user_selected_video_link_profile].uProfileEncodingFlags & VIDEO_PROFILE_ENCODING_FLAG_ENABLE_RETRANSMISSIONS )
    {
@@ -297,9 +297,9 @@ void MenuVehicleVideoBidirectional::onSelectItem()
       }
       video_parameters_t paramsNew;
       memcpy(&paramsNew, &g_pCurrentModel->video_params, sizeof(video_parameters_t));
-      paramsNew.uVideoExtraFlags &= ~VIDEO_FLAG_NEW_ADAPTIVE_ALGORITHM;
+      paramsNew.uVideoExtraFlags &= ~VIDEO_FLAG_PREDICTIVE_ADAPTIVE_VIDEO;
       if ( 1 == m_pItemsSelect[0]->getSelectedIndex() )
-         paramsNew.uVideoExtraFlags |= VIDEO_FLAG_NEW_ADAPTIVE_ALGORITHM;
+         paramsNew.uVideoExtraFlags |= VIDEO_FLAG_PREDICTIVE_ADAPTIVE_VIDEO;
 
       if ( ! handle_commands_send_to_vehicle(COMMAND_ID_SET_VIDEO_PARAMS, 0, (u8*)&paramsNew, sizeof(video_parameters_t)) )
          valuesToUI();    
@@ -458,11 +458,31 @@ float osd_course_to(double lat1, double long1, double lat2, double long2)
     */
 }
 
-float osd_show_value(float x, float y, const char* szValue, u32 fontId)
+// Values are drawn as retained render elements, identified by position and font,
+// so unchanged values are not rasterized again on each frame.
+static void _osd_draw_value_text(float x, float y, const char* szValue, u32 fontId, float fWidth)
 {
-   float w = 0;
+   if ( (NULL == szValue) || (0 == szValue[0]) )
+   {
+      g_pRenderEngine->drawText(x,y, fontId, szValue);
+      return;
+   }
+   u32 uElementId = ((u32)(int)(x*8192.0)) * 8191 + (u32)(int)(y*8192.0);
+   uElementId = uElementId * 31 + fontId;
+   if ( (0 == uElementId) || (0xFFFFFFFF == uElementId) )
+      uElementId = 1;
+   u32 uContentHash = base_compute_crc32((u8*)szValue, strlen(szValue)) ^ fontId;
+
+   if ( ! g_pRenderEngine->startRetainedElement(uElementId, x, y, fWidth, g_pRenderEngine->textHeight(fontId), uContentHash) )
+      return;
    g_pRenderEngine->drawText(x,y, fontId, szValue);
-   w += g_pRenderEngine->textWidth(fontId, szValue);
+   g_pRenderEngine->endRetainedElement();
+}
+
+float osd_show_value(float x, float y, const char* szValue, u32 fontId)
+{
+   float w = g_pRenderEngine->textWidth(fontId, szValue);
+   _osd_draw_value_text(x, y, szValue, fontId, w);
    return w;
 }
 
@@ -501,7 +521,7 @@ float osd_show_value_sufix_left(float x, float y, const char* szValue, const cha
 float osd_show_value_left(float x, float y, const char* szValue, u32 fontId)
 {
    float w = g_pRenderEngine->textWidth(fontId, szValue);
-   g_pRenderEngine->drawText(x-w,y, fontId, szValue);
+   _osd_draw_value_text(x-w, y, szValue, fontId, w);
    return w;
 }
 
@@ -510,7 +530,7 @@ float osd_show_value_centered(float x, float y, const char* szValue, u32 fontId)
 {
    float w = g_pRenderEngine->textWidth(fontId, szValue);
 
-   g_pRenderEngine->drawText(x-0.5*w,y, fontId, szValue);
+   _osd_draw_value_text(x-0.5*w, y, szValue, fontId, w);
    
    return w;
 }
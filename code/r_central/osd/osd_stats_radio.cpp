@@ -1188,6 +1188,7 @@ float osd_render_stats_local_radio_links_get_height(shared_mem_radio_stats* pRad
    {
       height += 3 * height_text*s_OSDStatsLineSpacing + 0.3*height_text;
       height += height_text_small*s_OSDStatsLineSpacing; // Ping frequency
+      height += height_text_small*s_OSDStatsLineSpacing; // EC decode cache
       height += height_text_small*s_OSDStatsLineSpacing; // Last response recv from vehicle
 
       height += hGraph + height_text_small*s_OSDStatsLineSpacing; // Radio rx queue graph
@@ -1563,6 +1564,14 @@ float osd_render_stats_local_radio_links( float xPos, float yPos, const char* sz
          sprintf(szBuff, "%d ms", ping_interval_ms);
          g_pRenderEngine->setColors(get_Color_Dev());
          _osd_stats_draw_line(xPos, rightMargin, y, s_idFontStatsSmall, "Clock Sync Freq:", szBuff);
+         y += height_text_small*s_OSDStatsLineSpacing;
+
+         u32 uTotalLookups = pVDS->uFECDecodeCacheHits + pVDS->uFECDecodeCacheMisses;
+         if ( uTotalLookups > 0 )
+            sprintf(szBuff, "%u/%u (%u%%)", pVDS->uFECDecodeCacheHits, pVDS->uFECDecodeCacheMisses, (u32)(100.0*(double)pVDS->uFECDecodeCacheHits/(double)uTotalLookups));
+         else
+            strcpy(szBuff, "N/A");
+         _osd_stats_draw_line(xPos, rightMargin, y, s_idFontStatsSmall, "EC Decode Cache Hit/Miss:", szBuff);
          osd_set_colors();
          y += height_text_small*s_OSDStatsLineSpacing;
       }
@@ -620,7 +620,7 @@ void render_all_with_menus(u32 timeNow, bool bRenderMenus, bool bForceBackground
          g_pRenderEngine->setFill(0,0,0,0.5);
          g_pRenderEngine->setStroke(0,0,0,0);
          g_pRenderEngine->disableRectBlending();
-         g_pRenderEngine->drawRect(xPos, yPos-0.003, 0.46, 0.03);
+         g_pRenderEngine->drawRect(xPos, yPos-0.003, 0.56, 0.03);
       }
 
       osd_set_colors_text(get_Color_Dev());
@@ -655,6 +655,10 @@ void render_all_with_menus(u32 timeNow, bool bRenderMenus, bool bForceBackground
          xPos += 0.095*osd_getScaleOSD();
          sprintf(szBuff, "OSD: %d ms/sec", (int)(s_iMicroTimeOSDRender*s_iRubyFPS/1000.0));
          osd_show_value(xPos, yPos, szBuff, g_idFontOSDSmall );
+
+         xPos += 0.095*osd_getScaleOSD();
+         sprintf(szBuff, "OSD: %u%% dirty", g_pRenderEngine->getLastFrameDirtyAreaPercent());
+         osd_show_value(xPos, yPos, szBuff, g_idFontOSDSmall );
       }
       g_pRenderEngine->enableRectBlending();
    }
@@ -1882,8 +1886,29 @@ void start_loop()
 }
 
 
+// Last seqlock sequence copied from each shared memory object (see shared_mem_read_if_changed)
+static u32 s_uSeqSMControllerRTInfo = 0;
+static u32 s_uSeqSMVehicleRTInfo = 0;
+static u32 s_uSeqSMRouterVehiclesRuntimeInfo = 0;
+static u32 s_uSeqSMRadioStats = 0;
+static u32 s_uSeqSMHistoryRxStats = 0;
+static u32 s_uSeqSMVideoFramesStatsOutput = 0;
+static u32 s_uSeqSMVideoDecodeStats = 0;
+static u32 s_uSeqSMRadioRxQueueInfo = 0;
+static u32 s_uSeqSMVideoLinkGraphs = 0;
+
 void clear_shared_mems()
 {
+   s_uSeqSMControllerRTInfo = 0;
+   s_uSeqSMVehicleRTInfo = 0;
+   s_uSeqSMRouterVehiclesRuntimeInfo = 0;
+   s_uSeqSMRadioStats = 0;
+   s_uSeqSMHistoryRxStats = 0;
+   s_uSeqSMVideoFramesStatsOutput = 0;
+   s_uSeqSMVideoDecodeStats = 0;
+   s_uSeqSMRadioRxQueueInfo = 0;
+   s_uSeqSMVideoLinkGraphs = 0;
+
    memset(&g_SM_VideoFramesStatsOutput, 0, sizeof(shared_mem_video_frames_stats));
    //memset(&g_SM_VideoInfoStatsRadioIn, 0, sizeof(shared_mem_video_frames_stats));
    //memset(&g_VideoInfoStatsFromVehicleCameraOut, 0, sizeof(shared_mem_video_frames_stats));
@@ -1965,8 +1990,8 @@ void synchronize_shared_mems()
          log_line("Opened shared mem to controller runtime info for reading.");
    }
    if ( NULL != g_pSMControllerRTInfo )
+   if ( 0 != shared_mem_read_if_changed(&g_SMControllerRTInfo, g_pSMControllerRTInfo, sizeof(controller_runtime_info), &s_uSeqSMControllerRTInfo) )
    {
-      memcpy((u8*)&g_SMControllerRTInfo, g_pSMControllerRTInfo, sizeof(controller_runtime_info));
       if ( (g_SMControllerRTInfo.iCurrentIndex != g_SMControllerRTInfo.iCurrentIndex2) ||
            (g_SMControllerRTInfo.iCurrentIndex2 != g_SMControllerRTInfo.iCurrentIndex3) )
       {
@@ -1983,7 +2008,7 @@ void synchronize_shared_mems()
          log_line("Opened shared mem to vehicle runtime info for reading.");
    }
    if ( NULL != g_pSMVehicleRTInfo )
-      memcpy((u8*)&g_SMVehicleRTInfo, g_pSMVehicleRTInfo, sizeof(vehicle_runtime_info));
+      shared_mem_read_if_changed(&g_SMVehicleRTInfo, g_pSMVehicleRTInfo, sizeof(vehicle_runtime_info), &s_uSeqSMVehicleRTInfo);
 
 
    if ( g_bFreezeOSD )
@@ -2000,12 +2025,12 @@ void synchronize_shared_mems()
       memcpy((u8*)&g_SM_DownstreamInfoRC, g_pSM_DownstreamInfoRC, sizeof(t_packet_header_rc_info_downstream));
 
    if ( NULL != g_pSM_RouterVehiclesRuntimeInfo )
-      memcpy((u8*)&g_SM_RouterVehiclesRuntimeInfo, g_pSM_RouterVehiclesRuntimeInfo, sizeof(shared_mem_router_vehicles_runtime_info));
+      shared_mem_read_if_changed(&g_SM_RouterVehiclesRuntimeInfo, g_pSM_RouterVehiclesRuntimeInfo, sizeof(shared_mem_router_vehicles_runtime_info), &s_uSeqSMRouterVehiclesRuntimeInfo);
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)&g_SM_RadioStats, g_pSM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_read_if_changed(&g_SM_RadioStats, g_pSM_RadioStats, sizeof(shared_mem_radio_stats), &s_uSeqSMRadioStats);
    
    if ( NULL != g_pSM_HistoryRxStats )
-      memcpy((u8*)&g_SM_HistoryRxStats, g_pSM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
+      shared_mem_read_if_changed(&g_SM_HistoryRxStats, g_pSM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist), &s_uSeqSMHistoryRxStats);
    
    if ( pCS->iDeveloperMode )
    if ( NULL != g_pCurrentModel )
@@ -2013,21 +2038,21 @@ void synchronize_shared_mems()
    {
       if ( NULL != g_pSM_VideoFramesStatsOutput )
       if ( g_TimeNow >= g_SM_VideoFramesStatsOutput.uLastTimeStatsUpdate + 200 )
-         memcpy((u8*)&g_SM_VideoFramesStatsOutput, g_pSM_VideoFramesStatsOutput, sizeof(shared_mem_video_frames_stats));
+         shared_mem_read_if_changed(&g_SM_VideoFramesStatsOutput, g_pSM_VideoFramesStatsOutput, sizeof(shared_mem_video_frames_stats), &s_uSeqSMVideoFramesStatsOutput);
       //if ( NULL != g_pSM_VideoInfoStatsRadioIn )
       //if ( g_TimeNow >= g_SM_VideoInfoStatsRadioIn.uLastTimeStatsUpdate + 200 )
       //   memcpy((u8*)&g_SM_VideoInfoStatsRadioIn, g_pSM_VideoInfoStatsRadioIn, sizeof(shared_mem_video_frames_stats));
    }
 
    if ( NULL != g_pSM_VideoDecodeStats )
-      memcpy((u8*)&g_SM_VideoDecodeStats, g_pSM_VideoDecodeStats, sizeof(shared_mem_video_stream_stats_rx_processors));
+      shared_mem_read_if_changed(&g_SM_VideoDecodeStats, g_pSM_VideoDecodeStats, sizeof(shared_mem_video_stream_stats_rx_processors), &s_uSeqSMVideoDecodeStats);
    if ( NULL != g_pSM_RadioRxQueueInfo )
-      memcpy((u8*)&g_SM_RadioRxQueueInfo, g_pSM_RadioRxQueueInfo, sizeof(shared_mem_radio_rx_queue_info));
+      shared_mem_read_if_changed(&g_SM_RadioRxQueueInfo, g_pSM_RadioRxQueueInfo, sizeof(shared_mem_radio_rx_queue_info), &s_uSeqSMRadioRxQueueInfo);
    // To fix
    //if ( NULL != g_pSM_VideoLinkStats )
    //   memcpy((u8*)&g_SM_VideoLinkStats, g_pSM_VideoLinkStats, sizeof(shared_mem_video_link_stats_and_overwrites));
    if ( NULL != g_pSM_VideoLinkGraphs )
-      memcpy((u8*)&g_SM_VideoLinkGraphs, g_pSM_VideoLinkGraphs, sizeof(shared_mem_video_link_graphs));
+      shared_mem_read_if_changed(&g_SM_VideoLinkGraphs, g_pSM_VideoLinkGraphs, sizeof(shared_mem_video_link_graphs), &s_uSeqSMVideoLinkGraphs);
    if ( NULL != g_pSM_RCIn )
       memcpy((u8*)&g_SM_RCIn, g_pSM_RCIn, sizeof(t_shared_mem_i2c_controller_rc_in));
    if ( NULL != g_pSMVoltage )
@@ -46,6 +46,7 @@
 #include "../base/hardware_files.h"
 #include "../base/hardware_camera.h"
 #include "../base/hw_procs.h"
+#include "../base/startup_timeline.h"
 #include "../base/hardware_radio_serial.h"
 #include "../base/vehicle_settings.h"
 #include "../radio/radioflags.h"
@@ -1154,16 +1155,8 @@ void _step_check_binaries_and_resources()
    #endif
 }
 
-void _step_load_init_devices()
+void _step_log_devices()
 {
-   #ifdef HW_PLATFORM_RADXA
-   hw_execute_bash_command("ip link set wlx down 2>&1 1>/dev/null", NULL);
-   #endif
-
-   #ifdef HW_CAPABILITY_I2C
-   hw_execute_bash_command("modprobe i2c-dev", NULL);
-   #endif
-
    char szOutput[4096];
    hw_execute_bash_command_raw("lsusb", szOutput);
    strcat(szOutput, "\n*END*\n");
@@ -1174,8 +1167,14 @@ void _step_load_init_devices()
    strcat(szOutput, "\n*END*\n");
    log_line("Loaded Modules:");
    log_line(szOutput);      
-      
+}
+
+void _step_scan_i2c_devices()
+{
    #ifdef HW_CAPABILITY_I2C
+   hw_execute_bash_command("modprobe i2c-dev", NULL);
+
+   char szOutput[4096];
    hw_execute_bash_command_raw("i2cdetect -l", szOutput);
    strcat(szOutput, "\n*END*\n");
    log_line("I2C buses:");
@@ -1203,10 +1202,12 @@ void _step_load_init_devices()
       log_line("Ruby: Done finding external I2C devices add-ons. Found %d known devices of which %d are configurable.", iKnown, iConfigurable );
       printf("Ruby: Done finding external I2C devices add-ons. Found %d known devices of which %d are configurable.\n", iKnown, iConfigurable );
    }
-   #endif
-
    fflush(stdout);
+   #endif
+}
 
+void _step_init_serial_ports()
+{
    log_line("Ruby: Finding serial ports...");
    printf("Ruby: Finding serial ports...\n");
    fflush(stdout);
@@ -1227,9 +1228,21 @@ void  _step_load_init_radios()
    hardware_load_radio_info_into_buffers(&iHwRadiosCountPrev, &iHwRadiosSupportedCountPrev, &sRadioInfoPrev[0]);
    log_line("Loaded previous radio configuration.");
    
+   #ifdef HW_PLATFORM_RADXA
+   hw_execute_bash_command("ip link set wlx down 2>&1 1>/dev/null", NULL);
+   #endif
+
    hardware_radio_load_radio_modules(1);
-     
-   hardware_sleep_ms(500);
+
+   // Wait for the first radio interface to show up, at most as long as the old fixed delay
+   u32 uTimeStartWait = get_current_timestamp_ms();
+   while ( access("/sys/class/net/wlan0", F_OK) == -1 )
+   {
+      if ( get_current_timestamp_ms() >= uTimeStartWait + 500 )
+         break;
+      hardware_sleep_ms(20);
+   }
+   log_line("Waited %u ms for the radio interfaces to show up.", get_current_timestamp_ms() - uTimeStartWait);
 
    char szComm[256];
    char szBuff[256];
@@ -1422,6 +1435,75 @@ void _step_initialize_check_vehicle()
    log_line("Done doing initialization checks on vehicle.");
 }
 
+static bool s_bModelValidatedAtStartup = false;
+
+void _step_validate_model()
+{
+   if ( (! s_isVehicle) || g_bIsFirstBoot )
+      return;
+
+   char szFile[MAX_FILE_PATH_SIZE];
+   strcpy(szFile, FOLDER_CONFIG);
+   strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
+   if ( access(szFile, R_OK) == -1 )
+   {
+      log_line("No vehicle model file to validate yet.");
+      return;
+   }
+   if ( modelVehicle.loadFromFile(szFile, true) )
+   {
+      s_bModelValidatedAtStartup = true;
+      log_line("Validated current vehicle model file.");
+   }
+   else
+      log_softerror_and_alarm("Current vehicle model file is invalid. It will be reset to defaults.");
+}
+
+static void _task_log_devices(void* pArg) { _step_log_devices(); }
+#ifdef HW_CAPABILITY_I2C
+static void _task_scan_i2c_devices(void* pArg) { _step_scan_i2c_devices(); }
+#endif
+static void _task_init_serial_ports(void* pArg) { _step_init_serial_ports(); }
+static void _task_detect_camera(void* pArg) { hardware_getCameraType(); }
+static void _task_enumerate_radios(void* pArg) { _step_enumerate_radios(); }
+static void _task_validate_model(void* pArg) { _step_validate_model(); }
+
+static void _task_load_radio_drivers(void* pArg)
+{
+   if ( ! g_bIsFirstBoot )
+      _check_update_drivers_on_update();
+   _step_load_init_radios();
+}
+
+// Runs the hardware detection steps that don't depend on each other concurrently:
+//   device logs, I2C scan -> camera detection, serial ports + radio drivers -> radio enumeration -> model validation
+void _step_detect_hardware()
+{
+   t_startup_graph graph;
+   startup_graph_init(&graph);
+
+   // Camera detection looks for HDMI/Veye cameras on the I2C busses
+   u32 uCameraDeps = 0;
+   startup_graph_add_task(&graph, "device logs", _task_log_devices, NULL, 0);
+   #ifdef HW_CAPABILITY_I2C
+   int iTaskI2C = startup_graph_add_task(&graph, "i2c scan", _task_scan_i2c_devices, NULL, 0);
+   uCameraDeps = ((u32)1) << iTaskI2C;
+   #endif
+   int iTaskSerial = startup_graph_add_task(&graph, "serial ports", _task_init_serial_ports, NULL, 0);
+   int iTaskDrivers = startup_graph_add_task(&graph, "radio drivers", _task_load_radio_drivers, NULL, 0);
+
+   startup_graph_add_task(&graph, "camera detection", _task_detect_camera, NULL, uCameraDeps);
+
+   // SiK and serial radios are probed on the serial ports
+   int iTaskRadios = startup_graph_add_task(&graph, "radio enumeration", _task_enumerate_radios, NULL, (((u32)1) << iTaskSerial) | (((u32)1) << iTaskDrivers));
+
+   // Loading the model validates its radio interfaces settings against the detected radios
+   startup_graph_add_task(&graph, "model validation", _task_validate_model, NULL, ((u32)1) << iTaskRadios);
+
+   int iCount = startup_graph_run(&graph, STARTUP_GRAPH_MAX_TASKS);
+   log_line("Done detecting hardware (%d startup tasks run).", iCount);
+}
+
 void handle_sigint(int sig) 
 { 
    log_line("Caught signal to stop: %d\n", sig);
@@ -1441,14 +1523,19 @@ int main(int argc, char *argv[])
 
    char szFile[MAX_FILE_PATH_SIZE];
 
+   startup_timeline_init("ruby_start");
+   int iStartupPhase = -1;
+
    _log_oipc_boot_rotate();
    
    #if defined(HW_PLATFORM_OPENIPC_CAMERA)
+   iStartupPhase = startup_timeline_begin("boot start delay");
    for( int i=0; i<10; i++ )
    {
       hardware_sleep_ms(500);
       _log_oipc_boot_step("Boot start delay");
    }
+   startup_timeline_end(iStartupPhase);
    #endif
    strcpy(szFile, FOLDER_CONFIG);
    strcat(szFile, "debug");
@@ -1460,8 +1547,10 @@ int main(int argc, char *argv[])
       _log_oipc_boot_step("Debug wait done");
    }
 
+   iStartupPhase = startup_timeline_begin("find console");
    if ( ! _step_find_console() )
       return 0;
+   startup_timeline_end(iStartupPhase);
 
    _log_oipc_boot_step("Console found");
 
@@ -1470,6 +1559,7 @@ int main(int argc, char *argv[])
    printf("\nRuby: Start (v %d.%d b.%d) r%d\n", SYSTEM_SW_VERSION_MAJOR, SYSTEM_SW_VERSION_MINOR/10, SYSTEM_SW_BUILD_NUMBER, s_iBootCount);
    fflush(stdout);
 
+   iStartupPhase = startup_timeline_begin("check file system");
    if ( _step_check_file_system() < 0 )
    {
       #if defined HW_PLATFORM_OPENIPC_CAMERA
@@ -1482,12 +1572,17 @@ int main(int argc, char *argv[])
    //initLocalizationData();
    //#endif
    
+   startup_timeline_end(iStartupPhase);
    _log_oipc_boot_step("Done check files.");
 
+   iStartupPhase = startup_timeline_begin("detect board");
    init_hardware_only_detection_pins();
    hardware_detectBoardAndSystemType();
+   startup_timeline_end(iStartupPhase);
    
+   iStartupPhase = startup_timeline_begin("check binaries");
    _step_check_binaries_and_resources();
+   startup_timeline_end(iStartupPhase);
    _log_oipc_boot_step("Done check binaries.");
 
    char szComm[1204];
@@ -1495,17 +1590,38 @@ int main(int argc, char *argv[])
    szOutput[0] = 0;
 
    if ( g_bIsFirstBoot )
+   {
+      iStartupPhase = startup_timeline_begin("first boot pre init");
       do_first_boot_pre_initialization();
+      startup_timeline_end(iStartupPhase);
+   }
 
-   _step_load_init_devices();
+   sprintf(szComm, "rm -rf %s%s", FOLDER_RUBY_TEMP, FILE_CONFIG_SYSTEM_TYPE);
+   hw_execute_bash_command_silent(szComm, NULL);
+   sprintf(szComm, "rm -rf %s%s", FOLDER_RUBY_TEMP, FILE_CONFIG_CAMERA_TYPE);
+   hw_execute_bash_command_silent(szComm, NULL);
 
-   _log_oipc_boot_step("Done init devices.");
+   if ( access( FILE_FORCE_RESET, R_OK ) != -1 )
+   {
+      unlink(FILE_FORCE_RESET);
+      hw_execute_bash_command("rm -rf config/*", NULL);
+      sprintf(szComm, "touch %s%s", FOLDER_CONFIG, FILE_CONFIG_FIRST_BOOT);
+      hw_execute_bash_command(szComm, NULL);
+      hardware_reboot();
+      hardware_sleep_ms(900);
+   }
 
-   if ( ! g_bIsFirstBoot )
-      _check_update_drivers_on_update();
-   _step_load_init_radios();
+   board_type = (hardware_getBoardType() & BOARD_TYPE_MASK);
+   detectSystemType();
+
+   // The hardware detection tasks log from several threads
+   log_enable_async();
 
-   _log_oipc_boot_step("Done init radios.");
+   iStartupPhase = startup_timeline_begin("detect hardware");
+   _step_detect_hardware();
+   startup_timeline_end(iStartupPhase);
+
+   _log_oipc_boot_step("Done init devices and radios.");
 
    #ifdef HW_PLATFORM_RADXA
    if ( ! g_bIsFirstBoot )
@@ -1524,32 +1640,10 @@ int main(int argc, char *argv[])
    }
    #endif
 
-   sprintf(szComm, "rm -rf %s%s", FOLDER_RUBY_TEMP, FILE_CONFIG_SYSTEM_TYPE);
-   hw_execute_bash_command_silent(szComm, NULL);
-   sprintf(szComm, "rm -rf %s%s", FOLDER_RUBY_TEMP, FILE_CONFIG_CAMERA_TYPE);
-   hw_execute_bash_command_silent(szComm, NULL);
-
-   if ( access( FILE_FORCE_RESET, R_OK ) != -1 )
-   {
-      unlink(FILE_FORCE_RESET);
-      hw_execute_bash_command("rm -rf config/*", NULL);
-      sprintf(szComm, "touch %s%s", FOLDER_CONFIG, FILE_CONFIG_FIRST_BOOT);
-      hw_execute_bash_command(szComm, NULL);
-      hardware_reboot();
-      hardware_sleep_ms(900);
-   }
-
-   board_type = (hardware_getBoardType() & BOARD_TYPE_MASK);
-
-   // Detect hardware camera
-   hardware_getCameraType();
-
    #if defined (HW_PLATFORM_RASPBERRY) || defined (HW_PLATFORM_RADXA)
    hw_execute_ruby_process(NULL, "ruby_initdhcp", NULL, NULL);
    #endif
 
-   detectSystemType();
-
    #if defined (HW_PLATFORM_RASPBERRY) || defined (HW_PLATFORM_RADXA)
    if ( g_bDebug )
    if ( hardware_is_station() )
@@ -1567,10 +1661,6 @@ int main(int argc, char *argv[])
 
    log_line("Starting Ruby system...");
    fflush(stdout);
-   
-   _step_enumerate_radios();
-   
-   _log_oipc_boot_step("Done enumerate radios.");
 
    // Reenable serial ports that where used for SiK radio and now are just regular serial ports
    
@@ -1641,6 +1731,7 @@ int main(int argc, char *argv[])
       {
          printf("Ruby: No supported radio interfaces found. Total radio interfaces found: %d\n", hardware_get_radio_interfaces_count());
          fflush(stdout);
+         startup_timeline_log_waterfall();
 
          if ( NULL != s_pSemaphoreStarted )
             sem_close(s_pSemaphoreStarted);
@@ -1693,6 +1784,7 @@ int main(int argc, char *argv[])
    }
 
    _log_oipc_boot_step("Check processes versions...");
+   iStartupPhase = startup_timeline_begin("check versions");
 
    hw_execute_ruby_process_wait(NULL, "ruby_start", "-ver", szOutput, 1);
    log_line("ruby_start: [%s]", szOutput);
@@ -1714,7 +1806,9 @@ int main(int argc, char *argv[])
       log_line("ruby_central: [%s]", szOutput);
    }
 
+   startup_timeline_end(iStartupPhase);
    _log_oipc_boot_step("Check for update files...");
+   iStartupPhase = startup_timeline_begin("check updates");
 
    _check_for_update_from_boot();
 
@@ -1724,8 +1818,10 @@ int main(int argc, char *argv[])
 
    if ( s_isVehicle )
    {
+      // Already loaded by the model validation startup task, if valid
       strcpy(szFile, FOLDER_CONFIG);
       strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
+      if ( ! s_bModelValidatedAtStartup )
       if ( ! modelVehicle.loadFromFile(szFile, true) )
       {
          modelVehicle.resetToDefaults(true);
@@ -1811,6 +1907,8 @@ int main(int argc, char *argv[])
       }
    }
 
+   startup_timeline_end(iStartupPhase);
+
    strcpy(szFile, FOLDER_CONFIG);
    strcat(szFile, FILE_CONFIG_CURRENT_VERSION);
    FILE* fd = fopen(szFile, "w");
@@ -1853,6 +1951,7 @@ int main(int argc, char *argv[])
    }
  
    _log_oipc_boot_step("Check for hw changes...");
+   iStartupPhase = startup_timeline_begin("check hw changes");
    printf("Ruby: Checking for HW changes...");
    log_line("Checking for HW changes...");
    fflush(stdout);
@@ -1874,8 +1973,12 @@ int main(int argc, char *argv[])
    log_line("Checking for HW changes complete.");
    fflush(stdout);
 
+   startup_timeline_end(iStartupPhase);
+
    _log_oipc_boot_step("Init IPC...");
+   iStartupPhase = startup_timeline_begin("init IPC");
    ruby_init_ipc_channels();
+   startup_timeline_end(iStartupPhase);
    _log_oipc_boot_step("Done init IPC.");
    
    if ( s_isVehicle )
@@ -1913,11 +2016,13 @@ int main(int argc, char *argv[])
          }
       }
    }
+   iStartupPhase = startup_timeline_begin("init radio interfaces");
    hw_execute_ruby_process_wait(NULL, "ruby_start", szParams, NULL, 1);
    
    log_line("Reloading hardware radio configuration after radio init step completed...");
    hardware_load_radio_info();
    _check_power_levels_of_current_cards(&sRadioInfoPrev[0], iHwRadiosCountPrev);
+   startup_timeline_end(iStartupPhase);
 
    printf("Ruby: Starting main process...\n");
    log_line("Starting main process...");
@@ -2068,6 +2173,7 @@ int main(int argc, char *argv[])
    }
 
    _log_oipc_boot_step("Done started processes.");
+   startup_timeline_log_waterfall();
    
    printf("Ruby: Started processes. Checking if all ok...\n");
    fflush(stdout);
@@ -34,11 +34,13 @@
 #include "../base/config.h"
 #include "../base/models_list.h"
 #include "../base/shared_mem_controller_only.h"
+#include "../base/utils.h"
 #include "../common/string_utils.h"
 #include "../radio/radiopackets2.h"
 #include "../radio/radiopacketsqueue.h"
 
 #include "adaptive_video.h"
+#include "adaptive_video_engine.h"
 #include "test_link_params.h"
 #include "shared_vars.h"
 #include "shared_vars_state.h"
@@ -65,26 +67,126 @@ void adaptive_video_pause(u32 uMilisec)
    }
 }
 
-int _adaptive_video_get_lower_video_profile(int iVideoProfile)
+// Predictive engine state and trace recording, per vehicle runtime index
+typedef struct
 {
-   if ( iVideoProfile == VIDEO_PROFILE_BEST_PERF ||
-        iVideoProfile == VIDEO_PROFILE_HIGH_QUALITY ||
-        iVideoProfile == VIDEO_PROFILE_USER )
-     return VIDEO_PROFILE_MQ;
+   u32 uVehicleId;
+   t_adaptive_video_mpc_state stateMPC;
+   t_adaptive_video_profile_info profiles[ADAPTIVE_VIDEO_MAX_PROFILES];
+   int iCountProfiles;
+   u32 uTimeLastUpdateProfiles;
+   int iLastSliceIndex;
+   FILE* fdTrace;
+} t_adaptive_video_vehicle_engine;
+
+static t_adaptive_video_vehicle_engine s_AdaptiveVideoEngines[MAX_CONCURENT_VEHICLES];
+
+// Candidate profiles for the predictive engine, from the lowest adaptive profile to the user selected one
+static void _adaptive_video_update_profiles(Model* pModel, t_adaptive_video_vehicle_engine* pEngine)
+{
+   int iUserProfile = pModel->video_params.user_selected_video_link_profile;
+   int iVideoProfiles[3];
+   int iCount = 0;
+   if ( ! ((pModel->video_link_profiles[iUserProfile].uProfileEncodingFlags) & VIDEO_PROFILE_ENCODING_FLAG_USE_MEDIUM_ADAPTIVE_VIDEO) )
+   if ( iUserProfile != VIDEO_PROFILE_LQ )
+      iVideoProfiles[iCount++] = VIDEO_PROFILE_LQ;
+   if ( (iUserProfile != VIDEO_PROFILE_MQ) && (iUserProfile != VIDEO_PROFILE_LQ) )
+      iVideoProfiles[iCount++] = VIDEO_PROFILE_MQ;
+   iVideoProfiles[iCount++] = iUserProfile;
+
+   for( int i=0; i<iCount; i++ )
+   {
+      t_adaptive_video_profile_info* pInfo = &(pEngine->profiles[i]);
+      int iProfile = iVideoProfiles[i];
+      pInfo->iVideoProfile = iProfile;
+      pModel->get_video_profile_ec_scheme(iProfile, &pInfo->iBlockDataPackets, &pInfo->iBlockECPackets);
+      pInfo->uVideoBitrateBps = utils_get_max_allowed_video_bitrate_for_profile_or_user_video_bitrate(pModel, iProfile);
+
+      // Same radio datarates the vehicle uses for the adaptive profiles
+      if ( iProfile == VIDEO_PROFILE_MQ )
+         pInfo->uRadioDatarateBps = getRealDataRateFromRadioDataRate(utils_get_video_profile_mq_radio_datarate(pModel), 0);
+      else if ( iProfile == VIDEO_PROFILE_LQ )
+         pInfo->uRadioDatarateBps = getRealDataRateFromRadioDataRate(utils_get_video_profile_lq_radio_datarate(pModel), 0);
+      else
+         pInfo->uRadioDatarateBps = utils_get_max_radio_datarate_for_profile(pModel, iProfile);
+
+      pInfo->uRetransmissionWindowMs = 0;
+      if ( pModel->video_link_profiles[iProfile].uProfileEncodingFlags & VIDEO_PROFILE_ENCODING_FLAG_ENABLE_RETRANSMISSIONS )
+         pInfo->uRetransmissionWindowMs = ((pModel->video_link_profiles[iProfile].uProfileEncodingFlags & VIDEO_PROFILE_ENCODING_FLAG_MAX_RETRANSMISSION_WINDOW_MASK) >> 8) * 5;
+   }
+   pEngine->iCountProfiles = iCount;
+   pEngine->uTimeLastUpdateProfiles = g_TimeNow;
+}
+
+static void _adaptive_video_reset_engine(int iRuntimeIndex, Model* pModel)
+{
+   t_adaptive_video_vehicle_engine* pEngine = &(s_AdaptiveVideoEngines[iRuntimeIndex]);
+   if ( NULL != pEngine->fdTrace )
+      fclose(pEngine->fdTrace);
+   memset(pEngine, 0, sizeof(t_adaptive_video_vehicle_engine));
+   pEngine->iLastSliceIndex = -1;
+   if ( NULL == pModel )
+      return;
+
+   pEngine->uVehicleId = pModel->uVehicleId;
+   adaptive_video_mpc_init(&(pEngine->stateMPC), pModel->video_params.videoAdjustmentStrength);
+   _adaptive_video_update_profiles(pModel, pEngine);
+
+   char szFile[MAX_FILE_PATH_SIZE];
+   strcpy(szFile, FOLDER_RUBY_TEMP);
+   strcat(szFile, FILE_TEMP_RECORD_ADAPTIVE_VIDEO_TRACE);
+   if ( access(szFile, R_OK) == -1 )
+      return;
 
-   return VIDEO_PROFILE_LQ;
+   t_adaptive_video_trace_header header;
+   memset(&header, 0, sizeof(header));
+   header.uSliceIntervalMs = g_SMControllerRTInfo.uUpdateIntervalMs;
+   header.uVehicleId = pModel->uVehicleId;
+   header.iAdjustmentStrength = pModel->video_params.videoAdjustmentStrength;
+   header.iUserVideoProfile = pModel->video_params.user_selected_video_link_profile;
+   header.iCountProfiles = pEngine->iCountProfiles;
+   memcpy(header.profiles, pEngine->profiles, pEngine->iCountProfiles * sizeof(t_adaptive_video_profile_info));
+   char szTraceFile[MAX_FILE_PATH_SIZE];
+   strcpy(szTraceFile, FOLDER_LOGS);
+   snprintf(szTraceFile + strlen(szTraceFile), sizeof(szTraceFile) - strlen(szTraceFile), LOG_FILE_ADAPTIVE_VIDEO_TRACE, pModel->uVehicleId);
+   pEngine->fdTrace = adaptive_video_trace_create(szTraceFile, &header);
 }
 
-int _adaptive_video_get_higher_video_profile(Model* pModel, int iVideoProfile)
+// Feeds the last completed controller runtime info slice to the predictive engine and to the trace
+static void _adaptive_video_on_slice(int iRuntimeIndex, Model* pModel, shared_mem_video_stream_stats* pSMVideoStreamInfo, bool bUsePredictive)
 {
-   if ( iVideoProfile == VIDEO_PROFILE_LQ )
-      return VIDEO_PROFILE_MQ;
-   return pModel->video_params.user_selected_video_link_profile;
+   t_adaptive_video_vehicle_engine* pEngine = &(s_AdaptiveVideoEngines[iRuntimeIndex]);
+   if ( pEngine->uVehicleId != pModel->uVehicleId )
+      _adaptive_video_reset_engine(iRuntimeIndex, pModel);
+
+   int iSliceIndex = g_SMControllerRTInfo.iCurrentIndex - 1;
+   if ( iSliceIndex < 0 )
+      iSliceIndex = SYSTEM_RT_INFO_INTERVALS-1;
+   if ( iSliceIndex == pEngine->iLastSliceIndex )
+      return;
+   pEngine->iLastSliceIndex = iSliceIndex;
+
+   if ( (NULL == pEngine->fdTrace) && (! bUsePredictive) )
+      return;
+
+   t_adaptive_video_slice slice;
+   adaptive_video_get_slice(&g_SMControllerRTInfo, iSliceIndex, pModel->uVehicleId, pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile, &slice);
+   if ( bUsePredictive )
+      adaptive_video_mpc_add_slice(&(pEngine->stateMPC), &slice);
+   if ( NULL != pEngine->fdTrace )
+   {
+      adaptive_video_trace_add_slice(pEngine->fdTrace, &slice);
+      if ( 0 == iSliceIndex )
+         fflush(pEngine->fdTrace);
+   }
 }
 
 void adaptive_video_init()
 {
    log_line("[AdaptiveVideo] Init");
+   memset(s_AdaptiveVideoEngines, 0, sizeof(s_AdaptiveVideoEngines));
+   for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
+      s_AdaptiveVideoEngines[i].iLastSliceIndex = -1;
 }
 
 void adaptive_video_on_new_vehicle(int iRuntimeIndex)
@@ -96,6 +198,8 @@ void adaptive_video_on_new_vehicle(int iRuntimeIndex)
   if ( (NULL == pModel) || (! pModel->hasCamera()) )
      return;
 
+  _adaptive_video_reset_engine(iRuntimeIndex, pModel);
+
   g_State.vehiclesRuntimeInfo[iRuntimeIndex].bIsDoingAdaptive = false;
   if ( pModel->video_link_profiles[pModel->video_params.user_selected_video_link_profile].uProfileEncodingFlags & VIDEO_PROFILE_ENCODING_FLAG_ENABLE_ADAPTIVE_VIDEO_KEYFRAME )
   {
@@ -198,100 +302,6 @@ void adaptive_video_received_video_profile_switch_confirmation(u32 uRequestId, u
    }
 }
 
-bool _adaptive_video_should_switch_lower(Model* pModel, type_global_state_vehicle_runtime_info* pRuntimeInfo, shared_mem_video_stream_stats* pSMVideoStreamInfo)
-{
-   // Adaptive adjustment strength is in: pModel->video_params.videoAdjustmentStrength
-   // 1: lowest (slower) adjustment strength;
-   // 10: highest (fastest) adjustment strength;
-
-   u32 uTimeToLookBack = 50 + 10 * pModel->video_params.videoAdjustmentStrength;
-   int iIntervalsToCheck = 1 + uTimeToLookBack/g_SMControllerRTInfo.uUpdateIntervalMs;
-   if ( iIntervalsToCheck >= SYSTEM_RT_INFO_INTERVALS )
-      iIntervalsToCheck = SYSTEM_RT_INFO_INTERVALS - 1;
-   int iRTInfoIndex = g_SMControllerRTInfo.iCurrentIndex;
-   
-   int iECScheme = pModel->video_link_profiles[pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile].iBlockECs;
-   
-   if ( iECScheme > 0 )
-   {
-      int iECThreshold = iECScheme-1;
-      if (iECThreshold < 1 )
-         iECThreshold = 1;
-      int iECCountThreshold = 0;
-    
-      u32 uTime = g_TimeNow;
-      while ( iIntervalsToCheck > 0 )
-      {
-         // Do not go past the last video profile change
-         if ( uTime <= pRuntimeInfo->uLastTimeRecvVideoProfileAck )
-            break;
-
-         if ( g_SMControllerRTInfo.uOutputedVideoPacketsMaxECUsed[iRTInfoIndex] >= iECScheme )
-            iECCountThreshold++;
-         if ( g_SMControllerRTInfo.uOutputedVideoPacketsMaxECUsed[iRTInfoIndex] >= iECThreshold )
-            iECCountThreshold++;
-         else if ( g_SMControllerRTInfo.uOutputedVideoPacketsSkippedBlocks[iRTInfoIndex] > 0 )
-            iECCountThreshold+=2;
-
-         // Go to prev (older) slice
-         uTime -= g_SMControllerRTInfo.uUpdateIntervalMs;
-         iIntervalsToCheck--;
-         iRTInfoIndex--;
-         if ( iRTInfoIndex < 0 )
-            iRTInfoIndex = SYSTEM_RT_INFO_INTERVALS-1;
-      }
-      if ( iECCountThreshold > (10-pModel->video_params.videoAdjustmentStrength)/2 )
-      {
-         return true;
-      }
-   }
-   return false;
-}
-
-bool _adaptive_video_should_switch_higher(Model* pModel, type_global_state_vehicle_runtime_info* pRuntimeInfo, shared_mem_video_stream_stats* pSMVideoStreamInfo)
-{
-   // Adaptive adjustment strength is in: pModel->video_params.videoAdjustmentStrength
-   // 1: lowest (slower) adjustment strength;
-   // 10: highest (fastest) adjustment strength;
-
-   u32 uTimeToLookBack = 1000 + 10 * pModel->video_params.videoAdjustmentStrength;
-   int iIntervalsToCheck = 1 + uTimeToLookBack/g_SMControllerRTInfo.uUpdateIntervalMs;
-   if ( iIntervalsToCheck >= SYSTEM_RT_INFO_INTERVALS )
-      iIntervalsToCheck = SYSTEM_RT_INFO_INTERVALS - 1;
-   int iRTInfoIndex = g_SMControllerRTInfo.iCurrentIndex;
-   
-   int iECScheme = pModel->video_link_profiles[pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile].iBlockECs;
-   if ( iECScheme > 0 )
-   {
-      int iECThreshold = iECScheme-1;
-      if (iECThreshold < 1 )
-         iECThreshold = 1;
-
-      int iECCountThreshold = 0;
-      u32 uTime = g_TimeNow;
-      while ( iIntervalsToCheck > 0 )
-      {
-         if ( g_SMControllerRTInfo.uOutputedVideoPacketsMaxECUsed[iRTInfoIndex] >= iECThreshold )
-            iECCountThreshold++;
-         else if ( g_SMControllerRTInfo.uOutputedVideoPacketsSkippedBlocks[iRTInfoIndex] > 0 )
-            iECCountThreshold+=2;
-
-         // Go to prev (older) slice
-         uTime -= g_SMControllerRTInfo.uUpdateIntervalMs;
-         iIntervalsToCheck--;
-         iRTInfoIndex--;
-         if ( iRTInfoIndex < 0 )
-            iRTInfoIndex = SYSTEM_RT_INFO_INTERVALS-1;
-      }
-
-      if ( iECCountThreshold < (10-pModel->video_params.videoAdjustmentStrength)/3 + 1 )
-      {
-         return true; 
-      }
-   }
-   return false;
-}
-
 void _adaptive_video_check_vehicle(Model* pModel, type_global_state_vehicle_runtime_info* pRuntimeInfo, shared_mem_video_stream_stats* pSMVideoStreamInfo)
 {
    if ( (NULL == pRuntimeInfo) || (NULL == pSMVideoStreamInfo) || (NULL == pModel) )
@@ -305,12 +315,14 @@ void _adaptive_video_check_vehicle(Model* pModel, type_global_state_vehicle_runt
    if ( (pModel->video_link_profiles[pModel->video_params.user_selected_video_link_profile].uProfileEncodingFlags) & VIDEO_PROFILE_ENCODING_FLAG_USE_MEDIUM_ADAPTIVE_VIDEO )
       iLowestProfile = VIDEO_PROFILE_MQ;
 
+   int iECScheme = pModel->video_link_profiles[pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile].iBlockECs;
+
    if ( pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile != iLowestProfile )
    if ( pRuntimeInfo->uPendingVideoProfileToSet != iLowestProfile )
    if ( pRuntimeInfo->uLastTimeSentVideoProfileRequest < g_TimeNow - 30 )
-   if ( _adaptive_video_should_switch_lower(pModel, pRuntimeInfo, pSMVideoStreamInfo) )
+   if ( adaptive_video_reactive_should_switch_lower(&g_SMControllerRTInfo, g_TimeNow, pRuntimeInfo->uLastTimeRecvVideoProfileAck, iECScheme, pModel->video_params.videoAdjustmentStrength) )
    {
-      int iVideoProfile = _adaptive_video_get_lower_video_profile(pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile);
+      int iVideoProfile = adaptive_video_get_lower_video_profile(pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile);
       pRuntimeInfo->uPendingVideoProfileToSet = iVideoProfile;
       pRuntimeInfo->uPendingVideoProfileToSetRequestedBy = CTRL_RT_INFO_FLAG_VIDEO_PROF_SWITCH_REQ_BY_ADAPTIVE_LOWER;
       _adaptive_video_send_video_profile_to_vehicle(iVideoProfile, pModel->uVehicleId);
@@ -321,15 +333,52 @@ void _adaptive_video_check_vehicle(Model* pModel, type_global_state_vehicle_runt
    if ( pRuntimeInfo->uPendingVideoProfileToSet != pModel->video_params.user_selected_video_link_profile )
    if ( g_TimeNow > g_TimeStart + uMinTimeToSwitchHigher )
    if ( pRuntimeInfo->uLastTimeSentVideoProfileRequest < g_TimeNow - uMinTimeToSwitchHigher )
-   if ( _adaptive_video_should_switch_higher(pModel, pRuntimeInfo, pSMVideoStreamInfo) )
+   if ( adaptive_video_reactive_should_switch_higher(&g_SMControllerRTInfo, g_TimeNow, iECScheme, pModel->video_params.videoAdjustmentStrength) )
    {
-      int iVideoProfile = _adaptive_video_get_higher_video_profile(pModel, pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile);
+      int iVideoProfile = adaptive_video_get_higher_video_profile(pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile, pModel->video_params.user_selected_video_link_profile);
       pRuntimeInfo->uPendingVideoProfileToSet = iVideoProfile;
       pRuntimeInfo->uPendingVideoProfileToSetRequestedBy = CTRL_RT_INFO_FLAG_VIDEO_PROF_SWITCH_REQ_BY_ADAPTIVE_HIGHER;
       _adaptive_video_send_video_profile_to_vehicle(iVideoProfile, pModel->uVehicleId);
    }
 }
 
+void _adaptive_video_predictive_check_vehicle(int iRuntimeIndex, Model* pModel, type_global_state_vehicle_runtime_info* pRuntimeInfo, shared_mem_video_stream_stats* pSMVideoStreamInfo)
+{
+   if ( (NULL == pRuntimeInfo) || (NULL == pSMVideoStreamInfo) || (NULL == pModel) )
+      return;
+
+   t_adaptive_video_vehicle_engine* pEngine = &(s_AdaptiveVideoEngines[iRuntimeIndex]);
+   if ( (pEngine->iCountProfiles <= 0) || (g_TimeNow > pEngine->uTimeLastUpdateProfiles + 2000) || (pEngine->profiles[pEngine->iCountProfiles-1].iVideoProfile != pModel->video_params.user_selected_video_link_profile) )
+      _adaptive_video_update_profiles(pModel, pEngine);
+
+   // Wait for the pending video profile change to be applied
+   if ( pRuntimeInfo->uPendingVideoProfileToSet != 0xFF )
+      return;
+   if ( pRuntimeInfo->uLastTimeSentVideoProfileRequest >= g_TimeNow - 30 )
+      return;
+
+   int iCurrentProfile = pSMVideoStreamInfo->PHVS.uCurrentVideoLinkProfile;
+   t_adaptive_video_mpc_forecast forecast;
+   int iIndex = adaptive_video_mpc_decide(&(pEngine->stateMPC), pEngine->profiles, pEngine->iCountProfiles, iCurrentProfile, g_TimeNow, &forecast);
+   if ( (-1 == iIndex) || (pEngine->profiles[iIndex].iVideoProfile == iCurrentProfile) )
+      return;
+
+   int iVideoProfile = pEngine->profiles[iIndex].iVideoProfile;
+   u32 uCurrentBitrate = utils_get_max_allowed_video_bitrate_for_profile_or_user_video_bitrate(pModel, iCurrentProfile);
+   log_line("[AdaptiveVideo] Predictive: VID %u, switch %s -> %s, loss: %.3f (%.3f/s), SNR: %.1f dB (%.1f dB/s, fade %.1f dB), retr: %.3f, rtt: %.1f ms, queue: %.1f, block loss: %.5f, utilization: %.2f",
+      pModel->uVehicleId, str_get_video_profile_name(iCurrentProfile), str_get_video_profile_name(iVideoProfile),
+      forecast.fLoss, forecast.fLossTrendPerSec, forecast.fSNR, forecast.fSNRTrendPerSec, forecast.fFadeDepthDb,
+      forecast.fRetrRate, forecast.fRoundtripMs, forecast.fQueueBlocks,
+      forecast.fBlockLoss[iIndex], forecast.fUtilization[iIndex]);
+
+   pRuntimeInfo->uPendingVideoProfileToSet = iVideoProfile;
+   if ( pEngine->profiles[iIndex].uVideoBitrateBps < uCurrentBitrate )
+      pRuntimeInfo->uPendingVideoProfileToSetRequestedBy = CTRL_RT_INFO_FLAG_VIDEO_PROF_SWITCH_REQ_BY_ADAPTIVE_LOWER;
+   else
+      pRuntimeInfo->uPendingVideoProfileToSetRequestedBy = CTRL_RT_INFO_FLAG_VIDEO_PROF_SWITCH_REQ_BY_ADAPTIVE_HIGHER;
+   _adaptive_video_send_video_profile_to_vehicle(iVideoProfile, pModel->uVehicleId);
+}
+
 void _adaptive_keyframe_check_vehicle(Model* pModel, type_global_state_vehicle_runtime_info* pRuntimeInfo, shared_mem_video_stream_stats* pSMVideoStreamInfo)
 {
    if ( (NULL == pRuntimeInfo) || (NULL == pSMVideoStreamInfo) || (NULL == pModel) )
@@ -420,10 +469,16 @@ void adaptive_video_periodic_loop(bool bForceSyncNow)
          g_State.vehiclesRuntimeInfo[i].bIsDoingAdaptive = false;
          continue;
       }
+      bool bUsePredictive = (pModel->video_params.uVideoExtraFlags & VIDEO_FLAG_PREDICTIVE_ADAPTIVE_VIDEO)?true:false;
+      _adaptive_video_on_slice(i, pModel, pSMVideoStreamInfo, bUsePredictive);
+
       if ( (pModel->video_link_profiles[pModel->video_params.user_selected_video_link_profile].uProfileEncodingFlags) & VIDEO_PROFILE_ENCODING_FLAG_ENABLE_ADAPTIVE_VIDEO_LINK )
       {
          g_State.vehiclesRuntimeInfo[i].bIsDoingAdaptive = true;
-         _adaptive_video_check_vehicle(pModel, pRuntimeInfo, pSMVideoStreamInfo);
+         if ( bUsePredictive )
+            _adaptive_video_predictive_check_vehicle(i, pModel, pRuntimeInfo, pSMVideoStreamInfo);
+         else
+            _adaptive_video_check_vehicle(pModel, pRuntimeInfo, pSMVideoStreamInfo);
       }
       if ( (pModel->video_link_profiles[pModel->video_params.user_selected_video_link_profile].uProfileEncodingFlags) & VIDEO_PROFILE_ENCODING_FLAG_ENABLE_ADAPTIVE_VIDEO_KEYFRAME )
          _adaptive_keyframe_check_vehicle(pModel, pRuntimeInfo, pSMVideoStreamInfo);
@@ -0,0 +1,691 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <math.h>
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/flags_video.h"
+#include "adaptive_video_engine.h"
+
+#define MPC_TAU_LOSS_FAST_MS 50.0
+#define MPC_TAU_LOSS_SLOW_MS 400.0
+#define MPC_TAU_RETR_MS 400.0
+#define MPC_TAU_QUEUE_MS 200.0
+#define MPC_SKIPPED_BLOCK_WEIGHT 8 // skipped blocks are counted as this many lost packets
+#define MPC_DEFAULT_NOISE_DBM -95
+#define MPC_DEFAULT_ROUNDTRIP_MS 30.0
+#define MPC_MIN_SLICES_FOR_DECISION 20
+#define MPC_MIN_SNR_SAMPLES_FOR_TREND 8
+#define MPC_MARGIN_SCALE_DB 2.0 // packet loss vs SNR margin slope: p = 1/(1+exp(margin/scale))
+#define MPC_DB_PER_DATARATE_DOUBLING 3.0
+#define MPC_FADE_RECOVERY_DB_PER_SEC 3.0
+#define MPC_TAU_SNR_MS MPC_TAU_LOSS_FAST_MS
+#define MPC_SNR_REQUIRED_LEARN_RATE 0.05
+#define MPC_AIRTIME_SHARE 0.5 // part of the radio datarate usable for video payload
+#define MPC_QUEUE_REFERENCE_BLOCKS 8.0
+#define MPC_WEIGHT_LOSS 2.0
+#define MPC_WEIGHT_OVERLOAD 4.0
+#define MPC_PENALTY_DWELL 100.0
+
+static int _adaptive_video_get_vehicle_index(controller_runtime_info* pRTInfo, u32 uVehicleId)
+{
+   for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
+   {
+      if ( pRTInfo->vehicles[i].uVehicleId == uVehicleId )
+         return i;
+   }
+   return -1;
+}
+
+void adaptive_video_get_slice(controller_runtime_info* pRTInfo, int iSliceIndex, u32 uVehicleId, int iVideoProfile, t_adaptive_video_slice* pOutSlice)
+{
+   memset(pOutSlice, 0, sizeof(t_adaptive_video_slice));
+   if ( (NULL == pRTInfo) || (iSliceIndex < 0) || (iSliceIndex >= SYSTEM_RT_INFO_INTERVALS) )
+      return;
+
+   pOutSlice->uTimeMs = pRTInfo->uSliceUpdateTime[iSliceIndex];
+   pOutSlice->uVehicleId = uVehicleId;
+   pOutSlice->uVideoProfile = (u8)iVideoProfile;
+   pOutSlice->uOutputedVideoPackets = pRTInfo->uOutputedVideoPackets[iSliceIndex];
+   pOutSlice->uOutputedVideoPacketsRetransmitted = pRTInfo->uOutputedVideoPacketsRetransmitted[iSliceIndex];
+   int iReconstructed = (int)pRTInfo->uOutputedVideoPacketsSingleECUsed[iSliceIndex] + (int)pRTInfo->uOutputedVideoPacketsTwoECUsed[iSliceIndex] + (int)pRTInfo->uOutputedVideoPacketsMultipleECUsed[iSliceIndex];
+   if ( iReconstructed > 255 )
+      iReconstructed = 255;
+   pOutSlice->uOutputedVideoPacketsReconstructed = (u8)iReconstructed;
+   pOutSlice->uOutputedVideoPacketsMaxECUsed = pRTInfo->uOutputedVideoPacketsMaxECUsed[iSliceIndex];
+   pOutSlice->uOutputedVideoPacketsSkippedBlocks = pRTInfo->uOutputedVideoPacketsSkippedBlocks[iSliceIndex];
+   pOutSlice->uRecvVideoDataPackets = pRTInfo->uRecvVideoDataPackets[iSliceIndex];
+   pOutSlice->uRecvVideoECPackets = pRTInfo->uRecvVideoECPackets[iSliceIndex];
+
+   int iVehicleIndex = _adaptive_video_get_vehicle_index(pRTInfo, uVehicleId);
+   if ( -1 != iVehicleIndex )
+   {
+      pOutSlice->uCountReqRetrPackets = pRTInfo->vehicles[iVehicleIndex].uCountReqRetrPackets[iSliceIndex];
+      int iBlocks = pRTInfo->vehicles[iVehicleIndex].iCountBlocksInVideoRxBuffers;
+      if ( iBlocks < 0 )
+         iBlocks = 0;
+      if ( iBlocks > 255 )
+         iBlocks = 255;
+      pOutSlice->uCountBlocksInRxBuffer = (u8)iBlocks;
+      for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+      {
+         u8 uAckTime = pRTInfo->vehicles[iVehicleIndex].uMinAckTime[iSliceIndex][i];
+         if ( (0 != uAckTime) && ((0 == pOutSlice->uMinAckTimeMs) || (uAckTime < pOutSlice->uMinAckTimeMs)) )
+            pOutSlice->uMinAckTimeMs = uAckTime;
+      }
+   }
+
+   // Best antenna of all radio interfaces
+   pOutSlice->iSignalDbm = ADAPTIVE_VIDEO_NO_DBM;
+   pOutSlice->iNoiseDbm = ADAPTIVE_VIDEO_NO_DBM;
+   for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+   {
+      controller_runtime_info_radio_interface_rx_signal* pSignal = &(pRTInfo->radioInterfacesDbm[iSliceIndex][i]);
+      for( int k=0; (k<pSignal->iCountAntennas) && (k<MAX_RADIO_ANTENNAS); k++ )
+      {
+         if ( ADAPTIVE_VIDEO_NO_DBM == pSignal->iDbmAvg[k] )
+            continue;
+         int iNoise = pSignal->iDbmNoiseAvg[k];
+         if ( ADAPTIVE_VIDEO_NO_DBM == iNoise )
+            iNoise = MPC_DEFAULT_NOISE_DBM;
+         if ( (ADAPTIVE_VIDEO_NO_DBM == pOutSlice->iSignalDbm) || (pSignal->iDbmAvg[k] - iNoise > pOutSlice->iSignalDbm - pOutSlice->iNoiseDbm) )
+         {
+            pOutSlice->iSignalDbm = pSignal->iDbmAvg[k];
+            pOutSlice->iNoiseDbm = iNoise;
+         }
+      }
+   }
+}
+
+void adaptive_video_put_slice(controller_runtime_info* pRTInfo, int iSliceIndex, t_adaptive_video_slice* pSlice)
+{
+   if ( (NULL == pRTInfo) || (NULL == pSlice) || (iSliceIndex < 0) || (iSliceIndex >= SYSTEM_RT_INFO_INTERVALS) )
+      return;
+
+   pRTInfo->uSliceUpdateTime[iSliceIndex] = pSlice->uTimeMs;
+   pRTInfo->uOutputedVideoPackets[iSliceIndex] = pSlice->uOutputedVideoPackets;
+   pRTInfo->uOutputedVideoPacketsRetransmitted[iSliceIndex] = pSlice->uOutputedVideoPacketsRetransmitted;
+   pRTInfo->uOutputedVideoPacketsSingleECUsed[iSliceIndex] = pSlice->uOutputedVideoPacketsReconstructed;
+   pRTInfo->uOutputedVideoPacketsTwoECUsed[iSliceIndex] = 0;
+   pRTInfo->uOutputedVideoPacketsMultipleECUsed[iSliceIndex] = 0;
+   pRTInfo->uOutputedVideoPacketsMaxECUsed[iSliceIndex] = pSlice->uOutputedVideoPacketsMaxECUsed;
+   pRTInfo->uOutputedVideoPacketsSkippedBlocks[iSliceIndex] = pSlice->uOutputedVideoPacketsSkippedBlocks;
+   pRTInfo->uRecvVideoDataPackets[iSliceIndex] = pSlice->uRecvVideoDataPackets;
+   pRTInfo->uRecvVideoECPackets[iSliceIndex] = pSlice->uRecvVideoECPackets;
+
+   int iVehicleIndex = _adaptive_video_get_vehicle_index(pRTInfo, pSlice->uVehicleId);
+   if ( -1 == iVehicleIndex )
+   {
+      iVehicleIndex = _adaptive_video_get_vehicle_index(pRTInfo, 0);
+      if ( -1 == iVehicleIndex )
+         iVehicleIndex = 0;
+      pRTInfo->vehicles[iVehicleIndex].uVehicleId = pSlice->uVehicleId;
+   }
+   pRTInfo->vehicles[iVehicleIndex].uCountReqRetrPackets[iSliceIndex] = pSlice->uCountReqRetrPackets;
+   pRTInfo->vehicles[iVehicleIndex].iCountBlocksInVideoRxBuffers = pSlice->uCountBlocksInRxBuffer;
+   for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+      pRTInfo->vehicles[iVehicleIndex].uMinAckTime[iSliceIndex][i] = 0;
+   pRTInfo->vehicles[iVehicleIndex].uMinAckTime[iSliceIndex][0] = pSlice->uMinAckTimeMs;
+
+   memset(&(pRTInfo->radioInterfacesDbm[iSliceIndex][0]), 0, MAX_RADIO_INTERFACES * sizeof(controller_runtime_info_radio_interface_rx_signal));
+   if ( ADAPTIVE_VIDEO_NO_DBM != pSlice->iSignalDbm )
+   {
+      pRTInfo->radioInterfacesDbm[iSliceIndex][0].iCountAntennas = 1;
+      pRTInfo->radioInterfacesDbm[iSliceIndex][0].iDbmAvg[0] = pSlice->iSignalDbm;
+      pRTInfo->radioInterfacesDbm[iSliceIndex][0].iDbmNoiseAvg[0] = pSlice->iNoiseDbm;
+   }
+}
+
+int adaptive_video_get_lower_video_profile(int iVideoProfile)
+{
+   if ( iVideoProfile == VIDEO_PROFILE_BEST_PERF ||
+        iVideoProfile == VIDEO_PROFILE_HIGH_QUALITY ||
+        iVideoProfile == VIDEO_PROFILE_USER )
+     return VIDEO_PROFILE_MQ;
+
+   return VIDEO_PROFILE_LQ;
+}
+
+int adaptive_video_get_higher_video_profile(int iVideoProfile, int iUserVideoProfile)
+{
+   if ( iVideoProfile == VIDEO_PROFILE_LQ )
+      return VIDEO_PROFILE_MQ;
+   return iUserVideoProfile;
+}
+
+bool adaptive_video_reactive_should_switch_lower(controller_runtime_info* pRTInfo, u32 uTimeNow, u32 uTimeLastVideoProfileAck, int iECScheme, int iAdjustmentStrength)
+{
+   // Adaptive adjustment strength:
+   // 1: lowest (slower) adjustment strength;
+   // 10: highest (fastest) adjustment strength;
+
+   u32 uTimeToLookBack = 50 + 10 * iAdjustmentStrength;
+   int iIntervalsToCheck = 1 + uTimeToLookBack/pRTInfo->uUpdateIntervalMs;
+   if ( iIntervalsToCheck >= SYSTEM_RT_INFO_INTERVALS )
+      iIntervalsToCheck = SYSTEM_RT_INFO_INTERVALS - 1;
+   int iRTInfoIndex = pRTInfo->iCurrentIndex;
+   
+   if ( iECScheme > 0 )
+   {
+      int iECThreshold = iECScheme-1;
+      if (iECThreshold < 1 )
+         iECThreshold = 1;
+      int iECCountThreshold = 0;
+    
+      u32 uTime = uTimeNow;
+      while ( iIntervalsToCheck > 0 )
+      {
+         // Do not go past the last video profile change
+         if ( uTime <= uTimeLastVideoProfileAck )
+            break;
+
+         if ( pRTInfo->uOutputedVideoPacketsMaxECUsed[iRTInfoIndex] >= iECScheme )
+            iECCountThreshold++;
+         if ( pRTInfo->uOutputedVideoPacketsMaxECUsed[iRTInfoIndex] >= iECThreshold )
+            iECCountThreshold++;
+         else if ( pRTInfo->uOutputedVideoPacketsSkippedBlocks[iRTInfoIndex] > 0 )
+            iECCountThreshold+=2;
+
+         // Go to prev (older) slice
+         uTime -= pRTInfo->uUpdateIntervalMs;
+         iIntervalsToCheck--;
+         iRTInfoIndex--;
+         if ( iRTInfoIndex < 0 )
+            iRTInfoIndex = SYSTEM_RT_INFO_INTERVALS-1;
+      }
+      if ( iECCountThreshold > (10-iAdjustmentStrength)/2 )
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+bool adaptive_video_reactive_should_switch_higher(controller_runtime_info* pRTInfo, u32 uTimeNow, int iECScheme, int iAdjustmentStrength)
+{
+   // Adaptive adjustment strength:
+   // 1: lowest (slower) adjustment strength;
+   // 10: highest (fastest) adjustment strength;
+
+   u32 uTimeToLookBack = 1000 + 10 * iAdjustmentStrength;
+   int iIntervalsToCheck = 1 + uTimeToLookBack/pRTInfo->uUpdateIntervalMs;
+   if ( iIntervalsToCheck >= SYSTEM_RT_INFO_INTERVALS )
+      iIntervalsToCheck = SYSTEM_RT_INFO_INTERVALS - 1;
+   int iRTInfoIndex = pRTInfo->iCurrentIndex;
+   
+   if ( iECScheme > 0 )
+   {
+      int iECThreshold = iECScheme-1;
+      if (iECThreshold < 1 )
+         iECThreshold = 1;
+
+      int iECCountThreshold = 0;
+      u32 uTime = uTimeNow;
+      while ( iIntervalsToCheck > 0 )
+      {
+         if ( pRTInfo->uOutputedVideoPacketsMaxECUsed[iRTInfoIndex] >= iECThreshold )
+            iECCountThreshold++;
+         else if ( pRTInfo->uOutputedVideoPacketsSkippedBlocks[iRTInfoIndex] > 0 )
+            iECCountThreshold+=2;
+
+         // Go to prev (older) slice
+         uTime -= pRTInfo->uUpdateIntervalMs;
+         iIntervalsToCheck--;
+         iRTInfoIndex--;
+         if ( iRTInfoIndex < 0 )
+            iRTInfoIndex = SYSTEM_RT_INFO_INTERVALS-1;
+      }
+
+      if ( iECCountThreshold < (10-iAdjustmentStrength)/3 + 1 )
+      {
+         return true; 
+      }
+   }
+   return false;
+}
+
+static float _mpc_margin_from_loss(float fLoss)
+{
+   if ( fLoss < 0.0001 )
+      fLoss = 0.0001;
+   if ( fLoss > 0.95 )
+      fLoss = 0.95;
+   return MPC_MARGIN_SCALE_DB * logf((1.0 - fLoss)/fLoss);
+}
+
+static float _mpc_loss_from_margin(float fMargin)
+{
+   return 1.0 / (1.0 + expf(fMargin / MPC_MARGIN_SCALE_DB));
+}
+
+void adaptive_video_mpc_init(t_adaptive_video_mpc_state* pState, int iAdjustmentStrength)
+{
+   memset(pState, 0, sizeof(t_adaptive_video_mpc_state));
+   if ( iAdjustmentStrength < 1 )
+      iAdjustmentStrength = 1;
+   if ( iAdjustmentStrength > 10 )
+      iAdjustmentStrength = 10;
+
+   // Higher strength: lower target block loss (reacts sooner) and shorter dwell time before going up
+   pState->params.fTargetBlockLoss = powf(10.0, -(1.5 + 0.25 * (float)iAdjustmentStrength));
+   pState->params.uHorizonMs = 400;
+   pState->params.iHorizonSteps = 4;
+   pState->params.fSwitchCost = 0.5;
+   pState->params.uMinDwellBeforeHigherMs = 1000 + (10 - iAdjustmentStrength) * 200;
+   pState->fRoundtripMs = MPC_DEFAULT_ROUNDTRIP_MS;
+   pState->fFadeMarginDb = _mpc_margin_from_loss(0.0);
+   pState->iCurrentVideoProfile = -1;
+}
+
+static float _mpc_ewma(float fValue, float fSample, float fDeltaMs, float fTauMs)
+{
+   float fAlpha = 1.0 - expf(-fDeltaMs/fTauMs);
+   return fValue + fAlpha * (fSample - fValue);
+}
+
+void adaptive_video_mpc_add_slice(t_adaptive_video_mpc_state* pState, t_adaptive_video_slice* pSlice)
+{
+   float fDeltaMs = 5.0;
+   if ( (0 != pState->uCountSlices) && (pSlice->uTimeMs > pState->uLastSliceTime) )
+      fDeltaMs = (float)(pSlice->uTimeMs - pState->uLastSliceTime);
+   if ( fDeltaMs > 100.0 )
+      fDeltaMs = 100.0;
+   pState->uLastSliceTime = pSlice->uTimeMs;
+   pState->uCountSlices++;
+
+   if ( (int)pSlice->uVideoProfile != pState->iCurrentVideoProfile )
+   {
+      pState->iCurrentVideoProfile = pSlice->uVideoProfile;
+      pState->uTimeCurrentVideoProfileStart = pSlice->uTimeMs;
+   }
+
+   pState->fSNRFloorDb += MPC_FADE_RECOVERY_DB_PER_SEC * fDeltaMs / 1000.0;
+   if ( ADAPTIVE_VIDEO_NO_DBM != pSlice->iSignalDbm )
+   {
+      float fSNR = (float)(pSlice->iSignalDbm - pSlice->iNoiseDbm);
+      if ( (0 == pState->iSNRHistoryCount) || (fSNR < pState->fSNRFloorDb) )
+         pState->fSNRFloorDb = fSNR;
+      if ( 0 == pState->iSNRHistoryCount )
+         pState->fSNRFast = fSNR;
+      else
+         pState->fSNRFast = _mpc_ewma(pState->fSNRFast, fSNR, fDeltaMs, MPC_TAU_SNR_MS);
+      pState->fSNRHistory[pState->iSNRHistoryIndex] = fSNR;
+      pState->uSNRHistoryTime[pState->iSNRHistoryIndex] = pSlice->uTimeMs;
+      pState->iSNRHistoryIndex = (pState->iSNRHistoryIndex + 1) % ADAPTIVE_VIDEO_MPC_SNR_HISTORY;
+      if ( pState->iSNRHistoryCount < ADAPTIVE_VIDEO_MPC_SNR_HISTORY )
+         pState->iSNRHistoryCount++;
+   }
+
+   // At low bitrates most slices have no video block output; the loss samples are weighted by the time since the previous one
+   pState->fMsSinceLossSample += fDeltaMs;
+   pState->fFadeMarginDb += MPC_FADE_RECOVERY_DB_PER_SEC * fDeltaMs / 1000.0;
+
+   float fTotal = (float)pSlice->uOutputedVideoPackets + (float)(MPC_SKIPPED_BLOCK_WEIGHT * pSlice->uOutputedVideoPacketsSkippedBlocks);
+   if ( fTotal > 0.0 )
+   {
+      float fSampleMs = pState->fMsSinceLossSample;
+      if ( fSampleMs > 100.0 )
+         fSampleMs = 100.0;
+      pState->fMsSinceLossSample = 0.0;
+      float fErasures = (float)pSlice->uOutputedVideoPacketsReconstructed + (float)pSlice->uOutputedVideoPacketsRetransmitted + (float)(MPC_SKIPPED_BLOCK_WEIGHT * pSlice->uOutputedVideoPacketsSkippedBlocks);
+      float fLoss = fErasures / fTotal;
+      if ( fLoss > 1.0 )
+         fLoss = 1.0;
+      pState->fLossFast = _mpc_ewma(pState->fLossFast, fLoss, fSampleMs, MPC_TAU_LOSS_FAST_MS);
+      pState->fLossSlow = _mpc_ewma(pState->fLossSlow, fLoss, fSampleMs, MPC_TAU_LOSS_SLOW_MS);
+      float fMargin = _mpc_margin_from_loss(pState->fLossFast);
+      if ( fMargin < pState->fFadeMarginDb )
+         pState->fFadeMarginDb = fMargin;
+
+      // Learn the SNR the link needs, only while the loss is in the measurable range
+      if ( (0 != pState->iSNRHistoryCount) && (pState->fLossFast > 0.005) && (pState->fLossFast < 0.5) )
+      {
+         float fSample = pState->fSNRFast - fMargin;
+         if ( pState->fSNRRequiredDb == 0.0 )
+            pState->fSNRRequiredDb = fSample;
+         else
+            pState->fSNRRequiredDb += MPC_SNR_REQUIRED_LEARN_RATE * (fSample - pState->fSNRRequiredDb);
+      }
+
+      float fRetrRate = (float)pSlice->uCountReqRetrPackets / fTotal;
+      if ( fRetrRate > 1.0 )
+         fRetrRate = 1.0;
+      pState->fRetrRate = _mpc_ewma(pState->fRetrRate, fRetrRate, fSampleMs, MPC_TAU_RETR_MS);
+   }
+   pState->fQueueBlocks = _mpc_ewma(pState->fQueueBlocks, (float)pSlice->uCountBlocksInRxBuffer, fDeltaMs, MPC_TAU_QUEUE_MS);
+   if ( 0 != pSlice->uMinAckTimeMs )
+      pState->fRoundtripMs += 0.125 * ((float)pSlice->uMinAckTimeMs - pState->fRoundtripMs);
+}
+
+// Linear regression of the SNR history. Returns the SNR at the newest sample, trend is in dB/sec
+static float _mpc_get_snr(t_adaptive_video_mpc_state* pState, float* pfTrendPerSec)
+{
+   *pfTrendPerSec = 0.0;
+   if ( 0 == pState->iSNRHistoryCount )
+      return 0.0;
+
+   int iNewest = (pState->iSNRHistoryIndex + ADAPTIVE_VIDEO_MPC_SNR_HISTORY - 1) % ADAPTIVE_VIDEO_MPC_SNR_HISTORY;
+   if ( pState->iSNRHistoryCount < MPC_MIN_SNR_SAMPLES_FOR_TREND )
+      return pState->fSNRHistory[iNewest];
+
+   float fSumX = 0.0, fSumY = 0.0, fSumXX = 0.0, fSumXY = 0.0;
+   for( int i=0; i<pState->iSNRHistoryCount; i++ )
+   {
+      int iIndex = (iNewest + ADAPTIVE_VIDEO_MPC_SNR_HISTORY - i) % ADAPTIVE_VIDEO_MPC_SNR_HISTORY;
+      // Time relative to the newest sample, in seconds (negative)
+      float fX = -(float)(pState->uSNRHistoryTime[iNewest] - pState->uSNRHistoryTime[iIndex]) / 1000.0;
+      float fY = pState->fSNRHistory[iIndex];
+      fSumX += fX;
+      fSumY += fY;
+      fSumXX += fX*fX;
+      fSumXY += fX*fY;
+   }
+   float fN = (float)pState->iSNRHistoryCount;
+   float fDenominator = fN * fSumXX - fSumX * fSumX;
+   if ( fDenominator < 1e-9 )
+      return fSumY / fN;
+   float fSlope = (fN * fSumXY - fSumX * fSumY) / fDenominator;
+   float fIntercept = (fSumY - fSlope * fSumX) / fN;
+   if ( fSlope > 40.0 )
+      fSlope = 40.0;
+   if ( fSlope < -40.0 )
+      fSlope = -40.0;
+   *pfTrendPerSec = fSlope;
+   return fIntercept;
+}
+
+// Probability of more than iECPackets erasures in a block of iTotalPackets
+static float _mpc_block_ec_failure(int iTotalPackets, int iECPackets, float fLoss)
+{
+   if ( iECPackets >= iTotalPackets )
+      return 0.0;
+   double dQ = 1.0 - (double)fLoss;
+   double dRatio = (double)fLoss / dQ;
+   double dPMF = pow(dQ, iTotalPackets);
+   double dSumUpToEC = 0.0;
+   for( int i=0; i<=iECPackets; i++ )
+   {
+      dSumUpToEC += dPMF;
+      dPMF *= dRatio * (double)(iTotalPackets - i) / (double)(i+1);
+   }
+   double dFail = 1.0 - dSumUpToEC;
+   if ( dFail < 0.0 )
+      dFail = 0.0;
+   return (float)dFail;
+}
+
+int adaptive_video_mpc_decide(t_adaptive_video_mpc_state* pState, t_adaptive_video_profile_info* pProfiles, int iCountProfiles, int iCurrentVideoProfile, u32 uTimeNow, t_adaptive_video_mpc_forecast* pOutForecast)
+{
+   if ( (NULL == pState) || (NULL == pProfiles) || (iCountProfiles <= 0) )
+      return -1;
+   if ( iCountProfiles > ADAPTIVE_VIDEO_MAX_PROFILES )
+      iCountProfiles = ADAPTIVE_VIDEO_MAX_PROFILES;
+   if ( pState->uCountSlices < MPC_MIN_SLICES_FOR_DECISION )
+      return -1;
+
+   int iCurrentIndex = -1;
+   u32 uMaxVideoBitrate = 1;
+   for( int i=0; i<iCountProfiles; i++ )
+   {
+      if ( pProfiles[i].iVideoProfile == iCurrentVideoProfile )
+         iCurrentIndex = i;
+      if ( pProfiles[i].uVideoBitrateBps > uMaxVideoBitrate )
+         uMaxVideoBitrate = pProfiles[i].uVideoBitrateBps;
+   }
+   if ( -1 == iCurrentIndex )
+      return -1;
+
+   float fSNRTrend = 0.0;
+   float fSNR = _mpc_get_snr(pState, &fSNRTrend);
+   // The difference of the two EWMAs is about slope * (tau slow - tau fast)
+   float fLossTrend = (pState->fLossFast - pState->fLossSlow) / ((MPC_TAU_LOSS_SLOW_MS - MPC_TAU_LOSS_FAST_MS)/1000.0);
+   // Improvements are trusted less than degradations
+   if ( fLossTrend < 0.0 )
+      fLossTrend *= 0.5;
+   if ( fSNRTrend > 0.0 )
+      fSNRTrend *= 0.5;
+
+   float fCurrentDatarate = (float)pProfiles[iCurrentIndex].uRadioDatarateBps;
+   if ( fCurrentDatarate < 1.0 )
+      fCurrentDatarate = 1.0;
+   float fRoundtripMs = pState->fRoundtripMs;
+   if ( fRoundtripMs < 5.0 )
+      fRoundtripMs = 5.0;
+   int iSteps = pState->params.iHorizonSteps;
+   if ( iSteps < 1 )
+      iSteps = 1;
+   if ( iSteps > ADAPTIVE_VIDEO_MPC_MAX_STEPS )
+      iSteps = ADAPTIVE_VIDEO_MPC_MAX_STEPS;
+
+   // Keep the fade margin and the required SNR relative to the radio datarate in use
+   if ( (0 != pState->uFadeMarginDatarateBps) && (pState->uFadeMarginDatarateBps != (u32)fCurrentDatarate) )
+   {
+      float fDelta = MPC_DB_PER_DATARATE_DOUBLING * log2f(fCurrentDatarate / (float)pState->uFadeMarginDatarateBps);
+      pState->fFadeMarginDb -= fDelta;
+      if ( pState->fSNRRequiredDb != 0.0 )
+         pState->fSNRRequiredDb += fDelta;
+   }
+   pState->uFadeMarginDatarateBps = (u32)fCurrentDatarate;
+
+   // Loss margin now and at the bottom of the recent fading
+   float fMarginNow = _mpc_margin_from_loss(pState->fLossFast);
+   float fMarginFade = pState->fFadeMarginDb;
+   float fFadeDepth = 0.0;
+   if ( 0 != pState->iSNRHistoryCount )
+   {
+      if ( pState->fSNRFast > pState->fSNRFloorDb )
+         fFadeDepth = pState->fSNRFast - pState->fSNRFloorDb;
+      if ( fMarginNow - fFadeDepth < fMarginFade )
+         fMarginFade = fMarginNow - fFadeDepth;
+      if ( pState->fSNRRequiredDb != 0.0 )
+      {
+         if ( pState->fSNRFast - pState->fSNRRequiredDb < fMarginNow )
+            fMarginNow = pState->fSNRFast - pState->fSNRRequiredDb;
+         if ( pState->fSNRFloorDb - pState->fSNRRequiredDb < fMarginFade )
+            fMarginFade = pState->fSNRFloorDb - pState->fSNRRequiredDb;
+      }
+   }
+
+   bool bDwellPassed = (uTimeNow - pState->uTimeCurrentVideoProfileStart) >= pState->params.uMinDwellBeforeHigherMs;
+
+   if ( NULL != pOutForecast )
+   {
+      memset(pOutForecast, 0, sizeof(t_adaptive_video_mpc_forecast));
+      pOutForecast->fLoss = pState->fLossFast;
+      pOutForecast->fLossTrendPerSec = fLossTrend;
+      pOutForecast->fSNR = fSNR;
+      pOutForecast->fSNRTrendPerSec = fSNRTrend;
+      pOutForecast->fFadeDepthDb = fFadeDepth;
+      pOutForecast->fRetrRate = pState->fRetrRate;
+      pOutForecast->fQueueBlocks = pState->fQueueBlocks;
+      pOutForecast->fRoundtripMs = fRoundtripMs;
+   }
+
+   int iBestIndex = iCurrentIndex;
+   float fBestCost = 0.0;
+   for( int c=0; c<iCountProfiles; c++ )
+   {
+      t_adaptive_video_profile_info* pProfile = &(pProfiles[c]);
+      int iDataPackets = pProfile->iBlockDataPackets;
+      if ( iDataPackets < 1 )
+         iDataPackets = 1;
+      int iECPackets = pProfile->iBlockECPackets;
+      if ( iECPackets < 0 )
+         iECPackets = 0;
+      float fDatarate = (float)pProfile->uRadioDatarateBps;
+      if ( fDatarate < 1.0 )
+         fDatarate = fCurrentDatarate;
+      float fDatarateMargin = MPC_DB_PER_DATARATE_DOUBLING * log2f(fDatarate / fCurrentDatarate);
+      bool bHigher = pProfile->uVideoBitrateBps > pProfiles[iCurrentIndex].uVideoBitrateBps;
+
+      float fCost = 0.0;
+      float fWorstBlockLoss = 0.0;
+      float fWorstUtilization = 0.0;
+      for( int s=1; s<=iSteps; s++ )
+      {
+         float fTime = (float)pState->params.uHorizonMs * (float)s / (float)iSteps / 1000.0;
+
+         // Packet loss forecast: the worst of the loss trend and the SNR trend projections.
+         // Going higher must also hold at the depth of the recent fading.
+         float fMargin = _mpc_margin_from_loss(pState->fLossFast + fLossTrend * fTime);
+         if ( fMarginNow + fSNRTrend * fTime < fMargin )
+            fMargin = fMarginNow + fSNRTrend * fTime;
+         if ( bHigher && (fMarginFade < fMargin) )
+            fMargin = fMarginFade;
+         float fLoss = _mpc_loss_from_margin(fMargin - fDatarateMargin);
+
+         // Capacity and utilization of the link for this profile
+         float fCapacity = fDatarate * MPC_AIRTIME_SHARE * (1.0 - fLoss) / (1.0 + pState->fQueueBlocks / MPC_QUEUE_REFERENCE_BLOCKS);
+         float fDemand = (float)pProfile->uVideoBitrateBps * (float)(iDataPackets + iECPackets) / (float)iDataPackets * (1.0 + pState->fRetrRate);
+         float fUtilization = fDemand / fCapacity;
+
+         // Block loss after EC, then after the retransmission rounds that fit in the window and in the spare capacity
+         float fBlockLoss = _mpc_block_ec_failure(iDataPackets + iECPackets, iECPackets, fLoss);
+         if ( 0 != pProfile->uRetransmissionWindowMs )
+         {
+            // The retransmitted packets must fit in the spare capacity
+            float fRounds = (float)pProfile->uRetransmissionWindowMs / fRoundtripMs;
+            float fSpare = 1.0 - fUtilization;
+            if ( fSpare < 0.0 )
+               fSpare = 0.0;
+            if ( fSpare < fUtilization * fLoss )
+               fRounds *= fSpare / (fUtilization * fLoss);
+            if ( fRounds >= 1.0 )
+               fBlockLoss *= powf(fLoss, fRounds);
+            else
+               fBlockLoss *= 1.0 - fRounds * (1.0 - fLoss);
+         }
+
+         if ( fBlockLoss > fWorstBlockLoss )
+            fWorstBlockLoss = fBlockLoss;
+         if ( fUtilization > fWorstUtilization )
+            fWorstUtilization = fUtilization;
+
+         float fStepCost = -log2f((float)(pProfile->uVideoBitrateBps + 1) / (float)uMaxVideoBitrate);
+         if ( fBlockLoss > pState->params.fTargetBlockLoss )
+            fStepCost += MPC_WEIGHT_LOSS * log10f(fBlockLoss / pState->params.fTargetBlockLoss);
+         if ( fUtilization > 1.0 )
+            fStepCost += MPC_WEIGHT_OVERLOAD * fUtilization;
+         fCost += fStepCost;
+      }
+      fCost /= (float)iSteps;
+      if ( c != iCurrentIndex )
+         fCost += pState->params.fSwitchCost;
+      if ( bHigher && (! bDwellPassed) )
+         fCost += MPC_PENALTY_DWELL;
+
+      if ( NULL != pOutForecast )
+      {
+         pOutForecast->fBlockLoss[c] = fWorstBlockLoss;
+         pOutForecast->fUtilization[c] = fWorstUtilization;
+         pOutForecast->fCost[c] = fCost;
+      }
+      if ( (c == 0) || (fCost < fBestCost) )
+      {
+         fBestCost = fCost;
+         iBestIndex = c;
+      }
+   }
+
+   if ( NULL != pOutForecast )
+      pOutForecast->iChosenProfileIndex = iBestIndex;
+   return iBestIndex;
+}
+
+FILE* adaptive_video_trace_create(const char* szFile, t_adaptive_video_trace_header* pHeader)
+{
+   if ( (NULL == szFile) || (NULL == pHeader) )
+      return NULL;
+   FILE* fd = fopen(szFile, "wb");
+   if ( NULL == fd )
+   {
+      log_softerror_and_alarm("[AdaptiveVideo] Failed to create trace file (%s)", szFile);
+      return NULL;
+   }
+   pHeader->uMagic = ADAPTIVE_VIDEO_TRACE_MAGIC;
+   pHeader->uVersion = ADAPTIVE_VIDEO_TRACE_VERSION;
+   if ( 1 != fwrite(pHeader, sizeof(t_adaptive_video_trace_header), 1, fd) )
+   {
+      log_softerror_and_alarm("[AdaptiveVideo] Failed to write trace file header (%s)", szFile);
+      fclose(fd);
+      return NULL;
+   }
+   log_line("[AdaptiveVideo] Recording trace to file %s", szFile);
+   return fd;
+}
+
+void adaptive_video_trace_add_slice(FILE* fd, t_adaptive_video_slice* pSlice)
+{
+   if ( (NULL == fd) || (NULL == pSlice) )
+      return;
+   fwrite(pSlice, sizeof(t_adaptive_video_slice), 1, fd);
+}
+
+int adaptive_video_trace_load(const char* szFile, t_adaptive_video_trace_header* pOutHeader, t_adaptive_video_slice** ppOutSlices)
+{
+   if ( (NULL == szFile) || (NULL == pOutHeader) || (NULL == ppOutSlices) )
+      return -1;
+   *ppOutSlices = NULL;
+   FILE* fd = fopen(szFile, "rb");
+   if ( NULL == fd )
+   {
+      log_softerror_and_alarm("[AdaptiveVideo] Failed to open trace file (%s)", szFile);
+      return -1;
+   }
+   if ( (1 != fread(pOutHeader, sizeof(t_adaptive_video_trace_header), 1, fd)) ||
+        (pOutHeader->uMagic != ADAPTIVE_VIDEO_TRACE_MAGIC) ||
+        (pOutHeader->uVersion != ADAPTIVE_VIDEO_TRACE_VERSION) ||
+        (pOutHeader->iCountProfiles < 1) || (pOutHeader->iCountProfiles > ADAPTIVE_VIDEO_MAX_PROFILES) )
+   {
+      log_softerror_and_alarm("[AdaptiveVideo] Invalid trace file (%s)", szFile);
+      fclose(fd);
+      return -1;
+   }
+   fseek(fd, 0, SEEK_END);
+   long lSize = ftell(fd) - (long)sizeof(t_adaptive_video_trace_header);
+   fseek(fd, sizeof(t_adaptive_video_trace_header), SEEK_SET);
+   int iCountSlices = (int)(lSize / (long)sizeof(t_adaptive_video_slice));
+   if ( iCountSlices <= 0 )
+   {
+      fclose(fd);
+      return 0;
+   }
+   *ppOutSlices = (t_adaptive_video_slice*) malloc(iCountSlices * sizeof(t_adaptive_video_slice));
+   if ( NULL == *ppOutSlices )
+   {
+      fclose(fd);
+      return -1;
+   }
+   iCountSlices = (int) fread(*ppOutSlices, sizeof(t_adaptive_video_slice), iCountSlices, fd);
+   fclose(fd);
+   return iCountSlices;
+}
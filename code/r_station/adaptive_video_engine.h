@@ -0,0 +1,153 @@
+#pragma once
+
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/controller_rt_info.h"
+
+// Adaptive video decision engines. They only use the controller runtime info slices and the
+// video profiles description, so the same code runs in ruby_rt_station and in the offline
+// evaluator (r_tests/test_adaptive_video_replay), which replays recorded traces.
+//
+// Reactive engine (default): counts the slices that used most of the EC scheme or had skipped
+// blocks and switches one profile lower/higher when the count passes a threshold.
+//
+// Predictive engine (VIDEO_FLAG_PREDICTIVE_ADAPTIVE_VIDEO): model predictive control over a short
+// horizon. From the slices it keeps:
+//   * fast and slow EWMAs of the video packets erasure rate (EC reconstructed + retransmitted + skipped),
+//     their difference gives the loss trend, and the lowest recent margin of the fast one, the fading depth;
+//   * the SNR (best antenna), its trend, from a linear regression over the last samples, its recent floor,
+//     and the SNR the radio datarate needs, learned from the slices with some loss, so the loss margin is known
+//     even when there is no loss;
+//   * the retransmission requests rate, the ack roundtrip time and the rx buffer queue depth.
+// For each candidate profile and each horizon step it forecasts the packet erasure probability
+// (the observed loss margin, moved by the SNR trend and by the candidate's radio datarate),
+// the link utilization, the probability of losing a block after EC (binomial tail) and after
+// the retransmission rounds that fit in the window and in the spare capacity.
+// It picks the profile with the best bitrate whose forecast block loss stays under the target.
+// Higher profiles are evaluated at the fading depth instead of the current loss, and have a minimum
+// dwell time; every switch has a cost. This avoids the oscillations of the reactive engine.
+
+#define ADAPTIVE_VIDEO_MAX_PROFILES 8
+#define ADAPTIVE_VIDEO_MPC_SNR_HISTORY 64
+#define ADAPTIVE_VIDEO_MPC_MAX_STEPS 8
+#define ADAPTIVE_VIDEO_NO_DBM 1000
+
+#define ADAPTIVE_VIDEO_TRACE_MAGIC 0x52415654 // "RAVT"
+#define ADAPTIVE_VIDEO_TRACE_VERSION 1
+
+// One controller runtime info slice, as seen by the adaptive video engines. Also the record format of the traces.
+typedef struct
+{
+   u32 uTimeMs;
+   u32 uVehicleId;
+   u8 uVideoProfile; // video profile of the received stream
+   u8 uOutputedVideoPackets;
+   u8 uOutputedVideoPacketsRetransmitted;
+   u8 uOutputedVideoPacketsReconstructed;
+   u8 uOutputedVideoPacketsMaxECUsed;
+   u8 uOutputedVideoPacketsSkippedBlocks;
+   u8 uRecvVideoDataPackets;
+   u8 uRecvVideoECPackets;
+   u8 uCountReqRetrPackets;
+   u8 uCountBlocksInRxBuffer;
+   u8 uMinAckTimeMs; // 0 if no ack in this slice
+   u8 uDummy;
+   int iSignalDbm; // best antenna, ADAPTIVE_VIDEO_NO_DBM if none
+   int iNoiseDbm;
+} ALIGN_STRUCT_SPEC_INFO t_adaptive_video_slice;
+
+typedef struct
+{
+   int iVideoProfile;
+   int iBlockDataPackets;
+   int iBlockECPackets;
+   u32 uVideoBitrateBps;
+   u32 uRadioDatarateBps;
+   u32 uRetransmissionWindowMs; // 0 if retransmissions are disabled
+} ALIGN_STRUCT_SPEC_INFO t_adaptive_video_profile_info;
+
+typedef struct
+{
+   u32 uMagic;
+   u32 uVersion;
+   u32 uSliceIntervalMs;
+   u32 uVehicleId;
+   int iAdjustmentStrength;
+   int iUserVideoProfile;
+   int iCountProfiles;
+   t_adaptive_video_profile_info profiles[ADAPTIVE_VIDEO_MAX_PROFILES];
+} ALIGN_STRUCT_SPEC_INFO t_adaptive_video_trace_header;
+
+typedef struct
+{
+   float fTargetBlockLoss; // max acceptable probability of losing a video block after EC and retransmissions
+   u32 uHorizonMs;
+   int iHorizonSteps;
+   float fSwitchCost;
+   u32 uMinDwellBeforeHigherMs;
+} t_adaptive_video_mpc_params;
+
+typedef struct
+{
+   float fLoss;
+   float fLossTrendPerSec;
+   float fSNR;
+   float fSNRTrendPerSec;
+   float fFadeDepthDb;
+   float fRetrRate;
+   float fQueueBlocks;
+   float fRoundtripMs;
+   float fBlockLoss[ADAPTIVE_VIDEO_MAX_PROFILES]; // worst over horizon
+   float fUtilization[ADAPTIVE_VIDEO_MAX_PROFILES]; // worst over horizon
+   float fCost[ADAPTIVE_VIDEO_MAX_PROFILES];
+   int iChosenProfileIndex;
+} t_adaptive_video_mpc_forecast;
+
+typedef struct
+{
+   t_adaptive_video_mpc_params params;
+   u32 uCountSlices;
+   u32 uLastSliceTime;
+   float fMsSinceLossSample;
+   float fLossFast;
+   float fLossSlow;
+   float fFadeMarginDb; // lowest recent loss margin (recovers linearly), tracks the depth of the fading
+   u32 uFadeMarginDatarateBps; // radio datarate the fade margin is relative to
+   float fRetrRate;
+   float fQueueBlocks;
+   float fRoundtripMs;
+   float fSNRFloorDb; // lowest recent SNR (recovers linearly)
+   float fSNRFast;
+   float fSNRRequiredDb; // SNR at which the packet loss is 50%, learned from the slices with some loss; 0 if unknown
+   float fSNRHistory[ADAPTIVE_VIDEO_MPC_SNR_HISTORY];
+   u32 uSNRHistoryTime[ADAPTIVE_VIDEO_MPC_SNR_HISTORY];
+   int iSNRHistoryCount;
+   int iSNRHistoryIndex;
+   int iCurrentVideoProfile;
+   u32 uTimeCurrentVideoProfileStart;
+} t_adaptive_video_mpc_state;
+
+
+// Slices extraction
+void adaptive_video_get_slice(controller_runtime_info* pRTInfo, int iSliceIndex, u32 uVehicleId, int iVideoProfile, t_adaptive_video_slice* pOutSlice);
+// Writes a slice back to the controller runtime info (used to replay traces)
+void adaptive_video_put_slice(controller_runtime_info* pRTInfo, int iSliceIndex, t_adaptive_video_slice* pSlice);
+
+// Reactive engine
+int adaptive_video_get_lower_video_profile(int iVideoProfile);
+int adaptive_video_get_higher_video_profile(int iVideoProfile, int iUserVideoProfile);
+bool adaptive_video_reactive_should_switch_lower(controller_runtime_info* pRTInfo, u32 uTimeNow, u32 uTimeLastVideoProfileAck, int iECScheme, int iAdjustmentStrength);
+bool adaptive_video_reactive_should_switch_higher(controller_runtime_info* pRTInfo, u32 uTimeNow, int iECScheme, int iAdjustmentStrength);
+
+// Predictive engine
+void adaptive_video_mpc_init(t_adaptive_video_mpc_state* pState, int iAdjustmentStrength);
+void adaptive_video_mpc_add_slice(t_adaptive_video_mpc_state* pState, t_adaptive_video_slice* pSlice);
+// pProfiles must be sorted from the lowest to the highest video bitrate.
+// Returns the index in pProfiles of the profile to use, or -1 if there is not enough data yet.
+int adaptive_video_mpc_decide(t_adaptive_video_mpc_state* pState, t_adaptive_video_profile_info* pProfiles, int iCountProfiles, int iCurrentVideoProfile, u32 uTimeNow, t_adaptive_video_mpc_forecast* pOutForecast);
+
+// Traces
+FILE* adaptive_video_trace_create(const char* szFile, t_adaptive_video_trace_header* pHeader);
+void adaptive_video_trace_add_slice(FILE* fd, t_adaptive_video_slice* pSlice);
+// Returns the number of slices loaded (allocated in *ppOutSlices, free it), or -1 on error
+int adaptive_video_trace_load(const char* szFile, t_adaptive_video_trace_header* pOutHeader, t_adaptive_video_slice** ppOutSlices);
@@ -35,6 +35,7 @@
 #include "../base/models.h"
 #include "../base/utils.h"
 #include "../radio/fec.h" 
+#include "../base/trace.h"
 #include "shared_vars.h"
 #include "generic_rx_ecbuffers.h"
 #include "timers.h"
@@ -223,7 +224,9 @@ void GenericRxECBuffers::_computeECDataOnBlock(int iBufferIndex)
       }
    }
 
+   TRACE_BEGIN(TRACE_EVENT_FEC_DECODE, m_uBlockDataPackets, m_missing_packets_count_for_ec, m_iBlockPacketLength);
    int iRes = fec_decode(m_iBlockPacketLength, m_p_ec_decode_data_packets, (unsigned int)m_uBlockDataPackets, m_p_ec_decode_ec_packets, m_ec_decode_ec_indexes, m_ec_decode_missing_packets_indexes, m_missing_packets_count_for_ec );
+   TRACE_END(TRACE_EVENT_FEC_DECODE, m_uBlockDataPackets, m_missing_packets_count_for_ec, m_iBlockPacketLength);
    if ( iRes < 0 )
    {
       log_softerror_and_alarm("[GenericRxEcBuffer] Failed to decode block type %u/%u/%d bytes; recv: %d/%d packets, missing count: %d",
@@ -44,6 +44,7 @@
 #include "../radio/radiolink.h"
 #include "../radio/radio_rx.h"
 #include "../radio/radiopacketsqueue.h"
+#include "../radio/fec.h"
 #include "periodic_loop.h"
 #include "shared_vars.h"
 #include "shared_vars_state.h"
@@ -75,7 +76,15 @@ void _synchronize_shared_mems()
    if ( g_TimeNow >= s_TimeLastVideoStatsUpdate + 200 )
    {
       s_TimeLastVideoStatsUpdate = g_TimeNow;
-      memcpy((u8*)g_pSM_VideoDecodeStats, (u8*)(&g_SM_VideoDecodeStats), sizeof(shared_mem_video_stream_stats_rx_processors));
+      u32 uFECCacheHits = 0;
+      u32 uFECCacheMisses = 0;
+      fec_get_decode_cache_stats(&uFECCacheHits, &uFECCacheMisses);
+      for( int i=0; i<MAX_VIDEO_PROCESSORS; i++ )
+      {
+         g_SM_VideoDecodeStats.video_streams[i].uFECDecodeCacheHits = uFECCacheHits;
+         g_SM_VideoDecodeStats.video_streams[i].uFECDecodeCacheMisses = uFECCacheMisses;
+      }
+      shared_mem_publish(g_pSM_VideoDecodeStats, &g_SM_VideoDecodeStats, sizeof(shared_mem_video_stream_stats_rx_processors));
    
       if ( NULL != g_pSM_RouterVehiclesRuntimeInfo )
       {
@@ -93,7 +102,7 @@ void _synchronize_shared_mems()
             g_SM_RouterVehiclesRuntimeInfo.uMaxCommandRoundtripMiliseconds[i] = g_State.vehiclesRuntimeInfo[i].uMaxCommandRoundtripMiliseconds;
             g_SM_RouterVehiclesRuntimeInfo.uMinCommandRoundtripMiliseconds[i] = g_State.vehiclesRuntimeInfo[i].uMinCommandRoundtripMiliseconds;
          }
-         memcpy((u8*)g_pSM_RouterVehiclesRuntimeInfo, (u8*)&g_SM_RouterVehiclesRuntimeInfo, sizeof(shared_mem_router_vehicles_runtime_info));
+         shared_mem_publish(g_pSM_RouterVehiclesRuntimeInfo, &g_SM_RouterVehiclesRuntimeInfo, sizeof(shared_mem_router_vehicles_runtime_info));
       }
    }
    //------------------------------------------
@@ -105,9 +114,9 @@ void _synchronize_shared_mems()
    {
       s_TimeLastControllerRTInfoUpdate = g_TimeNow;
       if ( NULL != g_pSMControllerRTInfo )
-         memcpy((u8*)g_pSMControllerRTInfo, (u8*)&g_SMControllerRTInfo, sizeof(controller_runtime_info));
+         shared_mem_publish(g_pSMControllerRTInfo, &g_SMControllerRTInfo, sizeof(controller_runtime_info));
       if ( NULL != g_pSMVehicleRTInfo )
-         memcpy((u8*)g_pSMVehicleRTInfo, (u8*)&g_SMVehicleRTInfo, sizeof(vehicle_runtime_info));
+         shared_mem_publish(g_pSMVehicleRTInfo, &g_SMVehicleRTInfo, sizeof(vehicle_runtime_info));
    }
    //---------------------------------------------
    
@@ -119,7 +128,7 @@ void _synchronize_shared_mems()
       //update_shared_mem_video_frames_stats( &g_SM_VideoInfoStatsRadioIn, g_TimeNow);
 
       if ( NULL != g_pSM_VideoFramesStatsOutput )
-         memcpy((u8*)g_pSM_VideoFramesStatsOutput, (u8*)&g_SM_VideoFramesStatsOutput, sizeof(shared_mem_video_frames_stats));
+         shared_mem_publish(g_pSM_VideoFramesStatsOutput, &g_SM_VideoFramesStatsOutput, sizeof(shared_mem_video_frames_stats));
       //if ( NULL != g_pSM_VideoInfoStatsRadioIn )
       //   memcpy((u8*)g_pSM_VideoInfoStatsRadioIn, (u8*)&g_SM_VideoInfoStatsRadioIn, sizeof(shared_mem_video_frames_stats));
    }
@@ -129,7 +138,7 @@ void _synchronize_shared_mems()
    if ( g_TimeNow >= s_uTimeLastRxHistorySync + 100 )
    {
       s_uTimeLastRxHistorySync = g_TimeNow;
-      memcpy((u8*)g_pSM_HistoryRxStats, (u8*)&g_SM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
+      shared_mem_publish(g_pSM_HistoryRxStats, &g_SM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
    }
 }
 
@@ -607,7 +616,7 @@ void router_periodic_loop()
       {
          s_uTimeLastRadioStatsSharedMemSync = g_TimeNow;
          if ( NULL != g_pSM_RadioStats )
-            memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+            shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
       }
 
       for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
@@ -712,7 +721,7 @@ void router_periodic_loop()
    if ( g_TimeNow >= s_uTimeLastVideoStatsUpdate + 50 )
    {
       s_uTimeLastVideoStatsUpdate = g_TimeNow;
-      memcpy(g_pSM_VideoDecodeStats, &g_SM_VideoDecodeStats, sizeof(shared_mem_video_stream_stats_rx_processors));
+      shared_mem_publish(g_pSM_VideoDecodeStats, &g_SM_VideoDecodeStats, sizeof(shared_mem_video_stream_stats_rx_processors));
    }
 
    if ( g_TimeNow >= g_SM_RadioRxQueueInfo.uLastMeasureTime + g_SM_RadioRxQueueInfo.uMeasureIntervalMs )
@@ -722,7 +731,7 @@ void router_periodic_loop()
       if ( g_SM_RadioRxQueueInfo.uCurrentIndex >= MAX_RADIO_RX_QUEUE_INFO_VALUES )
          g_SM_RadioRxQueueInfo.uCurrentIndex = 0;
       g_SM_RadioRxQueueInfo.uPendingRxPackets[g_SM_RadioRxQueueInfo.uCurrentIndex] = 0;
-      memcpy(g_pSM_RadioRxQueueInfo, &g_SM_RadioRxQueueInfo, sizeof(shared_mem_radio_rx_queue_info));
+      shared_mem_publish(g_pSM_RadioRxQueueInfo, &g_SM_RadioRxQueueInfo, sizeof(shared_mem_radio_rx_queue_info));
    }
 
    _check_free_storage_space();
@@ -147,7 +147,7 @@ bool _switch_to_vehicle_radio_link(int iVehicleRadioLinkId)
    // Update the radio state to reflect the new assigned radio links to local radio interfaces
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    return true;
 }
 
@@ -347,7 +347,10 @@ void _process_local_notification_model_changed(t_packet_header* pPH, u8 uChangeT
    }
 
    if ( g_pCurrentModel->enc_flags != oldEFlags )
+   {
       lpp(NULL, 0);
+      spm((g_pCurrentModel->enc_flags & MODEL_ENC_FLAG_USE_AEAD)?ENC_PP_MODE_AEAD:ENC_PP_MODE_XOR);
+   }
 
    if ( uChangeType == MODEL_CHANGED_AUDIO_PARAMS )
    {
@@ -433,7 +436,7 @@ void _process_local_notification_model_changed(t_packet_header* pPH, u8 uChangeT
 
       // Update the radio state to reflect the new radio links
       if ( NULL != g_pSM_RadioStats )
-         memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+         shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    
       discardRetransmissionsInfoAndBuffersOnLengthyOp();
       return;
@@ -982,6 +985,8 @@ void process_local_control_packet(t_packet_header* pPH)
       g_pControllerSettings = get_ControllerSettings();
       int iOldTxMode = g_pControllerSettings->iRadioTxUsesPPCAP;
       int iOldSocketBuffers = g_pControllerSettings->iRadioBypassSocketBuffers;
+      int iOldRxRing = g_pControllerSettings->iRadioRxUsesRing;
+      int iOldRxThreadPerInterface = g_pControllerSettings->iRadioRxThreadPerInterface;
       #if defined (HW_PLATFORM_RADXA)
       int iOldHDMIVSync = g_pControllerSettings->iHDMIVSync;
       #endif
@@ -1017,6 +1022,16 @@ void process_local_control_packet(t_packet_header* pPH)
          log_line("Radio bypass socket buffers changed. Reinit radio interfaces...");
          reasign_radio_links(true);       
       }
+      else if ( g_pControllerSettings->iRadioRxUsesRing != iOldRxRing )
+      {
+         log_line("Radio rx mode (mmap ring/PPCAP) changed. Reinit radio interfaces...");
+         reasign_radio_links(true);
+      }
+      else if ( g_pControllerSettings->iRadioRxThreadPerInterface != iOldRxThreadPerInterface )
+      {
+         log_line("Radio rx threads (one per radio interface/single) changed. Reinit radio interfaces...");
+         reasign_radio_links(true);
+      }
 
       if ( NULL != g_pControllerSettings )
          radio_rx_set_timeout_interval(g_pControllerSettings->iDevRxLoopTimeout);
@@ -1081,7 +1096,7 @@ void process_local_control_packet(t_packet_header* pPH)
       }
 
       if ( NULL != g_pSM_RadioStats )
-         memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+         shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
 
       if ( g_pCurrentModel->hasCamera() )
          rx_video_output_on_controller_settings_changed();
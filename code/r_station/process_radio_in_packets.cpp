@@ -1065,7 +1065,7 @@ int process_received_single_radio_packet(int iInterfaceIndex, u8* pData, int iDa
       if ( uPacketType == PACKET_TYPE_RUBY_TELEMETRY_VIDEO_LINK_DEV_GRAPHS )
       if ( NULL != g_pSM_VideoLinkGraphs )
       if ( iPacketLength == sizeof(t_packet_header) + sizeof(shared_mem_video_link_graphs) )
-         memcpy(g_pSM_VideoLinkGraphs, pData+sizeof(t_packet_header), sizeof(shared_mem_video_link_graphs) );
+         shared_mem_publish(g_pSM_VideoLinkGraphs, pData+sizeof(t_packet_header), sizeof(shared_mem_video_link_graphs));
 
       if ( NULL != g_pProcessStats )
          g_pProcessStats->lastIPCOutgoingTime = g_TimeNow;
@@ -135,6 +135,8 @@ ProcessorRxVideo::ProcessorRxVideo(u32 uVehicleId, u8 uVideoStreamIndex)
    m_uLastTimeRequestedRetransmission = 0;
    m_uLastTimeCheckedForMissingPackets = 0;
    m_uRequestRetransmissionUniqueId = 0;
+   m_uLastRoundtripSampledRetransmissionId = 0;
+   m_uLastScheduledTopBlockTailVideoBlockIndex = MAX_U32;
    m_TimeLastHistoryStatsUpdate = 0;
    m_TimeLastRetransmissionsStatsUpdate = 0;
    m_uLatestVideoPacketReceiveTime = 0;
@@ -145,6 +147,7 @@ ProcessorRxVideo::ProcessorRxVideo(u32 uVehicleId, u8 uVideoStreamIndex)
    m_bPaused = false;
 
    m_pVideoRxBuffer = new VideoRxPacketsBuffer(uVideoStreamIndex, 0);
+   m_pRetransmissionsScheduler = new VideoRxRetransmissionsScheduler();
    Model* pModel = findModelWithId(uVehicleId, 201);
    if ( NULL == pModel )
       log_softerror_and_alarm("[ProcessorRxVideo] Can't find model for VID %u", uVehicleId);
@@ -183,6 +186,10 @@ ProcessorRxVideo::~ProcessorRxVideo()
 
    m_siInstancesCount--;
 
+   if ( NULL != m_pRetransmissionsScheduler )
+      delete m_pRetransmissionsScheduler;
+   m_pRetransmissionsScheduler = NULL;
+
    if ( 0 == m_siInstancesCount )
    {
       if ( m_fdLogFile != NULL )
@@ -249,12 +256,14 @@ void ProcessorRxVideo::resetReceiveState()
    m_uLastBlockReceivedEncodingExtraFlags2 = MAX_U32;
 
    m_uRetryRetransmissionAfterTimeoutMiliseconds = g_pControllerSettings->nRetryRetransmissionAfterTimeoutMS;
-   m_uTimeIntervalMsForRequestingRetransmissions = 10;
 
    log_line("[ProcessorRxVideo] Using timers: Retransmission retry after timeout of %d ms; Request retransmission after video silence (no video packets) timeout of %d ms", m_uRetryRetransmissionAfterTimeoutMiliseconds, g_pControllerSettings->nRequestRetransmissionsOnVideoSilenceMs);
    
    if ( NULL != m_pVideoRxBuffer )
       m_pVideoRxBuffer->emptyBuffers("Reset receiver state on controller settings changed.");
+   if ( NULL != m_pRetransmissionsScheduler )
+      m_pRetransmissionsScheduler->reset();
+   m_uLastScheduledTopBlockTailVideoBlockIndex = MAX_U32;
 
    m_uTimeLastVideoStreamChanged = g_TimeNow;
 
@@ -278,6 +287,7 @@ void ProcessorRxVideo::resetStateOnVehicleRestart()
    resetReceiveState();
    resetOutputState();
    m_uRequestRetransmissionUniqueId = 0;
+   m_uLastRoundtripSampledRetransmissionId = 0;
    m_uLastVideoBlockIndexResolutionChange = 0;
    m_uLastVideoBlockPacketIndexResolutionChange = 0;
 }
@@ -285,6 +295,8 @@ void ProcessorRxVideo::resetStateOnVehicleRestart()
 void ProcessorRxVideo::discardRetransmissionsInfo()
 {
    m_pVideoRxBuffer->emptyBuffers("No new video past retransmission window");
+   m_pRetransmissionsScheduler->reset();
+   m_uLastScheduledTopBlockTailVideoBlockIndex = MAX_U32;
    resetOutputState();
    m_uLastTimeRequestedRetransmission = g_TimeNow;
    m_uLastTimeCheckedForMissingPackets = g_TimeNow;
@@ -482,7 +494,13 @@ void ProcessorRxVideo::handleReceivedVideoPacket(int interfaceNb, u8* pBuffer, i
    }
 
 
+   bool bBufferWasEmpty = (0 == m_pVideoRxBuffer->getBlocksCountInBuffer());
+   u32 uPrevTopVideoBlockIndex = m_pVideoRxBuffer->getBufferTopReceivedVideoBlockIndex();
+   int iPrevTopMaxPacketIndex = m_pVideoRxBuffer->getTopBufferMaxReceivedVideoBlockPacketIndex();
+
    bool bNewestOnStream = m_pVideoRxBuffer->checkAddVideoPacket(pBuffer, length);
+   if ( pRuntimeInfo->bIsDoingRetransmissions )
+      scheduleMissingPacketsOnReceivedPacket(pPHVS, bBufferWasEmpty, uPrevTopVideoBlockIndex, iPrevTopMaxPacketIndex);
    if ( bNewestOnStream )
    if ( ! (pPH->packet_flags & PACKET_FLAGS_BIT_RETRANSMITED) )
    {
@@ -498,6 +516,12 @@ void ProcessorRxVideo::handleReceivedVideoPacket(int interfaceNb, u8* pBuffer, i
       {
          u32 uDeltaTime = g_TimeNow - m_uLastTimeRequestedRetransmission;
          controller_rt_info_update_ack_rt_time(&g_SMControllerRTInfo, pPH->vehicle_id_src, g_SM_RadioStats.radio_interfaces[interfaceNb].assignedLocalRadioLinkId, uDeltaTime);
+         // Only the first packet answering a request is a roundtrip sample, the next ones add their own tx time
+         if ( m_uLastRoundtripSampledRetransmissionId != m_uRequestRetransmissionUniqueId )
+         {
+            m_uLastRoundtripSampledRetransmissionId = m_uRequestRetransmissionUniqueId;
+            m_pRetransmissionsScheduler->addRoundtripSample(uDeltaTime);
+         }
       }
    }
 
@@ -692,6 +716,62 @@ void ProcessorRxVideo::_checkUpdateRetransmissionsState()
 }
 
 
+void ProcessorRxVideo::scheduleMissingBlockPackets(u32 uVideoBlockIndex, int iFirstPacketIndex, int iLastPacketIndex, u32 uDeadline)
+{
+   type_rx_video_block_info* pVideoBlock = m_pVideoRxBuffer->getVideoBlockWithIndex(uVideoBlockIndex);
+   if ( NULL == pVideoBlock )
+      return;
+
+   // Block can already be reconstructed using EC
+   if ( pVideoBlock->iRecvDataPackets + pVideoBlock->iRecvECPackets >= pVideoBlock->iBlockDataPackets )
+      return;
+
+   // Only data packets are requested
+   if ( iFirstPacketIndex < 0 )
+      iFirstPacketIndex = 0;
+   if ( iLastPacketIndex >= pVideoBlock->iBlockDataPackets )
+      iLastPacketIndex = pVideoBlock->iBlockDataPackets - 1;
+
+   for( int k=iFirstPacketIndex; k<=iLastPacketIndex; k++ )
+   {
+      if ( NULL == pVideoBlock->packets[k].pRawData )
+         continue;
+      if ( (! pVideoBlock->packets[k].bEmpty) || pVideoBlock->packets[k].bRetransmissionScheduled )
+         continue;
+      if ( m_pRetransmissionsScheduler->addEntry(uVideoBlockIndex, k, uDeadline, 0) )
+         pVideoBlock->packets[k].bRetransmissionScheduled = true;
+   }
+}
+
+void ProcessorRxVideo::scheduleMissingPacketsOnReceivedPacket(t_packet_header_video_segment* pPHVS, bool bBufferWasEmpty, u32 uPrevTopVideoBlockIndex, int iPrevTopMaxPacketIndex)
+{
+   if ( bBufferWasEmpty || (NULL == pPHVS) )
+      return;
+
+   // Packets older than the top block can't reveal new gaps
+   if ( pPHVS->uCurrentBlockIndex < uPrevTopVideoBlockIndex )
+      return;
+
+   u32 uDeadline = g_TimeNow + RETR_SCHEDULER_REORDER_HOLD_MS;
+
+   if ( pPHVS->uCurrentBlockIndex == uPrevTopVideoBlockIndex )
+   {
+      if ( (int)pPHVS->uCurrentBlockPacketIndex > iPrevTopMaxPacketIndex + 1 )
+         scheduleMissingBlockPackets(uPrevTopVideoBlockIndex, iPrevTopMaxPacketIndex + 1, (int)pPHVS->uCurrentBlockPacketIndex - 1, uDeadline);
+      return;
+   }
+
+   // New top block: the end of the previous top block, the skipped blocks and the start of the new top block are missing
+   scheduleMissingBlockPackets(uPrevTopVideoBlockIndex, iPrevTopMaxPacketIndex + 1, MAX_TOTAL_PACKETS_IN_BLOCK - 1, uDeadline);
+   if ( pPHVS->uCurrentBlockIndex - uPrevTopVideoBlockIndex < MAX_RXTX_BLOCKS_BUFFER )
+   {
+      for( u32 uBlock = uPrevTopVideoBlockIndex + 1; uBlock < pPHVS->uCurrentBlockIndex; uBlock++ )
+         scheduleMissingBlockPackets(uBlock, 0, MAX_TOTAL_PACKETS_IN_BLOCK - 1, uDeadline);
+   }
+   if ( pPHVS->uCurrentBlockPacketIndex > 0 )
+      scheduleMissingBlockPackets(pPHVS->uCurrentBlockIndex, 0, (int)pPHVS->uCurrentBlockPacketIndex - 1, uDeadline);
+}
+
 int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
 {
    type_global_state_vehicle_runtime_info* pRuntimeInfo = getVehicleRuntimeInfo(m_uVehicleId);
@@ -708,11 +788,15 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
 
    int iVideoProfileNow = g_SM_VideoDecodeStats.video_streams[m_iIndexVideoDecodeStats].PHVS.uCurrentVideoLinkProfile;
    m_iMilisecondsMaxRetransmissionWindow = ((pModel->video_link_profiles[iVideoProfileNow].uProfileEncodingFlags & VIDEO_PROFILE_ENCODING_FLAG_MAX_RETRANSMISSION_WINDOW_MASK) >> 8) * 5;
+   m_pRetransmissionsScheduler->setTimeoutLimits(m_uRetryRetransmissionAfterTimeoutMiliseconds, m_iMilisecondsMaxRetransmissionWindow);
 
    checkAndDiscardBlocksTooOld();
 
    if ( ! pRuntimeInfo->bIsDoingRetransmissions )
+   {
+      m_pRetransmissionsScheduler->reset();
       return -1;
+   }
 
    // If too much time since we last received a new video packet, then discard the entire rx buffer
    if ( m_iMilisecondsMaxRetransmissionWindow > 10 )
@@ -720,6 +804,7 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
    {
       log_line("[ProcessorRxVideo] Discard old blocks due to no new video packet for %d ms", m_iMilisecondsMaxRetransmissionWindow);
       m_pVideoRxBuffer->emptyBuffers("No new video received since start of retransmission window");
+      m_pRetransmissionsScheduler->reset();
       resetOutputState();
       return -1;
    }
@@ -733,15 +818,28 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
          return -1;
    }
 
-   //log_line("DBG retr retr interval: %u ms, last retr %u ms ago", m_uTimeIntervalMsForRequestingRetransmissions, g_TimeNow - m_uLastTimeRequestedRetransmission);
-   
-   if ( (!bForceSyncNow) && (g_TimeNow < m_uLastTimeRequestedRetransmission + m_uTimeIntervalMsForRequestingRetransmissions) )
-      return -1;
+   // The end of the top block is only known to be missing once the next block starts,
+   // or if nothing was received for it for a while (end of frame detection timeout)
+   u32 uTopVideoBlockIndexInBuffer = m_pVideoRxBuffer->getBufferTopReceivedVideoBlockIndex();
+   type_rx_video_block_info* pTopVideoBlock = m_pVideoRxBuffer->getVideoBlockWithIndex(uTopVideoBlockIndexInBuffer);
+   if ( (NULL != pTopVideoBlock) && (uTopVideoBlockIndexInBuffer != m_uLastScheduledTopBlockTailVideoBlockIndex) )
+   if ( pTopVideoBlock->iRecvDataPackets > 0 )
+   if ( pTopVideoBlock->uReceivedTime < g_TimeNow - DEFAULT_VIDEO_END_FRAME_DETECTION_TIMEOUT )
+   if ( pTopVideoBlock->iRecvDataPackets + pTopVideoBlock->iRecvECPackets < pTopVideoBlock->iBlockDataPackets )
+   {
+      m_uLastScheduledTopBlockTailVideoBlockIndex = uTopVideoBlockIndexInBuffer;
+      log_line("[AdaptiveVideo] Req top block pckts as it has a rx time gap (last recv pckt was %u ms ago, time now: %u)",
+         g_TimeNow - pTopVideoBlock->uReceivedTime, g_TimeNow);
+      scheduleMissingBlockPackets(uTopVideoBlockIndexInBuffer, pTopVideoBlock->iMaxReceivedDataPacketIndex + 1, MAX_TOTAL_PACKETS_IN_BLOCK - 1, g_TimeNow);
+   }
 
-   if ( g_TimeNow >= m_uLastTimeRequestedRetransmission + m_iMilisecondsMaxRetransmissionWindow )
-      m_uTimeIntervalMsForRequestingRetransmissions = 10;
+   // On a frame end there are no more reordered packets to wait for
+   u32 uDueTime = g_TimeNow;
+   if ( bForceSyncNow )
+      uDueTime += RETR_SCHEDULER_REORDER_HOLD_MS;
 
-   // Request all missing packets except current block
+   if ( m_pRetransmissionsScheduler->getNextDeadline() > uDueTime )
+      return 0;
 
    //#define PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS 20
    // params after header:
@@ -750,7 +848,6 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
    //   u8: number of video packets requested
    //   (u32+u8)*n = each (video block index + video packet index) requested 
 
-
    m_uLastTimeCheckedForMissingPackets = g_TimeNow;
 
    t_packet_header PH;
@@ -765,98 +862,120 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
 
    u8 packet[MAX_PACKET_TOTAL_SIZE];
    u8* pDataInfo = packet + sizeof(t_packet_header) + sizeof(u32) + 2*sizeof(u8);
-   u32 uTopVideoBlockIndexInBuffer = 0;
-   u32 uTopVideoBlockPacketIndexInBuffer = 0xFF;
-   u32 uTopVideoBlockLastRecvTime = 0;
    u32 uLastRequestedVideoBlockIndex = 0;
    int iLastRequestedVideoBlockPacketIndex = 0;
 
-   char szBufferBlocks[128];
-   szBufferBlocks[0] = 0;
+   // Packets requested from each block in this request, to request no more than what EC still needs
+   u32 uRequestedBlocks[DEFAULT_VIDEO_RETRANS_MAX_PCOUNT];
+   int iRequestedBlocksPackets[DEFAULT_VIDEO_RETRANS_MAX_PCOUNT];
+   int iCountRequestedBlocks = 0;
+
+   // Entries popped but not due for a request now, added back after the pop loop
+   type_retr_scheduler_entry entriesToReschedule[DEFAULT_VIDEO_RETRANS_MAX_PCOUNT*2];
+   int iCountEntriesToReschedule = 0;
 
    int iCountPacketsRequested = 0;
-   int iCountBlocks = m_pVideoRxBuffer->getBlocksCountInBuffer();
+   int iCountSkippedFEC = 0;
+   int iCountStale = 0;
+   type_retr_scheduler_entry entry;
 
-   //if ( 0 == iCountBlocks )
-   //   log_line("DBG check retr: empty buff, req %u ms ago", g_TimeNow - m_uLastTimeRequestedRetransmission);
-   //else
-   //   log_line("DBG check retr: blocks in buffer: %d, bottom: [%u], top:[%u], req %u ms ago", g_TimeNow - m_uLastTimeRequestedRetransmission, 
-   //       iCountBlocks, m_pVideoRxBuffer->getBufferBottomReceivedVideoBlockIndex(), m_pVideoRxBuffer->getBufferTopReceivedVideoBlockIndex() );
-   
-   for( int i=0; i<iCountBlocks; i++ )
+   while ( (iCountPacketsRequested < DEFAULT_VIDEO_RETRANS_MAX_PCOUNT) && (iCountEntriesToReschedule < DEFAULT_VIDEO_RETRANS_MAX_PCOUNT*2) )
    {
-      type_rx_video_block_info* pVideoBlock = m_pVideoRxBuffer->getVideoBlockInBuffer(i);
+      if ( ! m_pRetransmissionsScheduler->popDueEntry(uDueTime, &entry) )
+         break;
+
+      // Drop entries for blocks no longer in the buffer or packets received in the meantime
+      type_rx_video_block_info* pVideoBlock = m_pVideoRxBuffer->getVideoBlockWithIndex(entry.uVideoBlockIndex);
       if ( NULL == pVideoBlock )
+      {
+         iCountStale++;
          continue;
-      
-      if ( i < 3 )
+      }
+      if ( (int)entry.uPacketIndex >= pVideoBlock->iBlockDataPackets )
       {
-         // To remove to revert
-         if ( 0 != szBufferBlocks[0] )
-            strcat(szBufferBlocks, ", ");
-         char szTmp[128];
-         sprintf(szTmp, "[%u: %d/%d pckts]", pVideoBlock->uVideoBlockIndex, pVideoBlock->iRecvDataPackets, pVideoBlock->iRecvECPackets);
-         strcat(szBufferBlocks, szTmp);
+         pVideoBlock->packets[entry.uPacketIndex].bRetransmissionScheduled = false;
+         iCountStale++;
+         continue;
+      }
+      type_rx_video_packet_info* pVideoPacket = &(pVideoBlock->packets[entry.uPacketIndex]);
+      if ( (NULL == pVideoPacket->pRawData) || (! pVideoPacket->bEmpty) || pVideoPacket->bOutputed )
+      {
+         pVideoPacket->bRetransmissionScheduled = false;
+         iCountStale++;
+         continue;
       }
-      int iCountToRequestFromBlock = pVideoBlock->iBlockDataPackets - pVideoBlock->iRecvDataPackets - pVideoBlock->iRecvECPackets;
 
-      // Ignore current last video block if it's still receiving packets now or has not received any packet at all
-      if ( i == iCountBlocks-1 )
-      if ( iCountToRequestFromBlock > 0 )
+      int iCountMissingForEC = pVideoBlock->iBlockDataPackets - pVideoBlock->iRecvDataPackets - pVideoBlock->iRecvECPackets;
+      if ( iCountMissingForEC <= 0 )
       {
-         uTopVideoBlockIndexInBuffer = pVideoBlock->uVideoBlockIndex;
-         uTopVideoBlockLastRecvTime = pVideoBlock->uReceivedTime;
-         bool bRequestData = false;
+         pVideoPacket->bRetransmissionScheduled = false;
+         iCountSkippedFEC++;
+         continue;
+      }
 
-         // Reached EC stage but not enough EC packets to reconstruct
-         if ( pVideoBlock->iRecvECPackets > 0 )
-         if ( (pVideoBlock->iRecvDataPackets + pVideoBlock->iBlockECPackets) < pVideoBlock->iBlockDataPackets )
+      // Block still receiving packets: wait if the EC packets still to come can recover it
+      if ( entry.uVideoBlockIndex == uTopVideoBlockIndexInBuffer )
+      if ( pVideoBlock->uReceivedTime >= g_TimeNow - DEFAULT_VIDEO_END_FRAME_DETECTION_TIMEOUT )
+      {
+         int iLeftToReceiveInBlock = pVideoBlock->iBlockDataPackets + pVideoBlock->iBlockECPackets - pVideoBlock->iMaxReceivedDataOrECPacketIndex - 1;
+         if ( iLeftToReceiveInBlock >= iCountMissingForEC )
          {
-             log_line("[AdaptiveVideo] Req top block as it has only %d/%d recv data/ec pckts (expected %d data p), now t: %u",
-                pVideoBlock->iRecvDataPackets, pVideoBlock->iRecvECPackets, pVideoBlock->iBlockDataPackets, g_TimeNow);
-             bRequestData = true;
+            entry.uDeadline = g_TimeNow + DEFAULT_VIDEO_END_FRAME_DETECTION_TIMEOUT;
+            entriesToReschedule[iCountEntriesToReschedule++] = entry;
+            iCountSkippedFEC++;
+            continue;
          }
+      }
 
-         if ( ! bRequestData )
-         if ( pVideoBlock->uReceivedTime < g_TimeNow - DEFAULT_VIDEO_END_FRAME_DETECTION_TIMEOUT )
-         if ( pVideoBlock->iRecvDataPackets > 0 )
+      int iBlockSlot = -1;
+      for( int i=0; i<iCountRequestedBlocks; i++ )
+      {
+         if ( uRequestedBlocks[i] == entry.uVideoBlockIndex )
          {
-            log_line("[AdaptiveVideo] Req top block pckts as it has a rx time gap (last recv pckt was %u ms ago, time now: %u)",
-              g_TimeNow - pVideoBlock->uReceivedTime, g_TimeNow);
-            bRequestData = true;
+            iBlockSlot = i;
+            break;
          }
-
-         if ( ! bRequestData )
-            continue;
-         log_line("[AdaptiveVideo] Top block (%u) has %d/%d recv data/ec packets, eof: %d, will request %d packets.", pVideoBlock->uVideoBlockIndex, pVideoBlock->iRecvDataPackets, pVideoBlock->iRecvECPackets, pVideoBlock->iEndOfFrameDetectedAtPacketIndex, iCountToRequestFromBlock);
       }
-      if ( iCountToRequestFromBlock > 0 )
+      if ( -1 == iBlockSlot )
       {
-         for( int k=0; k<pVideoBlock->iBlockDataPackets; k++ )
-         {
-            if ( NULL == pVideoBlock->packets[k].pRawData )
-               continue;
-            if ( ! pVideoBlock->packets[k].bEmpty )
-               continue;
-
-            uLastRequestedVideoBlockIndex = pVideoBlock->uVideoBlockIndex;
-            iLastRequestedVideoBlockPacketIndex = k;
-            memcpy(pDataInfo, &pVideoBlock->uVideoBlockIndex, sizeof(u32));
-            pDataInfo += sizeof(u32);
-            u8 uPacketIndex = k;
-            memcpy(pDataInfo, &uPacketIndex, sizeof(u8));
-            pDataInfo += sizeof(u8);
-
-            iCountToRequestFromBlock--;
-            iCountPacketsRequested++;
-            if ( iCountToRequestFromBlock == 0 )
-               break;
-            if ( iCountPacketsRequested >= DEFAULT_VIDEO_RETRANS_MAX_PCOUNT )
-              break;
-         }
+         iBlockSlot = iCountRequestedBlocks;
+         uRequestedBlocks[iBlockSlot] = entry.uVideoBlockIndex;
+         iRequestedBlocksPackets[iBlockSlot] = 0;
+         iCountRequestedBlocks++;
+      }
+
+      // Enough packets of this block are already requested for EC to recover it. Check this one again later.
+      if ( iRequestedBlocksPackets[iBlockSlot] >= iCountMissingForEC )
+      {
+         entry.uDeadline = g_TimeNow + m_pRetransmissionsScheduler->getRetryTimeout(entry.uRequestCount);
+         entriesToReschedule[iCountEntriesToReschedule++] = entry;
+         iCountSkippedFEC++;
+         continue;
       }
-      if ( iCountPacketsRequested >= DEFAULT_VIDEO_RETRANS_MAX_PCOUNT )
-        break;
+
+      iRequestedBlocksPackets[iBlockSlot]++;
+      uLastRequestedVideoBlockIndex = entry.uVideoBlockIndex;
+      iLastRequestedVideoBlockPacketIndex = entry.uPacketIndex;
+      memcpy(pDataInfo, &entry.uVideoBlockIndex, sizeof(u32));
+      pDataInfo += sizeof(u32);
+      memcpy(pDataInfo, &entry.uPacketIndex, sizeof(u8));
+      pDataInfo += sizeof(u8);
+      iCountPacketsRequested++;
+
+      pVideoPacket->uRequestedTime = g_TimeNow;
+      if ( entry.uRequestCount < 255 )
+         entry.uRequestCount++;
+      entry.uDeadline = g_TimeNow + m_pRetransmissionsScheduler->getRetryTimeout(entry.uRequestCount);
+      entriesToReschedule[iCountEntriesToReschedule++] = entry;
+   }
+
+   for( int i=0; i<iCountEntriesToReschedule; i++ )
+   {
+      if ( m_pRetransmissionsScheduler->addEntry(entriesToReschedule[i].uVideoBlockIndex, entriesToReschedule[i].uPacketIndex, entriesToReschedule[i].uDeadline, entriesToReschedule[i].uRequestCount) )
+         continue;
+      type_rx_video_block_info* pVideoBlock = m_pVideoRxBuffer->getVideoBlockWithIndex(entriesToReschedule[i].uVideoBlockIndex);
+      if ( NULL != pVideoBlock )
+         pVideoBlock->packets[entriesToReschedule[i].uPacketIndex].bRetransmissionScheduled = false;
    }
 
    if ( iCountPacketsRequested == 0 )
@@ -871,10 +990,6 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
    PH.total_length += iCountPacketsRequested*(sizeof(u32) + sizeof(u8)); 
    memcpy(packet, (u8*)&PH, sizeof(t_packet_header));
 
-   if ( g_TimeNow < m_uLastTimeRequestedRetransmission + m_iMilisecondsMaxRetransmissionWindow )
-   if ( m_uTimeIntervalMsForRequestingRetransmissions < 40 )
-       m_uTimeIntervalMsForRequestingRetransmissions += 5;
-
    m_uLastTimeRequestedRetransmission = g_TimeNow;
 
    controller_runtime_info_vehicle* pRTInfo = controller_rt_info_get_vehicle_info(&g_SMControllerRTInfo, m_uVehicleId);
@@ -890,14 +1005,14 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
    pDataInfo = packet + sizeof(t_packet_header) + sizeof(u32) + 2*sizeof(u8);
    u32 uFirstReqBlockIndex =0;
    memcpy(&uFirstReqBlockIndex, pDataInfo, sizeof(u32));
-   log_line("[AdaptiveVideo] * Requested retr id %u from vehicle for %d packets ([%u/%d]...[%u/%d])",
+   log_line("[AdaptiveVideo] * Requested retr id %u from vehicle for %d packets ([%u/%d]...[%u/%d]), skipped %d recoverable by EC, %d stale",
       m_uRequestRetransmissionUniqueId, iCountPacketsRequested,
-      uFirstReqBlockIndex, (int)pDataInfo[sizeof(u32)], uLastRequestedVideoBlockIndex, iLastRequestedVideoBlockPacketIndex);
-   
-   log_line("[AdaptiveVideo] * Video blocks in buffer: %d (%s), top/max video block index in buffer: [%u/%u] / [%u/%d]",
-      iCountBlocks, szBufferBlocks, uTopVideoBlockIndexInBuffer, uTopVideoBlockPacketIndexInBuffer, m_pVideoRxBuffer->getBufferTopReceivedVideoBlockIndex(), m_pVideoRxBuffer->getTopBufferMaxReceivedVideoBlockPacketIndex());
-   log_line("[AdaptiveVideo] Max Video block packet received: [%u/%d], top video block last recv time: %u ms ago",
-      m_pVideoRxBuffer->getBufferTopReceivedVideoBlockIndex(), m_pVideoRxBuffer->getTopBufferMaxReceivedVideoBlockPacketIndex(), g_TimeNow - uTopVideoBlockLastRecvTime);
+      uFirstReqBlockIndex, (int)pDataInfo[sizeof(u32)], uLastRequestedVideoBlockIndex, iLastRequestedVideoBlockPacketIndex,
+      iCountSkippedFEC, iCountStale);
+   log_line("[AdaptiveVideo] * Video blocks in buffer: %d, top/max video block index in buffer: [%u/%d], scheduled: %d, srtt/rttvar: %u/%u ms, retry timeout: %u ms",
+      m_pVideoRxBuffer->getBlocksCountInBuffer(), uTopVideoBlockIndexInBuffer, m_pVideoRxBuffer->getTopBufferMaxReceivedVideoBlockPacketIndex(),
+      m_pRetransmissionsScheduler->getEntriesCount(), m_pRetransmissionsScheduler->getSmoothedRoundtrip(), m_pRetransmissionsScheduler->getRoundtripVariation(),
+      m_pRetransmissionsScheduler->getRetryTimeout(1));
    packets_queue_add_packet(&s_QueueRadioPacketsHighPrio, packet);
    return iCountPacketsRequested;
 }
@@ -3,6 +3,7 @@
 #include "../base/models.h"
 #include "../base/shared_mem_controller_only.h"
 #include "video_rx_buffers.h"
+#include "video_rx_retransmissions.h"
 
 #define MAX_RETRANSMISSION_BUFFER_HISTORY_LENGTH 20
 
@@ -112,6 +113,9 @@ class ProcessorRxVideo
       void checkUpdateRetransmissionsState();
       // Returns how many retransmission packets where requested, if any
       int checkAndRequestMissingPackets(bool bForceSyncNow);
+      // Adds to the retransmissions scheduler the missing packets detected when a new video packet was added to the rx buffer
+      void scheduleMissingPacketsOnReceivedPacket(t_packet_header_video_segment* pPHVS, bool bBufferWasEmpty, u32 uPrevTopVideoBlockIndex, int iPrevTopMaxPacketIndex);
+      void scheduleMissingBlockPackets(u32 uVideoBlockIndex, int iFirstPacketIndex, int iLastPacketIndex, u32 uDeadline);
       void checkAndDiscardBlocksTooOld();
 
       bool m_bInitialized;
@@ -122,7 +126,6 @@ class ProcessorRxVideo
 
       u32 m_uRetryRetransmissionAfterTimeoutMiliseconds;
       int m_iMilisecondsMaxRetransmissionWindow;
-      u32 m_uTimeIntervalMsForRequestingRetransmissions;
 
       // Output state
 
@@ -139,6 +142,9 @@ class ProcessorRxVideo
       u32 m_uLastTimeCheckedForMissingPackets;
       u32 m_uLastTimeRequestedRetransmission;
       u32 m_uRequestRetransmissionUniqueId;
+      u32 m_uLastRoundtripSampledRetransmissionId;
+      u32 m_uLastScheduledTopBlockTailVideoBlockIndex;
+      VideoRxRetransmissionsScheduler* m_pRetransmissionsScheduler;
 
       u32 m_uEncodingsChangeCount;
       u32 m_uTimeLastVideoStreamChanged;
@@ -42,6 +42,7 @@
 #include "../base/radio_utils.h"
 #include "../common/string_utils.h"
 #include "../common/radio_stats.h"
+#include "../radio/radio_duplicate_det.h"
 #include "../radio/radio_rx.h"
 #include "../radio/radio_tx.h"
 #include "../utils/utils_controller.h"
@@ -160,6 +161,7 @@ void radio_links_reinit_radio_interfaces()
    hardware_sleep_ms(100);
    hardware_reset_radio_enumerated_flag();
    hardware_enumerate_radio_interfaces();
+   radio_duplicate_detection_update_radio_interfaces();
 
    hardware_save_radio_info();
    hardware_sleep_ms(100);
@@ -224,7 +226,7 @@ void radio_links_close_rxtx_radio_interfaces()
       g_SM_RadioStats.radio_interfaces[i].openedForWrite = 0;
    }
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Closed all radio interfaces (rx/tx)."); 
 }
 
@@ -322,7 +324,7 @@ void radio_links_open_rxtx_radio_interfaces_for_search( u32 uSearchFreq )
    }
    
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Opening RX radio interfaces for search complete. %d interfaces opened for RX:", iCountOpenRead);
    
    for( int i=0; i<hardware_get_radio_interfaces_count(); i++ )
@@ -479,7 +481,7 @@ void radio_links_open_rxtx_radio_interfaces()
    }
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Opening RX/TX radio interfaces complete. %d interfaces opened for RX, %d interfaces opened for TX:", totalCountForRead, totalCountForWrite);
 
    if ( totalCountForRead == 0 )
@@ -553,7 +555,7 @@ void radio_links_open_rxtx_radio_interfaces()
    }
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Finished opening RX/TX radio interfaces.");
 
    radio_links_set_monitor_mode();
@@ -597,7 +599,7 @@ bool radio_links_apply_settings(Model* pModel, int iRadioLink, type_radio_links_
 
       hardware_save_radio_info();
       if ( NULL != g_pSM_RadioStats )
-         memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+         shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    }
 
    // Apply data rates
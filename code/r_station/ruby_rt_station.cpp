@@ -46,7 +46,9 @@
 #include "../base/hardware.h"
 #include "../base/hardware_files.h"
 #include "../base/hw_procs.h"
+#include "../base/hw_sys.h"
 #include "../base/ruby_ipc.h"
+#include "../base/trace.h"
 #include "../base/parse_fc_telemetry.h"
 #include "../common/string_utils.h"
 #include "../common/radio_stats.h"
@@ -386,7 +388,7 @@ void _compute_radio_interfaces_assignment()
       iCountAssignedVehicleRadioLinks = 1;
       g_SM_RadioStats.countLocalRadioLinks = 1;
       if ( NULL != g_pSM_RadioStats )
-         memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+         shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
       if ( 0 == iCountInterfacesAssigned )
          send_alarm_to_central(ALARM_ID_CONTROLLER_NO_INTERFACES_FOR_RADIO_LINK,iConnectFirstUsableRadioLinkId, 0);
       
@@ -552,7 +554,7 @@ void _compute_radio_interfaces_assignment()
    log_line("Assigned %d controller local radio links to vehicle radio links (vehicle has %d active radio links)", iCountAssignedVehicleRadioLinks, iCountVehicleActiveUsableRadioLinks);
    
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
 
    //---------------------------------------------------------------
    // Log errors
@@ -714,7 +716,7 @@ bool links_set_cards_frequencies_for_search( u32 uSearchFreq, bool bSiKSearch, i
    }
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Links: Set all cards frequencies for search mode to %s. Completed.", str_format_frequency(uSearchFreq));
    return true;
 }
@@ -833,7 +835,7 @@ bool links_set_cards_frequencies_and_params(int iVehicleLinkId)
    }
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
 
    hardware_save_radio_info();
 
@@ -861,6 +863,13 @@ void reasign_radio_links(bool bSilent)
    else
       radio_set_bypass_socket_buffers(0);
 
+   if ( g_pControllerSettings->iRadioRxUsesRing )
+      radio_set_use_rx_ring(1);
+   else
+      radio_set_use_rx_ring(0);
+
+   radio_rx_set_thread_per_interface(g_pControllerSettings->iRadioRxThreadPerInterface);
+
    _compute_radio_interfaces_assignment();
    links_set_cards_frequencies_and_params(-1);
    radio_links_open_rxtx_radio_interfaces();
@@ -1088,7 +1097,7 @@ void init_shared_memory_objects()
       log_line("Opened shared mem to controller runtime info for writing.");
 
    if ( NULL != g_pSMControllerRTInfo )
-      memcpy((u8*)g_pSMControllerRTInfo, (u8*)&g_SMControllerRTInfo, sizeof(controller_runtime_info));
+      shared_mem_publish(g_pSMControllerRTInfo, &g_SMControllerRTInfo, sizeof(controller_runtime_info));
 
    g_pSMVehicleRTInfo = vehicle_rt_info_open_for_write();
    if ( NULL == g_pSMVehicleRTInfo )
@@ -1097,7 +1106,7 @@ void init_shared_memory_objects()
       log_line("Opened shared mem to vehicle runtime info for writing.");
 
    if ( NULL != g_pSMVehicleRTInfo )
-      memcpy((u8*)g_pSMVehicleRTInfo, (u8*)&g_SMVehicleRTInfo, sizeof(vehicle_runtime_info));
+      shared_mem_publish(g_pSMVehicleRTInfo, &g_SMVehicleRTInfo, sizeof(vehicle_runtime_info));
 
    g_pSM_RadioStats = shared_mem_radio_stats_open_for_write();
    if ( NULL == g_pSM_RadioStats )
@@ -1116,7 +1125,7 @@ void init_shared_memory_objects()
    radio_stats_reset(&g_SM_RadioStats, g_pControllerSettings->nGraphRadioRefreshInterval);
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
 
    g_pSM_VideoDecodeStats = shared_mem_video_stream_stats_rx_processors_open_for_write();
    if ( NULL == g_pSM_VideoDecodeStats )
@@ -1264,70 +1273,81 @@ int _consume_ipc_messages()
 }
 
 
+void _process_received_rx_packet(u8* pPacket, int iPacketLength, int iRadioInterfaceIndex)
+{
+   t_packet_header* pPH = (t_packet_header*)pPacket;
+   if ( (pPH->packet_flags & PACKET_FLAGS_MASK_MODULE) == PACKET_COMPONENT_VIDEO )
+   if ( pPH->packet_type == PACKET_TYPE_VIDEO_DATA )
+   {
+      if ( ! g_bSearching )
+      if ( ! (pPH->packet_flags & PACKET_FLAGS_BIT_RETRANSMITED) )
+      {
+         t_packet_header_video_segment* pPHVS = (t_packet_header_video_segment*)(pPacket + sizeof(t_packet_header));
+         if ( pPHVS->uCurrentBlockPacketIndex >= pPHVS->uCurrentBlockDataPackets )
+            g_SMControllerRTInfo.uRxVideoECPackets[g_SMControllerRTInfo.iCurrentIndex][0]++;
+         else
+            g_SMControllerRTInfo.uRxVideoPackets[g_SMControllerRTInfo.iCurrentIndex][0]++;
+      }
+   }
+   if ( g_bSearching )
+   if ( pPH->packet_type != PACKET_TYPE_VIDEO_DATA )
+      log_line("Process received radio packet (%s) while searching.", str_get_packet_type(pPH->packet_type));
+   process_received_single_radio_packet(iRadioInterfaceIndex, pPacket, iPacketLength);      
+   shared_mem_radio_stats_rx_hist_update(&g_SM_HistoryRxStats, iRadioInterfaceIndex, pPacket, g_TimeNow);
+   g_SMControllerRTInfo.uRxProcessedPackets[g_SMControllerRTInfo.iCurrentIndex]++;
+
+   if ( (pPH->packet_flags & PACKET_FLAGS_MASK_MODULE) == PACKET_COMPONENT_VIDEO )
+   if ( pPH->packet_type == PACKET_TYPE_VIDEO_DATA )
+   if ( ! (pPH->packet_flags & PACKET_FLAGS_BIT_RETRANSMITED) )
+   if ( ! g_bSearching )
+   {
+      bool bEndFrameDetected = false;
+      ProcessorRxVideo* pProcessorRxVideo = ProcessorRxVideo::getVideoProcessorForVehicleId(g_pCurrentModel->uVehicleId, 0);
+      if ( (NULL != pProcessorRxVideo) && (NULL != pProcessorRxVideo->m_pVideoRxBuffer) )
+      {
+         if ( pProcessorRxVideo->m_pVideoRxBuffer->isFrameEndDetected() )
+             bEndFrameDetected = true;
+      }
+
+      static u32 s_uTimeFirstRecvFrameVideoPacket = 0;
+      if ( bEndFrameDetected )
+      {
+          //log_line("DBG frame rx duration: %d ms", g_TimeNow - s_uTimeFirstRecvFrameVideoPacket);
+          s_uTimeFirstRecvFrameVideoPacket = 0;
+      }
+      if ( 0 == s_uTimeFirstRecvFrameVideoPacket )
+         s_uTimeFirstRecvFrameVideoPacket = g_TimeNow;
+   }
+}
+
 int _try_read_consume_rx_packets(bool bHighPriority, int iCountMax, u32 uTimeoutMicrosec)
 {
    int iCountConsumed = 0;
-   int iPacketLength = 0;
-   int iPacketIsShort = 0;
-   int iRadioInterfaceIndex = 0;
-   u8* pPacket = NULL;
+   type_received_radio_packet packets[32];
 
+   // Drain as many packets as available (up to iCountMax) on each wakeup
    while ( (iCountConsumed < iCountMax) && (!g_bQuit) )
    {
+      int iToRead = iCountMax - iCountConsumed;
+      if ( iToRead > (int)(sizeof(packets)/sizeof(packets[0])) )
+         iToRead = (int)(sizeof(packets)/sizeof(packets[0]));
+
+      int iCount = 0;
       if ( bHighPriority )
-         pPacket = radio_rx_wait_get_next_received_high_prio_packet(uTimeoutMicrosec, &iPacketLength, &iPacketIsShort, &iRadioInterfaceIndex);
+         iCount = radio_rx_wait_get_next_received_high_prio_packets(uTimeoutMicrosec, packets, iToRead);
       else
-         pPacket = radio_rx_wait_get_next_received_reg_prio_packet(uTimeoutMicrosec, &iPacketLength, &iPacketIsShort, &iRadioInterfaceIndex);
+         iCount = radio_rx_wait_get_next_received_reg_prio_packets(uTimeoutMicrosec, packets, iToRead);
 
-      if ( NULL == pPacket )
-         break;
-      iCountConsumed++;
-      if ( g_bQuit )
+      if ( 0 == iCount )
          break;
 
-      t_packet_header* pPH = (t_packet_header*)pPacket;
-      if ( (pPH->packet_flags & PACKET_FLAGS_MASK_MODULE) == PACKET_COMPONENT_VIDEO )
-      if ( pPH->packet_type == PACKET_TYPE_VIDEO_DATA )
+      for( int i=0; i<iCount; i++ )
       {
-         if ( ! g_bSearching )
-         if ( ! (pPH->packet_flags & PACKET_FLAGS_BIT_RETRANSMITED) )
-         {
-            t_packet_header_video_segment* pPHVS = (t_packet_header_video_segment*)(pPacket + sizeof(t_packet_header));
-            if ( pPHVS->uCurrentBlockPacketIndex >= pPHVS->uCurrentBlockDataPackets )
-               g_SMControllerRTInfo.uRxVideoECPackets[g_SMControllerRTInfo.iCurrentIndex][0]++;
-            else
-               g_SMControllerRTInfo.uRxVideoPackets[g_SMControllerRTInfo.iCurrentIndex][0]++;
-         }
+         iCountConsumed++;
+         if ( g_bQuit )
+            break;
+         _process_received_rx_packet(packets[i].pPacketData, packets[i].iPacketLength, packets[i].iPacketRxInterface);
       }
-      if ( g_bSearching )
-      if ( pPH->packet_type != PACKET_TYPE_VIDEO_DATA )
-         log_line("Process received radio packet (%s) while searching.", str_get_packet_type(pPH->packet_type));
-      process_received_single_radio_packet(iRadioInterfaceIndex, pPacket, iPacketLength);      
-      shared_mem_radio_stats_rx_hist_update(&g_SM_HistoryRxStats, iRadioInterfaceIndex, pPacket, g_TimeNow);
-      g_SMControllerRTInfo.uRxProcessedPackets[g_SMControllerRTInfo.iCurrentIndex]++;
-
-      if ( (pPH->packet_flags & PACKET_FLAGS_MASK_MODULE) == PACKET_COMPONENT_VIDEO )
-      if ( pPH->packet_type == PACKET_TYPE_VIDEO_DATA )
-      if ( ! (pPH->packet_flags & PACKET_FLAGS_BIT_RETRANSMITED) )
-      if ( ! g_bSearching )
-      {
-         bool bEndFrameDetected = false;
-         ProcessorRxVideo* pProcessorRxVideo = ProcessorRxVideo::getVideoProcessorForVehicleId(g_pCurrentModel->uVehicleId, 0);
-         if ( (NULL != pProcessorRxVideo) && (NULL != pProcessorRxVideo->m_pVideoRxBuffer) )
-         {
-            if ( pProcessorRxVideo->m_pVideoRxBuffer->isFrameEndDetected() )
-                bEndFrameDetected = true;
-         }
-
-         static u32 s_uTimeFirstRecvFrameVideoPacket = 0;
-         if ( bEndFrameDetected )
-         {
-             //log_line("DBG frame rx duration: %d ms", g_TimeNow - s_uTimeFirstRecvFrameVideoPacket);
-             s_uTimeFirstRecvFrameVideoPacket = 0;
-         }
-         if ( 0 == s_uTimeFirstRecvFrameVideoPacket )
-            s_uTimeFirstRecvFrameVideoPacket = g_TimeNow;
-      }      
    }
 
    return iCountConsumed;
@@ -1360,6 +1380,8 @@ int main(int argc, char *argv[])
    }
       
    log_init("Router");
+   log_enable_async();
+   trace_init("ruby_rt_station");
    
    hardware_detectBoardAndSystemType();
 
@@ -1440,6 +1462,13 @@ int main(int argc, char *argv[])
    else
       radio_set_use_pcap_for_tx(0);
 
+   if ( g_pControllerSettings->iRadioRxUsesRing )
+      radio_set_use_rx_ring(1);
+   else
+      radio_set_use_rx_ring(0);
+
+   radio_rx_set_thread_per_interface(g_pControllerSettings->iRadioRxThreadPerInterface);
+
    g_uControllerId = controller_utils_getControllerId();
    log_line("Controller UID: %u", g_uControllerId);
 
@@ -1451,6 +1480,7 @@ int main(int argc, char *argv[])
       g_pCurrentModel = getCurrentModel();
       if ( g_pCurrentModel->enc_flags != MODEL_ENC_FLAGS_NONE )
          lpp(NULL, 0);
+      spm((g_pCurrentModel->enc_flags & MODEL_ENC_FLAG_USE_AEAD)?ENC_PP_MODE_AEAD:ENC_PP_MODE_XOR);
       g_pCurrentModel->logVehicleRadioInfo();
 
       g_uAcceptedFirmwareType = g_pCurrentModel->getVehicleFirmwareType();
@@ -1578,6 +1608,7 @@ int main(int argc, char *argv[])
    load_CorePlugins(0);
 
    radio_duplicate_detection_init();
+   radio_duplicate_detection_update_radio_interfaces();
    radio_rx_start_rx_thread(&g_SM_RadioStats, (int)g_bSearching, g_uAcceptedFirmwareType);
    
    log_line("Broadcasting that router is ready.");
@@ -1618,6 +1649,8 @@ int main(int argc, char *argv[])
    u32 uLastLoopTime = g_TimeNow;
    g_pProcessStats->uLoopTimer1 = g_pProcessStats->uLoopTimer2 = g_TimeNow;
 
+   hw_sys_mark_startup_complete();
+
    while ( !g_bQuit )
    {
       g_TimeNow = get_current_timestamp_ms();
@@ -1815,6 +1848,8 @@ void _main_loop_searching()
    u32 uTimeNow = get_current_timestamp_ms();
    if ( NULL != g_pProcessStats )
    {
+      g_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+      g_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
       if ( g_pProcessStats->uMaxLoopTimeMs < uTimeNow - g_TimeNow )
          g_pProcessStats->uMaxLoopTimeMs = uTimeNow - g_TimeNow;
       g_pProcessStats->uTotalLoopTime += uTimeNow - g_TimeNow;
@@ -1960,6 +1995,8 @@ void _main_loop_simple(bool bDoBasicTxSync)
 
    if ( NULL != g_pProcessStats )
    {
+      g_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+      g_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
       if ( g_pProcessStats->uMaxLoopTimeMs < tTime4 - tTime0 )
          g_pProcessStats->uMaxLoopTimeMs = tTime4 - tTime0;
       g_pProcessStats->uTotalLoopTime += tTime4 - tTime0;
@@ -2132,6 +2169,8 @@ void _main_loop_adv_sync()
 
    if ( NULL != g_pProcessStats )
    {
+      g_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+      g_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
       if ( g_pProcessStats->uMaxLoopTimeMs < tTime4 - tTime0 )
          g_pProcessStats->uMaxLoopTimeMs = tTime4 - tTime0;
       g_pProcessStats->uTotalLoopTime += tTime4 - tTime0;
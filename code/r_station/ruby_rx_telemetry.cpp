@@ -32,6 +32,7 @@
 
 #include "../base/hardware.h"
 #include "../base/hw_procs.h"
+#include "../base/hw_sys.h"
 #include "../base/shared_mem.h"
 #include "../radio/radiolink.h"
 #include "../radio/radiopackets2.h"
@@ -888,9 +889,12 @@ int main(int argc, char *argv[])
  
    int iSleepTime = 50;
 
+   hw_sys_mark_startup_complete();
+
    while (!g_bQuit) 
    {
-      hardware_sleep_ms(iSleepTime);
+      // Wakes up as soon as the router sends a message
+      ruby_ipc_wait_for_message(s_fIPCFromRouter, iSleepTime*1000);
 
       g_TimeNow = get_current_timestamp_ms();
       if ( NULL != g_pProcessStats )
@@ -929,6 +933,8 @@ int main(int argc, char *argv[])
 
       if ( NULL != g_pProcessStats )
       {
+         g_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+         g_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
          if ( g_pProcessStats->uMaxLoopTimeMs < tNow - tTime0 )
             g_pProcessStats->uMaxLoopTimeMs = tNow - tTime0;
          g_pProcessStats->uTotalLoopTime += tNow - tTime0;
@@ -52,6 +52,7 @@
 #include "../base/models.h"
 #include "../base/models_list.h"
 #include "../base/hw_procs.h"
+#include "../base/hw_sys.h"
 #include "../base/utils.h"
 #include "../base/ctrl_interfaces.h"
 #include "../base/ctrl_settings.h"
@@ -237,6 +238,8 @@ void _update_loop_info(u32 tTime0)
    u32 tNow = get_current_timestamp_ms();
    if ( NULL != s_pProcessStats )
    {
+      s_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+      s_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
       if ( s_pProcessStats->uMaxLoopTimeMs < tNow - tTime0 )
          s_pProcessStats->uMaxLoopTimeMs = tNow - tTime0;
       s_pProcessStats->uTotalLoopTime += tNow - tTime0;
@@ -353,6 +356,8 @@ int main (int argc, char *argv[])
    iSleepTime = 10;
    #endif
 
+   hw_sys_mark_startup_complete();
+
    while ( !g_bQuit )
    { 
       g_iFPSFramesCount++;
@@ -35,6 +35,7 @@
 #include "timers.h"
 #include "packets_utils.h"
 #include "../radio/fec.h"
+#include "../base/trace.h"
 
 int VideoRxPacketsBuffer::m_siVideoBuffersInstancesCount = 0;
 
@@ -151,6 +152,7 @@ void VideoRxPacketsBuffer::_empty_block_buffer_packet_index(int iBufferIndex, in
    m_VideoBlocks[iBufferIndex].packets[iPacketIndex].bEmpty = true;
    m_VideoBlocks[iBufferIndex].packets[iPacketIndex].bReconstructed = false;
    m_VideoBlocks[iBufferIndex].packets[iPacketIndex].bOutputed = false;
+   m_VideoBlocks[iBufferIndex].packets[iPacketIndex].bRetransmissionScheduled = false;
 }
 
 void VideoRxPacketsBuffer::_empty_block_buffer_index(int iBufferIndex)
@@ -286,7 +288,9 @@ void VideoRxPacketsBuffer::_check_do_ec_for_video_block(int iBufferIndex)
       }
    }
 
+   TRACE_BEGIN(TRACE_EVENT_FEC_DECODE, m_VideoBlocks[iBufferIndex].iBlockDataPackets, m_ECRxInfo.missing_packets_count, m_VideoBlocks[iBufferIndex].iBlockDataSize);
    int iRes = fec_decode(m_VideoBlocks[iBufferIndex].iBlockDataSize, m_ECRxInfo.p_decode_data_packets_pointers, m_VideoBlocks[iBufferIndex].iBlockDataPackets, m_ECRxInfo.p_decode_ec_packets_pointers, m_ECRxInfo.decode_ec_packets_indexes, m_ECRxInfo.decode_missing_packets_indexes, m_ECRxInfo.missing_packets_count);
+   TRACE_END(TRACE_EVENT_FEC_DECODE, m_VideoBlocks[iBufferIndex].iBlockDataPackets, m_ECRxInfo.missing_packets_count, m_VideoBlocks[iBufferIndex].iBlockDataSize);
    if ( iRes < 0 )
    {
       log_softerror_and_alarm("[VideoRXBuffer] Failed to decode video block [%u], type %d/%d/%d bytes; max data recv index: %d, max data/ec received index: %d, eoframe-index: %d; recv: %d/%d packets, missing count: %d",
@@ -620,6 +624,25 @@ type_rx_video_block_info* VideoRxPacketsBuffer::getVideoBlockInBuffer(int iStart
    return &(m_VideoBlocks[iIndex]);
 }
 
+type_rx_video_block_info* VideoRxPacketsBuffer::getVideoBlockWithIndex(u32 uVideoBlockIndex)
+{
+   if ( m_VideoBlocks[m_iTopBufferIndex].bEmpty )
+      return NULL;
+   if ( uVideoBlockIndex > m_VideoBlocks[m_iTopBufferIndex].uVideoBlockIndex )
+      return NULL;
+
+   u32 uDiffBlocks = m_VideoBlocks[m_iTopBufferIndex].uVideoBlockIndex - uVideoBlockIndex;
+   if ( uDiffBlocks >= (u32)m_iCountBlocksPresent )
+      return NULL;
+
+   int iIndex = m_iTopBufferIndex - (int)uDiffBlocks;
+   if ( iIndex < 0 )
+      iIndex += MAX_RXTX_BLOCKS_BUFFER;
+   if ( m_VideoBlocks[iIndex].bEmpty || (m_VideoBlocks[iIndex].uVideoBlockIndex != uVideoBlockIndex) )
+      return NULL;
+   return &(m_VideoBlocks[iIndex]);
+}
+
 type_rx_video_packet_info* VideoRxPacketsBuffer::getFirstPacketInBuffer(type_rx_video_block_info** ppOutputBlock)
 {
    if ( NULL != ppOutputBlock )
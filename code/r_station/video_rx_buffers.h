@@ -24,6 +24,7 @@ typedef struct
    bool bEmpty;
    bool bReconstructed;
    bool bOutputed;
+   bool bRetransmissionScheduled; // if it's in the retransmissions scheduler
 }
 type_rx_video_packet_info;
 
@@ -74,6 +75,8 @@ class VideoRxPacketsBuffer
 
       int getBlocksCountInBuffer();
       type_rx_video_block_info* getVideoBlockInBuffer(int iStartPosition);
+      // Returns NULL if the video block is not in the buffer
+      type_rx_video_block_info* getVideoBlockWithIndex(u32 uVideoBlockIndex);
       type_rx_video_packet_info* getFirstPacketInBuffer(type_rx_video_block_info** ppOutputBlock);
       void goToNextPacketInBuffer();
       int discardOldBlocks(u32 uCutOffTime);
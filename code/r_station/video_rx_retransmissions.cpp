@@ -0,0 +1,216 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "video_rx_retransmissions.h"
+
+VideoRxRetransmissionsScheduler::VideoRxRetransmissionsScheduler()
+{
+   m_iCountEntries = 0;
+   m_uCountDroppedEntries = 0;
+   m_uMinTimeoutMs = 10;
+   m_uMaxTimeoutMs = 100;
+   resetRoundtripEstimate();
+}
+
+VideoRxRetransmissionsScheduler::~VideoRxRetransmissionsScheduler()
+{
+}
+
+void VideoRxRetransmissionsScheduler::reset()
+{
+   m_iCountEntries = 0;
+}
+
+void VideoRxRetransmissionsScheduler::resetRoundtripEstimate()
+{
+   m_bHasRoundtripSamples = false;
+   m_fSmoothedRoundtripMs = 0.0;
+   m_fRoundtripVariationMs = 0.0;
+}
+
+void VideoRxRetransmissionsScheduler::setTimeoutLimits(u32 uMinTimeoutMs, u32 uMaxTimeoutMs)
+{
+   if ( uMinTimeoutMs < 1 )
+      uMinTimeoutMs = 1;
+   if ( uMaxTimeoutMs < uMinTimeoutMs )
+      uMaxTimeoutMs = uMinTimeoutMs;
+   m_uMinTimeoutMs = uMinTimeoutMs;
+   m_uMaxTimeoutMs = uMaxTimeoutMs;
+}
+
+void VideoRxRetransmissionsScheduler::addRoundtripSample(u32 uRoundtripMs)
+{
+   float fSample = (float)uRoundtripMs;
+   if ( ! m_bHasRoundtripSamples )
+   {
+      m_bHasRoundtripSamples = true;
+      m_fSmoothedRoundtripMs = fSample;
+      m_fRoundtripVariationMs = fSample * 0.5;
+      return;
+   }
+   float fDelta = m_fSmoothedRoundtripMs - fSample;
+   if ( fDelta < 0.0 )
+      fDelta = -fDelta;
+   m_fRoundtripVariationMs = 0.75 * m_fRoundtripVariationMs + 0.25 * fDelta;
+   m_fSmoothedRoundtripMs = 0.875 * m_fSmoothedRoundtripMs + 0.125 * fSample;
+}
+
+bool VideoRxRetransmissionsScheduler::hasRoundtripSamples()
+{
+   return m_bHasRoundtripSamples;
+}
+
+u32 VideoRxRetransmissionsScheduler::getSmoothedRoundtrip()
+{
+   return (u32)(m_fSmoothedRoundtripMs + 0.5);
+}
+
+u32 VideoRxRetransmissionsScheduler::getRoundtripVariation()
+{
+   return (u32)(m_fRoundtripVariationMs + 0.5);
+}
+
+u32 VideoRxRetransmissionsScheduler::getRetryTimeout(int iPreviousRequestsCount)
+{
+   // No samples yet: use a few times the minimum retry interval
+   u32 uTimeout = 4 * m_uMinTimeoutMs;
+   if ( m_bHasRoundtripSamples )
+      uTimeout = (u32)(m_fSmoothedRoundtripMs + 4.0 * m_fRoundtripVariationMs + 0.5);
+
+   if ( iPreviousRequestsCount > 1 )
+   {
+      int iShift = iPreviousRequestsCount - 1;
+      if ( iShift > 3 )
+         iShift = 3;
+      uTimeout <<= iShift;
+   }
+   if ( uTimeout < m_uMinTimeoutMs )
+      uTimeout = m_uMinTimeoutMs;
+   if ( uTimeout > m_uMaxTimeoutMs )
+      uTimeout = m_uMaxTimeoutMs;
+   return uTimeout;
+}
+
+// Earlier deadline first; on equal deadlines, older blocks and lower packet indexes first
+bool VideoRxRetransmissionsScheduler::_is_before(type_retr_scheduler_entry* pEntry1, type_retr_scheduler_entry* pEntry2)
+{
+   if ( pEntry1->uDeadline != pEntry2->uDeadline )
+      return pEntry1->uDeadline < pEntry2->uDeadline;
+   if ( pEntry1->uVideoBlockIndex != pEntry2->uVideoBlockIndex )
+      return pEntry1->uVideoBlockIndex < pEntry2->uVideoBlockIndex;
+   return pEntry1->uPacketIndex < pEntry2->uPacketIndex;
+}
+
+void VideoRxRetransmissionsScheduler::_sift_up(int iIndex)
+{
+   type_retr_scheduler_entry entry = m_Entries[iIndex];
+   while ( iIndex > 0 )
+   {
+      int iParent = (iIndex-1)/2;
+      if ( ! _is_before(&entry, &(m_Entries[iParent])) )
+         break;
+      m_Entries[iIndex] = m_Entries[iParent];
+      iIndex = iParent;
+   }
+   m_Entries[iIndex] = entry;
+}
+
+void VideoRxRetransmissionsScheduler::_sift_down(int iIndex)
+{
+   type_retr_scheduler_entry entry = m_Entries[iIndex];
+   while ( true )
+   {
+      int iChild = 2*iIndex + 1;
+      if ( iChild >= m_iCountEntries )
+         break;
+      if ( (iChild+1 < m_iCountEntries) && _is_before(&(m_Entries[iChild+1]), &(m_Entries[iChild])) )
+         iChild++;
+      if ( ! _is_before(&(m_Entries[iChild]), &entry) )
+         break;
+      m_Entries[iIndex] = m_Entries[iChild];
+      iIndex = iChild;
+   }
+   m_Entries[iIndex] = entry;
+}
+
+bool VideoRxRetransmissionsScheduler::addEntry(u32 uVideoBlockIndex, int iPacketIndex, u32 uDeadline, u8 uRequestCount)
+{
+   if ( (iPacketIndex < 0) || (iPacketIndex >= MAX_TOTAL_PACKETS_IN_BLOCK) )
+      return false;
+   if ( m_iCountEntries >= RETR_SCHEDULER_MAX_ENTRIES )
+   {
+      m_uCountDroppedEntries++;
+      return false;
+   }
+   m_Entries[m_iCountEntries].uDeadline = uDeadline;
+   m_Entries[m_iCountEntries].uVideoBlockIndex = uVideoBlockIndex;
+   m_Entries[m_iCountEntries].uPacketIndex = (u8)iPacketIndex;
+   m_Entries[m_iCountEntries].uRequestCount = uRequestCount;
+   m_iCountEntries++;
+   _sift_up(m_iCountEntries-1);
+   return true;
+}
+
+bool VideoRxRetransmissionsScheduler::popDueEntry(u32 uTimeNow, type_retr_scheduler_entry* pOutEntry)
+{
+   if ( 0 == m_iCountEntries )
+      return false;
+   if ( m_Entries[0].uDeadline > uTimeNow )
+      return false;
+
+   if ( NULL != pOutEntry )
+      *pOutEntry = m_Entries[0];
+   m_iCountEntries--;
+   if ( m_iCountEntries > 0 )
+   {
+      m_Entries[0] = m_Entries[m_iCountEntries];
+      _sift_down(0);
+   }
+   return true;
+}
+
+u32 VideoRxRetransmissionsScheduler::getNextDeadline()
+{
+   if ( 0 == m_iCountEntries )
+      return MAX_U32;
+   return m_Entries[0].uDeadline;
+}
+
+int VideoRxRetransmissionsScheduler::getEntriesCount()
+{
+   return m_iCountEntries;
+}
+
+u32 VideoRxRetransmissionsScheduler::getDroppedEntriesCount()
+{
+   return m_uCountDroppedEntries;
+}
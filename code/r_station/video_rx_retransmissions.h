@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../base/base.h"
+#include "../radio/radiopackets2.h"
+
+// Retransmission requests scheduler for the video rx buffer.
+// Keeps the missing (video block, packet) pairs in a min-heap ordered by the time they are due
+// to be requested next, so each check only looks at the entries that are due instead of walking
+// the whole rx buffer. The retry timeout comes from a smoothed roundtrip time (SRTT) and its
+// variation (RTTVAR) of the vehicle's retransmission acks, computed as in RFC 6298.
+// Entries are not removed when a packet is received or a block is discarded; the caller
+// validates each due entry against the rx buffer and drops the stale ones.
+
+// How long a newly detected gap waits before it's requested, in case the packets are just reordered
+#define RETR_SCHEDULER_REORDER_HOLD_MS 2
+#define RETR_SCHEDULER_MAX_ENTRIES (MAX_RXTX_BLOCKS_BUFFER * MAX_TOTAL_PACKETS_IN_BLOCK)
+
+typedef struct
+{
+   u32 uDeadline;
+   u32 uVideoBlockIndex;
+   u8 uPacketIndex;
+   u8 uRequestCount;
+}
+type_retr_scheduler_entry;
+
+class VideoRxRetransmissionsScheduler
+{
+   public:
+      VideoRxRetransmissionsScheduler();
+      virtual ~VideoRxRetransmissionsScheduler();
+
+      // Drops all scheduled entries. The roundtrip estimate is kept.
+      void reset();
+      void resetRoundtripEstimate();
+
+      // Retry timeouts are clamped to [uMinTimeoutMs, uMaxTimeoutMs]
+      void setTimeoutLimits(u32 uMinTimeoutMs, u32 uMaxTimeoutMs);
+      void addRoundtripSample(u32 uRoundtripMs);
+      bool hasRoundtripSamples();
+      u32 getSmoothedRoundtrip();
+      u32 getRoundtripVariation();
+      // Time to wait for a requested packet before requesting it again (RTO = SRTT + 4*RTTVAR),
+      // doubled for each previous request of the same packet, up to the max timeout.
+      u32 getRetryTimeout(int iPreviousRequestsCount);
+
+      // Returns false if the scheduler is full
+      bool addEntry(u32 uVideoBlockIndex, int iPacketIndex, u32 uDeadline, u8 uRequestCount);
+      // Removes and returns the earliest entry if it's due at uTimeNow
+      bool popDueEntry(u32 uTimeNow, type_retr_scheduler_entry* pOutEntry);
+      // MAX_U32 if there is nothing scheduled
+      u32 getNextDeadline();
+      int getEntriesCount();
+      u32 getDroppedEntriesCount();
+
+   protected:
+      bool _is_before(type_retr_scheduler_entry* pEntry1, type_retr_scheduler_entry* pEntry2);
+      void _sift_up(int iIndex);
+      void _sift_down(int iIndex);
+
+      type_retr_scheduler_entry m_Entries[RETR_SCHEDULER_MAX_ENTRIES];
+      int m_iCountEntries;
+      u32 m_uCountDroppedEntries;
+
+      bool m_bHasRoundtripSamples;
+      float m_fSmoothedRoundtripMs;
+      float m_fRoundtripVariationMs;
+      u32 m_uMinTimeoutMs;
+      u32 m_uMaxTimeoutMs;
+};
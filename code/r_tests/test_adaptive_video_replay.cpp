@@ -0,0 +1,481 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Offline evaluator for the adaptive video controllers (r_station/adaptive_video_engine.h).
+// Replays a recorded trace (the controller records it when the file FILE_TEMP_RECORD_ADAPTIVE_VIDEO_TRACE
+// is present in the temp folder) through a link simulator, closed loop, for each controller:
+// fixed user profile, reactive (default) and predictive. The link state of each slice comes from the
+// recorded SNR, or, if the trace has no SNR, from the recorded packet loss of the recorded profile.
+// Without a trace file it records and replays a synthetic one (good link, slow fade, fast fading,
+// deep fade, recovery) and checks the predictive controller's decisions.
+//
+// Usage: test_adaptive_video_replay [trace_file] [-strength N] [-lag ms]
+
+#include <math.h>
+#include "../base/base.h"
+#include "../base/flags_video.h"
+#include "../r_station/adaptive_video_engine.h"
+
+#define REPLAY_SLICE_MS 5
+#define REPLAY_PACKET_BITS 8000
+#define REPLAY_ROUNDTRIP_MS 20
+#define REPLAY_SNR_REQ_6MBPS 8.0
+#define REPLAY_DB_PER_DATARATE_DOUBLING 3.5
+#define REPLAY_LOSS_SCALE_DB 1.5
+
+#define CONTROLLER_FIXED 0
+#define CONTROLLER_REACTIVE 1
+#define CONTROLLER_PREDICTIVE 2
+#define CONTROLLERS_COUNT 3
+
+static const char* s_szControllerNames[CONTROLLERS_COUNT] = { "fixed", "reactive", "predictive" };
+static int s_iFailed = 0;
+static controller_runtime_info s_RTInfo;
+
+typedef struct
+{
+   u32 uCountBlocks;
+   u32 uCountSkippedBlocks;
+   u32 uCountSwitches;
+   double dSumBitrate;
+   u32 uCountSlices;
+   u32 uTimeInProfileMs[ADAPTIVE_VIDEO_MAX_PROFILES];
+} t_replay_result;
+
+// Link simulator state
+typedef struct
+{
+   double dPacketsCredit;
+   int iBlockDataPacketsSent;
+   u32 uSeed;
+} t_replay_link;
+
+static void _check(int iCondition, const char* szName)
+{
+   printf("%s: %s\n", iCondition?"ok  ":"FAIL", szName);
+   if ( ! iCondition )
+      s_iFailed++;
+}
+
+static double _random(u32* pSeed)
+{
+   *pSeed = (*pSeed) * 1103515245 + 12345;
+   return (double)(((*pSeed) >> 8) & 0xFFFFFF) / (double)0x1000000;
+}
+
+static double _random_gauss(u32* pSeed)
+{
+   double d1 = _random(pSeed) + 1e-9;
+   double d2 = _random(pSeed);
+   return sqrt(-2.0 * log(d1)) * cos(2.0 * M_PI * d2);
+}
+
+static double _snr_required(u32 uRadioDatarateBps)
+{
+   return REPLAY_SNR_REQ_6MBPS + REPLAY_DB_PER_DATARATE_DOUBLING * log2((double)uRadioDatarateBps / 6000000.0);
+}
+
+static double _packet_loss(double dSNR, u32 uRadioDatarateBps)
+{
+   return 1.0 / (1.0 + exp((dSNR - _snr_required(uRadioDatarateBps)) / REPLAY_LOSS_SCALE_DB));
+}
+
+static int _get_profile_index(t_adaptive_video_trace_header* pHeader, int iVideoProfile)
+{
+   for( int i=0; i<pHeader->iCountProfiles; i++ )
+      if ( pHeader->profiles[i].iVideoProfile == iVideoProfile )
+         return i;
+   return -1;
+}
+
+// Simulates one slice of video over the link, for the given profile and SNR. Fills the stats part of the slice.
+static void _simulate_slice(t_replay_link* pLink, t_adaptive_video_profile_info* pProfile, double dSNR, t_adaptive_video_slice* pSlice, t_replay_result* pResult)
+{
+   double dLoss = _packet_loss(dSNR, pProfile->uRadioDatarateBps);
+   int iBlockPackets = pProfile->iBlockDataPackets + pProfile->iBlockECPackets;
+   double dDemand = (double)pProfile->uVideoBitrateBps * iBlockPackets / pProfile->iBlockDataPackets;
+   double dUtilization = dDemand / ((double)pProfile->uRadioDatarateBps * 0.5 * (1.0 - dLoss));
+   // Overloaded link: the tx queues drop the excess
+   if ( dUtilization > 1.0 )
+      dLoss += (1.0 - dLoss) * (1.0 - 1.0/dUtilization);
+
+   pSlice->iSignalDbm = (int)floor(dSNR + 0.5) - 95;
+   pSlice->iNoiseDbm = -95;
+   pSlice->uCountBlocksInRxBuffer = 1;
+
+   int iOutputed = 0, iRetransmitted = 0, iReconstructed = 0, iMaxEC = 0, iSkipped = 0;
+   int iRecvData = 0, iRecvEC = 0, iReqRetr = 0;
+
+   pLink->dPacketsCredit += (double)pProfile->uVideoBitrateBps * REPLAY_SLICE_MS / 1000.0 / REPLAY_PACKET_BITS;
+   while ( pLink->dPacketsCredit >= 1.0 )
+   {
+      pLink->dPacketsCredit -= 1.0;
+      pLink->iBlockDataPacketsSent++;
+      if ( pLink->iBlockDataPacketsSent < pProfile->iBlockDataPackets )
+         continue;
+      pLink->iBlockDataPacketsSent = 0;
+
+      // A full block was sent
+      int iLostData = 0, iLostTotal = 0;
+      for( int i=0; i<iBlockPackets; i++ )
+      {
+         if ( _random(&pLink->uSeed) >= dLoss )
+            continue;
+         iLostTotal++;
+         if ( i < pProfile->iBlockDataPackets )
+            iLostData++;
+      }
+      iRecvData += pProfile->iBlockDataPackets - iLostData;
+      iRecvEC += pProfile->iBlockECPackets - (iLostTotal - iLostData);
+      pResult->uCountBlocks++;
+
+      int iMissing = iLostTotal - pProfile->iBlockECPackets;
+      int iRecovered = 0;
+      if ( (iMissing > 0) && (0 != pProfile->uRetransmissionWindowMs) && (dUtilization < 1.0) )
+      {
+         pSlice->uCountBlocksInRxBuffer = 3;
+         int iRounds = pProfile->uRetransmissionWindowMs / REPLAY_ROUNDTRIP_MS;
+         int iRequested = iLostData;
+         for( int r=0; (r<iRounds) && (iMissing > 0); r++ )
+         {
+            iReqRetr += iRequested;
+            for( int i=0; i<iRequested; i++ )
+            {
+               if ( _random(&pLink->uSeed) < dLoss )
+                  continue;
+               iRecovered++;
+               iRequested--;
+               iMissing--;
+            }
+         }
+         pSlice->uMinAckTimeMs = REPLAY_ROUNDTRIP_MS;
+      }
+      if ( iMissing > 0 )
+      {
+         iSkipped++;
+         pResult->uCountSkippedBlocks++;
+         continue;
+      }
+      iOutputed += pProfile->iBlockDataPackets;
+      iRetransmitted += iRecovered;
+      int iECUsed = iLostData - iRecovered;
+      iReconstructed += iECUsed;
+      if ( iECUsed > iMaxEC )
+         iMaxEC = iECUsed;
+   }
+
+   pSlice->uOutputedVideoPackets = (u8)(iOutputed > 255 ? 255 : iOutputed);
+   pSlice->uOutputedVideoPacketsRetransmitted = (u8)iRetransmitted;
+   pSlice->uOutputedVideoPacketsReconstructed = (u8)iReconstructed;
+   pSlice->uOutputedVideoPacketsMaxECUsed = (u8)iMaxEC;
+   pSlice->uOutputedVideoPacketsSkippedBlocks = (u8)iSkipped;
+   pSlice->uRecvVideoDataPackets = (u8)(iRecvData > 255 ? 255 : iRecvData);
+   pSlice->uRecvVideoECPackets = (u8)(iRecvEC > 255 ? 255 : iRecvEC);
+   pSlice->uCountReqRetrPackets = (u8)(iReqRetr > 255 ? 255 : iReqRetr);
+}
+
+// Link SNR over time for the synthetic trace
+static double _synthetic_snr(u32 uTimeMs, u32* pSeed)
+{
+   double dTime = (double)uTimeMs / 1000.0;
+   double dSNR = 30.0;
+   if ( dTime >= 10.0 && dTime < 18.0 )
+      dSNR = 30.0 - 18.0 * (dTime - 10.0) / 8.0;
+   else if ( dTime >= 18.0 && dTime < 20.0 )
+      dSNR = 12.0;
+   else if ( dTime >= 20.0 && dTime < 35.0 )
+      dSNR = 22.0 + 8.0 * sin(2.0 * M_PI * 1.5 * (dTime - 20.0));
+   else if ( dTime >= 35.0 && dTime < 36.0 )
+      dSNR = 22.0 - 11.0 * (dTime - 35.0);
+   else if ( dTime >= 36.0 && dTime < 45.0 )
+      dSNR = 11.0;
+   else if ( dTime >= 45.0 && dTime < 47.0 )
+      dSNR = 11.0 + 9.5 * (dTime - 45.0);
+   return dSNR + _random_gauss(pSeed);
+}
+
+static void _build_synthetic_header(t_adaptive_video_trace_header* pHeader, int iAdjustmentStrength)
+{
+   memset(pHeader, 0, sizeof(t_adaptive_video_trace_header));
+   pHeader->uSliceIntervalMs = REPLAY_SLICE_MS;
+   pHeader->uVehicleId = 1;
+   pHeader->iAdjustmentStrength = iAdjustmentStrength;
+   pHeader->iUserVideoProfile = VIDEO_PROFILE_BEST_PERF;
+   pHeader->iCountProfiles = 3;
+   t_adaptive_video_profile_info profiles[3] =
+   {
+      { VIDEO_PROFILE_LQ, 8, 3, 1500000, 6000000, 60 },
+      { VIDEO_PROFILE_MQ, 10, 3, 3500000, 12000000, 60 },
+      { VIDEO_PROFILE_BEST_PERF, 10, 3, 5000000, 18000000, 60 }
+   };
+   memcpy(pHeader->profiles, profiles, sizeof(profiles));
+}
+
+static int _record_synthetic_trace(const char* szFile, int iAdjustmentStrength)
+{
+   t_adaptive_video_trace_header header;
+   _build_synthetic_header(&header, iAdjustmentStrength);
+   FILE* fd = adaptive_video_trace_create(szFile, &header);
+   if ( NULL == fd )
+      return 0;
+
+   t_replay_link link;
+   memset(&link, 0, sizeof(link));
+   link.uSeed = 1234;
+   t_replay_result result;
+   memset(&result, 0, sizeof(result));
+   u32 uSeedSNR = 4321;
+   int iUserIndex = _get_profile_index(&header, header.iUserVideoProfile);
+   for( u32 uTime = 0; uTime < 60000; uTime += REPLAY_SLICE_MS )
+   {
+      t_adaptive_video_slice slice;
+      memset(&slice, 0, sizeof(slice));
+      slice.uTimeMs = uTime;
+      slice.uVehicleId = header.uVehicleId;
+      slice.uVideoProfile = header.iUserVideoProfile;
+      _simulate_slice(&link, &(header.profiles[iUserIndex]), _synthetic_snr(uTime, &uSeedSNR), &slice, &result);
+      adaptive_video_trace_add_slice(fd, &slice);
+   }
+   fclose(fd);
+   return 1;
+}
+
+// Same decisions as the station's reactive path (adaptive_video.cpp)
+static int _reactive_decide(t_adaptive_video_trace_header* pHeader, int iCurrentProfile, int iPendingProfile, u32 uTimeNow, u32 uTimeLastRequest, u32 uTimeLastAck)
+{
+   int iCurrentIndex = _get_profile_index(pHeader, iCurrentProfile);
+   int iECScheme = pHeader->profiles[iCurrentIndex].iBlockECPackets;
+   int iLowestProfile = pHeader->profiles[0].iVideoProfile;
+
+   if ( (iCurrentProfile != iLowestProfile) && (iPendingProfile != iLowestProfile) && (uTimeLastRequest + 30 < uTimeNow) )
+   if ( adaptive_video_reactive_should_switch_lower(&s_RTInfo, uTimeNow, uTimeLastAck, iECScheme, pHeader->iAdjustmentStrength) )
+      return adaptive_video_get_lower_video_profile(iCurrentProfile);
+
+   u32 uMinTimeToSwitchHigher = 3000 + (10 - pHeader->iAdjustmentStrength) * 400;
+   if ( (iCurrentProfile != pHeader->iUserVideoProfile) && (iPendingProfile != pHeader->iUserVideoProfile) )
+   if ( (uTimeNow > uMinTimeToSwitchHigher) && (uTimeLastRequest + uMinTimeToSwitchHigher < uTimeNow) )
+   if ( adaptive_video_reactive_should_switch_higher(&s_RTInfo, uTimeNow, iECScheme, pHeader->iAdjustmentStrength) )
+      return adaptive_video_get_higher_video_profile(iCurrentProfile, pHeader->iUserVideoProfile);
+   return -1;
+}
+
+// Replays the trace through the link simulator with the given controller. piProfileAt (optional) gets the profile in use at each slice.
+static void _replay(int iController, t_adaptive_video_trace_header* pHeader, t_adaptive_video_slice* pSlices, int iCountSlices, u32 uLagMs, t_replay_result* pResult, u8* piProfileAt)
+{
+   memset(pResult, 0, sizeof(t_replay_result));
+   memset(&s_RTInfo, 0, sizeof(s_RTInfo));
+   s_RTInfo.uUpdateIntervalMs = pHeader->uSliceIntervalMs;
+
+   t_adaptive_video_mpc_state stateMPC;
+   adaptive_video_mpc_init(&stateMPC, pHeader->iAdjustmentStrength);
+
+   t_replay_link link;
+   memset(&link, 0, sizeof(link));
+   link.uSeed = 98765;
+
+   int iCurrentProfile = pHeader->iUserVideoProfile;
+   int iPendingProfile = -1;
+   u32 uTimeApplyPending = 0;
+   u32 uTimeLastRequest = 0;
+   u32 uTimeLastAck = 0;
+   double dLossRecorded = 0.0;
+
+   for( int i=0; i<iCountSlices; i++ )
+   {
+      t_adaptive_video_slice* pRecorded = &(pSlices[i]);
+      u32 uTimeNow = pRecorded->uTimeMs;
+
+      if ( (-1 != iPendingProfile) && (uTimeNow >= uTimeApplyPending) )
+      {
+         if ( iPendingProfile != iCurrentProfile )
+            pResult->uCountSwitches++;
+         iCurrentProfile = iPendingProfile;
+         iPendingProfile = -1;
+         uTimeLastAck = uTimeNow;
+      }
+
+      // Link state of this slice
+      double dSNR = 0.0;
+      if ( ADAPTIVE_VIDEO_NO_DBM != pRecorded->iSignalDbm )
+         dSNR = pRecorded->iSignalDbm - pRecorded->iNoiseDbm;
+      else
+      {
+         int iRecordedIndex = _get_profile_index(pHeader, pRecorded->uVideoProfile);
+         if ( -1 == iRecordedIndex )
+            iRecordedIndex = pHeader->iCountProfiles-1;
+         double dTotal = pRecorded->uOutputedVideoPackets + 8.0 * pRecorded->uOutputedVideoPacketsSkippedBlocks;
+         if ( dTotal > 0.0 )
+            dLossRecorded += 0.1 * ((pRecorded->uOutputedVideoPacketsReconstructed + pRecorded->uOutputedVideoPacketsRetransmitted + 8.0 * pRecorded->uOutputedVideoPacketsSkippedBlocks)/dTotal - dLossRecorded);
+         double dLoss = dLossRecorded;
+         if ( dLoss < 0.0001 )
+            dLoss = 0.0001;
+         if ( dLoss > 0.95 )
+            dLoss = 0.95;
+         dSNR = _snr_required(pHeader->profiles[iRecordedIndex].uRadioDatarateBps) + REPLAY_LOSS_SCALE_DB * log((1.0 - dLoss)/dLoss);
+      }
+
+      int iCurrentIndex = _get_profile_index(pHeader, iCurrentProfile);
+      t_adaptive_video_slice slice;
+      memset(&slice, 0, sizeof(slice));
+      slice.uTimeMs = uTimeNow;
+      slice.uVehicleId = pHeader->uVehicleId;
+      slice.uVideoProfile = iCurrentProfile;
+      _simulate_slice(&link, &(pHeader->profiles[iCurrentIndex]), dSNR, &slice, pResult);
+
+      pResult->uCountSlices++;
+      pResult->dSumBitrate += pHeader->profiles[iCurrentIndex].uVideoBitrateBps;
+      pResult->uTimeInProfileMs[iCurrentIndex] += pHeader->uSliceIntervalMs;
+      if ( NULL != piProfileAt )
+         piProfileAt[i] = iCurrentProfile;
+
+      int iRequestProfile = -1;
+      if ( CONTROLLER_REACTIVE == iController )
+      {
+         s_RTInfo.iCurrentIndex = i % SYSTEM_RT_INFO_INTERVALS;
+         adaptive_video_put_slice(&s_RTInfo, s_RTInfo.iCurrentIndex, &slice);
+         iRequestProfile = _reactive_decide(pHeader, iCurrentProfile, iPendingProfile, uTimeNow, uTimeLastRequest, uTimeLastAck);
+      }
+      if ( CONTROLLER_PREDICTIVE == iController )
+      {
+         adaptive_video_mpc_add_slice(&stateMPC, &slice);
+         if ( (-1 == iPendingProfile) && (uTimeLastRequest + 30 < uTimeNow) )
+         {
+            int iIndex = adaptive_video_mpc_decide(&stateMPC, pHeader->profiles, pHeader->iCountProfiles, iCurrentProfile, uTimeNow, NULL);
+            if ( -1 != iIndex )
+               iRequestProfile = pHeader->profiles[iIndex].iVideoProfile;
+         }
+      }
+      if ( (-1 != iRequestProfile) && (iRequestProfile != iCurrentProfile) )
+      {
+         iPendingProfile = iRequestProfile;
+         uTimeApplyPending = uTimeNow + uLagMs;
+         uTimeLastRequest = uTimeNow;
+      }
+   }
+}
+
+static void _print_result(const char* szName, t_adaptive_video_trace_header* pHeader, t_replay_result* pResult)
+{
+   printf("%-11s blocks: %6u, skipped: %5u (%.3f%%), switches: %4u, mean bitrate: %.2f Mbps, time per profile:",
+      szName, pResult->uCountBlocks, pResult->uCountSkippedBlocks,
+      pResult->uCountBlocks?(100.0*pResult->uCountSkippedBlocks/pResult->uCountBlocks):0.0,
+      pResult->uCountSwitches,
+      pResult->uCountSlices?(pResult->dSumBitrate/pResult->uCountSlices/1000000.0):0.0);
+   for( int i=0; i<pHeader->iCountProfiles; i++ )
+      printf(" %d: %.1fs", pHeader->profiles[i].iVideoProfile, pResult->uTimeInProfileMs[i]/1000.0);
+   printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestAdaptiveVideoReplay");
+   log_disable();
+
+   const char* szTraceFile = NULL;
+   int iAdjustmentStrength = -1;
+   u32 uLagMs = 30;
+   for( int i=1; i<argc; i++ )
+   {
+      if ( (0 == strcmp(argv[i], "-strength")) && (i < argc-1) )
+         iAdjustmentStrength = atoi(argv[++i]);
+      else if ( (0 == strcmp(argv[i], "-lag")) && (i < argc-1) )
+         uLagMs = (u32)atoi(argv[++i]);
+      else if ( argv[i][0] == '-' )
+      {
+         printf("\nUsage: test_adaptive_video_replay [trace_file] [-strength N] [-lag ms]\n");
+         return -1;
+      }
+      else
+         szTraceFile = argv[i];
+   }
+
+   bool bSynthetic = (NULL == szTraceFile);
+   if ( bSynthetic )
+   {
+      szTraceFile = "/tmp/test_adaptive_video_trace.bin";
+      _check(_record_synthetic_trace(szTraceFile, (iAdjustmentStrength > 0)?iAdjustmentStrength:DEFAULT_VIDEO_PARAMS_ADJUSTMENT_STRENGTH), "synthetic trace recorded");
+   }
+
+   t_adaptive_video_trace_header header;
+   t_adaptive_video_slice* pSlices = NULL;
+   int iCountSlices = adaptive_video_trace_load(szTraceFile, &header, &pSlices);
+   if ( iCountSlices <= 0 )
+   {
+      printf("Failed to load trace file %s\n", szTraceFile);
+      return -1;
+   }
+   if ( iAdjustmentStrength > 0 )
+      header.iAdjustmentStrength = iAdjustmentStrength;
+   if ( 0 == header.uSliceIntervalMs )
+      header.uSliceIntervalMs = REPLAY_SLICE_MS;
+   if ( -1 == _get_profile_index(&header, header.iUserVideoProfile) )
+      header.iUserVideoProfile = header.profiles[header.iCountProfiles-1].iVideoProfile;
+
+   printf("Trace %s: %d slices (%.1f s), %d profiles, user profile: %d, strength: %d, lag: %u ms\n",
+      szTraceFile, iCountSlices, iCountSlices * header.uSliceIntervalMs / 1000.0, header.iCountProfiles,
+      header.iUserVideoProfile, header.iAdjustmentStrength, uLagMs);
+
+   t_replay_result results[CONTROLLERS_COUNT];
+   u8* pProfileAt = (u8*) malloc(iCountSlices);
+   for( int i=0; i<CONTROLLERS_COUNT; i++ )
+   {
+      _replay(i, &header, pSlices, iCountSlices, uLagMs, &(results[i]), (CONTROLLER_PREDICTIVE == i)?pProfileAt:NULL);
+      _print_result(s_szControllerNames[i], &header, &(results[i]));
+   }
+
+   if ( bSynthetic )
+   {
+      _check(iCountSlices == 60000/REPLAY_SLICE_MS, "trace reloaded");
+      _check(pSlices[0].uVideoProfile == VIDEO_PROFILE_BEST_PERF, "trace slices");
+      int iSliceGood = 5000/REPLAY_SLICE_MS;
+      int iSliceDeepFade = 40000/REPLAY_SLICE_MS;
+      int iSliceEnd = iCountSlices-1;
+      _check(pProfileAt[iSliceGood] == VIDEO_PROFILE_BEST_PERF, "predictive keeps user profile on good link");
+      _check(pProfileAt[iSliceDeepFade] == VIDEO_PROFILE_LQ, "predictive goes to lowest profile in deep fade");
+      _check(pProfileAt[iSliceEnd] == VIDEO_PROFILE_BEST_PERF, "predictive returns to user profile");
+      _check(results[CONTROLLER_PREDICTIVE].uCountSkippedBlocks < results[CONTROLLER_FIXED].uCountSkippedBlocks, "predictive loses less than fixed profile");
+      _check(results[CONTROLLER_PREDICTIVE].uCountSkippedBlocks <= results[CONTROLLER_REACTIVE].uCountSkippedBlocks, "predictive loses no more than reactive");
+      _check(results[CONTROLLER_PREDICTIVE].uCountSwitches < results[CONTROLLER_REACTIVE].uCountSwitches, "predictive switches less than reactive");
+      unlink(szTraceFile);
+   }
+
+   free(pProfileAt);
+   free(pSlices);
+
+   if ( s_iFailed )
+   {
+      printf("FAILED (%d)\n", s_iFailed);
+      return -1;
+   }
+   printf("PASSED\n");
+   return 0;
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../base/chacha20poly1305.h"
+#include "../base/encr.h"
+
+// Checks the ChaCha20-Poly1305 implementation against the RFC 8439 test vectors
+// and prints the AEAD speed for radio packet sizes. Also checks that the radio AEAD mode
+// (encr.c) does not reuse the keystream across sessions that restart the packet counters.
+
+static long long _get_time_us()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (long long)t.tv_sec * 1000000LL + t.tv_nsec/1000;
+}
+
+static int _check(const char* szName, const uint8_t* pResult, const uint8_t* pExpected, int iLength)
+{
+   if ( 0 == memcmp(pResult, pExpected, iLength) )
+      return 1;
+   printf("FAILED: %s\n", szName);
+   return 0;
+}
+
+int main(int argc, char *argv[])
+{
+   int iCountTests = 0;
+   int iCountFailed = 0;
+
+   printf("\nTesting ChaCha20-Poly1305 (RFC 8439 vectors)\n");
+
+   // 2.5.2 Poly1305
+   const uint8_t uPolyKey[32] = { 0x85,0xd6,0xbe,0x78,0x57,0x55,0x6d,0x33,0x7f,0x44,0x52,0xfe,0x42,0xd5,0x06,0xa8,
+                                  0x01,0x03,0x80,0x8a,0xfb,0x0d,0xb2,0xfd,0x4a,0xbf,0xf6,0xaf,0x41,0x49,0xf5,0x1b };
+   const uint8_t uPolyTag[16] = { 0xa8,0x06,0x1d,0xc1,0x30,0x51,0x36,0xc6,0xc2,0x2b,0x8b,0xaf,0x0c,0x01,0x27,0xa9 };
+   const char* szPolyMessage = "Cryptographic Forum Research Group";
+   uint8_t uTag[16];
+   poly1305_mac(uPolyKey, (const uint8_t*)szPolyMessage, strlen(szPolyMessage), uTag);
+   iCountTests++;
+   if ( ! _check("Poly1305 tag", uTag, uPolyTag, 16) )
+      iCountFailed++;
+
+   // 2.8.2 AEAD
+   uint8_t uKey[32];
+   for( int i=0; i<32; i++ )
+      uKey[i] = 0x80 + i;
+   const uint8_t uNonce[12] = { 0x07,0x00,0x00,0x00,0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47 };
+   const uint8_t uAD[12] = { 0x50,0x51,0x52,0x53,0xc0,0xc1,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7 };
+   const char* szPlainText = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+   const uint8_t uCipherStart[16] = { 0xd3,0x1a,0x8d,0x34,0x64,0x8e,0x60,0xdb,0x7b,0x86,0xaf,0xbc,0x53,0xef,0x7e,0xc2 };
+   const uint8_t uAeadTag[16] = { 0x1a,0xe1,0x0b,0x59,0x4f,0x09,0xe2,0x6a,0x7e,0x90,0x2e,0xcb,0xd0,0x60,0x06,0x91 };
+
+   int iLength = strlen(szPlainText);
+   uint8_t uBuffer[2048];
+   memcpy(uBuffer, szPlainText, iLength);
+   chacha20_poly1305_encrypt(uKey, uNonce, uAD, sizeof(uAD), uBuffer, iLength, uTag);
+   iCountTests += 2;
+   if ( ! _check("AEAD cipher text", uBuffer, uCipherStart, 16) )
+      iCountFailed++;
+   if ( ! _check("AEAD tag", uTag, uAeadTag, 16) )
+      iCountFailed++;
+
+   iCountTests++;
+   if ( (1 != chacha20_poly1305_decrypt(uKey, uNonce, uAD, sizeof(uAD), uBuffer, iLength, uTag)) || (0 != memcmp(uBuffer, szPlainText, iLength)) )
+   {
+      printf("FAILED: AEAD decrypt\n");
+      iCountFailed++;
+   }
+
+   chacha20_poly1305_encrypt(uKey, uNonce, uAD, sizeof(uAD), uBuffer, iLength, uTag);
+   uBuffer[17] ^= 0x01;
+   iCountTests++;
+   if ( 0 != chacha20_poly1305_decrypt(uKey, uNonce, uAD, sizeof(uAD), uBuffer, iLength, uTag) )
+   {
+      printf("FAILED: AEAD accepted a modified packet\n");
+      iCountFailed++;
+   }
+
+   // Two sessions (boots) with the same pass phrase and the same packet counters (nonce)
+   printf("\nTesting AEAD sessions\n");
+   char szPass[32];
+   strcpy(szPass, "test-pass-phrase");
+   upp(szPass);
+   uint8_t uSession1[96], uSession2[96];
+   uint8_t uSalt1[ENC_AEAD_SALT_SIZE], uSalt2[ENC_AEAD_SALT_SIZE];
+   uint8_t uTag1[ENC_AEAD_TAG_SIZE], uTag2[ENC_AEAD_TAG_SIZE];
+   memcpy(uSession1, szPlainText, sizeof(uSession1));
+   memcpy(uSession2, szPlainText, sizeof(uSession2));
+   eppa((u8*)uAD, sizeof(uAD), uSession1, sizeof(uSession1), (u8*)uNonce, uSalt1, uTag1);
+   rpps();
+   eppa((u8*)uAD, sizeof(uAD), uSession2, sizeof(uSession2), (u8*)uNonce, uSalt2, uTag2);
+
+   iCountTests += 2;
+   if ( 0 == memcmp(uSalt1, uSalt2, ENC_AEAD_SALT_SIZE) )
+   {
+      printf("FAILED: AEAD sessions have the same salt\n");
+      iCountFailed++;
+   }
+   if ( (0 == memcmp(uSession1, uSession2, sizeof(uSession1))) || (0 == memcmp(uTag1, uTag2, ENC_AEAD_TAG_SIZE)) )
+   {
+      printf("FAILED: AEAD sessions with the same counters produced the same cipher text\n");
+      iCountFailed++;
+   }
+
+   // The receiver decrypts both sessions from the salt sent with each packet
+   iCountTests += 2;
+   if ( (1 != dppa((u8*)uAD, sizeof(uAD), uSession1, sizeof(uSession1), (u8*)uNonce, uSalt1, uTag1)) || (0 != memcmp(uSession1, szPlainText, sizeof(uSession1))) )
+   {
+      printf("FAILED: AEAD decrypt of the first session\n");
+      iCountFailed++;
+   }
+   if ( (1 != dppa((u8*)uAD, sizeof(uAD), uSession2, sizeof(uSession2), (u8*)uNonce, uSalt2, uTag2)) || (0 != memcmp(uSession2, szPlainText, sizeof(uSession2))) )
+   {
+      printf("FAILED: AEAD decrypt of the second session\n");
+      iCountFailed++;
+   }
+
+   // A tag from one session is not valid with the other session's salt
+   eppa((u8*)uAD, sizeof(uAD), uSession2, sizeof(uSession2), (u8*)uNonce, uSalt2, uTag2);
+   iCountTests++;
+   if ( 0 != dppa((u8*)uAD, sizeof(uAD), uSession2, sizeof(uSession2), (u8*)uNonce, uSalt1, uTag2) )
+   {
+      printf("FAILED: AEAD accepted a packet with a different session salt\n");
+      iCountFailed++;
+   }
+
+   printf("\nAEAD speed:\n");
+   int iSizes[] = { 64, 256, 1400 };
+   for( unsigned int s=0; s<sizeof(iSizes)/sizeof(iSizes[0]); s++ )
+   {
+      int iLoops = 20000000 / iSizes[s];
+      long long tStart = _get_time_us();
+      for( int i=0; i<iLoops; i++ )
+         chacha20_poly1305_encrypt(uKey, uNonce, uAD, sizeof(uAD), uBuffer, iSizes[s], uTag);
+      long long tEnd = _get_time_us();
+      if ( tEnd <= tStart )
+         tEnd = tStart + 1;
+      printf("  %4d bytes packets: %.3f us/packet, %.1f MB/s\n", iSizes[s], (double)(tEnd-tStart)/iLoops, (double)iLoops*iSizes[s]/(double)(tEnd-tStart));
+   }
+
+   printf("\n%d tests, %d failed: %s\n", iCountTests, iCountFailed, (0 == iCountFailed)?"PASS":"FAIL");
+   return (0 == iCountFailed)?0:1;
+}
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../base/base.h"
+
+// Checks that all the CRC32 implementations available on this CPU give the same result
+// as the original byte table implementation and prints the speed of each one.
+
+#define MAX_BUFFER_SIZE 4096
+
+static u8 s_Buffer[MAX_BUFFER_SIZE + 64];
+
+static long long _get_time_us()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (long long)t.tv_sec * 1000000LL + t.tv_nsec/1000;
+}
+
+static const char* _get_name(int iType)
+{
+   base_set_crc32_acceleration(iType);
+   return base_get_crc32_acceleration_name();
+}
+
+int main(int argc, char *argv[])
+{
+   printf("\nTesting CRC32 implementations\n");
+   printf("Auto detected CRC32 implementation: %s\n", base_get_crc32_acceleration_name());
+   int iAutoType = base_get_crc32_acceleration();
+
+   srand(12345);
+   for( int i=0; i<MAX_BUFFER_SIZE+64; i++ )
+      s_Buffer[i] = rand() & 0xFF;
+
+   int iCountTests = 0;
+   int iCountFailed = 0;
+
+   // Known value for the "123456789" check string
+   base_set_crc32_acceleration(CRC32_ACCELERATION_NONE);
+   iCountTests++;
+   if ( base_compute_crc32((u8*)"123456789", 9) != 0xCBF43926 )
+   {
+      printf("FAILED check value\n");
+      iCountFailed++;
+   }
+
+   int iTypes[] = { CRC32_ACCELERATION_SLICE8, CRC32_ACCELERATION_ARMV8, CRC32_ACCELERATION_PCLMUL };
+   for( unsigned int t=0; t<sizeof(iTypes)/sizeof(iTypes[0]); t++ )
+   {
+      if ( base_set_crc32_acceleration(iTypes[t]) < 0 )
+         continue;
+      printf("Checking %s...\n", base_get_crc32_acceleration_name());
+      for( int iLength=0; iLength<=1600; iLength++ )
+      for( int iOffset=0; iOffset<16; iOffset += 3 )
+      {
+         base_set_crc32_acceleration(CRC32_ACCELERATION_NONE);
+         u32 uRef = base_compute_crc32(&s_Buffer[iOffset], iLength);
+         base_set_crc32_acceleration(iTypes[t]);
+         u32 uTest = base_compute_crc32(&s_Buffer[iOffset], iLength);
+         iCountTests++;
+         if ( uRef != uTest )
+         {
+            if ( iCountFailed < 10 )
+               printf("FAILED: %s, length %d, offset %d: %08X != %08X\n", base_get_crc32_acceleration_name(), iLength, iOffset, uTest, uRef);
+            iCountFailed++;
+         }
+      }
+   }
+
+   int iSizes[] = { 64, 256, 1400, 4096 };
+   int iAllTypes[] = { CRC32_ACCELERATION_NONE, CRC32_ACCELERATION_SLICE8, CRC32_ACCELERATION_ARMV8, CRC32_ACCELERATION_PCLMUL };
+   for( unsigned int s=0; s<sizeof(iSizes)/sizeof(iSizes[0]); s++ )
+   {
+      printf("\nSpeed for %d bytes buffers:\n", iSizes[s]);
+      for( unsigned int t=0; t<sizeof(iAllTypes)/sizeof(iAllTypes[0]); t++ )
+      {
+         if ( base_set_crc32_acceleration(iAllTypes[t]) < 0 )
+            continue;
+         int iLoops = 20000000 / iSizes[s];
+         u32 uSum = 0;
+         long long tStart = _get_time_us();
+         for( int i=0; i<iLoops; i++ )
+            uSum += base_compute_crc32(s_Buffer, iSizes[s]);
+         long long tEnd = _get_time_us();
+         if ( tEnd <= tStart )
+            tEnd = tStart + 1;
+         printf("  %-8s %.3f us/buffer, %.1f MB/s (%08X)\n", _get_name(iAllTypes[t]), (double)(tEnd-tStart)/iLoops, (double)iLoops*iSizes[s]/(double)(tEnd-tStart), uSum);
+      }
+   }
+
+   base_set_crc32_acceleration(iAutoType);
+   printf("\n%d tests, %d failed: %s\n", iCountTests, iCountFailed, (0 == iCountFailed)?"PASS":"FAIL");
+   return (0 == iCountFailed)?0:1;
+}
@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware.h"
+#include "../radio/radiopackets2.h"
+#include "../radio/radio_duplicate_det.h"
+
+// Checks the sliding window duplicate detection against the previous hash slots implementation
+// and compares their speed on a simulated 3 radio cards x 5000 packets/sec video link.
+
+#define TEST_CARDS 3
+#define TEST_PACKETS_PER_SEC 5000
+#define TEST_SECONDS 10
+#define TEST_MAX_REORDER 8
+#define TEST_VEHICLE_ID 0x10203040
+#define TEST_START_TIME 100000
+
+extern u32 s_uRadioRxTimeNow;
+
+typedef struct
+{
+   u32 uTime;
+   int iCard;
+   u32 uStreamPacketIdx;
+   u8 uPacketType;
+} t_test_rx_event;
+
+static t_test_rx_event* s_pEvents = NULL;
+static int s_iCountEvents = 0;
+static int s_iCountUniquePackets = 0;
+
+//-----------------------------------------------------------
+// Previous implementation: linear VID search and 512 hash slots per stream
+
+#define LEGACY_HASH_SIZE 512
+#define LEGACY_HASH_MASK 0x01FF
+
+typedef struct
+{
+   u32 uVehicleId;
+   u32 uMaxReceivedPacketIndex[MAX_RADIO_STREAMS];
+   u32 uLastTimeReceivedPacket[MAX_RADIO_STREAMS];
+   u32 packetsHashIndexes[MAX_RADIO_STREAMS][LEGACY_HASH_SIZE];
+} t_legacy_vehicle_history;
+
+static t_legacy_vehicle_history s_LegacyHistory[MAX_CONCURENT_VEHICLES];
+
+static void _legacy_reset(int iIndex)
+{
+   s_LegacyHistory[iIndex].uVehicleId = 0;
+   memset(s_LegacyHistory[iIndex].uMaxReceivedPacketIndex, 0, sizeof(s_LegacyHistory[iIndex].uMaxReceivedPacketIndex));
+   memset(s_LegacyHistory[iIndex].uLastTimeReceivedPacket, 0, sizeof(s_LegacyHistory[iIndex].uLastTimeReceivedPacket));
+   memset(s_LegacyHistory[iIndex].packetsHashIndexes, 0xFF, sizeof(s_LegacyHistory[iIndex].packetsHashIndexes));
+}
+
+static int __attribute__((noinline)) _legacy_is_duplicate(int iRadioInterfaceIndex, u8* pPacketBuffer, u32 uTimeNow)
+{
+   t_packet_header* pPH = (t_packet_header*)pPacketBuffer;
+   u32 uStreamPacketIndex = (pPH->stream_packet_idx) & PACKET_FLAGS_MASK_STREAM_PACKET_IDX;
+   u32 uStreamIndex = (pPH->stream_packet_idx)>>PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX;
+
+   int iIndex = -1;
+   for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
+      if ( pPH->vehicle_id_src == s_LegacyHistory[i].uVehicleId )
+      {
+         iIndex = i;
+         break;
+      }
+   if ( -1 == iIndex )
+   {
+      for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
+         if ( 0 == s_LegacyHistory[i].uVehicleId )
+         {
+            iIndex = i;
+            break;
+         }
+      if ( -1 == iIndex )
+         return 1;
+      _legacy_reset(iIndex);
+      s_LegacyHistory[iIndex].uVehicleId = pPH->vehicle_id_src;
+   }
+   t_legacy_vehicle_history* pInfo = &s_LegacyHistory[iIndex];
+
+   static u32 s_uTimeLastLogAlarm = 0;
+   u32 uMaxDeltaForVideoStream = 2000;
+   // No serial radios in the test (the new detector is not told about any either)
+   u32 uMaxDeltaForDataStream = 50;
+   u32 uMaxDelta = (uStreamIndex < STREAM_ID_VIDEO_1)?uMaxDeltaForDataStream:uMaxDeltaForVideoStream;
+
+   if ( uStreamIndex < STREAM_ID_VIDEO_1 )
+   if ( (pInfo->uMaxReceivedPacketIndex[uStreamIndex] > uMaxDeltaForDataStream) && (uStreamPacketIndex < pInfo->uMaxReceivedPacketIndex[uStreamIndex] - uMaxDeltaForDataStream) )
+   if ( pInfo->uLastTimeReceivedPacket[uStreamIndex] > uTimeNow - 4000 )
+   if ( uTimeNow > s_uTimeLastLogAlarm + 1000 )
+   {
+      s_uTimeLastLogAlarm = uTimeNow;
+      log_line("Received old packet");
+   }
+
+   if ( (pInfo->uMaxReceivedPacketIndex[uStreamIndex] > uStreamPacketIndex + uMaxDelta) ||
+        ((0 != pInfo->uLastTimeReceivedPacket[uStreamIndex]) && (pInfo->uLastTimeReceivedPacket[uStreamIndex] < uTimeNow - 8000) && (uStreamPacketIndex+10 < pInfo->uMaxReceivedPacketIndex[uStreamIndex])) )
+   {
+      u32 uVehicleId = pInfo->uVehicleId;
+      _legacy_reset(iIndex);
+      pInfo->uVehicleId = uVehicleId;
+   }
+
+   int iHashIndex = uStreamPacketIndex & LEGACY_HASH_MASK;
+   if ( uStreamPacketIndex == pInfo->packetsHashIndexes[uStreamIndex][iHashIndex] )
+   if ( (pPH->packet_type != PACKET_TYPE_RUBY_PING_CLOCK) && (pPH->packet_type != PACKET_TYPE_RUBY_PING_CLOCK_REPLY) )
+      return 1;
+
+   pInfo->packetsHashIndexes[uStreamIndex][iHashIndex] = uStreamPacketIndex;
+   if ( uStreamPacketIndex > pInfo->uMaxReceivedPacketIndex[uStreamIndex] )
+      pInfo->uMaxReceivedPacketIndex[uStreamIndex] = uStreamPacketIndex;
+   pInfo->uLastTimeReceivedPacket[uStreamIndex] = uTimeNow;
+   return 0;
+}
+
+//-----------------------------------------------------------
+
+static long long _get_time_us()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (long long)t.tv_sec * 1000000LL + t.tv_nsec/1000;
+}
+
+static int _compare_events(const void* p1, const void* p2)
+{
+   const t_test_rx_event* pE1 = (const t_test_rx_event*)p1;
+   const t_test_rx_event* pE2 = (const t_test_rx_event*)p2;
+   if ( pE1->uTime != pE2->uTime )
+      return (pE1->uTime < pE2->uTime)?-1:1;
+   return pE1->iCard - pE2->iCard;
+}
+
+// Each video packet is received on each card with 90% probability, delayed by up to TEST_MAX_REORDER packets.
+// One telemetry packet is sent every 50 video packets on the telemetry stream.
+static void _build_events()
+{
+   int iTotalPackets = TEST_PACKETS_PER_SEC * TEST_SECONDS;
+   s_pEvents = (t_test_rx_event*) malloc(sizeof(t_test_rx_event) * (iTotalPackets * 2) * TEST_CARDS);
+   s_iCountEvents = 0;
+   s_iCountUniquePackets = 0;
+
+   u32 uTelemetryIndex = 0;
+   for( int i=0; i<iTotalPackets; i++ )
+   {
+      for( int iType=0; iType<2; iType++ )
+      {
+         if ( (1 == iType) && (0 != (i % 50)) )
+            continue;
+         int bReceived = 0;
+         for( int iCard=0; iCard<TEST_CARDS; iCard++ )
+         {
+            if ( (rand() % 100) >= 90 )
+               continue;
+            t_test_rx_event* pEvent = &s_pEvents[s_iCountEvents++];
+            pEvent->uTime = (u32)(i + rand() % (TEST_MAX_REORDER+1));
+            pEvent->iCard = iCard;
+            if ( 0 == iType )
+            {
+               pEvent->uStreamPacketIdx = (((u32)STREAM_ID_VIDEO_1) << PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX) | (u32)i;
+               pEvent->uPacketType = PACKET_TYPE_VIDEO_DATA;
+            }
+            else
+            {
+               pEvent->uStreamPacketIdx = (((u32)STREAM_ID_TELEMETRY) << PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX) | uTelemetryIndex;
+               pEvent->uPacketType = PACKET_TYPE_FC_TELEMETRY;
+            }
+            bReceived = 1;
+         }
+         if ( 1 == iType )
+            uTelemetryIndex++;
+         if ( bReceived )
+            s_iCountUniquePackets++;
+      }
+   }
+   qsort(s_pEvents, s_iCountEvents, sizeof(t_test_rx_event), _compare_events);
+}
+
+static void _fill_packet(t_test_rx_event* pEvent, u8* pPacket)
+{
+   t_packet_header* pPH = (t_packet_header*)pPacket;
+   pPH->vehicle_id_src = TEST_VEHICLE_ID;
+   pPH->vehicle_id_dest = 0;
+   pPH->stream_packet_idx = pEvent->uStreamPacketIdx;
+   pPH->packet_type = pEvent->uPacketType;
+   pPH->total_length = sizeof(t_packet_header);
+}
+
+// Registers a few other vehicles first, so the tested one is not the first entry in the lists
+static void _add_other_vehicles()
+{
+   u8 packet[MAX_PACKET_TOTAL_SIZE];
+   memset(packet, 0, sizeof(packet));
+   t_packet_header* pPH = (t_packet_header*)packet;
+   pPH->total_length = sizeof(t_packet_header);
+   pPH->packet_type = PACKET_TYPE_FC_TELEMETRY;
+   for( u32 uVID=1; uVID<MAX_CONCURENT_VEHICLES-1; uVID++ )
+   {
+      pPH->vehicle_id_src = uVID * 1000;
+      radio_dup_detection_is_duplicate_on_stream(0, packet, sizeof(t_packet_header), TEST_START_TIME);
+      _legacy_is_duplicate(0, packet, TEST_START_TIME);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   log_init_local_only("TestDupDetection");
+   log_disable_stdout();
+   printf("\nTesting radio duplicate packets detection (%d cards x %d packets/sec, %d seconds)\n", TEST_CARDS, TEST_PACKETS_PER_SEC, TEST_SECONDS);
+
+   srand(12345);
+   _build_events();
+
+   int iCountFailed = 0;
+   u8 packet[MAX_PACKET_TOTAL_SIZE];
+   memset(packet, 0, sizeof(packet));
+
+   radio_duplicate_detection_init();
+   for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
+      _legacy_reset(i);
+   _add_other_vehicles();
+
+   int iAcceptedNew = 0;
+   int iAcceptedLegacy = 0;
+   for( int i=0; i<s_iCountEvents; i++ )
+   {
+      _fill_packet(&s_pEvents[i], packet);
+      u32 uTime = TEST_START_TIME + s_pEvents[i].uTime / (TEST_PACKETS_PER_SEC/1000);
+      s_uRadioRxTimeNow = uTime;
+      int iDupNew = radio_dup_detection_is_duplicate_on_stream(s_pEvents[i].iCard, packet, sizeof(t_packet_header), uTime);
+      int iDupLegacy = _legacy_is_duplicate(s_pEvents[i].iCard, packet, uTime);
+      if ( ! iDupNew )
+         iAcceptedNew++;
+      if ( ! iDupLegacy )
+         iAcceptedLegacy++;
+      if ( iDupNew != iDupLegacy )
+      {
+         if ( iCountFailed < 10 )
+            printf("FAILED: event %d, card %d, stream packet 0x%08X: new: %d, legacy: %d\n", i, s_pEvents[i].iCard, s_pEvents[i].uStreamPacketIdx, iDupNew, iDupLegacy);
+         iCountFailed++;
+      }
+   }
+   printf("%d radio packets received, %d unique packets, accepted: %d (new), %d (legacy)\n", s_iCountEvents, s_iCountUniquePackets, iAcceptedNew, iAcceptedLegacy);
+   if ( iAcceptedNew != s_iCountUniquePackets )
+   {
+      printf("FAILED: accepted packets count does not match unique packets count\n");
+      iCountFailed++;
+   }
+
+   // Late packets past the legacy hash size must still be detected as duplicates
+   radio_duplicate_detection_init();
+   int iLateMissed = 0;
+   for( u32 u=0; u<1500; u++ )
+   {
+      t_test_rx_event event;
+      event.iCard = 0;
+      event.uPacketType = PACKET_TYPE_VIDEO_DATA;
+      event.uStreamPacketIdx = (((u32)STREAM_ID_VIDEO_1) << PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX) | u;
+      _fill_packet(&event, packet);
+      radio_dup_detection_is_duplicate_on_stream(0, packet, sizeof(t_packet_header), TEST_START_TIME);
+   }
+   for( u32 u=0; u<1500; u++ )
+   {
+      t_test_rx_event event;
+      event.iCard = 1;
+      event.uPacketType = PACKET_TYPE_VIDEO_DATA;
+      event.uStreamPacketIdx = (((u32)STREAM_ID_VIDEO_1) << PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX) | u;
+      _fill_packet(&event, packet);
+      if ( ! radio_dup_detection_is_duplicate_on_stream(1, packet, sizeof(t_packet_header), TEST_START_TIME) )
+         iLateMissed++;
+   }
+   if ( 0 != iLateMissed )
+   {
+      printf("FAILED: %d late duplicate packets not detected\n", iLateMissed);
+      iCountFailed++;
+   }
+
+   // Speed
+
+   int iRuns = 20;
+   long long tStart = _get_time_us();
+   for( int r=0; r<iRuns; r++ )
+   {
+      for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
+         _legacy_reset(i);
+      _add_other_vehicles();
+      for( int i=0; i<s_iCountEvents; i++ )
+      {
+         _fill_packet(&s_pEvents[i], packet);
+         _legacy_is_duplicate(s_pEvents[i].iCard, packet, TEST_START_TIME + s_pEvents[i].uTime / (TEST_PACKETS_PER_SEC/1000));
+      }
+   }
+   long long tLegacy = _get_time_us() - tStart;
+
+   tStart = _get_time_us();
+   for( int r=0; r<iRuns; r++ )
+   {
+      radio_duplicate_detection_init();
+      _add_other_vehicles();
+      for( int i=0; i<s_iCountEvents; i++ )
+      {
+         _fill_packet(&s_pEvents[i], packet);
+         u32 uTime = TEST_START_TIME + s_pEvents[i].uTime / (TEST_PACKETS_PER_SEC/1000);
+         s_uRadioRxTimeNow = uTime;
+         radio_dup_detection_is_duplicate_on_stream(s_pEvents[i].iCard, packet, sizeof(t_packet_header), uTime);
+      }
+   }
+   long long tNew = _get_time_us() - tStart;
+
+   double dLegacyNs = (double)tLegacy * 1000.0 / ((double)iRuns * s_iCountEvents);
+   double dNewNs = (double)tNew * 1000.0 / ((double)iRuns * s_iCountEvents);
+   printf("\nSpeed (%d runs of %d radio packets):\n", iRuns, s_iCountEvents);
+   printf("  legacy:         %.1f ns/packet\n", dLegacyNs);
+   printf("  sliding window: %.1f ns/packet\n", dNewNs);
+   printf("  RX thread load at %d pkt/s: %.3f%% (legacy), %.3f%% (sliding window)\n", TEST_CARDS*TEST_PACKETS_PER_SEC,
+      dLegacyNs * TEST_CARDS * TEST_PACKETS_PER_SEC / 1e7, dNewNs * TEST_CARDS * TEST_PACKETS_PER_SEC / 1e7);
+
+   free(s_pEvents);
+   printf("\n%d failed: %s\n", iCountFailed, (0 == iCountFailed)?"PASS":"FAIL");
+   return (0 == iCountFailed)?0:1;
+}
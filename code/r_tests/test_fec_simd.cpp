@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../radio/fec.h"
+
+// Checks that the SIMD FEC kernels are bit exact with the scalar table implementation
+// and prints the encode speed of each available kernel.
+
+#define MAX_PACKETS 64
+#define MAX_PACKET_SIZE 1300
+
+typedef unsigned char u8;
+
+u8 s_DataPackets[MAX_PACKETS][MAX_PACKET_SIZE+32];
+u8 s_ECPacketsRef[MAX_PACKETS][MAX_PACKET_SIZE+32];
+u8 s_ECPacketsTest[MAX_PACKETS][MAX_PACKET_SIZE+32];
+u8 s_DecodedRef[MAX_PACKETS][MAX_PACKET_SIZE+32];
+u8 s_DecodedTest[MAX_PACKETS][MAX_PACKET_SIZE+32];
+
+static const int s_iAccelerations[] = { FEC_ACCELERATION_SSSE3, FEC_ACCELERATION_AVX2, FEC_ACCELERATION_NEON };
+
+static long long _get_time_us()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (long long)t.tv_sec * 1000000LL + t.tv_nsec/1000;
+}
+
+static void _encode(int iAcceleration, int iOffset, int iSize, int iDataPackets, int iECPackets, u8 pOut[][MAX_PACKET_SIZE+32])
+{
+   u8* pData[MAX_PACKETS];
+   u8* pEC[MAX_PACKETS];
+   for( int i=0; i<iDataPackets; i++ )
+      pData[i] = &s_DataPackets[i][iOffset];
+   for( int i=0; i<iECPackets; i++ )
+   {
+      pEC[i] = &pOut[i][iOffset];
+      memset(pOut[i], 0x5A, MAX_PACKET_SIZE+32);
+   }
+   fec_set_acceleration(iAcceleration);
+   fec_encode(iSize, pData, iDataPackets, pEC, iECPackets);
+}
+
+// Erases the given data packets and recovers them using the last EC packets
+static int _decode(int iAcceleration, int iOffset, int iSize, int iDataPackets, int iECPackets, int iMissing, u8 pEC[][MAX_PACKET_SIZE+32], u8 pOut[][MAX_PACKET_SIZE+32], unsigned int* pMissingIndexes)
+{
+   u8* pData[MAX_PACKETS];
+   u8* pECUsed[MAX_PACKETS];
+   u8 ecCopy[MAX_PACKETS][MAX_PACKET_SIZE+32];
+   unsigned int uECIndexes[MAX_PACKETS];
+
+   for( int i=0; i<iDataPackets; i++ )
+   {
+      memcpy(pOut[i], s_DataPackets[i], MAX_PACKET_SIZE+32);
+      pData[i] = &pOut[i][iOffset];
+   }
+   for( int i=0; i<iMissing; i++ )
+   {
+      memset(pOut[pMissingIndexes[i]], 0, MAX_PACKET_SIZE+32);
+      int iECIndex = iECPackets - iMissing + i;
+      memcpy(ecCopy[i], pEC[iECIndex], MAX_PACKET_SIZE+32);
+      pECUsed[i] = &ecCopy[i][iOffset];
+      uECIndexes[i] = iECIndex;
+   }
+   fec_set_acceleration(iAcceleration);
+   return fec_decode(iSize, pData, iDataPackets, pECUsed, uECIndexes, pMissingIndexes, iMissing);
+}
+
+int main(int argc, char *argv[])
+{
+   printf("\nTesting FEC SIMD kernels against the scalar implementation\n");
+   fec_init();
+   printf("Auto detected FEC kernel: %s\n", fec_get_acceleration_name());
+
+   srand(12345);
+   for( int i=0; i<MAX_PACKETS; i++ )
+   for( int k=0; k<MAX_PACKET_SIZE+32; k++ )
+      s_DataPackets[i][k] = rand() & 0xFF;
+
+   int iCountTests = 0;
+   int iCountFailed = 0;
+
+   for( unsigned int a=0; a<sizeof(s_iAccelerations)/sizeof(s_iAccelerations[0]); a++ )
+   {
+      if ( fec_set_acceleration(s_iAccelerations[a]) < 0 )
+         continue;
+      printf("Checking kernel %s...\n", fec_get_acceleration_name());
+
+      for( int iTest=0; iTest<2000; iTest++ )
+      {
+         int iDataPackets = 1 + rand() % 32;
+         int iECPackets = 1 + rand() % 16;
+         int iOffset = rand() % 17;
+         int iSize = 1 + rand() % MAX_PACKET_SIZE;
+         if ( iTest < 64 )
+            iSize = 1 + iTest;
+
+         _encode(FEC_ACCELERATION_NONE, iOffset, iSize, iDataPackets, iECPackets, s_ECPacketsRef);
+         _encode(s_iAccelerations[a], iOffset, iSize, iDataPackets, iECPackets, s_ECPacketsTest);
+         iCountTests++;
+         if ( 0 != memcmp(s_ECPacketsRef, s_ECPacketsTest, iECPackets*sizeof(s_ECPacketsRef[0])) )
+         {
+            printf("FAILED encode: k=%d, n=%d, size=%d, offset=%d\n", iDataPackets, iECPackets, iSize, iOffset);
+            iCountFailed++;
+            continue;
+         }
+
+         int iMissing = 1 + rand() % iECPackets;
+         if ( iMissing > iDataPackets )
+            iMissing = iDataPackets;
+         unsigned int uMissingIndexes[MAX_PACKETS];
+         int iStart = rand() % (iDataPackets - iMissing + 1);
+         for( int i=0; i<iMissing; i++ )
+            uMissingIndexes[i] = iStart + i;
+
+         int iResRef = _decode(FEC_ACCELERATION_NONE, iOffset, iSize, iDataPackets, iECPackets, iMissing, s_ECPacketsRef, s_DecodedRef, uMissingIndexes);
+         int iResTest = _decode(s_iAccelerations[a], iOffset, iSize, iDataPackets, iECPackets, iMissing, s_ECPacketsRef, s_DecodedTest, uMissingIndexes);
+         iCountTests++;
+         if ( (iResRef != iResTest) || (0 != memcmp(s_DecodedRef, s_DecodedTest, iDataPackets*sizeof(s_DecodedRef[0]))) )
+         {
+            printf("FAILED decode: k=%d, n=%d, missing=%d, size=%d, offset=%d\n", iDataPackets, iECPackets, iMissing, iSize, iOffset);
+            iCountFailed++;
+            continue;
+         }
+         for( int i=0; i<iMissing; i++ )
+         {
+            if ( 0 != memcmp(&s_DecodedTest[uMissingIndexes[i]][iOffset], &s_DataPackets[uMissingIndexes[i]][iOffset], iSize) )
+            {
+               printf("FAILED recovery: k=%d, n=%d, missing=%d, size=%d, offset=%d\n", iDataPackets, iECPackets, iMissing, iSize, iOffset);
+               iCountFailed++;
+               break;
+            }
+         }
+      }
+   }
+
+   // Incremental encoding, data packets folded one by one in two parts (as done by the video tx buffers),
+   // possibly into more EC packets than needed (block shortened after it was started)
+   printf("Checking incremental encoding...\n");
+   fec_set_acceleration(FEC_ACCELERATION_AUTO);
+   for( int iTest=0; iTest<2000; iTest++ )
+   {
+      int iDataPackets = 1 + rand() % 32;
+      int iECPackets = 1 + rand() % 16;
+      int iECRows = iECPackets + rand() % 4;
+      int iSize = 2 + rand() % MAX_PACKET_SIZE;
+      int iSplit = 1 + rand() % (iSize-1);
+      u8* pEC[MAX_PACKETS];
+      u8* pECTail[MAX_PACKETS];
+
+      _encode(FEC_ACCELERATION_AUTO, 0, iSize, iDataPackets, iECPackets, s_ECPacketsRef);
+      for( int i=0; i<iECRows; i++ )
+      {
+         memset(s_ECPacketsTest[i], 0x5A, MAX_PACKET_SIZE+32);
+         pEC[i] = s_ECPacketsTest[i];
+         pECTail[i] = &s_ECPacketsTest[i][iSplit];
+      }
+      for( int i=0; i<iDataPackets; i++ )
+         fec_encode_add_data_block(iSize - iSplit, &s_DataPackets[i][iSplit], i, pECTail, iECRows);
+      for( int i=0; i<iDataPackets; i++ )
+         fec_encode_add_data_block(iSplit, s_DataPackets[i], i, pEC, iECPackets);
+
+      iCountTests++;
+      if ( 0 != memcmp(s_ECPacketsRef, s_ECPacketsTest, iECPackets*sizeof(s_ECPacketsRef[0])) )
+      {
+         printf("FAILED incremental encode: k=%d, n=%d, rows=%d, size=%d\n", iDataPackets, iECPackets, iECRows, iSize);
+         iCountFailed++;
+      }
+   }
+
+   printf("\nEncode speed (12/6 scheme, 1250 bytes packets):\n");
+   int iAllAccelerations[] = { FEC_ACCELERATION_NONE, FEC_ACCELERATION_SSSE3, FEC_ACCELERATION_AVX2, FEC_ACCELERATION_NEON };
+   for( unsigned int a=0; a<sizeof(iAllAccelerations)/sizeof(iAllAccelerations[0]); a++ )
+   {
+      if ( fec_set_acceleration(iAllAccelerations[a]) < 0 )
+         continue;
+      const char* szName = fec_get_acceleration_name();
+      int iBlocks = 5000;
+      long long tStart = _get_time_us();
+      for( int i=0; i<iBlocks; i++ )
+         _encode(iAllAccelerations[a], 0, 1250, 12, 6, s_ECPacketsTest);
+      long long tEnd = _get_time_us();
+      if ( tEnd <= tStart )
+         tEnd = tStart + 1;
+      printf("  %-8s %.2f us/block, %.1f MB/s of video data\n", szName, (double)(tEnd-tStart)/iBlocks, (double)iBlocks*12*1250/(double)(tEnd-tStart));
+   }
+
+   fec_set_acceleration(FEC_ACCELERATION_AUTO);
+   printf("\n%d tests, %d failed: %s\n", iCountTests, iCountFailed, (0 == iCountFailed)?"PASS":"FAIL");
+   return (0 == iCountFailed)?0:1;
+}
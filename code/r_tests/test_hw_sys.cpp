@@ -0,0 +1,154 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Checks the native process and procfs/sysfs helpers (base/hw_sys.h) against the running system:
+// process lookup by name, priorities, file reads, child spawning and reaping, fork accounting.
+
+#include <sys/resource.h>
+#include <signal.h>
+#include "../base/base.h"
+#include "../base/hw_sys.h"
+
+static int s_iFailed = 0;
+
+static void _check(int iCondition, const char* szName)
+{
+   printf("%s: %s\n", iCondition?"ok  ":"FAIL", szName);
+   if ( ! iCondition )
+      s_iFailed++;
+}
+
+static int _wait_for_process_count(const char* szName, int iExpected, int iTimeoutMs)
+{
+   int iPIDs[HW_SYS_MAX_PIDS];
+   int iCount = -1;
+   for( int i=0; i<iTimeoutMs/10; i++ )
+   {
+      iCount = hw_sys_find_pids(szName, iPIDs, HW_SYS_MAX_PIDS);
+      if ( iCount == iExpected )
+         break;
+      hardware_sleep_ms(10);
+   }
+   return iCount;
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestHwSys");
+   log_disable();
+
+   // Own process, by argv[0] base name and by a partial name
+   int iPIDs[HW_SYS_MAX_PIDS];
+   int iCount = hw_sys_find_pids("test_hw_sys", iPIDs, HW_SYS_MAX_PIDS);
+   int bFoundSelf = 0;
+   for( int i=0; i<iCount; i++ )
+      if ( iPIDs[i] == getpid() )
+         bFoundSelf = 1;
+   _check(bFoundSelf, "find own process by name");
+   iCount = hw_sys_find_pids("hw_sy", iPIDs, HW_SYS_MAX_PIDS);
+   bFoundSelf = 0;
+   for( int i=0; i<iCount; i++ )
+      if ( iPIDs[i] == getpid() )
+         bFoundSelf = 1;
+   _check(bFoundSelf, "find own process by partial name");
+   _check(0 == hw_sys_find_pids("no_such_process_name_xyz", iPIDs, HW_SYS_MAX_PIDS), "no match for unknown process");
+
+   int iTIDs[16];
+   _check(hw_sys_get_process_threads(getpid(), iTIDs, 16) >= 1, "list own threads");
+
+   // Priorities
+   setpriority(PRIO_PROCESS, 0, 3);
+   int iPriority = 0, iNice = 0;
+   _check(hw_sys_get_process_priority(getpid(), &iPriority, &iNice) && (iNice == 3) && (iPriority == 23), "read own priority and nice");
+   _check(hw_sys_set_process_nice(getpid(), 5) && (getpriority(PRIO_PROCESS, 0) == 5), "set own nice");
+
+   // procfs reads
+   char szBuff[256];
+   _check(hw_sys_read_file("/proc/sys/kernel/ostype", szBuff, sizeof(szBuff)) > 0 && (0 == strcmp(szBuff, "Linux")), "read file, new line removed");
+   int iValue = 0;
+   _check(hw_sys_read_int("/proc/sys/kernel/pid_max", &iValue) && (iValue > 100), "read int");
+   _check(hw_sys_read_file("/proc/no_such_file", szBuff, sizeof(szBuff)) < 0, "read missing file fails");
+   _check(hw_sys_grep_file("/proc/self/status", "Name:", szBuff, sizeof(szBuff)) && (NULL != strstr(szBuff, "test_hw_sys")), "grep file");
+   _check(hw_sys_read_key_value("/proc/self/status", "State", szBuff, sizeof(szBuff)) && (szBuff[0] == 'R'), "read key value");
+   _check(hw_sys_get_cpu_cores_count() >= 1, "cpu cores count");
+
+   // Nested folders (mkdir -p)
+   char szDir[128];
+   snprintf(szDir, sizeof(szDir), "/tmp/test_hw_sys_%d/a/b/", (int)getpid());
+   _check(hw_sys_make_dirs(szDir, 0777) && (0 == access(szDir, F_OK)), "make nested folders");
+   _check(hw_sys_make_dirs(szDir, 0777), "make existing folders");
+   snprintf(szBuff, sizeof(szBuff), "/tmp/test_hw_sys_%d/file", (int)getpid());
+   FILE* fd = fopen(szBuff, "w");
+   if ( NULL != fd )
+      fclose(fd);
+   char szFile[sizeof(szBuff)+4];
+   snprintf(szFile, sizeof(szFile), "%s/c", szBuff);
+   _check(! hw_sys_make_dirs(szFile, 0777), "make folders under a file fails");
+   unlink(szBuff);
+   rmdir(szDir);
+   snprintf(szDir, sizeof(szDir), "/tmp/test_hw_sys_%d/a", (int)getpid());
+   rmdir(szDir);
+   snprintf(szDir, sizeof(szDir), "/tmp/test_hw_sys_%d", (int)getpid());
+   rmdir(szDir);
+
+   // Spawn, find, signal and reap a child
+   u32 uForksBefore = hw_sys_get_startup_forks_count();
+   _check(0 == hw_sys_spawn_command_line("sleep 30 > /dev/null"), "command line with redirect needs a shell");
+   int iPID = hw_sys_spawn_command_line("sleep 30");
+   _check(iPID > 0, "spawn child");
+   _check(hw_sys_get_startup_forks_count() == uForksBefore + 1, "spawn counted as startup fork");
+   iCount = _wait_for_process_count("sleep", 1, 1000);
+   _check(iCount >= 1, "find spawned child");
+   _check(1 == hw_sys_signal_pids(&iPID, 1, SIGTERM), "signal child");
+   // The reaper thread collects it, so it must not linger as a zombie
+   int bGone = 0;
+   for( int i=0; i<100; i++ )
+   {
+      char szFile[64];
+      sprintf(szFile, "/proc/%d/stat", iPID);
+      if ( access(szFile, R_OK) == -1 )
+      {
+         bGone = 1;
+         break;
+      }
+      hardware_sleep_ms(10);
+   }
+   _check(bGone, "child reaped after exit");
+   _check(hw_sys_spawn_command_line("no_such_binary_xyz") < 0, "spawn of missing binary fails");
+
+   hw_sys_mark_startup_complete();
+   hw_sys_count_fork();
+   _check(hw_sys_is_startup_complete() && (hw_sys_get_steady_forks_count() == 1), "steady state fork counted");
+
+   printf("%s\n", s_iFailed?"FAIL":"PASS");
+   return s_iFailed?1:0;
+}
@@ -0,0 +1,426 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+
+#include "../base/base.h"
+#include "../base/ruby_ipc.h"
+#include "../base/ipc_shm_ring.h"
+
+// Compares the IPC transports between two processes (the same way the router talks to the other Ruby processes):
+// SysV message queues (framing and CRCs as in ruby_ipc), FIFO pipes and the shared memory rings.
+// Checks that all messages arrive intact and in order, then prints throughput and round trip latency.
+// Also checks that a ring writer killed while holding the write lock does not block the other writers.
+
+#define TEST_THROUGHPUT_MESSAGES 100000
+#define TEST_LATENCY_ROUND_TRIPS 20000
+#define TEST_LATENCY_MSG_SIZE 64
+#define TEST_LIVE_WRITER_HOLD_MS 300
+
+typedef struct
+{
+   long type;
+   u8 data[IPC_CHANNEL_MAX_MSG_SIZE];
+} t_test_msgqueue_buffer;
+
+typedef struct
+{
+   const char* szName;
+   int (*pfOpen)(int iChannel);
+   int (*pfSend)(int iChannel, u8* pData, int iLength);
+   // Blocks until a message is received. Returns the message length or -1 on error
+   int (*pfReceive)(int iChannel, u8* pOutput);
+   void (*pfClose)(int iChannel);
+} t_test_transport;
+
+// Channel 0: parent to child, channel 1: child to parent
+static int s_iMsgQueues[2];
+static int s_iFifoFds[2];
+static t_ipc_shm_ring* s_pRings[2];
+static int s_iRingFds[2];
+
+static long long _get_time_us()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (long long)t.tv_sec * 1000000LL + t.tv_nsec/1000;
+}
+
+static int _msgqueue_open(int iChannel)
+{
+   s_iMsgQueues[iChannel] = msgget(IPC_PRIVATE, IPC_CREAT | S_IRUSR | S_IWUSR);
+   return (s_iMsgQueues[iChannel] >= 0)?1:0;
+}
+
+static int _msgqueue_send(int iChannel, u8* pData, int iLength)
+{
+   t_test_msgqueue_buffer msg;
+   msg.type = 1;
+   msg.data[4] = 0;
+   msg.data[5] = ((u32)iLength) & 0xFF;
+   msg.data[6] = (((u32)iLength)>>8) & 0xFF;
+   memcpy(&msg.data[7], pData, iLength);
+   u32 uCRC = base_compute_crc32(&msg.data[4], iLength+3);
+   memcpy(&msg.data[0], &uCRC, sizeof(u32));
+   return (0 == msgsnd(s_iMsgQueues[iChannel], &msg, iLength+7, 0))?1:0;
+}
+
+static int _msgqueue_receive(int iChannel, u8* pOutput)
+{
+   t_test_msgqueue_buffer msg;
+   int iLen = msgrcv(s_iMsgQueues[iChannel], &msg, IPC_CHANNEL_MAX_MSG_SIZE, 0, MSG_NOERROR);
+   if ( iLen <= 6 )
+      return -1;
+   int iMsgLen = msg.data[5] + 256*(int)msg.data[6];
+   u32 uCRC = 0;
+   memcpy(&uCRC, &msg.data[0], sizeof(u32));
+   if ( uCRC != base_compute_crc32(&msg.data[4], iMsgLen+3) )
+      return -1;
+   memcpy(pOutput, &msg.data[7], iMsgLen);
+   return iMsgLen;
+}
+
+static void _msgqueue_close(int iChannel)
+{
+   msgctl(s_iMsgQueues[iChannel], IPC_RMID, NULL);
+}
+
+static int _fifo_open(int iChannel)
+{
+   char szName[64];
+   snprintf(szName, sizeof(szName), "/tmp/test_ipc_transport_fifo%d", iChannel);
+   unlink(szName);
+   if ( 0 != mkfifo(szName, S_IRUSR | S_IWUSR) )
+      return 0;
+   // Opened read-write so neither side blocks on open; both processes inherit it
+   s_iFifoFds[iChannel] = open(szName, O_RDWR);
+   fcntl(s_iFifoFds[iChannel], F_SETPIPE_SZ, 65536);
+   return (s_iFifoFds[iChannel] >= 0)?1:0;
+}
+
+static int _fifo_send(int iChannel, u8* pData, int iLength)
+{
+   u8 uBuffer[IPC_CHANNEL_MAX_MSG_SIZE+2];
+   uBuffer[0] = iLength & 0xFF;
+   uBuffer[1] = (iLength >> 8) & 0xFF;
+   memcpy(&uBuffer[2], pData, iLength);
+   return (write(s_iFifoFds[iChannel], uBuffer, iLength+2) == iLength+2)?1:0;
+}
+
+static int _fifo_read_all(int fd, u8* pBuffer, int iLength)
+{
+   int iPos = 0;
+   while ( iPos < iLength )
+   {
+      int iRead = read(fd, pBuffer + iPos, iLength - iPos);
+      if ( iRead <= 0 )
+         return 0;
+      iPos += iRead;
+   }
+   return 1;
+}
+
+static int _fifo_receive(int iChannel, u8* pOutput)
+{
+   u8 uHeader[2];
+   if ( ! _fifo_read_all(s_iFifoFds[iChannel], uHeader, 2) )
+      return -1;
+   int iLength = uHeader[0] + 256*(int)uHeader[1];
+   if ( ! _fifo_read_all(s_iFifoFds[iChannel], pOutput, iLength) )
+      return -1;
+   return iLength;
+}
+
+static void _fifo_close(int iChannel)
+{
+   char szName[64];
+   snprintf(szName, sizeof(szName), "/tmp/test_ipc_transport_fifo%d", iChannel);
+   close(s_iFifoFds[iChannel]);
+   unlink(szName);
+}
+
+static int _ring_open(int iChannel)
+{
+   char szName[64];
+   snprintf(szName, sizeof(szName), "/test_ipc_transport_ring%d", iChannel);
+   ipc_shm_ring_unlink(szName);
+   s_pRings[iChannel] = ipc_shm_ring_open(szName, &s_iRingFds[iChannel]);
+   return (NULL != s_pRings[iChannel])?1:0;
+}
+
+static int _ring_send(int iChannel, u8* pData, int iLength)
+{
+   // The routers drop on a full ring; here the sender waits so the test measures the transport, not the drops
+   while ( 0 == ipc_shm_ring_write(s_pRings[iChannel], pData, iLength) )
+      sched_yield();
+   return 1;
+}
+
+static int _ring_receive(int iChannel, u8* pOutput)
+{
+   while ( 1 )
+   {
+      int iLength = ipc_shm_ring_read(s_pRings[iChannel], pOutput, IPC_CHANNEL_MAX_MSG_SIZE);
+      if ( 0 != iLength )
+         return iLength;
+      ipc_shm_ring_wait(s_pRings[iChannel], 100000);
+   }
+}
+
+static void _ring_close(int iChannel)
+{
+   char szName[64];
+   snprintf(szName, sizeof(szName), "/test_ipc_transport_ring%d", iChannel);
+   ipc_shm_ring_close(s_pRings[iChannel], s_iRingFds[iChannel]);
+   ipc_shm_ring_unlink(szName);
+}
+
+static t_test_transport s_Transports[] =
+{
+   { "msgqueue", _msgqueue_open, _msgqueue_send, _msgqueue_receive, _msgqueue_close },
+   { "fifo", _fifo_open, _fifo_send, _fifo_receive, _fifo_close },
+   { "shm_ring", _ring_open, _ring_send, _ring_receive, _ring_close }
+};
+
+// Same layout as the Ruby packets: CRC in the first u32 (computed by the sender), then a sequence number
+static void _build_message(u8* pBuffer, int iLength, u32 uSequence)
+{
+   memcpy(pBuffer + sizeof(u32), &uSequence, sizeof(u32));
+   for( int i=8; i<iLength; i++ )
+      pBuffer[i] = (u8)(uSequence + i);
+   u32 uCRC = base_compute_crc32(pBuffer + sizeof(u32), iLength-sizeof(u32));
+   memcpy(pBuffer, &uCRC, sizeof(u32));
+}
+
+static int _check_message(u8* pBuffer, int iLength, int iExpectedLength, u32 uExpectedSequence)
+{
+   if ( iLength != iExpectedLength )
+      return 0;
+   u32 uSequence = 0;
+   memcpy(&uSequence, pBuffer + sizeof(u32), sizeof(u32));
+   if ( uSequence != uExpectedSequence )
+      return 0;
+   return base_check_crc32(pBuffer, iLength);
+}
+
+// Returns the number of failures
+static int _test_throughput(t_test_transport* pTransport, int iMsgSize)
+{
+   if ( ! pTransport->pfOpen(0) )
+   {
+      printf("  %-10s failed to open\n", pTransport->szName);
+      return 1;
+   }
+   pid_t pid = fork();
+   if ( 0 == pid )
+   {
+      u8 uBuffer[IPC_CHANNEL_MAX_MSG_SIZE];
+      int iFailed = 0;
+      for( u32 u=0; u<TEST_THROUGHPUT_MESSAGES; u++ )
+      {
+         int iLength = pTransport->pfReceive(0, uBuffer);
+         if ( ! _check_message(uBuffer, iLength, iMsgSize, u) )
+            iFailed++;
+      }
+      _exit((0 == iFailed)?0:1);
+   }
+
+   u8 uBuffer[IPC_CHANNEL_MAX_MSG_SIZE];
+   long long tStart = _get_time_us();
+   for( u32 u=0; u<TEST_THROUGHPUT_MESSAGES; u++ )
+   {
+      _build_message(uBuffer, iMsgSize, u);
+      pTransport->pfSend(0, uBuffer, iMsgSize);
+   }
+   int iStatus = 0;
+   waitpid(pid, &iStatus, 0);
+   long long tEnd = _get_time_us();
+   pTransport->pfClose(0);
+   if ( tEnd <= tStart )
+      tEnd = tStart + 1;
+
+   int iFailed = (WIFEXITED(iStatus) && (0 == WEXITSTATUS(iStatus)))?0:1;
+   printf("  %-10s %5d bytes: %9.0f msg/s, %7.1f MB/s %s\n", pTransport->szName, iMsgSize,
+      (double)TEST_THROUGHPUT_MESSAGES * 1000000.0 / (double)(tEnd-tStart),
+      (double)TEST_THROUGHPUT_MESSAGES * iMsgSize / (double)(tEnd-tStart),
+      iFailed?"FAILED (lost or corrupted messages)":"");
+   return iFailed;
+}
+
+static int _compare_int(const void* p1, const void* p2)
+{
+   return (*(const int*)p1) - (*(const int*)p2);
+}
+
+static int _test_latency(t_test_transport* pTransport)
+{
+   if ( (! pTransport->pfOpen(0)) || (! pTransport->pfOpen(1)) )
+   {
+      printf("  %-10s failed to open\n", pTransport->szName);
+      return 1;
+   }
+   pid_t pid = fork();
+   if ( 0 == pid )
+   {
+      u8 uBuffer[IPC_CHANNEL_MAX_MSG_SIZE];
+      for( int i=0; i<TEST_LATENCY_ROUND_TRIPS; i++ )
+      {
+         int iLength = pTransport->pfReceive(0, uBuffer);
+         if ( iLength <= 0 )
+            _exit(1);
+         pTransport->pfSend(1, uBuffer, iLength);
+      }
+      _exit(0);
+   }
+
+   static int s_iRoundTrips[TEST_LATENCY_ROUND_TRIPS];
+   u8 uBuffer[IPC_CHANNEL_MAX_MSG_SIZE];
+   int iFailed = 0;
+   for( int i=0; i<TEST_LATENCY_ROUND_TRIPS; i++ )
+   {
+      _build_message(uBuffer, TEST_LATENCY_MSG_SIZE, (u32)i);
+      long long tStart = _get_time_us();
+      pTransport->pfSend(0, uBuffer, TEST_LATENCY_MSG_SIZE);
+      int iLength = pTransport->pfReceive(1, uBuffer);
+      s_iRoundTrips[i] = (int)(_get_time_us() - tStart);
+      if ( ! _check_message(uBuffer, iLength, TEST_LATENCY_MSG_SIZE, (u32)i) )
+         iFailed++;
+   }
+   int iStatus = 0;
+   waitpid(pid, &iStatus, 0);
+   pTransport->pfClose(0);
+   pTransport->pfClose(1);
+   if ( ! (WIFEXITED(iStatus) && (0 == WEXITSTATUS(iStatus))) )
+      iFailed++;
+
+   long long lSum = 0;
+   for( int i=0; i<TEST_LATENCY_ROUND_TRIPS; i++ )
+      lSum += s_iRoundTrips[i];
+   qsort(s_iRoundTrips, TEST_LATENCY_ROUND_TRIPS, sizeof(int), _compare_int);
+   printf("  %-10s round trip: avg %.1f us, p50 %d us, p99 %d us, max %d us %s\n", pTransport->szName,
+      (double)lSum/TEST_LATENCY_ROUND_TRIPS, s_iRoundTrips[TEST_LATENCY_ROUND_TRIPS/2],
+      s_iRoundTrips[(TEST_LATENCY_ROUND_TRIPS*99)/100], s_iRoundTrips[TEST_LATENCY_ROUND_TRIPS-1],
+      (iFailed > 0)?"FAILED":"");
+   return (iFailed > 0)?1:0;
+}
+
+static int _test_ring_dead_writer()
+{
+   if ( ! _ring_open(0) )
+   {
+      printf("  Ring dead writer: FAILED to open the ring\n");
+      return 1;
+   }
+   // The child takes the write lock and is killed before releasing it
+   pid_t pid = fork();
+   if ( 0 == pid )
+   {
+      __atomic_store_n(&s_pRings[0]->uWriteLock, (u32)getpid(), __ATOMIC_RELEASE);
+      kill(getpid(), SIGKILL);
+      _exit(0);
+   }
+   int iStatus = 0;
+   waitpid(pid, &iStatus, 0);
+
+   int iFailed = 0;
+   u8 uMessage[64];
+   u8 uReceived[IPC_CHANNEL_MAX_MSG_SIZE];
+   _build_message(uMessage, sizeof(uMessage), 1);
+   long long tStart = _get_time_us();
+   if ( sizeof(uMessage) != ipc_shm_ring_write(s_pRings[0], uMessage, sizeof(uMessage)) )
+      iFailed++;
+   long long tWait = _get_time_us() - tStart;
+   if ( tWait >= 10 * IPC_SHM_RING_LOCK_CHECK_OWNER_MS * 1000 )
+      iFailed++;
+   int iLength = ipc_shm_ring_read(s_pRings[0], uReceived, sizeof(uReceived));
+   if ( ! _check_message(uReceived, iLength, sizeof(uMessage), 1) )
+      iFailed++;
+   if ( 0 != __atomic_load_n(&s_pRings[0]->uWriteLock, __ATOMIC_ACQUIRE) )
+      iFailed++;
+   _ring_close(0);
+   printf("  Ring write lock taken over from a dead writer in %.1f ms %s\n", (double)tWait/1000.0, (iFailed > 0)?"FAILED":"");
+   return (iFailed > 0)?1:0;
+}
+
+static int _test_ring_live_writer()
+{
+   if ( ! _ring_open(0) )
+   {
+      printf("  Ring live writer: FAILED to open the ring\n");
+      return 1;
+   }
+   // The child holds the write lock for much longer than the owner check interval, then releases it
+   pid_t pid = fork();
+   if ( 0 == pid )
+   {
+      __atomic_store_n(&s_pRings[0]->uWriteLock, (u32)getpid(), __ATOMIC_RELEASE);
+      hardware_sleep_ms(TEST_LIVE_WRITER_HOLD_MS);
+      __atomic_store_n(&s_pRings[0]->uWriteLock, 0, __ATOMIC_RELEASE);
+      _exit(0);
+   }
+   long long tStart = _get_time_us();
+   while ( (0 == __atomic_load_n(&s_pRings[0]->uWriteLock, __ATOMIC_ACQUIRE)) && (_get_time_us() < tStart + 1000000) )
+      hardware_sleep_micros(100);
+
+   int iFailed = 0;
+   u8 uMessage[64];
+   u8 uReceived[IPC_CHANNEL_MAX_MSG_SIZE];
+   _build_message(uMessage, sizeof(uMessage), 2);
+   if ( sizeof(uMessage) != ipc_shm_ring_write(s_pRings[0], uMessage, sizeof(uMessage)) )
+      iFailed++;
+   long long tWait = _get_time_us() - tStart;
+   // The lock must not be taken from a live owner, so the write completes only after the child released it
+   if ( tWait < (TEST_LIVE_WRITER_HOLD_MS * 1000)/2 )
+      iFailed++;
+   int iStatus = 0;
+   waitpid(pid, &iStatus, 0);
+   int iLength = ipc_shm_ring_read(s_pRings[0], uReceived, sizeof(uReceived));
+   if ( ! _check_message(uReceived, iLength, sizeof(uMessage), 2) )
+      iFailed++;
+   _ring_close(0);
+   printf("  Ring write lock waited for a live writer for %.1f ms %s\n", (double)tWait/1000.0, (iFailed > 0)?"FAILED":"");
+   return (iFailed > 0)?1:0;
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestIPCTransport");
+   log_disable();
+
+   printf("\nTesting IPC transports (%d messages per throughput run, %d round trips)\n", TEST_THROUGHPUT_MESSAGES, TEST_LATENCY_ROUND_TRIPS);
+   int iCountTransports = sizeof(s_Transports)/sizeof(s_Transports[0]);
+   int iCountTests = 0;
+   int iCountFailed = 0;
+
+   int iSizes[] = { 64, 512, 1400 };
+   printf("\nThroughput:\n");
+   for( unsigned int s=0; s<sizeof(iSizes)/sizeof(iSizes[0]); s++ )
+   for( int t=0; t<iCountTransports; t++ )
+   {
+      iCountTests++;
+      iCountFailed += _test_throughput(&s_Transports[t], iSizes[s]);
+   }
+
+   printf("\nLatency (%d bytes messages):\n", TEST_LATENCY_MSG_SIZE);
+   for( int t=0; t<iCountTransports; t++ )
+   {
+      iCountTests++;
+      iCountFailed += _test_latency(&s_Transports[t]);
+   }
+
+   printf("\nRobustness:\n");
+   iCountTests++;
+   iCountFailed += _test_ring_dead_writer();
+   iCountFailed += _test_ring_live_writer();
+
+   printf("\n%d tests, %d failed: %s\n", iCountTests, iCountFailed, (0 == iCountFailed)?"PASS":"FAIL");
+   return (0 == iCountFailed)?0:1;
+}
@@ -0,0 +1,476 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../base/base.h"
+#include "../base/models.h"
+#include "../base/parse_fc_telemetry.h"
+#include "../../mavlink/common/mavlink.h"
+
+// Replays a MAVLink stream through parse_telemetry_from_fc() with the byte by byte parser and
+// with the frame scanner, in serial read sized chunks, checks that both decode the same telemetry
+// and prints the parsing cost of each one.
+// Usage: test_mavlink_parse [file.tlog]
+// With no tlog (8 bytes timestamp + frame records), an ArduPilot like 921600 baud stream is generated.
+
+#define TEST_STREAM_SECONDS 120
+#define TEST_MAX_STREAM_SIZE (16*1024*1024)
+#define TEST_MAX_READ_SIZE 1023
+#define TEST_REPEAT 5
+#define TEST_SYS_ID 1
+
+static u8* s_pStream = NULL;
+static int s_iStreamLength = 0;
+static double s_fStreamSeconds = 0.0;
+static int s_iStreamFrames = 0;
+static u32 s_uRandSeed = 12345;
+
+static u32 _rand()
+{
+   s_uRandSeed = s_uRandSeed * 1103515245 + 12345;
+   return (s_uRandSeed >> 8);
+}
+
+static double _get_time_sec()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (double)t.tv_sec + (double)t.tv_nsec / 1000000000.0;
+}
+
+static int _get_frame_length(const u8* pFrame, int iAvailable)
+{
+   if ( iAvailable < 2 )
+      return -1;
+   if ( pFrame[0] == MAVLINK_STX_MAVLINK1 )
+      return MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1 + pFrame[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+   if ( pFrame[0] != MAVLINK_STX || iAvailable < 3 )
+      return -1;
+   int iLength = MAVLINK_CORE_HEADER_LEN + 1 + pFrame[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+   if ( pFrame[2] & MAVLINK_IFLAG_SIGNED )
+      iLength += MAVLINK_SIGNATURE_BLOCK_LEN;
+   return iLength;
+}
+
+static bool _load_tlog(const char* szFile)
+{
+   FILE* fd = fopen(szFile, "rb");
+   if ( NULL == fd )
+      return false;
+   fseek(fd, 0, SEEK_END);
+   long lSize = ftell(fd);
+   fseek(fd, 0, SEEK_SET);
+   u8* pFile = (u8*) malloc(lSize);
+   if ( (lSize <= 0) || (lSize > TEST_MAX_STREAM_SIZE) || (NULL == pFile) || (lSize != (long)fread(pFile, 1, lSize, fd)) )
+   {
+      fclose(fd);
+      free(pFile);
+      return false;
+   }
+   fclose(fd);
+
+   // Drop the record timestamps, keep only what the FC would have sent on the serial port
+   unsigned long long uFirstTime = 0, uLastTime = 0;
+   long lPos = 0;
+   while ( lPos + 8 < lSize )
+   {
+      unsigned long long uTime = 0;
+      for( int i=0; i<8; i++ )
+         uTime = (uTime << 8) | pFile[lPos+i];
+      int iFrameLength = _get_frame_length(&pFile[lPos+8], lSize - lPos - 8);
+      if ( (iFrameLength < 0) || (lPos + 8 + iFrameLength > lSize) )
+         break;
+      if ( 0 == uFirstTime )
+         uFirstTime = uTime;
+      uLastTime = uTime;
+      memcpy(&s_pStream[s_iStreamLength], &pFile[lPos+8], iFrameLength);
+      s_iStreamLength += iFrameLength;
+      s_iStreamFrames++;
+      lPos += 8 + iFrameLength;
+   }
+   free(pFile);
+   s_fStreamSeconds = (double)(uLastTime - uFirstTime) / 1000000.0;
+   if ( s_fStreamSeconds <= 0.0 )
+      s_fStreamSeconds = (double)s_iStreamLength / 92160.0;
+   return (s_iStreamFrames > 0);
+}
+
+static void _add_message(mavlink_message_t* pMsg)
+{
+   s_iStreamLength += mavlink_msg_to_send_buffer(&s_pStream[s_iStreamLength], pMsg);
+   s_iStreamFrames++;
+}
+
+// Message mix and rates close to what ArduPilot sends with SRx rates raised for a 921600 link.
+// Most of the bytes are messages Ruby does not consume (IMU, servo outputs, params, ...).
+static void _generate_stream(int iAddNoise)
+{
+   mavlink_message_t msg;
+   for( int iTick=0; iTick<TEST_STREAM_SECONDS*50; iTick++ )
+   {
+      u32 uTimeMs = iTick * 20;
+      bool bNoise = iAddNoise && (iTick < TEST_STREAM_SECONDS*25);
+
+      mavlink_attitude_t att;
+      memset(&att, 0, sizeof(att));
+      att.time_boot_ms = uTimeMs;
+      att.roll = 0.3f*sinf(iTick*0.01f);
+      att.pitch = 0.2f*cosf(iTick*0.013f);
+      att.yaw = iTick*0.001f;
+      mavlink_msg_attitude_encode(TEST_SYS_ID, 1, &msg, &att);
+      _add_message(&msg);
+
+      mavlink_raw_imu_t imu;
+      memset(&imu, 0, sizeof(imu));
+      imu.time_usec = uTimeMs*1000;
+      imu.xacc = _rand() & 0x3FF;
+      imu.yacc = _rand() & 0x3FF;
+      imu.zacc = -1000 + (_rand() & 0x3F);
+      imu.xgyro = _rand() & 0x1F;
+      mavlink_msg_raw_imu_encode(TEST_SYS_ID, 1, &msg, &imu);
+      _add_message(&msg);
+
+      mavlink_scaled_imu2_t imu2;
+      memset(&imu2, 0, sizeof(imu2));
+      imu2.time_boot_ms = uTimeMs;
+      imu2.xacc = _rand() & 0x3FF;
+      imu2.zacc = -1000;
+      mavlink_msg_scaled_imu2_encode(TEST_SYS_ID, 1, &msg, &imu2);
+      _add_message(&msg);
+
+      if ( (iTick % 5) == 0 )
+      {
+         mavlink_global_position_int_t pos;
+         memset(&pos, 0, sizeof(pos));
+         pos.time_boot_ms = uTimeMs;
+         pos.lat = 473977420 + iTick;
+         pos.lon = 85455940 - iTick;
+         pos.alt = 488000 + iTick*3;
+         pos.relative_alt = iTick*3;
+         pos.hdg = (iTick*7) % 36000;
+         mavlink_msg_global_position_int_encode(TEST_SYS_ID, 1, &msg, &pos);
+         _add_message(&msg);
+
+         mavlink_vfr_hud_t hud;
+         memset(&hud, 0, sizeof(hud));
+         hud.airspeed = 12.5f + (iTick % 100)*0.01f;
+         hud.groundspeed = 11.0f + (iTick % 50)*0.02f;
+         hud.climb = 0.5f;
+         hud.throttle = (iTick/5) % 101;
+         mavlink_msg_vfr_hud_encode(TEST_SYS_ID, 1, &msg, &hud);
+         _add_message(&msg);
+
+         mavlink_rc_channels_t rc;
+         memset(&rc, 0, sizeof(rc));
+         rc.time_boot_ms = uTimeMs;
+         rc.chancount = 16;
+         rc.chan1_raw = 1000 + (iTick % 1000);
+         rc.chan2_raw = 1500;
+         rc.chan3_raw = 1100 + (iTick % 800);
+         rc.chan4_raw = 1500;
+         rc.chan8_raw = 2000;
+         rc.rssi = 200;
+         mavlink_msg_rc_channels_encode(TEST_SYS_ID, 1, &msg, &rc);
+         _add_message(&msg);
+
+         mavlink_servo_output_raw_t servo;
+         memset(&servo, 0, sizeof(servo));
+         servo.time_usec = uTimeMs*1000;
+         servo.servo1_raw = 1100 + (iTick % 800);
+         servo.servo2_raw = 1200;
+         servo.servo3_raw = 1300;
+         servo.servo4_raw = 1400;
+         mavlink_msg_servo_output_raw_encode(TEST_SYS_ID, 1, &msg, &servo);
+         _add_message(&msg);
+
+         mavlink_nav_controller_output_t nav;
+         memset(&nav, 0, sizeof(nav));
+         nav.nav_roll = 1.5f;
+         nav.wp_dist = iTick;
+         mavlink_msg_nav_controller_output_encode(TEST_SYS_ID, 1, &msg, &nav);
+         _add_message(&msg);
+      }
+
+      if ( (iTick % 10) == 0 )
+      {
+         mavlink_gps_raw_int_t gps;
+         memset(&gps, 0, sizeof(gps));
+         gps.time_usec = uTimeMs*1000;
+         gps.lat = 473977420 + iTick;
+         gps.lon = 85455940 - iTick;
+         gps.fix_type = 3;
+         gps.satellites_visible = 12 + (iTick/10) % 5;
+         gps.eph = 90;
+         mavlink_msg_gps_raw_int_encode(TEST_SYS_ID, 1, &msg, &gps);
+         _add_message(&msg);
+
+         mavlink_vibration_t vib;
+         memset(&vib, 0, sizeof(vib));
+         vib.vibration_x = 2.0f;
+         mavlink_msg_vibration_encode(TEST_SYS_ID, 1, &msg, &vib);
+         _add_message(&msg);
+
+         mavlink_local_position_ned_t ned;
+         memset(&ned, 0, sizeof(ned));
+         ned.x = iTick*0.1f;
+         mavlink_msg_local_position_ned_encode(TEST_SYS_ID, 1, &msg, &ned);
+         _add_message(&msg);
+      }
+
+      if ( (iTick % 25) == 0 )
+      {
+         mavlink_sys_status_t sys;
+         memset(&sys, 0, sizeof(sys));
+         sys.voltage_battery = 16000 - iTick/10;
+         sys.current_battery = 1200 + (iTick % 300);
+         mavlink_msg_sys_status_encode(TEST_SYS_ID, 1, &msg, &sys);
+         _add_message(&msg);
+
+         mavlink_battery_status_t bat;
+         memset(&bat, 0, sizeof(bat));
+         bat.current_consumed = iTick/3;
+         bat.battery_remaining = 80;
+         mavlink_msg_battery_status_encode(TEST_SYS_ID, 1, &msg, &bat);
+         _add_message(&msg);
+
+         mavlink_scaled_pressure_t press;
+         memset(&press, 0, sizeof(press));
+         press.press_abs = 1013.0f;
+         press.temperature = 2150 + (iTick % 200);
+         mavlink_msg_scaled_pressure_encode(TEST_SYS_ID, 1, &msg, &press);
+         _add_message(&msg);
+
+         mavlink_wind_cov_t wind;
+         memset(&wind, 0, sizeof(wind));
+         wind.wind_x = 2.0f + (iTick % 100)*0.01f;
+         wind.wind_y = 1.0f;
+         mavlink_msg_wind_cov_encode(TEST_SYS_ID, 1, &msg, &wind);
+         _add_message(&msg);
+
+         mavlink_gps2_raw_t gps2;
+         memset(&gps2, 0, sizeof(gps2));
+         gps2.fix_type = 3;
+         gps2.satellites_visible = 9;
+         gps2.eph = 120 + (iTick % 7);
+         mavlink_msg_gps2_raw_encode(TEST_SYS_ID, 1, &msg, &gps2);
+         _add_message(&msg);
+
+         // Same messages from a second vehicle on the same bus, must be filtered out
+         sys.voltage_battery = 11000;
+         mavlink_msg_sys_status_encode(TEST_SYS_ID+1, 1, &msg, &sys);
+         _add_message(&msg);
+      }
+
+      if ( (iTick % 50) == 0 )
+      {
+         mavlink_heartbeat_t hb;
+         memset(&hb, 0, sizeof(hb));
+         hb.type = MAV_TYPE_QUADROTOR;
+         hb.autopilot = MAV_AUTOPILOT_ARDUPILOTMEGA;
+         hb.base_mode = MAV_MODE_FLAG_CUSTOM_MODE_ENABLED | ((iTick/50) % 2 ? MAV_MODE_FLAG_SAFETY_ARMED : 0);
+         hb.custom_mode = (iTick/50) % 7;
+         mavlink_msg_heartbeat_encode(TEST_SYS_ID, 1, &msg, &hb);
+         _add_message(&msg);
+
+         mavlink_system_time_t st;
+         memset(&st, 0, sizeof(st));
+         st.time_boot_ms = uTimeMs;
+         mavlink_msg_system_time_encode(TEST_SYS_ID, 1, &msg, &st);
+         _add_message(&msg);
+
+         mavlink_radio_status_t radio;
+         memset(&radio, 0, sizeof(radio));
+         radio.rssi = 180 + (iTick/50) % 50;
+         mavlink_msg_radio_status_encode(TEST_SYS_ID, 1, &msg, &radio);
+         _add_message(&msg);
+
+         // A MAVLink 1 frame now and then (old radios/OSDs on the same bus)
+         mavlink_get_channel_status(MAVLINK_COMM_1)->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+         mavlink_rc_channels_raw_t rcraw;
+         memset(&rcraw, 0, sizeof(rcraw));
+         rcraw.chan1_raw = 1000 + (iTick % 900);
+         rcraw.rssi = 150;
+         mavlink_msg_rc_channels_raw_encode_chan(TEST_SYS_ID, 1, MAVLINK_COMM_1, &msg, &rcraw);
+         _add_message(&msg);
+      }
+
+      if ( (iTick % 250) == 0 )
+      {
+         mavlink_statustext_t txt;
+         memset(&txt, 0, sizeof(txt));
+         txt.severity = MAV_SEVERITY_INFO;
+         snprintf(txt.text, sizeof(txt.text), "EKF3 IMU%d is using GPS, tick %d", (iTick/250)%2, iTick);
+         mavlink_msg_statustext_encode(TEST_SYS_ID, 1, &msg, &txt);
+         _add_message(&msg);
+      }
+
+      // Parameter download burst at start
+      if ( iTick < 50 )
+      for( int i=0; i<20; i++ )
+      {
+         mavlink_param_value_t param;
+         memset(&param, 0, sizeof(param));
+         snprintf(param.param_id, sizeof(param.param_id), "PARAM_%d", iTick*20+i);
+         param.param_value = (float)i;
+         param.param_count = 1000;
+         param.param_index = iTick*20+i;
+         mavlink_msg_param_value_encode(TEST_SYS_ID, 1, &msg, &param);
+         _add_message(&msg);
+      }
+
+      // Line noise: garbage (with fake STX bytes) between frames and corrupted frames
+      if ( bNoise && ((_rand() % 20) == 0) )
+      {
+         int iCount = 1 + (_rand() % 40);
+         for( int i=0; i<iCount; i++ )
+            s_pStream[s_iStreamLength++] = ((_rand() % 4) == 0) ? MAVLINK_STX : (u8)_rand();
+      }
+      if ( bNoise && ((_rand() % 30) == 0) )
+         s_pStream[s_iStreamLength - 1 - (_rand() % 20)] ^= 0x20;
+   }
+   s_fStreamSeconds = TEST_STREAM_SECONDS;
+}
+
+typedef struct
+{
+   t_packet_header_fc_telemetry fct;
+   t_packet_header_ruby_telemetry_extended_v4 rte;
+   int iRCChannels[16];
+   int iHeartbeats;
+   int iSystemMessages;
+   int iCallsWithMessages;
+   char szLastMessage[FC_MESSAGE_MAX_LENGTH];
+   double fSeconds;
+} t_test_parse_result;
+
+static void _run_parser(bool bUseScanner, t_test_parse_result* pResult)
+{
+   double fBest = 1000000.0;
+   for( int iRun=0; iRun<TEST_REPEAT; iRun++ )
+   {
+      memset(pResult, 0, sizeof(t_test_parse_result));
+      memset(get_mavlink_rc_channels(), 0, 16*sizeof(int));
+      parse_telemetry_init(TEST_SYS_ID, false);
+      parse_telemetry_use_mavlink_frame_scanner(bUseScanner);
+
+      s_uRandSeed = 777;
+      double fStart = _get_time_sec();
+      int iPos = 0;
+      while ( iPos < s_iStreamLength )
+      {
+         int iLength = 1 + (_rand() % TEST_MAX_READ_SIZE);
+         if ( iPos + iLength > s_iStreamLength )
+            iLength = s_iStreamLength - iPos;
+         if ( parse_telemetry_from_fc(&s_pStream[iPos], iLength, &pResult->fct, &pResult->rte, MODEL_TYPE_DRONE, TELEMETRY_TYPE_MAVLINK) )
+            pResult->iCallsWithMessages++;
+         iPos += iLength;
+      }
+      double fTime = _get_time_sec() - fStart;
+      if ( fTime < fBest )
+         fBest = fTime;
+   }
+   pResult->fSeconds = fBest;
+   memcpy(pResult->iRCChannels, get_mavlink_rc_channels(), 16*sizeof(int));
+   pResult->iHeartbeats = get_heartbeat_msg_count();
+   pResult->iSystemMessages = get_system_msg_count();
+   if ( NULL != get_last_message() )
+      strcpy(pResult->szLastMessage, get_last_message());
+}
+
+static bool _compare_results(const t_test_parse_result* pA, const t_test_parse_result* pB, bool bCheckCounters)
+{
+   bool bSame = true;
+   if ( 0 != memcmp(&pA->fct, &pB->fct, sizeof(pA->fct)) )
+   {
+      printf("  decoded FC telemetry differs\n");
+      bSame = false;
+   }
+   if ( 0 != memcmp(&pA->rte, &pB->rte, sizeof(pA->rte)) )
+   {
+      printf("  decoded Ruby telemetry (RC/RX RSSI) differs\n");
+      bSame = false;
+   }
+   if ( 0 != memcmp(pA->iRCChannels, pB->iRCChannels, sizeof(pA->iRCChannels)) )
+   {
+      printf("  RC channels differ\n");
+      bSame = false;
+   }
+   if ( 0 != strcmp(pA->szLastMessage, pB->szLastMessage) )
+   {
+      printf("  last FC message differs: [%s] / [%s]\n", pA->szLastMessage, pB->szLastMessage);
+      bSame = false;
+   }
+   if ( bCheckCounters )
+   if ( (pA->iHeartbeats != pB->iHeartbeats) || (pA->iSystemMessages != pB->iSystemMessages) )
+   {
+      printf("  message counters differ: heartbeats %d/%d, sys status %d/%d\n", pA->iHeartbeats, pB->iHeartbeats, pA->iSystemMessages, pB->iSystemMessages);
+      bSame = false;
+   }
+   return bSame;
+}
+
+static void _print_result(const char* szName, const t_test_parse_result* pResult)
+{
+   double fMBs = (double)s_iStreamLength / pResult->fSeconds / (1024.0*1024.0);
+   double fUsPerSec = pResult->fSeconds * 1000000.0 / s_fStreamSeconds;
+   printf("%s: %.2f ms, %.1f MB/s, %.1f us CPU per second of telemetry (%d heartbeats, %d sys status)\n",
+      szName, pResult->fSeconds*1000.0, fMBs, fUsPerSec, pResult->iHeartbeats, pResult->iSystemMessages);
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("test_mavlink_parse");
+   log_disable();
+
+   s_pStream = (u8*) malloc(TEST_MAX_STREAM_SIZE);
+   if ( NULL == s_pStream )
+      return 1;
+
+   bool bFromFile = false;
+   if ( argc > 1 )
+   {
+      if ( ! _load_tlog(argv[1]) )
+      {
+         printf("Failed to load tlog file %s\n", argv[1]);
+         return 1;
+      }
+      bFromFile = true;
+      printf("\nReplaying %s: %d frames, %d bytes, %.1f seconds\n", argv[1], s_iStreamFrames, s_iStreamLength, s_fStreamSeconds);
+   }
+   else
+   {
+      _generate_stream(0);
+      printf("\nReplaying generated ArduPilot like stream: %d frames, %d bytes, %d seconds (%.1f%% of a 921600 baud link)\n",
+         s_iStreamFrames, s_iStreamLength, TEST_STREAM_SECONDS, 100.0*(double)s_iStreamLength/(92160.0*TEST_STREAM_SECONDS));
+   }
+
+   t_test_parse_result resultBytes, resultScanner;
+   _run_parser(false, &resultBytes);
+   _run_parser(true, &resultScanner);
+   _print_result("byte parser  ", &resultBytes);
+   _print_result("frame scanner", &resultScanner);
+   printf("speedup: %.2fx\n", resultBytes.fSeconds / resultScanner.fSeconds);
+   bool bOk = _compare_results(&resultBytes, &resultScanner, true);
+
+   if ( ! bFromFile )
+   {
+      // Noisy line in the first half of the stream; both parsers must end up in sync with the same state
+      t_test_parse_result resultNoiseBytes, resultNoiseScanner;
+      s_iStreamLength = 0;
+      s_iStreamFrames = 0;
+      s_uRandSeed = 12345;
+      _generate_stream(1);
+      printf("\nSame stream with line noise (%d bytes):\n", s_iStreamLength);
+      _run_parser(false, &resultNoiseBytes);
+      _run_parser(true, &resultNoiseScanner);
+      _print_result("byte parser  ", &resultNoiseBytes);
+      _print_result("frame scanner", &resultNoiseScanner);
+      if ( ! _compare_results(&resultNoiseBytes, &resultNoiseScanner, false) )
+         bOk = false;
+   }
+
+   free(s_pStream);
+   printf("\n%s\n", bOk?"PASS":"FAIL");
+   return bOk?0:1;
+}
@@ -0,0 +1,157 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Checks the shared memory model snapshot (base/model_snapshot.h): publish and read back,
+// per section checks, source file change detection, invalidation and change notification
+// across processes.
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "../base/base.h"
+#include "../base/model_snapshot.h"
+
+static int s_iFailed = 0;
+
+static void _check(int iCondition, const char* szName)
+{
+   printf("%s: %s\n", iCondition?"ok  ":"FAIL", szName);
+   if ( ! iCondition )
+      s_iFailed++;
+}
+
+static void _write_file(const char* szFile, const char* szContent)
+{
+   FILE* fd = fopen(szFile, "w");
+   if ( NULL != fd )
+   {
+      fputs(szContent, fd);
+      fclose(fd);
+   }
+}
+
+typedef struct
+{
+   u32 uValue1;
+   char szName[20];
+} t_test_section_a;
+
+int main(int argc, char *argv[])
+{
+   log_init("TestModelSnapshot");
+   log_disable();
+   shm_unlink(SHARED_MEM_MODEL_SNAPSHOT);
+
+   char szFile[MAX_FILE_PATH_SIZE];
+   sprintf(szFile, "/tmp/test_model_snapshot_%d.mdl", (int)getpid());
+   _write_file(szFile, "ver: 10\n");
+
+   t_test_section_a sectionA;
+   memset(&sectionA, 0, sizeof(sectionA));
+   sectionA.uValue1 = 1234;
+   strcpy(sectionA.szName, "vehicle");
+   u8 uSectionB[301];
+   for( int i=0; i<(int)sizeof(uSectionB); i++ )
+      uSectionB[i] = (u8)(i*7);
+
+   t_model_snapshot_section_source sections[2];
+   sections[0].uId = 1;
+   sections[0].pData = &sectionA;
+   sections[0].uSize = sizeof(sectionA);
+   sections[1].uId = 2;
+   sections[1].pData = uSectionB;
+   sections[1].uSize = sizeof(uSectionB);
+   u32 uLayout = model_snapshot_compute_layout_hash(sections, 2);
+
+   t_model_snapshot* pSnapshot = (t_model_snapshot*) malloc(sizeof(t_model_snapshot));
+   _check(0 == model_snapshot_read(szFile, uLayout, pSnapshot), "no snapshot before publish");
+
+   u32 uGen = model_snapshot_get_generation();
+   _check(1 == model_snapshot_publish(szFile, 7, uLayout, sections, 2), "publish");
+   _check(model_snapshot_get_generation() != uGen, "generation changes on publish");
+   _check(1 == model_snapshot_read(szFile, uLayout, pSnapshot), "read back");
+   _check(7 == pSnapshot->header.uSaveCount, "save count");
+
+   const t_test_section_a* pA = (const t_test_section_a*) model_snapshot_get_section(pSnapshot, 1, sizeof(t_test_section_a));
+   _check((NULL != pA) && (pA->uValue1 == 1234) && (0 == strcmp(pA->szName, "vehicle")), "section 1 content");
+   const u8* pB = model_snapshot_get_section(pSnapshot, 2, sizeof(uSectionB));
+   _check((NULL != pB) && (0 == memcmp(pB, uSectionB, sizeof(uSectionB))), "section 2 content");
+   _check(NULL == model_snapshot_get_section(pSnapshot, 2, sizeof(uSectionB)-1), "section size mismatch is rejected");
+   _check(NULL == model_snapshot_get_section(pSnapshot, 3, 4), "missing section");
+
+   pSnapshot->uData[pSnapshot->header.sections[1].uOffset + 5] ^= 0xFF;
+   _check(NULL == model_snapshot_get_section(pSnapshot, 2, sizeof(uSectionB)), "corrupted section is rejected");
+
+   _check(0 == model_snapshot_read(szFile, uLayout+1, pSnapshot), "different layout is rejected");
+   _check(0 == model_snapshot_read("/tmp/other_file.mdl", uLayout, pSnapshot), "different source file is rejected");
+
+   // Source file changed behind the snapshot
+   hardware_sleep_ms(20);
+   _write_file(szFile, "ver: 10\nsavecounter: 8\n");
+   _check(0 == model_snapshot_read(szFile, uLayout, pSnapshot), "changed source file is detected");
+
+   _check(1 == model_snapshot_publish(szFile, 8, uLayout, sections, 2), "publish again");
+   _check(1 == model_snapshot_read(szFile, uLayout, pSnapshot), "read after publish again");
+   model_snapshot_invalidate();
+   _check(0 == model_snapshot_read(szFile, uLayout, pSnapshot), "invalidated snapshot");
+
+   // Change notification from another process
+   uGen = model_snapshot_get_generation();
+   _check(0 == model_snapshot_wait_for_change(uGen, 10), "no change, wait times out");
+   pid_t pid = fork();
+   if ( 0 == pid )
+   {
+      hardware_sleep_ms(100);
+      sectionA.uValue1 = 5678;
+      model_snapshot_publish(szFile, 9, uLayout, sections, 2);
+      _exit(0);
+   }
+   u32 uTimeStart = get_current_timestamp_ms();
+   int iChanged = model_snapshot_wait_for_change(uGen, 2000);
+   u32 uWaited = get_current_timestamp_ms() - uTimeStart;
+   _check(iChanged && (uWaited < 1000), "woken up by the publish of another process");
+   waitpid(pid, NULL, 0);
+   _check(1 == model_snapshot_read(szFile, uLayout, pSnapshot), "read the other process snapshot");
+   pA = (const t_test_section_a*) model_snapshot_get_section(pSnapshot, 1, sizeof(t_test_section_a));
+   _check((NULL != pA) && (pA->uValue1 == 5678) && (9 == pSnapshot->header.uSaveCount), "other process snapshot content");
+
+   u32 uTimeMicros = get_current_timestamp_micros();
+   for( int i=0; i<1000; i++ )
+      model_snapshot_read(szFile, uLayout, pSnapshot);
+   printf("read: %.2f us per snapshot\n", (float)(get_current_timestamp_micros() - uTimeMicros)/1000.0);
+
+   free(pSnapshot);
+   unlink(szFile);
+   shm_unlink(SHARED_MEM_MODEL_SNAPSHOT);
+
+   printf("%s\n", s_iFailed?"FAILED":"PASSED");
+   return s_iFailed?1:0;
+}
@@ -0,0 +1,327 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Runs both ends of a simulated radio link (see base/hardware_radio_sim.h) in two processes
+// and checks delivery, loss, latency and the synthetic RSSI against the configured channel model.
+// Usage: test_radio_sim [-count n] [-interval us] [-size bytes] [-channel "loss=0.1,latency=20,..."]
+
+#include <sys/wait.h>
+#include <poll.h>
+#include <math.h>
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware.h"
+#include "../base/hardware_radio.h"
+#include "../base/hardware_radio_sim.h"
+#include "../radio/radiolink.h"
+#include "../radio/radiopackets2.h"
+#include "../radio/radio_sim.h"
+
+typedef struct
+{
+   int iReceived;
+   int iMaxSeq;
+   int iMaxGap;
+   int iReordered;
+   int iDuplicates;
+   double dLatencyAvgMs;
+   double dLatencyMinMs;
+   double dLatencyMaxMs;
+   int iRSSIMin;
+   int iRSSIMax;
+   int iNoise;
+} t_test_radio_sim_result;
+
+static int s_iCount = 2000;
+static int s_iIntervalUs = 1000;
+static int s_iSize = 1000;
+static char s_szChannel[256];
+static char s_szSocketsFolder[128];
+
+static int _setup_node(const char* szNode, const char* szPeer, const char* szChannel)
+{
+   char szConfig[512];
+   snprintf(szConfig, sizeof(szConfig), "node=%s,peer=%s,dir=%s,seed=1234%s%s", szNode, szPeer, s_szSocketsFolder,
+      (NULL != szChannel && 0 != szChannel[0])?",":"", (NULL != szChannel)?szChannel:"");
+   setenv(RADIO_SIM_ENV_VAR, szConfig, 1);
+   if ( ! hardware_radio_sim_is_enabled() )
+      return 0;
+   if ( hardware_get_radio_interfaces_count() < 1 )
+      return 0;
+   if ( ! hardware_radio_is_simulated_radio(hardware_get_radio_info(0)) )
+      return 0;
+   radio_init_link_structures();
+   radio_enable_crc_gen(1);
+   return 1;
+}
+
+static unsigned long long _time_us()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((unsigned long long)ts.tv_sec) * 1000000LL + ts.tv_nsec/1000;
+}
+
+static void _run_receiver(int iFdReady, int iFdResult)
+{
+   t_test_radio_sim_result result;
+   memset(&result, 0, sizeof(result));
+   result.dLatencyMinMs = 1000000.0;
+   result.iRSSIMin = 1000;
+   result.iRSSIMax = -1000;
+
+   if ( ! _setup_node("b", "a", "") )
+   {
+      printf("Receiver: failed to setup simulated radio.\n");
+      exit(1);
+   }
+   int iFd = radio_open_interface_for_read(0, RADIO_PORT_ROUTER_UPLINK);
+   if ( iFd < 0 )
+   {
+      printf("Receiver: failed to open simulated radio for read.\n");
+      exit(1);
+   }
+   u8 uReady = 1;
+   if ( 1 != write(iFdReady, &uReady, 1) )
+      exit(1);
+
+   u8* pSeen = (u8*) malloc(s_iCount);
+   memset(pSeen, 0, s_iCount);
+   int iLastSeq = -1;
+   unsigned long long uLastRecvTime = _time_us();
+   radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(0);
+
+   while ( _time_us() < uLastRecvTime + 2000000LL )
+   {
+      struct pollfd pfd;
+      pfd.fd = iFd;
+      pfd.events = POLLIN;
+      if ( poll(&pfd, 1, 50) <= 0 )
+         continue;
+
+      while ( 1 )
+      {
+         int iLength = 0;
+         u8* pData = radio_process_wlan_data_in(0, &iLength, get_current_timestamp_ms());
+         if ( NULL == pData )
+            break;
+         unsigned long long uTimeNow = _time_us();
+         if ( iLength < (int)(sizeof(t_packet_header) + sizeof(int) + sizeof(unsigned long long)) )
+            continue;
+         int iSeq = 0;
+         unsigned long long uSentTime = 0;
+         memcpy(&iSeq, pData + sizeof(t_packet_header), sizeof(int));
+         memcpy(&uSentTime, pData + sizeof(t_packet_header) + sizeof(int), sizeof(unsigned long long));
+         if ( (iSeq < 0) || (iSeq >= s_iCount) )
+            continue;
+         uLastRecvTime = uTimeNow;
+         if ( pSeen[iSeq] )
+         {
+            result.iDuplicates++;
+            continue;
+         }
+         pSeen[iSeq] = 1;
+         result.iReceived++;
+         if ( iSeq < iLastSeq )
+            result.iReordered++;
+         else
+         {
+            if ( iSeq - iLastSeq - 1 > result.iMaxGap )
+               result.iMaxGap = iSeq - iLastSeq - 1;
+            iLastSeq = iSeq;
+         }
+         if ( iSeq > result.iMaxSeq )
+            result.iMaxSeq = iSeq;
+
+         double dLatency = (double)(uTimeNow - uSentTime)/1000.0;
+         result.dLatencyAvgMs += dLatency;
+         if ( dLatency < result.dLatencyMinMs )
+            result.dLatencyMinMs = dLatency;
+         if ( dLatency > result.dLatencyMaxMs )
+            result.dLatencyMaxMs = dLatency;
+
+         int iRSSI = pRadioHWInfo->runtimeInterfaceInfoRx.radioHwRxInfo.nDbmLast[0];
+         if ( iRSSI < result.iRSSIMin )
+            result.iRSSIMin = iRSSI;
+         if ( iRSSI > result.iRSSIMax )
+            result.iRSSIMax = iRSSI;
+         result.iNoise = pRadioHWInfo->runtimeInterfaceInfoRx.radioHwRxInfo.nDbmNoiseLast[0];
+      }
+   }
+   if ( result.iReceived > 0 )
+      result.dLatencyAvgMs /= result.iReceived;
+   radio_close_interface_for_read(0);
+   if ( sizeof(result) != write(iFdResult, &result, sizeof(result)) )
+      exit(1);
+   exit(0);
+}
+
+static int _run_sender(int iFdReady, int iFdResult, t_test_radio_sim_result* pResult)
+{
+   if ( ! _setup_node("a", "b", s_szChannel) )
+   {
+      printf("Sender: failed to setup simulated radio.\n");
+      return 0;
+   }
+   if ( radio_open_interface_for_write(0) < 0 )
+   {
+      printf("Sender: failed to open simulated radio for write.\n");
+      return 0;
+   }
+   radio_set_frames_flags(RADIO_FLAGS_USE_LEGACY_DATARATES | RADIO_FLAGS_FRAME_TYPE_DATA);
+   radio_set_out_datarate(12*1000*1000);
+
+   u8 uReady = 0;
+   if ( 1 != read(iFdReady, &uReady, 1) )
+      return 0;
+
+   unsigned long long uTimeStart = _time_us();
+   for( int i=0; i<s_iCount; i++ )
+   {
+      unsigned long long uTimeSend = uTimeStart + (unsigned long long)i * s_iIntervalUs;
+      while ( _time_us() < uTimeSend )
+         hardware_sleep_micros(100);
+
+      t_packet_header PH;
+      radio_packet_init(&PH, PACKET_COMPONENT_RUBY, PACKET_TYPE_VIDEO_DATA, STREAM_ID_VIDEO_1);
+      PH.vehicle_id_src = 1;
+      PH.vehicle_id_dest = 0;
+      PH.total_length = sizeof(t_packet_header) + s_iSize;
+
+      u8 packet[MAX_PACKET_TOTAL_SIZE];
+      memset(packet, 0, sizeof(packet));
+      memcpy(packet, &PH, sizeof(t_packet_header));
+      unsigned long long uTimeNow = _time_us();
+      memcpy(packet + sizeof(t_packet_header), &i, sizeof(int));
+      memcpy(packet + sizeof(t_packet_header) + sizeof(int), &uTimeNow, sizeof(unsigned long long));
+
+      u8 rawPacket[MAX_PACKET_TOTAL_SIZE*2];
+      int iTotalLength = radio_build_new_raw_ieee_packet(0, rawPacket, packet, PH.total_length, RADIO_PORT_ROUTER_UPLINK, 0);
+      if ( 0 == radio_write_raw_ieee_packet(0, rawPacket, iTotalLength, 0) )
+      {
+         printf("Sender: failed to write frame %d.\n", i);
+         return 0;
+      }
+   }
+   unsigned long long uSendDuration = _time_us() - uTimeStart;
+
+   if ( sizeof(t_test_radio_sim_result) != read(iFdResult, pResult, sizeof(t_test_radio_sim_result)) )
+      return 0;
+   radio_sim_log_stats(0);
+   radio_close_interface_for_write(0);
+   printf("Sent %d frames of %d bytes in %.1f ms\n", s_iCount, s_iSize, (double)uSendDuration/1000.0);
+   return 1;
+}
+
+int main(int argc, char *argv[])
+{
+   s_szChannel[0] = 0;
+   snprintf(s_szSocketsFolder, sizeof(s_szSocketsFolder), "/tmp");
+   for( int i=1; i<argc-1; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-count") )
+         s_iCount = atoi(argv[++i]);
+      else if ( 0 == strcmp(argv[i], "-interval") )
+         s_iIntervalUs = atoi(argv[++i]);
+      else if ( 0 == strcmp(argv[i], "-size") )
+         s_iSize = atoi(argv[++i]);
+      else if ( 0 == strcmp(argv[i], "-channel") )
+         strncpy(s_szChannel, argv[++i], sizeof(s_szChannel)-1);
+      else if ( 0 == strcmp(argv[i], "-dir") )
+         strncpy(s_szSocketsFolder, argv[++i], sizeof(s_szSocketsFolder)-1);
+   }
+   if ( s_iCount < 1 )
+      s_iCount = 1;
+   if ( (s_iSize < (int)(sizeof(int) + sizeof(unsigned long long))) || (s_iSize > MAX_PACKET_TOTAL_SIZE - (int)sizeof(t_packet_header) - 64) )
+      s_iSize = 1000;
+
+   log_init("TestRadioSim");
+   log_disable();
+
+   int iPipeReady[2];
+   int iPipeResult[2];
+   if ( (0 != pipe(iPipeReady)) || (0 != pipe(iPipeResult)) )
+      return -1;
+
+   pid_t pid = fork();
+   if ( pid < 0 )
+      return -1;
+   if ( 0 == pid )
+      _run_receiver(iPipeReady[1], iPipeResult[1]);
+
+   t_test_radio_sim_result result;
+   memset(&result, 0, sizeof(result));
+   int iOk = _run_sender(iPipeReady[0], iPipeResult[0], &result);
+   int iStatus = 0;
+   waitpid(pid, &iStatus, 0);
+   if ( (! iOk) || (! WIFEXITED(iStatus)) || (0 != WEXITSTATUS(iStatus)) )
+   {
+      printf("FAIL: simulated link did not run.\n");
+      return -1;
+   }
+
+   t_radio_sim_config config;
+   char szConfig[512];
+   snprintf(szConfig, sizeof(szConfig), "node=a,peer=b,%s", s_szChannel);
+   hardware_radio_sim_parse_config(szConfig, &config);
+
+   double dLoss = 1.0 - (double)result.iReceived/(double)s_iCount;
+   printf("Channel: [%s]\n", s_szChannel);
+   printf("Received %d of %d frames (loss %.2f%%), max consecutive lost: %d, reordered: %d, duplicates: %d\n",
+      result.iReceived, s_iCount, dLoss*100.0, result.iMaxGap, result.iReordered, result.iDuplicates);
+   printf("Latency: avg %.2f ms, min %.2f ms, max %.2f ms\n", result.dLatencyAvgMs, result.dLatencyMinMs, result.dLatencyMaxMs);
+   printf("RSSI: %d..%d dBm, noise: %d dBm\n", result.iRSSIMin, result.iRSSIMax, result.iNoise);
+
+   // Expected long term loss of the Gilbert-Elliott model
+   double dBadShare = 0.0;
+   if ( config.fGEProbGoodToBad > 0.0 )
+      dBadShare = config.fGEProbGoodToBad / (config.fGEProbGoodToBad + config.fGEProbBadToGood);
+   double dExpectedLoss = (1.0 - dBadShare) * config.fLoss + dBadShare * config.fGELossBad;
+
+   int iFailed = 0;
+   if ( (result.iReordered > 0) || (result.iDuplicates > 0) )
+      iFailed = 1;
+   if ( (0 == config.uRateKbps) && (dLoss > dExpectedLoss + 0.05 + 3.0 * sqrt(dExpectedLoss/s_iCount)) )
+      iFailed = 1;
+   if ( (dExpectedLoss > 0.0) && (dLoss < dExpectedLoss - 0.05 - 3.0 * sqrt(dExpectedLoss/s_iCount)) )
+      iFailed = 1;
+   if ( (result.iReceived > 0) && (result.dLatencyMinMs + 0.5 < (double)config.uLatencyMs) )
+      iFailed = 1;
+   if ( (result.iReceived > 0) && (result.iRSSIMax > config.iRSSIGood + 2) )
+      iFailed = 1;
+   if ( (0 == config.uRateKbps) && (0 == dExpectedLoss) && (result.iReceived != s_iCount) )
+      iFailed = 1;
+
+   printf("Expected loss: %.2f%%\n", dExpectedLoss*100.0);
+   printf("%s\n", iFailed?"FAIL":"PASS");
+   return iFailed?-1:0;
+}
@@ -0,0 +1,123 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../base/base.h"
+#include "../base/encr.h"
+#include "../radio/radiopackets2.h"
+
+// Checks how much of a received radio buffer the relay forwards: the chained packets
+// already checked by the rx thread, without the AEAD salt and tag that follow an AEAD packet.
+
+static int s_iCountTests = 0;
+static int s_iCountFailed = 0;
+
+static void _check_length(const char* szName, int iResult, int iExpected)
+{
+   s_iCountTests++;
+   if ( iResult == iExpected )
+      return;
+   printf("FAILED: %s: got %d bytes, expected %d bytes\n", szName, iResult, iExpected);
+   s_iCountFailed++;
+}
+
+static int _add_packet(u8* pBuffer, u8 uPacketType, int iDataLength)
+{
+   t_packet_header* pPH = (t_packet_header*)pBuffer;
+   radio_packet_init(pPH, PACKET_COMPONENT_TELEMETRY, uPacketType, STREAM_ID_DATA);
+   pPH->vehicle_id_src = 1234;
+   pPH->total_length = sizeof(t_packet_header) + iDataLength;
+   for( int i=0; i<iDataLength; i++ )
+      pBuffer[sizeof(t_packet_header)+i] = (u8)(i*7);
+   radio_packet_compute_crc(pBuffer, pPH->total_length);
+   return pPH->total_length;
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestRelayPackets");
+   log_disable();
+
+   printf("\nTesting relayed packets lengths\n");
+
+   u8 uBuffer[MAX_PACKET_TOTAL_SIZE];
+
+   // Single plain packet
+   int iLength = _add_packet(uBuffer, PACKET_TYPE_RUBY_TELEMETRY_SHORT, 100);
+   _check_length("single packet", radio_packets_get_authenticated_length(uBuffer, iLength), iLength);
+
+   // Chained plain packets
+   int iLength2 = _add_packet(uBuffer + iLength, PACKET_TYPE_FC_TELEMETRY, 60);
+   _check_length("chained packets", radio_packets_get_authenticated_length(uBuffer, iLength + iLength2), iLength + iLength2);
+
+   // Truncated second packet is not forwarded
+   _check_length("truncated chained packet", radio_packets_get_authenticated_length(uBuffer, iLength + iLength2 - 1), iLength);
+
+   // Invalid lengths
+   _check_length("buffer smaller than a header", radio_packets_get_authenticated_length(uBuffer, sizeof(t_packet_header)-1), 0);
+   ((t_packet_header*)uBuffer)->total_length = 2;
+   _check_length("packet smaller than a header", radio_packets_get_authenticated_length(uBuffer, iLength), 0);
+
+   // AEAD packet: encrypted as by the sender, followed by the salt and tag, then decrypted in place as by the rx thread
+   char szPass[32];
+   strcpy(szPass, "relay-test-pass");
+   upp(szPass);
+   iLength = _add_packet(uBuffer, PACKET_TYPE_RUBY_TELEMETRY_EXTENDED, 200);
+   t_packet_header* pPH = (t_packet_header*)uBuffer;
+   pPH->packet_flags |= PACKET_FLAGS_BIT_HAS_ENCRYPTION;
+   pPH->packet_flags_extended |= PACKET_FLAGS_EXTENDED_BIT_AEAD;
+   u8 uPlain[MAX_PACKET_TOTAL_SIZE];
+   memcpy(uPlain, uBuffer, iLength);
+   u8 uNonce[ENC_AEAD_NONCE_SIZE];
+   memset(uNonce, 0x5A, sizeof(uNonce));
+   int dx = sizeof(t_packet_header);
+   eppa(uBuffer, dx, uBuffer + dx, iLength - dx, uNonce, uBuffer + iLength, uBuffer + iLength + ENC_AEAD_SALT_SIZE);
+   int iRadioLength = iLength + ENC_AEAD_TRAILER_SIZE;
+
+   s_iCountTests++;
+   if ( (1 != dppa(uBuffer, dx, uBuffer + dx, iLength - dx, uNonce, uBuffer + iLength, uBuffer + iLength + ENC_AEAD_SALT_SIZE)) ||
+        (0 != memcmp(uBuffer, uPlain, iLength)) )
+   {
+      printf("FAILED: AEAD packet was not decrypted\n");
+      s_iCountFailed++;
+   }
+   _check_length("AEAD packet with trailer", radio_packets_get_authenticated_length(uBuffer, iRadioLength), iLength);
+
+   // Nothing after an AEAD packet is forwarded, even if it looks like a valid packet
+   iLength2 = _add_packet(uBuffer + iLength, PACKET_TYPE_FC_TELEMETRY, 60);
+   _check_length("AEAD packet followed by a packet", radio_packets_get_authenticated_length(uBuffer, iLength + iLength2), iLength);
+
+   printf("\n%d tests, %d failed: %s\n", s_iCountTests, s_iCountFailed, (0 == s_iCountFailed)?"PASS":"FAIL");
+   return (0 == s_iCountFailed)?0:1;
+}
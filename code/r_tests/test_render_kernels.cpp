@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../base/base.h"
+#include "../renderer/fbgraphics.h"
+#include "../renderer/render_kernels.h"
+
+// Checks that the SIMD render span kernels are bit exact with the scalar ones and
+// replays a recorded-like OSD frame (panels, lines, text glyphs) on the raw engine
+// primitives, printing the ms/frame with the scalar and the SIMD kernels.
+
+#define TEST_WIDTH 1280
+#define TEST_HEIGHT 720
+#define TEST_GLYPH_WIDTH 14
+#define TEST_GLYPH_HEIGHT 24
+#define TEST_GLYPHS 96
+#define TEST_SPAN_MAX 300
+#define TEST_FRAMES 60
+
+static u8 s_FrameScalar[TEST_WIDTH*TEST_HEIGHT*4];
+static u8 s_FrameSIMD[TEST_WIDTH*TEST_HEIGHT*4];
+static u8 s_FontAtlas[TEST_GLYPHS*TEST_GLYPH_WIDTH*TEST_GLYPH_HEIGHT*4];
+
+static long long _get_time_us()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (long long)t.tv_sec * 1000000LL + t.tv_nsec/1000;
+}
+
+// Anti aliased looking glyphs: white core, dark outline, alpha ramps on the edges
+static void _build_font_atlas()
+{
+   for( int g=0; g<TEST_GLYPHS; g++ )
+   for( int y=0; y<TEST_GLYPH_HEIGHT; y++ )
+   for( int x=0; x<TEST_GLYPH_WIDTH; x++ )
+   {
+      u8* p = &s_FontAtlas[((y*TEST_GLYPHS*TEST_GLYPH_WIDTH) + g*TEST_GLYPH_WIDTH + x)*4];
+      int iDist = abs(((x*7 + y*3 + g*11) % 17) - 8);
+      if ( iDist > 6 )
+      {
+         p[0] = p[1] = p[2] = 255;
+         p[3] = 255;
+      }
+      else if ( iDist > 3 )
+      {
+         p[0] = p[1] = p[2] = 20 + iDist;
+         p[3] = 40*iDist;
+      }
+      else
+      {
+         p[0] = p[1] = p[2] = 0;
+         p[3] = (iDist*31 + g) & 0x7F;
+      }
+   }
+}
+
+static void _init_fbg(struct _fbg* pFbg, u8* pBuffer)
+{
+   memset(pFbg, 0, sizeof(struct _fbg));
+   pFbg->back_buffer = pBuffer;
+   pFbg->width = TEST_WIDTH;
+   pFbg->height = TEST_HEIGHT;
+   pFbg->width_n_height = TEST_WIDTH * TEST_HEIGHT;
+   pFbg->components = 4;
+   pFbg->comp_offset = 0;
+   pFbg->line_length = TEST_WIDTH * 4;
+   pFbg->size = TEST_WIDTH * TEST_HEIGHT * 4;
+   pFbg->mix_color.r = pFbg->mix_color.g = pFbg->mix_color.b = pFbg->mix_color.a = 255;
+}
+
+static void _draw_text(struct _fbg* pFbg, struct _fbg_img* pFont, int x, int y, const char* szText)
+{
+   for( const char* p = szText; *p; p++ )
+   {
+      int iGlyph = ((*p) - 32 + TEST_GLYPHS) % TEST_GLYPHS;
+      fbg_imageClipAColor(pFbg, pFont, x, y, iGlyph*TEST_GLYPH_WIDTH, 0, TEST_GLYPH_WIDTH, TEST_GLYPH_HEIGHT);
+      x += TEST_GLYPH_WIDTH;
+   }
+}
+
+// Same draw calls as a busy OSD screen: top and bottom bars, stats panels with
+// outlines and separators, and about 1500 glyphs of text with the 3 font modes
+static void _render_osd_frame(struct _fbg* pFbg, struct _fbg_img* pFont, int iFrame)
+{
+   char szBuff[64];
+   memset(pFbg->back_buffer, 0, pFbg->size);
+
+   pFbg->s_iEnableRectBlending = 1;
+   fbg_recta(pFbg, 0, 0, TEST_WIDTH, 40, 20, 20, 30, 140);
+   fbg_recta(pFbg, 0, TEST_HEIGHT-40, TEST_WIDTH, 40, 20, 20, 30, 140);
+
+   for( int iPanel=0; iPanel<4; iPanel++ )
+   {
+      int xPanel = 20 + iPanel * 310;
+      int yPanel = 60 + (iPanel%2)*20;
+      pFbg->s_iEnableRectBlending = 1;
+      fbg_recta(pFbg, xPanel, yPanel, 290, 420, 10, 10 + iPanel*30, 40, 160);
+      fbg_hline(pFbg, xPanel, yPanel, 290, 200, 200, 200, 220);
+      fbg_hline(pFbg, xPanel, yPanel+419, 290, 200, 200, 200, 220);
+      fbg_vline(pFbg, xPanel, yPanel, 420, 200, 200, 200, 220);
+      fbg_vline(pFbg, xPanel+289, yPanel, 420, 200, 200, 200, 220);
+
+      for( int iLine=0; iLine<16; iLine++ )
+      {
+         int y = yPanel + 8 + iLine * TEST_GLYPH_HEIGHT;
+         if ( 0 == (iLine % 4) )
+            fbg_hline(pFbg, xPanel+4, y-2, 282, 150, 150, 150, 120);
+         snprintf(szBuff, sizeof(szBuff), "Value %d: %d.%02d", iLine, (iFrame*7+iLine*13)%1000, (iFrame+iLine)%100);
+         pFbg->s_iEnableRectBlending = (iPanel != 3)?1:0;
+         pFbg->disableFontOutline = (iPanel == 1)?1:0;
+         pFbg->mix_color.g = (iLine%3)?255:180;
+         _draw_text(pFbg, pFont, xPanel + 6, y, szBuff);
+      }
+   }
+   pFbg->mix_color.g = 255;
+   pFbg->s_iEnableRectBlending = 0;
+   fbg_rect(pFbg, TEST_WIDTH-120, TEST_HEIGHT-160, 100, 100, 50, 200, 50, 255);
+   pFbg->s_iEnableRectBlending = 1;
+   snprintf(szBuff, sizeof(szBuff), "ALT 123.4m  DIST 2.41km  BAT 15.8V  %d", iFrame);
+   _draw_text(pFbg, pFont, 30, 8, szBuff);
+   _draw_text(pFbg, pFont, 30, TEST_HEIGHT-32, szBuff);
+}
+
+static double _run_frames(int iEnableSIMD, u8* pBuffer)
+{
+   struct _fbg fbg;
+   struct _fbg_img fontImg;
+   fontImg.data = s_FontAtlas;
+   fontImg.width = TEST_GLYPHS*TEST_GLYPH_WIDTH;
+   fontImg.height = TEST_GLYPH_HEIGHT;
+   _init_fbg(&fbg, pBuffer);
+   render_kernels_enable_simd(iEnableSIMD);
+
+   long long tStart = _get_time_us();
+   for( int i=0; i<TEST_FRAMES; i++ )
+      _render_osd_frame(&fbg, &fontImg, i);
+   return (double)(_get_time_us() - tStart) / 1000.0 / TEST_FRAMES;
+}
+
+// Runs each kernel on random spans (all lengths, unaligned offsets) with and without SIMD
+static int _test_spans()
+{
+   static u8 destRef[TEST_SPAN_MAX*4+16];
+   static u8 destTest[TEST_SPAN_MAX*4+16];
+   static u8 src[TEST_SPAN_MAX*4+16];
+   int iErrors = 0;
+
+   for( int iRun=0; iRun<4000; iRun++ )
+   {
+      int iKernel = iRun % 5;
+      int iCount = rand() % TEST_SPAN_MAX;
+      int iOffset = 4 * (rand() % 4);
+      u8 color[4] = { (u8)rand(), (u8)rand(), (u8)rand(), (u8)rand() };
+      u8 mix[4] = { (u8)rand(), (u8)rand(), (u8)rand(), (u8)rand() };
+      if ( iRun & 8 )
+         mix[0] = mix[1] = mix[2] = mix[3] = 255;
+      u8 uAlpha = (iRun & 16)?((iRun & 32)?0:255):(u8)rand();
+      for( int i=0; i<(int)sizeof(src); i++ )
+      {
+         src[i] = rand();
+         destRef[i] = rand();
+      }
+      memcpy(destTest, destRef, sizeof(destRef));
+
+      for( int iSIMD=0; iSIMD<2; iSIMD++ )
+      {
+         u8* pDest = (iSIMD?destTest:destRef) + iOffset;
+         render_kernels_enable_simd(iSIMD);
+         switch ( iKernel )
+         {
+            case 0: render_kernels_fill_span(pDest, iCount, color); break;
+            case 1: render_kernels_blend_color_span(pDest, iCount, color, uAlpha); break;
+            case 2: render_kernels_blend_src_mix_span(pDest, src + iOffset, iCount, mix, iRun & 1); break;
+            case 3: render_kernels_copy_src_mix_span(pDest, src + iOffset, iCount, mix, 120); break;
+            case 4: render_kernels_blend_src_span(pDest, src + iOffset, iCount); break;
+         }
+      }
+      if ( 0 != memcmp(destRef, destTest, sizeof(destRef)) )
+      {
+         if ( iErrors < 10 )
+            printf("Mismatch: kernel %d, %d pixels, offset %d\n", iKernel, iCount, iOffset);
+         iErrors++;
+      }
+   }
+   return iErrors;
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("test_render_kernels");
+   log_disable();
+   srand(1234);
+   _build_font_atlas();
+
+   printf("\nTesting render span kernels (SIMD: %s)\n", render_kernels_get_simd_name());
+   int iSpanErrors = _test_spans();
+   printf("Spans: %d mismatches\n", iSpanErrors);
+
+   _run_frames(0, s_FrameScalar);
+   double fScalarMs = _run_frames(0, s_FrameScalar);
+   _run_frames(1, s_FrameSIMD);
+   double fSIMDMs = _run_frames(1, s_FrameSIMD);
+   int iFrameMismatch = (0 != memcmp(s_FrameScalar, s_FrameSIMD, sizeof(s_FrameScalar)));
+   render_kernels_enable_simd(1);
+
+   printf("OSD frame %dx%d: scalar %.2f ms/frame, %s %.2f ms/frame (x%.2f), output %s\n",
+      TEST_WIDTH, TEST_HEIGHT, fScalarMs, render_kernels_get_simd_name(), fSIMDMs,
+      (fSIMDMs > 0.0)?(fScalarMs/fSIMDMs):0.0, iFrameMismatch?"differs":"identical");
+
+   int iFailed = (0 != iSpanErrors) || iFrameMismatch;
+   printf("\n%s\n", iFailed?"FAIL":"PASS");
+   return iFailed?1:0;
+}
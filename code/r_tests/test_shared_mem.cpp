@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../base/base.h"
+#include "../base/shared_mem.h"
+
+// Checks the seqlock protected shared memory snapshots: a writer process keeps publishing
+// a large struct where all the words have the same value; the reader counts the torn copies
+// it gets with a plain memcpy and with shared_mem_read_if_changed().
+
+#define TEST_SHARED_MEM_NAME "/TEST_SHARED_MEM_SEQLOCK"
+#define TEST_WORDS 4096
+#define TEST_DURATION_MS 1500
+
+typedef struct
+{
+   u32 uValues[TEST_WORDS];
+} t_test_shared_struct;
+
+static t_test_shared_struct s_Local;
+
+static long long _get_time_ms()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (long long)t.tv_sec * 1000LL + t.tv_nsec/1000000;
+}
+
+static int _is_consistent(const t_test_shared_struct* pStruct)
+{
+   for( int i=1; i<TEST_WORDS; i++ )
+      if ( pStruct->uValues[i] != pStruct->uValues[0] )
+         return 0;
+   return 1;
+}
+
+static void _run_writer(t_test_shared_struct* pShared, int iUseSeqLock)
+{
+   t_test_shared_struct* pLocal = (t_test_shared_struct*) malloc(sizeof(t_test_shared_struct));
+   long long tEnd = _get_time_ms() + TEST_DURATION_MS + 200;
+   u32 uValue = 1;
+   while ( _get_time_ms() < tEnd )
+   {
+      for( int i=0; i<TEST_WORDS; i++ )
+         pLocal->uValues[i] = uValue;
+      if ( iUseSeqLock )
+         shared_mem_publish(pShared, pLocal, sizeof(t_test_shared_struct));
+      else
+         memcpy(pShared, pLocal, sizeof(t_test_shared_struct));
+      uValue++;
+      if ( 0 == (uValue % 16) )
+         hardware_sleep_micros(200);
+   }
+   free(pLocal);
+}
+
+// Returns the number of torn snapshots seen by the reader
+static int _run_test(int iUseSeqLock, int* piCopies, int* piSkipped)
+{
+   t_test_shared_struct* pShared = (t_test_shared_struct*) open_shared_mem_for_write(TEST_SHARED_MEM_NAME, sizeof(t_test_shared_struct));
+   if ( NULL == pShared )
+      return -1;
+
+   pid_t pid = fork();
+   if ( 0 == pid )
+   {
+      _run_writer(pShared, iUseSeqLock);
+      _exit(0);
+   }
+
+   const t_test_shared_struct* pRead = (const t_test_shared_struct*) open_shared_mem_for_read(TEST_SHARED_MEM_NAME, sizeof(t_test_shared_struct));
+   int iTorn = 0;
+   u32 uSequence = 0;
+   *piCopies = 0;
+   *piSkipped = 0;
+   hardware_sleep_ms(50);
+   long long tEnd = _get_time_ms() + TEST_DURATION_MS;
+   while ( _get_time_ms() < tEnd )
+   {
+      if ( iUseSeqLock )
+      {
+         int iRes = shared_mem_read_if_changed(&s_Local, pRead, sizeof(t_test_shared_struct), &uSequence);
+         if ( 0 == iRes )
+         {
+            (*piSkipped)++;
+            continue;
+         }
+         // A failed read must leave the previous snapshot in place
+         if ( iRes < 0 )
+         {
+            if ( ! _is_consistent(&s_Local) )
+               iTorn++;
+            continue;
+         }
+      }
+      else
+         memcpy(&s_Local, pRead, sizeof(t_test_shared_struct));
+      (*piCopies)++;
+      if ( ! _is_consistent(&s_Local) )
+         iTorn++;
+   }
+   waitpid(pid, NULL, 0);
+   close_shared_mem((void*)pRead, sizeof(t_test_shared_struct));
+   close_shared_mem(pShared, sizeof(t_test_shared_struct));
+   shm_unlink(TEST_SHARED_MEM_NAME);
+   return iTorn;
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("test_shared_mem");
+   log_disable();
+   int iCopies = 0;
+   int iSkipped = 0;
+
+   printf("\nTesting shared memory snapshots (%d bytes struct)\n", (int)sizeof(t_test_shared_struct));
+   int iTornPlain = _run_test(0, &iCopies, &iSkipped);
+   printf("memcpy:  %d copies, %d torn\n", iCopies, iTornPlain);
+   int iTornSeqLock = _run_test(1, &iCopies, &iSkipped);
+   printf("seqlock: %d copies, %d unchanged (not copied), %d torn\n", iCopies, iSkipped, iTornSeqLock);
+
+   int iFailed = (0 != iTornSeqLock) || (iCopies == 0);
+   printf("\n%s\n", iFailed?"FAIL":"PASS");
+   return iFailed?1:0;
+}
@@ -0,0 +1,138 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Checks the startup task graph (base/startup_timeline.h): dependencies are respected,
+// independent tasks run concurrently, the parallelism limit is honored and the timeline waterfall is logged.
+
+#include <pthread.h>
+#include "../base/base.h"
+#include "../base/startup_timeline.h"
+
+static int s_iFailed = 0;
+
+static void _check(int iCondition, const char* szName)
+{
+   printf("%s: %s\n", iCondition?"ok  ":"FAIL", szName);
+   if ( ! iCondition )
+      s_iFailed++;
+}
+
+typedef struct
+{
+   int iSleepMs;
+   u32 uTimeStart;
+   u32 uTimeEnd;
+} t_test_task;
+
+static int s_iRunningNow = 0;
+static int s_iRunningMax = 0;
+static pthread_mutex_t s_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void _test_task(void* pArg)
+{
+   t_test_task* pTask = (t_test_task*)pArg;
+   pthread_mutex_lock(&s_Mutex);
+   s_iRunningNow++;
+   if ( s_iRunningNow > s_iRunningMax )
+      s_iRunningMax = s_iRunningNow;
+   pthread_mutex_unlock(&s_Mutex);
+
+   pTask->uTimeStart = get_current_timestamp_ms();
+   hardware_sleep_ms(pTask->iSleepMs);
+   pTask->uTimeEnd = get_current_timestamp_ms();
+
+   pthread_mutex_lock(&s_Mutex);
+   s_iRunningNow--;
+   pthread_mutex_unlock(&s_Mutex);
+}
+
+static u32 _run_graph(t_test_task* pTasks, int iMaxParallel, int* piCountRun)
+{
+   t_startup_graph graph;
+   startup_graph_init(&graph);
+   // 0, 1, 2 independent; 3 after 0 and 1; 4 after 3
+   int iT0 = startup_graph_add_task(&graph, "task 0", _test_task, &pTasks[0], 0);
+   int iT1 = startup_graph_add_task(&graph, "task 1", _test_task, &pTasks[1], 0);
+   startup_graph_add_task(&graph, "task 2", _test_task, &pTasks[2], 0);
+   int iT3 = startup_graph_add_task(&graph, "task 3", _test_task, &pTasks[3], (1<<iT0) | (1<<iT1));
+   startup_graph_add_task(&graph, "task 4", _test_task, &pTasks[4], 1<<iT3);
+
+   s_iRunningMax = 0;
+   u32 uTimeStart = get_current_timestamp_ms();
+   *piCountRun = startup_graph_run(&graph, iMaxParallel);
+   return get_current_timestamp_ms() - uTimeStart;
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestStartupTimeline");
+   log_disable();
+
+   startup_timeline_init("test_startup_timeline");
+   int iPhase = startup_timeline_begin("graph");
+
+   t_test_task tasks[5];
+   memset(tasks, 0, sizeof(tasks));
+   for( int i=0; i<5; i++ )
+      tasks[i].iSleepMs = 100;
+
+   int iCountRun = 0;
+   u32 uDuration = _run_graph(tasks, STARTUP_GRAPH_MAX_TASKS, &iCountRun);
+   _check(iCountRun == 5, "all tasks run");
+   _check(tasks[3].uTimeStart >= tasks[0].uTimeEnd && tasks[3].uTimeStart >= tasks[1].uTimeEnd, "task runs after its dependencies");
+   _check(tasks[4].uTimeStart >= tasks[3].uTimeEnd, "dependency chain is respected");
+   _check(s_iRunningMax == 3, "independent tasks run concurrently");
+   // Critical path is 3 tasks long
+   _check(uDuration < 450, "graph duration is the critical path, not the sum of the tasks");
+   printf("graph duration: %u ms (sum of tasks: 500 ms)\n", uDuration);
+   startup_timeline_end(iPhase);
+
+   iPhase = startup_timeline_begin("graph serial");
+   memset(tasks, 0, sizeof(tasks));
+   for( int i=0; i<5; i++ )
+      tasks[i].iSleepMs = 20;
+   _run_graph(tasks, 1, &iCountRun);
+   _check(iCountRun == 5, "all tasks run with no parallelism");
+   _check(s_iRunningMax == 1, "parallelism limit is honored");
+   startup_timeline_end(iPhase);
+
+   t_startup_graph graph;
+   startup_graph_init(&graph);
+   _check(-1 == startup_graph_add_task(&graph, "forward dependency", _test_task, &tasks[0], 1<<1), "forward dependencies are rejected");
+   _check(0 == startup_graph_run(&graph, 4), "empty graph runs nothing");
+
+   startup_timeline_log_waterfall();
+   _check(startup_timeline_get_elapsed_ms() >= 300, "timeline elapsed time");
+
+   printf("%s\n", s_iFailed?"FAILED":"PASSED");
+   return s_iFailed?1:0;
+}
@@ -0,0 +1,496 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../base/base.h"
+#include "../base/models.h"
+#include "../base/parse_fc_telemetry.h"
+#include "../r_vehicle/shared_vars.h"
+#include "../r_vehicle/timers.h"
+#include "../r_vehicle/telemetry.h"
+#include "../r_vehicle/telemetry_msp.h"
+#include "../../mavlink/common/mavlink.h"
+
+// Replays a recorded FC serial capture through telemetry_on_new_serial_data(), the same entry
+// point telemetry_try_read_serial_port() uses on the vehicle, and reports the parsing throughput,
+// the per message type decode cost and the resulting FC and Ruby telemetry contents.
+//
+// Usage: test_telemetry_replay capture [-mavlink|-ltm|-msp] [-realtime] [-baud N] [-byteparser]
+//
+// Capture formats (by file extension):
+//   .tlog   MAVLink telemetry log: records of 8 bytes big endian time (microseconds) + one MAVLink frame
+//   .rcap   timestamped serial reads: records of u32 time (ms) + u16 length + data, little endian
+//   other   raw serial dump, read timing is derived from the baud rate (-baud, default 115200)
+// The telemetry type is detected from the data unless given on the command line.
+
+#define REPLAY_MAX_READ_SIZE 1023
+#define REPLAY_READ_INTERVAL_MS 2 // same as the select() timeout used when reading the serial port
+#define REPLAY_TYPE_STATS_REPEAT 5
+#define REPLAY_MAX_TYPES 1024
+
+// Symbols ruby_tx_telemetry provides to the telemetry modules
+
+t_packet_header_ruby_telemetry_extended_v4 sPHRTE;
+int s_fIPCToRouter = -1;
+long int home_lat = 0;
+long int home_lon = 0;
+bool home_set = false;
+t_packet_header_rc_info_downstream* s_pPHDownstreamInfoRC = NULL;
+
+bool isRadioLinksInitInProgress()
+{
+   return false;
+}
+
+void broadcast_vehicle_stats()
+{
+}
+
+void save_model()
+{
+}
+
+typedef struct
+{
+   u32 uTimeMs;
+   int iOffset;
+   int iLength;
+} t_replay_read;
+
+typedef struct
+{
+   u32 uTypeId;
+   int iCount;
+   double fSeconds;
+} t_replay_type_stats;
+
+static u8* s_pCapture = NULL;
+static int s_iCaptureLength = 0;
+static t_replay_read* s_pReads = NULL;
+static int s_iReadsCount = 0;
+
+static t_replay_type_stats s_TypeStats[REPLAY_MAX_TYPES];
+static int s_iTypeStatsCount = 0;
+
+static double _get_time_sec()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (double)t.tv_sec + (double)t.tv_nsec / 1000000000.0;
+}
+
+static bool _has_extension(const char* szFile, const char* szExt)
+{
+   int iLen = strlen(szFile);
+   int iExtLen = strlen(szExt);
+   return (iLen > iExtLen) && (0 == strcasecmp(szFile + iLen - iExtLen, szExt));
+}
+
+// Returns the length of the frame at pData (or -1 if there is no frame start there) and its type
+static int _get_frame(int iTelemetryType, const u8* pData, int iAvailable, u32* puTypeId)
+{
+   if ( iTelemetryType == TELEMETRY_TYPE_MAVLINK )
+   {
+      if ( (iAvailable >= 6) && (pData[0] == MAVLINK_STX_MAVLINK1) )
+      {
+         *puTypeId = pData[5];
+         return MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1 + pData[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+      }
+      if ( (iAvailable >= 10) && (pData[0] == MAVLINK_STX) )
+      {
+         *puTypeId = ((u32)pData[7]) | (((u32)pData[8]) << 8) | (((u32)pData[9]) << 16);
+         int iLength = MAVLINK_CORE_HEADER_LEN + 1 + pData[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+         if ( pData[2] & MAVLINK_IFLAG_SIGNED )
+            iLength += MAVLINK_SIGNATURE_BLOCK_LEN;
+         return iLength;
+      }
+      return -1;
+   }
+
+   if ( iTelemetryType == TELEMETRY_TYPE_LTM )
+   {
+      if ( (iAvailable < 3) || (pData[0] != '$') || (pData[1] != 'T') )
+         return -1;
+      *puTypeId = pData[2];
+      switch ( pData[2] )
+      {
+         case 'G': return 18;
+         case 'O': return 18;
+         case 'S': return 11;
+         case 'A':
+         case 'N':
+         case 'X': return 10;
+      }
+      return -1;
+   }
+
+   if ( iTelemetryType == TELEMETRY_TYPE_MSP )
+   {
+      if ( (iAvailable < 5) || (pData[0] != '$') || (pData[1] != 'M') || ((pData[2] != '>') && (pData[2] != '<')) )
+         return -1;
+      *puTypeId = pData[4];
+      return 6 + pData[3];
+   }
+   return -1;
+}
+
+static int _detect_telemetry_type()
+{
+   int iCounts[3] = { 0, 0, 0 };
+   int iTypes[3] = { TELEMETRY_TYPE_MAVLINK, TELEMETRY_TYPE_LTM, TELEMETRY_TYPE_MSP };
+   int iBest = 0;
+   for( int i=0; i<3; i++ )
+   {
+      int iPos = 0;
+      while ( (iPos < s_iCaptureLength) && (iPos < 64*1024) )
+      {
+         u32 uType = 0;
+         int iLength = _get_frame(iTypes[i], &s_pCapture[iPos], s_iCaptureLength - iPos, &uType);
+         if ( iLength > 0 )
+         {
+            iCounts[i]++;
+            iPos += iLength;
+         }
+         else
+            iPos++;
+      }
+      if ( iCounts[i] > iCounts[iBest] )
+         iBest = i;
+   }
+   return iTypes[iBest];
+}
+
+static void _add_read(u32 uTimeMs, int iOffset, int iLength)
+{
+   // Reads closer than the serial read interval are merged, as the serial driver would return them in one read
+   if ( s_iReadsCount > 0 )
+   {
+      t_replay_read* pLast = &s_pReads[s_iReadsCount-1];
+      if ( (uTimeMs < pLast->uTimeMs + REPLAY_READ_INTERVAL_MS) && (pLast->iOffset + pLast->iLength == iOffset) &&
+           (pLast->iLength + iLength <= REPLAY_MAX_READ_SIZE) )
+      {
+         pLast->iLength += iLength;
+         return;
+      }
+   }
+   s_pReads[s_iReadsCount].uTimeMs = uTimeMs;
+   s_pReads[s_iReadsCount].iOffset = iOffset;
+   s_pReads[s_iReadsCount].iLength = iLength;
+   s_iReadsCount++;
+}
+
+static bool _load_capture(const char* szFile, int iBaudRate)
+{
+   FILE* fd = fopen(szFile, "rb");
+   if ( NULL == fd )
+      return false;
+   fseek(fd, 0, SEEK_END);
+   long lSize = ftell(fd);
+   fseek(fd, 0, SEEK_SET);
+   u8* pFile = (u8*) malloc(lSize+1);
+   if ( (lSize <= 0) || (NULL == pFile) || (lSize != (long)fread(pFile, 1, lSize, fd)) )
+   {
+      fclose(fd);
+      free(pFile);
+      return false;
+   }
+   fclose(fd);
+
+   s_pCapture = (u8*) malloc(lSize);
+   s_pReads = (t_replay_read*) malloc(sizeof(t_replay_read) * (lSize/2 + 1));
+   s_iCaptureLength = 0;
+   s_iReadsCount = 0;
+
+   if ( _has_extension(szFile, ".tlog") )
+   {
+      unsigned long long uFirstTime = 0;
+      long lPos = 0;
+      while ( lPos + 8 < lSize )
+      {
+         unsigned long long uTime = 0;
+         for( int i=0; i<8; i++ )
+            uTime = (uTime << 8) | pFile[lPos+i];
+         u32 uType = 0;
+         int iLength = _get_frame(TELEMETRY_TYPE_MAVLINK, &pFile[lPos+8], lSize - lPos - 8, &uType);
+         if ( (iLength < 0) || (lPos + 8 + iLength > lSize) )
+            break;
+         if ( 0 == uFirstTime )
+            uFirstTime = uTime;
+         memcpy(&s_pCapture[s_iCaptureLength], &pFile[lPos+8], iLength);
+         _add_read((u32)((uTime - uFirstTime)/1000), s_iCaptureLength, iLength);
+         s_iCaptureLength += iLength;
+         lPos += 8 + iLength;
+      }
+   }
+   else if ( _has_extension(szFile, ".rcap") )
+   {
+      u32 uFirstTime = 0;
+      long lPos = 0;
+      while ( lPos + 6 <= lSize )
+      {
+         u32 uTime = ((u32)pFile[lPos]) | (((u32)pFile[lPos+1]) << 8) | (((u32)pFile[lPos+2]) << 16) | (((u32)pFile[lPos+3]) << 24);
+         int iLength = ((int)pFile[lPos+4]) | (((int)pFile[lPos+5]) << 8);
+         if ( lPos + 6 + iLength > lSize )
+            break;
+         if ( 0 == lPos )
+            uFirstTime = uTime;
+         memcpy(&s_pCapture[s_iCaptureLength], &pFile[lPos+6], iLength);
+         _add_read(uTime - uFirstTime, s_iCaptureLength, iLength);
+         s_iCaptureLength += iLength;
+         lPos += 6 + iLength;
+      }
+   }
+   else
+   {
+      memcpy(s_pCapture, pFile, lSize);
+      s_iCaptureLength = lSize;
+      int iBytesPerRead = (iBaudRate/10) * REPLAY_READ_INTERVAL_MS / 1000;
+      if ( iBytesPerRead < 1 )
+         iBytesPerRead = 1;
+      if ( iBytesPerRead > REPLAY_MAX_READ_SIZE )
+         iBytesPerRead = REPLAY_MAX_READ_SIZE;
+      for( int iPos = 0; iPos < s_iCaptureLength; iPos += iBytesPerRead )
+      {
+         int iLength = iBytesPerRead;
+         if ( iPos + iLength > s_iCaptureLength )
+            iLength = s_iCaptureLength - iPos;
+         s_pReads[s_iReadsCount].uTimeMs = (u32)(((long long)iPos) * 10000LL / iBaudRate);
+         s_pReads[s_iReadsCount].iOffset = iPos;
+         s_pReads[s_iReadsCount].iLength = iLength;
+         s_iReadsCount++;
+      }
+   }
+   free(pFile);
+   return (s_iCaptureLength > 0) && (s_iReadsCount > 0);
+}
+
+static void _reset_telemetry_state()
+{
+   telemetry_init();
+   memset(&sPHRTE, 0, sizeof(sPHRTE));
+   sPHRTE.uplink_rc_rssi = 255;
+   sPHRTE.uplink_mavlink_rc_rssi = 255;
+   sPHRTE.uplink_mavlink_rx_rssi = 255;
+   parse_telemetry_init(g_pCurrentModel->telemetry_params.vehicle_mavlink_id, false);
+   parse_telemetry_allow_any_sysid((g_pCurrentModel->telemetry_params.flags & TELEMETRY_FLAGS_ALLOW_ANY_VEHICLE_SYSID)?1:0);
+   telemetry_msp_on_open_port(-1);
+}
+
+static t_replay_type_stats* _get_type_stats(u32 uTypeId)
+{
+   for( int i=0; i<s_iTypeStatsCount; i++ )
+      if ( s_TypeStats[i].uTypeId == uTypeId )
+         return &s_TypeStats[i];
+   if ( s_iTypeStatsCount >= REPLAY_MAX_TYPES )
+      return NULL;
+   memset(&s_TypeStats[s_iTypeStatsCount], 0, sizeof(t_replay_type_stats));
+   s_TypeStats[s_iTypeStatsCount].uTypeId = uTypeId;
+   return &s_TypeStats[s_iTypeStatsCount++];
+}
+
+static int _compare_type_stats(const void* pA, const void* pB)
+{
+   double fA = ((const t_replay_type_stats*)pA)->fSeconds;
+   double fB = ((const t_replay_type_stats*)pB)->fSeconds;
+   return (fA < fB) ? 1 : ((fA > fB) ? -1 : 0);
+}
+
+// Feeds the capture one frame at a time and attributes the time spent to the frame type.
+// Bytes that are not part of a frame (line noise) are fed and timed as type 0xFFFFFFFF.
+static int _measure_types(int iTelemetryType)
+{
+   int iFrames = 0;
+   s_iTypeStatsCount = 0;
+   for( int iRun=0; iRun<REPLAY_TYPE_STATS_REPEAT; iRun++ )
+   {
+      _reset_telemetry_state();
+      int iPos = 0;
+      while ( iPos < s_iCaptureLength )
+      {
+         u32 uType = 0xFFFFFFFF;
+         int iLength = _get_frame(iTelemetryType, &s_pCapture[iPos], s_iCaptureLength - iPos, &uType);
+         if ( (iLength < 0) || (iPos + iLength > s_iCaptureLength) )
+         {
+            iLength = 1;
+            uType = 0xFFFFFFFF;
+         }
+         else if ( 0 == iRun )
+            iFrames++;
+
+         double fStart = _get_time_sec();
+         telemetry_on_new_serial_data(&s_pCapture[iPos], iLength);
+         double fTime = _get_time_sec() - fStart;
+
+         t_replay_type_stats* pStats = _get_type_stats(uType);
+         if ( NULL != pStats )
+         {
+            if ( 0 == iRun )
+               pStats->iCount++;
+            pStats->fSeconds += fTime / REPLAY_TYPE_STATS_REPEAT;
+         }
+         iPos += iLength;
+      }
+   }
+   return iFrames;
+}
+
+static void _print_type_stats(int iTelemetryType, double fDurationSec)
+{
+   qsort(s_TypeStats, s_iTypeStatsCount, sizeof(t_replay_type_stats), _compare_type_stats);
+   double fTotal = 0.0;
+   for( int i=0; i<s_iTypeStatsCount; i++ )
+      fTotal += s_TypeStats[i].fSeconds;
+
+   printf("\nDecode cost per message type (one frame per call, including the call overhead):\n");
+   printf("   %-10s %8s %8s %10s %8s %6s\n", "type", "count", "msg/s", "total ms", "ns/msg", "%");
+   for( int i=0; i<s_iTypeStatsCount; i++ )
+   {
+      t_replay_type_stats* pStats = &s_TypeStats[i];
+      char szType[32];
+      if ( pStats->uTypeId == 0xFFFFFFFF )
+         strcpy(szType, "noise");
+      else if ( iTelemetryType == TELEMETRY_TYPE_LTM )
+         snprintf(szType, sizeof(szType), "%c", (char)pStats->uTypeId);
+      else
+         snprintf(szType, sizeof(szType), "%u", pStats->uTypeId);
+      printf("   %-10s %8d %8.1f %10.3f %8.0f %6.1f\n", szType, pStats->iCount,
+         (double)pStats->iCount / fDurationSec, pStats->fSeconds * 1000.0,
+         (pStats->iCount > 0) ? (pStats->fSeconds * 1000000000.0 / pStats->iCount) : 0.0,
+         (fTotal > 0.0) ? (100.0 * pStats->fSeconds / fTotal) : 0.0);
+   }
+}
+
+static void _print_telemetry(const t_packet_header_fc_telemetry* pFC, const t_packet_header_ruby_telemetry_extended_v4* pRTE)
+{
+   printf("\nFC telemetry (t_packet_header_fc_telemetry):\n");
+   printf("   flags: 0x%02X, flight mode: 0x%02X, throttle: %d%%\n", pFC->uFCFlags, pFC->flight_mode, pFC->throttle);
+   printf("   voltage: %.3f V, current: %.3f A, mAh: %d\n", pFC->voltage/1000.0, pFC->current/1000.0, pFC->mah);
+   printf("   altitude: %.2f m, abs: %.2f m, vspeed: %.2f m/s, hspeed: %.2f m/s, aspeed: %.2f m/s\n",
+      ((double)pFC->altitude-100000.0)/100.0, ((double)pFC->altitude_abs-100000.0)/100.0,
+      ((double)pFC->vspeed-100000.0)/100.0, ((double)pFC->hspeed-100000.0)/100.0, ((double)pFC->aspeed-100000.0)/100.0);
+   printf("   roll: %.2f, pitch: %.2f, heading: %d\n", pFC->roll/100.0 - 180.0, pFC->pitch/100.0 - 180.0, pFC->heading);
+   printf("   GPS: fix %d, %d sats, hdop %.2f, lat %.7f, lon %.7f\n", pFC->gps_fix_type, pFC->satelites, pFC->hdop/100.0, pFC->latitude/10000000.0, pFC->longitude/10000000.0);
+   printf("   temperature: %d C, RC RSSI: %d\n", (int)pFC->temperatureC - 100, pFC->rc_rssi);
+   printf("   extra info:");
+   for( int i=0; i<(int)sizeof(pFC->extra_info); i++ )
+      printf(" %d", pFC->extra_info[i]);
+   printf("\n");
+
+   printf("Ruby telemetry (t_packet_header_ruby_telemetry_extended_v4):\n");
+   printf("   Ruby flags: 0x%04X, MAVLink RC RSSI: %d, MAVLink RX RSSI: %d\n", pRTE->uRubyFlags, pRTE->uplink_mavlink_rc_rssi, pRTE->uplink_mavlink_rx_rssi);
+   printf("   heartbeats: %d, sys status: %d, GPS info: %s, flight mode: %s\n", get_heartbeat_msg_count(), get_system_msg_count(),
+      has_received_gps_info()?"yes":"no", has_received_flight_mode()?"yes":"no");
+   if ( NULL != get_last_message() )
+      printf("   last FC message: %s\n", get_last_message());
+}
+
+int main(int argc, char *argv[])
+{
+   if ( argc < 2 )
+   {
+      printf("\nUsage: test_telemetry_replay capture [-mavlink|-ltm|-msp] [-realtime] [-baud N] [-byteparser]\n");
+      printf("   capture: .tlog MAVLink log, .rcap timestamped serial reads or raw serial dump\n");
+      return 0;
+   }
+
+   log_init("test_telemetry_replay");
+   log_disable();
+
+   int iTelemetryType = -1;
+   int iBaudRate = 115200;
+   bool bRealTime = false;
+   for( int i=2; i<argc; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-mavlink") )
+         iTelemetryType = TELEMETRY_TYPE_MAVLINK;
+      else if ( 0 == strcmp(argv[i], "-ltm") )
+         iTelemetryType = TELEMETRY_TYPE_LTM;
+      else if ( 0 == strcmp(argv[i], "-msp") )
+         iTelemetryType = TELEMETRY_TYPE_MSP;
+      else if ( 0 == strcmp(argv[i], "-realtime") )
+         bRealTime = true;
+      else if ( 0 == strcmp(argv[i], "-byteparser") )
+         parse_telemetry_use_mavlink_frame_scanner(false);
+      else if ( (0 == strcmp(argv[i], "-baud")) && (i < argc-1) )
+      {
+         iBaudRate = atoi(argv[i+1]);
+         if ( iBaudRate < 1200 )
+            iBaudRate = 1200;
+         i++;
+      }
+   }
+
+   if ( ! _load_capture(argv[1], iBaudRate) )
+   {
+      printf("Failed to load capture %s\n", argv[1]);
+      return 1;
+   }
+   if ( _has_extension(argv[1], ".tlog") )
+      iTelemetryType = TELEMETRY_TYPE_MAVLINK;
+   if ( iTelemetryType < 0 )
+      iTelemetryType = _detect_telemetry_type();
+
+   // Telemetry defaults of a new model; no raw telemetry forwarding to the controller
+   Model model;
+   model.vehicle_type = MODEL_TYPE_DRONE;
+   model.telemetry_params.fc_telemetry_type = iTelemetryType;
+   model.telemetry_params.vehicle_mavlink_id = DEFAULT_MAVLINK_SYS_ID_VEHICLE;
+   model.telemetry_params.flags = TELEMETRY_FLAGS_RXTX | TELEMETRY_FLAGS_ALLOW_ANY_VEHICLE_SYSID;
+   model.telemetry_params.bControllerHasInputTelemetry = false;
+   model.telemetry_params.bControllerHasOutputTelemetry = false;
+   g_pCurrentModel = &model;
+   g_bRouterReady = false;
+
+   double fDurationSec = (s_pReads[s_iReadsCount-1].uTimeMs + REPLAY_READ_INTERVAL_MS) / 1000.0;
+   const char* szType = (iTelemetryType == TELEMETRY_TYPE_MAVLINK)?"MAVLink":((iTelemetryType == TELEMETRY_TYPE_LTM)?"LTM":"MSP");
+   printf("\nReplaying %s: %s, %d bytes in %d serial reads, %.1f seconds recorded (%.0f bytes/s)\n",
+      argv[1], szType, s_iCaptureLength, s_iReadsCount, fDurationSec, s_iCaptureLength / fDurationSec);
+
+   // Replay in the recorded serial reads
+
+   _reset_telemetry_state();
+   u32 uStartTime = get_current_timestamp_ms();
+   int iReadsWithMessages = 0;
+   double fParseTime = 0.0;
+   double fWallStart = _get_time_sec();
+   for( int i=0; i<s_iReadsCount; i++ )
+   {
+      if ( bRealTime )
+      {
+         u32 uNow = get_current_timestamp_ms();
+         if ( uNow < uStartTime + s_pReads[i].uTimeMs )
+            hardware_sleep_ms(uStartTime + s_pReads[i].uTimeMs - uNow);
+         g_TimeNow = get_current_timestamp_ms();
+      }
+      else
+         g_TimeNow = uStartTime + s_pReads[i].uTimeMs;
+
+      double fStart = _get_time_sec();
+      if ( telemetry_on_new_serial_data(&s_pCapture[s_pReads[i].iOffset], s_pReads[i].iLength) )
+         iReadsWithMessages++;
+      fParseTime += _get_time_sec() - fStart;
+   }
+   double fWallTime = _get_time_sec() - fWallStart;
+
+   t_packet_header_fc_telemetry resultFC;
+   t_packet_header_ruby_telemetry_extended_v4 resultRTE;
+   memcpy(&resultFC, telemetry_get_fc_telemetry_header(), sizeof(resultFC));
+   memcpy(&resultRTE, &sPHRTE, sizeof(resultRTE));
+   _print_telemetry(&resultFC, &resultRTE);
+
+   int iFrames = _measure_types(iTelemetryType);
+
+   printf("\nReplay (%s): %.1f ms wall time, %.3f ms spent parsing\n", bRealTime?"recorded speed":"as fast as possible", fWallTime*1000.0, fParseTime*1000.0);
+   printf("   %.1f bytes/s and %.1f messages/s recorded, %d of %d reads had new messages\n",
+      s_iCaptureLength / fDurationSec, iFrames / fDurationSec, iReadsWithMessages, s_iReadsCount);
+   printf("   parsing throughput: %.2f MB/s, %.0f ns per message, %.1f us of CPU per second of telemetry\n",
+      s_iCaptureLength / fParseTime / (1024.0*1024.0), (iFrames > 0)?(fParseTime*1000000000.0/iFrames):0.0, fParseTime*1000000.0/fDurationSec);
+
+   _print_type_stats(iTelemetryType, fDurationSec);
+
+   free(s_pCapture);
+   free(s_pReads);
+   return 0;
+}
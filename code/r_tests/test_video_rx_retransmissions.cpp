@@ -0,0 +1,138 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Checks the video retransmissions scheduler (r_station/video_rx_retransmissions.h):
+// deadline ordering of the min-heap, roundtrip estimation and retry timeouts.
+
+#include "../base/base.h"
+#include "../r_station/video_rx_retransmissions.h"
+
+static int s_iFailed = 0;
+
+static void _check(int iCondition, const char* szName)
+{
+   printf("%s: %s\n", iCondition?"ok  ":"FAIL", szName);
+   if ( ! iCondition )
+      s_iFailed++;
+}
+
+static VideoRxRetransmissionsScheduler s_Scheduler;
+
+int main(int argc, char *argv[])
+{
+   log_init("TestVideoRxRetransmissions");
+   log_disable();
+   srand(1234);
+
+   type_retr_scheduler_entry entry;
+
+   // Ordering
+   int iCountEntries = RETR_SCHEDULER_MAX_ENTRIES;
+   for( int i=0; i<iCountEntries; i++ )
+      s_Scheduler.addEntry(rand()%200, rand()%MAX_TOTAL_PACKETS_IN_BLOCK, 1000 + rand()%500, 0);
+   _check(iCountEntries == s_Scheduler.getEntriesCount(), "entries added");
+   _check(! s_Scheduler.popDueEntry(999, &entry), "nothing due before first deadline");
+
+   int iCountPopped = 0;
+   int iOrderOk = 1;
+   type_retr_scheduler_entry prevEntry;
+   memset(&prevEntry, 0, sizeof(prevEntry));
+   while ( s_Scheduler.popDueEntry(1500, &entry) )
+   {
+      if ( iCountPopped > 0 )
+      {
+         if ( entry.uDeadline < prevEntry.uDeadline )
+            iOrderOk = 0;
+         if ( (entry.uDeadline == prevEntry.uDeadline) && (entry.uVideoBlockIndex < prevEntry.uVideoBlockIndex) )
+            iOrderOk = 0;
+      }
+      prevEntry = entry;
+      iCountPopped++;
+   }
+   _check(iOrderOk, "popped in deadline order, older blocks first");
+   _check(iCountEntries == iCountPopped, "all due entries popped");
+   _check(MAX_U32 == s_Scheduler.getNextDeadline(), "empty after pop");
+
+   // Only due entries are popped
+   s_Scheduler.addEntry(10, 3, 200, 0);
+   s_Scheduler.addEntry(11, 1, 100, 0);
+   s_Scheduler.addEntry(10, 2, 100, 1);
+   _check(100 == s_Scheduler.getNextDeadline(), "next deadline");
+   _check(s_Scheduler.popDueEntry(150, &entry) && (10 == entry.uVideoBlockIndex) && (2 == entry.uPacketIndex) && (1 == entry.uRequestCount), "first due entry");
+   _check(s_Scheduler.popDueEntry(150, &entry) && (11 == entry.uVideoBlockIndex), "second due entry");
+   _check(! s_Scheduler.popDueEntry(150, &entry), "not due entry kept");
+   s_Scheduler.reset();
+   _check(0 == s_Scheduler.getEntriesCount(), "reset");
+
+   // Capacity
+   for( int i=0; i<RETR_SCHEDULER_MAX_ENTRIES; i++ )
+      s_Scheduler.addEntry(i, 0, i, 0);
+   _check(! s_Scheduler.addEntry(0, 0, 0, 0), "full scheduler rejects entries");
+   _check(1 == s_Scheduler.getDroppedEntriesCount(), "dropped entries counted");
+   s_Scheduler.reset();
+
+   // Roundtrip estimation and retry timeouts
+   s_Scheduler.setTimeoutLimits(10, 60);
+   _check(! s_Scheduler.hasRoundtripSamples(), "no roundtrip samples");
+   _check(40 == s_Scheduler.getRetryTimeout(1), "retry timeout without samples");
+
+   s_Scheduler.addRoundtripSample(8);
+   _check((8 == s_Scheduler.getSmoothedRoundtrip()) && (4 == s_Scheduler.getRoundtripVariation()), "first roundtrip sample");
+   _check(24 == s_Scheduler.getRetryTimeout(1), "retry timeout after first sample");
+
+   for( int i=0; i<100; i++ )
+      s_Scheduler.addRoundtripSample(6);
+   _check(6 == s_Scheduler.getSmoothedRoundtrip(), "smoothed roundtrip converges");
+   _check(0 == s_Scheduler.getRoundtripVariation(), "roundtrip variation converges");
+   _check(10 == s_Scheduler.getRetryTimeout(1), "retry timeout clamped to min");
+
+   for( int i=0; i<20; i++ )
+      s_Scheduler.addRoundtripSample((i%2)?4:16);
+   u32 uTimeout = s_Scheduler.getRetryTimeout(1);
+   _check((uTimeout > s_Scheduler.getSmoothedRoundtrip() + 10) && (uTimeout <= 60), "retry timeout covers jitter");
+   _check(s_Scheduler.getRetryTimeout(2) == ((2*uTimeout > 60)?60:2*uTimeout), "retry backoff");
+   _check(60 == s_Scheduler.getRetryTimeout(10), "retry timeout clamped to max");
+
+   s_Scheduler.resetRoundtripEstimate();
+   _check(! s_Scheduler.hasRoundtripSamples(), "roundtrip estimate reset");
+
+   // Timing
+   u32 uTimeMicros = get_current_timestamp_micros();
+   for( int i=0; i<100000; i++ )
+      if ( ! s_Scheduler.addEntry(rand()%200, rand()%MAX_TOTAL_PACKETS_IN_BLOCK, rand()%100000, 0) )
+         while ( s_Scheduler.popDueEntry(MAX_U32, &entry) );
+   while ( s_Scheduler.popDueEntry(MAX_U32, &entry) );
+   printf("add+pop: %.3f us per entry\n", (float)(get_current_timestamp_micros() - uTimeMicros)/100000.0);
+
+   printf("%s\n", s_iFailed?"FAILED":"PASSED");
+   return s_iFailed?1:0;
+}
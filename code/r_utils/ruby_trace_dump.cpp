@@ -0,0 +1,213 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Dumps the binary trace rings of the Ruby processes to Chrome trace-event JSON.
+// Usage: ruby_trace_dump [-o output.json] [process_name ...]
+// Open the output in chrome://tracing or ui.perfetto.dev
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../base/base.h"
+#include "../base/config_file_names.h"
+#include "../base/trace.h"
+
+static const char* s_szDefaultProcesses[] = { "ruby_rt_vehicle", "ruby_rt_station" };
+
+static t_trace_record s_RecordsCopy[TRACE_RING_RECORDS];
+static int s_iCountOutputEvents = 0;
+
+static void _output_event(FILE* fd, const char* szName, char cPhase, uint64_t uTimeMicros, u32 uPid, u32 uTid, u16 uEventId, const u32* pArgs)
+{
+   fprintf(fd, "%s\n{\"name\":\"%s\",\"cat\":\"ruby\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":%u,\"tid\":%u",
+      (s_iCountOutputEvents > 0)?",":"", szName, cPhase, (unsigned long long)uTimeMicros, uPid, uTid);
+   if ( cPhase == TRACE_PHASE_INSTANT )
+      fprintf(fd, ",\"s\":\"t\"");
+   fprintf(fd, ",\"args\":{");
+   int iCountArgs = 0;
+   for( int i=0; i<3; i++ )
+   {
+      const char* szArg = trace_get_event_arg_name(uEventId, i);
+      if ( NULL == szArg )
+         continue;
+      fprintf(fd, "%s\"%s\":%u", (iCountArgs > 0)?",":"", szArg, pArgs[i]);
+      iCountArgs++;
+   }
+   fprintf(fd, "}}");
+   s_iCountOutputEvents++;
+}
+
+static void _output_metadata(FILE* fd, const char* szMetaName, u32 uPid, u32 uTid, const char* szValue)
+{
+   fprintf(fd, "%s\n{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+      (s_iCountOutputEvents > 0)?",":"", szMetaName, uPid, uTid, szValue);
+   s_iCountOutputEvents++;
+}
+
+// Returns the number of records written
+static int _dump_thread_ring(FILE* fd, const t_trace_thread_ring* pRing, u32 uPid)
+{
+   // Snapshot the ring; records older than (write pos after copy - ring size) may have been overwritten while copying
+   u32 uPosStart = __atomic_load_n(&pRing->uWritePos, __ATOMIC_ACQUIRE);
+   memcpy(s_RecordsCopy, (const void*)pRing->records, sizeof(s_RecordsCopy));
+   u32 uPosEnd = __atomic_load_n(&pRing->uWritePos, __ATOMIC_ACQUIRE);
+
+   u32 uFirst = 0;
+   if ( uPosEnd >= TRACE_RING_RECORDS )
+      uFirst = uPosEnd - TRACE_RING_RECORDS + 1;
+
+   char szThreadName[32];
+   snprintf(szThreadName, sizeof(szThreadName), "%s (%u)", pRing->szThreadName, pRing->uThreadId);
+   _output_metadata(fd, "thread_name", uPid, pRing->uThreadId, szThreadName);
+
+   int iCount = 0;
+   int iDepth = 0;
+   for( u32 uPos = uFirst; uPos < uPosStart; uPos++ )
+   {
+      const t_trace_record* pRecord = &s_RecordsCopy[uPos & (TRACE_RING_RECORDS-1)];
+      // Drop end events whose begin was already overwritten
+      if ( pRecord->uPhase == TRACE_PHASE_END )
+      {
+         if ( 0 == iDepth )
+            continue;
+         iDepth--;
+      }
+      else if ( pRecord->uPhase == TRACE_PHASE_BEGIN )
+         iDepth++;
+      _output_event(fd, trace_get_event_name(pRecord->uEventId), (char)pRecord->uPhase, pRecord->uTimeMicros, uPid, pRing->uThreadId, pRecord->uEventId, pRecord->uArgs);
+      iCount++;
+   }
+   return iCount;
+}
+
+static int _dump_process(FILE* fd, const char* szProcessName)
+{
+   char szName[128];
+   snprintf(szName, sizeof(szName), "%s%s", SHARED_MEM_TRACE_PREFIX, szProcessName);
+
+   int fdMem = shm_open(szName, O_RDONLY, 0);
+   if ( fdMem < 0 )
+   {
+      fprintf(stderr, "No trace found for %s (is %s%s present?)\n", szProcessName, FOLDER_CONFIG, TRACE_ENABLE_FLAG);
+      return 0;
+   }
+   struct stat st;
+   if ( (0 != fstat(fdMem, &st)) || (st.st_size < (off_t)sizeof(t_trace_shared_mem)) )
+   {
+      fprintf(stderr, "Invalid trace memory for %s\n", szProcessName);
+      close(fdMem);
+      return 0;
+   }
+   const t_trace_shared_mem* pMem = (const t_trace_shared_mem*) mmap(NULL, sizeof(t_trace_shared_mem), PROT_READ, MAP_SHARED, fdMem, 0);
+   close(fdMem);
+   if ( pMem == MAP_FAILED )
+   {
+      fprintf(stderr, "Failed to map trace memory for %s\n", szProcessName);
+      return 0;
+   }
+   if ( (pMem->uMagic != TRACE_SHM_MAGIC) || (pMem->uVersion != TRACE_SHM_VERSION) )
+   {
+      fprintf(stderr, "Trace memory for %s has an unknown format (magic %X, version %u)\n", szProcessName, pMem->uMagic, pMem->uVersion);
+      munmap((void*)pMem, sizeof(t_trace_shared_mem));
+      return 0;
+   }
+
+   _output_metadata(fd, "process_name", pMem->uProcessId, 0, szProcessName);
+   u32 uThreads = pMem->uThreadsCount;
+   if ( uThreads > TRACE_MAX_THREADS )
+      uThreads = TRACE_MAX_THREADS;
+   int iTotal = 0;
+   for( u32 u=0; u<uThreads; u++ )
+   {
+      int iCount = _dump_thread_ring(fd, &pMem->threads[u], pMem->uProcessId);
+      fprintf(stderr, "%s, thread %s (%u): %d records\n", szProcessName, pMem->threads[u].szThreadName, pMem->threads[u].uThreadId, iCount);
+      iTotal += iCount;
+   }
+   munmap((void*)pMem, sizeof(t_trace_shared_mem));
+   return iTotal;
+}
+
+int main(int argc, char *argv[])
+{
+   const char* szOutputFile = NULL;
+   const char* szProcesses[32];
+   int iCountProcesses = 0;
+
+   for( int i=1; i<argc; i++ )
+   {
+      if ( (0 == strcmp(argv[i], "-o")) && (i < argc-1) )
+      {
+         szOutputFile = argv[++i];
+         continue;
+      }
+      if ( (0 == strcmp(argv[i], "-h")) || (0 == strcmp(argv[i], "-help")) )
+      {
+         printf("Usage: ruby_trace_dump [-o output.json] [process_name ...]\n");
+         printf("Tracing is enabled for the processes started while %s%s exists.\n", FOLDER_CONFIG, TRACE_ENABLE_FLAG);
+         return 0;
+      }
+      if ( iCountProcesses < 32 )
+         szProcesses[iCountProcesses++] = argv[i];
+   }
+   if ( 0 == iCountProcesses )
+   {
+      for( unsigned int i=0; i<sizeof(s_szDefaultProcesses)/sizeof(s_szDefaultProcesses[0]); i++ )
+         szProcesses[iCountProcesses++] = s_szDefaultProcesses[i];
+   }
+
+   FILE* fd = stdout;
+   if ( NULL != szOutputFile )
+   {
+      fd = fopen(szOutputFile, "w");
+      if ( NULL == fd )
+      {
+         fprintf(stderr, "Failed to create output file %s\n", szOutputFile);
+         return -1;
+      }
+   }
+
+   fprintf(fd, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+   int iTotal = 0;
+   for( int i=0; i<iCountProcesses; i++ )
+      iTotal += _dump_process(fd, szProcesses[i]);
+   fprintf(fd, "\n]}\n");
+
+   if ( fd != stdout )
+      fclose(fd);
+   fprintf(stderr, "Dumped %d trace records.\n", iTotal);
+   return 0;
+}
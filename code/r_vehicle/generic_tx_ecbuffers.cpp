@@ -35,6 +35,7 @@
 #include "../base/models.h"
 #include "../base/utils.h"
 #include "../radio/fec.h" 
+#include "../base/trace.h"
 #include "shared_vars.h"
 #include "generic_tx_ecbuffers.h"
 #include "timers.h"
@@ -148,7 +149,9 @@ void GenericTxECBuffers::_computeECDataOnCurrentBlock()
    for(u32 u=0; u<m_uBlockECPackets; u++ )
       m_p_ec_ec_packets[u] = &(m_pBlocks[m_iTopBufferIndex].pPackets[u + m_uBlockDataPackets]->uPacketData[0]);
 
+   TRACE_BEGIN(TRACE_EVENT_FEC_ENCODE, m_uBlockDataPackets, m_uBlockECPackets, m_iBlockPacketLength);
    fec_encode(m_iBlockPacketLength, m_p_ec_data_packets, (unsigned int)m_uBlockDataPackets, m_p_ec_ec_packets, (unsigned int)m_uBlockECPackets);
+   TRACE_END(TRACE_EVENT_FEC_ENCODE, m_uBlockDataPackets, m_uBlockECPackets, m_iBlockPacketLength);
    
    for(u32 u=0; u<m_uBlockECPackets; u++ )
    {
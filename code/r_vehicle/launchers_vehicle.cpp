@@ -36,6 +36,7 @@
 #include "../base/hardware_i2c.h"
 #include "../base/hardware_cam_maj.h"
 #include "../base/hw_procs.h"
+#include "../base/hw_sys.h"
 #include "../base/radio_utils.h"
 #include <math.h>
 #include <semaphore.h>
@@ -318,16 +319,7 @@ static void * _thread_adjust_affinities_vehicle(void *argument)
       iSelfId = 0;
    if ( s_iCPUCoresCount < 1 )
    {
-      s_iCPUCoresCount = 1;
-      char szOutput[128];
-      hw_execute_bash_command_raw("nproc --all", szOutput);
-      if ( 1 != sscanf(szOutput, "%d", &s_iCPUCoresCount) )
-      {
-         log_softerror_and_alarm("Failed to get CPU cores count. No affinity adjustments for processes to be done.");
-         s_bThreadBgAffinitiesStarted = false;
-         s_iCPUCoresCount = 1;
-         return NULL;    
-      }
+      s_iCPUCoresCount = hw_sys_get_cpu_cores_count();
    }
 
    if ( s_iCPUCoresCount < 2 || s_iCPUCoresCount > 32 )
@@ -531,7 +531,11 @@ bool _send_packet_to_wifi_radio_interface(int iLocalRadioLinkId, int iRadioInter
    }
   */ 
 
-   int totalLength = radio_build_new_raw_ieee_packet(iLocalRadioLinkId, s_RadioRawPacket, pPacketData, nPacketLength, RADIO_PORT_ROUTER_DOWNLINK, be);
+   // When tx batching is active, build the raw frame directly into the interface's batch slot (no extra copy)
+   u8* pRawPacket = radio_tx_batch_get_frame_buffer(iRadioInterfaceIndex);
+   if ( NULL == pRawPacket )
+      pRawPacket = s_RadioRawPacket;
+   int totalLength = radio_build_new_raw_ieee_packet(iLocalRadioLinkId, pRawPacket, pPacketData, nPacketLength, RADIO_PORT_ROUTER_DOWNLINK, be);
    u32 microT1 = get_current_timestamp_micros();
 
    if ( iDidSetTempFlags )
@@ -547,7 +551,7 @@ bool _send_packet_to_wifi_radio_interface(int iLocalRadioLinkId, int iRadioInter
         (pPH->packet_type == PACKET_TYPE_VIDEO_SWITCH_TO_ADAPTIVE_VIDEO_LEVEL_ACK) )
       iRepeatCount++;
 
-   if ( radio_write_raw_ieee_packet(iRadioInterfaceIndex, s_RadioRawPacket, totalLength, iRepeatCount) )
+   if ( radio_write_raw_ieee_packet(iRadioInterfaceIndex, pRawPacket, totalLength, iRepeatCount) )
    {       
       u32 microT2 = get_current_timestamp_micros();
       if ( microT2 > microT1 )
@@ -569,6 +573,26 @@ bool _send_packet_to_wifi_radio_interface(int iLocalRadioLinkId, int iRadioInter
    return false;
 }
 
+// Submits all the radio packets accumulated since radio_tx_batch_begin(), one syscall per radio interface
+
+void send_batched_packets_to_radio_interfaces()
+{
+   for( int i=0; i<hardware_get_radio_interfaces_count(); i++ )
+   {
+      u32 microT1 = get_current_timestamp_micros();
+      int iSent = radio_tx_batch_flush(i);
+      if ( iSent <= 0 )
+         continue;
+      u32 microT2 = get_current_timestamp_micros();
+      if ( microT2 > microT1 )
+      {
+         g_RadioTxTimers.aTmpInterfacesTxTotalTimeMicros[i] += microT2 - microT1;
+         g_RadioTxTimers.aTmpInterfacesTxVideoTimeMicros[i] += microT2 - microT1;
+      }
+   }
+   radio_tx_batch_end();
+}
+
 // Sends a radio packet to all posible radio interfaces or just to a single radio link
 
 int send_packet_to_radio_interfaces(u8* pPacketData, int nPacketLength, int iSendToSingleRadioLink)
@@ -36,6 +36,7 @@
 #include "../base/config.h"
 #include "../base/models.h"
 #include "../base/hw_procs.h"
+#include "../base/hw_sys.h"
 #ifdef HW_PLATFORM_RASPBERRY
 #include "../base/hardware_i2c.h"
 #endif
@@ -210,8 +211,7 @@ int _check_reinit_sik_interfaces()
             fclose(fd);
          }
          log_line("SiK radio configuration completed. Result: %d.", iResult);
-         sprintf(szFile, "rm -rf %s%s", FOLDER_RUBY_TEMP, FILE_TEMP_SIK_CONFIG_FINISHED);
-         hw_execute_bash_command(szFile, NULL);
+         unlink(szFile);
          g_SiKRadiosState.bConfiguringToolInProgress = false;
          reopen_marked_sik_interfaces();
          send_alarm_to_controller(ALARM_ID_GENERIC_STATUS_UPDATE, ALARM_FLAG_GENERIC_STATUS_RECONFIGURED_RADIO_INTERFACE, 0, 10);
@@ -1095,9 +1095,12 @@ void _process_local_notification_model_changed(t_packet_header* pPH, int changeT
             saveCurrentModel();
          }
       }
+      spm((g_pCurrentModel->enc_flags & MODEL_ENC_FLAG_USE_AEAD)?ENC_PP_MODE_AEAD:ENC_PP_MODE_XOR);
       bMustSignalOtherComponents = false;
    }
 
+   radio_links_update_tx_batching();
+
    // Signal other components about the model change
 
    if ( bMustSignalOtherComponents )
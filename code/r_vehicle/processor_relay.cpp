@@ -140,8 +140,13 @@ void relay_process_received_radio_packet_from_relayed_vehicle(int iRadioLink, in
    if ( NULL != s_pRelayRxInfoStats )
       pRxInfoStats = (type_uplink_rx_info_stats*)(((u32*)s_pRelayRxInfoStats) + iRadioInterfaceIndex * sizeof(type_uplink_rx_info_stats));
 
+   // The rx thread already decrypted and checked the packets. Anything past them (the AEAD salt and tag) is not forwarded.
+   int iAuthenticatedLength = radio_packets_get_authenticated_length(pBufferData, iBufferLength);
+   if ( iAuthenticatedLength <= 0 )
+      return;
+
    u8* pData = pBufferData;
-   int nRemainingLength = iBufferLength;
+   int nRemainingLength = iAuthenticatedLength;
    int iCountReceivedPackets = 0;
    bool bIsFullComposedPacketOkToForward = true;
    bool bPacketContainsDataToForward = false;
@@ -153,11 +158,6 @@ void relay_process_received_radio_packet_from_relayed_vehicle(int iRadioLink, in
       iTotalLength = pPH->total_length;
       uPacketType = pPH->packet_type;
       uPacketFlags = pPH->packet_flags;
-      int bCRCOk = 0;
-      int iPacketLength = packet_process_and_check(iRadioInterfaceIndex, pData, nRemainingLength, &bCRCOk);
-
-      if ( iPacketLength <= 0 )
-         return;
 
       if ( uVehicleIdSrc != g_pCurrentModel->relay_params.uRelayedVehicleId )
       {
@@ -224,7 +224,7 @@ void relay_process_received_radio_packet_from_relayed_vehicle(int iRadioLink, in
       return;
 
    // Forward the full composed packet to the controller
-   relay_send_packet_to_controller(pBufferData, iBufferLength);
+   relay_send_packet_to_controller(pBufferData, iAuthenticatedLength);
 }
 
 
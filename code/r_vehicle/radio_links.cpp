@@ -258,10 +258,25 @@ int radio_links_open_rxtx_radio_interfaces()
    }
    log_line("OPENING INTERFACES END ============================================================");
 
+   radio_links_update_tx_batching();
    g_pCurrentModel->logVehicleRadioInfo();
    return 0;
 }
 
+// Batched tx can be turned off for each radio interface from the radio interface settings
+void radio_links_update_tx_batching()
+{
+   if ( NULL == g_pCurrentModel )
+      return;
+   for( int i=0; i<hardware_get_radio_interfaces_count(); i++ )
+   {
+      if ( g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[i] & RADIO_HW_CAPABILITY_FLAG_NO_TX_BATCHING )
+         radio_set_tx_batching(i, 0);
+      else
+         radio_set_tx_batching(i, DEFAULT_RADIO_TX_BATCHING);
+   }
+}
+
 
 void radio_links_close_rxtx_radio_interfaces()
 {
@@ -5,4 +5,5 @@
 
 int radio_links_open_rxtx_radio_interfaces();
 void radio_links_close_rxtx_radio_interfaces();
+void radio_links_update_tx_batching();
 bool radio_links_apply_settings(Model* pModel, int iRadioLink, type_radio_links_parameters* pRadioLinkParamsOld, type_radio_links_parameters* pRadioLinkParamsNew);
@@ -57,11 +57,13 @@
 #include "../base/config.h"
 #include "../base/commands.h"
 #include "../base/hw_procs.h"
+#include "../base/hw_sys.h"
 #include "../base/models.h"
 #include "../base/models_list.h"
 #include "../base/radio_utils.h"
 #include "../base/encr.h"
 #include "../base/ruby_ipc.h"
+#include "../base/trace.h"
 #include "../base/camera_utils.h"
 #include "../base/vehicle_settings.h"
 #include "../base/vehicle_rt_info.h"
@@ -556,6 +558,7 @@ void reinit_radio_interfaces()
    hardware_sleep_ms(100);
    hardware_reset_radio_enumerated_flag();
    hardware_enumerate_radio_interfaces();
+   radio_duplicate_detection_update_radio_interfaces();
 
    log_line("=================================================================");
    log_line("Detected hardware radio interfaces:");
@@ -799,7 +802,7 @@ void _synchronize_shared_mems()
       update_shared_mem_video_frames_stats( &g_VideoInfoStatsCameraOutput, g_TimeNow);
 
       if ( NULL != g_pSM_VideoInfoStatsCameraOutput )
-         memcpy((u8*)g_pSM_VideoInfoStatsCameraOutput, (u8*)&g_VideoInfoStatsCameraOutput, sizeof(shared_mem_video_frames_stats));
+         shared_mem_publish(g_pSM_VideoInfoStatsCameraOutput, &g_VideoInfoStatsCameraOutput, sizeof(shared_mem_video_frames_stats));
       else
       {
         g_pSM_VideoInfoStatsCameraOutput = shared_mem_video_frames_stats_open_for_write();
@@ -818,7 +821,7 @@ void _synchronize_shared_mems()
       update_shared_mem_video_frames_stats( &g_VideoInfoStatsRadioOut, g_TimeNow);
 
       if ( NULL != g_pSM_VideoInfoStatsRadioOut )
-         memcpy((u8*)g_pSM_VideoInfoStatsRadioOut, (u8*)&g_VideoInfoStatsRadioOut, sizeof(shared_mem_video_frames_stats));
+         shared_mem_publish(g_pSM_VideoInfoStatsRadioOut, &g_VideoInfoStatsRadioOut, sizeof(shared_mem_video_frames_stats));
       else
       {
         g_pSM_VideoInfoStatsRadioOut = shared_mem_video_frames_stats_radio_out_open_for_write();
@@ -835,7 +838,7 @@ void _synchronize_shared_mems()
    if ( g_TimeNow >= s_uTimeLastRxHistorySync + 100 )
    {
       s_uTimeLastRxHistorySync = g_TimeNow;
-      memcpy((u8*)g_pSM_HistoryRxStats, (u8*)&g_SM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
+      shared_mem_publish(g_pSM_HistoryRxStats, &g_SM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
    }
 }
 
@@ -1014,6 +1017,8 @@ void _check_loop_consistency(int iStep, u32 uLastTotalTxPackets, u32 uLastTotalT
    if ( NULL != g_pProcessStats )
    if ( g_TimeNow > g_TimeLastSetRadioFlagsCommandReceived + 5000 )
    {
+      g_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+      g_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
       if ( g_pProcessStats->uMaxLoopTimeMs < tTime5 - tTime0 )
          g_pProcessStats->uMaxLoopTimeMs = tTime5 - tTime0;
       g_pProcessStats->uTotalLoopTime += tTime5 - tTime0;
@@ -1145,6 +1150,8 @@ int main(int argc, char *argv[])
 
    log_init("Router");
    log_arguments(argc, argv);
+   log_enable_async();
+   trace_init("ruby_rt_vehicle");
 
    if ( strcmp(argv[argc-1], "test_maj") == 0 )
    {
@@ -1184,6 +1191,7 @@ int main(int argc, char *argv[])
          saveCurrentModel();
       }
    }
+   spm((g_pCurrentModel->enc_flags & MODEL_ENC_FLAG_USE_AEAD)?ENC_PP_MODE_AEAD:ENC_PP_MODE_XOR);
   
    log_line_forced_to_file("Start sequence: Loaded model. Developer flags: live log: %s, enable radio silence failsafe: %s, log only errors: %s, radio config guard interval: %d ms",
          (g_pCurrentModel->uDeveloperFlags & DEVELOPER_FLAGS_BIT_LIVE_LOG)?"yes":"no",
@@ -1201,11 +1209,11 @@ int main(int argc, char *argv[])
 
    #if defined(HW_PLATFORM_OPENIPC_CAMERA)
    log_line("Setting CPU speed for OpenIPC hardware...");
-   hw_execute_bash_command_raw("echo 'performance' | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_governor", NULL);
-   char szComm[256];
-   sprintf(szComm, "echo %d | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_max_freq", g_pCurrentModel->processesPriorities.iFreqARM*1000);
-   hw_execute_bash_command_raw(szComm, NULL);
-   hw_execute_bash_command_raw("echo 700000 | tee /sys/devices/system/cpu/cpu*/cpufreq/scaling_min_freq", NULL);
+   hw_sys_write_cpufreq_all("scaling_governor", "performance");
+   char szFreq[32];
+   sprintf(szFreq, "%d", g_pCurrentModel->processesPriorities.iFreqARM*1000);
+   hw_sys_write_cpufreq_all("scaling_max_freq", szFreq);
+   hw_sys_write_cpufreq_all("scaling_min_freq", "700000");
    #endif
 
    radio_rx_set_custom_thread_priority(g_pCurrentModel->processesPriorities.iThreadPriorityRadioRx);
@@ -1443,6 +1451,7 @@ int main(int argc, char *argv[])
    log_line("Start sequence: Done creating audio processor.");
 
    radio_duplicate_detection_init();
+   radio_duplicate_detection_update_radio_interfaces();
    radio_rx_start_rx_thread(&g_SM_RadioStats, 0, g_pCurrentModel->getVehicleFirmwareType());
    
    send_radio_config_to_controller();
@@ -1524,6 +1533,8 @@ int main(int argc, char *argv[])
    u32 uLastLoopTime = g_TimeNow;
    g_pProcessStats->uLoopTimer1 = g_pProcessStats->uLoopTimer2 = g_TimeNow;
 
+   hw_sys_mark_startup_complete();
+
    while ( !g_bQuit )
    {
       g_TimeNow = get_current_timestamp_ms();
@@ -1826,13 +1837,26 @@ void _main_loop()
    g_pProcessStats->uLoopSubStep = 20;
 
    int iCountConsumedRegPrio = 0;
+   type_received_radio_packet regPrioPackets[50];
+   int iCountRegPrioPackets = 0;
+   int iIndexRegPrioPacket = 0;
    while ( (iCountConsumedRegPrio < 50) && (!g_bQuit) )
    {
       g_pProcessStats->uLoopSubStep = 21;
-      pPacket = radio_rx_wait_get_next_received_reg_prio_packet(200, &iPacketLength, &iPacketIsShort, &iRadioInterfaceIndex);
-      if ( (NULL == pPacket) || g_bQuit )
+      // Drain all the available packets in one wakeup
+      if ( iIndexRegPrioPacket >= iCountRegPrioPackets )
+      {
+         iCountRegPrioPackets = radio_rx_wait_get_next_received_reg_prio_packets(200, regPrioPackets, 50 - iCountConsumedRegPrio);
+         iIndexRegPrioPacket = 0;
+      }
+      if ( (iIndexRegPrioPacket >= iCountRegPrioPackets) || g_bQuit )
          break;
 
+      pPacket = regPrioPackets[iIndexRegPrioPacket].pPacketData;
+      iPacketLength = regPrioPackets[iIndexRegPrioPacket].iPacketLength;
+      iRadioInterfaceIndex = regPrioPackets[iIndexRegPrioPacket].iPacketRxInterface;
+      iIndexRegPrioPacket++;
+
       g_pProcessStats->uLoopSubStep = 22;
 
       iCountConsumedRegPrio++;
@@ -35,6 +35,7 @@
 #include "../radio/radiopackets2.h"
 #include "../base/config.h"
 #include "../base/hw_procs.h"
+#include "../base/hw_sys.h"
 #include "../base/commands.h"
 #include "../base/models.h"
 #include "../base/models_list.h"
@@ -1100,14 +1101,14 @@ bool process_command(u8* pBuffer, int length)
          strcat(szBuffer, "#");
          #endif
 
-         hw_execute_bash_command_raw("cat /proc/device-tree/model", szOutput);
+         hw_sys_read_file("/proc/device-tree/model", szOutput, sizeof(szOutput)/sizeof(szOutput[0]));
          strcat(szBuffer, "CPU: ");
          strcat(szBuffer, szOutput);
          strcat(szBuffer, "#"); 
 
          szOutput[0] = 0;
          #ifdef HW_PLATFORM_RASPBERRY
-         hw_execute_bash_command_raw("cat /proc/cpuinfo | grep 'Revision' | awk '{print $3}'", szOutput);
+         hw_sys_read_key_value("/proc/cpuinfo", "Revision", szOutput, sizeof(szOutput)/sizeof(szOutput[0]));
          strcat(szBuffer, "CPU Id: ");
          strcat(szBuffer, szOutput);
          strcat(szBuffer, "#");
@@ -1574,8 +1575,7 @@ bool process_command(u8* pBuffer, int length)
          g_pProcessStats->lastActiveTime = get_current_timestamp_ms();
       #endif
 
-      hw_execute_bash_command_raw("nproc --all", szOutput);
-      szOutput[strlen(szOutput)-1] = 0;
+      sprintf(szOutput, "%d", hw_sys_get_cpu_cores_count());
       strcat(szBuffer, "CPU Cores: ");
       strcat(szBuffer, szOutput);
       strcat(szBuffer, ", ");
@@ -1655,13 +1655,13 @@ bool process_command(u8* pBuffer, int length)
       strcat(szBuffer, "+");
       #endif
 
-      sprintf(szOutput, "Avg/Max loops (ms): rx_commands: %u/%u;", g_pProcessStats->uAverageLoopTimeMs, g_pProcessStats->uMaxLoopTimeMs);
+      sprintf(szOutput, "Avg/Max loops (ms), startup/steady forks: rx_commands: %u/%u, %u/%u;", g_pProcessStats->uAverageLoopTimeMs, g_pProcessStats->uMaxLoopTimeMs, g_pProcessStats->uForksAtStartup, g_pProcessStats->uForksSteadyState);
       strcat(szBuffer, szOutput);
       shared_mem_process_stats* pProcessStats = NULL;
       pProcessStats = shared_mem_process_stats_open_read(SHARED_MEM_WATCHDOG_ROUTER_TX);
       if ( NULL != pProcessStats )
       {
-         sprintf(szOutput, " router: %u/%u;", pProcessStats->uAverageLoopTimeMs, pProcessStats->uMaxLoopTimeMs);
+         sprintf(szOutput, " router: %u/%u, %u/%u;", pProcessStats->uAverageLoopTimeMs, pProcessStats->uMaxLoopTimeMs, pProcessStats->uForksAtStartup, pProcessStats->uForksSteadyState);
          strcat(szBuffer, szOutput);
          shared_mem_process_stats_close(SHARED_MEM_WATCHDOG_ROUTER_TX, pProcessStats);
       }
@@ -1673,7 +1673,7 @@ bool process_command(u8* pBuffer, int length)
       pProcessStats = shared_mem_process_stats_open_read(SHARED_MEM_WATCHDOG_TELEMETRY_TX);
       if ( NULL != pProcessStats )
       {
-         sprintf(szOutput, " tx_telemetry: %u/%u;", pProcessStats->uAverageLoopTimeMs, pProcessStats->uMaxLoopTimeMs);
+         sprintf(szOutput, " tx_telemetry: %u/%u, %u/%u;", pProcessStats->uAverageLoopTimeMs, pProcessStats->uMaxLoopTimeMs, pProcessStats->uForksAtStartup, pProcessStats->uForksSteadyState);
          strcat(szBuffer, szOutput);
          shared_mem_process_stats_close(SHARED_MEM_WATCHDOG_ROUTER_TX, pProcessStats);
       }
@@ -1685,7 +1685,7 @@ bool process_command(u8* pBuffer, int length)
       pProcessStats = shared_mem_process_stats_open_read(SHARED_MEM_WATCHDOG_RC_RX);
       if ( NULL != pProcessStats )
       {
-         sprintf(szOutput, " rx_rc: %u/%u;", pProcessStats->uAverageLoopTimeMs, pProcessStats->uMaxLoopTimeMs);
+         sprintf(szOutput, " rx_rc: %u/%u, %u/%u;", pProcessStats->uAverageLoopTimeMs, pProcessStats->uMaxLoopTimeMs, pProcessStats->uForksAtStartup, pProcessStats->uForksSteadyState);
          strcat(szBuffer, szOutput);
          shared_mem_process_stats_close(SHARED_MEM_WATCHDOG_ROUTER_TX, pProcessStats);
       }
@@ -3761,9 +3761,12 @@ int r_start_commands_rx(int argc, char* argv[])
  
    int iSleepIntervalMS = 50;
 
+   hw_sys_mark_startup_complete();
+
    while (!g_bQuit) 
    {
-      hardware_sleep_ms(iSleepIntervalMS);
+      // Wakes up as soon as the router sends a message
+      ruby_ipc_wait_for_message(s_fIPCFromRouter, iSleepIntervalMS*1000);
       g_TimeNow = get_current_timestamp_ms();
       u32 tTime0 = g_TimeNow;
 
@@ -3899,6 +3902,8 @@ int r_start_commands_rx(int argc, char* argv[])
       u32 tNow = get_current_timestamp_ms();
       if ( NULL != g_pProcessStats )
       {
+         g_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+         g_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
          if ( g_pProcessStats->uMaxLoopTimeMs < tNow - tTime0 )
             g_pProcessStats->uMaxLoopTimeMs = tNow - tTime0;
          g_pProcessStats->uTotalLoopTime += tNow - tTime0;
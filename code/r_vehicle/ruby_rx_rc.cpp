@@ -35,6 +35,7 @@
 #ifdef HW_PLATFORM_RASPBERRY
 #include "../base/hw_procs.h"
 #endif
+#include "../base/hw_sys.h"
 #include "../base/shared_mem.h"
 #include "../radio/radiolink.h"
 #include "../radio/radiopackets2.h"
@@ -214,9 +215,12 @@ int r_start_rx_rc(int argc, char *argv[])
 
    int iSleepIntervalMS = 50;
 
+   hw_sys_mark_startup_complete();
+
    while (!g_bQuit) 
    {
-      hardware_sleep_ms(iSleepIntervalMS);
+      // Wakes up as soon as the router sends a message
+      ruby_ipc_wait_for_message(s_fIPC_FromRouter, iSleepIntervalMS*1000);
       if ( iSleepIntervalMS < 50 )
          iSleepIntervalMS += 10;
 
@@ -391,6 +395,8 @@ int r_start_rx_rc(int argc, char *argv[])
       u32 tNow = get_current_timestamp_ms();
       if ( NULL != g_pProcessStats )
       {
+         g_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+         g_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
          if ( g_pProcessStats->uMaxLoopTimeMs < tNow - tTime0 )
             g_pProcessStats->uMaxLoopTimeMs = tNow - tTime0;
          g_pProcessStats->uTotalLoopTime += tNow - tTime0;
@@ -54,6 +54,7 @@
 #include "../base/config.h"
 #include "../base/shared_mem.h"
 #include "../base/hw_procs.h"
+#include "../base/hw_sys.h"
 #include "../base/hardware.h"
 #include "../base/hardware_camera.h"
 #include "../base/models.h"
@@ -1605,6 +1606,8 @@ void _main_loop()
    if ( g_pCurrentModel->telemetry_params.fc_telemetry_type == TELEMETRY_TYPE_NONE )
       iSleepTime = 50;
 
+   hw_sys_mark_startup_complete();
+
    while ( !g_bQuit )
    {
       hardware_sleep_ms(iSleepTime);
@@ -1688,6 +1691,8 @@ void _main_loop()
          u32 tNow = get_current_timestamp_ms();
          if ( NULL != g_pProcessStats )
          {
+            g_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+            g_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
             if ( g_pProcessStats->uMaxLoopTimeMs < tNow - tTime0 )
                g_pProcessStats->uMaxLoopTimeMs = tNow - tTime0;
             g_pProcessStats->uTotalLoopTime += tNow - tTime0;
@@ -1707,6 +1712,8 @@ void _main_loop()
       u32 tNow = get_current_timestamp_ms();
       if ( NULL != g_pProcessStats )
       {
+         g_pProcessStats->uForksAtStartup = hw_sys_get_startup_forks_count();
+         g_pProcessStats->uForksSteadyState = hw_sys_get_steady_forks_count();
          if ( g_pProcessStats->uMaxLoopTimeMs < tNow - tTime0 )
             g_pProcessStats->uMaxLoopTimeMs = tNow - tTime0;
          g_pProcessStats->uTotalLoopTime += tNow - tTime0;
@@ -398,23 +398,32 @@ int telemetry_try_read_serial_port()
    if ( length <= 0 )
       return 0;
 
-   s_uRawTelemetryDownloadTotalReadFromSerial += length;
-   s_iFCSerialTelemetryReadBytesTempLastSecond += length;
+   telemetry_on_new_serial_data(s_uTelemetrySerialInBuffer, length);
+   return length;
+}
+
+bool telemetry_on_new_serial_data(u8* pData, int iDataLength)
+{
+   if ( (NULL == g_pCurrentModel) || (NULL == pData) || (iDataLength <= 0) )
+      return false;
+
+   s_uRawTelemetryDownloadTotalReadFromSerial += iDataLength;
+   s_iFCSerialTelemetryReadBytesTempLastSecond += iDataLength;
 
    if ( _telemetry_must_send_raw_telemetry_to_controller() )
-      _telemetry_addSerialDataToFCTelemetryBuffer(s_uTelemetrySerialInBuffer, length);
+      _telemetry_addSerialDataToFCTelemetryBuffer(pData, iDataLength);
 
    bool bNewFCMessage = false;
    if ( g_pCurrentModel->telemetry_params.fc_telemetry_type == TELEMETRY_TYPE_MAVLINK )
-      bNewFCMessage = telemetry_mavlink_on_new_serial_data(s_uTelemetrySerialInBuffer, length);
+      bNewFCMessage = telemetry_mavlink_on_new_serial_data(pData, iDataLength);
    if ( g_pCurrentModel->telemetry_params.fc_telemetry_type == TELEMETRY_TYPE_LTM )
-      bNewFCMessage = telemetry_mavlink_on_new_serial_data(s_uTelemetrySerialInBuffer, length);
+      bNewFCMessage = telemetry_mavlink_on_new_serial_data(pData, iDataLength);
    if ( g_pCurrentModel->telemetry_params.fc_telemetry_type == TELEMETRY_TYPE_MSP )
-      bNewFCMessage = telemetry_msp_on_new_serial_data(s_uTelemetrySerialInBuffer, length);
+      bNewFCMessage = telemetry_msp_on_new_serial_data(pData, iDataLength);
 
    if ( bNewFCMessage )
       s_CountMessagesFromFCPerSecondTemp++;
-   return length;
+   return bNewFCMessage;
 }
 
 void telemetry_periodic_loop()
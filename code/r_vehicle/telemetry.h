@@ -14,6 +14,8 @@ void telemetry_reset_time_last_telemetry_received();
 int telemetry_get_serial_port_file();
 
 int telemetry_try_read_serial_port();
+// Processes data read from the FC serial port; also used to replay serial captures
+bool telemetry_on_new_serial_data(u8* pData, int iDataLength);
 void telemetry_periodic_loop();
 
 t_packet_header_fc_telemetry* telemetry_get_fc_telemetry_header();
@@ -38,6 +38,7 @@
 #include "../common/string_utils.h"
 #include "../base/hardware_cam_maj.h"
 #include "../radio/fec.h"
+#include "../base/trace.h"
 #include "adaptive_video.h"
 #include "processor_tx_video.h"
 #include "processor_relay.h"
@@ -89,6 +90,10 @@ VideoTxPacketsBuffer::VideoTxPacketsBuffer(int iVideoStreamIndex, int iCameraInd
    m_iNextBufferIndexToFill = 0;
    m_iNextBufferPacketIndexToFill = 0;
    m_iCountReadyToSend = 0;
+   m_iECAccumulatedRows = 0;
+   m_iECAccumulatedDataPackets = 0;
+   m_iECAccumulatedBlockDataPackets = 0;
+   m_uECAccumulatedPacketSize = 0;
 
    m_uNextVideoBlockIndexToGenerate = 0;
    m_uNextVideoBlockPacketIndexToGenerate = 0;
@@ -135,6 +140,7 @@ bool VideoTxPacketsBuffer::init(Model* pModel)
       return false;
    }
    log_line("[VideoTXBuffer] Initialize video Tx buffer instance number %d.", m_iInstanceIndex+1);
+   log_line("[VideoTXBuffer] Using %s kernels for FEC encoding.", fec_get_acceleration_name());
 
    m_uNextVideoBlockIndexToGenerate = 0;
    m_uNextVideoBlockPacketIndexToGenerate = 0;
@@ -594,6 +600,8 @@ void VideoTxPacketsBuffer::_addNewVideoPacket(u8* pRawVideoData, int iRawVideoDa
    if ( iSizeToZero > 0 )
       memset(pVideoDestination, 0, iSizeToZero);
 
+   _addPacketToECAccumulators(m_iNextBufferIndexToFill, m_iNextBufferPacketIndexToFill);
+
    // Update state
    m_iNextBufferPacketIndexToFill++;
    m_uNextVideoBlockPacketIndexToGenerate++;
@@ -602,39 +610,9 @@ void VideoTxPacketsBuffer::_addNewVideoPacket(u8* pRawVideoData, int iRawVideoDa
    if ( m_uNextVideoBlockPacketIndexToGenerate >= pCurrentVideoPacketHeader->uCurrentBlockDataPackets )
    if ( pCurrentVideoPacketHeader->uCurrentBlockECPackets > 0 )
    {
-      // Compute EC packets
-      u8* p_fec_data_packets[MAX_DATA_PACKETS_IN_BLOCK];
-      u8* p_fec_data_fecs[MAX_FECS_PACKETS_IN_BLOCK];
+      _computeECPackets(m_iNextBufferIndexToFill, pCurrentVideoPacketHeader);
 
-      for( int i=0; i<pCurrentVideoPacketHeader->uCurrentBlockDataPackets; i++ )
-      {
-         _checkAllocatePacket(m_iNextBufferIndexToFill, i);
-         p_fec_data_packets[i] = m_VideoPackets[m_iNextBufferIndexToFill][i].pVideoData;
-      }
       int iECDelta = pCurrentVideoPacketHeader->uCurrentBlockDataPackets;
-      for( int i=0; i<pCurrentVideoPacketHeader->uCurrentBlockECPackets; i++ )
-      {
-         _checkAllocatePacket(m_iNextBufferIndexToFill, i+iECDelta);
-         p_fec_data_fecs[i] = m_VideoPackets[m_iNextBufferIndexToFill][i+iECDelta].pVideoData;
-      }
-
-      u32 tTemp = get_current_timestamp_micros();
-      fec_encode(pCurrentVideoPacketHeader->uCurrentBlockPacketSize, p_fec_data_packets, pCurrentVideoPacketHeader->uCurrentBlockDataPackets, p_fec_data_fecs, pCurrentVideoPacketHeader->uCurrentBlockECPackets);
-      tTemp = get_current_timestamp_micros() - tTemp;
-      s_uTimeTotalFecTimeMicroSec += tTemp;
-      if ( 0 == s_uLastTimeFecCalculation )
-      {
-         s_uTimeFecMicroPerSec = 0;
-         s_uTimeTotalFecTimeMicroSec = 0;
-         s_uLastTimeFecCalculation = g_TimeNow;
-      }
-      else if ( g_TimeNow >= s_uLastTimeFecCalculation + 250 )
-      {
-         s_uTimeFecMicroPerSec = 4 * s_uTimeTotalFecTimeMicroSec;
-         s_uTimeTotalFecTimeMicroSec = 0;
-         s_uLastTimeFecCalculation = g_TimeNow;
-      }
-
       int iECDataSize = pCurrentVideoPacketHeader->uCurrentBlockPacketSize - sizeof(t_packet_header_video_segment_important);
 
       for( int i=0; i<pCurrentVideoPacketHeader->uCurrentBlockECPackets; i++ )
@@ -671,6 +649,105 @@ void VideoTxPacketsBuffer::_addNewVideoPacket(u8* pRawVideoData, int iRawVideoDa
    }
 }
 
+// Folds the video data of a new data packet into the EC packets of the current block,
+// so that the EC packets are ready as soon as the last data packet of the block is added.
+// The video important header is not folded here, as it can still change (end of frame flags)
+// until the block is complete. It's added in _computeECPackets.
+void VideoTxPacketsBuffer::_addPacketToECAccumulators(int iBufferIndex, int iPacketIndex)
+{
+   if ( 0 == iPacketIndex )
+   {
+      m_iECAccumulatedRows = m_PacketHeaderVideo.uCurrentBlockECPackets;
+      m_iECAccumulatedBlockDataPackets = m_PacketHeaderVideo.uCurrentBlockDataPackets;
+      m_iECAccumulatedDataPackets = 0;
+      m_uECAccumulatedPacketSize = m_PacketHeaderVideo.uCurrentBlockPacketSize;
+   }
+   if ( (m_iECAccumulatedRows <= 0) || (iPacketIndex != m_iECAccumulatedDataPackets) )
+      return;
+   if ( m_uECAccumulatedPacketSize <= sizeof(t_packet_header_video_segment_important) )
+      return;
+
+   u8* p_fec_data_fecs[MAX_FECS_PACKETS_IN_BLOCK];
+   for( int i=0; i<m_iECAccumulatedRows; i++ )
+   {
+      _checkAllocatePacket(iBufferIndex, i+m_iECAccumulatedBlockDataPackets);
+      p_fec_data_fecs[i] = m_VideoPackets[iBufferIndex][i+m_iECAccumulatedBlockDataPackets].pVideoData + sizeof(t_packet_header_video_segment_important);
+   }
+
+   u32 tTemp = get_current_timestamp_micros();
+   TRACE_BEGIN(TRACE_EVENT_FEC_ENCODE_ADD, iPacketIndex, m_iECAccumulatedRows, m_uECAccumulatedPacketSize);
+   fec_encode_add_data_block(m_uECAccumulatedPacketSize - sizeof(t_packet_header_video_segment_important),
+      m_VideoPackets[iBufferIndex][iPacketIndex].pVideoData + sizeof(t_packet_header_video_segment_important),
+      (unsigned int)iPacketIndex, p_fec_data_fecs, (unsigned int)m_iECAccumulatedRows);
+   TRACE_END(TRACE_EVENT_FEC_ENCODE_ADD, iPacketIndex, m_iECAccumulatedRows, m_uECAccumulatedPacketSize);
+   s_uTimeTotalFecTimeMicroSec += get_current_timestamp_micros() - tTemp;
+   m_iECAccumulatedDataPackets++;
+}
+
+void VideoTxPacketsBuffer::_computeECPackets(int iBufferIndex, t_packet_header_video_segment* pCurrentVideoPacketHeader)
+{
+   int iDataPackets = pCurrentVideoPacketHeader->uCurrentBlockDataPackets;
+   int iECPackets = pCurrentVideoPacketHeader->uCurrentBlockECPackets;
+   u8* p_fec_data_packets[MAX_DATA_PACKETS_IN_BLOCK];
+   u8* p_fec_data_fecs[MAX_FECS_PACKETS_IN_BLOCK];
+
+   u32 tTemp = get_current_timestamp_micros();
+   TRACE_BEGIN(TRACE_EVENT_FEC_ENCODE, iDataPackets, iECPackets, pCurrentVideoPacketHeader->uCurrentBlockPacketSize);
+
+   // All data packets folded in already? (the block can be shorter than when it was started)
+   if ( (m_iECAccumulatedDataPackets == iDataPackets) && (iECPackets <= m_iECAccumulatedRows) &&
+        (m_uECAccumulatedPacketSize == pCurrentVideoPacketHeader->uCurrentBlockPacketSize) &&
+        (iDataPackets <= m_iECAccumulatedBlockDataPackets) )
+   {
+      // Short block: move the accumulated EC packets right after the last data packet
+      if ( iDataPackets < m_iECAccumulatedBlockDataPackets )
+      for( int i=0; i<iECPackets; i++ )
+      {
+         type_tx_video_packet_info tmp = m_VideoPackets[iBufferIndex][iDataPackets+i];
+         m_VideoPackets[iBufferIndex][iDataPackets+i] = m_VideoPackets[iBufferIndex][m_iECAccumulatedBlockDataPackets+i];
+         m_VideoPackets[iBufferIndex][m_iECAccumulatedBlockDataPackets+i] = tmp;
+      }
+      for( int i=0; i<iECPackets; i++ )
+         p_fec_data_fecs[i] = m_VideoPackets[iBufferIndex][i+iDataPackets].pVideoData;
+
+      // Add the video important headers
+      for( int i=0; i<iDataPackets; i++ )
+         fec_encode_add_data_block(sizeof(t_packet_header_video_segment_important), m_VideoPackets[iBufferIndex][i].pVideoData, (unsigned int)i, p_fec_data_fecs, (unsigned int)iECPackets);
+   }
+   else
+   {
+      for( int i=0; i<iDataPackets; i++ )
+      {
+         _checkAllocatePacket(iBufferIndex, i);
+         p_fec_data_packets[i] = m_VideoPackets[iBufferIndex][i].pVideoData;
+      }
+      for( int i=0; i<iECPackets; i++ )
+      {
+         _checkAllocatePacket(iBufferIndex, i+iDataPackets);
+         p_fec_data_fecs[i] = m_VideoPackets[iBufferIndex][i+iDataPackets].pVideoData;
+      }
+      fec_encode(pCurrentVideoPacketHeader->uCurrentBlockPacketSize, p_fec_data_packets, iDataPackets, p_fec_data_fecs, iECPackets);
+   }
+   m_iECAccumulatedRows = 0;
+   m_iECAccumulatedDataPackets = 0;
+   TRACE_END(TRACE_EVENT_FEC_ENCODE, iDataPackets, iECPackets, pCurrentVideoPacketHeader->uCurrentBlockPacketSize);
+
+   tTemp = get_current_timestamp_micros() - tTemp;
+   s_uTimeTotalFecTimeMicroSec += tTemp;
+   if ( 0 == s_uLastTimeFecCalculation )
+   {
+      s_uTimeFecMicroPerSec = 0;
+      s_uTimeTotalFecTimeMicroSec = 0;
+      s_uLastTimeFecCalculation = g_TimeNow;
+   }
+   else if ( g_TimeNow >= s_uLastTimeFecCalculation + 250 )
+   {
+      s_uTimeFecMicroPerSec = 4 * s_uTimeTotalFecTimeMicroSec;
+      s_uTimeTotalFecTimeMicroSec = 0;
+      s_uLastTimeFecCalculation = g_TimeNow;
+   }
+}
+
 bool VideoTxPacketsBuffer::_sendPacket(int iBufferIndex, int iPacketIndex, u32 uRetransmissionId)
 {
    if ( m_VideoPackets[iBufferIndex][iPacketIndex].bEmpty )
@@ -720,6 +797,7 @@ bool VideoTxPacketsBuffer::_sendPacket(int iBufferIndex, int iPacketIndex, u32 u
    //pVideoData += sizeof(t_packet_header_video_full_98_debug_info);
    //u32 crc = base_compute_crc32(pVideoData, pCurrentVideoPacketHeader->uCurrentBlockPacketSize);
 
+   TRACE_INSTANT(TRACE_EVENT_VIDEO_TX_PACKET, pCurrentVideoPacketHeader->uCurrentBlockIndex, pCurrentVideoPacketHeader->uCurrentBlockPacketIndex, uRetransmissionId);
    send_packet_to_radio_interfaces((u8*)pCurrentPacketHeader, pCurrentPacketHeader->total_length, -1);
    return true;
 }
@@ -741,6 +819,11 @@ int VideoTxPacketsBuffer::sendAvailablePackets(int iMaxCountToSend)
    if ( iToSend > iMaxCountToSend )
       iToSend = iMaxCountToSend;
 
+   TRACE_BEGIN(TRACE_EVENT_VIDEO_TX_SEND, m_iCountReadyToSend, iToSend, 0);
+
+   // Video packets in this slice are queued per radio interface and submitted in one go at the end
+   radio_tx_batch_begin();
+
    int iCountSent = 0;
    for( int i=0; i<iToSend; i++ )
    {
@@ -780,6 +863,8 @@ int VideoTxPacketsBuffer::sendAvailablePackets(int iMaxCountToSend)
       if ( m_iCurrentBufferPacketIndexToSend == m_iNextBufferPacketIndexToFill )
          break;
    }
+   send_batched_packets_to_radio_interfaces();
+   TRACE_END(TRACE_EVENT_VIDEO_TX_SEND, m_iCountReadyToSend, iToSend, iCountSent);
    return iCountSent;
 }
 
@@ -52,6 +52,8 @@ class VideoTxPacketsBuffer
       void _checkAllocatePacket(int iBufferIndex, int iPacketIndex);
       void _fillVideoPacketHeaders(int iBufferIndex, int iPacketIndex, bool bIsECPacket, int iRawVideoDataSize, u32 uNALPresenceFlags, bool bEndOfTransmissionFrame);
       void _addNewVideoPacket(u8* pRawVideoData, int iRawVideoDataSize, u32 uNALPresenceFlags, bool bEndOfTransmissionFrame);
+      void _addPacketToECAccumulators(int iBufferIndex, int iPacketIndex);
+      void _computeECPackets(int iBufferIndex, t_packet_header_video_segment* pCurrentVideoPacketHeader);
       bool _sendPacket(int iBufferIndex, int iPacketIndex, u32 uRetransmissionId);
       static int m_siVideoBuffersInstancesCount;
       bool m_bInitialized;
@@ -88,6 +90,12 @@ class VideoTxPacketsBuffer
       type_tx_video_packet_info m_VideoPackets[MAX_RXTX_BLOCKS_BUFFER][MAX_TOTAL_PACKETS_IN_BLOCK];
       int m_iCountReadyToSend;
 
+      // Incremental EC encoding state for the block being filled
+      int m_iECAccumulatedRows;
+      int m_iECAccumulatedDataPackets;
+      int m_iECAccumulatedBlockDataPackets;
+      u32 m_uECAccumulatedPacketSize;
+
       u32 m_uRadioStreamPacketIndex;
 };
 
@@ -435,11 +435,6 @@ addmul1(gf *dst1, gf *src1, gf c, int sz)
 # define addmul1 slow_addmul1
 #endif
 
-static void addmul(gf *dst, gf *src, gf c, int sz) {
-    // fprintf(stderr, "Dst=%p Src=%p, gf=%02x sz=%d\n", dst, src, c, sz);
-    if (c != 0) addmul1(dst, src, c, sz);
-}
-
 /*
  * mul() computes dst[] = c * src[]
  * This is used often, so better optimize it! Currently the loop is
@@ -561,9 +556,227 @@ mul1(gf *dst1, gf *src1, gf c, int sz)
 # define mul1 slow_mul1
 #endif
 
+/*
+ * Split-nibble SIMD kernels for addmul1/mul1.
+ *
+ * Multiplication by a constant is linear over GF(2), so
+ *    c * x = c * (x & 0x0F) ^ c * (x & 0xF0)
+ * and the two partial products can be looked up in two 16 entries tables
+ * per constant. A 16 entries table fits in one vector register, so the
+ * lookup for 16 (or 32) bytes at a time is a single PSHUFB (x86) or
+ * VTBL/TBL (ARM) instruction. Results are bit-identical to the
+ * gf_mul_table lookups. The kernel is picked at runtime in fec_init().
+ */
+static gf gf_mul_lo[GF_SIZE+1][16] __attribute__((aligned (32)));
+static gf gf_mul_hi[GF_SIZE+1][16] __attribute__((aligned (32)));
+
+static void
+init_nibble_tables(void)
+{
+    int c, i;
+    for (c=0; c < GF_SIZE+1; c++)
+	for (i=0; i < 16; i++) {
+	    gf_mul_lo[c][i] = gf_mul(c, i);
+	    gf_mul_hi[c][i] = gf_mul(c, (i<<4));
+	}
+}
+
+typedef void (*gf_kernel_t)(gf *dst1, gf *src1, gf c, int sz);
+
+static void scalar_addmul1(gf *dst1, gf *src1, gf c, int sz) { addmul1(dst1, src1, c, sz); }
+static void scalar_mul1(gf *dst1, gf *src1, gf c, int sz) { mul1(dst1, src1, c, sz); }
+
+static gf_kernel_t s_pFnAddMul1 = scalar_addmul1;
+static gf_kernel_t s_pFnMul1 = scalar_mul1;
+static int s_iFecAccelerationType = FEC_ACCELERATION_NONE;
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FEC_HAS_X86_KERNELS 1
+#include <immintrin.h>
+
+__attribute__((target("ssse3"))) static void
+ssse3_addmul1(gf *dst, gf *src, gf c, int sz)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i tlo = _mm_load_si128((const __m128i*)gf_mul_lo[c]);
+    const __m128i thi = _mm_load_si128((const __m128i*)gf_mul_hi[c]);
+    int i = 0;
+    for (; i + 16 <= sz; i += 16) {
+	__m128i s = _mm_loadu_si128((const __m128i*)(src+i));
+	__m128i l = _mm_and_si128(s, mask);
+	__m128i h = _mm_and_si128(_mm_srli_epi64(s, 4), mask);
+	__m128i p = _mm_xor_si128(_mm_shuffle_epi8(tlo, l), _mm_shuffle_epi8(thi, h));
+	__m128i d = _mm_loadu_si128((const __m128i*)(dst+i));
+	_mm_storeu_si128((__m128i*)(dst+i), _mm_xor_si128(d, p));
+    }
+    if (i < sz)
+	slow_addmul1(dst+i, src+i, c, sz-i);
+}
+
+__attribute__((target("ssse3"))) static void
+ssse3_mul1(gf *dst, gf *src, gf c, int sz)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i tlo = _mm_load_si128((const __m128i*)gf_mul_lo[c]);
+    const __m128i thi = _mm_load_si128((const __m128i*)gf_mul_hi[c]);
+    int i = 0;
+    for (; i + 16 <= sz; i += 16) {
+	__m128i s = _mm_loadu_si128((const __m128i*)(src+i));
+	__m128i l = _mm_and_si128(s, mask);
+	__m128i h = _mm_and_si128(_mm_srli_epi64(s, 4), mask);
+	_mm_storeu_si128((__m128i*)(dst+i), _mm_xor_si128(_mm_shuffle_epi8(tlo, l), _mm_shuffle_epi8(thi, h)));
+    }
+    if (i < sz)
+	slow_mul1(dst+i, src+i, c, sz-i);
+}
+
+__attribute__((target("avx2"))) static void
+avx2_addmul1(gf *dst, gf *src, gf c, int sz)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    const __m256i tlo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_lo[c]));
+    const __m256i thi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_hi[c]));
+    int i = 0;
+    for (; i + 32 <= sz; i += 32) {
+	__m256i s = _mm256_loadu_si256((const __m256i*)(src+i));
+	__m256i l = _mm256_and_si256(s, mask);
+	__m256i h = _mm256_and_si256(_mm256_srli_epi64(s, 4), mask);
+	__m256i p = _mm256_xor_si256(_mm256_shuffle_epi8(tlo, l), _mm256_shuffle_epi8(thi, h));
+	__m256i d = _mm256_loadu_si256((const __m256i*)(dst+i));
+	_mm256_storeu_si256((__m256i*)(dst+i), _mm256_xor_si256(d, p));
+    }
+    /* leave the AVX state clean before running legacy SSE code */
+    _mm256_zeroupper();
+    if (i < sz)
+	ssse3_addmul1(dst+i, src+i, c, sz-i);
+}
+
+__attribute__((target("avx2"))) static void
+avx2_mul1(gf *dst, gf *src, gf c, int sz)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    const __m256i tlo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_lo[c]));
+    const __m256i thi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_hi[c]));
+    int i = 0;
+    for (; i + 32 <= sz; i += 32) {
+	__m256i s = _mm256_loadu_si256((const __m256i*)(src+i));
+	__m256i l = _mm256_and_si256(s, mask);
+	__m256i h = _mm256_and_si256(_mm256_srli_epi64(s, 4), mask);
+	_mm256_storeu_si256((__m256i*)(dst+i), _mm256_xor_si256(_mm256_shuffle_epi8(tlo, l), _mm256_shuffle_epi8(thi, h)));
+    }
+    /* leave the AVX state clean before running legacy SSE code */
+    _mm256_zeroupper();
+    if (i < sz)
+	ssse3_mul1(dst+i, src+i, c, sz-i);
+}
+#endif /* x86 */
+
+#if defined(__arm__) || defined(__aarch64__)
+/* The NEON kernels are in fec_neon.c, built with NEON enabled even if this file is not */
+#define FEC_HAS_NEON_KERNELS 1
+#include "fec_neon.h"
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+
+static void
+neon_addmul1(gf *dst, gf *src, gf c, int sz)
+{
+    int i = fec_neon_addmul1(dst, src, gf_mul_lo[c], gf_mul_hi[c], sz);
+    if (i < sz)
+	slow_addmul1(dst+i, src+i, c, sz-i);
+}
+
+static void
+neon_mul1(gf *dst, gf *src, gf c, int sz)
+{
+    int i = fec_neon_mul1(dst, src, gf_mul_lo[c], gf_mul_hi[c], sz);
+    if (i < sz)
+	slow_mul1(dst+i, src+i, c, sz-i);
+}
+#endif /* ARM */
+
+static int
+is_acceleration_supported(int iType)
+{
+    switch (iType) {
+    case FEC_ACCELERATION_NONE:
+	return 1;
+#if defined(FEC_HAS_X86_KERNELS)
+    case FEC_ACCELERATION_SSSE3:
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("ssse3") ? 1 : 0;
+    case FEC_ACCELERATION_AVX2:
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+#if defined(FEC_HAS_NEON_KERNELS)
+    case FEC_ACCELERATION_NEON:
+	if (! fec_neon_kernels_available())
+	    return 0;
+#if defined(__aarch64__)
+	return 1;
+#else
+	return (getauxval(AT_HWCAP) & HWCAP_NEON) ? 1 : 0;
+#endif
+#endif
+    default:
+	return 0;
+    }
+}
+
+static void
+select_kernels(int iType)
+{
+    s_pFnAddMul1 = scalar_addmul1;
+    s_pFnMul1 = scalar_mul1;
+    s_iFecAccelerationType = FEC_ACCELERATION_NONE;
+    switch (iType) {
+#if defined(FEC_HAS_X86_KERNELS)
+    case FEC_ACCELERATION_SSSE3:
+	s_pFnAddMul1 = ssse3_addmul1;
+	s_pFnMul1 = ssse3_mul1;
+	break;
+    case FEC_ACCELERATION_AVX2:
+	s_pFnAddMul1 = avx2_addmul1;
+	s_pFnMul1 = avx2_mul1;
+	break;
+#endif
+#if defined(FEC_HAS_NEON_KERNELS)
+    case FEC_ACCELERATION_NEON:
+	s_pFnAddMul1 = neon_addmul1;
+	s_pFnMul1 = neon_mul1;
+	break;
+#endif
+    default:
+	return;
+    }
+    s_iFecAccelerationType = iType;
+}
+
+static int
+detect_best_acceleration(void)
+{
+    if (is_acceleration_supported(FEC_ACCELERATION_AVX2))
+	return FEC_ACCELERATION_AVX2;
+    if (is_acceleration_supported(FEC_ACCELERATION_SSSE3))
+	return FEC_ACCELERATION_SSSE3;
+    if (is_acceleration_supported(FEC_ACCELERATION_NEON))
+	return FEC_ACCELERATION_NEON;
+    return FEC_ACCELERATION_NONE;
+}
+
+static void addmul(gf *dst, gf *src, gf c, int sz) {
+    // fprintf(stderr, "Dst=%p Src=%p, gf=%02x sz=%d\n", dst, src, c, sz);
+    if (c != 0) s_pFnAddMul1(dst, src, c, sz);
+}
+
 static inline void mul(gf *dst, gf *src, gf c, int sz) {
     /*fprintf(stderr, "%p = %02x * %p\n", dst, c, src);*/
-    if (c != 0) mul1(dst, src, c, sz); else memset(dst, 0, sz);
+    if (c != 0) s_pFnMul1(dst, src, c, sz); else memset(dst, 0, sz);
 }
 
 /*
@@ -704,11 +917,42 @@ void fec_init(void)
     DDB(fprintf(stderr, "generate_gf took %ldus\n", ticks[0]);)
 	TICK(ticks[0]);
     init_mul_table();
+    init_nibble_tables();
     TOCK(ticks[0]);
     DDB(fprintf(stderr, "init_mul_table took %ldus\n", ticks[0]);)
+    select_kernels(detect_best_acceleration());
    	fec_initialized = 1 ;
 }
 
+int fec_get_acceleration(void)
+{
+    if ( 0 == fec_initialized )
+       fec_init();
+    return s_iFecAccelerationType;
+}
+
+const char* fec_get_acceleration_name(void)
+{
+    switch (fec_get_acceleration()) {
+    case FEC_ACCELERATION_SSSE3: return "SSSE3";
+    case FEC_ACCELERATION_AVX2: return "AVX2";
+    case FEC_ACCELERATION_NEON: return "NEON";
+    default: return "scalar";
+    }
+}
+
+int fec_set_acceleration(int iAccelerationType)
+{
+    if ( 0 == fec_initialized )
+       fec_init();
+    if (iAccelerationType == FEC_ACCELERATION_AUTO)
+	iAccelerationType = detect_best_acceleration();
+    if (! is_acceleration_supported(iAccelerationType))
+	return -1;
+    select_kernels(iAccelerationType);
+    return s_iFecAccelerationType;
+}
+
 
 /**
  * Simplified re-implementation of Fec-Bourbon
@@ -834,6 +1078,36 @@ void fec_encode(unsigned int blockSize,
     }
 }
 
+/* Incremental version of fec_encode: folds one data block into the FEC
+ * blocks as soon as it is available, so that the FEC blocks are ready
+ * right after the last data block of a stripe arrives, instead of doing
+ * all the work at the end of the stripe. Data block 0 must be added first
+ * (it initializes the FEC blocks), the others can be added in any order.
+ * Adding all the data blocks gives the same result as fec_encode.
+ * The FEC row coefficients do not depend on the number of data blocks,
+ * so a stripe can be ended earlier (with fewer data blocks).
+ */
+void fec_encode_add_data_block(unsigned int blockSize,
+		unsigned char *data_block,
+		unsigned int dataBlockIndex,
+		unsigned char **fec_blocks,
+		unsigned int nrFecBlocks)
+{
+    unsigned int row;
+
+    if ( 0 == fec_initialized )
+       fec_init();
+    assert(dataBlockIndex < 128);
+    assert(nrFecBlocks <= 128);
+
+    for(row=0; row < nrFecBlocks; row++) {
+	if (0 == dataBlockIndex)
+	    mul(fec_blocks[row], data_block, inverse[128 ^ row], blockSize);
+	else
+	    addmul(fec_blocks[row], data_block, inverse[row ^ (128 + dataBlockIndex)], blockSize);
+    }
+}
+
 /**
  * Reduce the system by substracting all received data blocks from FEC blocks
  * This will allow to resolve the system by inverting a much smaller matrix
@@ -871,9 +1145,105 @@ static inline void reduce(unsigned int blockSize,
        s_iAssertion = -2;
 }
 
+/*
+ * Cache of inverted decode matrices.
+ * The decode matrix depends only on which data blocks are erased and on
+ * which FEC blocks are used to recover them (not on the block size or on
+ * the data itself), so on a steady loss pattern (i.e. one weak antenna
+ * dropping the same slot every block) the same matrix would be inverted
+ * again and again. Entries are keyed by the erased data blocks bitmask and
+ * the used FEC blocks bitmask (both lists are sorted ascending by the
+ * callers) and evicted least recently used first.
+ */
+#define FEC_DECODE_CACHE_ENTRIES 16
+#define FEC_DECODE_CACHE_MAX_BLOCKS 32
+
+typedef struct {
+    unsigned int uLastUse; /* 0: empty slot */
+    unsigned short nr_fec_blocks;
+    unsigned long long uErasedMask[2];
+    unsigned long long uFecMask[2];
+    gf matrix[FEC_DECODE_CACHE_MAX_BLOCKS*FEC_DECODE_CACHE_MAX_BLOCKS];
+} fec_decode_cache_entry;
+
+static fec_decode_cache_entry s_DecodeCache[FEC_DECODE_CACHE_ENTRIES];
+static unsigned int s_uDecodeCacheUseCounter = 0;
+static unsigned int s_uDecodeCacheHits = 0;
+static unsigned int s_uDecodeCacheMisses = 0;
+
+/* Returns 0 if the lists can't be represented as bitmasks (not sorted or out of range) */
+static int build_cache_mask(unsigned int *list, int count, unsigned long long *pMask)
+{
+    int i;
+    pMask[0] = pMask[1] = 0;
+    for (i = 0; i < count; i++) {
+	if (list[i] >= 128)
+	    return 0;
+	if ((i > 0) && (list[i] <= list[i-1]))
+	    return 0;
+	pMask[list[i] >> 6] |= ((unsigned long long)1) << (list[i] & 0x3F);
+    }
+    return 1;
+}
+
+static fec_decode_cache_entry* find_cached_matrix(unsigned long long *uErasedMask, unsigned long long *uFecMask, short nr_fec_blocks)
+{
+    int i;
+    for (i = 0; i < FEC_DECODE_CACHE_ENTRIES; i++) {
+	fec_decode_cache_entry *pEntry = &s_DecodeCache[i];
+	if (0 == pEntry->uLastUse || pEntry->nr_fec_blocks != nr_fec_blocks)
+	    continue;
+	if (pEntry->uErasedMask[0] != uErasedMask[0] || pEntry->uErasedMask[1] != uErasedMask[1])
+	    continue;
+	if (pEntry->uFecMask[0] != uFecMask[0] || pEntry->uFecMask[1] != uFecMask[1])
+	    continue;
+	pEntry->uLastUse = ++s_uDecodeCacheUseCounter;
+	return pEntry;
+    }
+    return NULL;
+}
+
+static void add_cached_matrix(unsigned long long *uErasedMask, unsigned long long *uFecMask, short nr_fec_blocks, gf *matrix)
+{
+    int i;
+    fec_decode_cache_entry *pEntry = &s_DecodeCache[0];
+    for (i = 1; i < FEC_DECODE_CACHE_ENTRIES; i++)
+	if (s_DecodeCache[i].uLastUse < pEntry->uLastUse)
+	    pEntry = &s_DecodeCache[i];
+
+    pEntry->uLastUse = ++s_uDecodeCacheUseCounter;
+    pEntry->nr_fec_blocks = nr_fec_blocks;
+    pEntry->uErasedMask[0] = uErasedMask[0];
+    pEntry->uErasedMask[1] = uErasedMask[1];
+    pEntry->uFecMask[0] = uFecMask[0];
+    pEntry->uFecMask[1] = uFecMask[1];
+    memcpy(pEntry->matrix, matrix, nr_fec_blocks*nr_fec_blocks);
+}
+
+/* we pick the submatrix of code that keeps colums corresponding to
+ * the erased data blocks, and rows corresponding to the present FEC
+ * blocks. This is the matrix by which we would need to multiply the
+ * missing data blocks to obtain the FEC blocks we have */
+static void build_decode_matrix(gf *matrix,
+			   unsigned int *fec_block_nos,
+			   unsigned int *erased_blocks,
+			   short nr_fec_blocks)
+{
+    int row, ptr;
+    for(row = 0, ptr=0; row < nr_fec_blocks; row++) {
+	int col;
+	int irow = 128 + fec_block_nos[row];
+	/*assert(irow < fec_blocks+128);*/
+	for(col = 0; col < nr_fec_blocks; col++, ptr++) {
+	    int icol = erased_blocks[col];
+	    matrix[ptr] = inverse[irow ^ icol];
+	}
+    }
+}
+
 /**
  * Resolves reduced system. Constructs "mini" encoding matrix, inverts
- * it, and multiply reduced vector by it.
+ * it (or takes it from the cache), and multiply reduced vector by it.
  */
 static inline void resolve(int blockSize,
 			   unsigned char **data_blocks,
@@ -887,26 +1257,30 @@ static inline void resolve(int blockSize,
     unsigned char matrix[nr_fec_blocks*nr_fec_blocks];
     int ptr;
     int r;
-
-    /* we pick the submatrix of code that keeps colums corresponding to
-     * the erased data blocks, and rows corresponding to the present FEC
-     * blocks. This is the matrix by which we would need to multiply the
-     * missing data blocks to obtain the FEC blocks we have */
-    for(row = 0, ptr=0; row < nr_fec_blocks; row++) {
-	int col;
-	int irow = 128 + fec_block_nos[row];
-	/*assert(irow < fec_blocks+128);*/
-	for(col = 0; col < nr_fec_blocks; col++, ptr++) {
-	    int icol = erased_blocks[col];
-	    matrix[ptr] = inverse[irow ^ icol];
-	}
+    int bCacheable;
+    unsigned long long uErasedMask[2];
+    unsigned long long uFecMask[2];
+    fec_decode_cache_entry *pCached = NULL;
+
+    bCacheable = (nr_fec_blocks <= FEC_DECODE_CACHE_MAX_BLOCKS) &&
+		 build_cache_mask(erased_blocks, nr_fec_blocks, uErasedMask) &&
+		 build_cache_mask(fec_block_nos, nr_fec_blocks, uFecMask);
+    if (bCacheable)
+	pCached = find_cached_matrix(uErasedMask, uFecMask, nr_fec_blocks);
+
+    if (NULL != pCached) {
+	s_uDecodeCacheHits++;
+	memcpy(matrix, pCached->matrix, nr_fec_blocks*nr_fec_blocks);
+    } else {
+	s_uDecodeCacheMisses++;
+	build_decode_matrix(matrix, fec_block_nos, erased_blocks, nr_fec_blocks);
+	r=invert_mat(matrix, nr_fec_blocks);
+	if(r)
+	    s_iAssertion = -1;
+	else if (bCacheable)
+	    add_cached_matrix(uErasedMask, uFecMask, nr_fec_blocks, matrix);
     }
 
-    r=invert_mat(matrix, nr_fec_blocks);
-
-    if(r)
-	      s_iAssertion = -1;
-
     /* do the multiplication with the reduced code vector */
     for(row = 0, ptr=0; row < nr_fec_blocks; row++) {
 	int col;
@@ -939,3 +1313,10 @@ int fec_decode(unsigned int blockSize,
     return s_iAssertion;
 }
 
+void fec_get_decode_cache_stats(unsigned int *puHits, unsigned int *puMisses)
+{
+    if (NULL != puHits)
+	*puHits = s_uDecodeCacheHits;
+    if (NULL != puMisses)
+	*puMisses = s_uDecodeCacheMisses;
+}
@@ -18,6 +18,15 @@ void fec_encode(unsigned int blockSize,
 		unsigned char **fec_blocks,
 		unsigned int nrFecBlocks);
 
+// Incremental encoding: folds data block dataBlockIndex into the FEC blocks.
+// Data block 0 must be added first. Once all data blocks are added, the FEC
+// blocks are identical to the ones generated by fec_encode()
+void fec_encode_add_data_block(unsigned int blockSize,
+		unsigned char *data_block,
+		unsigned int dataBlockIndex,
+		unsigned char **fec_blocks,
+		unsigned int nrFecBlocks);
+
 int fec_decode(unsigned int blockSize,
 		unsigned char **data_blocks,
 		unsigned int nr_data_blocks,
@@ -28,6 +37,21 @@ int fec_decode(unsigned int blockSize,
 
 void fec_print(fec_code_t code, int width);
 
+// Total hits/misses of the inverted decode matrices cache (since process start)
+void fec_get_decode_cache_stats(unsigned int *puHits, unsigned int *puMisses);
+
+// SIMD kernels used for the GF(256) math. Picked at runtime in fec_init()
+#define FEC_ACCELERATION_AUTO -1
+#define FEC_ACCELERATION_NONE 0
+#define FEC_ACCELERATION_SSSE3 1
+#define FEC_ACCELERATION_AVX2 2
+#define FEC_ACCELERATION_NEON 3
+
+int fec_get_acceleration(void);
+const char* fec_get_acceleration_name(void);
+// Forces a kernel type (testing/benchmarks). Returns the type set or -1 if not supported by the CPU
+int fec_set_acceleration(int iAccelerationType);
+
 void fec_license(void);
 #ifdef __cplusplus
 }
@@ -0,0 +1,101 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "fec_neon.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+static inline uint8x16_t _fec_neon_lookup16(uint8x16_t tbl, uint8x16_t idx)
+{
+   #if defined(__aarch64__)
+   return vqtbl1q_u8(tbl, idx);
+   #else
+   uint8x8x2_t t;
+   t.val[0] = vget_low_u8(tbl);
+   t.val[1] = vget_high_u8(tbl);
+   return vcombine_u8(vtbl2_u8(t, vget_low_u8(idx)), vtbl2_u8(t, vget_high_u8(idx)));
+   #endif
+}
+
+int fec_neon_kernels_available(void)
+{
+   return 1;
+}
+
+int fec_neon_addmul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pTableLow, const unsigned char* pTableHigh, int iSize)
+{
+   const uint8x16_t mask = vdupq_n_u8(0x0F);
+   const uint8x16_t tlo = vld1q_u8(pTableLow);
+   const uint8x16_t thi = vld1q_u8(pTableHigh);
+   int i = 0;
+   for( ; i + 16 <= iSize; i += 16 )
+   {
+      uint8x16_t s = vld1q_u8(pSrc+i);
+      uint8x16_t p = veorq_u8(_fec_neon_lookup16(tlo, vandq_u8(s, mask)), _fec_neon_lookup16(thi, vshrq_n_u8(s, 4)));
+      vst1q_u8(pDst+i, veorq_u8(vld1q_u8(pDst+i), p));
+   }
+   return i;
+}
+
+int fec_neon_mul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pTableLow, const unsigned char* pTableHigh, int iSize)
+{
+   const uint8x16_t mask = vdupq_n_u8(0x0F);
+   const uint8x16_t tlo = vld1q_u8(pTableLow);
+   const uint8x16_t thi = vld1q_u8(pTableHigh);
+   int i = 0;
+   for( ; i + 16 <= iSize; i += 16 )
+   {
+      uint8x16_t s = vld1q_u8(pSrc+i);
+      vst1q_u8(pDst+i, veorq_u8(_fec_neon_lookup16(tlo, vandq_u8(s, mask)), _fec_neon_lookup16(thi, vshrq_n_u8(s, 4))));
+   }
+   return i;
+}
+
+#else
+
+int fec_neon_kernels_available(void)
+{
+   return 0;
+}
+
+int fec_neon_addmul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pTableLow, const unsigned char* pTableHigh, int iSize)
+{
+   return 0;
+}
+
+int fec_neon_mul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pTableLow, const unsigned char* pTableHigh, int iSize)
+{
+   return 0;
+}
+
+#endif
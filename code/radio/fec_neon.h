@@ -0,0 +1,21 @@
+#pragma once
+
+// NEON split-nibble kernels for the FEC GF(256) math (see fec.c).
+// Built in their own translation unit with NEON enabled (CFLAGS_NEON in the Makefile),
+// so 32 bit ARM builds that don't target NEON still have them for the runtime (HWCAP) dispatch.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returns 1 if this build has the NEON kernels
+int fec_neon_kernels_available(void);
+
+// pTableLow/pTableHigh: the 16 entries products of the constant by the low/high nibbles.
+// Process only the multiples of 16 bytes. Return the number of bytes processed.
+int fec_neon_addmul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pTableLow, const unsigned char* pTableHigh, int iSize);
+int fec_neon_mul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pTableLow, const unsigned char* pTableHigh, int iSize);
+
+#ifdef __cplusplus
+}
+#endif
@@ -39,15 +39,21 @@
 #include "radiolink.h"
 
 
-#define PACKETS_INDEX_HASH_SIZE 512
-#define PACKETS_INDEX_HASH_MASK 0x01FF
+// Sliding window of received stream packet indexes, one bit per packet index,
+// ending at the max received packet index on the stream.
+// Must be a power of 2 and larger than the max video stream delta used for restart detection (2000)
+#define DUP_DETECTION_WINDOW_SIZE 4096
+#define DUP_DETECTION_WINDOW_WORDS (DUP_DETECTION_WINDOW_SIZE/32)
+
+// Direct mapped cache of vehicle id -> runtime index
+#define DUP_DETECTION_VID_CACHE_SIZE 16
 
 typedef struct
 {
    u32 uMaxReceivedPacketIndex;
    u32 uLastReceivedPacketIndex;
    u32 uLastTimeReceivedPacket;
-   u32 packetsHashIndexes[PACKETS_INDEX_HASH_SIZE];
+   u32 uReceivedWindow[DUP_DETECTION_WINDOW_WORDS];
 } ALIGN_STRUCT_SPEC_INFO t_stream_history_packets_indexes;
 
 typedef struct
@@ -58,6 +64,9 @@ typedef struct
 } ALIGN_STRUCT_SPEC_INFO t_vehicle_history_packets_indexes;
 
 t_vehicle_history_packets_indexes s_ListHistoryRxPacketsVehicles[MAX_CONCURENT_VEHICLES];
+int s_iDupDetectionVehicleIndexCache[DUP_DETECTION_VID_CACHE_SIZE];
+// Serial radio interfaces (looser data streams packets delta), set by radio_duplicate_detection_update_radio_interfaces()
+int s_iDupDetectionIsSerialRadio[MAX_RADIO_INTERFACES];
 
 extern u32 s_uRadioRxTimeNow;
 
@@ -76,17 +85,59 @@ void _radio_dd_reset_duplication_stats_for_vehicle(int iVehicleIndex, int iReaso
       s_ListHistoryRxPacketsVehicles[iVehicleIndex].streamsPacketsHistory[k].uMaxReceivedPacketIndex = 0;
       s_ListHistoryRxPacketsVehicles[iVehicleIndex].streamsPacketsHistory[k].uLastReceivedPacketIndex = MAX_U32;
       s_ListHistoryRxPacketsVehicles[iVehicleIndex].streamsPacketsHistory[k].uLastTimeReceivedPacket = 0;
-      memset((u8*)s_ListHistoryRxPacketsVehicles[iVehicleIndex].streamsPacketsHistory[k].packetsHashIndexes, 0xFF, PACKETS_INDEX_HASH_SIZE * sizeof(u32));
+      memset((u8*)s_ListHistoryRxPacketsVehicles[iVehicleIndex].streamsPacketsHistory[k].uReceivedWindow, 0, sizeof(s_ListHistoryRxPacketsVehicles[iVehicleIndex].streamsPacketsHistory[k].uReceivedWindow));
+   }
+}
+
+static inline int _radio_dd_get_vid_cache_slot(u32 uVehicleId)
+{
+   return (int)((uVehicleId * 2654435761u) >> 28) & (DUP_DETECTION_VID_CACHE_SIZE-1);
+}
+
+// Moves the end of the received window up to uNewMaxPacketIndex. Only the words the window enters are cleared:
+// bits past the current max in its own word were never set.
+static inline void _radio_dd_advance_window(t_stream_history_packets_indexes* pStreamHistory, u32 uNewMaxPacketIndex)
+{
+   u32 uWord = pStreamHistory->uMaxReceivedPacketIndex >> 5;
+   u32 uCountWords = (uNewMaxPacketIndex >> 5) - uWord;
+   if ( uCountWords >= DUP_DETECTION_WINDOW_WORDS )
+   {
+      memset((u8*)pStreamHistory->uReceivedWindow, 0, sizeof(pStreamHistory->uReceivedWindow));
+      return;
+   }
+   while ( uCountWords > 0 )
+   {
+      uWord++;
+      pStreamHistory->uReceivedWindow[uWord & (DUP_DETECTION_WINDOW_WORDS-1)] = 0;
+      uCountWords--;
    }
 }
 
 
 void radio_duplicate_detection_init()
 {
+   for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+      s_iDupDetectionIsSerialRadio[i] = 0;
+   for( int i=0; i<DUP_DETECTION_VID_CACHE_SIZE; i++ )
+      s_iDupDetectionVehicleIndexCache[i] = -1;
    for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
       _radio_dd_reset_duplication_stats_for_vehicle(i, 0);
 }
 
+void radio_duplicate_detection_update_radio_interfaces()
+{
+   int iCountSerial = 0;
+   for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+   {
+      s_iDupDetectionIsSerialRadio[i] = 0;
+      if ( i < hardware_get_radio_interfaces_count() )
+         s_iDupDetectionIsSerialRadio[i] = hardware_radio_index_is_serial_radio(i);
+      if ( s_iDupDetectionIsSerialRadio[i] )
+         iCountSerial++;
+   }
+   log_line("[RadioDuplicateDetection] Updated radio interfaces, %d serial radio interfaces.", iCountSerial);
+}
+
 void radio_duplicate_detection_log_info()
 {
    char szBuff[256];
@@ -111,8 +162,14 @@ void radio_duplicate_detection_log_info()
 
 int _radio_dup_detection_get_runtime_index_for_vid(u32 uVehicleId, u8* pPacketBuffer, int iPacketLength)
 {
-   int iStatsIndex = -1;
+   // Cached entries are validated against the list, so resets of the list never leave stale cache hits
+   int iCacheSlot = _radio_dd_get_vid_cache_slot(uVehicleId);
+   int iStatsIndex = s_iDupDetectionVehicleIndexCache[iCacheSlot];
+   if ( (iStatsIndex >= 0) && (iStatsIndex < MAX_CONCURENT_VEHICLES) )
+   if ( (0 != uVehicleId) && (uVehicleId == s_ListHistoryRxPacketsVehicles[iStatsIndex].uVehicleId) )
+      return iStatsIndex;
 
+   iStatsIndex = -1;
    for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
    {
       if ( uVehicleId == s_ListHistoryRxPacketsVehicles[i].uVehicleId )
@@ -122,7 +179,10 @@ int _radio_dup_detection_get_runtime_index_for_vid(u32 uVehicleId, u8* pPacketBu
       }
    }
    if ( iStatsIndex != -1 )
+   {
+      s_iDupDetectionVehicleIndexCache[iCacheSlot] = iStatsIndex;
       return iStatsIndex;
+   }
 
    // New vehicle id, add it to the runtime list
 
@@ -191,6 +251,7 @@ int _radio_dup_detection_get_runtime_index_for_vid(u32 uVehicleId, u8* pPacketBu
    if ( 0 == szBuff[0] )
       strcpy(szBuff, "None");
    log_line("[RadioDuplicateDetection] Updated list of receiving VIDs: [%s]", szBuff);
+   s_iDupDetectionVehicleIndexCache[iCacheSlot] = iStatsIndex;
    return iStatsIndex;
 }
 
@@ -207,62 +268,69 @@ int radio_dup_detection_is_duplicate_on_stream(int iRadioInterfaceIndex, u8* pPa
    u32 uStreamPacketIndex = (pPH->stream_packet_idx) & PACKET_FLAGS_MASK_STREAM_PACKET_IDX;
    u32 uStreamIndex = (pPH->stream_packet_idx)>>PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX; 
    u8 uPacketType = pPH->packet_type;   
-   int iStatsIndex = -1;
 
-   iStatsIndex = _radio_dup_detection_get_runtime_index_for_vid(uVehicleId, pPacketBuffer, iPacketLength);
-   if ( -1 == iStatsIndex )
-      return 1;
+   // Cache hits are resolved inline, the lookup function only runs on misses and new vehicles
+   int iStatsIndex = s_iDupDetectionVehicleIndexCache[_radio_dd_get_vid_cache_slot(uVehicleId)];
+   if ( (iStatsIndex < 0) || (0 == uVehicleId) || (uVehicleId != s_ListHistoryRxPacketsVehicles[iStatsIndex].uVehicleId) )
+   {
+      iStatsIndex = _radio_dup_detection_get_runtime_index_for_vid(uVehicleId, pPacketBuffer, iPacketLength);
+      if ( -1 == iStatsIndex )
+         return 1;
+   }
 
    t_vehicle_history_packets_indexes* pDupInfo = &s_ListHistoryRxPacketsVehicles[iStatsIndex];
    pDupInfo->uVehicleId = uVehicleId;
    
    static u32 s_TimeLastLogAlarmStreamPacketsVariation = 0;
 
-   u32 uMaxDeltaForVideoStream = 2000;
-   u32 uMaxDeltaForDataStream = 50;
-   if ( hardware_radio_index_is_serial_radio(iRadioInterfaceIndex) )
-      uMaxDeltaForDataStream = 200;
-
-   if ( uStreamIndex < STREAM_ID_VIDEO_1 )
-   if ((pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex > uMaxDeltaForDataStream ) && 
-           (uStreamPacketIndex < pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex - uMaxDeltaForDataStream) )
-   if ( pDupInfo->streamsPacketsHistory[uStreamIndex].uLastTimeReceivedPacket > uTimeNow - 4000 )
-   if ( uTimeNow > s_TimeLastLogAlarmStreamPacketsVariation + 1000 )
-   {
-      s_TimeLastLogAlarmStreamPacketsVariation = get_current_timestamp_ms();
-      log_line("[RadioDuplicateDetection] Received stream-%d packet index %u on radio interface %d, is %u packets older than max packet for the stream (%u).",
-         (int)uStreamIndex, iRadioInterfaceIndex+1, uStreamPacketIndex,
-         pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex-uStreamPacketIndex,
-         pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex);
-   }
+   t_stream_history_packets_indexes* pStreamHistory = &(pDupInfo->streamsPacketsHistory[uStreamIndex]);
 
    // --------------------------------------------------------
    // Begin: Detect if stream restarted
+   // All the checks below need a packet more than 10 indexes older than the max received one,
+   // so in order packets and the usual duplicates from the other radio interfaces skip them
 
-   int iStreamRestarted = 0;
-
-   if ( uStreamIndex >= STREAM_ID_VIDEO_1 )
-   if ( pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex > uStreamPacketIndex + uMaxDeltaForVideoStream )
-      iStreamRestarted = 1;
+   if ( pStreamHistory->uMaxReceivedPacketIndex > uStreamPacketIndex + 10 )
+   {
+      u32 uMaxDeltaForVideoStream = 2000;
+      u32 uMaxDeltaForDataStream = 50;
+      if ( (iRadioInterfaceIndex >= 0) && (iRadioInterfaceIndex < MAX_RADIO_INTERFACES) )
+      if ( s_iDupDetectionIsSerialRadio[iRadioInterfaceIndex] )
+         uMaxDeltaForDataStream = 200;
+
+      if ( uStreamIndex < STREAM_ID_VIDEO_1 )
+      if ((pStreamHistory->uMaxReceivedPacketIndex > uMaxDeltaForDataStream ) && 
+              (uStreamPacketIndex < pStreamHistory->uMaxReceivedPacketIndex - uMaxDeltaForDataStream) )
+      if ( pStreamHistory->uLastTimeReceivedPacket > uTimeNow - 4000 )
+      if ( uTimeNow > s_TimeLastLogAlarmStreamPacketsVariation + 1000 )
+      {
+         s_TimeLastLogAlarmStreamPacketsVariation = get_current_timestamp_ms();
+         log_line("[RadioDuplicateDetection] Received stream-%d packet index %u on radio interface %d, is %u packets older than max packet for the stream (%u).",
+            (int)uStreamIndex, iRadioInterfaceIndex+1, uStreamPacketIndex,
+            pStreamHistory->uMaxReceivedPacketIndex-uStreamPacketIndex,
+            pStreamHistory->uMaxReceivedPacketIndex);
+      }
 
-   if ( uStreamIndex < STREAM_ID_VIDEO_1 )
-   if ( pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex > uStreamPacketIndex + uMaxDeltaForDataStream )
-      iStreamRestarted = 1;
+      int iStreamRestarted = 0;
+      u32 uMaxDelta = (uStreamIndex >= STREAM_ID_VIDEO_1)?uMaxDeltaForVideoStream:uMaxDeltaForDataStream;
+      if ( pStreamHistory->uMaxReceivedPacketIndex > uStreamPacketIndex + uMaxDelta )
+         iStreamRestarted = 1;
 
-   if ( 0 != pDupInfo->streamsPacketsHistory[uStreamIndex].uLastTimeReceivedPacket )
-   if ( pDupInfo->streamsPacketsHistory[uStreamIndex].uLastTimeReceivedPacket < uTimeNow - 8000 )
-   if ( uStreamPacketIndex+10 < pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex )
-      iStreamRestarted = 1;
+      if ( 0 != pStreamHistory->uLastTimeReceivedPacket )
+      if ( pStreamHistory->uLastTimeReceivedPacket < uTimeNow - 8000 )
+      if ( uStreamPacketIndex+10 < pStreamHistory->uMaxReceivedPacketIndex )
+         iStreamRestarted = 1;
 
-   if ( iStreamRestarted )
-   {
-      log_line("[RadioDuplicateDetection] Detected stream restart on the other end of the radio link for VID %u. On stream: %d (%s), received stream packet index: %u, max recv stream packet index: %u, last received packet on this stream was %d ms ago. Reseting duplicate stats info for this VID (%u)",
-         uVehicleId, uStreamIndex, str_get_radio_stream_name(uStreamIndex),
-         uStreamPacketIndex, pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex,
-         uTimeNow - pDupInfo->streamsPacketsHistory[uStreamIndex].uLastTimeReceivedPacket, uVehicleId );
-      _radio_dd_reset_duplication_stats_for_vehicle(iStatsIndex, 2);
-      pDupInfo->iRestartDetected = 1;
-      pDupInfo->uVehicleId = uVehicleId;
+      if ( iStreamRestarted )
+      {
+         log_line("[RadioDuplicateDetection] Detected stream restart on the other end of the radio link for VID %u. On stream: %d (%s), received stream packet index: %u, max recv stream packet index: %u, last received packet on this stream was %d ms ago. Reseting duplicate stats info for this VID (%u)",
+            uVehicleId, uStreamIndex, str_get_radio_stream_name(uStreamIndex),
+            uStreamPacketIndex, pStreamHistory->uMaxReceivedPacketIndex,
+            uTimeNow - pStreamHistory->uLastTimeReceivedPacket, uVehicleId );
+         _radio_dd_reset_duplication_stats_for_vehicle(iStatsIndex, 2);
+         pDupInfo->iRestartDetected = 1;
+         pDupInfo->uVehicleId = uVehicleId;
+      }
    }
 
    // End: Detect if stream restarted
@@ -271,24 +339,26 @@ int radio_dup_detection_is_duplicate_on_stream(int iRadioInterfaceIndex, u8* pPa
    // ---------------------------------------------------
    // Check for packet duplication on stream for vehicle
 
-   int bIsDuplicatePacket = 0;
-   int iHashIndex = uStreamPacketIndex & PACKETS_INDEX_HASH_MASK;
-   if ( uStreamPacketIndex == pDupInfo->streamsPacketsHistory[uStreamIndex].packetsHashIndexes[iHashIndex] )
-      bIsDuplicatePacket = 1;
-
-   if ( (uPacketType == PACKET_TYPE_RUBY_PING_CLOCK) || (uPacketType == PACKET_TYPE_RUBY_PING_CLOCK_REPLY) )
-      bIsDuplicatePacket = 0;
-
-   if ( bIsDuplicatePacket )
-      return 1;
+   u32* pWindowWord = &pStreamHistory->uReceivedWindow[(uStreamPacketIndex >> 5) & (DUP_DETECTION_WINDOW_WORDS-1)];
+   u32 uBitMask = ((u32)1) << (uStreamPacketIndex & 0x1F);
 
-   
-   pDupInfo->streamsPacketsHistory[uStreamIndex].packetsHashIndexes[iHashIndex] = uStreamPacketIndex;
-   pDupInfo->streamsPacketsHistory[uStreamIndex].uLastReceivedPacketIndex = uStreamPacketIndex;
-   if ( uStreamPacketIndex > pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex )
-      pDupInfo->streamsPacketsHistory[uStreamIndex].uMaxReceivedPacketIndex = uStreamPacketIndex;
+   if ( uStreamPacketIndex > pStreamHistory->uMaxReceivedPacketIndex )
+   {
+      _radio_dd_advance_window(pStreamHistory, uStreamPacketIndex);
+      pStreamHistory->uMaxReceivedPacketIndex = uStreamPacketIndex;
+      *pWindowWord |= uBitMask;
+   }
+   // Packets older than the window can't be tracked anymore, let them pass
+   else if ( (pStreamHistory->uMaxReceivedPacketIndex >> 5) - (uStreamPacketIndex >> 5) < DUP_DETECTION_WINDOW_WORDS )
+   {
+      if ( *pWindowWord & uBitMask )
+      if ( (uPacketType != PACKET_TYPE_RUBY_PING_CLOCK) && (uPacketType != PACKET_TYPE_RUBY_PING_CLOCK_REPLY) )
+         return 1;
+      *pWindowWord |= uBitMask;
+   }
+   pStreamHistory->uLastReceivedPacketIndex = uStreamPacketIndex;
 
-   pDupInfo->streamsPacketsHistory[uStreamIndex].uLastTimeReceivedPacket = s_uRadioRxTimeNow;
+   pStreamHistory->uLastTimeReceivedPacket = s_uRadioRxTimeNow;
 
    // End - Check for packet duplication on stream for vehicle
    // -------------------------------------------------------------
@@ -10,6 +10,8 @@ extern "C" {
 #endif
 
 void radio_duplicate_detection_init();
+// Caches which radio interfaces are serial radios, so the rx path does not query the hardware. Call it after the radios are enumerated.
+void radio_duplicate_detection_update_radio_interfaces();
 void radio_duplicate_detection_log_info();
 
 int radio_dup_detection_is_duplicate_on_stream(int iRadioInterfaceIndex, u8* pPacketBuffer, int iPacketLength, u32 uTimeNow);
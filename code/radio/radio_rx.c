@@ -34,12 +34,47 @@
 #include "../base/encr.h"
 #include "../base/config_hw.h"
 #include "../base/hw_procs.h"
+#include "../base/trace.h"
 #include "../common/radio_stats.h"
 #include "../common/string_utils.h"
 #include "radio_rx.h"
 #include "radiolink.h"
 #include "radio_duplicate_det.h"
-#include <poll.h>
+#include "radio_rx_ring.h"
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+// Radio interfaces are read using an edge triggered epoll set. Each ready interface is drained
+// with a limited budget per pass, round robin, so one busy card can't delay the others.
+// Stats are updated on a timerfd registered in the same epoll set.
+// Optionally, one rx thread is used for each radio interface, pinned to separate cores.
+// Then only the reads run in parallel, the packets processing is serialized by a lock.
+
+#define RADIO_RX_EPOLL_ID_TIMER 0xFFFF
+#define RADIO_RX_DRAIN_BUDGET_PACKETS 8
+#define RADIO_RX_MAX_DRAIN_PASSES 3
+#define RADIO_RX_STATS_TIMER_INTERVAL_MS 250
+
+typedef struct
+{
+   int iThreadIndex;
+   int iInterfaceIndex; // -1 for all radio interfaces
+   pthread_t pThread;
+   int iThreadCreated;
+   int iEpollFd;
+   int iTimerFd;
+   int iCurrentThreadPriority;
+   u32 uTimeLastStatsTimer;
+   int iRegisteredFds[MAX_RADIO_INTERFACES];
+   void* pRegisteredPCap[MAX_RADIO_INTERFACES];
+   int iInterfacePendingReads[MAX_RADIO_INTERFACES];
+   volatile int iCanDoOperations;
+} t_radio_rx_thread_info;
+
+t_radio_rx_thread_info s_RadioRxThreads[MAX_RADIO_INTERFACES];
+int s_iRadioRxThreadsCount = 0;
+int s_iRadioRxThreadPerInterface = DEFAULT_RADIO_RX_THREAD_PER_INTERFACE;
+pthread_mutex_t s_MutexRadioRxProcessing;
 
 int s_iRadioRxInitialized = 0;
 int s_iRadioRxSingalStop = 0;
@@ -50,7 +85,6 @@ int s_iCurrentRxThreadPriority = -1;
 int s_iPendingRxThreadPriority = -1;
 
 t_radio_rx_state s_RadioRxState;
-pthread_t s_pThreadRadioRx;
 
 shared_mem_radio_stats* s_pSMRadioStats = NULL;
 int s_iSearchMode = 0;
@@ -72,14 +106,6 @@ u32 s_uRadioRxLoopLastSpikesIndex = 0;
 int s_iRadioRxPausedInterfaces[MAX_RADIO_INTERFACES];
 int s_iRadioRxAllInterfacesPaused = 0;
 
-fd_set s_RadioRxReadSet;
-fd_set s_RadioRxExceptionSet;
-int s_iRadioRxCountFDs = 0;
-int s_iRadioRxMaxFD = 0;
-struct timeval s_iRadioRxReadTimeInterval;
-
-u8 s_tmpLastProcessedRadioRxPacket[MAX_PACKET_TOTAL_SIZE];
-
 u32 s_uLastRxShortPacketsVehicleIds[MAX_RADIO_INTERFACES];
 
 // Pointers to array of int-s (max radio cards, for each card)
@@ -93,11 +119,14 @@ extern pthread_mutex_t s_pMutexRadioSyncRxTxThreads;
 extern int s_iMutexRadioSyncRxTxThreadsInitialized;
 
 volatile int s_bHasPendingOperation = 0;
-volatile int s_bCanDoOperations = 0;
 
 extern u32 s_uLastRadioPingSentTime;
 extern u8 s_uLastRadioPingId;
 
+// Direct mapped cache of vehicle id -> index in s_RadioRxState.vehicles, validated on each lookup
+#define RADIO_RX_VID_CACHE_SIZE 16
+static int s_iRadioRxVehicleIndexCache[RADIO_RX_VID_CACHE_SIZE] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+
 t_radio_rx_state_vehicle* _radio_rx_get_stats_structure_for_vehicle(u32 uVehicleId)
 {
    t_radio_rx_state_vehicle* pStatsVehicle = NULL;
@@ -108,6 +137,15 @@ t_radio_rx_state_vehicle* _radio_rx_get_stats_structure_for_vehicle(u32 uVehicle
    if ( (s_RadioRxState.vehicles[0].uVehicleId == 0) || (s_RadioRxState.vehicles[0].uVehicleId == uVehicleId)  )
       pStatsVehicle = &(s_RadioRxState.vehicles[0]);
    
+   int iCacheSlot = (int)((uVehicleId * 2654435761u) >> 28) & (RADIO_RX_VID_CACHE_SIZE-1);
+   if ( NULL == pStatsVehicle )
+   {
+      int iIndex = s_iRadioRxVehicleIndexCache[iCacheSlot];
+      if ( (iIndex > 0) && (iIndex < MAX_CONCURENT_VEHICLES) )
+      if ( s_RadioRxState.vehicles[iIndex].uVehicleId == uVehicleId )
+         return &(s_RadioRxState.vehicles[iIndex]);
+   }
+
    if ( NULL == pStatsVehicle )
    {
       for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
@@ -150,6 +188,7 @@ t_radio_rx_state_vehicle* _radio_rx_get_stats_structure_for_vehicle(u32 uVehicle
    }
 
    pStatsVehicle->uVehicleId = uVehicleId;
+   s_iRadioRxVehicleIndexCache[iCacheSlot] = (int)(pStatsVehicle - &(s_RadioRxState.vehicles[0]));
 
    // End: Compute index of stats to use
    //----------------------------------------------
@@ -218,80 +257,211 @@ int _radio_rx_update_local_stats_on_new_radio_packet(int iInterface, int iIsShor
    return nReturnLost;
 }
 
-void _radio_rx_update_fd_sets()
+static void _radio_rx_lock_processing()
 {
-   FD_ZERO(&s_RadioRxReadSet);
-   FD_ZERO(&s_RadioRxExceptionSet);
+   if ( s_iRadioRxThreadsCount > 1 )
+      pthread_mutex_lock(&s_MutexRadioRxProcessing);
+}
 
-   s_iRadioRxCountFDs = 0;
-   s_iRadioRxMaxFD = 0;
-   s_iRadioRxReadTimeInterval.tv_sec = 0;
-   s_iRadioRxReadTimeInterval.tv_usec = 50000; // 50 milisec timeout
+static void _radio_rx_unlock_processing()
+{
+   if ( s_iRadioRxThreadsCount > 1 )
+      pthread_mutex_unlock(&s_MutexRadioRxProcessing);
+}
 
-   for( int i=0; i<hardware_get_radio_interfaces_count(); i++ )
+// Adds/removes the radio interfaces handled by this thread to/from its epoll set, as they are opened, paused or broken
+
+static void _radio_rx_update_epoll_interfaces(t_radio_rx_thread_info* pThreadInfo)
+{
+   int iInterfacesCount = hardware_get_radio_interfaces_count();
+   for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
    {
-      radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(i);
-      if ( (NULL == pRadioHWInfo) || (! pRadioHWInfo->openedForRead) )
+      int iFd = -1;
+      void* pPCap = NULL;
+      if ( (i < iInterfacesCount) && ((pThreadInfo->iInterfaceIndex < 0) || (pThreadInfo->iInterfaceIndex == i)) )
+      {
+         radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(i);
+         if ( (NULL != pRadioHWInfo) && pRadioHWInfo->openedForRead )
+         if ( (! s_RadioRxState.iRadioInterfacesBroken[i]) && (! s_iRadioRxPausedInterfaces[i]) )
+         {
+            iFd = pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd;
+            pPCap = (void*)pRadioHWInfo->runtimeInterfaceInfoRx.ppcap;
+         }
+      }
+
+      // Same fd number but reopened interface? Register it again
+      if ( (iFd == pThreadInfo->iRegisteredFds[i]) && (pPCap == pThreadInfo->pRegisteredPCap[i]) )
          continue;
-      if ( s_RadioRxState.iRadioInterfacesBroken[i] )
+
+      if ( pThreadInfo->iRegisteredFds[i] >= 0 )
+      {
+         // Fails if the fd was closed meanwhile, it was then already removed from the epoll set
+         epoll_ctl(pThreadInfo->iEpollFd, EPOLL_CTL_DEL, pThreadInfo->iRegisteredFds[i], NULL);
+         pThreadInfo->iRegisteredFds[i] = -1;
+         pThreadInfo->pRegisteredPCap[i] = NULL;
+         pThreadInfo->iInterfacePendingReads[i] = 0;
+      }
+      if ( iFd < 0 )
          continue;
-      if ( s_iRadioRxPausedInterfaces[i] )
+
+      // Serial radios are read in chunks, keep them level triggered
+      struct epoll_event event;
+      memset(&event, 0, sizeof(event));
+      event.events = EPOLLIN;
+      if ( ! hardware_radio_index_is_serial_radio(i) )
+         event.events |= EPOLLET;
+      event.data.u32 = (u32)i;
+      int iRes = epoll_ctl(pThreadInfo->iEpollFd, EPOLL_CTL_ADD, iFd, &event);
+      if ( (0 != iRes) && (EEXIST == errno) )
+         iRes = epoll_ctl(pThreadInfo->iEpollFd, EPOLL_CTL_MOD, iFd, &event);
+      if ( 0 != iRes )
+      {
+         log_softerror_and_alarm("[RadioRxThread] Failed to add radio interface %d (fd %d) to epoll set, error: %d (%s)", i+1, iFd, errno, strerror(errno));
          continue;
+      }
+      log_line("[RadioRxThread] Added radio interface %d (fd %d) to rx thread %d epoll set.", i+1, iFd, pThreadInfo->iThreadIndex);
+      pThreadInfo->iRegisteredFds[i] = iFd;
+      pThreadInfo->pRegisteredPCap[i] = pPCap;
+      // Data received before registration does not generate an edge
+      pThreadInfo->iInterfacePendingReads[i] = 1;
+   }
+}
 
-      FD_SET(pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd, &s_RadioRxReadSet);
-      FD_SET(pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd, &s_RadioRxExceptionSet);
+// The rx queues are single producer (rx thread) / single consumer rings:
+// each side owns one index and publishes it with release semantics, the other side reads it with acquire.
+// The consumer spins for a short while before blocking on the semaphore, which is posted only when it's blocked.
 
-      s_iRadioRxCountFDs++;
-      if ( pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd > s_iRadioRxMaxFD )
-         s_iRadioRxMaxFD = pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd;
-   }
-   s_iRadioRxMaxFD++;
+#define RADIO_RX_QUEUE_SPIN_LOOPS 200
+
+#if defined(__x86_64__) || defined(__i386__)
+#define _radio_rx_cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define _radio_rx_cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define _radio_rx_cpu_relax() __asm__ __volatile__("" ::: "memory")
+#endif
+
+int s_iRadioRxQueueSpinLoops = 0;
+
+static int _radio_rx_queue_count_available(t_radio_rx_state_packets_queue* pQueue, int iIndexToConsume)
+{
+   int iIndexToWrite = __atomic_load_n(&pQueue->iCurrentPacketIndexToWrite, __ATOMIC_ACQUIRE);
+   int iCount = iIndexToWrite - iIndexToConsume;
+   if ( iCount < 0 )
+      iCount += pQueue->iQueueSize;
+   return iCount;
 }
 
+void _radio_rx_release_queue_packet(t_radio_rx_state_packets_queue* pQueue)
+{
+   if ( pQueue->iCountPacketsPendingRelease <= 0 )
+      return;
+
+   int iIndex = pQueue->iCurrentPacketIndexToConsume;
+   for( int i=0; i<pQueue->iCountPacketsPendingRelease; i++ )
+   {
+      if ( 0 != pQueue->uPacketsRxBufferRef[iIndex] )
+      {
+         radio_rx_ring_ref_release(pQueue->uPacketsRxBufferRef[iIndex]);
+         pQueue->uPacketsRxBufferRef[iIndex] = 0;
+      }
+      iIndex++;
+      if ( iIndex >= pQueue->iQueueSize )
+         iIndex = 0;
+   }
+   pQueue->iCountPacketsPendingRelease = 0;
 
+   // Only now the slots can be reused by the rx thread
+   __atomic_store_n(&pQueue->iCurrentPacketIndexToConsume, iIndex, __ATOMIC_RELEASE);
+}
 
-u8* _radio_rx_wait_get_queue_packet(t_radio_rx_state_packets_queue* pQueue, int iHighPriorityQueue, u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex)
+// Returns the number of packets available for consumption
+static int _radio_rx_queue_wait_for_packets(t_radio_rx_state_packets_queue* pQueue, u32 uTimeoutMicroSec)
 {
-   int iRes = -1;
+   int iIndexToConsume = pQueue->iCurrentPacketIndexToConsume;
+   int iCount = _radio_rx_queue_count_available(pQueue, iIndexToConsume);
+   if ( (iCount > 0) || (0 == uTimeoutMicroSec) )
+      return iCount;
 
-   if ( 0 == uTimeoutMicroSec )
+   for( int i=0; i<s_iRadioRxQueueSpinLoops; i++ )
    {
-      iRes = sem_trywait(pQueue->pSemaphoreRead);
+      _radio_rx_cpu_relax();
+      iCount = _radio_rx_queue_count_available(pQueue, iIndexToConsume);
+      if ( iCount > 0 )
+         return iCount;
    }
-   else
+
+   if ( NULL == pQueue->pSemaphoreRead )
+      return 0;
+
+   struct timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+   long long lNanoSec = (long long)ts.tv_nsec + 1000LL*(long long)uTimeoutMicroSec;
+   ts.tv_sec += lNanoSec / 1000000000LL;
+   ts.tv_nsec = lNanoSec % 1000000000LL;
+
+   // Announce we are going to block, then check again so a packet added meanwhile is not missed
+   __atomic_store_n(&pQueue->iConsumerWaiting, 1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   iCount = _radio_rx_queue_count_available(pQueue, iIndexToConsume);
+   while ( 0 == iCount )
    {
-      struct timespec ts;
-      clock_gettime(CLOCK_REALTIME, &ts);
-      ts.tv_nsec += 1000LL*(long long)uTimeoutMicroSec;
-      iRes = sem_timedwait(pQueue->pSemaphoreRead, &ts);
+      // Stale posts (from packets already consumed without blocking) just wake us up earlier
+      if ( 0 != sem_timedwait(pQueue->pSemaphoreRead, &ts) )
+      if ( errno != EINTR )
+         break;
+      iCount = _radio_rx_queue_count_available(pQueue, iIndexToConsume);
    }
-   if ( 0 != iRes )
-      return NULL;
+   __atomic_store_n(&pQueue->iConsumerWaiting, 0, __ATOMIC_RELAXED);
+   return _radio_rx_queue_count_available(pQueue, iIndexToConsume);
+}
 
-   int iIndexToCopy = 0;
+int _radio_rx_wait_get_queue_packets(t_radio_rx_state_packets_queue* pQueue, u32 uTimeoutMicroSec, type_received_radio_packet* pPackets, int iMaxPackets)
+{
+   _radio_rx_release_queue_packet(pQueue);
 
-   iIndexToCopy = pQueue->iCurrentPacketIndexToConsume;
-   if ( (iIndexToCopy < 0) || (iIndexToCopy >= pQueue->iQueueSize) )
-      return NULL;
-   if ( (pQueue->iPacketsLengths[iIndexToCopy] <= 0) || (pQueue->iPacketsLengths[iIndexToCopy] > MAX_PACKET_TOTAL_SIZE) )
-      return NULL;
-   if ( NULL == pQueue->pPacketsBuffers[iIndexToCopy] )
+   int iCount = _radio_rx_queue_wait_for_packets(pQueue, uTimeoutMicroSec);
+   if ( iCount > iMaxPackets )
+      iCount = iMaxPackets;
+   if ( iCount <= 0 )
+      return 0;
+
+   // Packets are handed out in place; the slots are released on the next call or explicitly
+   pQueue->iCountPacketsPendingRelease = iCount;
+
+   int iCountValid = 0;
+   int iIndex = pQueue->iCurrentPacketIndexToConsume;
+   for( int i=0; i<iCount; i++ )
+   {
+      if ( (pQueue->iPacketsLengths[iIndex] > 0) && (pQueue->iPacketsLengths[iIndex] <= MAX_PACKET_TOTAL_SIZE) )
+      if ( NULL != pQueue->pPacketsData[iIndex] )
+      {
+         pPackets[iCountValid].pPacketData = pQueue->pPacketsData[iIndex];
+         pPackets[iCountValid].iPacketLength = pQueue->iPacketsLengths[iIndex];
+         pPackets[iCountValid].iPacketIsShort = pQueue->uPacketsAreShort[iIndex];
+         pPackets[iCountValid].iPacketRxInterface = pQueue->uPacketsRxInterface[iIndex];
+         iCountValid++;
+      }
+      iIndex++;
+      if ( iIndex >= pQueue->iQueueSize )
+         iIndex = 0;
+   }
+   return iCountValid;
+}
+
+u8* _radio_rx_wait_get_queue_packet(t_radio_rx_state_packets_queue* pQueue, u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex)
+{
+   type_received_radio_packet packet;
+   if ( 0 == _radio_rx_wait_get_queue_packets(pQueue, uTimeoutMicroSec, &packet, 1) )
       return NULL;
 
    if ( NULL != pLength )
-      *pLength = pQueue->iPacketsLengths[iIndexToCopy];
+      *pLength = packet.iPacketLength;
    if ( NULL != pIsShortPacket )
-      *pIsShortPacket = pQueue->uPacketsAreShort[iIndexToCopy];
+      *pIsShortPacket = packet.iPacketIsShort;
    if ( NULL != pRadioInterfaceIndex )
-      *pRadioInterfaceIndex = pQueue->uPacketsRxInterface[iIndexToCopy];
-
-   memcpy(s_tmpLastProcessedRadioRxPacket, pQueue->pPacketsBuffers[iIndexToCopy], pQueue->iPacketsLengths[iIndexToCopy]);
-
-   pQueue->iCurrentPacketIndexToConsume++;
-   if ( pQueue->iCurrentPacketIndexToConsume >= pQueue->iQueueSize )
-      pQueue->iCurrentPacketIndexToConsume = 0;
-
-   return s_tmpLastProcessedRadioRxPacket;
+      *pRadioInterfaceIndex = packet.iPacketRxInterface;
+   return packet.pPacketData;
 }
 
 u8* radio_rx_wait_get_next_received_high_prio_packet(u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex)
@@ -305,7 +475,7 @@ u8* radio_rx_wait_get_next_received_high_prio_packet(u32 uTimeoutMicroSec, int*
    if ( 0 == s_iRadioRxInitialized )
       return NULL;
 
-   return _radio_rx_wait_get_queue_packet(&(s_RadioRxState.queue_high_priority), 1, uTimeoutMicroSec, pLength, pIsShortPacket, pRadioInterfaceIndex);
+   return _radio_rx_wait_get_queue_packet(&(s_RadioRxState.queue_high_priority), uTimeoutMicroSec, pLength, pIsShortPacket, pRadioInterfaceIndex);
 }
 
 u8* radio_rx_wait_get_next_received_reg_prio_packet(u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex)
@@ -319,10 +489,39 @@ u8* radio_rx_wait_get_next_received_reg_prio_packet(u32 uTimeoutMicroSec, int* p
    if ( 0 == s_iRadioRxInitialized )
       return NULL;
 
-   return _radio_rx_wait_get_queue_packet(&(s_RadioRxState.queue_reg_priority), 0, uTimeoutMicroSec, pLength, pIsShortPacket, pRadioInterfaceIndex);
+   return _radio_rx_wait_get_queue_packet(&(s_RadioRxState.queue_reg_priority), uTimeoutMicroSec, pLength, pIsShortPacket, pRadioInterfaceIndex);
 }
 
-void _radio_rx_add_packet_to_rx_queue(u8* pPacket, int iLength, int iRadioInterface)
+int radio_rx_wait_get_next_received_high_prio_packets(u32 uTimeoutMicroSec, type_received_radio_packet* pPackets, int iMaxPackets)
+{
+   if ( (0 == s_iRadioRxInitialized) || (NULL == pPackets) || (iMaxPackets <= 0) )
+      return 0;
+   return _radio_rx_wait_get_queue_packets(&(s_RadioRxState.queue_high_priority), uTimeoutMicroSec, pPackets, iMaxPackets);
+}
+
+int radio_rx_wait_get_next_received_reg_prio_packets(u32 uTimeoutMicroSec, type_received_radio_packet* pPackets, int iMaxPackets)
+{
+   if ( (0 == s_iRadioRxInitialized) || (NULL == pPackets) || (iMaxPackets <= 0) )
+      return 0;
+   return _radio_rx_wait_get_queue_packets(&(s_RadioRxState.queue_reg_priority), uTimeoutMicroSec, pPackets, iMaxPackets);
+}
+
+void radio_rx_release_high_prio_packet()
+{
+   if ( 0 == s_iRadioRxInitialized )
+      return;
+   _radio_rx_release_queue_packet(&(s_RadioRxState.queue_high_priority));
+}
+
+void radio_rx_release_reg_prio_packet()
+{
+   if ( 0 == s_iRadioRxInitialized )
+      return;
+   _radio_rx_release_queue_packet(&(s_RadioRxState.queue_reg_priority));
+}
+
+// uRxBufferRef: non zero if pPacket is a frame inside the rx mmap ring. It's then queued by reference.
+void _radio_rx_add_packet_to_rx_queue(u8* pPacket, int iLength, int iRadioInterface, u32 uRxBufferRef)
 {
    if ( (NULL == pPacket) || (iLength <= 0) || s_iRadioRxMarkedForQuit )
       return;
@@ -335,41 +534,61 @@ void _radio_rx_add_packet_to_rx_queue(u8* pPacket, int iLength, int iRadioInterf
    if ( radio_packet_type_is_high_priority(uPacketFlags, uPacketType) )
       pQueue = &s_RadioRxState.queue_high_priority;
 
+   int iIndexToWrite = pQueue->iCurrentPacketIndexToWrite;
+   int iIndexNext = iIndexToWrite + 1;
+   if ( iIndexNext >= pQueue->iQueueSize )
+      iIndexNext = 0;
+
    // No more room? Discard it
-   if ( ((pQueue->iCurrentPacketIndexToWrite+1) % pQueue->iQueueSize) == (pQueue->iCurrentPacketIndexToConsume % pQueue->iQueueSize) )
+   int iIndexToConsume = __atomic_load_n(&pQueue->iCurrentPacketIndexToConsume, __ATOMIC_ACQUIRE);
+   if ( iIndexNext == iIndexToConsume )
    {
-      //s_uRadioRxLastTimeQueue += get_current_timestamp_ms() - s_uRadioRxTimeNow;
+      pQueue->uStatsDroppedPackets++;
       return;
    }
 
    // Add the packet to the queue
-   pQueue->uPacketsRxInterface[pQueue->iCurrentPacketIndexToWrite] = iRadioInterface;
-   pQueue->uPacketsAreShort[pQueue->iCurrentPacketIndexToWrite] = 0;
-   pQueue->iPacketsLengths[pQueue->iCurrentPacketIndexToWrite] = iLength;
-   memcpy(pQueue->pPacketsBuffers[pQueue->iCurrentPacketIndexToWrite], pPacket, iLength);
-      
-   pQueue->iCurrentPacketIndexToWrite++;
-   if ( pQueue->iCurrentPacketIndexToWrite >= pQueue->iQueueSize )
-      pQueue->iCurrentPacketIndexToWrite = 0;
+   pQueue->uPacketsRxInterface[iIndexToWrite] = iRadioInterface;
+   pQueue->uPacketsAreShort[iIndexToWrite] = 0;
+   pQueue->iPacketsLengths[iIndexToWrite] = iLength;
+   // Too many ring blocks pinned by queued frames? Copy this one out so the ring keeps free blocks for the kernel
+   if ( (0 != uRxBufferRef) && radio_rx_ring_must_copy_frame(uRxBufferRef) )
+      uRxBufferRef = 0;
+   if ( 0 != uRxBufferRef )
+   {
+      radio_rx_ring_ref_acquire(uRxBufferRef);
+      pQueue->pPacketsData[iIndexToWrite] = pPacket;
+   }
+   else
+   {
+      memcpy(pQueue->pPacketsBuffers[iIndexToWrite], pPacket, iLength);
+      pQueue->pPacketsData[iIndexToWrite] = pQueue->pPacketsBuffers[iIndexToWrite];
+   }
+   pQueue->uPacketsRxBufferRef[iIndexToWrite] = uRxBufferRef;
+
+   // Publish the packet to the consumer
+   __atomic_store_n(&pQueue->iCurrentPacketIndexToWrite, iIndexNext, __ATOMIC_RELEASE);
 
-   int iCountPackets = pQueue->iCurrentPacketIndexToWrite - pQueue->iCurrentPacketIndexToConsume;
-   if ( pQueue->iCurrentPacketIndexToWrite < pQueue->iCurrentPacketIndexToConsume )
-      iCountPackets = pQueue->iCurrentPacketIndexToWrite + (pQueue->iQueueSize - pQueue->iCurrentPacketIndexToConsume);
+   int iCountPackets = iIndexNext - iIndexToConsume;
+   if ( iCountPackets < 0 )
+      iCountPackets += pQueue->iQueueSize;
 
    if ( iCountPackets > pQueue->iStatsMaxPacketsInQueueLastMinute )
       pQueue->iStatsMaxPacketsInQueueLastMinute = iCountPackets;
    if ( iCountPackets > pQueue->iStatsMaxPacketsInQueue )
       pQueue->iStatsMaxPacketsInQueue = iCountPackets;
 
+   // Wake up the consumer only if it's blocked (pairs with the fence in _radio_rx_queue_wait_for_packets)
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if ( __atomic_load_n(&pQueue->iConsumerWaiting, __ATOMIC_RELAXED) )
    if ( NULL != pQueue->pSemaphoreWrite )
    {
       if ( 0 != sem_post(pQueue->pSemaphoreWrite) )
          log_softerror_and_alarm("Failed to set semaphore for packet ready.");
    }
-   //s_uRadioRxLastTimeQueue += get_current_timestamp_ms() - s_uRadioRxTimeNow;
 }
 
-void _radio_rx_check_add_packet_to_rx_queue(u8* pPacket, int iLength, int iRadioInterfaceIndex)
+void _radio_rx_check_add_packet_to_rx_queue(u8* pPacket, int iLength, int iRadioInterfaceIndex, u32 uRxBufferRef)
 {
    if ( radio_dup_detection_is_duplicate_on_stream(iRadioInterfaceIndex, pPacket, iLength, s_uRadioRxTimeNow) )
       return;
@@ -377,7 +596,7 @@ void _radio_rx_check_add_packet_to_rx_queue(u8* pPacket, int iLength, int iRadio
    if ( NULL != s_pSMRadioStats )
      radio_stats_update_on_unique_packet_received(s_pSMRadioStats, s_uRadioRxTimeNow, iRadioInterfaceIndex, pPacket, iLength);
 
-   _radio_rx_add_packet_to_rx_queue(pPacket, iLength, iRadioInterfaceIndex);
+   _radio_rx_add_packet_to_rx_queue(pPacket, iLength, iRadioInterfaceIndex, uRxBufferRef);
 }
 
 
@@ -447,7 +666,7 @@ int _radio_rx_process_serial_short_packet(int iInterfaceIndex, u8* pPacketBuffer
          if ( (uCRC & 0x00FFFFFF) == (pPH->uCRC & 0x00FFFFFF) )
          {
             s_uBuffersFullMessagesReadPos[iInterfaceIndex] = 0;
-            _radio_rx_check_add_packet_to_rx_queue(s_uBuffersFullMessages[iInterfaceIndex], pPH->total_length, iInterfaceIndex);
+            _radio_rx_check_add_packet_to_rx_queue(s_uBuffersFullMessages[iInterfaceIndex], pPH->total_length, iInterfaceIndex, 0);
          }
       }
    }
@@ -563,6 +782,93 @@ int _radio_rx_parse_received_serial_radio_data(int iInterfaceIndex)
    return iRead;
 }
 
+// Processes one received radio frame. Called with the processing lock held when running one rx thread per interface.
+
+void _radio_rx_process_received_wifi_radio_packet(int iInterfaceIndex, u8* pPacketBuffer, int iBufferLength, u32 uRxBufferRef)
+{
+   int iDataIsOk = 1;
+   t_packet_header* pPH = (t_packet_header*)pPacketBuffer;
+   u8 uPacketFlags = pPH->packet_flags;
+   u8 uPacketType = pPH->packet_type;
+   u32 uVehicleId = pPH->vehicle_id_src;
+
+   TRACE_INSTANT(TRACE_EVENT_RADIO_RX_PACKET, iInterfaceIndex, iBufferLength, pPH->stream_packet_idx);
+
+   if ( s_iRadioRxDevMode )
+   if ( uPacketType == PACKET_TYPE_RUBY_PING_CLOCK )
+   {
+      s_uLastRadioPingSentTime = get_current_timestamp_ms();
+      s_uLastRadioPingId = *(pPacketBuffer +sizeof(t_packet_header));
+   }
+
+   if ( radio_packet_type_is_high_priority(uPacketFlags, uPacketType) )
+   {
+      if ( NULL != s_pPacketsCounterOutputHighPriority )
+         s_pPacketsCounterOutputHighPriority[iInterfaceIndex]++;
+   }
+   else
+   {      
+      if ( NULL != s_pPacketsCounterOutputData )
+         s_pPacketsCounterOutputData[iInterfaceIndex]++;
+   }
+   // To fix
+   /*
+   if ( (pPH->packet_flags & PACKET_FLAGS_MASK_MODULE) == PACKET_COMPONENT_VIDEO )
+   {
+      t_packet_header_video_full_77* pPHVF = (t_packet_header_video_full_77*) (pPacketBuffer+sizeof(t_packet_header));    
+      if ( ! (pPH->packet_flags & PACKET_FLAGS_BIT_RETRANSMITED) )
+      if ( pPHVF->uVideoStatusFlags2 & VIDEO_STATUS_FLAGS2_HAS_DEBUG_TIMESTAMPS )
+      if ( pPHVF->video_block_packet_index < pPHVF->block_packets)
+      {
+         u8* pExtraData = pPacketBuffer + sizeof(t_packet_header) + sizeof(t_packet_header_video_full_77) + pPHVF->video_data_length;
+         u32* pExtraDataU32 = (u32*)pExtraData;
+         pExtraDataU32[4] = get_current_timestamp_ms();
+      }
+   }
+   */
+   int bCRCOk = 0;
+   int iPacketLength = packet_process_and_check(iInterfaceIndex, pPacketBuffer, iBufferLength, &bCRCOk);
+
+   if ( iPacketLength <= 0 )
+   {
+      log_softerror_and_alarm("[RadioRxThread] Process and check packet of %d bytes failed, error: %d", iBufferLength, get_last_processing_error_code());
+      s_RadioRxState.iRadioInterfacesRxBadPackets[iInterfaceIndex] = get_last_processing_error_code();
+      return;
+   }
+
+   if ( ! bCRCOk )
+   {
+      log_softerror_and_alarm("[RadioRxThread] Received broken packet (wrong CRC) on radio interface %d. Packet size: %d bytes, type: %s",
+         iInterfaceIndex+1, pPH->total_length, str_get_packet_type(pPH->packet_type));
+      return;
+   }
+
+   _radio_rx_check_add_packet_to_rx_queue(pPacketBuffer, iPacketLength, iInterfaceIndex, uRxBufferRef);
+ 
+   if ( NULL != s_pRxAirGapTracking )
+   {
+      s_uRadioRxTimeNow = get_current_timestamp_ms();
+      u32 uGap = s_uRadioRxTimeNow - s_uRadioRxLastReceivedPacket;
+      if ( uGap > 255 )
+         uGap = 255;
+      if ( uGap > *s_pRxAirGapTracking )
+         *s_pRxAirGapTracking = uGap;
+      s_uRadioRxLastReceivedPacket = s_uRadioRxTimeNow;
+   }
+
+   int nLost = _radio_rx_update_local_stats_on_new_radio_packet(iInterfaceIndex, 0, uVehicleId, pPacketBuffer, iBufferLength, iDataIsOk);
+   if ( nLost > 0 )
+   {
+      if ( NULL != s_pPacketsCounterOutputMissing)
+         s_pPacketsCounterOutputMissing[iInterfaceIndex]++;
+      if ( NULL != s_pPacketsCounterOutputMissingMaxGap )
+      if ( nLost > s_pPacketsCounterOutputMissingMaxGap[iInterfaceIndex] )
+         s_pPacketsCounterOutputMissingMaxGap[iInterfaceIndex] = (u8)nLost;
+   }
+   if ( NULL != s_pSMRadioStats )
+      radio_stats_update_on_new_radio_packet_received(s_pSMRadioStats, s_uRadioRxTimeNow, iInterfaceIndex, pPacketBuffer, iBufferLength, 0, iDataIsOk);
+}
+
 // return number of packets parsed, -1 if the interface is now invalid or broken
 
 int _radio_rx_parse_received_wifi_radio_data(int iInterfaceIndex, int iMaxReads)
@@ -571,111 +877,29 @@ int _radio_rx_parse_received_wifi_radio_data(int iInterfaceIndex, int iMaxReads)
       return 0;
 
    int iReturn = 0;
-   int iDataIsOk = 1;
    int iBufferLength = 0;
    u8* pPacketBuffer = NULL;
+   u32 uRxBufferRef = 0;
    int iCountParsed = 0;
 
-   //static int sdebugCountParser = 0;
-   //sdebugCountParser++;
-
    for( int iCountReads=0; iCountReads<iMaxReads; iCountReads++ )
    {
       iBufferLength = 0;
-      pPacketBuffer = radio_process_wlan_data_in(iInterfaceIndex, &iBufferLength, s_uRadioRxTimeNow);
+      pPacketBuffer = radio_process_wlan_data_in_zero_copy(iInterfaceIndex, &iBufferLength, s_uRadioRxTimeNow, &uRxBufferRef);
       if ( NULL == pPacketBuffer )
          break;
 
       if ( iBufferLength <= 0 )
       {
          log_softerror_and_alarm("[RadioRxThread] Rx cap returned an empty buffer (%d length) on radio interface index %d.", iBufferLength, iInterfaceIndex+1);
-         iDataIsOk = 0;
          iReturn = -1;
          break;
       }
 
       iCountParsed++;
-      iDataIsOk = 1;
-      t_packet_header* pPH = (t_packet_header*)pPacketBuffer;
-      u8 uPacketFlags = pPH->packet_flags;
-      u8 uPacketType = pPH->packet_type;
-      u32 uVehicleId = pPH->vehicle_id_src;
-   
-      if ( s_iRadioRxDevMode )
-      if ( uPacketType == PACKET_TYPE_RUBY_PING_CLOCK )
-      {
-         s_uLastRadioPingSentTime = get_current_timestamp_ms();
-         s_uLastRadioPingId = *(pPacketBuffer +sizeof(t_packet_header));
-      }
-
-      if ( radio_packet_type_is_high_priority(uPacketFlags, uPacketType) )
-      {
-         if ( NULL != s_pPacketsCounterOutputHighPriority )
-            s_pPacketsCounterOutputHighPriority[iInterfaceIndex]++;
-      }
-      else
-      {      
-         if ( NULL != s_pPacketsCounterOutputData )
-            s_pPacketsCounterOutputData[iInterfaceIndex]++;
-      }
-      // To fix
-      /*
-      if ( (pPH->packet_flags & PACKET_FLAGS_MASK_MODULE) == PACKET_COMPONENT_VIDEO )
-      {
-         t_packet_header_video_full_77* pPHVF = (t_packet_header_video_full_77*) (pPacketBuffer+sizeof(t_packet_header));    
-         if ( ! (pPH->packet_flags & PACKET_FLAGS_BIT_RETRANSMITED) )
-         if ( pPHVF->uVideoStatusFlags2 & VIDEO_STATUS_FLAGS2_HAS_DEBUG_TIMESTAMPS )
-         if ( pPHVF->video_block_packet_index < pPHVF->block_packets)
-         {
-            u8* pExtraData = pPacketBuffer + sizeof(t_packet_header) + sizeof(t_packet_header_video_full_77) + pPHVF->video_data_length;
-            u32* pExtraDataU32 = (u32*)pExtraData;
-            pExtraDataU32[4] = get_current_timestamp_ms();
-         }
-      }
-      */
-      int bCRCOk = 0;
-      int iPacketLength = packet_process_and_check(iInterfaceIndex, pPacketBuffer, iBufferLength, &bCRCOk);
-
-      if ( iPacketLength <= 0 )
-      {
-         log_softerror_and_alarm("[RadioRxThread] Process and check packet of %d bytes failed, error: %d", iBufferLength, get_last_processing_error_code());
-         iDataIsOk = 0;
-         s_RadioRxState.iRadioInterfacesRxBadPackets[iInterfaceIndex] = get_last_processing_error_code();
-         continue;
-      }
-
-      if ( ! bCRCOk )
-      {
-         log_softerror_and_alarm("[RadioRxThread] Received broken packet (wrong CRC) on radio interface %d. Packet size: %d bytes, type: %s",
-            iInterfaceIndex+1, pPH->total_length, str_get_packet_type(pPH->packet_type));
-         iDataIsOk = 0;
-         continue;
-      }
-
-      _radio_rx_check_add_packet_to_rx_queue(pPacketBuffer, iPacketLength, iInterfaceIndex);
-    
-      if ( NULL != s_pRxAirGapTracking )
-      {
-         s_uRadioRxTimeNow = get_current_timestamp_ms();
-         u32 uGap = s_uRadioRxTimeNow - s_uRadioRxLastReceivedPacket;
-         if ( uGap > 255 )
-            uGap = 255;
-         if ( uGap > *s_pRxAirGapTracking )
-            *s_pRxAirGapTracking = uGap;
-         s_uRadioRxLastReceivedPacket = s_uRadioRxTimeNow;
-      }
-
-      int nLost = _radio_rx_update_local_stats_on_new_radio_packet(iInterfaceIndex, 0, uVehicleId, pPacketBuffer, iBufferLength, iDataIsOk);
-      if ( nLost > 0 )
-      {
-         if ( NULL != s_pPacketsCounterOutputMissing)
-            s_pPacketsCounterOutputMissing[iInterfaceIndex]++;
-         if ( NULL != s_pPacketsCounterOutputMissingMaxGap )
-         if ( nLost > s_pPacketsCounterOutputMissingMaxGap[iInterfaceIndex] )
-            s_pPacketsCounterOutputMissingMaxGap[iInterfaceIndex] = (u8)nLost;
-      }
-      if ( NULL != s_pSMRadioStats )
-         radio_stats_update_on_new_radio_packet_received(s_pSMRadioStats, s_uRadioRxTimeNow, iInterfaceIndex, pPacketBuffer, iBufferLength, 0, iDataIsOk);
+      _radio_rx_lock_processing();
+      _radio_rx_process_received_wifi_radio_packet(iInterfaceIndex, pPacketBuffer, iBufferLength, uRxBufferRef);
+      _radio_rx_unlock_processing();
    }
 
    if ( iReturn < 0 )
@@ -744,16 +968,15 @@ void _radio_rx_update_stats(u32 uTimeNow)
       s_RadioRxState.queue_high_priority.iStatsMaxPacketsInQueueLastMinute = 0;
       s_RadioRxState.queue_reg_priority.iStatsMaxPacketsInQueueLastMinute = 0;
 
-      int iCountPacketsHigh = s_RadioRxState.queue_high_priority.iCurrentPacketIndexToWrite - s_RadioRxState.queue_high_priority.iCurrentPacketIndexToConsume;
-      if ( s_RadioRxState.queue_high_priority.iCurrentPacketIndexToWrite < s_RadioRxState.queue_high_priority.iCurrentPacketIndexToConsume )
-         iCountPacketsHigh = s_RadioRxState.queue_high_priority.iCurrentPacketIndexToWrite + (s_RadioRxState.queue_high_priority.iQueueSize - s_RadioRxState.queue_high_priority.iCurrentPacketIndexToConsume);
+      int iCountPacketsHigh = _radio_rx_queue_count_available(&s_RadioRxState.queue_high_priority, __atomic_load_n(&s_RadioRxState.queue_high_priority.iCurrentPacketIndexToConsume, __ATOMIC_ACQUIRE));
+      int iCountPacketsReg = _radio_rx_queue_count_available(&s_RadioRxState.queue_reg_priority, __atomic_load_n(&s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume, __ATOMIC_ACQUIRE));
 
-      int iCountPacketsReg = s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToWrite - s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume;
-      if ( s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToWrite < s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume )
-         iCountPacketsReg = s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToWrite + (s_RadioRxState.queue_reg_priority.iQueueSize - s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume);
+      log_line("[RadioRxThread] Packets in queues now pending consumption (high/reg prio): %d/%d, dropped on full queues: %u/%u",
+         iCountPacketsHigh, iCountPacketsReg,
+         s_RadioRxState.queue_high_priority.uStatsDroppedPackets, s_RadioRxState.queue_reg_priority.uStatsDroppedPackets);
 
-      log_line("[RadioRxThread] Packets in queues now pending consumption (high/reg prio): %d/%d",
-         iCountPacketsHigh, iCountPacketsReg);
+      for( int i=0; i<hardware_get_radio_interfaces_count(); i++ )
+         radio_rx_ring_log_stats(i);
 
       if ( (s_iCounterRadioRxStatsUpdate2 % 10) == 0 )
       {
@@ -783,25 +1006,120 @@ void _radio_rx_update_stats(u32 uTimeNow)
    }
 }
 
+// Returns the number of packets parsed on the pending interfaces
+
+static int _radio_rx_drain_pending_interfaces(t_radio_rx_thread_info* pThreadInfo)
+{
+   int iParsedPackets = 0;
+   int iAnyPending = 0;
+   int iPasses = RADIO_RX_MAX_DRAIN_PASSES;
+   int iInterfacesCount = hardware_get_radio_interfaces_count();
+   if ( iInterfacesCount > MAX_RADIO_INTERFACES )
+      iInterfacesCount = MAX_RADIO_INTERFACES;
+
+   do
+   {
+      iPasses--;
+      iAnyPending = 0;
+      for( int iInterfaceIndex=0; iInterfaceIndex<iInterfacesCount; iInterfaceIndex++ )
+      {
+         if ( ! pThreadInfo->iInterfacePendingReads[iInterfaceIndex] )
+            continue;
+         if ( s_RadioRxState.iRadioInterfacesBroken[iInterfaceIndex] || s_iRadioRxPausedInterfaces[iInterfaceIndex] )
+         {
+            pThreadInfo->iInterfacePendingReads[iInterfaceIndex] = 0;
+            continue;
+         }
+
+         if ( hardware_radio_index_is_serial_radio(iInterfaceIndex) )
+         {
+            // Level triggered, epoll reports it again if there is more data
+            pThreadInfo->iInterfacePendingReads[iInterfaceIndex] = 0;
+            _radio_rx_lock_processing();
+            int iRes = _radio_rx_parse_received_serial_radio_data(iInterfaceIndex);
+            _radio_rx_unlock_processing();
+            if ( iRes < 0 )
+            {
+               log_line("[RadioRx] Mark serial radio interface %d as broken", iInterfaceIndex+1);
+               s_RadioRxState.iRadioInterfacesBroken[iInterfaceIndex] = 1;
+            }
+            continue;
+         }
+
+         int iRes = _radio_rx_parse_received_wifi_radio_data(iInterfaceIndex, RADIO_RX_DRAIN_BUDGET_PACKETS);
+         if ( (iRes < 0) || ( radio_get_last_read_error_code() == RADIO_READ_ERROR_INTERFACE_BROKEN ) )
+         {
+            log_line("[RadioRx] Mark radio interface %d as broken", iInterfaceIndex+1);
+            s_RadioRxState.iRadioInterfacesBroken[iInterfaceIndex] = 1;
+            pThreadInfo->iInterfacePendingReads[iInterfaceIndex] = 0;
+            continue;
+         }
+         iParsedPackets += iRes;
+
+         // Edge triggered: keep reading it until it's drained
+         if ( iRes < RADIO_RX_DRAIN_BUDGET_PACKETS )
+            pThreadInfo->iInterfacePendingReads[iInterfaceIndex] = 0;
+         else
+            iAnyPending = 1;
+      }
+   } while ( iAnyPending && (iPasses > 0) );
+
+   return iParsedPackets;
+}
+
+static void _radio_rx_on_stats_timer(t_radio_rx_thread_info* pThreadInfo, u32 uTimeNow)
+{
+   pThreadInfo->uTimeLastStatsTimer = uTimeNow;
+   if ( pThreadInfo->iTimerFd >= 0 )
+   {
+      uint64_t uExpirations = 0;
+      if ( read(pThreadInfo->iTimerFd, &uExpirations, sizeof(uExpirations)) < 0 )
+      if ( (EAGAIN != errno) && (EINTR != errno) )
+         log_softerror_and_alarm("[RadioRxThread] Failed to read stats timer, error: %d", errno);
+   }
+   _radio_rx_lock_processing();
+   _radio_rx_update_stats(uTimeNow);
+   _radio_rx_unlock_processing();
+}
+
 void * _thread_radio_rx(void *argument)
 {
-   log_line("[RadioRxThread] Started.");
+   t_radio_rx_thread_info* pThreadInfo = (t_radio_rx_thread_info*) argument;
+   char szLogPrefix[64];
+   if ( s_iRadioRxThreadsCount > 1 )
+      sprintf(szLogPrefix, "[RadioRxThread-%d]", pThreadInfo->iThreadIndex+1);
+   else
+      strcpy(szLogPrefix, "[RadioRxThread]");
+
+   log_line("%s Started, radio interface: %d.", szLogPrefix, pThreadInfo->iInterfaceIndex+1);
 
    if ( s_iPendingRxThreadPriority > 0 )
-   if ( s_iPendingRxThreadPriority != s_iCurrentRxThreadPriority )
+   if ( s_iPendingRxThreadPriority != pThreadInfo->iCurrentThreadPriority )
    {
-      hw_increase_current_thread_priority("[RadioRxThread]", s_iPendingRxThreadPriority);
-      s_iCurrentRxThreadPriority = s_iPendingRxThreadPriority;
+      hw_increase_current_thread_priority(szLogPrefix, s_iPendingRxThreadPriority);
+      pThreadInfo->iCurrentThreadPriority = s_iPendingRxThreadPriority;
    }
 
+   // Leave the first core to the main processing loop
+   if ( s_iRadioRxThreadsCount > 1 )
+   {
+      int iCores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+      if ( iCores > 1 )
+      {
+         int iCore = 1 + (pThreadInfo->iThreadIndex % (iCores-1));
+         hw_set_current_thread_affinity(szLogPrefix, iCore, iCore);
+      }
+   }
+
+   if ( 0 == pThreadInfo->iThreadIndex )
    for( int i=0; i<MAX_SPIKES_TO_LOG; i++ )
    {
       s_uRadioRxLoopLastSpikesTimes[i] = 0;
       s_uRadioRxLoopLastSpikesRxPackets[i] = 0;
    }
-   log_line("[RadioRxThread] Initialized State. Waiting for rx messages...");
+   log_line("%s Initialized State. Waiting for rx messages...", szLogPrefix);
 
-   int* piQuit = (int*) argument;
+   int iHandlesStats = (0 == pThreadInfo->iThreadIndex)?1:0;
    int iPollTimeoutMs = 10;
    int iLoopCounter = 0;
    int iLoopParsedPackets = 0;
@@ -809,19 +1127,20 @@ void * _thread_radio_rx(void *argument)
    u32 uTimeLastLoopCheck = get_current_timestamp_ms();
    u32 uTimeReadSignaled = 0;
    u32 uTimeNow = 0;
+   struct epoll_event events[MAX_RADIO_INTERFACES+1];
 
    while ( 1 )
    {
       iLoopCounter++;
-      if ( (NULL != piQuit) && (*piQuit != 0 ) )
+      if ( s_iRadioRxSingalStop )
       {
-         log_line("[RadioRxThread] Signaled to stop.");
+         log_line("%s Signaled to stop.", szLogPrefix);
          break;
       }
       if ( s_iRadioRxMarkedForQuit )
       {
          if ( iLoopCounter )
-            log_line("[RadioRxThread] Rx marked for quit. Do nothing.");
+            log_line("%s Rx marked for quit. Do nothing.", szLogPrefix);
          iLoopCounter = -1;
          hardware_sleep_ms(5);
          continue;
@@ -829,21 +1148,24 @@ void * _thread_radio_rx(void *argument)
 
       if ( s_bHasPendingOperation )
       {
-         s_bCanDoOperations = 1;
+         pThreadInfo->iCanDoOperations = 1;
          hardware_sleep_ms(1);
          continue;
       }
       
-      s_bCanDoOperations = 0;
+      pThreadInfo->iCanDoOperations = 0;
       uTimeNow = s_uRadioRxTimeNow = get_current_timestamp_ms();
 
       u32 uDeltaTime = uTimeNow - uTimeLastLoopCheck;
 
-      if ( uDeltaTime < s_uRadioRxLoopTimeMin )
-         s_uRadioRxLoopTimeMin = uDeltaTime;
-      if ( uDeltaTime > s_uRadioRxLoopTimeMax )
-         s_uRadioRxLoopTimeMax = uDeltaTime;
-      s_uRadioRxLoopTimeAvg = (s_uRadioRxLoopTimeAvg * 99 + uDeltaTime)/100;
+      if ( iHandlesStats )
+      {
+         if ( uDeltaTime < s_uRadioRxLoopTimeMin )
+            s_uRadioRxLoopTimeMin = uDeltaTime;
+         if ( uDeltaTime > s_uRadioRxLoopTimeMax )
+            s_uRadioRxLoopTimeMax = uDeltaTime;
+         s_uRadioRxLoopTimeAvg = (s_uRadioRxLoopTimeAvg * 99 + uDeltaTime)/100;
+      }
       
       if ( iLoopCounter > 1 )
       {
@@ -863,6 +1185,7 @@ void * _thread_radio_rx(void *argument)
       uTimeLastLoopCheck = uTimeNow;
 
       uDeltaTime = uTimeNow - uTimeReadSignaled;
+      if ( iHandlesStats )
       if ( (uDeltaTime >= 4) && (0 != uTimeReadSignaled) )
       {
          s_uRadioRxLoopSpikesCount++;
@@ -876,134 +1199,182 @@ void * _thread_radio_rx(void *argument)
 
       }
 
-      // Loop is executed every 10 ms max. So check and update stats about every 250 ms max
-
-      if ( 0 == (iLoopCounter % 20) )
+      if ( s_iPendingRxThreadPriority != pThreadInfo->iCurrentThreadPriority )
       {
-         _radio_rx_update_stats(uTimeNow);
-         if ( s_iPendingRxThreadPriority != s_iCurrentRxThreadPriority )
-         {
-            log_line("[RadioRxThread] New thread priority must be set, from %d to %d.", s_iCurrentRxThreadPriority, s_iPendingRxThreadPriority);
+         log_line("%s New thread priority must be set, from %d to %d.", szLogPrefix, pThreadInfo->iCurrentThreadPriority, s_iPendingRxThreadPriority);
+         pThreadInfo->iCurrentThreadPriority = s_iPendingRxThreadPriority;
+         if ( iHandlesStats )
             s_iCurrentRxThreadPriority = s_iPendingRxThreadPriority;
 
-            if ( s_iPendingRxThreadPriority > 0 )
-               hw_increase_current_thread_priority("[RadioRxThread]", s_iPendingRxThreadPriority);
-            else
-               hw_increase_current_thread_priority("[RadioRxThread]", 0);
-         }
+         if ( s_iPendingRxThreadPriority > 0 )
+            hw_increase_current_thread_priority(szLogPrefix, s_iPendingRxThreadPriority);
+         else
+            hw_increase_current_thread_priority(szLogPrefix, 0);
       }
 
-      iLoopParsedPackets = 0;
-      struct pollfd fds[MAX_RADIO_INTERFACES];
-      s_iRadioRxCountFDs = 0;
-      for( int i=0; i<hardware_get_radio_interfaces_count(); i++ )
-      {
-         radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(i);
-         if ( (NULL == pRadioHWInfo) || (! pRadioHWInfo->openedForRead) )
-            continue;
-         if ( s_RadioRxState.iRadioInterfacesBroken[i] )
-            continue;
-         if ( s_iRadioRxPausedInterfaces[i] )
-            continue;
-         fds[s_iRadioRxCountFDs].fd = pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd;
-         fds[s_iRadioRxCountFDs].events = POLLIN;
-         s_iRadioRxCountFDs++;
-      }
+      _radio_rx_update_epoll_interfaces(pThreadInfo);
 
-      if ( s_iRadioRxCountFDs <= 0 )
+      // Don't wait if some interfaces were not fully drained in the previous loop
+      int iTimeoutMs = iPollTimeoutMs;
+      for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
       {
-         hardware_sleep_ms(5);
-         uTimeReadSignaled = get_current_timestamp_ms();
-         continue;
+         if ( pThreadInfo->iInterfacePendingReads[i] )
+         {
+            iTimeoutMs = 0;
+            break;
+         }
       }
 
-      //int nResult = select(s_iRadioRxMaxFD, &s_RadioRxReadSet, NULL, NULL, &s_iRadioRxReadTimeInterval);
-      int nResult = poll(fds, s_iRadioRxCountFDs, iPollTimeoutMs);
-
+      iLoopParsedPackets = 0;
+      int nResult = epoll_wait(pThreadInfo->iEpollFd, events, MAX_RADIO_INTERFACES+1, iTimeoutMs);
       
       uTimeReadSignaled = get_current_timestamp_ms();
       s_uRadioRxLastTimeQueue = 0;
 
       if ( nResult < 0 )
       {
-         log_line("[RadioRxThread] Radio interfaces have broken up. Exception on select read radio handle.");
-         for( int i=0; i<hardware_get_radio_interfaces_count(); i++ )
+         if ( EINTR == errno )
+            continue;
+         log_line("%s Radio interfaces have broken up. Exception on epoll wait on radio handles, error: %d", szLogPrefix, errno);
+         for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
          {
-            radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(i);
-            if ( (NULL != pRadioHWInfo) && pRadioHWInfo->openedForRead )
+            if ( pThreadInfo->iRegisteredFds[i] >= 0 )
                s_RadioRxState.iRadioInterfacesBroken[i] = 1;
          }
+         hardware_sleep_micros(500);
+         continue;
       }
 
-      if ( nResult <= 0 )
+      int iStatsTimerFired = 0;
+      for( int i=0; i<nResult; i++ )
       {
-         hardware_sleep_micros(500);
-         continue;
+         if ( RADIO_RX_EPOLL_ID_TIMER == events[i].data.u32 )
+         {
+            iStatsTimerFired = 1;
+            continue;
+         }
+         int iInterfaceIndex = (int)events[i].data.u32;
+         if ( (iInterfaceIndex < 0) || (iInterfaceIndex >= MAX_RADIO_INTERFACES) )
+            continue;
+         if ( events[i].events & (EPOLLERR | EPOLLHUP) )
+         if ( ! (events[i].events & EPOLLIN) )
+         {
+            log_line("[RadioRx] Mark radio interface %d as broken (epoll events: 0x%X)", iInterfaceIndex+1, events[i].events);
+            s_RadioRxState.iRadioInterfacesBroken[iInterfaceIndex] = 1;
+            continue;
+         }
+         pThreadInfo->iInterfacePendingReads[iInterfaceIndex] = 1;
       }
 
-      // Received data, process it
-      int iMaxRepeatCount = 3;
-      int iMaxedInterface = -1;
-      int iParsedPackets[MAX_RADIO_INTERFACES];
-      for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
-         iParsedPackets[i] = 1;
+      // No timerfd available? Fallback to checking the time
+      if ( iHandlesStats && (pThreadInfo->iTimerFd < 0) )
+      if ( uTimeReadSignaled >= pThreadInfo->uTimeLastStatsTimer + RADIO_RX_STATS_TIMER_INTERVAL_MS )
+         iStatsTimerFired = 1;
 
-      // Repeat reading while we have max reads on at least one interface
-      do
+      if ( iStatsTimerFired )
+         _radio_rx_on_stats_timer(pThreadInfo, uTimeReadSignaled);
+
+      TRACE_BEGIN(TRACE_EVENT_RADIO_RX_WAKEUP, nResult, 0, 0);
+      iLoopParsedPackets = _radio_rx_drain_pending_interfaces(pThreadInfo);
+      TRACE_END(TRACE_EVENT_RADIO_RX_WAKEUP, nResult, iLoopParsedPackets, 0);
+   }
+
+   log_line("%s Stopped.", szLogPrefix);
+   return NULL;
+}
+
+static int _radio_rx_create_thread(int iThreadIndex, int iInterfaceIndex)
+{
+   t_radio_rx_thread_info* pThreadInfo = &s_RadioRxThreads[iThreadIndex];
+   memset(pThreadInfo, 0, sizeof(t_radio_rx_thread_info));
+   pThreadInfo->iThreadIndex = iThreadIndex;
+   pThreadInfo->iInterfaceIndex = iInterfaceIndex;
+   pThreadInfo->iCurrentThreadPriority = s_iCurrentRxThreadPriority;
+   pThreadInfo->iTimerFd = -1;
+   pThreadInfo->uTimeLastStatsTimer = get_current_timestamp_ms();
+   for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+      pThreadInfo->iRegisteredFds[i] = -1;
+
+   pThreadInfo->iEpollFd = epoll_create1(EPOLL_CLOEXEC);
+   if ( pThreadInfo->iEpollFd < 0 )
+   {
+      log_error_and_alarm("[RadioRx] Failed to create epoll set for rx thread %d, error: %d", iThreadIndex+1, errno);
+      return 0;
+   }
+
+   if ( 0 == iThreadIndex )
+   {
+      pThreadInfo->iTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+      if ( pThreadInfo->iTimerFd >= 0 )
       {
-         iMaxRepeatCount--;
-         iMaxedInterface = -1;
-         int kIndex = 0;
-         int iInterfacesCount = hardware_get_radio_interfaces_count();
-         if ( iInterfacesCount > MAX_RADIO_INTERFACES )
-            iInterfacesCount = MAX_RADIO_INTERFACES;
-         for(int iInterfaceIndex=0; iInterfaceIndex<iInterfacesCount; iInterfaceIndex++)
+         struct itimerspec timerSpec;
+         memset(&timerSpec, 0, sizeof(timerSpec));
+         timerSpec.it_interval.tv_nsec = RADIO_RX_STATS_TIMER_INTERVAL_MS * 1000LL * 1000LL;
+         timerSpec.it_value.tv_nsec = RADIO_RX_STATS_TIMER_INTERVAL_MS * 1000LL * 1000LL;
+         struct epoll_event event;
+         memset(&event, 0, sizeof(event));
+         event.events = EPOLLIN;
+         event.data.u32 = RADIO_RX_EPOLL_ID_TIMER;
+         if ( (0 != timerfd_settime(pThreadInfo->iTimerFd, 0, &timerSpec, NULL)) ||
+              (0 != epoll_ctl(pThreadInfo->iEpollFd, EPOLL_CTL_ADD, pThreadInfo->iTimerFd, &event)) )
          {
-            radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(iInterfaceIndex);
-            if ( (NULL == pRadioHWInfo) || (! pRadioHWInfo->openedForRead) )
-               continue;
-            if ( s_RadioRxState.iRadioInterfacesBroken[iInterfaceIndex] )
-               continue;
-            if ( s_iRadioRxPausedInterfaces[iInterfaceIndex] )
-               continue;
-
-            //if( 0 == FD_ISSET(pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd, &s_RadioRxReadSet) )
-            //   continue;
-            if ( 0 == (fds[kIndex].revents & POLLIN) )
-               continue;
-            kIndex++;
-
-            if ( iParsedPackets[iInterfaceIndex] <= 0 )
-               continue;
-
-            if ( hardware_radio_index_is_serial_radio(iInterfaceIndex) )
-            {
-               iParsedPackets[iInterfaceIndex] = _radio_rx_parse_received_serial_radio_data(iInterfaceIndex);
-               if ( iParsedPackets[iInterfaceIndex] < 0 )
-               {
-                  log_line("[RadioRx] Mark serial radio interface %d as broken", iInterfaceIndex+1);
-                  s_RadioRxState.iRadioInterfacesBroken[iInterfaceIndex] = 1;
-               }
-            }
-            else
-            {
-               iParsedPackets[iInterfaceIndex] = _radio_rx_parse_received_wifi_radio_data(iInterfaceIndex, 3);
-               if ( (iParsedPackets[iInterfaceIndex] < 0) || ( radio_get_last_read_error_code() == RADIO_READ_ERROR_INTERFACE_BROKEN ) )
-               {
-                  log_line("[RadioRx] Mark radio interface %d as broken", iInterfaceIndex+1);
-                  s_RadioRxState.iRadioInterfacesBroken[iInterfaceIndex] = 1;
-                  continue;
-               }
-               iLoopParsedPackets += iParsedPackets[iInterfaceIndex];
-               if ( iParsedPackets[iInterfaceIndex] >= 3 )
-                  iMaxedInterface = iInterfaceIndex;
-            }
+            close(pThreadInfo->iTimerFd);
+            pThreadInfo->iTimerFd = -1;
          }
-      } while ( (iMaxedInterface != -1) && (iMaxRepeatCount > 0));
+      }
+      if ( pThreadInfo->iTimerFd < 0 )
+         log_softerror_and_alarm("[RadioRx] Failed to create stats timer, error: %d. Use loop time checks instead.", errno);
    }
 
-   log_line("[RadioRxThread] Stopped.");
-   return NULL;
+   if ( 0 != pthread_create(&pThreadInfo->pThread, NULL, &_thread_radio_rx, (void*)pThreadInfo) )
+   {
+      log_error_and_alarm("[RadioRx] Failed to create thread %d for radio rx.", iThreadIndex+1);
+      return 0;
+   }
+   pThreadInfo->iThreadCreated = 1;
+   return 1;
+}
+
+static void _radio_rx_close_threads_resources()
+{
+   for( int i=0; i<s_iRadioRxThreadsCount; i++ )
+   {
+      if ( s_RadioRxThreads[i].iTimerFd >= 0 )
+         close(s_RadioRxThreads[i].iTimerFd);
+      if ( s_RadioRxThreads[i].iEpollFd >= 0 )
+         close(s_RadioRxThreads[i].iEpollFd);
+      s_RadioRxThreads[i].iTimerFd = -1;
+      s_RadioRxThreads[i].iEpollFd = -1;
+      s_RadioRxThreads[i].iThreadCreated = 0;
+   }
+   s_iRadioRxThreadsCount = 0;
+}
+
+// Waits for all rx threads to be idle, so that the radio interfaces state can be changed
+
+static void _radio_rx_begin_pending_operation()
+{
+   s_bHasPendingOperation = 1;
+   for( int i=0; i<s_iRadioRxThreadsCount; i++ )
+   {
+      if ( ! s_RadioRxThreads[i].iThreadCreated )
+         continue;
+      while ( ! s_RadioRxThreads[i].iCanDoOperations )
+         hardware_sleep_ms(1);
+   }
+}
+
+static void _radio_rx_end_pending_operation()
+{
+   s_bHasPendingOperation = 0;
+   for( int i=0; i<s_iRadioRxThreadsCount; i++ )
+      s_RadioRxThreads[i].iCanDoOperations = 0;
+}
+
+void radio_rx_set_thread_per_interface(int iEnable)
+{
+   s_iRadioRxThreadPerInterface = iEnable;
+   log_line("[RadioRx] Set one rx thread per radio interface: %s%s", iEnable?"yes":"no", s_iRadioRxInitialized?" (applied on next rx start)":"");
 }
 
 int radio_rx_start_rx_thread(shared_mem_radio_stats* pSMRadioStats, int iSearchMode, u32 uAcceptedFirmwareType)
@@ -1030,7 +1401,9 @@ int radio_rx_start_rx_thread(shared_mem_radio_stats* pSMRadioStats, int iSearchM
       s_RadioRxState.queue_reg_priority.iPacketsLengths[i] = 0;
       s_RadioRxState.queue_reg_priority.uPacketsAreShort[i] = 0;
       s_RadioRxState.queue_reg_priority.uPacketsRxInterface[i] = 0;
+      s_RadioRxState.queue_reg_priority.uPacketsRxBufferRef[i] = 0;
       s_RadioRxState.queue_reg_priority.pPacketsBuffers[i] = (u8*) malloc(MAX_PACKET_TOTAL_SIZE);
+      s_RadioRxState.queue_reg_priority.pPacketsData[i] = s_RadioRxState.queue_reg_priority.pPacketsBuffers[i];
       if ( NULL == s_RadioRxState.queue_reg_priority.pPacketsBuffers[i] )
       {
          log_error_and_alarm("[RadioRx] Failed to allocate rx packets buffers!");
@@ -1044,7 +1417,9 @@ int radio_rx_start_rx_thread(shared_mem_radio_stats* pSMRadioStats, int iSearchM
       s_RadioRxState.queue_high_priority.iPacketsLengths[i] = 0;
       s_RadioRxState.queue_high_priority.uPacketsAreShort[i] = 0;
       s_RadioRxState.queue_high_priority.uPacketsRxInterface[i] = 0;
+      s_RadioRxState.queue_high_priority.uPacketsRxBufferRef[i] = 0;
       s_RadioRxState.queue_high_priority.pPacketsBuffers[i] = (u8*) malloc(MAX_PACKET_TOTAL_SIZE);
+      s_RadioRxState.queue_high_priority.pPacketsData[i] = s_RadioRxState.queue_high_priority.pPacketsBuffers[i];
       if ( NULL == s_RadioRxState.queue_high_priority.pPacketsBuffers[i] )
       {
          log_error_and_alarm("[RadioRx] Failed to allocate rx packets buffers!");
@@ -1057,6 +1432,17 @@ int radio_rx_start_rx_thread(shared_mem_radio_stats* pSMRadioStats, int iSearchM
    s_RadioRxState.queue_high_priority.iCurrentPacketIndexToWrite = 0;
    s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume = 0;
    s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToWrite = 0;
+   s_RadioRxState.queue_high_priority.iCountPacketsPendingRelease = 0;
+   s_RadioRxState.queue_reg_priority.iCountPacketsPendingRelease = 0;
+   s_RadioRxState.queue_high_priority.iConsumerWaiting = 0;
+   s_RadioRxState.queue_reg_priority.iConsumerWaiting = 0;
+   s_RadioRxState.queue_high_priority.uStatsDroppedPackets = 0;
+   s_RadioRxState.queue_reg_priority.uStatsDroppedPackets = 0;
+
+   // Spinning before blocking only makes sense if the rx thread can run at the same time
+   s_iRadioRxQueueSpinLoops = 0;
+   if ( sysconf(_SC_NPROCESSORS_ONLN) > 1 )
+      s_iRadioRxQueueSpinLoops = RADIO_RX_QUEUE_SPIN_LOOPS;
    
    s_RadioRxState.queue_high_priority.iStatsMaxPacketsInQueue = 0;
    s_RadioRxState.queue_high_priority.iStatsMaxPacketsInQueueLastMinute = 0;
@@ -1145,14 +1531,45 @@ int radio_rx_start_rx_thread(shared_mem_radio_stats* pSMRadioStats, int iSearchM
 
    s_RadioRxState.uMaxLoopTime = 0;
 
-   if ( 0 != pthread_create(&s_pThreadRadioRx, NULL, &_thread_radio_rx, (void*)&s_iRadioRxSingalStop) )
+   pthread_mutex_init(&s_MutexRadioRxProcessing, NULL);
+   int iThreadsCount = 1;
+   if ( s_iRadioRxThreadPerInterface )
+      iThreadsCount = hardware_get_radio_interfaces_count();
+   if ( iThreadsCount > MAX_RADIO_INTERFACES )
+      iThreadsCount = MAX_RADIO_INTERFACES;
+   if ( iThreadsCount < 1 )
+      iThreadsCount = 1;
+
+   // Set before creating the threads, they use it to decide on locking
+   s_iRadioRxThreadsCount = iThreadsCount;
+   for( int i=0; i<iThreadsCount; i++ )
    {
-      log_error_and_alarm("[RadioRx] Failed to create thread for radio rx.");
-      return 0;
+      if ( ! _radio_rx_create_thread(i, (iThreadsCount > 1)?i:-1) )
+      {
+         if ( 0 == i )
+         {
+            _radio_rx_close_threads_resources();
+            return 0;
+         }
+         // Interfaces without a thread are handled by the first one
+         log_softerror_and_alarm("[RadioRx] Only %d rx threads could be created, falling back to a single rx thread.", i);
+         s_iRadioRxSingalStop = 1;
+         for( int k=0; k<i; k++ )
+            pthread_join(s_RadioRxThreads[k].pThread, NULL);
+         _radio_rx_close_threads_resources();
+         s_iRadioRxSingalStop = 0;
+         s_iRadioRxThreadsCount = 1;
+         if ( ! _radio_rx_create_thread(0, -1) )
+         {
+            _radio_rx_close_threads_resources();
+            return 0;
+         }
+         break;
+      }
    }
 
    s_iRadioRxInitialized = 1;
-   log_line("[RadioRx] Started radio rx thread, accepted firmware types: %s.", str_format_firmware_type(s_RadioRxState.uAcceptedFirmwareType));
+   log_line("[RadioRx] Started %d radio rx thread(s), accepted firmware types: %s.", s_iRadioRxThreadsCount, str_format_firmware_type(s_RadioRxState.uAcceptedFirmwareType));
    return 1;
 }
 
@@ -1165,7 +1582,14 @@ void radio_rx_stop_rx_thread()
    s_iRadioRxSingalStop = 1;
    s_iRadioRxInitialized = 0;
 
-   pthread_cancel(s_pThreadRadioRx);
+   for( int i=0; i<s_iRadioRxThreadsCount; i++ )
+   {
+      if ( ! s_RadioRxThreads[i].iThreadCreated )
+         continue;
+      pthread_cancel(s_RadioRxThreads[i].pThread);
+      pthread_join(s_RadioRxThreads[i].pThread, NULL);
+   }
+   _radio_rx_close_threads_resources();
 
    if ( NULL != s_RadioRxState.queue_high_priority.pSemaphoreWrite )
       sem_close(s_RadioRxState.queue_high_priority.pSemaphoreWrite);
@@ -1215,15 +1639,12 @@ void radio_rx_pause_interface(int iInterfaceIndex, const char* szReason)
 
    if ( s_iRadioRxInitialized )
    {
-      s_bHasPendingOperation = 1;
-      while ( ! s_bCanDoOperations )
-         hardware_sleep_ms(1);
+      _radio_rx_begin_pending_operation();
 
       s_iRadioRxPausedInterfaces[iInterfaceIndex]++;
       _radio_rx_check_update_all_paused_flag();
 
-      s_bHasPendingOperation = 0;
-      s_bCanDoOperations = 0;
+      _radio_rx_end_pending_operation();
    }
    else
    {
@@ -1253,9 +1674,7 @@ void radio_rx_resume_interface(int iInterfaceIndex)
 
    if ( s_iRadioRxInitialized )
    {
-      s_bHasPendingOperation = 1;
-      while ( ! s_bCanDoOperations )
-         hardware_sleep_ms(1);
+      _radio_rx_begin_pending_operation();
 
       if ( s_iRadioRxPausedInterfaces[iInterfaceIndex] > 0 )
       {
@@ -1263,8 +1682,7 @@ void radio_rx_resume_interface(int iInterfaceIndex)
          if ( s_iRadioRxPausedInterfaces[iInterfaceIndex] == 0 )
             s_iRadioRxAllInterfacesPaused = 0;
       }
-      s_bHasPendingOperation = 0;
-      s_bCanDoOperations = 0;
+      _radio_rx_end_pending_operation();
    }
    else
    {
@@ -1325,11 +1743,8 @@ int radio_rx_detect_firmware_type_from_packet(u8* pPacketBuffer, int nPacketLeng
       if ( pPH->total_length > nPacketLength )
       {
          if ( pPH->packet_flags & PACKET_FLAGS_BIT_HAS_ENCRYPTION )
-         {
-            int dx = sizeof(t_packet_header);
-            int l = nPacketLength-dx;
-            dpp(pPacketBuffer + dx, l);
-         }
+         if ( ! radio_packet_decrypt(pPacketBuffer, nPacketLength, nPacketLength) )
+            return 0;
          u32 uCRC = 0;
          if ( pPH->packet_flags & PACKET_FLAGS_BIT_HEADERS_ONLY_CRC )
             uCRC = base_compute_crc32(pPacketBuffer+sizeof(u32), sizeof(t_packet_header)-sizeof(u32));
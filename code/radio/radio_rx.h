@@ -30,12 +30,18 @@ typedef struct
 typedef struct
 {
    u8* pPacketsBuffers[MAX_RX_PACKETS_QUEUE];
+   u8* pPacketsData[MAX_RX_PACKETS_QUEUE]; // Either the own buffer or a frame in the rx mmap ring
+   u32 uPacketsRxBufferRef[MAX_RX_PACKETS_QUEUE]; // Rx ring reference held by the packet, 0 for none
    int iPacketsLengths[MAX_RX_PACKETS_QUEUE];
    u8  uPacketsAreShort[MAX_RX_PACKETS_QUEUE];
    u8  uPacketsRxInterface[MAX_RX_PACKETS_QUEUE];
    int iQueueSize;
-   volatile int iCurrentPacketIndexToWrite; // Where next packet will be added
-   volatile int iCurrentPacketIndexToConsume; // Where the first packet to read/consume is
+   // Single producer (rx thread) / single consumer ring. Indexes are only accessed using atomic acquire/release
+   int iCurrentPacketIndexToWrite; // Where next packet will be added. Written only by the rx thread
+   int iCurrentPacketIndexToConsume; // Where the first packet to read/consume is. Written only by the consumer
+   int iCountPacketsPendingRelease; // Packets starting at iCurrentPacketIndexToConsume handed out to the consumer
+   int iConsumerWaiting; // Consumer is blocked on the semaphore, rx thread must post it
+   u32 uStatsDroppedPackets;
    int iStatsMaxPacketsInQueue;
    int iStatsMaxPacketsInQueueLastMinute;
 
@@ -76,6 +82,8 @@ int radio_rx_start_rx_thread(shared_mem_radio_stats* pSMRadioStats, int iSearchM
 void radio_rx_stop_rx_thread();
 
 void radio_rx_set_custom_thread_priority(int iPriority);
+// Must be set before starting the rx thread(s)
+void radio_rx_set_thread_per_interface(int iEnable);
 void radio_rx_set_timeout_interval(int iMiliSec);
 
 void radio_rx_pause_interface(int iInterfaceIndex, const char* szReason);
@@ -101,6 +109,14 @@ u32 radio_rx_get_and_reset_max_loop_time_queue();
 u8* radio_rx_wait_get_next_received_high_prio_packet(u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex);
 u8* radio_rx_wait_get_next_received_reg_prio_packet(u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex);
 
+// Batch versions: return the number of packets stored in pPackets (at most iMaxPackets), draining the queue in one wakeup
+int radio_rx_wait_get_next_received_high_prio_packets(u32 uTimeoutMicroSec, type_received_radio_packet* pPackets, int iMaxPackets);
+int radio_rx_wait_get_next_received_reg_prio_packets(u32 uTimeoutMicroSec, type_received_radio_packet* pPackets, int iMaxPackets);
+
+// Returned packets are valid until released, or until the next packet(s) are requested from the same queue
+void radio_rx_release_high_prio_packet();
+void radio_rx_release_reg_prio_packet();
+
 #ifdef __cplusplus
 }  
 #endif
@@ -0,0 +1,436 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../base/base.h"
+#include "../base/config.h"
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <net/ethernet.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+#include "radio_rx_ring.h"
+
+// Ring slots are not tied to the interface index, so that an interface can be reopened
+// while packets from its previous ring are still referenced in the rx queues.
+#define MAX_RX_RINGS (2*MAX_RADIO_INTERFACES)
+
+typedef struct
+{
+   int iInterfaceIndex;
+   int iSocket;
+   u8* pMap;
+   u32 uMapSize;
+   int iBlocksCount;
+   volatile int iBlocksRefs[RX_RING_BLOCKS_COUNT];
+   volatile int iTotalRefs; // One for the ring being open, plus one per referenced block
+
+   // Reader state (rx thread only)
+   int iCurrentBlock;
+   int iCurrentBlockHeld;
+   unsigned long long uLastBlockSeq;
+   u8* pNextFrame;
+   int iFramesLeftInBlock;
+
+   u32 uStatsFrames;
+   u32 uStatsBlocks;
+   u32 uStatsCopiedFrames;
+} ALIGN_STRUCT_SPEC_INFO type_radio_rx_ring;
+
+static type_radio_rx_ring* s_pRadioRxRings[MAX_RX_RINGS];
+static int s_iRadioRxRingForInterface[MAX_RADIO_INTERFACES];
+static int s_bRadioRxRingsInitialized = 0;
+
+static void _radio_rx_ring_init()
+{
+   if ( s_bRadioRxRingsInitialized )
+      return;
+   s_bRadioRxRingsInitialized = 1;
+   for( int i=0; i<MAX_RX_RINGS; i++ )
+      s_pRadioRxRings[i] = NULL;
+   for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+      s_iRadioRxRingForInterface[i] = -1;
+}
+
+static void _radio_rx_ring_drop_total_ref(int iSlot)
+{
+   type_radio_rx_ring* pRing = s_pRadioRxRings[iSlot];
+   if ( NULL == pRing )
+      return;
+   if ( 0 != __sync_sub_and_fetch(&pRing->iTotalRefs, 1) )
+      return;
+
+   // Closed and nothing references it anymore
+   munmap(pRing->pMap, pRing->uMapSize);
+   log_line("[RadioRxRing] Released ring slot %d of radio interface %d.", iSlot, pRing->iInterfaceIndex+1);
+   s_pRadioRxRings[iSlot] = NULL;
+   free(pRing);
+}
+
+static void _radio_rx_ring_block_release(int iSlot, int iBlock)
+{
+   type_radio_rx_ring* pRing = s_pRadioRxRings[iSlot];
+   if ( NULL == pRing )
+      return;
+   if ( 0 == __sync_sub_and_fetch(&pRing->iBlocksRefs[iBlock], 1) )
+   {
+      struct tpacket_block_desc* pBlock = (struct tpacket_block_desc*)(pRing->pMap + iBlock * RX_RING_BLOCK_SIZE);
+      __sync_synchronize();
+      pBlock->hdr.bh1.block_status = TP_STATUS_KERNEL;
+      _radio_rx_ring_drop_total_ref(iSlot);
+   }
+}
+
+static void _radio_rx_ring_block_acquire(int iSlot, int iBlock)
+{
+   type_radio_rx_ring* pRing = s_pRadioRxRings[iSlot];
+   if ( 1 == __sync_add_and_fetch(&pRing->iBlocksRefs[iBlock], 1) )
+      __sync_add_and_fetch(&pRing->iTotalRefs, 1);
+}
+
+static int _radio_rx_ring_attach_filter(int iSocket, const char* szInterfaceName, const char* szFilter, const char* szFilterPrism)
+{
+   struct ifreq ifr;
+   memset(&ifr, 0, sizeof(ifr));
+   strncpy(ifr.ifr_name, szInterfaceName, IFNAMSIZ-1);
+   if ( ioctl(iSocket, SIOCGIFHWADDR, &ifr) < 0 )
+   {
+      log_softerror_and_alarm("[RadioRxRing] Failed to get link type of [%s], error: %d", szInterfaceName, errno);
+      return -1;
+   }
+
+   int iLinkType = -1;
+   const char* szProgram = szFilter;
+   if ( ifr.ifr_hwaddr.sa_family == ARPHRD_IEEE80211_RADIOTAP )
+      iLinkType = DLT_IEEE802_11_RADIO;
+   else if ( ifr.ifr_hwaddr.sa_family == ARPHRD_IEEE80211_PRISM )
+   {
+      iLinkType = DLT_PRISM_HEADER;
+      szProgram = szFilterPrism;
+   }
+   else
+   {
+      log_softerror_and_alarm("[RadioRxRing] Unknown encapsulation (%d) on [%s]! Check if monitor mode is supported and enabled.", ifr.ifr_hwaddr.sa_family, szInterfaceName);
+      return -1;
+   }
+
+   // Compile the same filter as for the pcap rx path and attach it to the raw socket
+   pcap_t* pDead = pcap_open_dead(iLinkType, MAX_PACKET_TOTAL_SIZE*10);
+   if ( NULL == pDead )
+      return -1;
+   struct bpf_program bpfprogram;
+   if ( pcap_compile(pDead, &bpfprogram, szProgram, 1, 0) == -1 )
+   {
+      log_softerror_and_alarm("[RadioRxRing] Failed to compile filter [%s]: %s", szProgram, pcap_geterr(pDead));
+      pcap_close(pDead);
+      return -1;
+   }
+
+   struct sock_fprog fprog;
+   fprog.len = bpfprogram.bf_len;
+   fprog.filter = (struct sock_filter*) bpfprogram.bf_insns;
+   int iRes = setsockopt(iSocket, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog));
+   pcap_freecode(&bpfprogram);
+   pcap_close(pDead);
+   if ( iRes < 0 )
+   {
+      log_softerror_and_alarm("[RadioRxRing] Failed to attach filter to [%s], error: %d", szInterfaceName, errno);
+      return -1;
+   }
+   return 0;
+}
+
+int radio_rx_ring_open(int iInterfaceIndex, const char* szInterfaceName, const char* szFilter, const char* szFilterPrism)
+{
+   _radio_rx_ring_init();
+   if ( (iInterfaceIndex < 0) || (iInterfaceIndex >= MAX_RADIO_INTERFACES) || (NULL == szInterfaceName) )
+      return -1;
+   if ( s_iRadioRxRingForInterface[iInterfaceIndex] >= 0 )
+      radio_rx_ring_close(iInterfaceIndex);
+
+   int iSlot = -1;
+   for( int i=0; i<MAX_RX_RINGS; i++ )
+   {
+      if ( NULL == s_pRadioRxRings[i] )
+      {
+         iSlot = i;
+         break;
+      }
+   }
+   if ( iSlot < 0 )
+   {
+      log_softerror_and_alarm("[RadioRxRing] No free ring slots to open radio interface %d.", iInterfaceIndex+1);
+      return -1;
+   }
+
+   int iSocket = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+   if ( iSocket < 0 )
+   {
+      log_softerror_and_alarm("[RadioRxRing] Failed to create raw socket for [%s], error: %d", szInterfaceName, errno);
+      return -1;
+   }
+
+   if ( _radio_rx_ring_attach_filter(iSocket, szInterfaceName, szFilter, szFilterPrism) < 0 )
+   {
+      close(iSocket);
+      return -1;
+   }
+
+   int iVersion = TPACKET_V3;
+   if ( setsockopt(iSocket, SOL_PACKET, PACKET_VERSION, &iVersion, sizeof(iVersion)) < 0 )
+   {
+      log_softerror_and_alarm("[RadioRxRing] TPACKET_V3 is not supported, error: %d", errno);
+      close(iSocket);
+      return -1;
+   }
+
+   struct tpacket_req3 req;
+   memset(&req, 0, sizeof(req));
+   req.tp_block_size = RX_RING_BLOCK_SIZE;
+   req.tp_block_nr = RX_RING_BLOCKS_COUNT;
+   req.tp_frame_size = RX_RING_FRAME_SIZE;
+   req.tp_frame_nr = (RX_RING_BLOCK_SIZE * RX_RING_BLOCKS_COUNT) / RX_RING_FRAME_SIZE;
+   req.tp_retire_blk_tov = RX_RING_BLOCK_TIMEOUT_MS;
+   req.tp_feature_req_word = 0;
+   if ( setsockopt(iSocket, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0 )
+   {
+      log_softerror_and_alarm("[RadioRxRing] Failed to setup rx ring for [%s], error: %d", szInterfaceName, errno);
+      close(iSocket);
+      return -1;
+   }
+
+   u32 uMapSize = req.tp_block_size * req.tp_block_nr;
+   u8* pMap = (u8*) mmap(NULL, uMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, iSocket, 0);
+   if ( MAP_FAILED == pMap )
+      pMap = (u8*) mmap(NULL, uMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, iSocket, 0);
+   if ( MAP_FAILED == pMap )
+   {
+      log_softerror_and_alarm("[RadioRxRing] Failed to map rx ring for [%s], error: %d", szInterfaceName, errno);
+      close(iSocket);
+      return -1;
+   }
+
+   struct sockaddr_ll addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.sll_family = AF_PACKET;
+   addr.sll_protocol = htons(ETH_P_ALL);
+   addr.sll_ifindex = if_nametoindex(szInterfaceName);
+   if ( (0 == addr.sll_ifindex) || (bind(iSocket, (struct sockaddr*)&addr, sizeof(addr)) < 0) )
+   {
+      log_softerror_and_alarm("[RadioRxRing] Failed to bind raw socket to [%s], error: %d", szInterfaceName, errno);
+      munmap(pMap, uMapSize);
+      close(iSocket);
+      return -1;
+   }
+
+   struct packet_mreq mreq;
+   memset(&mreq, 0, sizeof(mreq));
+   mreq.mr_ifindex = addr.sll_ifindex;
+   mreq.mr_type = PACKET_MR_PROMISC;
+   if ( setsockopt(iSocket, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0 )
+      log_softerror_and_alarm("[RadioRxRing] Error setting [%s] to promiscous mode.", szInterfaceName);
+
+   type_radio_rx_ring* pRing = (type_radio_rx_ring*) malloc(sizeof(type_radio_rx_ring));
+   if ( NULL == pRing )
+   {
+      munmap(pMap, uMapSize);
+      close(iSocket);
+      return -1;
+   }
+   memset(pRing, 0, sizeof(type_radio_rx_ring));
+   pRing->iInterfaceIndex = iInterfaceIndex;
+   pRing->iSocket = iSocket;
+   pRing->pMap = pMap;
+   pRing->uMapSize = uMapSize;
+   pRing->iBlocksCount = req.tp_block_nr;
+   pRing->iTotalRefs = 1;
+   pRing->iCurrentBlock = 0;
+   pRing->iCurrentBlockHeld = 0;
+   pRing->uLastBlockSeq = 0;
+   pRing->pNextFrame = NULL;
+   pRing->iFramesLeftInBlock = 0;
+
+   s_pRadioRxRings[iSlot] = pRing;
+   s_iRadioRxRingForInterface[iInterfaceIndex] = iSlot;
+
+   log_line("[RadioRxRing] Opened radio interface %d (%s) in mmap ring mode (%d blocks of %d bytes, slot %d), fd=%d",
+      iInterfaceIndex+1, szInterfaceName, req.tp_block_nr, req.tp_block_size, iSlot, iSocket);
+   return iSocket;
+}
+
+void radio_rx_ring_close(int iInterfaceIndex)
+{
+   _radio_rx_ring_init();
+   if ( (iInterfaceIndex < 0) || (iInterfaceIndex >= MAX_RADIO_INTERFACES) )
+      return;
+   int iSlot = s_iRadioRxRingForInterface[iInterfaceIndex];
+   if ( iSlot < 0 )
+      return;
+   s_iRadioRxRingForInterface[iInterfaceIndex] = -1;
+
+   type_radio_rx_ring* pRing = s_pRadioRxRings[iSlot];
+   if ( NULL == pRing )
+      return;
+
+   log_line("[RadioRxRing] Closing ring of radio interface %d, fd was: %d, blocks still referenced: %d",
+      iInterfaceIndex+1, pRing->iSocket, pRing->iTotalRefs - 1 - pRing->iCurrentBlockHeld);
+
+   if ( pRing->iCurrentBlockHeld )
+   {
+      pRing->iCurrentBlockHeld = 0;
+      _radio_rx_ring_block_release(iSlot, pRing->iCurrentBlock);
+   }
+   // The mapping stays valid after the socket is closed, until all packets in the rx queues referencing it are released
+   close(pRing->iSocket);
+   pRing->iSocket = -1;
+   _radio_rx_ring_drop_total_ref(iSlot);
+}
+
+int radio_rx_ring_is_open(int iInterfaceIndex)
+{
+   _radio_rx_ring_init();
+   if ( (iInterfaceIndex < 0) || (iInterfaceIndex >= MAX_RADIO_INTERFACES) )
+      return 0;
+   return (s_iRadioRxRingForInterface[iInterfaceIndex] >= 0)?1:0;
+}
+
+u8* radio_rx_ring_get_next_frame(int iInterfaceIndex, int* piFrameLength, u32* puRef)
+{
+   if ( NULL != piFrameLength )
+      *piFrameLength = 0;
+   if ( NULL != puRef )
+      *puRef = 0;
+   if ( (iInterfaceIndex < 0) || (iInterfaceIndex >= MAX_RADIO_INTERFACES) )
+      return NULL;
+   int iSlot = s_iRadioRxRingForInterface[iInterfaceIndex];
+   if ( iSlot < 0 )
+      return NULL;
+   type_radio_rx_ring* pRing = s_pRadioRxRings[iSlot];
+
+   // Done with current block? Give it back (to the kernel if no one else holds frames from it)
+   if ( pRing->iCurrentBlockHeld && (pRing->iFramesLeftInBlock <= 0) )
+   {
+      pRing->iCurrentBlockHeld = 0;
+      _radio_rx_ring_block_release(iSlot, pRing->iCurrentBlock);
+      pRing->iCurrentBlock = (pRing->iCurrentBlock + 1) % pRing->iBlocksCount;
+   }
+
+   if ( ! pRing->iCurrentBlockHeld )
+   {
+      struct tpacket_block_desc* pBlock = (struct tpacket_block_desc*)(pRing->pMap + pRing->iCurrentBlock * RX_RING_BLOCK_SIZE);
+      if ( 0 == (pBlock->hdr.bh1.block_status & TP_STATUS_USER) )
+         return NULL;
+      __sync_synchronize();
+
+      // Still owned by us from the previous pass over the ring (frames from it are still in the rx queues)
+      if ( (0 != pRing->uLastBlockSeq) && (pBlock->hdr.bh1.seq_num <= pRing->uLastBlockSeq) )
+         return NULL;
+
+      pRing->uLastBlockSeq = pBlock->hdr.bh1.seq_num;
+      pRing->iFramesLeftInBlock = pBlock->hdr.bh1.num_pkts;
+      pRing->pNextFrame = (u8*)pBlock + pBlock->hdr.bh1.offset_to_first_pkt;
+      pRing->iCurrentBlockHeld = 1;
+      pRing->uStatsBlocks++;
+      _radio_rx_ring_block_acquire(iSlot, pRing->iCurrentBlock);
+
+      // Empty block (can happen on timeout)
+      if ( pRing->iFramesLeftInBlock <= 0 )
+         return radio_rx_ring_get_next_frame(iInterfaceIndex, piFrameLength, puRef);
+   }
+
+   struct tpacket3_hdr* pFrameHeader = (struct tpacket3_hdr*) pRing->pNextFrame;
+   pRing->iFramesLeftInBlock--;
+   pRing->pNextFrame += pFrameHeader->tp_next_offset;
+   pRing->uStatsFrames++;
+
+   if ( NULL != piFrameLength )
+      *piFrameLength = (int) pFrameHeader->tp_snaplen;
+   if ( NULL != puRef )
+      *puRef = (((u32)iSlot+1) << 16) | (u32)pRing->iCurrentBlock;
+   return ((u8*)pFrameHeader) + pFrameHeader->tp_mac;
+}
+
+int radio_rx_ring_must_copy_frame(u32 uRef)
+{
+   int iSlot = (int)(uRef >> 16) - 1;
+   if ( (iSlot < 0) || (iSlot >= MAX_RX_RINGS) )
+      return 1;
+   type_radio_rx_ring* pRing = s_pRadioRxRings[iSlot];
+   if ( NULL == pRing )
+      return 1;
+   // The block being read counts as held too
+   if ( __atomic_load_n(&pRing->iTotalRefs, __ATOMIC_RELAXED) - 1 < RX_RING_MAX_PINNED_BLOCKS )
+      return 0;
+   pRing->uStatsCopiedFrames++;
+   return 1;
+}
+
+void radio_rx_ring_ref_acquire(u32 uRef)
+{
+   int iSlot = (int)(uRef >> 16) - 1;
+   int iBlock = (int)(uRef & 0xFFFF);
+   if ( (iSlot < 0) || (iSlot >= MAX_RX_RINGS) || (iBlock >= RX_RING_BLOCKS_COUNT) )
+      return;
+   if ( NULL == s_pRadioRxRings[iSlot] )
+      return;
+   _radio_rx_ring_block_acquire(iSlot, iBlock);
+}
+
+void radio_rx_ring_ref_release(u32 uRef)
+{
+   int iSlot = (int)(uRef >> 16) - 1;
+   int iBlock = (int)(uRef & 0xFFFF);
+   if ( (iSlot < 0) || (iSlot >= MAX_RX_RINGS) || (iBlock >= RX_RING_BLOCKS_COUNT) )
+      return;
+   _radio_rx_ring_block_release(iSlot, iBlock);
+}
+
+void radio_rx_ring_log_stats(int iInterfaceIndex)
+{
+   if ( ! radio_rx_ring_is_open(iInterfaceIndex) )
+      return;
+   int iSlot = s_iRadioRxRingForInterface[iInterfaceIndex];
+   type_radio_rx_ring* pRing = s_pRadioRxRings[iSlot];
+
+   struct tpacket_stats_v3 stats;
+   memset(&stats, 0, sizeof(stats));
+   socklen_t iLen = sizeof(stats);
+   getsockopt(pRing->iSocket, SOL_PACKET, PACKET_STATISTICS, &stats, &iLen);
+
+   int iBlocksHeld = pRing->iTotalRefs - 1;
+   log_line("[RadioRxRing] Radio interface %d: rx frames: %u (copied out: %u), blocks: %u, kernel drops: %u, ring full: %u, blocks now held: %d/%d",
+      iInterfaceIndex+1, pRing->uStatsFrames, pRing->uStatsCopiedFrames, pRing->uStatsBlocks, stats.tp_drops, stats.tp_freeze_q_cnt, iBlocksHeld, pRing->iBlocksCount);
+   pRing->uStatsFrames = 0;
+   pRing->uStatsBlocks = 0;
+   pRing->uStatsCopiedFrames = 0;
+}
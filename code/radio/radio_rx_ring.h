@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware.h"
+
+// Zero copy radio rx using a TPACKET_V3 mmap ring on a raw packet socket.
+// Received frames are handed out as pointers inside the ring. A frame stays valid
+// until the next radio_rx_ring_get_next_frame() call on the same interface, or,
+// if a reference was taken on it, until that reference is released.
+
+#define RX_RING_BLOCK_SIZE (1<<17)
+#define RX_RING_BLOCKS_COUNT 16
+#define RX_RING_FRAME_SIZE 2048
+#define RX_RING_BLOCK_TIMEOUT_MS 1
+// Past this many blocks held by queued frames, frames are copied out of the ring instead of referenced,
+// so that the kernel always has free blocks to write into
+#define RX_RING_MAX_PINNED_BLOCKS (RX_RING_BLOCKS_COUNT/2)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returns the selectable fd or -1 on failure
+int radio_rx_ring_open(int iInterfaceIndex, const char* szInterfaceName, const char* szFilter, const char* szFilterPrism);
+void radio_rx_ring_close(int iInterfaceIndex);
+int radio_rx_ring_is_open(int iInterfaceIndex);
+
+// Returns the raw frame (radiotap header included) and a reference id for it
+u8* radio_rx_ring_get_next_frame(int iInterfaceIndex, int* piFrameLength, u32* puRef);
+// Returns 1 if the frame should be copied out of the ring instead of queued by reference
+int radio_rx_ring_must_copy_frame(u32 uRef);
+void radio_rx_ring_ref_acquire(u32 uRef);
+void radio_rx_ring_ref_release(u32 uRef);
+
+void radio_rx_ring_log_stats(int iInterfaceIndex);
+
+#ifdef __cplusplus
+}  
+#endif
@@ -0,0 +1,563 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware_radio.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <pthread.h>
+#include <time.h>
+#include "radiotap.h"
+#include "radio_sim.h"
+
+#define RADIO_SIM_FRAME_MAGIC 0x52534D31
+
+// Prepended to each frame sent over the loopback socket, instead of the sender's radiotap header
+typedef struct
+{
+   u32 uMagic;
+   u32 uFrequencyKhz;
+   u32 uFrameIndex;
+   int8_t iRSSI;
+   int8_t iNoise;
+   u8 uIsMCS;
+   u8 uRate; // 500kbps units for legacy rates, MCS index otherwise
+} __attribute__((packed)) t_radio_sim_frame_header;
+
+typedef struct
+{
+   unsigned long long uDueTimeUs;
+   int iLength;
+   u8* pData;
+} t_radio_sim_tx_slot;
+
+typedef struct
+{
+   int iInterfaceIndex;
+   int iRxSocket;
+   int iRxPortFilter;
+   char szRxSocketPath[MAX_FILE_PATH_SIZE];
+   u8 uRxBuffer[RADIO_SIM_MAX_FRAME_SIZE + 64];
+
+   int iTxSocket;
+   struct sockaddr_un txPeerAddr;
+   pthread_t txThread;
+   int iTxThreadRunning;
+   volatile int iTxThreadStop;
+   pthread_mutex_t txMutex;
+   pthread_cond_t txCond;
+   u8* pTxFrames;
+   t_radio_sim_tx_slot txSlots[RADIO_SIM_TX_QUEUE_SLOTS];
+   int iTxQueueHead;
+   int iTxQueueCount;
+
+   // Channel model state (guarded by txMutex)
+   u32 uRandState;
+   int iGEStateBad;
+   unsigned long long uAirFreeTimeUs;
+   unsigned long long uLastDueTimeUs;
+   u32 uTxFrameIndex;
+
+   u32 uStatsTxFrames;
+   u32 uStatsTxLost;
+   u32 uStatsTxQueueDropped;
+   u32 uStatsTxNoPeer;
+   u32 uStatsRxFrames;
+   u32 uStatsRxFiltered;
+} t_radio_sim_interface;
+
+static t_radio_sim_interface* s_pRadioSimInterfaces[MAX_RADIO_INTERFACES];
+
+static unsigned long long _radio_sim_get_time_us()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((unsigned long long)ts.tv_sec) * 1000000LL + ((unsigned long long)ts.tv_nsec)/1000LL;
+}
+
+// xorshift32, returns a value in [0, 1)
+static float _radio_sim_random(t_radio_sim_interface* pSim)
+{
+   u32 x = pSim->uRandState;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   pSim->uRandState = x;
+   return (float)(x >> 8) / (float)(1<<24);
+}
+
+static t_radio_sim_interface* _radio_sim_get_interface(int iInterfaceIndex, int bCreate)
+{
+   if ( (iInterfaceIndex < 0) || (iInterfaceIndex >= MAX_RADIO_INTERFACES) )
+      return NULL;
+   if ( (NULL != s_pRadioSimInterfaces[iInterfaceIndex]) || (! bCreate) )
+      return s_pRadioSimInterfaces[iInterfaceIndex];
+
+   t_radio_sim_interface* pSim = (t_radio_sim_interface*) malloc(sizeof(t_radio_sim_interface));
+   if ( NULL == pSim )
+   {
+      log_softerror_and_alarm("[RadioSim] Failed to allocate simulated radio interface %d.", iInterfaceIndex+1);
+      return NULL;
+   }
+   memset(pSim, 0, sizeof(t_radio_sim_interface));
+   pSim->iInterfaceIndex = iInterfaceIndex;
+   pSim->iRxSocket = -1;
+   pSim->iRxPortFilter = -1;
+   pSim->iTxSocket = -1;
+   pthread_mutex_init(&pSim->txMutex, NULL);
+   pthread_condattr_t condAttr;
+   pthread_condattr_init(&condAttr);
+   pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+   pthread_cond_init(&pSim->txCond, &condAttr);
+   pthread_condattr_destroy(&condAttr);
+
+   t_radio_sim_config* pConfig = hardware_radio_sim_get_config();
+   pSim->uRandState = pConfig->uSeed;
+   if ( 0 == pSim->uRandState )
+      pSim->uRandState = (u32)_radio_sim_get_time_us();
+   pSim->uRandState = pSim->uRandState * 2654435761u + (u32)iInterfaceIndex + 1;
+   if ( 0 == pSim->uRandState )
+      pSim->uRandState = 1;
+
+   s_pRadioSimInterfaces[iInterfaceIndex] = pSim;
+   return pSim;
+}
+
+int radio_sim_open_for_read(int iInterfaceIndex, int iPortFilter)
+{
+   t_radio_sim_interface* pSim = _radio_sim_get_interface(iInterfaceIndex, 1);
+   if ( NULL == pSim )
+      return -1;
+   if ( pSim->iRxSocket >= 0 )
+      radio_sim_close_for_read(iInterfaceIndex);
+
+   t_radio_sim_config* pConfig = hardware_radio_sim_get_config();
+   hardware_radio_sim_get_socket_path(pConfig->szNode, iInterfaceIndex, pSim->szRxSocketPath);
+
+   int iSocket = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+   if ( iSocket < 0 )
+   {
+      log_softerror_and_alarm("[RadioSim] Failed to create rx socket for radio interface %d, error: %d (%s)", iInterfaceIndex+1, errno, strerror(errno));
+      return -1;
+   }
+
+   struct sockaddr_un addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strncpy(addr.sun_path, pSim->szRxSocketPath, sizeof(addr.sun_path)-1);
+   unlink(pSim->szRxSocketPath);
+   if ( 0 != bind(iSocket, (struct sockaddr*)&addr, sizeof(addr)) )
+   {
+      log_softerror_and_alarm("[RadioSim] Failed to bind rx socket [%s] for radio interface %d, error: %d (%s)", pSim->szRxSocketPath, iInterfaceIndex+1, errno, strerror(errno));
+      close(iSocket);
+      return -1;
+   }
+
+   int iBufferSize = 4*1024*1024;
+   if ( 0 != setsockopt(iSocket, SOL_SOCKET, SO_RCVBUF, &iBufferSize, sizeof(iBufferSize)) )
+      log_softerror_and_alarm("[RadioSim] Failed to set rx socket buffer size for radio interface %d.", iInterfaceIndex+1);
+
+   pSim->iRxSocket = iSocket;
+   pSim->iRxPortFilter = iPortFilter;
+   log_line("[RadioSim] Opened simulated radio interface %d for read on [%s], fd: %d, port filter: %d", iInterfaceIndex+1, pSim->szRxSocketPath, iSocket, iPortFilter);
+   return iSocket;
+}
+
+void radio_sim_close_for_read(int iInterfaceIndex)
+{
+   t_radio_sim_interface* pSim = _radio_sim_get_interface(iInterfaceIndex, 0);
+   if ( (NULL == pSim) || (pSim->iRxSocket < 0) )
+      return;
+   close(pSim->iRxSocket);
+   unlink(pSim->szRxSocketPath);
+   log_line("[RadioSim] Closed simulated radio interface %d used for read (fd %d), received frames: %u, filtered out: %u",
+      iInterfaceIndex+1, pSim->iRxSocket, pSim->uStatsRxFrames, pSim->uStatsRxFiltered);
+   pSim->iRxSocket = -1;
+}
+
+int radio_sim_is_open_for_read(int iInterfaceIndex)
+{
+   t_radio_sim_interface* pSim = _radio_sim_get_interface(iInterfaceIndex, 0);
+   if ( (NULL == pSim) || (pSim->iRxSocket < 0) )
+      return 0;
+   return 1;
+}
+
+// Same checks as the pcap filters used on real interfaces: data frame, Ruby signature and radio port
+static int _radio_sim_frame_passes_filter(t_radio_sim_interface* pSim, u8* pIEEEFrame, int iLength)
+{
+   if ( iLength < 24 )
+      return 0;
+   if ( (pIEEEFrame[0] != 0x08) || (pIEEEFrame[1] != 0x01) )
+      return 0;
+   if ( (pIEEEFrame[10] != 0x13) || (pIEEEFrame[11] != 0x12) || (pIEEEFrame[12] != 0x34) || (pIEEEFrame[13] != 0x56) )
+      return 0;
+   if ( (pSim->iRxPortFilter >= 0) && (pIEEEFrame[4] != (u8)pSim->iRxPortFilter) )
+      return 0;
+   return 1;
+}
+
+u8* radio_sim_get_next_frame(int iInterfaceIndex, int* piFrameLength)
+{
+   if ( NULL != piFrameLength )
+      *piFrameLength = 0;
+   t_radio_sim_interface* pSim = _radio_sim_get_interface(iInterfaceIndex, 0);
+   if ( (NULL == pSim) || (pSim->iRxSocket < 0) )
+      return NULL;
+
+   radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(iInterfaceIndex);
+
+   // Room for the synthetic radiotap header in front of the received ieee frame
+   const int iRadiotapRoom = 20;
+   u8* pRecv = pSim->uRxBuffer + iRadiotapRoom - (int)sizeof(t_radio_sim_frame_header);
+
+   while ( 1 )
+   {
+      int iLength = recv(pSim->iRxSocket, pRecv, RADIO_SIM_MAX_FRAME_SIZE + sizeof(t_radio_sim_frame_header), MSG_DONTWAIT);
+      if ( iLength <= 0 )
+         return NULL;
+
+      t_radio_sim_frame_header header;
+      if ( iLength < (int)sizeof(t_radio_sim_frame_header) )
+      {
+         pSim->uStatsRxFiltered++;
+         continue;
+      }
+      memcpy(&header, pRecv, sizeof(t_radio_sim_frame_header));
+      u8* pIEEEFrame = pRecv + sizeof(t_radio_sim_frame_header);
+      int iIEEELength = iLength - (int)sizeof(t_radio_sim_frame_header);
+      if ( (header.uMagic != RADIO_SIM_FRAME_MAGIC) || (! _radio_sim_frame_passes_filter(pSim, pIEEEFrame, iIEEELength)) )
+      {
+         pSim->uStatsRxFiltered++;
+         continue;
+      }
+      // Different channels don't hear each other
+      if ( (NULL != pRadioHWInfo) && (0 != pRadioHWInfo->uCurrentFrequencyKhz) && (0 != header.uFrequencyKhz) )
+      if ( pRadioHWInfo->uCurrentFrequencyKhz != header.uFrequencyKhz )
+      {
+         pSim->uStatsRxFiltered++;
+         continue;
+      }
+
+      // Build the rx radiotap header right before the ieee frame
+      int iRadiotapLength = header.uIsMCS?20:17;
+      u8* pRadiotap = pIEEEFrame - iRadiotapLength;
+      u32 uPresent = (1<<IEEE80211_RADIOTAP_FLAGS) | (1<<IEEE80211_RADIOTAP_CHANNEL) | (1<<IEEE80211_RADIOTAP_DBM_ANTSIGNAL) |
+                     (1<<IEEE80211_RADIOTAP_DBM_ANTNOISE) | (1<<IEEE80211_RADIOTAP_ANTENNA);
+      if ( header.uIsMCS )
+         uPresent |= (1<<IEEE80211_RADIOTAP_MCS);
+      else
+         uPresent |= (1<<IEEE80211_RADIOTAP_RATE);
+      u16 uFreqMhz = (u16)(header.uFrequencyKhz/1000);
+      u16 uChannelFlags = (header.uFrequencyKhz > 3000000)?0x0140:0x00A0;
+
+      memset(pRadiotap, 0, iRadiotapLength);
+      pRadiotap[0] = 0;
+      pRadiotap[1] = 0;
+      pRadiotap[2] = iRadiotapLength & 0xFF;
+      pRadiotap[3] = 0;
+      pRadiotap[4] = uPresent & 0xFF;
+      pRadiotap[5] = (uPresent >> 8) & 0xFF;
+      pRadiotap[6] = (uPresent >> 16) & 0xFF;
+      pRadiotap[7] = (uPresent >> 24) & 0xFF;
+      pRadiotap[8] = 0; // flags: no FCS at the end
+      pRadiotap[9] = header.uIsMCS?0:header.uRate;
+      pRadiotap[10] = uFreqMhz & 0xFF;
+      pRadiotap[11] = (uFreqMhz >> 8) & 0xFF;
+      pRadiotap[12] = uChannelFlags & 0xFF;
+      pRadiotap[13] = (uChannelFlags >> 8) & 0xFF;
+      pRadiotap[14] = (u8)header.iRSSI;
+      pRadiotap[15] = (u8)header.iNoise;
+      pRadiotap[16] = 0; // antenna index
+      if ( header.uIsMCS )
+      {
+         pRadiotap[17] = IEEE80211_RADIOTAP_MCS_HAVE_MCS;
+         pRadiotap[18] = 0;
+         pRadiotap[19] = header.uRate;
+      }
+
+      pSim->uStatsRxFrames++;
+      if ( NULL != piFrameLength )
+         *piFrameLength = iIEEELength + iRadiotapLength;
+      return pRadiotap;
+   }
+   return NULL;
+}
+
+static void* _thread_radio_sim_tx(void* pParam)
+{
+   t_radio_sim_interface* pSim = (t_radio_sim_interface*)pParam;
+   log_line("[RadioSim] Started tx scheduler thread for simulated radio interface %d.", pSim->iInterfaceIndex+1);
+
+   pthread_mutex_lock(&pSim->txMutex);
+   while ( ! pSim->iTxThreadStop )
+   {
+      if ( 0 == pSim->iTxQueueCount )
+      {
+         pthread_cond_wait(&pSim->txCond, &pSim->txMutex);
+         continue;
+      }
+      t_radio_sim_tx_slot* pSlot = &pSim->txSlots[pSim->iTxQueueHead];
+      unsigned long long uTimeNow = _radio_sim_get_time_us();
+      if ( pSlot->uDueTimeUs > uTimeNow )
+      {
+         struct timespec ts;
+         ts.tv_sec = pSlot->uDueTimeUs / 1000000LL;
+         ts.tv_nsec = (pSlot->uDueTimeUs % 1000000LL) * 1000LL;
+         pthread_cond_timedwait(&pSim->txCond, &pSim->txMutex, &ts);
+         continue;
+      }
+
+      // The slot is not reused until it's removed from the queue, so send it without holding the lock
+      pthread_mutex_unlock(&pSim->txMutex);
+      int iRes = sendto(pSim->iTxSocket, pSlot->pData, pSlot->iLength, MSG_DONTWAIT, (struct sockaddr*)&pSim->txPeerAddr, sizeof(pSim->txPeerAddr));
+      pthread_mutex_lock(&pSim->txMutex);
+      if ( iRes != pSlot->iLength )
+         pSim->uStatsTxNoPeer++;
+
+      pSim->iTxQueueHead = (pSim->iTxQueueHead + 1) % RADIO_SIM_TX_QUEUE_SLOTS;
+      pSim->iTxQueueCount--;
+   }
+   pthread_mutex_unlock(&pSim->txMutex);
+
+   log_line("[RadioSim] Stopped tx scheduler thread for simulated radio interface %d.", pSim->iInterfaceIndex+1);
+   return NULL;
+}
+
+int radio_sim_open_for_write(int iInterfaceIndex)
+{
+   t_radio_sim_interface* pSim = _radio_sim_get_interface(iInterfaceIndex, 1);
+   if ( NULL == pSim )
+      return -1;
+   if ( pSim->iTxSocket >= 0 )
+      radio_sim_close_for_write(iInterfaceIndex);
+
+   if ( NULL == pSim->pTxFrames )
+   {
+      pSim->pTxFrames = (u8*) malloc(RADIO_SIM_TX_QUEUE_SLOTS * (RADIO_SIM_MAX_FRAME_SIZE + sizeof(t_radio_sim_frame_header)));
+      if ( NULL == pSim->pTxFrames )
+      {
+         log_softerror_and_alarm("[RadioSim] Failed to allocate tx queue for radio interface %d.", iInterfaceIndex+1);
+         return -1;
+      }
+      for( int i=0; i<RADIO_SIM_TX_QUEUE_SLOTS; i++ )
+         pSim->txSlots[i].pData = pSim->pTxFrames + i * (RADIO_SIM_MAX_FRAME_SIZE + sizeof(t_radio_sim_frame_header));
+   }
+
+   t_radio_sim_config* pConfig = hardware_radio_sim_get_config();
+   char szPeerPath[MAX_FILE_PATH_SIZE];
+   hardware_radio_sim_get_socket_path(pConfig->szPeer, iInterfaceIndex, szPeerPath);
+   memset(&pSim->txPeerAddr, 0, sizeof(pSim->txPeerAddr));
+   pSim->txPeerAddr.sun_family = AF_UNIX;
+   strncpy(pSim->txPeerAddr.sun_path, szPeerPath, sizeof(pSim->txPeerAddr.sun_path)-1);
+
+   int iSocket = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+   if ( iSocket < 0 )
+   {
+      log_softerror_and_alarm("[RadioSim] Failed to create tx socket for radio interface %d, error: %d (%s)", iInterfaceIndex+1, errno, strerror(errno));
+      return -1;
+   }
+
+   pthread_mutex_lock(&pSim->txMutex);
+   pSim->iTxSocket = iSocket;
+   pSim->iTxQueueHead = 0;
+   pSim->iTxQueueCount = 0;
+   pSim->iGEStateBad = 0;
+   pSim->uAirFreeTimeUs = 0;
+   pSim->uLastDueTimeUs = 0;
+   pSim->iTxThreadStop = 0;
+   pthread_mutex_unlock(&pSim->txMutex);
+
+   if ( 0 != pthread_create(&pSim->txThread, NULL, &_thread_radio_sim_tx, pSim) )
+   {
+      log_softerror_and_alarm("[RadioSim] Failed to create tx thread for radio interface %d.", iInterfaceIndex+1);
+      close(iSocket);
+      pSim->iTxSocket = -1;
+      return -1;
+   }
+   pSim->iTxThreadRunning = 1;
+   log_line("[RadioSim] Opened simulated radio interface %d for write to [%s], fd: %d", iInterfaceIndex+1, szPeerPath, iSocket);
+   return iSocket;
+}
+
+void radio_sim_close_for_write(int iInterfaceIndex)
+{
+   t_radio_sim_interface* pSim = _radio_sim_get_interface(iInterfaceIndex, 0);
+   if ( (NULL == pSim) || (pSim->iTxSocket < 0) )
+      return;
+
+   if ( pSim->iTxThreadRunning )
+   {
+      pthread_mutex_lock(&pSim->txMutex);
+      pSim->iTxThreadStop = 1;
+      pthread_cond_signal(&pSim->txCond);
+      pthread_mutex_unlock(&pSim->txMutex);
+      pthread_join(pSim->txThread, NULL);
+      pSim->iTxThreadRunning = 0;
+   }
+   radio_sim_log_stats(iInterfaceIndex);
+   close(pSim->iTxSocket);
+   pSim->iTxSocket = -1;
+   pSim->iTxQueueCount = 0;
+   log_line("[RadioSim] Closed simulated radio interface %d used for write.", iInterfaceIndex+1);
+}
+
+int radio_sim_is_open_for_write(int iInterfaceIndex)
+{
+   t_radio_sim_interface* pSim = _radio_sim_get_interface(iInterfaceIndex, 0);
+   if ( (NULL == pSim) || (pSim->iTxSocket < 0) )
+      return 0;
+   return 1;
+}
+
+static void _radio_sim_get_tx_rate(u8* pData, int iLength, t_radio_sim_frame_header* pHeader)
+{
+   pHeader->uIsMCS = 0;
+   pHeader->uRate = 12;
+   struct ieee80211_radiotap_iterator rti;
+   if ( ieee80211_radiotap_iterator_init(&rti, (struct ieee80211_radiotap_header*)pData, iLength) < 0 )
+      return;
+   while ( 0 == ieee80211_radiotap_iterator_next(&rti) )
+   {
+      if ( rti.this_arg_index == IEEE80211_RADIOTAP_RATE )
+      {
+         pHeader->uIsMCS = 0;
+         pHeader->uRate = *((u8*)rti.this_arg);
+      }
+      else if ( rti.this_arg_index == IEEE80211_RADIOTAP_MCS )
+      {
+         pHeader->uIsMCS = 1;
+         pHeader->uRate = rti.this_arg[2];
+      }
+   }
+}
+
+int radio_sim_write_frame(int iInterfaceIndex, u8* pData, int iLength)
+{
+   t_radio_sim_interface* pSim = _radio_sim_get_interface(iInterfaceIndex, 0);
+   if ( (NULL == pSim) || (pSim->iTxSocket < 0) || (NULL == pData) || (iLength < 4) )
+      return 0;
+
+   int iRadiotapLength = pData[2] | (((int)pData[3]) << 8);
+   int iIEEELength = iLength - iRadiotapLength;
+   if ( (iRadiotapLength < 8) || (iIEEELength <= 0) || (iIEEELength > RADIO_SIM_MAX_FRAME_SIZE) )
+   {
+      log_softerror_and_alarm("[RadioSim] Invalid tx frame on radio interface %d (%d bytes, radiotap: %d bytes).", iInterfaceIndex+1, iLength, iRadiotapLength);
+      return 0;
+   }
+
+   t_radio_sim_config* pConfig = hardware_radio_sim_get_config();
+   radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(iInterfaceIndex);
+   t_radio_sim_frame_header header;
+   header.uMagic = RADIO_SIM_FRAME_MAGIC;
+   header.uFrequencyKhz = (NULL != pRadioHWInfo)?pRadioHWInfo->uCurrentFrequencyKhz:0;
+   _radio_sim_get_tx_rate(pData, iRadiotapLength, &header);
+
+   unsigned long long uTimeNow = _radio_sim_get_time_us();
+
+   pthread_mutex_lock(&pSim->txMutex);
+   pSim->uStatsTxFrames++;
+   header.uFrameIndex = pSim->uTxFrameIndex++;
+
+   // Air time: frames wait for the air to be free, above the max queue time they are dropped
+   if ( pSim->uAirFreeTimeUs < uTimeNow )
+      pSim->uAirFreeTimeUs = uTimeNow;
+   if ( pConfig->uRateKbps > 0 )
+   {
+      if ( pSim->uAirFreeTimeUs - uTimeNow > ((unsigned long long)pConfig->uMaxQueueMs) * 1000LL )
+      {
+         pSim->uStatsTxQueueDropped++;
+         pthread_mutex_unlock(&pSim->txMutex);
+         return 1;
+      }
+      pSim->uAirFreeTimeUs += ((unsigned long long)iIEEELength) * 8000LL / pConfig->uRateKbps;
+   }
+
+   // Gilbert-Elliott channel state, then loss for the current state
+   if ( pSim->iGEStateBad )
+   {
+      if ( _radio_sim_random(pSim) < pConfig->fGEProbBadToGood )
+         pSim->iGEStateBad = 0;
+   }
+   else if ( (pConfig->fGEProbGoodToBad > 0.0) && (_radio_sim_random(pSim) < pConfig->fGEProbGoodToBad) )
+      pSim->iGEStateBad = 1;
+
+   float fLoss = pSim->iGEStateBad?pConfig->fGELossBad:pConfig->fLoss;
+   if ( (fLoss > 0.0) && (_radio_sim_random(pSim) < fLoss) )
+   {
+      pSim->uStatsTxLost++;
+      pthread_mutex_unlock(&pSim->txMutex);
+      return 1;
+   }
+
+   if ( pSim->iTxQueueCount >= RADIO_SIM_TX_QUEUE_SLOTS )
+   {
+      pSim->uStatsTxQueueDropped++;
+      pthread_mutex_unlock(&pSim->txMutex);
+      return 1;
+   }
+
+   int iRSSI = pSim->iGEStateBad?pConfig->iRSSIBad:pConfig->iRSSIGood;
+   iRSSI += (int)(_radio_sim_random(pSim) * 5.0) - 2;
+   header.iRSSI = (int8_t)iRSSI;
+   header.iNoise = (int8_t)(pConfig->iNoise + (int)(_radio_sim_random(pSim) * 3.0) - 1);
+
+   // Radio frames don't get reordered: jitter never moves a frame before the previous one
+   unsigned long long uDueTimeUs = pSim->uAirFreeTimeUs + ((unsigned long long)pConfig->uLatencyMs) * 1000LL;
+   if ( pConfig->uJitterMs > 0 )
+      uDueTimeUs += (unsigned long long)(_radio_sim_random(pSim) * (float)pConfig->uJitterMs * 1000.0);
+   if ( uDueTimeUs < pSim->uLastDueTimeUs )
+      uDueTimeUs = pSim->uLastDueTimeUs;
+   pSim->uLastDueTimeUs = uDueTimeUs;
+
+   t_radio_sim_tx_slot* pSlot = &pSim->txSlots[(pSim->iTxQueueHead + pSim->iTxQueueCount) % RADIO_SIM_TX_QUEUE_SLOTS];
+   memcpy(pSlot->pData, &header, sizeof(t_radio_sim_frame_header));
+   memcpy(pSlot->pData + sizeof(t_radio_sim_frame_header), pData + iRadiotapLength, iIEEELength);
+   pSlot->iLength = iIEEELength + sizeof(t_radio_sim_frame_header);
+   pSlot->uDueTimeUs = uDueTimeUs;
+   pSim->iTxQueueCount++;
+   if ( 1 == pSim->iTxQueueCount )
+      pthread_cond_signal(&pSim->txCond);
+   pthread_mutex_unlock(&pSim->txMutex);
+   return 1;
+}
+
+void radio_sim_log_stats(int iInterfaceIndex)
+{
+   t_radio_sim_interface* pSim = _radio_sim_get_interface(iInterfaceIndex, 0);
+   if ( NULL == pSim )
+      return;
+   log_line("[RadioSim] Simulated radio interface %d: tx frames: %u, lost on air: %u, dropped (queue full): %u, not delivered (no peer): %u, rx frames: %u, rx filtered: %u",
+      iInterfaceIndex+1, pSim->uStatsTxFrames, pSim->uStatsTxLost, pSim->uStatsTxQueueDropped, pSim->uStatsTxNoPeer,
+      pSim->uStatsRxFrames, pSim->uStatsRxFiltered);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware_radio_sim.h"
+
+// Loopback radio link for the simulated radio interfaces (see hardware_radio_sim.h).
+// Each interface binds a unix datagram socket for rx and sends its frames to the socket
+// of the same interface index of the peer node. Frames go out through a scheduler thread
+// that applies the configured loss, latency, jitter and bandwidth cap. On rx, the sender's
+// radiotap header is replaced by a synthetic rx radiotap header (rate, channel, RSSI, noise),
+// so the frames are parsed exactly as the ones captured from a monitor mode interface.
+
+#define RADIO_SIM_MAX_FRAME_SIZE 2048
+#define RADIO_SIM_TX_QUEUE_SLOTS 1024
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returns the selectable fd or -1 on failure. iPortFilter is the encoded radio port to accept, or -1 for all.
+int radio_sim_open_for_read(int iInterfaceIndex, int iPortFilter);
+void radio_sim_close_for_read(int iInterfaceIndex);
+int radio_sim_is_open_for_read(int iInterfaceIndex);
+
+// Returns the next received frame (synthetic radiotap header included), or NULL if there is none pending.
+// The pointer is valid until the next call on the same interface.
+u8* radio_sim_get_next_frame(int iInterfaceIndex, int* piFrameLength);
+
+// Returns the selectable fd or -1 on failure
+int radio_sim_open_for_write(int iInterfaceIndex);
+void radio_sim_close_for_write(int iInterfaceIndex);
+int radio_sim_is_open_for_write(int iInterfaceIndex);
+
+// pData is a full tx frame (radiotap + ieee header + payload). Returns 1 if the frame was accepted
+// (a frame lost on the simulated air is still accepted), 0 on error.
+int radio_sim_write_frame(int iInterfaceIndex, u8* pData, int iLength);
+
+void radio_sim_log_stats(int iInterfaceIndex);
+
+#ifdef __cplusplus
+}
+#endif
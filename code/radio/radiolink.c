@@ -30,7 +30,11 @@
     SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // for sendmmsg
+#endif
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <netpacket/packet.h>
 #include <net/if.h>
 #include <netinet/ether.h>
@@ -50,18 +54,23 @@
 #include "radiolink.h"
 #include "radiopackets2.h"
 #include "radio_rx.h"
+#include "radio_rx_ring.h"
+#include "radio_sim.h"
 
 //#define DEBUG_PACKET_RECEIVED
 //#define DEBUG_PACKET_SENT
 
 int s_bRadioDebugFlag = 0;
 int s_iUsePCAPForTx = DEFAULT_USE_PPCAP_FOR_TX;
+int s_iUseRxRing = DEFAULT_USE_RX_RING;
 int s_iBypassSocketBuffers = DEFAULT_BYPASS_SOCKET_BUFFERS;
 int s_iRadioInterfacesBroken = 0;
-int s_iRadioLastReadErrorCode = RADIO_READ_ERROR_NO_ERROR;
+// Per thread, radio interfaces can be read from multiple rx threads
+__thread int s_iRadioLastReadErrorCode = RADIO_READ_ERROR_NO_ERROR;
 int s_iVehicleBehindMilisec = 0;
 
-u8 sPayloadBufferRead[MAX_PACKET_LENGTH_PCAP];
+// Per thread too: the pcap read path returns a pointer to it
+__thread u8 sPayloadBufferRead[MAX_PACKET_LENGTH_PCAP];
 int sEnableCRCGen = 0;
 
 int sRadioDataRate_bps = DEFAULT_RADIO_DATARATE_VIDEO_ATHEROS; // positive: clasic in bps; negative MCS (starts from -1)
@@ -71,7 +80,7 @@ int s_iUseTemporaryRadioFrameFlags = 0;
 
 int sAutoIncrementPacketCounter = 1;
 u32 sRadioReceivedFramesType = RADIO_FLAGS_FRAME_TYPE_DATA;
-u32 sRadioLastReceivedHeadersLength = 0;
+__thread u32 sRadioLastReceivedHeadersLength = 0;
 
 int s_iLastProcessingErrorCode = 0;
 
@@ -100,6 +109,20 @@ pthread_mutex_t s_pMutexRadioSyncRxTxThreads;
 int s_iMutexRadioSyncRxTxThreadsInitialized = 0;
 
 u8 s_uLastPacketBuilt[MAX_PACKET_TOTAL_SIZE];
+
+// Batched tx: raw frames are accumulated per interface and submitted with a single sendmmsg call
+typedef struct
+{
+   int iEnabled;
+   u8* pFrames;
+   int iCount;
+   int iLengths[RADIO_TX_BATCH_MAX_PACKETS];
+   struct mmsghdr msgs[RADIO_TX_BATCH_MAX_PACKETS];
+   struct iovec iovs[RADIO_TX_BATCH_MAX_PACKETS];
+} t_radio_tx_batch;
+
+t_radio_tx_batch s_RadioTxBatch[MAX_RADIO_INTERFACES];
+int s_iRadioTxBatchActive = 0;
 u32 s_uLastRadioPingSentTime = 0;
 u8 s_uLastRadioPingId = 0;
 
@@ -177,6 +200,13 @@ void radio_init_link_structures()
       }
    }
 
+   for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+   {
+      s_RadioTxBatch[i].iEnabled = DEFAULT_RADIO_TX_BATCHING;
+      s_RadioTxBatch[i].iCount = 0;
+   }
+   s_iRadioTxBatchActive = 0;
+
 #ifdef FEATURE_RADIO_SYNCHRONIZE_RXTX_THREADS
    log_line("[Radio] Initialize and use radio rxtx threads synchronization.");
    if ( 0 == s_iMutexRadioSyncRxTxThreadsInitialized )
@@ -294,6 +324,141 @@ void radio_set_use_pcap_for_tx(int iEnablePCAPTx)
       log_line("[Radio] Set using sockets for radio tx");
 }
 
+void radio_set_use_rx_ring(int iEnableRxRing)
+{
+   s_iUseRxRing = iEnableRxRing;
+   if ( s_iUseRxRing )
+      log_line("[Radio] Set using mmap ring for radio rx");
+   else
+      log_line("[Radio] Set using ppcap for radio rx");
+}
+
+void radio_set_tx_batching(int iInterfaceIndex, int iEnable)
+{
+   if ( (iInterfaceIndex < 0) || (iInterfaceIndex >= MAX_RADIO_INTERFACES) )
+      return;
+   if ( s_RadioTxBatch[iInterfaceIndex].iEnabled == iEnable )
+      return;
+   if ( s_RadioTxBatch[iInterfaceIndex].iEnabled && (! iEnable) )
+      radio_tx_batch_flush(iInterfaceIndex);
+   s_RadioTxBatch[iInterfaceIndex].iEnabled = iEnable;
+   log_line("[Radio] Set batched tx for radio interface %d: %s", iInterfaceIndex+1, iEnable?"on":"off");
+}
+
+// Batching is done using sendmmsg on the raw tx socket, so it's not available in ppcap tx mode or on simulated radios
+int radio_tx_batching_is_enabled(int iInterfaceIndex)
+{
+   if ( (iInterfaceIndex < 0) || (iInterfaceIndex >= MAX_RADIO_INTERFACES) )
+      return 0;
+   if ( s_iUsePCAPForTx || (! s_RadioTxBatch[iInterfaceIndex].iEnabled) )
+      return 0;
+   if ( radio_sim_is_open_for_write(iInterfaceIndex) )
+      return 0;
+   return 1;
+}
+
+void radio_tx_batch_begin()
+{
+   s_iRadioTxBatchActive = 1;
+}
+
+// Returns a buffer where the next raw frame for this interface can be built in place, or NULL if tx is not batched now
+u8* radio_tx_batch_get_frame_buffer(int iInterfaceIndex)
+{
+   if ( (! s_iRadioTxBatchActive) || (! radio_tx_batching_is_enabled(iInterfaceIndex)) )
+      return NULL;
+
+   t_radio_tx_batch* pBatch = &s_RadioTxBatch[iInterfaceIndex];
+   if ( NULL == pBatch->pFrames )
+   {
+      pBatch->pFrames = (u8*) malloc(RADIO_TX_BATCH_MAX_PACKETS * RADIO_TX_BATCH_FRAME_SIZE);
+      if ( NULL == pBatch->pFrames )
+      {
+         log_softerror_and_alarm("[Radio] Failed to allocate tx batch buffers for radio interface %d. Disable batched tx on it.", iInterfaceIndex+1);
+         pBatch->iEnabled = 0;
+         return NULL;
+      }
+   }
+   if ( pBatch->iCount >= RADIO_TX_BATCH_MAX_PACKETS )
+      radio_tx_batch_flush(iInterfaceIndex);
+   return pBatch->pFrames + pBatch->iCount * RADIO_TX_BATCH_FRAME_SIZE;
+}
+
+// Returns the number of frames sent or -1 on error
+int radio_tx_batch_flush(int iInterfaceIndex)
+{
+   if ( (iInterfaceIndex < 0) || (iInterfaceIndex >= MAX_RADIO_INTERFACES) )
+      return 0;
+   t_radio_tx_batch* pBatch = &s_RadioTxBatch[iInterfaceIndex];
+   if ( pBatch->iCount <= 0 )
+      return 0;
+
+   int iCount = pBatch->iCount;
+   pBatch->iCount = 0;
+
+   radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(iInterfaceIndex);
+   if ( (NULL == pRadioHWInfo) || (0 == pRadioHWInfo->openedForWrite) || (pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd < 0) )
+   {
+      log_softerror_and_alarm("RadioError: Tried to write a batch of %d radio messages to an invalid interface (%d).", iCount, iInterfaceIndex+1);
+      return -1;
+   }
+
+   for( int i=0; i<iCount; i++ )
+   {
+      pBatch->iovs[i].iov_base = pBatch->pFrames + i * RADIO_TX_BATCH_FRAME_SIZE;
+      pBatch->iovs[i].iov_len = pBatch->iLengths[i];
+      memset(&pBatch->msgs[i], 0, sizeof(struct mmsghdr));
+      pBatch->msgs[i].msg_hdr.msg_iov = &pBatch->iovs[i];
+      pBatch->msgs[i].msg_hdr.msg_iovlen = 1;
+   }
+
+   #ifdef FEATURE_RADIO_SYNCHRONIZE_RXTX_THREADS
+   if ( 1 == s_iMutexRadioSyncRxTxThreadsInitialized )
+      pthread_mutex_lock(&s_pMutexRadioSyncRxTxThreads);
+   #endif
+
+   int iSent = 0;
+   int iRetries = 2;
+   while ( (iSent < iCount) && (iRetries > 0) )
+   {
+      int iRes = sendmmsg(pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd, &pBatch->msgs[iSent], iCount - iSent, 0);
+      if ( iRes <= 0 )
+      {
+         if ( (iRes < 0) && (errno == EINTR) )
+            continue;
+         iRetries--;
+         continue;
+      }
+      iSent += iRes;
+   }
+
+   #ifdef FEATURE_RADIO_SYNCHRONIZE_RXTX_THREADS
+   if ( 1 == s_iMutexRadioSyncRxTxThreadsInitialized )
+      pthread_mutex_unlock(&s_pMutexRadioSyncRxTxThreads);
+   #endif
+
+   if ( iSent < iCount )
+   {
+      // Each frame left in the batch is a failed radio message, same as when sent one by one
+      pRadioHWInfo->runtimeInterfaceInfoTx.iErrorCount += iCount - iSent;
+      log_softerror_and_alarm("RadioError: Failed to send batched radio messages on radio interface %d, fd=%d (%d sent of %d), error: %d, error count: %d",
+         iInterfaceIndex+1, pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd, iSent, iCount, errno, pRadioHWInfo->runtimeInterfaceInfoTx.iErrorCount);
+      return -1;
+   }
+   pRadioHWInfo->runtimeInterfaceInfoTx.iErrorCount = 0;
+   return iSent;
+}
+
+void radio_tx_batch_end()
+{
+   s_iRadioTxBatchActive = 0;
+   for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+   {
+      if ( s_RadioTxBatch[i].iCount > 0 )
+         radio_tx_batch_flush(i);
+   }
+}
+
 void radio_set_bypass_socket_buffers(int iBypass)
 {
    s_iBypassSocketBuffers = iBypass;
@@ -625,6 +790,21 @@ int _radio_open_interface_for_read_with_filter(int interfaceIndex, char* szFilte
    pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd = -1;
    pRadioHWInfo->runtimeInterfaceInfoRx.iErrorCount = 0;
 
+   if ( s_iUseRxRing )
+   {
+      int iFd = radio_rx_ring_open(interfaceIndex, pRadioHWInfo->szName, szFilter, szFilterPrism);
+      if ( iFd >= 0 )
+      {
+         pRadioHWInfo->runtimeInterfaceInfoRx.ppcap = NULL;
+         pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd = iFd;
+         reset_runtime_radio_rx_info(&(pRadioHWInfo->runtimeInterfaceInfoRx.radioHwRxInfo));
+         pRadioHWInfo->openedForRead = 1;
+         log_line("Opened radio interface %d (%s) for reading (mmap ring) on %s, filter: [%s]. Returned fd=%d", interfaceIndex+1, pRadioHWInfo->szName, str_format_frequency(pRadioHWInfo->uCurrentFrequencyKhz), szFilter, iFd);
+         return iFd;
+      }
+      log_softerror_and_alarm("Failed to open radio interface %d (%s) in mmap ring mode. Using ppcap for it.", interfaceIndex+1, pRadioHWInfo->szName);
+   }
+
    szErrbuf[0] = '\0';
    //pRadioHWInfo->runtimeInterfaceInfoRx.ppcap = pcap_open_live(pRadioHWInfo->szName, 4096, 1, 1, szErrbuf);
    pRadioHWInfo->runtimeInterfaceInfoRx.ppcap = pcap_create(pRadioHWInfo->szName, szErrbuf);
@@ -700,6 +880,26 @@ int _radio_open_interface_for_read_with_filter(int interfaceIndex, char* szFilte
    return pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd;
 }
 
+static int _radio_open_simulated_interface_for_read(int interfaceIndex, radio_hw_info_t* pRadioHWInfo, int iPortEncoded)
+{
+   s_iRadioInterfacesBroken = 0;
+   pRadioHWInfo->openedForRead = 0;
+   pRadioHWInfo->runtimeInterfaceInfoRx.ppcap = NULL;
+   pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd = -1;
+   pRadioHWInfo->runtimeInterfaceInfoRx.iErrorCount = 0;
+
+   int iFd = radio_sim_open_for_read(interfaceIndex, iPortEncoded);
+   if ( iFd < 0 )
+   {
+      log_softerror_and_alarm("Failed to open simulated radio interface %d (%s) for read.", interfaceIndex+1, pRadioHWInfo->szName);
+      return -1;
+   }
+   pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd = iFd;
+   reset_runtime_radio_rx_info(&(pRadioHWInfo->runtimeInterfaceInfoRx.radioHwRxInfo));
+   pRadioHWInfo->openedForRead = 1;
+   return iFd;
+}
+
 int radio_open_interface_for_read(int interfaceIndex, int portNumber)
 {
    char szFilter[256];
@@ -713,7 +913,11 @@ int radio_open_interface_for_read(int interfaceIndex, int portNumber)
    sprintf(szFilter, "ether[0x00:2] == 0x0801 && ether[0x0a:4] == 0x13123456 && ether[0x04:1] == 0x%.2x", port_encoded);
    sprintf(szFilterPrism, "radio[0x40:2] == 0x0801 && radio[0x4a:4] == 0x13123456 && radio[0x44:1] == 0x%.2x", port_encoded);
 
-   int iResult = _radio_open_interface_for_read_with_filter(interfaceIndex, szFilter, szFilterPrism);
+   int iResult = -1;
+   if ( hardware_radio_is_simulated_radio(pRadioHWInfo) )
+      iResult = _radio_open_simulated_interface_for_read(interfaceIndex, pRadioHWInfo, port_encoded);
+   else
+      iResult = _radio_open_interface_for_read_with_filter(interfaceIndex, szFilter, szFilterPrism);
    
    if ( iResult < 0 )
       return iResult;
@@ -750,7 +954,17 @@ int radio_open_interface_for_write(int interfaceIndex)
    pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd = -1;
    pRadioHWInfo->runtimeInterfaceInfoTx.iErrorCount = 0;
 
-   if ( s_iUsePCAPForTx )
+   if ( hardware_radio_is_simulated_radio(pRadioHWInfo) )
+   {
+      pRadioHWInfo->runtimeInterfaceInfoTx.ppcap = NULL;
+      pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd = radio_sim_open_for_write(interfaceIndex);
+      if ( pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd < 0 )
+      {
+         log_error_and_alarm("Failed to open simulated radio interface %d for write.", interfaceIndex+1);
+         return -1;
+      }
+   }
+   else if ( s_iUsePCAPForTx )
    {
       log_line("Using ppcap for tx packets.");
       char errbuf[PCAP_ERRBUF_SIZE];
@@ -852,7 +1066,17 @@ void radio_close_interface_for_read(int interfaceIndex)
 
    radio_rx_pause_interface(interfaceIndex, "Close radio interface");
    
-   if ( NULL != pRadioHWInfo->runtimeInterfaceInfoRx.ppcap )
+   if ( radio_sim_is_open_for_read(interfaceIndex) )
+   {
+      log_line("Closed simulated radio interface %d [%s] that was used for read, selectable read fd was: %d", interfaceIndex+1, pRadioHWInfo->szName, pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd);
+      radio_sim_close_for_read(interfaceIndex);
+   }
+   else if ( radio_rx_ring_is_open(interfaceIndex) )
+   {
+      log_line("Closed radio interface %d [%s] that was used for read (mmap ring), selectable read fd was: %d", interfaceIndex+1, pRadioHWInfo->szName, pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd);
+      radio_rx_ring_close(interfaceIndex);
+   }
+   else if ( NULL != pRadioHWInfo->runtimeInterfaceInfoRx.ppcap )
    {
       log_line("Closed radio interface %d [%s] that was used for read, selectable read fd was: %d, ppcap was: %d", interfaceIndex+1, pRadioHWInfo->szName, pRadioHWInfo->runtimeInterfaceInfoRx.selectable_fd, pRadioHWInfo->runtimeInterfaceInfoRx.ppcap);
       pcap_close(pRadioHWInfo->runtimeInterfaceInfoRx.ppcap);
@@ -890,7 +1114,9 @@ void radio_close_interface_for_write(int interfaceIndex)
 
    log_line("Closed radio interface %d (%s) that was used for write. Selectable write fd was: %d, ppcap was: %d", interfaceIndex+1, pRadioHWInfo->szName, pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd, pRadioHWInfo->runtimeInterfaceInfoTx.ppcap);
 
-   if ( s_iUsePCAPForTx )
+   if ( radio_sim_is_open_for_write(interfaceIndex) )
+      radio_sim_close_for_write(interfaceIndex);
+   else if ( s_iUsePCAPForTx )
    {
       if ( NULL != pRadioHWInfo->runtimeInterfaceInfoTx.ppcap )
          pcap_close(pRadioHWInfo->runtimeInterfaceInfoTx.ppcap);
@@ -909,10 +1135,28 @@ void radio_close_interface_for_write(int interfaceIndex)
    pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd = -1;
    pRadioHWInfo->runtimeInterfaceInfoTx.iErrorCount = 0;
    pRadioHWInfo->openedForWrite = 0;
+   if ( (interfaceIndex >= 0) && (interfaceIndex < MAX_RADIO_INTERFACES) )
+      s_RadioTxBatch[interfaceIndex].iCount = 0;
 }
 
 
 u8* radio_process_wlan_data_in(int interfaceNumber, int* outPacketLength, u32 uTimeNow)
+{
+   u32 uRxBufferRef = 0;
+   int iLength = 0;
+   u8* pPayload = radio_process_wlan_data_in_zero_copy(interfaceNumber, &iLength, uTimeNow, &uRxBufferRef);
+   if ( NULL != outPacketLength )
+      *outPacketLength = iLength;
+   if ( (NULL == pPayload) || (0 == uRxBufferRef) )
+      return pPayload;
+   memcpy(sPayloadBufferRead, pPayload, iLength);
+   return sPayloadBufferRead;
+}
+
+// Returns a pointer valid until the next read on the same interface from the same thread.
+// If *puRxBufferRef is not zero, the pointer is inside the mmap rx ring and can be kept longer
+// by taking a reference on it (radio_rx_ring_ref_acquire/release). Otherwise it must be copied.
+u8* radio_process_wlan_data_in_zero_copy(int interfaceNumber, int* outPacketLength, u32 uTimeNow, u32* puRxBufferRef)
 {
    radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(interfaceNumber);
 
@@ -920,6 +1164,8 @@ u8* radio_process_wlan_data_in(int interfaceNumber, int* outPacketLength, u32 uT
 
    if ( NULL != outPacketLength )
       *outPacketLength = 0;
+   if ( NULL != puRxBufferRef )
+      *puRxBufferRef = 0;
 
 
 #ifdef FEATURE_RADIO_SYNCHRONIZE_RXTX_THREADS
@@ -1000,9 +1246,31 @@ u8* radio_process_wlan_data_in(int interfaceNumber, int* outPacketLength, u32 uT
    */
    struct pcap_pkthdr pcapHeader;
    ppcapPacketHeader = &pcapHeader;
-   pRadioPayload = (u8*) pcap_next(pRadioHWInfo->runtimeInterfaceInfoRx.ppcap, ppcapPacketHeader); 
+   u32 uRxBufferRef = 0;
+   if ( radio_sim_is_open_for_read(interfaceNumber) )
+   {
+      int iFrameLength = 0;
+      pRadioPayload = radio_sim_get_next_frame(interfaceNumber, &iFrameLength);
+      pcapHeader.caplen = iFrameLength;
+      pcapHeader.len = iFrameLength;
+   }
+   else if ( radio_rx_ring_is_open(interfaceNumber) )
+   {
+      int iFrameLength = 0;
+      pRadioPayload = radio_rx_ring_get_next_frame(interfaceNumber, &iFrameLength, &uRxBufferRef);
+      pcapHeader.caplen = iFrameLength;
+      pcapHeader.len = iFrameLength;
+   }
+   else
+      pRadioPayload = (u8*) pcap_next(pRadioHWInfo->runtimeInterfaceInfoRx.ppcap, ppcapPacketHeader); 
    if ( NULL == pRadioPayload )
+   {
+      #ifdef FEATURE_RADIO_SYNCHRONIZE_RXTX_THREADS
+      if ( 1 == s_iMutexRadioSyncRxTxThreadsInitialized )
+         pthread_mutex_unlock(&s_pMutexRadioSyncRxTxThreads);
+      #endif
       return NULL;
+   }
    #ifdef DEBUG_PACKET_RECEIVED
    log_line("RX Buffer: caplen: %d bytes, len: %d", ppcapPacketHeader->caplen, ppcapPacketHeader->len);
    #endif
@@ -1176,11 +1444,48 @@ u8* radio_process_wlan_data_in(int interfaceNumber, int* outPacketLength, u32 uT
    }
    #endif
 
-   //return pRadioPayload;
+   // Frames from the mmap ring are handed out in place
+   if ( 0 != uRxBufferRef )
+   {
+      if ( NULL != puRxBufferRef )
+         *puRxBufferRef = uRxBufferRef;
+      return pRadioPayload;
+   }
    memcpy(sPayloadBufferRead, pRadioPayload, payloadLength);
    return sPayloadBufferRead;
 }
 
+// Nonce is unique per sender and packet within a session: source vehicle id, stream packet index and radio link packet index.
+// The counters restart on each boot; the session salt sent with the tag makes the key differ per session.
+static void _radio_packet_build_aead_nonce(t_packet_header* pPH, u8* pNonce)
+{
+   memcpy(pNonce, &pPH->vehicle_id_src, sizeof(u32));
+   memcpy(pNonce + 4, &pPH->stream_packet_idx, sizeof(u32));
+   memcpy(pNonce + 8, &pPH->radio_link_packet_index, sizeof(u16));
+   memcpy(pNonce + 10, &pPH->vehicle_id_dest, sizeof(u16));
+}
+
+int radio_packet_decrypt(u8* pPacketBuffer, int iPacketLength, int iBufferLength)
+{
+   t_packet_header* pPH = (t_packet_header*)pPacketBuffer;
+   int dx = sizeof(t_packet_header);
+   if ( iPacketLength < dx )
+      return 0;
+
+   if ( !(pPH->packet_flags_extended & PACKET_FLAGS_EXTENDED_BIT_AEAD) )
+   {
+      dpp(pPacketBuffer + dx, iPacketLength - dx);
+      return 1;
+   }
+
+   if ( iPacketLength + ENC_AEAD_TRAILER_SIZE > iBufferLength )
+      return 0;
+   u8 uNonce[ENC_AEAD_NONCE_SIZE];
+   _radio_packet_build_aead_nonce(pPH, uNonce);
+   u8* pSalt = pPacketBuffer + iPacketLength;
+   return dppa(pPacketBuffer, dx, pPacketBuffer + dx, iPacketLength - dx, uNonce, pSalt, pSalt + ENC_AEAD_SALT_SIZE);
+}
+
 // returns 0 for failure, total length of packet for success
 
 int packet_process_and_check(int interfaceNb, u8* pPacketBuffer, int iBufferLength, int* pbCRCOk)
@@ -1231,9 +1536,13 @@ int packet_process_and_check(int interfaceNb, u8* pPacketBuffer, int iBufferLeng
       #ifdef DEBUG_PACKET_RECEIVED
       log_line("enc detected");
       #endif
-      int dx = sizeof(t_packet_header);
-      int l = iPacketLength-dx;
-      dpp(pPacketBuffer + dx, l);
+      if ( ! radio_packet_decrypt(pPacketBuffer, iPacketLength, iBufferLength) )
+      {
+         s_iLastProcessingErrorCode = RADIO_PROCESSING_ERROR_CODE_INVALID_CRC_RECEIVED;
+         if ( NULL != pbCRCOk )
+            *pbCRCOk = 0;
+         return 0;
+      }
    }
 
    u32 uCRC = 0;
@@ -1357,15 +1666,36 @@ int radio_build_new_raw_ieee_packet(int iLocalRadioLinkId, u8* pRawPacket, u8* p
   
    t_packet_header* pPH = (t_packet_header*)pRawPacket;
    pPH->radio_link_packet_index = uRadioLinkPacketIndex;
+   int bAead = 0;
+   pPH->packet_flags_extended &= ~PACKET_FLAGS_EXTENDED_BIT_AEAD;
    if ( bEncrypt )
+   {
       pPH->packet_flags |= PACKET_FLAGS_BIT_HAS_ENCRYPTION;
+      // AEAD session salt and tag are appended after the packet; single packets only and only if they fit in a radio frame
+      if ( ENC_PP_MODE_AEAD == gpm() )
+      if ( pPH->total_length == nInputLength )
+      if ( totalRadioLength + ENC_AEAD_TRAILER_SIZE <= MAX_PACKET_TOTAL_SIZE )
+      {
+         bAead = 1;
+         pPH->packet_flags_extended |= PACKET_FLAGS_EXTENDED_BIT_AEAD;
+      }
+   }
 
    if ( pPH->packet_flags & PACKET_FLAGS_BIT_HEADERS_ONLY_CRC )
       radio_packet_compute_crc((u8*)pPH, sizeof(t_packet_header));
    else
       radio_packet_compute_crc((u8*)pPH, pPH->total_length);
 
-   if ( bEncrypt )
+   if ( bAead )
+   {
+      int dx = sizeof(t_packet_header);
+      u8 uNonce[ENC_AEAD_NONCE_SIZE];
+      _radio_packet_build_aead_nonce(pPH, uNonce);
+      u8* pSalt = pRawPacket + pPH->total_length;
+      eppa(pRawPacket, dx, pRawPacket+dx, pPH->total_length-dx, uNonce, pSalt, pSalt + ENC_AEAD_SALT_SIZE);
+      totalRadioLength += ENC_AEAD_TRAILER_SIZE;
+   }
+   else if ( bEncrypt )
    {
       int dx = sizeof(t_packet_header);
       epp(pRawPacket+dx, pPH->total_length-dx);
@@ -1410,6 +1740,27 @@ int radio_write_raw_ieee_packet(int interfaceIndex, u8* pData, int dataLength, i
      pPH = NULL;
    */
 
+   // Batched tx? Just queue it, it's sent on the next batch flush
+   if ( s_iRadioTxBatchActive && (0 == iRepeatCount) && (dataLength <= RADIO_TX_BATCH_FRAME_SIZE) )
+   {
+      u8* pFrame = radio_tx_batch_get_frame_buffer(interfaceIndex);
+      if ( NULL != pFrame )
+      {
+         if ( pFrame != pData )
+            memcpy(pFrame, pData, dataLength);
+         t_radio_tx_batch* pBatch = &s_RadioTxBatch[interfaceIndex];
+         pBatch->iLengths[pBatch->iCount] = dataLength;
+         pBatch->iCount++;
+         s_uPacketsSentUsingCurrent_RadioRate++;
+         s_uPacketsSentUsingCurrent_RadioFlags++;
+         return 1;
+      }
+   }
+
+   // Keep ordering with frames already waiting in a batch
+   if ( s_RadioTxBatch[interfaceIndex].iCount > 0 )
+      radio_tx_batch_flush(interfaceIndex);
+
    #ifdef FEATURE_RADIO_SYNCHRONIZE_RXTX_THREADS
    if ( 1 == s_iMutexRadioSyncRxTxThreadsInitialized )
       pthread_mutex_lock(&s_pMutexRadioSyncRxTxThreads);
@@ -1422,7 +1773,21 @@ int radio_write_raw_ieee_packet(int interfaceIndex, u8* pData, int dataLength, i
 
    for( int k=0; k<=iRepeatCount; k++ )
    {
-      if ( s_iUsePCAPForTx )
+      if ( radio_sim_is_open_for_write(interfaceIndex) )
+      {
+         if ( ! radio_sim_write_frame(interfaceIndex, pData, dataLength) )
+         {
+            log_softerror_and_alarm("RadioError: Failed to send radio message on simulated radio interface %d (%d bytes).", interfaceIndex+1, dataLength);
+            pRadioHWInfo->runtimeInterfaceInfoTx.iErrorCount++;
+            #ifdef FEATURE_RADIO_SYNCHRONIZE_RXTX_THREADS
+            if ( 1 == s_iMutexRadioSyncRxTxThreadsInitialized )
+               pthread_mutex_unlock(&s_pMutexRadioSyncRxTxThreads);
+            #endif
+            return 0;
+         }
+         pRadioHWInfo->runtimeInterfaceInfoTx.iErrorCount = 0;
+      }
+      else if ( s_iUsePCAPForTx )
       {
          len = pcap_inject(pRadioHWInfo->runtimeInterfaceInfoTx.ppcap, pData, dataLength);
          if ( len < dataLength )
@@ -42,6 +42,9 @@
 
 #define MAX_PACKET_LENGTH_PCAP 4096
 
+#define RADIO_TX_BATCH_MAX_PACKETS 40
+#define RADIO_TX_BATCH_FRAME_SIZE (MAX_PACKET_TOTAL_SIZE + 128)
+
 #define RADIO_PROCESSING_ERROR_NO_ERROR 0x00
 #define RADIO_PROCESSING_ERROR_CODE_INVALID_CRC_RECEIVED 0x01
 #define RADIO_PROCESSING_ERROR_CODE_PACKET_RECEIVED_TOO_SMALL 0x02
@@ -65,7 +68,17 @@ void radio_set_debug_flag();
 void radio_set_link_clock_delta(int iVehicleBehindMilisec);
 int  radio_get_link_clock_delta();
 void radio_set_use_pcap_for_tx(int iEnablePCAPTx);
+void radio_set_use_rx_ring(int iEnableRxRing);
 void radio_set_bypass_socket_buffers(int iBypass);
+
+// Batched tx: between begin and end, raw frames written to interfaces with batching enabled
+// are accumulated and submitted with one syscall per interface on flush/end
+void radio_set_tx_batching(int iInterfaceIndex, int iEnable);
+int  radio_tx_batching_is_enabled(int iInterfaceIndex);
+void radio_tx_batch_begin();
+u8*  radio_tx_batch_get_frame_buffer(int iInterfaceIndex);
+int  radio_tx_batch_flush(int iInterfaceIndex);
+void radio_tx_batch_end();
 int  radio_set_out_datarate(int rate_bps); // positive: classic in bps, negative: MCS; returns 1 if it was changed
 u32  radio_get_current_frames_flags();
 u32  radio_get_current_frames_flags_datarate();
@@ -91,10 +104,13 @@ void radio_close_interface_for_read(int interfaceIndex);
 void radio_close_interface_for_write(int interfaceIndex);
 
 u8* radio_process_wlan_data_in(int interfaceNumber, int* outPacketLength, u32 uTimeNow);
+u8* radio_process_wlan_data_in_zero_copy(int interfaceNumber, int* outPacketLength, u32 uTimeNow, u32* puRxBufferRef);
 int radio_get_last_read_error_code();
 
 // returns 0 for failure, total length of packet for success
 int packet_process_and_check(int interfaceNb, u8* pPacketBuffer, int iBufferLength, int* pbCRCOk);
+// Decrypts in place an encrypted received packet. Returns 0 if an AEAD packet fails authentication
+int radio_packet_decrypt(u8* pPacketBuffer, int iPacketLength, int iBufferLength);
 int get_last_processing_error_code();
 
 u32 radio_get_next_radio_link_packet_index(int iLocalRadioLinkId);
@@ -73,6 +73,26 @@ int radio_packet_check_crc(u8* pBuffer, int length)
    return 1;
 }
 
+// Returns the length of the radio packets chained at the start of a buffer already checked by packet_process_and_check.
+// An AEAD packet is followed by its salt and tag, not by another packet, so the chain stops after it.
+int radio_packets_get_authenticated_length(u8* pBuffer, int iBufferLength)
+{
+   if ( NULL == pBuffer )
+      return 0;
+   int iLength = 0;
+   while ( iBufferLength - iLength >= (int)sizeof(t_packet_header) )
+   {
+      t_packet_header* pPH = (t_packet_header*)(pBuffer + iLength);
+      int iPacketLength = pPH->total_length;
+      if ( (iPacketLength < (int)sizeof(t_packet_header)) || (iPacketLength > iBufferLength - iLength) )
+         break;
+      iLength += iPacketLength;
+      if ( (pPH->packet_flags & PACKET_FLAGS_BIT_HAS_ENCRYPTION) && (pPH->packet_flags_extended & PACKET_FLAGS_EXTENDED_BIT_AEAD) )
+         break;
+   }
+   return iLength;
+}
+
 int radio_packet_type_is_high_priority(u8 uPacketFlags, u8 uPacketType)
 {
    if ( uPacketFlags & PACKET_FLAGS_BIT_RETRANSMITED )
@@ -90,6 +90,7 @@
 #define PACKET_FLAGS_EXTENDED_BIT_SEND_ON_HIGH_CAPACITY_LINK_ONLY  (((u16)1)<<8)
 #define PACKET_FLAGS_EXTENDED_BIT_SEND_ON_LOW_CAPACITY_LINK_ONLY  (((u16)1)<<9)
 #define PACKET_FLAGS_EXTENDED_BIT_REQUIRE_ACK  (((u16)1)<<10)
+#define PACKET_FLAGS_EXTENDED_BIT_AEAD  (((u16)1)<<11) // Encrypted using ChaCha20-Poly1305, tag follows the packet (after total_length)
 
 // Max 8 components, for the first 3 bits of packet_flags field
 #define PACKET_COMPONENT_LOCAL_CONTROL 0 // Used only internally, to exchange data between processes
@@ -804,6 +805,7 @@ extern "C" {
 void radio_packet_init(t_packet_header* pPH, u8 component, u8 packet_type, u32 uStreamId);
 void radio_packet_compute_crc(u8* pBuffer, int length);
 int radio_packet_check_crc(u8* pBuffer, int length);
+int radio_packets_get_authenticated_length(u8* pBuffer, int iBufferLength);
 
 int radio_packet_type_is_high_priority(u8 uPacketFlags, u8 uPacketType);
 
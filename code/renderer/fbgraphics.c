@@ -40,6 +40,7 @@
 #endif
 
 #include "fbgraphics.h"
+#include "render_kernels.h"
 
 #ifdef FBG_PARALLEL
     void fbg_terminateFragments(struct _fbg *fbg);
@@ -799,24 +800,12 @@ void fbg_hline(struct _fbg *fbg, int x, int y, int w, unsigned char r, unsigned
 {
     unsigned char *pix_pointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
 
+    unsigned char color[4] = { r, g, b, a };
+
     if ( fbg->s_iEnableRectBlending )
-    {
-       for (int xx = 0; xx < w; xx++)
-       {
-         fbg_pixela_fast(fbg, pix_pointer, r,g,b,a);
-         pix_pointer += 4;
-       }
-    }
+       render_kernels_blend_color_span(pix_pointer, w, color, a);
     else
-    {
-       for (int xx = 0; xx < w; xx++)
-       {
-         *pix_pointer++ = r;
-         *pix_pointer++ = g;
-         *pix_pointer++ = b;
-         *pix_pointer++ = a;
-       }
-    }
+       render_kernels_fill_span(pix_pointer, w, color);
 }
 
 void fbg_vline(struct _fbg *fbg, int x, int y, int h, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
@@ -925,20 +914,15 @@ void fbg_polygon(struct _fbg *fbg, int num_vertices, int *vertices, unsigned cha
 
 void fbg_recta(struct _fbg *fbg, int x, int y, int w, int h, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
 {
-    int xx = 0, yy = 0, w4 = w * fbg->components;
+    int yy = 0;
+    unsigned char color[4] = { r, g, b, a };
 
     unsigned char *pix_pointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
 
     for (yy = 0; yy < h; yy += 1)
     {
-        for (xx = 0; xx < w; xx += 1)
-        {
-           fbg_pixela_fast(fbg, pix_pointer, r,g,b,a);
-           //fbg_pixela(fbg, x + xx, y + yy, r,g,b,a);
-           pix_pointer += 4;
-        }
-
-        pix_pointer += (fbg->line_length - w4);
+        render_kernels_blend_color_span(pix_pointer, w, color, a);
+        pix_pointer += fbg->line_length;
     }
 }
 
@@ -948,6 +932,17 @@ void fbg_rect(struct _fbg *fbg, int x, int y, int w, int h, unsigned char r, uns
 
     unsigned char *pix_pointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
 
+    if ( 4 == fbg->components )
+    {
+        unsigned char color[4] = { r, g, b, a };
+        for (yy = 0; yy < h; yy += 1)
+        {
+            render_kernels_fill_span(pix_pointer, w, color);
+            pix_pointer += fbg->line_length;
+        }
+        return;
+    }
+
     for (yy = 0; yy < h; yy += 1) {
         for (xx = 0; xx < w; xx += 1) {
             *pix_pointer++ = r;
@@ -1607,93 +1602,21 @@ void fbg_imageClipAColor(struct _fbg *fbg, struct _fbg_img *img, int x, int y, i
 {
     unsigned char *pDestPointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
     unsigned char *pSrcPointer = (unsigned char *)(img->data + (cy * img->width * fbg->components + cx * fbg->components));
+    const unsigned char *pMix = (const unsigned char*)&fbg->mix_color;
 
     int i = 0;
-    //int w4 = _FBG_MIN(cw * fbg->components, (fbg->width - x) * fbg->components);
     int h = ch;
 
-    char r,g,b,a;
-
-    if ( ! fbg->s_iEnableRectBlending )
-    {
-       for (i = 0; i < h; i += 1) 
-       {
-          for (int j=0; j<cw; j++ )
-          {
-            if ( *(pSrcPointer+3) < 120 )
-            {
-               pDestPointer += 4;
-               pSrcPointer += 4;
-               continue;
-            }
-            r = *pSrcPointer;
-            g = *(pSrcPointer+1);
-            b = *(pSrcPointer+2);
-            a = *(pSrcPointer+3);
-            r = (r*fbg->mix_color.r)>>8;
-            g = (g*fbg->mix_color.g)>>8;
-            b = (b*fbg->mix_color.b)>>8;
-            a = (a*fbg->mix_color.a)>>8;
-            //fbg_pixela_fast(fbg, pDestPointer, r,g,b,a);
-            *pDestPointer++ = r;
-            *pDestPointer++ = g;
-            *pDestPointer++ = b;
-            *pDestPointer++ = a;
-            pSrcPointer += 4;
-          }
-          pDestPointer += fbg->line_length - cw*4;
-          pSrcPointer += img->width * fbg->components - cw*4;
-       }
-    }
-    else if ( fbg->disableFontOutline )
-    {
-       for (i = 0; i < h; i += 1) 
-       {
-          for (int j=0; j<cw; j++ )
-          {
-            if ( (*(pSrcPointer)) + (*(pSrcPointer+1)) + (*(pSrcPointer+2)) < 120 )
-            {
-               pDestPointer += 4;
-               pSrcPointer += 4;
-               continue;
-            }
-            r = *pSrcPointer;
-            g = *(pSrcPointer+1);
-            b = *(pSrcPointer+2);
-            a = *(pSrcPointer+3);
-            r = (r*fbg->mix_color.r)>>8;
-            g = (g*fbg->mix_color.g)>>8;
-            b = (b*fbg->mix_color.b)>>8;
-            a = (a*fbg->mix_color.a)>>8;
-            fbg_pixela_fast(fbg, pDestPointer, r,g,b,a);
-            pDestPointer += 4;
-            pSrcPointer += 4;
-          }
-          pDestPointer += fbg->line_length - cw*4;
-          pSrcPointer += img->width * fbg->components - cw*4;
-       }
-    }
-    else
+    for (i = 0; i < h; i += 1) 
     {
-       for (i = 0; i < h; i += 1) 
-       {
-          for (int j=0; j<cw; j++ )
-          {
-            r = *pSrcPointer;
-            g = *(pSrcPointer+1);
-            b = *(pSrcPointer+2);
-            a = *(pSrcPointer+3);
-            r = (r*fbg->mix_color.r)>>8;
-            g = (g*fbg->mix_color.g)>>8;
-            b = (b*fbg->mix_color.b)>>8;
-            a = (a*fbg->mix_color.a)>>8;
-            fbg_pixela_fast(fbg, pDestPointer, r,g,b,a);
-            pDestPointer += 4;
-            pSrcPointer += 4;
-          }
-          pDestPointer += fbg->line_length - cw*4;
-          pSrcPointer += img->width * fbg->components - cw*4;
-       }
+       // No blending: copy only the opaque enough pixels.
+       // Blending without font outline: skip the dark (outline) pixels.
+       if ( ! fbg->s_iEnableRectBlending )
+          render_kernels_copy_src_mix_span(pDestPointer, pSrcPointer, cw, pMix, 120);
+       else
+          render_kernels_blend_src_mix_span(pDestPointer, pSrcPointer, cw, pMix, fbg->disableFontOutline);
+       pDestPointer += fbg->line_length;
+       pSrcPointer += img->width * fbg->components;
     }
 }
 
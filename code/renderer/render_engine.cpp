@@ -126,11 +126,17 @@ RenderEngine::RenderEngine()
 
    m_CurrentRawFontId = 0;
    m_iCountRawFonts = 0;
+
+   m_pTextRunCache = NULL;
+   m_fTextRunCachePixelWidth = 0.0;
 }
 
 
 RenderEngine::~RenderEngine()
 {
+   if ( NULL != m_pTextRunCache )
+      free(m_pTextRunCache);
+   m_pTextRunCache = NULL;
 }
 
 bool RenderEngine::initEngine()
@@ -698,6 +704,20 @@ bool RenderEngine::isFrameStarted()
    return m_bStartedFrame;
 }
 
+bool RenderEngine::startRetainedElement(u32 uElementId, float xPos, float yPos, float fWidth, float fHeight, u32 uContentHash)
+{
+   return true;
+}
+
+void RenderEngine::endRetainedElement()
+{
+}
+
+u32 RenderEngine::getLastFrameDirtyAreaPercent()
+{
+   return 100;
+}
+
 
 void RenderEngine::rotate180()
 {
@@ -770,23 +790,155 @@ float RenderEngine::textRawWidth(u32 fontId, const char* szText)
 
 float RenderEngine::textRawWidthScaled(u32 fontId, float fScale, const char* szText)
 {
-   if ( NULL == szText )
-      return 0.0;
-
-   RenderEngineRawFont* pFont = _getRawFontFromId(fontId);
-   if ( NULL == pFont )
+   type_render_text_run* pRun = _getTextRun(fontId, fScale, szText);
+   if ( NULL == pRun )
       return 0.0;
+   return pRun->fValue;
+}
 
+// Measures the text and stores the glyphs to draw (index in the font chars and advance width)
+bool RenderEngine::_measureTextRun(RenderEngineRawFont* pFont, float fScale, const char* szText, type_render_text_run* pRun)
+{
    float fWidth = 0.0;
    char* p = (char*)szText;
+   pRun->iGlyphCount = 0;
 
    while ( (*p) != 0 )
    {
-      fWidth += _get_raw_char_width(pFont, (*p));
+      float fWidthCh = _get_raw_char_width(pFont, (*p));
+      fWidth += fWidthCh;
+      if ( (pRun->iGlyphCount >= 0) && (fWidthCh >= 0.0001) && ((*p) >= pFont->charIdFirst) && ((*p) <= pFont->charIdLast) )
+      {
+         if ( pRun->iGlyphCount < MAX_TEXT_RUN_GLYPHS )
+         {
+            pRun->uGlyphs[pRun->iGlyphCount] = (u32)((*p) - pFont->charIdFirst);
+            pRun->fGlyphsX[pRun->iGlyphCount] = fWidthCh;
+            pRun->iGlyphCount++;
+         }
+         else
+            pRun->iGlyphCount = -1;
+      }
+      p++;
+   }
+
+   pRun->fValue = fWidth * fScale;
+   return true;
+}
+
+type_render_text_run* RenderEngine::_getTextRun(u32 uFontId, float fScale, const char* szText)
+{
+   if ( NULL == szText )
+      return NULL;
+
+   type_render_text_run* pRun = _textRunFind(TEXT_RUN_TYPE_WIDTH, uFontId, fScale, 0.0, szText);
+   if ( NULL != pRun )
+      return pRun;
+
+   RenderEngineRawFont* pFont = _getRawFontFromId(uFontId);
+   if ( NULL == pFont )
+      return NULL;
+
+   pRun = _textRunAdd(TEXT_RUN_TYPE_WIDTH, uFontId, fScale, 0.0, szText, 0.0);
+   if ( NULL == pRun )
+      return NULL;
+   if ( ! _measureTextRun(pFont, fScale, szText, pRun) )
+   {
+      pRun->uType = TEXT_RUN_TYPE_NONE;
+      return NULL;
+   }
+   return pRun;
+}
+
+static void _text_run_hash(const char* szText, int* piLength, u32* puHash1, u32* puHash2)
+{
+   // FNV-1a and djb2 together, so that collisions are not an issue for a small cache
+   u32 uHash1 = 2166136261u;
+   u32 uHash2 = 5381;
+   const unsigned char* p = (const unsigned char*)szText;
+   while ( *p )
+   {
+      uHash1 = (uHash1 ^ (*p)) * 16777619u;
+      uHash2 = uHash2 * 33 + (*p);
       p++;
    }
+   *piLength = (int)(p - (const unsigned char*)szText);
+   *puHash1 = uHash1;
+   *puHash2 = uHash2;
+}
 
-   return fWidth * fScale;
+static int _text_run_cache_index(u32 uType, u32 uFontId, float fParam1, float fParam2, u32 uHash1)
+{
+   u32 uParam1, uParam2;
+   memcpy(&uParam1, &fParam1, sizeof(u32));
+   memcpy(&uParam2, &fParam2, sizeof(u32));
+   u32 uIndex = uHash1 ^ (uType * 0x9E3779B1u) ^ (uFontId * 0x85EBCA6Bu) ^ (uParam1 * 0xC2B2AE35u) ^ uParam2;
+   uIndex ^= uIndex >> 16;
+   return (int)(uIndex % MAX_TEXT_RUN_CACHE);
+}
+
+type_render_text_run* RenderEngine::_textRunFind(u32 uType, u32 uFontId, float fParam1, float fParam2, const char* szText)
+{
+   if ( (NULL == m_pTextRunCache) || (NULL == szText) )
+      return NULL;
+
+   // Cached sizes are in screen units
+   if ( m_fTextRunCachePixelWidth != m_fPixelWidth )
+   {
+      _textRunClearCache();
+      return NULL;
+   }
+
+   int iLength = 0;
+   u32 uHash1 = 0, uHash2 = 0;
+   _text_run_hash(szText, &iLength, &uHash1, &uHash2);
+
+   type_render_text_run* pRun = &m_pTextRunCache[_text_run_cache_index(uType, uFontId, fParam1, fParam2, uHash1)];
+   if ( (pRun->uType != uType) || (pRun->uFontId != uFontId) || (pRun->fParam1 != fParam1) || (pRun->fParam2 != fParam2) ||
+        (pRun->iLength != iLength) || (pRun->uHash1 != uHash1) || (pRun->uHash2 != uHash2) )
+      return NULL;
+   return pRun;
+}
+
+type_render_text_run* RenderEngine::_textRunAdd(u32 uType, u32 uFontId, float fParam1, float fParam2, const char* szText, float fValue)
+{
+   if ( NULL == szText )
+      return NULL;
+
+   if ( NULL == m_pTextRunCache )
+   {
+      m_pTextRunCache = (type_render_text_run*) malloc(MAX_TEXT_RUN_CACHE * sizeof(type_render_text_run));
+      if ( NULL == m_pTextRunCache )
+         return NULL;
+      _textRunClearCache();
+   }
+   if ( m_fTextRunCachePixelWidth != m_fPixelWidth )
+      _textRunClearCache();
+
+   int iLength = 0;
+   u32 uHash1 = 0, uHash2 = 0;
+   _text_run_hash(szText, &iLength, &uHash1, &uHash2);
+
+   type_render_text_run* pRun = &m_pTextRunCache[_text_run_cache_index(uType, uFontId, fParam1, fParam2, uHash1)];
+   pRun->uType = uType;
+   pRun->uFontId = uFontId;
+   pRun->fParam1 = fParam1;
+   pRun->fParam2 = fParam2;
+   pRun->iLength = iLength;
+   pRun->uHash1 = uHash1;
+   pRun->uHash2 = uHash2;
+   pRun->fValue = fValue;
+   pRun->iGlyphCount = -1;
+   return pRun;
+}
+
+void RenderEngine::_textRunClearCache()
+{
+   if ( NULL != m_pTextRunCache )
+   {
+      for( int i=0; i<MAX_TEXT_RUN_CACHE; i++ )
+         m_pTextRunCache[i].uType = TEXT_RUN_TYPE_NONE;
+   }
+   m_fTextRunCachePixelWidth = m_fPixelWidth;
 }
 
 void RenderEngine::_drawSimpleTextBoundingBox(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos, float fScale)
@@ -925,6 +1077,10 @@ float RenderEngine::getMessageWidth(const char* text, float max_width, u32 fontI
    if ( NULL == pFont )
       return 0.0;
 
+   type_render_text_run* pRun = _textRunFind(TEXT_RUN_TYPE_MESSAGE_WIDTH, fontId, max_width, 0.0, text);
+   if ( NULL != pRun )
+      return pRun->fValue;
+
    float fMaxLineWidth = 0.0;
 
    char szText[256];
@@ -987,6 +1143,7 @@ float RenderEngine::getMessageWidth(const char* text, float max_width, u32 fontI
       }
    }
 
+   _textRunAdd(TEXT_RUN_TYPE_MESSAGE_WIDTH, fontId, max_width, 0.0, text, fMaxLineWidth);
    return fMaxLineWidth;
 }
 
@@ -1000,6 +1157,10 @@ float RenderEngine::getMessageHeight(const char* text, float line_spacing_percen
    if ( NULL == pFont )
       return 0.05;
 
+   type_render_text_run* pRun = _textRunFind(TEXT_RUN_TYPE_MESSAGE_HEIGHT, fontId, max_width, line_spacing_percent, text);
+   if ( NULL != pRun )
+      return pRun->fValue;
+
    float height = 0.0;
 
    char szText[256];
@@ -1071,6 +1232,7 @@ float RenderEngine::getMessageHeight(const char* text, float line_spacing_percen
       countLines++;
    }
 
+   _textRunAdd(TEXT_RUN_TYPE_MESSAGE_HEIGHT, fontId, max_width, line_spacing_percent, text, height);
    return height;
 }
 
@@ -42,6 +42,32 @@ typedef struct
 
 } RenderEngineRawFont;
 
+#define MAX_TEXT_RUN_CACHE 256
+#define MAX_TEXT_RUN_GLYPHS 64
+
+#define TEXT_RUN_TYPE_NONE 0
+#define TEXT_RUN_TYPE_WIDTH 1
+#define TEXT_RUN_TYPE_MESSAGE_WIDTH 2
+#define TEXT_RUN_TYPE_MESSAGE_HEIGHT 3
+
+// A measured text (or multiline message) for a font and scale/layout params.
+// Text runs also store the glyphs of the text as laid out by the engine, so that
+// drawing the same string again does not have to measure or shape it again.
+typedef struct
+{
+   u32 uType;
+   u32 uFontId;
+   float fParam1;
+   float fParam2;
+   int iLength;
+   u32 uHash1;
+   u32 uHash2;
+   float fValue;
+   int iGlyphCount; // -1 if the glyphs were not stored for this run
+   u32 uGlyphs[MAX_TEXT_RUN_GLYPHS];
+   float fGlyphsX[MAX_TEXT_RUN_GLYPHS];
+} type_render_text_run;
+
 
 class RenderEngine
 {
@@ -103,6 +129,13 @@ class RenderEngine
      virtual void endFrame();
      virtual bool isFrameStarted();
 
+     // Retained elements: returns false if the element does not have to be drawn again
+     // (it's unchanged and still present in the back buffer). If it returns true, the element
+     // must be drawn and then closed with endRetainedElement().
+     virtual bool startRetainedElement(u32 uElementId, float xPos, float yPos, float fWidth, float fHeight, u32 uContentHash);
+     virtual void endRetainedElement();
+     virtual u32 getLastFrameDirtyAreaPercent();
+
      virtual void rotate180();
 
      virtual void drawImage(float xPos, float yPos, float fWidth, float fHeight, u32 imageId);
@@ -154,6 +187,12 @@ class RenderEngine
       virtual void _drawSimpleText(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos);
       virtual void _drawSimpleTextScaled(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos, float fScale);
 
+      virtual bool _measureTextRun(RenderEngineRawFont* pFont, float fScale, const char* szText, type_render_text_run* pRun);
+      type_render_text_run* _getTextRun(u32 uFontId, float fScale, const char* szText);
+      type_render_text_run* _textRunFind(u32 uType, u32 uFontId, float fParam1, float fParam2, const char* szText);
+      type_render_text_run* _textRunAdd(u32 uType, u32 uFontId, float fParam1, float fParam2, const char* szText, float fValue);
+      void _textRunClearCache();
+
       bool m_bStartedFrame;
       int m_iRenderDepth;
       int m_iRenderWidth;
@@ -186,6 +225,9 @@ class RenderEngine
       u32 m_RawFontIds[MAX_RAW_FONTS];
       u32 m_CurrentRawFontId;
       int m_iCountRawFonts;
+
+      type_render_text_run* m_pTextRunCache;
+      float m_fTextRunCachePixelWidth;
 };
 
 
@@ -34,6 +34,7 @@
 #include "../base/config.h"
 #include "render_engine_cairo.h"
 #include "drm_core.h"
+#include "render_kernels.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -96,6 +97,52 @@ RenderEngineCairo::RenderEngineCairo()
    m_iCountIcons = 0;
    m_CurrentImageId = 0;
    m_CurrentIconId = 0;
+
+   m_iDamageWidth = m_iRenderWidth;
+   m_iDamageHeight = m_iRenderHeight;
+   if ( m_iDamageWidth > (int)pBackDisplayBuffer->uWidth )
+      m_iDamageWidth = pBackDisplayBuffer->uWidth;
+   if ( m_iDamageHeight > (int)pBackDisplayBuffer->uHeight )
+      m_iDamageHeight = pBackDisplayBuffer->uHeight;
+   m_iDamageTilesX = (m_iDamageWidth + RENDER_DAMAGE_TILE_SIZE - 1) / RENDER_DAMAGE_TILE_SIZE;
+   m_iDamageTilesY = (m_iDamageHeight + RENDER_DAMAGE_TILE_SIZE - 1) / RENDER_DAMAGE_TILE_SIZE;
+   m_iDamageTilesCount = m_iDamageTilesX * m_iDamageTilesY;
+   m_iDamageBufferIndex = 0;
+   m_pDamageTileState = NULL;
+   m_pDamageTileOwnerNow = NULL;
+   m_pDamageTileOwner[0] = NULL;
+   m_pDamageTileOwner[1] = NULL;
+   if ( m_iDamageTilesCount > 0 )
+   {
+      m_pDamageTileState = (u8*) malloc(m_iDamageTilesCount * sizeof(u8));
+      m_pDamageTileOwnerNow = (u32*) malloc(m_iDamageTilesCount * sizeof(u32));
+      m_pDamageTileOwner[0] = (u32*) malloc(m_iDamageTilesCount * sizeof(u32));
+      m_pDamageTileOwner[1] = (u32*) malloc(m_iDamageTilesCount * sizeof(u32));
+   }
+   if ( (NULL == m_pDamageTileState) || (NULL == m_pDamageTileOwnerNow) || (NULL == m_pDamageTileOwner[0]) || (NULL == m_pDamageTileOwner[1]) )
+   {
+      log_softerror_and_alarm("[RenderEngineCairo] Failed to allocate dirty tiles info. Will clear the full buffers on each frame.");
+      free(m_pDamageTileState);
+      free(m_pDamageTileOwnerNow);
+      free(m_pDamageTileOwner[0]);
+      free(m_pDamageTileOwner[1]);
+      m_pDamageTileState = NULL;
+      m_pDamageTileOwnerNow = NULL;
+      m_pDamageTileOwner[0] = NULL;
+      m_pDamageTileOwner[1] = NULL;
+   }
+   else
+      log_line("[RenderEngineCairo] Tracking dirty regions using %d x %d tiles of %d pixels.", m_iDamageTilesX, m_iDamageTilesY, RENDER_DAMAGE_TILE_SIZE);
+   m_bDamageMustFullClear[0] = true;
+   m_bDamageMustFullClear[1] = true;
+   m_uDamageClearByte[0] = m_uClearBufferByte;
+   m_uDamageClearByte[1] = m_uClearBufferByte;
+   m_iDamageDirtyTilesFrame = 0;
+   m_uLastFrameDirtyAreaPercent = 100;
+   m_iCountRetainedElements[0] = 0;
+   m_iCountRetainedElements[1] = 0;
+   m_iCountRetainedElementsNow = 0;
+   m_uCurrentRetainedElementId = 0;
    log_line("[RenderEngineCairo] Render init done.");
 }
 
@@ -113,10 +160,21 @@ RenderEngineCairo::~RenderEngineCairo()
 
    m_pMainCairoSurface[0] = NULL;
    m_pMainCairoSurface[1] = NULL;
+
+   free(m_pDamageTileState);
+   free(m_pDamageTileOwnerNow);
+   free(m_pDamageTileOwner[0]);
+   free(m_pDamageTileOwner[1]);
+   m_pDamageTileState = NULL;
+   m_pDamageTileOwnerNow = NULL;
+   m_pDamageTileOwner[0] = NULL;
+   m_pDamageTileOwner[1] = NULL;
 }
 
 void* RenderEngineCairo::getDrawContext()
 {
+   // Caller can draw anywhere using the context
+   _damageMarkPixels(0, 0, m_iDamageWidth, m_iDamageHeight);
    return m_pCairoCtx;
 }
 
@@ -140,7 +198,7 @@ void RenderEngineCairo::startFrame()
    
    type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
    
-   memset(pOutputBufferInfo->pData, m_uClearBufferByte, pOutputBufferInfo->uSize);
+   _damageStartFrame();
    
    if ( NULL != m_pCairoCtx )
       cairo_destroy(m_pCairoCtx);
@@ -174,6 +232,7 @@ void RenderEngineCairo::endFrame()
       cairo_destroy(m_pCairoTempCtx);
    m_pCairoTempCtx = NULL;
 
+   _damageEndFrame();
    ruby_drm_swap_mainback_buffers();
    RenderEngine::endFrame();
 }
@@ -228,6 +287,279 @@ cairo_t* RenderEngineCairo::_getActiveCairoContext()
    return m_pCairoTempCtx;
 }
 
+void RenderEngineCairo::_damageStartFrame()
+{
+   type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
+   m_iDamageBufferIndex = 0;
+   if ( pOutputBufferInfo->uBufferId == m_uRenderDrawSurfacesIds[1] )
+      m_iDamageBufferIndex = 1;
+
+   int iBuffer = m_iDamageBufferIndex;
+   m_iDamageDirtyTilesFrame = 0;
+   m_iCountRetainedElementsNow = 0;
+   m_uCurrentRetainedElementId = 0;
+
+   if ( (NULL == m_pDamageTileState) || m_bDamageMustFullClear[iBuffer] || (m_uDamageClearByte[iBuffer] != m_uClearBufferByte) )
+   {
+      memset(pOutputBufferInfo->pData, m_uClearBufferByte, pOutputBufferInfo->uSize);
+      m_bDamageMustFullClear[iBuffer] = false;
+      m_uDamageClearByte[iBuffer] = m_uClearBufferByte;
+      m_iCountRetainedElements[iBuffer] = 0;
+      m_iDamageDirtyTilesFrame = m_iDamageTilesCount;
+      if ( NULL == m_pDamageTileState )
+         return;
+      memset(m_pDamageTileOwner[iBuffer], 0, m_iDamageTilesCount * sizeof(u32));
+   }
+
+   // Tiles drawn in the previous use of this buffer must be cleared before being drawn again
+   for( int i=0; i<m_iDamageTilesCount; i++ )
+   {
+      m_pDamageTileOwnerNow[i] = RENDER_DAMAGE_OWNER_NONE;
+      if ( m_pDamageTileOwner[iBuffer][i] != RENDER_DAMAGE_OWNER_NONE )
+         m_pDamageTileState[i] = RENDER_DAMAGE_TILE_STALE;
+      else
+         m_pDamageTileState[i] = RENDER_DAMAGE_TILE_CLEAN;
+   }
+}
+
+void RenderEngineCairo::_damageEndFrame()
+{
+   if ( NULL == m_pDamageTileState )
+   {
+      m_uLastFrameDirtyAreaPercent = 100;
+      return;
+   }
+   endRetainedElement();
+
+   int iBuffer = m_iDamageBufferIndex;
+   for( int i=0; i<m_iDamageTilesCount; i++ )
+   {
+      if ( m_pDamageTileState[i] == RENDER_DAMAGE_TILE_STALE )
+      {
+         _damageClearTile(i);
+         m_iDamageDirtyTilesFrame++;
+         m_pDamageTileOwner[iBuffer][i] = RENDER_DAMAGE_OWNER_NONE;
+      }
+      else if ( m_pDamageTileState[i] == RENDER_DAMAGE_TILE_CLEAN )
+         m_pDamageTileOwner[iBuffer][i] = RENDER_DAMAGE_OWNER_NONE;
+      else
+         m_pDamageTileOwner[iBuffer][i] = m_pDamageTileOwnerNow[i];
+   }
+
+   memcpy(m_RetainedElements[iBuffer], m_RetainedElementsNow, m_iCountRetainedElementsNow * sizeof(type_render_retained_element));
+   m_iCountRetainedElements[iBuffer] = m_iCountRetainedElementsNow;
+   m_iCountRetainedElementsNow = 0;
+
+   m_uLastFrameDirtyAreaPercent = 100;
+   if ( m_iDamageTilesCount > 0 )
+      m_uLastFrameDirtyAreaPercent = (m_iDamageDirtyTilesFrame * 100 + m_iDamageTilesCount - 1) / m_iDamageTilesCount;
+}
+
+void RenderEngineCairo::_damageClearTile(int iTile)
+{
+   type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
+   int x = (iTile % m_iDamageTilesX) * RENDER_DAMAGE_TILE_SIZE;
+   int y = (iTile / m_iDamageTilesX) * RENDER_DAMAGE_TILE_SIZE;
+   int w = m_iDamageWidth - x;
+   int h = m_iDamageHeight - y;
+   if ( w > RENDER_DAMAGE_TILE_SIZE )
+      w = RENDER_DAMAGE_TILE_SIZE;
+   if ( h > RENDER_DAMAGE_TILE_SIZE )
+      h = RENDER_DAMAGE_TILE_SIZE;
+
+   u8* pDestLine = (u8*)&(pOutputBufferInfo->pData[y*pOutputBufferInfo->uStride + x*4]);
+   for( int i=0; i<h; i++ )
+   {
+      memset(pDestLine, m_uClearBufferByte, w*4);
+      pDestLine += pOutputBufferInfo->uStride;
+   }
+}
+
+void RenderEngineCairo::_damageTouchTile(int iTile)
+{
+   u8 uState = m_pDamageTileState[iTile];
+   if ( uState == RENDER_DAMAGE_TILE_STALE )
+      _damageClearTile(iTile);
+   if ( uState != RENDER_DAMAGE_TILE_DRAWN )
+   {
+      m_pDamageTileState[iTile] = RENDER_DAMAGE_TILE_DRAWN;
+      m_iDamageDirtyTilesFrame++;
+   }
+
+   u32 uOwner = m_pDamageTileOwnerNow[iTile];
+   if ( (0 != m_uCurrentRetainedElementId) && ((uOwner == RENDER_DAMAGE_OWNER_NONE) || (uOwner == m_uCurrentRetainedElementId)) )
+      m_pDamageTileOwnerNow[iTile] = m_uCurrentRetainedElementId;
+   else
+      m_pDamageTileOwnerNow[iTile] = RENDER_DAMAGE_OWNER_MIXED;
+}
+
+// Must be called before drawing anything in the given pixels area
+void RenderEngineCairo::_damageMarkPixels(int x, int y, int w, int h)
+{
+   if ( (NULL == m_pDamageTileState) || (! m_bStartedFrame) )
+      return;
+   if ( x < 0 )
+   {
+      w += x;
+      x = 0;
+   }
+   if ( y < 0 )
+   {
+      h += y;
+      y = 0;
+   }
+   if ( x + w > m_iDamageWidth )
+      w = m_iDamageWidth - x;
+   if ( y + h > m_iDamageHeight )
+      h = m_iDamageHeight - y;
+   if ( (w <= 0) || (h <= 0) )
+      return;
+
+   int iTileX0 = x / RENDER_DAMAGE_TILE_SIZE;
+   int iTileY0 = y / RENDER_DAMAGE_TILE_SIZE;
+   int iTileX1 = (x + w - 1) / RENDER_DAMAGE_TILE_SIZE;
+   int iTileY1 = (y + h - 1) / RENDER_DAMAGE_TILE_SIZE;
+
+   for( int ty=iTileY0; ty<=iTileY1; ty++ )
+   for( int tx=iTileX0; tx<=iTileX1; tx++ )
+      _damageTouchTile(ty*m_iDamageTilesX + tx);
+
+   if ( 0 != m_uCurrentRetainedElementId )
+   {
+      if ( iTileX0 < m_CurrentRetainedElement.iTileX0 )
+         m_CurrentRetainedElement.iTileX0 = iTileX0;
+      if ( iTileY0 < m_CurrentRetainedElement.iTileY0 )
+         m_CurrentRetainedElement.iTileY0 = iTileY0;
+      if ( iTileX1 > m_CurrentRetainedElement.iTileX1 )
+         m_CurrentRetainedElement.iTileX1 = iTileX1;
+      if ( iTileY1 > m_CurrentRetainedElement.iTileY1 )
+         m_CurrentRetainedElement.iTileY1 = iTileY1;
+   }
+}
+
+// Marks the bounding box of the given points (in screen coordinates), extended by a margin in pixels
+void RenderEngineCairo::_damageMarkPoints(float* x, float* y, int iCount, int iMarginPx)
+{
+   if ( (NULL == m_pDamageTileState) || (iCount < 1) )
+      return;
+   float xMin = x[0], xMax = x[0];
+   float yMin = y[0], yMax = y[0];
+   for( int i=1; i<iCount; i++ )
+   {
+      if ( x[i] < xMin ) xMin = x[i];
+      if ( x[i] > xMax ) xMax = x[i];
+      if ( y[i] < yMin ) yMin = y[i];
+      if ( y[i] > yMax ) yMax = y[i];
+   }
+   int x0 = (int)floorf(xMin * m_iRenderWidth) - iMarginPx;
+   int y0 = (int)floorf(yMin * m_iRenderHeight) - iMarginPx;
+   int x1 = (int)ceilf(xMax * m_iRenderWidth) + iMarginPx;
+   int y1 = (int)ceilf(yMax * m_iRenderHeight) + iMarginPx;
+   _damageMarkPixels(x0, y0, x1-x0+1, y1-y0+1);
+}
+
+type_render_retained_element* RenderEngineCairo::_damageFindElement(type_render_retained_element* pList, int iCount, u32 uElementId)
+{
+   for( int i=0; i<iCount; i++ )
+   {
+      if ( pList[i].uElementId == uElementId )
+         return &(pList[i]);
+   }
+   return NULL;
+}
+
+// An element can be reused if, in the previous use of this buffer, its tiles had only its pixels
+// and nothing was drawn over them yet in this frame
+bool RenderEngineCairo::_damageCanReuseElement(type_render_retained_element* pElement)
+{
+   u32* pOwners = m_pDamageTileOwner[m_iDamageBufferIndex];
+   for( int ty=pElement->iTileY0; ty<=pElement->iTileY1; ty++ )
+   for( int tx=pElement->iTileX0; tx<=pElement->iTileX1; tx++ )
+   {
+      int iTile = ty*m_iDamageTilesX + tx;
+      if ( (pOwners[iTile] == pElement->uElementId) && (m_pDamageTileState[iTile] == RENDER_DAMAGE_TILE_STALE) )
+         continue;
+      if ( (pOwners[iTile] == RENDER_DAMAGE_OWNER_NONE) && (m_pDamageTileState[iTile] == RENDER_DAMAGE_TILE_CLEAN) )
+         continue;
+      return false;
+   }
+   return true;
+}
+
+bool RenderEngineCairo::startRetainedElement(u32 uElementId, float xPos, float yPos, float fWidth, float fHeight, u32 uContentHash)
+{
+   if ( (NULL == m_pDamageTileState) || (! m_bStartedFrame) )
+      return true;
+   // Nested elements are drawn as part of the parent element
+   if ( 0 != m_uCurrentRetainedElementId )
+      return true;
+   if ( (RENDER_DAMAGE_OWNER_NONE == uElementId) || (RENDER_DAMAGE_OWNER_MIXED == uElementId) )
+      return true;
+   if ( m_iCountRetainedElementsNow >= RENDER_DAMAGE_MAX_RETAINED_ELEMENTS )
+      return true;
+   // Same element drawn twice in a frame: draw it as a regular (not retained) content
+   if ( NULL != _damageFindElement(m_RetainedElementsNow, m_iCountRetainedElementsNow, uElementId) )
+      return true;
+
+   // Current colors are part of the element content
+   uContentHash = uContentHash * 31 + ((((u32)m_ColorFill[0]) << 24) | (((u32)m_ColorFill[1]) << 16) | (((u32)m_ColorFill[2]) << 8) | m_ColorFill[3]);
+   uContentHash = uContentHash * 31 + ((((u32)m_ColorStroke[0]) << 24) | (((u32)m_ColorStroke[1]) << 16) | (((u32)m_ColorStroke[2]) << 8) | m_ColorStroke[3]);
+   uContentHash = uContentHash * 31 + ((((u32)m_ColorTextBoundingBoxBgFill[0]) << 24) | (((u32)m_ColorTextBoundingBoxBgFill[1]) << 16) | (((u32)m_ColorTextBoundingBoxBgFill[2]) << 8) | m_ColorTextBoundingBoxBgFill[3]);
+   uContentHash = uContentHash * 31 + (m_bDrawBackgroundBoundingBoxes?1:0) + (m_fStrokeSizePx > 0.9?2:0);
+
+   type_render_retained_element* pPrev = _damageFindElement(m_RetainedElements[m_iDamageBufferIndex], m_iCountRetainedElements[m_iDamageBufferIndex], uElementId);
+   if ( (NULL != pPrev) && (pPrev->uContentHash == uContentHash) )
+   if ( (pPrev->fRectX == xPos) && (pPrev->fRectY == yPos) && (pPrev->fRectWidth == fWidth) && (pPrev->fRectHeight == fHeight) )
+   if ( _damageCanReuseElement(pPrev) )
+   {
+      // Keep the element pixels from the previous use of this buffer
+      u32* pOwners = m_pDamageTileOwner[m_iDamageBufferIndex];
+      for( int ty=pPrev->iTileY0; ty<=pPrev->iTileY1; ty++ )
+      for( int tx=pPrev->iTileX0; tx<=pPrev->iTileX1; tx++ )
+      {
+         int iTile = ty*m_iDamageTilesX + tx;
+         if ( pOwners[iTile] != uElementId )
+            continue;
+         m_pDamageTileState[iTile] = RENDER_DAMAGE_TILE_RETAINED;
+         m_pDamageTileOwnerNow[iTile] = uElementId;
+      }
+      m_RetainedElementsNow[m_iCountRetainedElementsNow] = *pPrev;
+      m_iCountRetainedElementsNow++;
+      return false;
+   }
+
+   m_uCurrentRetainedElementId = uElementId;
+   m_CurrentRetainedElement.uElementId = uElementId;
+   m_CurrentRetainedElement.uContentHash = uContentHash;
+   m_CurrentRetainedElement.fRectX = xPos;
+   m_CurrentRetainedElement.fRectY = yPos;
+   m_CurrentRetainedElement.fRectWidth = fWidth;
+   m_CurrentRetainedElement.fRectHeight = fHeight;
+   m_CurrentRetainedElement.iTileX0 = m_iDamageTilesX;
+   m_CurrentRetainedElement.iTileY0 = m_iDamageTilesY;
+   m_CurrentRetainedElement.iTileX1 = -1;
+   m_CurrentRetainedElement.iTileY1 = -1;
+   return true;
+}
+
+void RenderEngineCairo::endRetainedElement()
+{
+   if ( 0 == m_uCurrentRetainedElementId )
+      return;
+   m_uCurrentRetainedElementId = 0;
+   if ( (m_CurrentRetainedElement.iTileX1 < 0) || (m_CurrentRetainedElement.iTileY1 < 0) )
+      return;
+   if ( m_iCountRetainedElementsNow >= RENDER_DAMAGE_MAX_RETAINED_ELEMENTS )
+      return;
+   m_RetainedElementsNow[m_iCountRetainedElementsNow] = m_CurrentRetainedElement;
+   m_iCountRetainedElementsNow++;
+}
+
+u32 RenderEngineCairo::getLastFrameDirtyAreaPercent()
+{
+   return m_uLastFrameDirtyAreaPercent;
+}
+
 void* RenderEngineCairo::_loadRawFontImageObject(const char* szFileName)
 {
    return NULL;
@@ -482,6 +814,9 @@ void RenderEngineCairo::drawImage(float xPos, float yPos, float fWidth, float fH
    if ( NULL == m_pImages[indexImage] )
       return;
   
+   // Image is painted over the full surface
+   _damageMarkPixels(0, 0, m_iDamageWidth, m_iDamageHeight);
+
    double scaleX = cairo_image_surface_get_width(m_pImages[indexImage]) / (float) m_iRenderWidth;
    double scaleY = cairo_image_surface_get_height(m_pImages[indexImage]) / (float) m_iRenderHeight;
    cairo_scale(m_pCairoCtx, 1.0/scaleX, 1.0/scaleY);
@@ -558,6 +893,8 @@ void RenderEngineCairo::bltImage(float xPosDest, float yPosDest, float fWidthDes
    if ( (xDest < 0) || (yDest < 0) || (xDest+wDest > m_iRenderWidth) || (yDest+hDest > m_iRenderHeight) )
       return;
 
+   _damageMarkPixels(xDest, yDest, wDest, hDest);
+
    type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
    u8* pSrcImageData = cairo_image_surface_get_data(m_pImages[indexImage]);
    int iSrcImageStride = cairo_image_surface_get_stride(m_pImages[indexImage]);
@@ -648,6 +985,8 @@ void RenderEngineCairo::bltSprite(float xPosDest, float yPosDest, int iSrcX, int
    if ( (xDest < 0) || (yDest < 0) || (xDest+iSrcWidth >= m_iRenderWidth) || (yDest+iSrcHeight >= m_iRenderHeight) )
       return;
 
+   _damageMarkPixels(xDest, yDest, iSrcWidth, iSrcHeight);
+
    type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
    u8* pSrcImageData = cairo_image_surface_get_data(m_pImages[indexImage]);
    int iSrcImageStride = cairo_image_surface_get_stride(m_pImages[indexImage]);
@@ -718,6 +1057,8 @@ void RenderEngineCairo::drawIcon(float xPos, float yPos, float fWidth, float fHe
    if ( (x < 0) || (y < 0) || (x+w >= m_iRenderWidth) || (y+h >= m_iRenderHeight) )
       return;
 
+   _damageMarkPixels(x, y, w, h);
+
    type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
    u8* pSrcImageData = cairo_image_surface_get_data(m_pIcons[indexIcon]);
    int iSrcImageStride = cairo_image_surface_get_stride(m_pIcons[indexIcon]);
@@ -810,6 +1151,8 @@ void RenderEngineCairo::bltIcon(float xPosDest, float yPosDest, int iSrcX, int i
    if ( (ixPosDest < 0) || (iyPosDest < 0) || (ixPosDest+iSrcWidth >= m_iRenderWidth) || (iyPosDest+iSrcHeight >= m_iRenderHeight) )
       return;
 
+   _damageMarkPixels(ixPosDest, iyPosDest, iSrcWidth, iSrcHeight);
+
    type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
    u8* pSrcImageData = cairo_image_surface_get_data(m_pIcons[indexIcon]);
    int iSrcImageStride = cairo_image_surface_get_stride(m_pIcons[indexIcon]);
@@ -822,21 +1165,7 @@ void RenderEngineCairo::bltIcon(float xPosDest, float yPosDest, int iSrcX, int i
       u8* pSrcLine = pSrcImageData + ((iSrcY +y)* iSrcImageStride);
       pSrcLine += 4 * iSrcX;
 
-      for( int x=0; x<iSrcWidth; x++ )
-      {
-          u8 uAlpha = *(pSrcLine+3);
-          *pDestLine = ((*(pSrcLine)) * uAlpha + (*(pDestLine)) * (255-uAlpha))/256;
-          pDestLine++;
-          pSrcLine++;
-          *pDestLine = ((*(pSrcLine)) * uAlpha + (*(pDestLine)) * (255-uAlpha))/256;
-          pDestLine++;
-          pSrcLine++;
-          *pDestLine = ((*(pSrcLine)) * uAlpha + (*(pDestLine)) * (255-uAlpha))/256;
-          pDestLine++;
-          pSrcLine++;
-          pDestLine++;
-          pSrcLine++;
-      }
+      render_kernels_blend_src_span(pDestLine, pSrcLine, iSrcWidth);
    }
 }
 
@@ -882,13 +1211,8 @@ void RenderEngineCairo::_draw_hline(int x, int y, int w, unsigned char r, unsign
 {
    type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
    u8* pDestLine = (&(pOutputBufferInfo->pData[0])) + y*pOutputBufferInfo->uStride + 4*x;
-   for( int i=0; i<w; i++ )
-   {
-      *pDestLine++ = b;
-      *pDestLine++ = g;
-      *pDestLine++ = r;
-      *pDestLine++ = a;
-   }
+   u8 uColor[4] = { b, g, r, a };
+   render_kernels_fill_span(pDestLine, w, uColor);
 }
 
 void RenderEngineCairo::_draw_vline(int x, int y, int h, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
@@ -907,6 +1231,10 @@ void RenderEngineCairo::_draw_vline(int x, int y, int h, unsigned char r, unsign
       
 void RenderEngineCairo::drawLine(float x1, float y1, float x2, float y2)
 {
+   float xPoints[2] = { x1, x2 };
+   float yPoints[2] = { y1, y2 };
+   _damageMarkPoints(xPoints, yPoints, 2, 2);
+
    if ( fabs(y1-y2) < 0.0001 )
    {
       if ( x1 < 0 )
@@ -1002,6 +1330,9 @@ void RenderEngineCairo::drawRect(float xPos, float yPos, float fWidth, float fHe
    if ( (w <= 0) || (h <= 0) )
       return;
 
+   if ( (m_ColorFill[3] > 2) || ((m_ColorStroke[3] > 2) && (m_fStrokeSizePx > 0.00001)) )
+      _damageMarkPixels(xSt, ySt, w, h);
+
    /*
    if ( m_bEnableRectBlending )
    {
@@ -1030,19 +1361,12 @@ void RenderEngineCairo::drawRect(float xPos, float yPos, float fWidth, float fHe
    if ( m_ColorFill[3] > 2 )
    {
       type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
+      u8 uColor[4] = { b, g, r, a };
       for( int y=0; y<h; y++ )
       {
          u8* pDestLine = (u8*)&(pOutputBufferInfo->pData[(ySt+y)*pOutputBufferInfo->uStride]);
          pDestLine += 4*xSt;
-         for( int x=0; x<w; x++ )
-         {
-            //_blend_pixel(pDestLine, r,g,b,a);
-            //pDestLine += 4;
-            *pDestLine++ = b;
-            *pDestLine++ = g;
-            *pDestLine++ = r;
-            *pDestLine++ = a;
-         }
+         render_kernels_fill_span(pDestLine, w, uColor);
       }
    }
    if ( m_ColorStroke[3] > 2 )
@@ -1111,6 +1435,9 @@ void RenderEngineCairo::drawRoundRect(float xPos, float yPos, float fWidth, floa
    if ( (w < 6.0*m_fPixelWidth) || (h < 6.0*m_fPixelHeight) )
       return;
 
+   // Right and bottom edges are drawn at xSt+w and ySt+h
+   _damageMarkPixels(xSt, ySt, w+1, h+1);
+
    // Output surface format order is: BGRA
    if ( m_ColorFill[3] > 2 )
    {
@@ -1197,6 +1524,10 @@ void RenderEngineCairo::drawRoundRect(float xPos, float yPos, float fWidth, floa
 
 void RenderEngineCairo::drawTriangle(float x1, float y1, float x2, float y2, float x3, float y3)
 {
+   float xPoints[3] = { x1, x2, x3 };
+   float yPoints[3] = { y1, y2, y3 };
+   _damageMarkPoints(xPoints, yPoints, 3, 2);
+
    cairo_move_to (m_pCairoCtx, x1 * m_iRenderWidth, y1 * m_iRenderHeight); 
    cairo_line_to (m_pCairoCtx, x2 * m_iRenderWidth, y2 * m_iRenderHeight);
    cairo_line_to (m_pCairoCtx, x3 * m_iRenderWidth, y3 * m_iRenderHeight);
@@ -1207,6 +1538,10 @@ void RenderEngineCairo::drawTriangle(float x1, float y1, float x2, float y2, flo
 
 void RenderEngineCairo::fillTriangle(float x1, float y1, float x2, float y2, float x3, float y3)
 {
+   float xPoints[3] = { x1, x2, x3 };
+   float yPoints[3] = { y1, y2, y3 };
+   _damageMarkPoints(xPoints, yPoints, 3, 2);
+
    cairo_move_to (m_pCairoCtx, x1 * m_iRenderWidth, y1 * m_iRenderHeight); 
    cairo_line_to (m_pCairoCtx, x2 * m_iRenderWidth, y2 * m_iRenderHeight);
    cairo_line_to (m_pCairoCtx, x3 * m_iRenderWidth, y3 * m_iRenderHeight);
@@ -1243,8 +1578,9 @@ void RenderEngineCairo::drawPolyLine(float* x, float* y, int count)
 
 void RenderEngineCairo::fillPolygon(float* x, float* y, int count)
 {
-if ( count < 3 || count > 120 )
+   if ( count < 3 || count > 120 )
       return;
+   _damageMarkPoints(x, y, count, 2);
    float xIntersections[256];
    int countIntersections = 0;
    float yMin, yMax;
@@ -1329,6 +1665,9 @@ if ( count < 3 || count > 120 )
 
 void RenderEngineCairo::fillCircle(float x, float y, float r)
 {
+   int iRadiusPx = r * m_iRenderHeight + 2;
+   _damageMarkPixels(x * m_iRenderWidth - iRadiusPx, y * m_iRenderHeight - iRadiusPx, 2*iRadiusPx+1, 2*iRadiusPx+1);
+
    if ( m_ColorFill[3] > 2 )
    {
       cairo_set_source_rgba(m_pCairoCtx, m_ColorFill[0]/255.0, m_ColorFill[1]/255.0, m_ColorFill[2]/255.0, m_ColorFill[3]/255.0);
@@ -1350,6 +1689,9 @@ void RenderEngineCairo::fillCircle(float x, float y, float r)
 
 void RenderEngineCairo::drawCircle(float x, float y, float r)
 {
+   int iRadiusPx = r * m_iRenderHeight + 2;
+   _damageMarkPixels(x * m_iRenderWidth - iRadiusPx, y * m_iRenderHeight - iRadiusPx, 2*iRadiusPx+1, 2*iRadiusPx+1);
+
    if ( m_ColorStroke[3] > 2 )
    {
       cairo_set_source_rgba(m_pCairoCtx, m_ColorStroke[0]/255.0, m_ColorStroke[1]/255.0, m_ColorStroke[2]/255.0, m_ColorStroke[3]/255.0);
@@ -1440,11 +1782,13 @@ void RenderEngineCairo::_updateCurrentFontToUse(RenderEngineRawFont* pFont, bool
    //cairo_select_font_face(pCairoCtx, "Noto Sans SC", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
 }
 
-float RenderEngineCairo::textRawWidthScaled(u32 fontId, float fScale, const char* szText)
+// Measures the text using cairo shaping and stores the shaped glyphs (glyph index and x position in pixels)
+bool RenderEngineCairo::_measureTextRun(RenderEngineRawFont* pFont, float fScale, const char* szText, type_render_text_run* pRun)
 {
-   RenderEngineRawFont* pFont = _getRawFontFromId(fontId);
+   pRun->fValue = 0.0;
+   pRun->iGlyphCount = -1;
    if ( (NULL == pFont) || (NULL == szText) || (0 == szText[0]) )
-      return 0.0;
+      return true;
 
    cairo_t* pCairoCtx = _getActiveCairoContext();
    if ( NULL == pCairoCtx )
@@ -1476,7 +1820,7 @@ float RenderEngineCairo::textRawWidthScaled(u32 fontId, float fScale, const char
       if ( NULL != clusters )
          cairo_text_cluster_free(clusters);
       log_softerror_and_alarm("[RenderEngineCairo] Failed to get text width: (%s)", szTxt);
-      return 0.0;
+      return false;
    }
 
    if ( (0 == glyph_count) && (0 == cluster_count) )
@@ -1486,7 +1830,7 @@ float RenderEngineCairo::textRawWidthScaled(u32 fontId, float fScale, const char
       if ( NULL != clusters )
          cairo_text_cluster_free(clusters);
       log_softerror_and_alarm("[RenderEngineCairo] Failed to get text width glyphs: (%s)", szTxt);
-      return 0.0;
+      return false;
    }
 
    float fWidthPixelsGlyphs = 0.0;
@@ -1506,15 +1850,29 @@ float RenderEngineCairo::textRawWidthScaled(u32 fontId, float fScale, const char
      byte_index += cluster->num_bytes;
    }
 
+   // Horizontal runs only, relative to the text origin
+   if ( (glyph_count > 0) && (glyph_count <= MAX_TEXT_RUN_GLYPHS) )
+   {
+      pRun->iGlyphCount = glyph_count;
+      for( int i=0; i<glyph_count; i++ )
+      {
+         pRun->uGlyphs[i] = (u32)glyphs[i].index;
+         pRun->fGlyphsX[i] = glyphs[i].x;
+         if ( fabs(glyphs[i].y) > 0.0001 )
+            pRun->iGlyphCount = -1;
+      }
+   }
+
    if ( NULL != glyphs )
       cairo_glyph_free(glyphs);
    if ( NULL != clusters )
       cairo_text_cluster_free(clusters);
  
    if ( fWidthPixelsGlyphs <= 1.0 )
-      return 0.0;
+      return true;
 
-   return fWidthPixelsGlyphs * m_fPixelWidth * fScale;
+   pRun->fValue = fWidthPixelsGlyphs * m_fPixelWidth * fScale;
+   return true;
    
    /*
    char* szParse = szTxt;
@@ -1633,6 +1991,12 @@ void RenderEngineCairo::_drawSimpleTextScaled(RenderEngineRawFont* pFont, const
       log_softerror_and_alarm("[RenderEngineCairo] Tried to draw an invalid text (%s)", szTxt);
       return;
    }
+
+   // Text is rendered using the unscaled font size; add a margin for glyphs overhang
+   if ( fScale < 0.999 )
+      fRenderWidth = textRawWidthScaled(uFontId, 1.0, szTxt);
+   int iTextMargin = pFont->lineHeight/4 + 2;
+   _damageMarkPixels(xPos * m_iRenderWidth - iTextMargin, yPos * m_iRenderHeight - iTextMargin, fRenderWidth * m_iRenderWidth + 2*iTextMargin, pFont->lineHeight + 2*iTextMargin);
    if ( m_bDrawBackgroundBoundingBoxes )
       _drawSimpleTextBoundingBox(pFont, szTxt, xPos, yPos, 1.0);
 
@@ -1662,7 +2026,24 @@ void RenderEngineCairo::_drawSimpleTextScaled(RenderEngineRawFont* pFont, const
       iPixels = 6;
 
    cairo_set_font_size(m_pCairoCtx, iPixels);
-   cairo_show_text(m_pCairoCtx, szTxt);
+
+   // Draw the already shaped glyphs of the unscaled font size if we have them
+   type_render_text_run* pRun = _getTextRun(uFontId, 1.0, szTxt);
+   if ( (NULL != pRun) && (pRun->iGlyphCount > 0) )
+   {
+      cairo_glyph_t glyphs[MAX_TEXT_RUN_GLYPHS];
+      double xOrigin = xPos * m_iRenderWidth;
+      double yOrigin = yPos * m_iRenderHeight + pFont->baseLine;
+      for( int i=0; i<pRun->iGlyphCount; i++ )
+      {
+         glyphs[i].index = pRun->uGlyphs[i];
+         glyphs[i].x = xOrigin + pRun->fGlyphsX[i];
+         glyphs[i].y = yOrigin;
+      }
+      cairo_show_glyphs(m_pCairoCtx, glyphs, pRun->iGlyphCount);
+   }
+   else
+      cairo_show_text(m_pCairoCtx, szTxt);
 }
 
 void RenderEngineCairo::_bltFontChar(int iDestX, int iDestY, int iSrcX, int iSrcY, int iSrcWidth, int iSrcHeight, RenderEngineRawFont* pFont)
@@ -1672,6 +2053,8 @@ void RenderEngineCairo::_bltFontChar(int iDestX, int iDestY, int iSrcX, int iSrc
    if ( (iDestX < 0) || (iDestY < 0) || (iDestX+iSrcWidth >= m_iRenderWidth) || (iDestY+iSrcHeight >= m_iRenderHeight) )
       return;
 
+   _damageMarkPixels(iDestX, iDestY, iSrcWidth, iSrcHeight);
+
    type_drm_buffer* pOutputBufferInfo = ruby_drm_core_get_back_draw_buffer();
    u8* pSrcImageData = cairo_image_surface_get_data((cairo_surface_t*)pFont->pImageObject);
    int iSrcImageStride = cairo_image_surface_get_stride((cairo_surface_t*)pFont->pImageObject);
@@ -1684,20 +2067,6 @@ void RenderEngineCairo::_bltFontChar(int iDestX, int iDestY, int iSrcX, int iSrc
       u8* pSrcLine = pSrcImageData + ((iSrcY +y)* iSrcImageStride);
       pSrcLine += 4 * iSrcX;
 
-      for( int x=0; x<iSrcWidth; x++ )
-      {
-          u8 uAlpha = *(pSrcLine+3);
-          *pDestLine = ((*(pSrcLine)) * uAlpha + (*(pDestLine)) * (255-uAlpha))/256;
-          pDestLine++;
-          pSrcLine++;
-          *pDestLine = ((*(pSrcLine)) * uAlpha + (*(pDestLine)) * (255-uAlpha))/256;
-          pDestLine++;
-          pSrcLine++;
-          *pDestLine = ((*(pSrcLine)) * uAlpha + (*(pDestLine)) * (255-uAlpha))/256;
-          pDestLine++;
-          pSrcLine++;
-          pDestLine++;
-          pSrcLine++;
-      }
+      render_kernels_blend_src_span(pDestLine, pSrcLine, iSrcWidth);
    }
 }
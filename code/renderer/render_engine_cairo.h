@@ -3,6 +3,27 @@
 #include "render_engine.h"
 #include <cairo.h>
 
+// The back buffers are not fully cleared each frame. The screen is split in tiles and only the tiles
+// drawn in the previous use of a buffer are cleared, lazily, right before something is drawn over them
+// or at the end of the frame.
+#define RENDER_DAMAGE_TILE_SIZE 16
+#define RENDER_DAMAGE_MAX_RETAINED_ELEMENTS 128
+#define RENDER_DAMAGE_OWNER_NONE 0
+#define RENDER_DAMAGE_OWNER_MIXED 0xFFFFFFFF
+
+#define RENDER_DAMAGE_TILE_CLEAN 0
+#define RENDER_DAMAGE_TILE_STALE 1
+#define RENDER_DAMAGE_TILE_DRAWN 2
+#define RENDER_DAMAGE_TILE_RETAINED 3
+
+typedef struct
+{
+   u32 uElementId;
+   u32 uContentHash;
+   float fRectX, fRectY, fRectWidth, fRectHeight; // Declared bounding box, any change forces a redraw
+   int iTileX0, iTileY0, iTileX1, iTileY1; // Tiles actually drawn by the element, inclusive
+} type_render_retained_element;
+
 class RenderEngineCairo: public RenderEngine
 {
    public:
@@ -26,6 +47,10 @@ class RenderEngineCairo: public RenderEngine
      virtual void endFrame();
      virtual void rotate180();
 
+     virtual bool startRetainedElement(u32 uElementId, float xPos, float yPos, float fWidth, float fHeight, u32 uContentHash);
+     virtual void endRetainedElement();
+     virtual u32 getLastFrameDirtyAreaPercent();
+
      virtual void drawImage(float xPos, float yPos, float fWidth, float fHeight, u32 uImageId);
      virtual void drawImageAlpha(float xPos, float yPos, float fWidth, float fHeight, u32 uImageId, u8 uAlpha);
      virtual void bltImage(float xPosDest, float yPosDest, float fWidthDest, float fHeightDest, int iSrcX, int iSrcY, int iSrcWidth, int iSrcHeight, u32 uImageId);
@@ -33,7 +58,6 @@ class RenderEngineCairo: public RenderEngine
      virtual void drawIcon(float xPos, float yPos, float fWidth, float fHeight, u32 uIconId);
      virtual void bltIcon(float xPosDest, float yPosDest, int iSrcX, int iSrcY, int iSrcWidth, int iSrcHeight, u32 uIconId);
 
-     virtual float textRawWidthScaled(u32 fontId, float fScale, const char* szText);
 
      virtual void drawLine(float x1, float y1, float x2, float y2);
      virtual void drawRect(float xPos, float yPos, float fWidth, float fHeight);
@@ -55,12 +79,22 @@ class RenderEngineCairo: public RenderEngine
 
       void _updateCurrentFontToUse(RenderEngineRawFont* pFont, bool bForce);
       //virtual float _get_raw_char_width(RenderEngineRawFont* pFont, int ch);
+      virtual bool _measureTextRun(RenderEngineRawFont* pFont, float fScale, const char* szText, type_render_text_run* pRun);
       virtual void _drawSimpleText(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos);
       virtual void _drawSimpleTextScaled(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos, float fScale);
       void _bltFontChar(int iDestX, int iDestY, int iSrcX, int iSrcY, int iSrcWidth, int iSrcHeight, RenderEngineRawFont* pFont);
       void _blend_pixel(unsigned char* pixel, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
       void _draw_hline(int x, int y, int w, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
       void _draw_vline(int x, int y, int h, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+
+      void _damageStartFrame();
+      void _damageEndFrame();
+      void _damageClearTile(int iTile);
+      void _damageTouchTile(int iTile);
+      void _damageMarkPixels(int x, int y, int w, int h);
+      void _damageMarkPoints(float* x, float* y, int iCount, int iMarginPx);
+      type_render_retained_element* _damageFindElement(type_render_retained_element* pList, int iCount, u32 uElementId);
+      bool _damageCanReuseElement(type_render_retained_element* pElement);
       
       bool m_bUseDoubleBuffering;
       u32 m_uRenderDrawSurfacesIds[2];
@@ -81,5 +115,26 @@ class RenderEngineCairo: public RenderEngine
       u32 m_CurrentIconId;
       int m_iCountIcons;
 
+      int m_iDamageWidth;
+      int m_iDamageHeight;
+      int m_iDamageTilesX;
+      int m_iDamageTilesY;
+      int m_iDamageTilesCount;
+      int m_iDamageBufferIndex;
+      u8* m_pDamageTileState; // State of each tile in the current frame
+      u32* m_pDamageTileOwnerNow; // What was drawn in each tile in the current frame
+      u32* m_pDamageTileOwner[2]; // What is present in each tile of each buffer
+      bool m_bDamageMustFullClear[2];
+      u8 m_uDamageClearByte[2];
+      int m_iDamageDirtyTilesFrame;
+      u32 m_uLastFrameDirtyAreaPercent;
+
+      type_render_retained_element m_RetainedElements[2][RENDER_DAMAGE_MAX_RETAINED_ELEMENTS];
+      int m_iCountRetainedElements[2];
+      type_render_retained_element m_RetainedElementsNow[RENDER_DAMAGE_MAX_RETAINED_ELEMENTS];
+      int m_iCountRetainedElementsNow;
+      type_render_retained_element m_CurrentRetainedElement;
+      u32 m_uCurrentRetainedElementId;
+
 
 };
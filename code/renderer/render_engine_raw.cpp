@@ -53,6 +53,10 @@ RenderEngineRaw::RenderEngineRaw()
    m_CurrentImageId = 1;
    m_CurrentIconId = 1;
 
+   for( int i=0; i<MAX_SCALED_FONT_ATLASES; i++ )
+      m_pScaledFontAtlases[i] = NULL;
+   m_iNextScaledFontAtlas = 0;
+
    log_line("RendererRAW: Render init done.");
 }
 
@@ -60,6 +64,7 @@ RenderEngineRaw::RenderEngineRaw()
 RenderEngineRaw::~RenderEngineRaw()
 {
    log_line("Free graphics engine resources.");
+   _freeScaledFontAtlases(0);
    if ( NULL != m_pFBG )
    {
       log_line("Free graphics engine instance.");
@@ -81,6 +86,12 @@ void RenderEngineRaw::_freeRawFontImageObject(void* pImageObject)
 }
 
 
+void RenderEngineRaw::freeRawFont(u32 idFont)
+{
+   _freeScaledFontAtlases(idFont);
+   RenderEngine::freeRawFont(idFont);
+}
+
 void RenderEngineRaw::setFontOutlineColor(u32 idFont, u8 r, u8 g, u8 b, u8 a)
 {
    int indexFont = _getRawFontIndexFromId(idFont);
@@ -92,6 +103,9 @@ void RenderEngineRaw::setFontOutlineColor(u32 idFont, u8 r, u8 g, u8 b, u8 a)
 
    if ( (r<30) && (g<30) && (b<30) )
       return;
+
+   // Scaled glyphs must be resampled from the updated font image
+   _freeScaledFontAtlases(idFont);
    RenderEngineRawFont* pFont = m_pRawFonts[indexFont];
    struct _fbg_img* pImg = (struct _fbg_img*) pFont->pImageObject;
    unsigned char *img_data_pointer_row = (unsigned char *)(pImg->data);
@@ -291,6 +305,119 @@ void RenderEngineRaw::changeImageHue(u32 uImageId, u8 r, u8 g, u8 b)
    fbg_imageChangeHue(m_pFBG, m_pImages[indexImage], r, g, b);
 }
 
+// uFontId 0: frees all the scaled atlases
+void RenderEngineRaw::_freeScaledFontAtlases(u32 uFontId)
+{
+   for( int i=0; i<MAX_SCALED_FONT_ATLASES; i++ )
+   {
+      if ( NULL == m_pScaledFontAtlases[i] )
+         continue;
+      if ( (0 != uFontId) && (m_pScaledFontAtlases[i]->uFontId != uFontId) )
+         continue;
+      if ( NULL != m_pScaledFontAtlases[i]->pImage )
+         fbg_freeImage(m_pScaledFontAtlases[i]->pImage);
+      free(m_pScaledFontAtlases[i]);
+      m_pScaledFontAtlases[i] = NULL;
+   }
+}
+
+// Resamples each glyph once, the same way fbg_imageDrawAlpha does it when drawing scaled text
+type_raw_scaled_font_atlas* RenderEngineRaw::_getScaledFontAtlas(RenderEngineRawFont* pFont, float fScale)
+{
+   if ( (NULL == pFont) || (NULL == pFont->pImageObject) )
+      return NULL;
+
+   u32 uFontId = _getRawFontId(pFont);
+   for( int i=0; i<MAX_SCALED_FONT_ATLASES; i++ )
+   {
+      if ( (NULL != m_pScaledFontAtlases[i]) && (m_pScaledFontAtlases[i]->uFontId == uFontId) && (m_pScaledFontAtlases[i]->fScale == fScale) )
+         return m_pScaledFontAtlases[i];
+   }
+
+   struct _fbg_img* pFontImage = (struct _fbg_img*) pFont->pImageObject;
+   int iCountChars = pFont->charIdLast - pFont->charIdFirst + 1;
+   if ( iCountChars > MAX_FONT_CHARS )
+      iCountChars = MAX_FONT_CHARS;
+   if ( iCountChars <= 0 )
+      return NULL;
+
+   type_raw_scaled_font_atlas* pAtlas = (type_raw_scaled_font_atlas*) malloc(sizeof(type_raw_scaled_font_atlas));
+   if ( NULL == pAtlas )
+      return NULL;
+   memset(pAtlas, 0, sizeof(type_raw_scaled_font_atlas));
+   pAtlas->uFontId = uFontId;
+   pAtlas->fScale = fScale;
+
+   int iAtlasWidth = 0;
+   int iAtlasHeight = 1;
+   for( int i=0; i<iCountChars; i++ )
+   {
+      pAtlas->iGlyphX[i] = iAtlasWidth;
+      pAtlas->iGlyphWidth[i] = pFont->chars[i].width * fScale;
+      pAtlas->iGlyphHeight[i] = pFont->chars[i].height * fScale;
+      if ( pAtlas->iGlyphWidth[i] < 0 )
+         pAtlas->iGlyphWidth[i] = 0;
+      if ( pAtlas->iGlyphHeight[i] < 0 )
+         pAtlas->iGlyphHeight[i] = 0;
+      iAtlasWidth += pAtlas->iGlyphWidth[i];
+      if ( pAtlas->iGlyphHeight[i] > iAtlasHeight )
+         iAtlasHeight = pAtlas->iGlyphHeight[i];
+   }
+   if ( iAtlasWidth <= 0 )
+      iAtlasWidth = 1;
+
+   pAtlas->pImage = fbg_createImage(m_pFBG, iAtlasWidth, iAtlasHeight);
+   if ( NULL == pAtlas->pImage )
+   {
+      free(pAtlas);
+      return NULL;
+   }
+   memset(pAtlas->pImage->data, 0, iAtlasWidth * iAtlasHeight * 4);
+
+   for( int i=0; i<iCountChars; i++ )
+   {
+      int w = pAtlas->iGlyphWidth[i];
+      int h = pAtlas->iGlyphHeight[i];
+      if ( (w <= 0) || (h <= 0) )
+         continue;
+      int cx = pFont->chars[i].imgXOffset;
+      int cy = pFont->chars[i].imgYOffset;
+      float dxImg = (float)pFont->chars[i].width/(float)w;
+      float dyImg = (float)pFont->chars[i].height/(float)h;
+      float yImg = cy;
+      int iRows = 0;
+      for( int sy=0; sy<h; sy++ )
+      {
+         int iyImg = (int)yImg;
+         if ( (iyImg >= cy + pFont->chars[i].height) || (iyImg >= (int)pFontImage->height) )
+            break;
+         u8* pDest = pAtlas->pImage->data + (sy * iAtlasWidth + pAtlas->iGlyphX[i]) * 4;
+         float xImg = cx;
+         for( int sx=0; sx<w; sx++ )
+         {
+            memcpy(pDest, pFontImage->data + (((int)xImg) + iyImg * pFontImage->width) * 4, 4);
+            pDest += 4;
+            xImg += dxImg;
+         }
+         yImg += dyImg;
+         iRows++;
+      }
+      pAtlas->iGlyphHeight[i] = iRows;
+   }
+
+   // Reuse the slots in round robin once all are used
+   int iSlot = m_iNextScaledFontAtlas;
+   m_iNextScaledFontAtlas = (m_iNextScaledFontAtlas + 1) % MAX_SCALED_FONT_ATLASES;
+   if ( NULL != m_pScaledFontAtlases[iSlot] )
+   {
+      fbg_freeImage(m_pScaledFontAtlases[iSlot]->pImage);
+      free(m_pScaledFontAtlases[iSlot]);
+   }
+   m_pScaledFontAtlases[iSlot] = pAtlas;
+   log_line("RendererRAW: Built scaled glyphs for font id %u, scale %.2f: %d x %d pixels", uFontId, fScale, iAtlasWidth, iAtlasHeight);
+   return pAtlas;
+}
+
 void RenderEngineRaw::_buildMipImage(struct _fbg_img* pSrc, struct _fbg_img* pDest)
 {
    pDest->width = pSrc->width/2;
@@ -605,6 +732,31 @@ void RenderEngineRaw::_drawSimpleText(RenderEngineRawFont* pFont, const char* sz
    }
 
    float xTmp = xPos;
+
+   // Use the already measured glyph run of the text if we have it
+   type_render_text_run* pRun = _getTextRun(_getRawFontId(pFont), 1.0, szText);
+   if ( (NULL != pRun) && (pRun->iGlyphCount >= 0) )
+   {
+      for( int i=0; i<pRun->iGlyphCount; i++ )
+      {
+         float fWidthCh = pRun->fGlyphsX[i];
+         if ( xTmp < 0 )
+         {
+            xTmp += fWidthCh;
+            continue;
+         }
+         if ( xTmp + fWidthCh >= 1.0 )
+            break;
+
+         RenderEngineRawFontChar* pChar = &(pFont->chars[pRun->uGlyphs[i]]);
+         if ( (int)pRun->uGlyphs[i] + pFont->charIdFirst != ' ' )
+            fbg_imageClipAColor(m_pFBG, (struct _fbg_img*) pFont->pImageObject, xTmp*m_iRenderWidth, yPos*m_iRenderHeight, pChar->imgXOffset, pChar->imgYOffset, pChar->width, pChar->height);
+         xTmp += fWidthCh;
+      }
+      m_pFBG->disableFontOutline = tmp;
+      return;
+   }
+
    while ( *szText )
    {
       float fWidthCh = _get_raw_char_width(pFont, *szText);
@@ -653,6 +805,13 @@ void RenderEngineRaw::_drawSimpleTextScaled(RenderEngineRawFont* pFont, const ch
    m_pFBG->mix_color.b = m_uTextFontMixColor[2];
    m_pFBG->mix_color.a = m_uTextFontMixColor[3];
 
+   // Scaled glyphs are blended (with no outline skipping), same as fbg_imageDrawAlpha does
+   type_raw_scaled_font_atlas* pAtlas = _getScaledFontAtlas(pFont, fScale);
+   int iTmpBlending = m_pFBG->s_iEnableRectBlending;
+   int iTmpOutline = m_pFBG->disableFontOutline;
+   m_pFBG->s_iEnableRectBlending = 1;
+   m_pFBG->disableFontOutline = 0;
+
    while ( *szText )
    {
       float fWidthCh = _get_raw_char_width(pFont, *szText);
@@ -670,17 +829,27 @@ void RenderEngineRaw::_drawSimpleTextScaled(RenderEngineRawFont* pFont, const ch
       if ( xPos + fWidthCh * fScale >= 1.0 )
          break;
 
-      int xImg = pFont->chars[(*szText)-pFont->charIdFirst].imgXOffset;
-      int yImg = pFont->chars[(*szText)-pFont->charIdFirst].imgYOffset;
-      int wImg = pFont->chars[(*szText)-pFont->charIdFirst].width;
-      int hImg = pFont->chars[(*szText)-pFont->charIdFirst].height;
-      //unsigned char *img_pointer = (unsigned char *)(pFont->pImage->data + (yImg * pFont->pImage->width * m_pFBG->components + xImg * m_pFBG->components));
-
-      fbg_imageDrawAlpha(m_pFBG, (struct _fbg_img*) pFont->pImageObject, xPos * m_iRenderWidth, yPos * m_iRenderHeight, wImg*fScale, hImg*fScale, xImg, yImg, wImg, hImg);
+      int iChar = (*szText)-pFont->charIdFirst;
+      if ( (NULL != pAtlas) && (iChar < MAX_FONT_CHARS) )
+      {
+         if ( (pAtlas->iGlyphWidth[iChar] > 0) && (pAtlas->iGlyphHeight[iChar] > 0) )
+            fbg_imageClipAColor(m_pFBG, pAtlas->pImage, xPos * m_iRenderWidth, yPos * m_iRenderHeight, pAtlas->iGlyphX[iChar], 0, pAtlas->iGlyphWidth[iChar], pAtlas->iGlyphHeight[iChar]);
+      }
+      else
+      {
+         int xImg = pFont->chars[iChar].imgXOffset;
+         int yImg = pFont->chars[iChar].imgYOffset;
+         int wImg = pFont->chars[iChar].width;
+         int hImg = pFont->chars[iChar].height;
+         fbg_imageDrawAlpha(m_pFBG, (struct _fbg_img*) pFont->pImageObject, xPos * m_iRenderWidth, yPos * m_iRenderHeight, wImg*fScale, hImg*fScale, xImg, yImg, wImg, hImg);
+      }
 
       xPos += fWidthCh;
       szText++;
    }
+
+   m_pFBG->s_iEnableRectBlending = iTmpBlending;
+   m_pFBG->disableFontOutline = iTmpOutline;
 }
 
 
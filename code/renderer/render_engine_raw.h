@@ -2,12 +2,26 @@
 
 #include "render_engine.h"
 
+#define MAX_SCALED_FONT_ATLASES 8
+
+// Glyphs of a font resampled once for a given text scale, laid out on a single row
+typedef struct
+{
+   u32 uFontId;
+   float fScale;
+   struct _fbg_img* pImage;
+   int iGlyphX[MAX_FONT_CHARS];
+   int iGlyphWidth[MAX_FONT_CHARS];
+   int iGlyphHeight[MAX_FONT_CHARS];
+} type_raw_scaled_font_atlas;
+
 class RenderEngineRaw: public RenderEngine
 {
    public:
      RenderEngineRaw();
      virtual ~RenderEngineRaw();
 
+     virtual void freeRawFont(u32 idFont);
      virtual void setFontOutlineColor(u32 idFont, u8 r, u8 g, u8 b, u8 a);
      virtual u32 loadImage(const char* szFile);
      virtual void freeImage(u32 idImage);
@@ -44,6 +58,8 @@ class RenderEngineRaw: public RenderEngine
       virtual void* _loadRawFontImageObject(const char* szFileName);
       virtual void _freeRawFontImageObject(void* pImageObject);
       void _buildMipImage(struct _fbg_img* pSrc, struct _fbg_img* pDest);
+      type_raw_scaled_font_atlas* _getScaledFontAtlas(RenderEngineRawFont* pFont, float fScale);
+      void _freeScaledFontAtlases(u32 uFontId);
 
       void _drawSimpleText(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos);
       void _drawSimpleTextScaled(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos, float fScale);
@@ -60,4 +76,7 @@ class RenderEngineRaw: public RenderEngine
       u32 m_IconIds[MAX_RAW_ICONS];
       u32 m_CurrentIconId;
       int m_iCountIcons;
+
+      type_raw_scaled_font_atlas* m_pScaledFontAtlases[MAX_SCALED_FONT_ATLASES];
+      int m_iNextScaledFontAtlas;
 };
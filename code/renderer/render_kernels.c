@@ -0,0 +1,445 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "render_kernels.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RENDER_KERNELS_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#define RENDER_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static int s_iRenderKernelsUseSIMD = 1;
+
+void render_kernels_enable_simd(int iEnable)
+{
+   s_iRenderKernelsUseSIMD = iEnable;
+}
+
+const char* render_kernels_get_simd_name()
+{
+   #if defined(RENDER_KERNELS_NEON)
+   return s_iRenderKernelsUseSIMD?"NEON":"scalar";
+   #elif defined(RENDER_KERNELS_SSE2)
+   return s_iRenderKernelsUseSIMD?"SSE2":"scalar";
+   #else
+   return "scalar";
+   #endif
+}
+
+//---------------------------------------------------
+// Scalar kernels, also used for the spans tails
+
+static void _fill_span_scalar(u8* pDest, int iCount, const u8* pColor)
+{
+   u32 uPixel;
+   memcpy(&uPixel, pColor, 4);
+   for( int i=0; i<iCount; i++ )
+   {
+      memcpy(pDest, &uPixel, 4);
+      pDest += 4;
+   }
+}
+
+static inline void _blend_pixel_scalar(u8* pDest, u8 r, u8 g, u8 b, u8 a)
+{
+   pDest[0] = (a * r + (255 - a) * pDest[0]) >> 8;
+   pDest[1] = (a * g + (255 - a) * pDest[1]) >> 8;
+   pDest[2] = (a * b + (255 - a) * pDest[2]) >> 8;
+   pDest[3] = pDest[3] + (((255 - pDest[3]) * a) >> 8);
+}
+
+static void _blend_color_span_scalar(u8* pDest, int iCount, const u8* pColor, u8 uAlpha)
+{
+   for( int i=0; i<iCount; i++ )
+   {
+      _blend_pixel_scalar(pDest, pColor[0], pColor[1], pColor[2], uAlpha);
+      pDest += 4;
+   }
+}
+
+static void _blend_src_mix_span_scalar(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, int iSkipDarkPixels)
+{
+   for( int i=0; i<iCount; i++ )
+   {
+      if ( (! iSkipDarkPixels) || (pSrc[0] + pSrc[1] + pSrc[2] >= 120) )
+         _blend_pixel_scalar(pDest, (pSrc[0]*pMix[0])>>8, (pSrc[1]*pMix[1])>>8, (pSrc[2]*pMix[2])>>8, (pSrc[3]*pMix[3])>>8);
+      pDest += 4;
+      pSrc += 4;
+   }
+}
+
+static void _copy_src_mix_span_scalar(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, u8 uMinAlpha)
+{
+   for( int i=0; i<iCount; i++ )
+   {
+      if ( pSrc[3] >= uMinAlpha )
+      {
+         pDest[0] = (pSrc[0]*pMix[0])>>8;
+         pDest[1] = (pSrc[1]*pMix[1])>>8;
+         pDest[2] = (pSrc[2]*pMix[2])>>8;
+         pDest[3] = (pSrc[3]*pMix[3])>>8;
+      }
+      pDest += 4;
+      pSrc += 4;
+   }
+}
+
+static void _blend_src_span_scalar(u8* pDest, const u8* pSrc, int iCount)
+{
+   for( int i=0; i<iCount; i++ )
+   {
+      u8 uAlpha = pSrc[3];
+      pDest[0] = (pSrc[0] * uAlpha + pDest[0] * (255-uAlpha)) >> 8;
+      pDest[1] = (pSrc[1] * uAlpha + pDest[1] * (255-uAlpha)) >> 8;
+      pDest[2] = (pSrc[2] * uAlpha + pDest[2] * (255-uAlpha)) >> 8;
+      pDest += 4;
+      pSrc += 4;
+   }
+}
+
+#if defined(RENDER_KERNELS_NEON)
+
+//---------------------------------------------------
+// NEON kernels: 16 pixels at a time, deinterleaved in 4 planes
+
+static inline uint8x16_t _neon_lerp(uint8x16_t uSrc, uint8x16_t uDest, uint8x16_t uAlpha, uint8x16_t uInvAlpha)
+{
+   // (a*s + (255-a)*d) >> 8
+   uint16x8_t uLow = vmlal_u8(vmull_u8(vget_low_u8(uSrc), vget_low_u8(uAlpha)), vget_low_u8(uDest), vget_low_u8(uInvAlpha));
+   uint16x8_t uHigh = vmlal_u8(vmull_u8(vget_high_u8(uSrc), vget_high_u8(uAlpha)), vget_high_u8(uDest), vget_high_u8(uInvAlpha));
+   return vcombine_u8(vshrn_n_u16(uLow, 8), vshrn_n_u16(uHigh, 8));
+}
+
+static inline uint8x16_t _neon_accumulate_alpha(uint8x16_t uDestAlpha, uint8x16_t uAlpha)
+{
+   // d + (((255-d)*a) >> 8)
+   uint8x16_t uInvDest = vmvnq_u8(uDestAlpha);
+   uint16x8_t uLow = vmull_u8(vget_low_u8(uInvDest), vget_low_u8(uAlpha));
+   uint16x8_t uHigh = vmull_u8(vget_high_u8(uInvDest), vget_high_u8(uAlpha));
+   return vaddq_u8(uDestAlpha, vcombine_u8(vshrn_n_u16(uLow, 8), vshrn_n_u16(uHigh, 8)));
+}
+
+static inline uint8x16_t _neon_modulate(uint8x16_t uSrc, uint8x16_t uMix)
+{
+   // (s*m) >> 8
+   uint16x8_t uLow = vmull_u8(vget_low_u8(uSrc), vget_low_u8(uMix));
+   uint16x8_t uHigh = vmull_u8(vget_high_u8(uSrc), vget_high_u8(uMix));
+   return vcombine_u8(vshrn_n_u16(uLow, 8), vshrn_n_u16(uHigh, 8));
+}
+
+static int _fill_span_simd(u8* pDest, int iCount, const u8* pColor)
+{
+   uint8x16x4_t uPixels;
+   for( int k=0; k<4; k++ )
+      uPixels.val[k] = vdupq_n_u8(pColor[k]);
+   int i = 0;
+   for( ; i + 16 <= iCount; i += 16 )
+      vst4q_u8(pDest + i*4, uPixels);
+   return i;
+}
+
+static int _blend_color_span_simd(u8* pDest, int iCount, const u8* pColor, u8 uAlpha)
+{
+   uint8x16_t uA = vdupq_n_u8(uAlpha);
+   uint8x16_t uInvA = vdupq_n_u8(255-uAlpha);
+   uint8x16_t uColor[3];
+   for( int k=0; k<3; k++ )
+      uColor[k] = vdupq_n_u8(pColor[k]);
+   int i = 0;
+   for( ; i + 16 <= iCount; i += 16 )
+   {
+      uint8x16x4_t uDest = vld4q_u8(pDest + i*4);
+      for( int k=0; k<3; k++ )
+         uDest.val[k] = _neon_lerp(uColor[k], uDest.val[k], uA, uInvA);
+      uDest.val[3] = _neon_accumulate_alpha(uDest.val[3], uA);
+      vst4q_u8(pDest + i*4, uDest);
+   }
+   return i;
+}
+
+static int _blend_src_mix_span_simd(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, int iSkipDarkPixels)
+{
+   uint8x16_t uMix[4];
+   for( int k=0; k<4; k++ )
+      uMix[k] = vdupq_n_u8(pMix[k]);
+   uint16x8_t uDarkLimit = vdupq_n_u16(120);
+   int i = 0;
+   for( ; i + 16 <= iCount; i += 16 )
+   {
+      uint8x16x4_t uSrcRaw = vld4q_u8(pSrc + i*4);
+      uint8x16x4_t uDest = vld4q_u8(pDest + i*4);
+      uint8x16x4_t uResult;
+      uint8x16_t uA = _neon_modulate(uSrcRaw.val[3], uMix[3]);
+      uint8x16_t uInvA = vmvnq_u8(uA);
+      for( int k=0; k<3; k++ )
+         uResult.val[k] = _neon_lerp(_neon_modulate(uSrcRaw.val[k], uMix[k]), uDest.val[k], uA, uInvA);
+      uResult.val[3] = _neon_accumulate_alpha(uDest.val[3], uA);
+      if ( iSkipDarkPixels )
+      {
+         uint16x8_t uSumLow = vaddw_u8(vaddl_u8(vget_low_u8(uSrcRaw.val[0]), vget_low_u8(uSrcRaw.val[1])), vget_low_u8(uSrcRaw.val[2]));
+         uint16x8_t uSumHigh = vaddw_u8(vaddl_u8(vget_high_u8(uSrcRaw.val[0]), vget_high_u8(uSrcRaw.val[1])), vget_high_u8(uSrcRaw.val[2]));
+         uint8x16_t uSkip = vcombine_u8(vmovn_u16(vcltq_u16(uSumLow, uDarkLimit)), vmovn_u16(vcltq_u16(uSumHigh, uDarkLimit)));
+         for( int k=0; k<4; k++ )
+            uResult.val[k] = vbslq_u8(uSkip, uDest.val[k], uResult.val[k]);
+      }
+      vst4q_u8(pDest + i*4, uResult);
+   }
+   return i;
+}
+
+static int _copy_src_mix_span_simd(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, u8 uMinAlpha)
+{
+   uint8x16_t uMix[4];
+   for( int k=0; k<4; k++ )
+      uMix[k] = vdupq_n_u8(pMix[k]);
+   uint8x16_t uMinA = vdupq_n_u8(uMinAlpha);
+   int i = 0;
+   for( ; i + 16 <= iCount; i += 16 )
+   {
+      uint8x16x4_t uSrcRaw = vld4q_u8(pSrc + i*4);
+      uint8x16x4_t uDest = vld4q_u8(pDest + i*4);
+      uint8x16_t uSkip = vcltq_u8(uSrcRaw.val[3], uMinA);
+      for( int k=0; k<4; k++ )
+         uDest.val[k] = vbslq_u8(uSkip, uDest.val[k], _neon_modulate(uSrcRaw.val[k], uMix[k]));
+      vst4q_u8(pDest + i*4, uDest);
+   }
+   return i;
+}
+
+static int _blend_src_span_simd(u8* pDest, const u8* pSrc, int iCount)
+{
+   int i = 0;
+   for( ; i + 16 <= iCount; i += 16 )
+   {
+      uint8x16x4_t uSrc = vld4q_u8(pSrc + i*4);
+      uint8x16x4_t uDest = vld4q_u8(pDest + i*4);
+      uint8x16_t uInvA = vmvnq_u8(uSrc.val[3]);
+      for( int k=0; k<3; k++ )
+         uDest.val[k] = _neon_lerp(uSrc.val[k], uDest.val[k], uSrc.val[3], uInvA);
+      vst4q_u8(pDest + i*4, uDest);
+   }
+   return i;
+}
+
+#elif defined(RENDER_KERNELS_SSE2)
+
+//---------------------------------------------------
+// SSE2 kernels: 4 pixels at a time, as 16 bit lanes (2 pixels per register)
+
+// Broadcasts lane 3 (alpha) of each pixel to the other lanes of the pixel
+static inline __m128i _sse2_broadcast_alpha(__m128i uPixels16)
+{
+   return _mm_shufflehi_epi16(_mm_shufflelo_epi16(uPixels16, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+}
+
+// (k + d*m) >> 8 on each 16 bit lane
+static inline __m128i _sse2_mul_add_shift(__m128i uDest16, __m128i uMul, __m128i uAdd)
+{
+   return _mm_srli_epi16(_mm_add_epi16(uAdd, _mm_mullo_epi16(uDest16, uMul)), 8);
+}
+
+static int _fill_span_simd(u8* pDest, int iCount, const u8* pColor)
+{
+   u32 uPixel;
+   memcpy(&uPixel, pColor, 4);
+   __m128i uPixels = _mm_set1_epi32((int)uPixel);
+   int i = 0;
+   for( ; i + 4 <= iCount; i += 4 )
+      _mm_storeu_si128((__m128i*)(pDest + i*4), uPixels);
+   return i;
+}
+
+// Color lanes: (a*c + (255-a)*d) >> 8
+// Alpha lane: d + (((255-d)*a) >> 8) == (a*255 + (256-a)*d) >> 8
+static int _blend_color_span_simd(u8* pDest, int iCount, const u8* pColor, u8 uAlpha)
+{
+   const __m128i uZero = _mm_setzero_si128();
+   int a = uAlpha;
+   __m128i uAdd = _mm_setr_epi16(a*pColor[0], a*pColor[1], a*pColor[2], a*255, a*pColor[0], a*pColor[1], a*pColor[2], a*255);
+   __m128i uMul = _mm_setr_epi16(255-a, 255-a, 255-a, 256-a, 255-a, 255-a, 255-a, 256-a);
+   int i = 0;
+   for( ; i + 4 <= iCount; i += 4 )
+   {
+      __m128i uDest = _mm_loadu_si128((const __m128i*)(pDest + i*4));
+      __m128i uLow = _sse2_mul_add_shift(_mm_unpacklo_epi8(uDest, uZero), uMul, uAdd);
+      __m128i uHigh = _sse2_mul_add_shift(_mm_unpackhi_epi8(uDest, uZero), uMul, uAdd);
+      _mm_storeu_si128((__m128i*)(pDest + i*4), _mm_packus_epi16(uLow, uHigh));
+   }
+   return i;
+}
+
+static inline __m128i _sse2_blend_src_mix_half(__m128i uSrcRaw16, __m128i uDest16, __m128i uMix, int iSkipDarkPixels)
+{
+   const __m128i uMaskColor = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+   const __m128i uAlphaLane255 = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+   const __m128i uMulBase = _mm_setr_epi16(255, 255, 255, 256, 255, 255, 255, 256);
+
+   __m128i uSrc = _mm_srli_epi16(_mm_mullo_epi16(uSrcRaw16, uMix), 8);
+   __m128i uAlpha = _sse2_broadcast_alpha(uSrc);
+   __m128i uColor = _mm_or_si128(_mm_and_si128(uSrc, uMaskColor), uAlphaLane255);
+   __m128i uResult = _sse2_mul_add_shift(uDest16, _mm_sub_epi16(uMulBase, uAlpha), _mm_mullo_epi16(uAlpha, uColor));
+   if ( iSkipDarkPixels )
+   {
+      __m128i uSum = _mm_add_epi16(_mm_add_epi16(
+         _mm_shufflehi_epi16(_mm_shufflelo_epi16(uSrcRaw16, _MM_SHUFFLE(0,0,0,0)), _MM_SHUFFLE(0,0,0,0)),
+         _mm_shufflehi_epi16(_mm_shufflelo_epi16(uSrcRaw16, _MM_SHUFFLE(1,1,1,1)), _MM_SHUFFLE(1,1,1,1))),
+         _mm_shufflehi_epi16(_mm_shufflelo_epi16(uSrcRaw16, _MM_SHUFFLE(2,2,2,2)), _MM_SHUFFLE(2,2,2,2)));
+      __m128i uSkip = _mm_cmplt_epi16(uSum, _mm_set1_epi16(120));
+      uResult = _mm_or_si128(_mm_and_si128(uSkip, uDest16), _mm_andnot_si128(uSkip, uResult));
+   }
+   return uResult;
+}
+
+static int _blend_src_mix_span_simd(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, int iSkipDarkPixels)
+{
+   const __m128i uZero = _mm_setzero_si128();
+   __m128i uMix = _mm_setr_epi16(pMix[0], pMix[1], pMix[2], pMix[3], pMix[0], pMix[1], pMix[2], pMix[3]);
+   int i = 0;
+   for( ; i + 4 <= iCount; i += 4 )
+   {
+      __m128i uSrc = _mm_loadu_si128((const __m128i*)(pSrc + i*4));
+      __m128i uDest = _mm_loadu_si128((const __m128i*)(pDest + i*4));
+      __m128i uLow = _sse2_blend_src_mix_half(_mm_unpacklo_epi8(uSrc, uZero), _mm_unpacklo_epi8(uDest, uZero), uMix, iSkipDarkPixels);
+      __m128i uHigh = _sse2_blend_src_mix_half(_mm_unpackhi_epi8(uSrc, uZero), _mm_unpackhi_epi8(uDest, uZero), uMix, iSkipDarkPixels);
+      _mm_storeu_si128((__m128i*)(pDest + i*4), _mm_packus_epi16(uLow, uHigh));
+   }
+   return i;
+}
+
+static inline __m128i _sse2_copy_src_mix_half(__m128i uSrcRaw16, __m128i uDest16, __m128i uMix, __m128i uMinAlpha)
+{
+   __m128i uSrc = _mm_srli_epi16(_mm_mullo_epi16(uSrcRaw16, uMix), 8);
+   __m128i uSkip = _mm_cmplt_epi16(_sse2_broadcast_alpha(uSrcRaw16), uMinAlpha);
+   return _mm_or_si128(_mm_and_si128(uSkip, uDest16), _mm_andnot_si128(uSkip, uSrc));
+}
+
+static int _copy_src_mix_span_simd(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, u8 uMinAlpha)
+{
+   const __m128i uZero = _mm_setzero_si128();
+   __m128i uMix = _mm_setr_epi16(pMix[0], pMix[1], pMix[2], pMix[3], pMix[0], pMix[1], pMix[2], pMix[3]);
+   __m128i uMinA = _mm_set1_epi16(uMinAlpha);
+   int i = 0;
+   for( ; i + 4 <= iCount; i += 4 )
+   {
+      __m128i uSrc = _mm_loadu_si128((const __m128i*)(pSrc + i*4));
+      __m128i uDest = _mm_loadu_si128((const __m128i*)(pDest + i*4));
+      __m128i uLow = _sse2_copy_src_mix_half(_mm_unpacklo_epi8(uSrc, uZero), _mm_unpacklo_epi8(uDest, uZero), uMix, uMinA);
+      __m128i uHigh = _sse2_copy_src_mix_half(_mm_unpackhi_epi8(uSrc, uZero), _mm_unpackhi_epi8(uDest, uZero), uMix, uMinA);
+      _mm_storeu_si128((__m128i*)(pDest + i*4), _mm_packus_epi16(uLow, uHigh));
+   }
+   return i;
+}
+
+// Color lanes: (a*s + (255-a)*d) >> 8, alpha lane: (0 + 256*d) >> 8 == d
+static inline __m128i _sse2_blend_src_half(__m128i uSrc16, __m128i uDest16)
+{
+   const __m128i uMaskColor = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+   const __m128i uMulBase = _mm_setr_epi16(255, 255, 255, 256, 255, 255, 255, 256);
+   __m128i uAlpha = _mm_and_si128(_sse2_broadcast_alpha(uSrc16), uMaskColor);
+   return _sse2_mul_add_shift(uDest16, _mm_sub_epi16(uMulBase, uAlpha), _mm_mullo_epi16(uAlpha, uSrc16));
+}
+
+static int _blend_src_span_simd(u8* pDest, const u8* pSrc, int iCount)
+{
+   const __m128i uZero = _mm_setzero_si128();
+   int i = 0;
+   for( ; i + 4 <= iCount; i += 4 )
+   {
+      __m128i uSrc = _mm_loadu_si128((const __m128i*)(pSrc + i*4));
+      __m128i uDest = _mm_loadu_si128((const __m128i*)(pDest + i*4));
+      __m128i uLow = _sse2_blend_src_half(_mm_unpacklo_epi8(uSrc, uZero), _mm_unpacklo_epi8(uDest, uZero));
+      __m128i uHigh = _sse2_blend_src_half(_mm_unpackhi_epi8(uSrc, uZero), _mm_unpackhi_epi8(uDest, uZero));
+      _mm_storeu_si128((__m128i*)(pDest + i*4), _mm_packus_epi16(uLow, uHigh));
+   }
+   return i;
+}
+
+#else
+
+static int _fill_span_simd(u8* pDest, int iCount, const u8* pColor) { return 0; }
+static int _blend_color_span_simd(u8* pDest, int iCount, const u8* pColor, u8 uAlpha) { return 0; }
+static int _blend_src_mix_span_simd(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, int iSkipDarkPixels) { return 0; }
+static int _copy_src_mix_span_simd(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, u8 uMinAlpha) { return 0; }
+static int _blend_src_span_simd(u8* pDest, const u8* pSrc, int iCount) { return 0; }
+
+#endif
+
+//---------------------------------------------------
+// Public kernels: SIMD for the bulk of the span, scalar for the tail
+
+void render_kernels_fill_span(u8* pDest, int iCount, const u8* pColor)
+{
+   int i = 0;
+   if ( s_iRenderKernelsUseSIMD )
+      i = _fill_span_simd(pDest, iCount, pColor);
+   if ( i < iCount )
+      _fill_span_scalar(pDest + i*4, iCount - i, pColor);
+}
+
+void render_kernels_blend_color_span(u8* pDest, int iCount, const u8* pColor, u8 uAlpha)
+{
+   int i = 0;
+   if ( s_iRenderKernelsUseSIMD )
+      i = _blend_color_span_simd(pDest, iCount, pColor, uAlpha);
+   if ( i < iCount )
+      _blend_color_span_scalar(pDest + i*4, iCount - i, pColor, uAlpha);
+}
+
+void render_kernels_blend_src_mix_span(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, int iSkipDarkPixels)
+{
+   int i = 0;
+   if ( s_iRenderKernelsUseSIMD )
+      i = _blend_src_mix_span_simd(pDest, pSrc, iCount, pMix, iSkipDarkPixels);
+   if ( i < iCount )
+      _blend_src_mix_span_scalar(pDest + i*4, pSrc + i*4, iCount - i, pMix, iSkipDarkPixels);
+}
+
+void render_kernels_copy_src_mix_span(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, u8 uMinAlpha)
+{
+   int i = 0;
+   if ( s_iRenderKernelsUseSIMD )
+      i = _copy_src_mix_span_simd(pDest, pSrc, iCount, pMix, uMinAlpha);
+   if ( i < iCount )
+      _copy_src_mix_span_scalar(pDest + i*4, pSrc + i*4, iCount - i, pMix, uMinAlpha);
+}
+
+void render_kernels_blend_src_span(u8* pDest, const u8* pSrc, int iCount)
+{
+   int i = 0;
+   if ( s_iRenderKernelsUseSIMD )
+      i = _blend_src_span_simd(pDest, pSrc, iCount);
+   if ( i < iCount )
+      _blend_src_span_scalar(pDest + i*4, pSrc + i*4, iCount - i);
+}
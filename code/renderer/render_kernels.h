@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../base/base.h"
+
+// Span kernels used by the render engines on 4 bytes per pixel buffers.
+// Byte order inside a pixel does not matter to the kernels (the raw engine uses RGBA,
+// the cairo engine BGRA), the 4th byte is always the alpha. NEON and SSE2 versions are
+// bit exact with the scalar ones.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Writes the 4 bytes of pColor to each pixel
+void render_kernels_fill_span(u8* pDest, int iCount, const u8* pColor);
+
+// Blends a color (3 bytes) with the given alpha over each pixel; destination alpha is accumulated.
+void render_kernels_blend_color_span(u8* pDest, int iCount, const u8* pColor, u8 uAlpha);
+
+// Source pixels are modulated by pMix (4 bytes), then blended over the destination using their alpha.
+// If iSkipDarkPixels is set, source pixels with r+g+b < 120 are not drawn.
+void render_kernels_blend_src_mix_span(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, int iSkipDarkPixels);
+
+// Source pixels are modulated by pMix (4 bytes) and copied; source pixels with alpha < uMinAlpha are not drawn.
+void render_kernels_copy_src_mix_span(u8* pDest, const u8* pSrc, int iCount, const u8* pMix, u8 uMinAlpha);
+
+// Glyph/icon blit: the source alpha is the coverage mask of the source color; destination alpha is unchanged.
+void render_kernels_blend_src_span(u8* pDest, const u8* pSrc, int iCount);
+
+// Used by tests to compare the SIMD kernels with the scalar ones
+void render_kernels_enable_simd(int iEnable);
+const char* render_kernels_get_simd_name();
+
+#ifdef __cplusplus
+}
+#endif